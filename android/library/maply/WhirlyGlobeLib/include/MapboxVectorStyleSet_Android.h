@@ -21,6 +21,7 @@
 #import <jni.h>
 #import "WhirlyGlobe.h"
 #import "LabelInfo_Android.h"
+#import <mutex>
 
 namespace WhirlyKit
 {
@@ -75,7 +76,13 @@ public:
     jmethodID makeLineTextureMethod = nullptr;
 
     // Map fontName/size to Java-side labelInfo objects
+    // Tile building threads share these, so they're locked
+    std::mutex labelInfoLock;
     std::map<std::pair<std::string, float>, LabelInfoAndroidRef> labelInfos;
+
+protected:
+    // Method lookup happens on whichever thread gets there first
+    std::once_flag setupMethodsOnce;
 };
 typedef std::shared_ptr<MapboxVectorStyleSetImpl_Android> MapboxVectorStyleSetImpl_AndroidRef;
 
@@ -119,6 +119,7 @@ Texture *ImageTile_Android::buildTexture()
             tex = new TextureGLES("ImageTile_Android",rawData,false);
             tex->setWidth(destWidth);
             tex->setHeight(destHeight);
+            tex->setDataInFormat(dataInFormat);
             break;
     }
 
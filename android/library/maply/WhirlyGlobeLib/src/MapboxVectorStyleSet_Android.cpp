@@ -37,18 +37,19 @@ MapboxVectorStyleSetImpl_Android::MapboxVectorStyleSetImpl_Android(Scene *scene,
 
 void MapboxVectorStyleSetImpl_Android::setupMethods(JNIEnv *env)
 {
-    if (!makeLabelInfoMethod)
+    std::call_once(setupMethodsOnce, [&]
     {
         const jclass thisClass = MapboxVectorStyleSetClassInfo::getClassInfo()->getClass();
         makeLabelInfoMethod      = env->GetMethodID(thisClass,"labelInfoForFont",  "(Ljava/lang/String;F)Lcom/mousebird/maply/LabelInfo;");
         calculateTextWidthMethod = env->GetMethodID(thisClass,"calculateTextWidth","(Ljava/lang/String;Lcom/mousebird/maply/LabelInfo;)D");
         makeCircleTextureMethod  = env->GetMethodID(thisClass,"makeCircleTexture", "(DIIFLcom/mousebird/maply/Point2d;)J");
         makeLineTextureMethod    = env->GetMethodID(thisClass,"makeLineTexture",   "([D)J");
-    }
+    });
 }
 
 void MapboxVectorStyleSetImpl_Android::cleanup(JNIEnv *env)
 {
+    std::lock_guard<std::mutex> guardLock(labelInfoLock);
     for (auto &labelInfo : labelInfos)
     {
         env->DeleteGlobalRef(labelInfo.second->labelInfoObj);
@@ -143,9 +144,12 @@ LabelInfoRef MapboxVectorStyleSetImpl_Android::makeLabelInfo(PlatformThreadInfo
     {
         setupMethods(inst->env);
 
+        // Held across the Java call so two threads don't both make the same one
+        std::lock_guard<std::mutex> guardLock(labelInfoLock);
+
         const auto key = std::make_pair(fontNames[0],fontSize);
         const auto result = labelInfos.insert(std::make_pair(key, LabelInfoAndroidRef()));
-        if (!result.second)
+        if (!result.second && result.first->second)
         {
             // Already present, return it
             return result.first->second;
@@ -203,6 +207,7 @@ ComponentObjectRef MapboxVectorStyleSetImpl_Android::makeComponentObject(Platfor
 double MapboxVectorStyleSetImpl_Android::calculateTextWidth(PlatformThreadInfo *inInst,const LabelInfoRef &inLabelInfo,const std::string &text)
 {
     const auto inst = (PlatformInfo_Android *)inInst;
+    setupMethods(inst->env);
     if (auto labelInfo = dynamic_cast<LabelInfoAndroid*>(inLabelInfo.get()))
     {
         if (jstring jText = inst->env->NewStringUTF(text.c_str()))
@@ -19,6 +19,7 @@
 #import "Maply_jni.h"
 #import "WhirlyGlobe_Android.h"
 #import "../../../WhirlyGlobeLib/include/QuadImageFrameLoader_Android.h"
+#import "TileCache.h"
 
 typedef JavaClassInfo<WhirlyKit::SamplingParams> SamplingParamsClassInfo;
 typedef JavaClassInfo<WhirlyKit::QuadLoaderReturnRef> LoaderReturnClassInfo;
@@ -27,6 +28,7 @@ typedef JavaClassInfo<WhirlyKit::QuadImageFrameLoader_AndroidRef> QuadImageFrame
 typedef JavaClassInfo<WhirlyKit::QuadSamplingController_Android> QuadSamplingControllerInfo;
 typedef JavaClassInfo<WhirlyKit::QIFBatchOps_Android> QIFBatchOpsClassInfo;
 typedef JavaClassInfo<WhirlyKit::QIFFrameAsset_Android> QIFFrameAssetClassInfo;
+typedef JavaClassInfo<WhirlyKit::TileCache> TileCacheClassInfo;
 
 JNIEXPORT jobject JNICALL MakeImageTile(JNIEnv *env,WhirlyKit::ImageTile_AndroidRef imgTile);
 JNIEXPORT jobject JNICALL MakeQIFBatchOps(JNIEnv *env,WhirlyKit::QIFBatchOps_Android *batchOps);
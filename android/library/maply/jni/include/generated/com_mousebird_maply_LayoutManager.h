@@ -15,6 +15,14 @@ extern "C" {
 JNIEXPORT void JNICALL Java_com_mousebird_maply_LayoutManager_setMaxDisplayObjects
   (JNIEnv *, jobject, jint);
 
+/*
+ * Class:     com_mousebird_maply_LayoutManager
+ * Method:    setIncrementalLayout
+ * Signature: (ZF)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_LayoutManager_setIncrementalLayout
+  (JNIEnv *, jobject, jboolean, jfloat);
+
 /*
  * Class:     com_mousebird_maply_LayoutManager
  * Method:    updateLayout
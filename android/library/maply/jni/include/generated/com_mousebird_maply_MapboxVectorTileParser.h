@@ -32,6 +32,14 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_MapboxVectorTileParser_parse
 JNIEXPORT void JNICALL Java_com_mousebird_maply_MapboxVectorTileParser_setLocalCoords
   (JNIEnv *, jobject, jboolean);
 
+/*
+ * Class:     com_mousebird_maply_MapboxVectorTileParser
+ * Method:    setParallelBuild
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_MapboxVectorTileParser_setParallelBuild
+  (JNIEnv *, jobject, jint);
+
 /*
  * Class:     com_mousebird_maply_MapboxVectorTileParser
  * Method:    initialise
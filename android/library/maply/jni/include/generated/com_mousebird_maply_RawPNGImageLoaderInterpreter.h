@@ -18,10 +18,10 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RawPNGImageLoaderInterpreter_add
 /*
  * Class:     com_mousebird_maply_RawPNGImageLoaderInterpreter
  * Method:    dataForTileNative
- * Signature: ([BLcom/mousebird/maply/LoaderReturn;)V
+ * Signature: ([BLcom/mousebird/maply/LoaderReturn;Lcom/mousebird/maply/QuadLoaderBase;)V
  */
 JNIEXPORT void JNICALL Java_com_mousebird_maply_RawPNGImageLoaderInterpreter_dataForTileNative
-  (JNIEnv *, jobject, jbyteArray, jobject);
+  (JNIEnv *, jobject, jbyteArray, jobject, jobject);
 
 /*
  * Class:     com_mousebird_maply_RawPNGImageLoaderInterpreter
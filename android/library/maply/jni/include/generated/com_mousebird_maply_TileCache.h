@@ -0,0 +1,77 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class com_mousebird_maply_TileCache */
+
+#ifndef _Included_com_mousebird_maply_TileCache
+#define _Included_com_mousebird_maply_TileCache
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     com_mousebird_maply_TileCache
+ * Method:    open
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_TileCache_open
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_TileCache
+ * Method:    close
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCache_close
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     com_mousebird_maply_TileCache
+ * Method:    getTile
+ * Signature: (IIILjava/lang/String;)[B
+ */
+JNIEXPORT jbyteArray JNICALL Java_com_mousebird_maply_TileCache_getTile
+  (JNIEnv *, jobject, jint, jint, jint, jstring);
+
+/*
+ * Class:     com_mousebird_maply_TileCache
+ * Method:    putTile
+ * Signature: (IIILjava/lang/String;[B)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_TileCache_putTile
+  (JNIEnv *, jobject, jint, jint, jint, jstring, jbyteArray);
+
+/*
+ * Class:     com_mousebird_maply_TileCache
+ * Method:    removeTile
+ * Signature: (IIILjava/lang/String;)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCache_removeTile
+  (JNIEnv *, jobject, jint, jint, jint, jstring);
+
+/*
+ * Class:     com_mousebird_maply_TileCache
+ * Method:    nativeInit
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCache_nativeInit
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_mousebird_maply_TileCache
+ * Method:    initialise
+ * Signature: (Ljava/lang/String;J)V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCache_initialise
+  (JNIEnv *, jobject, jstring, jlong);
+
+/*
+ * Class:     com_mousebird_maply_TileCache
+ * Method:    dispose
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCache_dispose
+  (JNIEnv *, jobject);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -411,7 +411,7 @@ JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_MapboxVectorStyleSet_getSpri
         }
 
         const auto styleSetRef = MapboxVectorStyleSetClassInfo::get(env,obj);
-        const auto sprites = (styleSetRef && *styleSetRef) ? (*styleSetRef)->sprites : nullptr;
+        const auto sprites = (styleSetRef && *styleSetRef) ? (*styleSetRef)->getSprites() : nullptr;
         if (!sprites) {
             return false;
         }
@@ -105,6 +105,39 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_MapboxVectorTileParser_setLocalC
     }
 }
 
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_MapboxVectorTileParser_setParallelBuild
+    (JNIEnv *env, jobject obj, jint numThreads)
+{
+    try {
+        MapboxVectorTileParser *inst = MapboxVectorTileParserClassInfo::getClassInfo()->getObject(
+                env, obj);
+        if (!inst)
+            return;
+
+        JavaVM *vm = nullptr;
+        if (env->GetJavaVM(&vm) != JNI_OK || !vm)
+            return;
+
+        // Each worker attaches to the VM for the life of the thread so the styles have an env
+        inst->setParallelBuild(std::max(0,(int)numThreads),
+            [vm]() -> PlatformThreadInfo * {
+                JNIEnv *threadEnv = nullptr;
+                if (vm->AttachCurrentThread(&threadEnv, nullptr) != JNI_OK || !threadEnv)
+                    return nullptr;
+                return new PlatformInfo_Android(threadEnv);
+            },
+            [vm](PlatformThreadInfo *threadInfo) {
+                delete (PlatformInfo_Android *)threadInfo;
+                vm->DetachCurrentThread();
+            });
+    }
+    catch (...) {
+        __android_log_print(ANDROID_LOG_VERBOSE, "Maply",
+                            "Crash in MapboxVectorTileParser::setParallelBuild()");
+    }
+}
+
 static bool noCancel(PlatformThreadInfo*) { return false; }
 
 extern "C"
@@ -409,6 +409,23 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_LayoutManager_setMaxDisplayObjec
     }
 }
 
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_LayoutManager_setIncrementalLayout
+  (JNIEnv *env, jobject obj, jboolean enable, jfloat moveThreshold)
+{
+    try
+    {
+        if (auto wrap = LayoutManagerWrapperClassInfo::get(env, obj))
+        {
+            wrap->layoutManager->setIncrementalLayout(enable, moveThreshold);
+        }
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in LayoutManager::setIncrementalLayout()");
+    }
+}
+
 extern "C"
 JNIEXPORT void JNICALL Java_com_mousebird_maply_LayoutManager_updateLayout
   (JNIEnv *env, jobject obj, jobject viewStateObj, jobject changeSetObj)
@@ -81,7 +81,7 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RawPNGImageLoaderInterpreter_dis
 }
 
 JNIEXPORT void JNICALL Java_com_mousebird_maply_RawPNGImageLoaderInterpreter_dataForTileNative
-(JNIEnv *env, jobject obj, jbyteArray inImage,jobject loadReturnObj)
+(JNIEnv *env, jobject obj, jbyteArray inImage,jobject loadReturnObj,jobject loaderObj)
 {
 	try
 	{
@@ -90,26 +90,32 @@ JNIEXPORT void JNICALL Java_com_mousebird_maply_RawPNGImageLoaderInterpreter_dat
 		if (!rawImage || !loadReturn)
 			return;
 
+		// Decode color images straight to 16 bit if that's what the textures will be
+		QuadImageFrameLoader_AndroidRef *loader = loaderObj ? QuadImageFrameLoaderClassInfo::getClassInfo()->getObject(env,loaderObj) : nullptr;
+		const RawPNGFormat format = loader ? RawPNGFormatForTexType((*loader)->getTexType()) : RawPNGRGBA;
+
 		jbyte *bytes = env->GetByteArrayElements(inImage,NULL);
 		jsize len = env->GetArrayLength(inImage);
 
         unsigned int width=0,height=0;
         unsigned int err = 0;
         int byteWidth = -1;
-        unsigned char *outData = RawPNGImageLoaderInterpreter(width,height,
+        RawDataRef outData = RawPNGImageLoaderInterpreter(width,height,
                 (const unsigned char *)bytes,len,
 		        rawImage->valueMap,
+                format,
                 byteWidth, err);
 
-		env->ReleaseByteArrayElements(inImage,bytes, 0);
+		env->ReleaseByteArrayElements(inImage,bytes, JNI_ABORT);
 
-		if (err != 0 && !outData) {
+		if (err != 0 || !outData) {
             wkLogLevel(Warn, "Failed to read PNG in MaplyRawPNGImageLoaderInterpreter for tile %d: (%d,%d)",(*loadReturn)->ident.level,(*loadReturn)->ident.x,(*loadReturn)->ident.y);
         } else {
-			RawDataWrapperRef wrap = std::make_shared<RawDataWrapper>(outData,width*height*byteWidth,true);
-			ImageTileRef imgTile = std::make_shared<ImageTile_Android>("Raw PNG",wrap);
+			ImageTileRef imgTile = std::make_shared<ImageTile_Android>("Raw PNG",outData);
 			imgTile->width = width;  imgTile->height = height;
 			imgTile->components = byteWidth;
+			// Greyscale comes out one byte per pixel whatever we asked for
+			imgTile->dataInFormat = format != RawPNGRGBA && byteWidth == 2;
 			(*loadReturn)->images.push_back(imgTile);
         }
     }
@@ -0,0 +1,174 @@
+/*  TileCache_jni.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "QuadLoading_jni.h"
+#import "com_mousebird_maply_TileCache.h"
+
+using namespace WhirlyKit;
+
+template<> TileCacheClassInfo *TileCacheClassInfo::classInfoObj = nullptr;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCache_nativeInit
+  (JNIEnv *env, jclass cls)
+{
+    TileCacheClassInfo::getClassInfo(env,cls);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCache_initialise
+  (JNIEnv *env, jobject obj, jstring dirStr, jlong maxBytes)
+{
+    try
+    {
+        const JavaString dir(env,dirStr);
+        auto *cache = new TileCache(dir.getCString(),(size_t)std::max(maxBytes,(jlong)0));
+        TileCacheClassInfo::getClassInfo()->setHandle(env,obj,cache);
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in TileCache::initialise()");
+    }
+}
+
+static std::mutex disposeMutex;
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCache_dispose
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        TileCacheClassInfo *classInfo = TileCacheClassInfo::getClassInfo();
+        std::lock_guard<std::mutex> lock(disposeMutex);
+        TileCache *cache = classInfo->getObject(env,obj);
+        delete cache;
+        classInfo->clearHandle(env,obj);
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in TileCache::dispose()");
+    }
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_TileCache_open
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (TileCache *cache = TileCacheClassInfo::getClassInfo()->getObject(env,obj))
+            return cache->open();
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in TileCache::open()");
+    }
+    return false;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCache_close
+  (JNIEnv *env, jobject obj)
+{
+    try
+    {
+        if (TileCache *cache = TileCacheClassInfo::getClassInfo()->getObject(env,obj))
+            cache->close();
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in TileCache::close()");
+    }
+}
+
+extern "C"
+JNIEXPORT jbyteArray JNICALL Java_com_mousebird_maply_TileCache_getTile
+  (JNIEnv *env, jobject obj, jint x, jint y, jint level, jstring sourceStr)
+{
+    try
+    {
+        TileCache *cache = TileCacheClassInfo::getClassInfo()->getObject(env,obj);
+        const JavaString source(env,sourceStr);
+        if (!cache || !source)
+            return nullptr;
+
+        // The hit is a view on the mapped pack, so this is the only copy
+        const RawDataRef data = cache->getTile(QuadTreeIdentifier(x,y,level),source.getCString());
+        if (!data)
+            return nullptr;
+        const auto len = (jsize)data->getLen();
+        jbyteArray retArray = env->NewByteArray(len);
+        if (!retArray)
+        {
+            logAndClearJVMException(env);
+            return nullptr;
+        }
+        env->SetByteArrayRegion(retArray, 0, len, (const jbyte *)data->getRawData());
+        return retArray;
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in TileCache::getTile()");
+    }
+    return nullptr;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL Java_com_mousebird_maply_TileCache_putTile
+  (JNIEnv *env, jobject obj, jint x, jint y, jint level, jstring sourceStr, jbyteArray dataArray)
+{
+    try
+    {
+        TileCache *cache = TileCacheClassInfo::getClassInfo()->getObject(env,obj);
+        const JavaString source(env,sourceStr);
+        if (!cache || !source || !dataArray)
+            return false;
+
+        const int len = env->GetArrayLength(dataArray);
+        bool ret = false;
+        if (jbyte *rawData = env->GetByteArrayElements(dataArray,nullptr))
+        {
+            const RawDataWrapper dataWrap(rawData, len, false);
+            ret = cache->putTile(QuadTreeIdentifier(x,y,level),source.getCString(),dataWrap);
+            env->ReleaseByteArrayElements(dataArray, rawData, JNI_ABORT);
+        }
+        return ret;
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in TileCache::putTile()");
+    }
+    return false;
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_com_mousebird_maply_TileCache_removeTile
+  (JNIEnv *env, jobject obj, jint x, jint y, jint level, jstring sourceStr)
+{
+    try
+    {
+        TileCache *cache = TileCacheClassInfo::getClassInfo()->getObject(env,obj);
+        const JavaString source(env,sourceStr);
+        if (cache && source)
+            cache->removeTile(QuadTreeIdentifier(x,y,level),source.getCString());
+    }
+    catch (...)
+    {
+        __android_log_print(ANDROID_LOG_ERROR, "Maply", "Crash in TileCache::removeTile()");
+    }
+}
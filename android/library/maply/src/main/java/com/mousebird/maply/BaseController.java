@@ -2464,6 +2464,27 @@ public class BaseController implements RenderController.TaskManager, RenderContr
 		}
 	}
 
+	/**
+	 * Reuse the last layout for screen objects that haven't moved much.
+	 * <br>
+	 * When this is on, the layout engine keeps what it placed last time and only retests
+	 * objects that have moved by more than the threshold (in pixels) relative to the rest
+	 * of the screen, along with anything near them.  This makes layout much cheaper when
+	 * panning over lots of labels and markers.  Clustered objects still get a full layout.
+	 *
+	 * @param enable Turn incremental layout on or off.  Off by default.
+	 * @param moveThreshold How far an object can move, in pixels, before it's retested.
+	 */
+	public void setIncrementalLayout(boolean enable,float moveThreshold) {
+		RenderController rc = renderControl;
+		if (rc != null) {
+			LayoutManager lm = rc.layoutManager;
+			if (lm != null) {
+				lm.setIncrementalLayout(enable,moveThreshold);
+			}
+		}
+	}
+
 	/**
 	 * True if the renderer was set up as offline.
 	 * Never going to be true for this.
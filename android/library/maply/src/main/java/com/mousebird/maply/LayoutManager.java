@@ -46,6 +46,16 @@ class LayoutManager
 	 * @param numObjects Maximum number of objects to display.
 	 */
 	public native void setMaxDisplayObjects(int numObjects);
+
+	/**
+	 * Reuse the last layout for objects that haven't moved more than the threshold
+	 * relative to the rest of the screen.  Anything near an object that did change
+	 * is tested again.
+	 *
+	 * @param enable Turn incremental layout on or off.  Off by default.
+	 * @param moveThreshold How far an object can move, in pixels, before it's retested.
+	 */
+	public native void setIncrementalLayout(boolean enable,float moveThreshold);
 	
 	/**
 	 * Run the layout logic on the currently active objects.  Any
@@ -90,6 +90,14 @@ public class MapboxVectorTileParser
     /// If set, we'll parse into local coordinates as specified by the bounding box, rather than geo coords
     native void setLocalCoords(boolean localCoords);
 
+    /**
+     * Build a tile's styles on a pool of worker threads rather than one after the other.
+     * The threads are attached to the JVM for the styles to use.
+     *
+     * @param numThreads Number of worker threads.  Pass 0 to turn this back off.
+     */
+    public native void setParallelBuild(int numThreads);
+
     public void finalize()
     {
         dispose();
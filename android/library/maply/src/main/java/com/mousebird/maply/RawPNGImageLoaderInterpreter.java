@@ -23,7 +23,7 @@ public class RawPNGImageLoaderInterpreter implements LoaderInterpreter {
             if (loadReturn.isCanceled()) {
                 return;
             }
-            dataForTileNative(image, loadReturn);
+            dataForTileNative(image, loadReturn, loader);
         }
     }
 
@@ -32,7 +32,7 @@ public class RawPNGImageLoaderInterpreter implements LoaderInterpreter {
      */
     public native void addMappingFrom(int fromVal,int toVal);
 
-    native void dataForTileNative(byte[] image,LoaderReturn loaderReturn);
+    native void dataForTileNative(byte[] image,LoaderReturn loaderReturn,QuadLoaderBase loader);
 
     static
     {
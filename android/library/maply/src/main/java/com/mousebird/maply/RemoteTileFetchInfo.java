@@ -45,4 +45,15 @@ public class RemoteTileFetchInfo
      * We'll try to read from here or cache to here after a successful fetch.
      */
     public File cacheFile;
+
+    /**
+     * Tile this fetch is for.  Needed to look it up in the fetcher's TileCache.
+     */
+    public TileID tileID;
+
+    /**
+     * Name of the source in the fetcher's TileCache.
+     * Tile infos sharing a fetcher need different names.  Nothing goes in the TileCache if this is null.
+     */
+    public String cacheSource;
 }
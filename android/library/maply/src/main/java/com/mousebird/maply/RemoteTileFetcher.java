@@ -68,6 +68,22 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
         return name;
     }
 
+    TileCache tileCache = null;
+
+    /**
+     * Look for tiles in the given cache before fetching them and add them after.
+     * This is used instead of the cacheFile for fetches that have a tileID and cacheSource.
+     */
+    public void setTileCache(TileCache cache) {
+        tileCache = cache;
+    }
+
+    // True if this tile goes through the TileCache rather than a cache file
+    protected boolean usesTileCache(TileInfo tile) {
+        return tileCache != null && tile.fetchInfo != null &&
+                tile.fetchInfo.tileID != null && tile.fetchInfo.cacheSource != null;
+    }
+
     enum TileInfoState {ToLoad,Loading,None}
 
     /**
@@ -80,6 +96,9 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
         // Set if we already know the tile is cached
         boolean isLocal = false;
 
+        // Set if the data came out of a cache, so it doesn't need to go back in
+        boolean fromCache = false;
+
         // Used to uniquely identify a group of requests
         long tileSource = 0;
 
@@ -394,7 +413,7 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
             // Set up the fetching task
             tile.task = client.newCall(tile.fetchInfo.urlReq);
 
-            if (tile.isLocal) {
+            if (tile.isLocal || usesTileCache(tile)) {
                 // Try reading the data in the background
                 new CacheTask(this,tile).executeOnExecutor(AsyncTask.THREAD_POOL_EXECUTOR,(Void)null);
             } else {
@@ -542,26 +561,22 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
         if (!valid)
             return;
 
-        boolean success = false;
-        final int size = (int) tile.fetchInfo.cacheFile.length();
-        final byte[] data = new byte[size];
-        try {
-            try (FileInputStream fileStream = new FileInputStream(tile.fetchInfo.cacheFile)) {
-                try (BufferedInputStream buf = new BufferedInputStream(fileStream)) {
-                    int bytesRead = buf.read(data, 0, data.length);
-                    if (bytesRead == data.length) {
-                        success = true;
-                    }
-                }
-            }
-        } catch (Exception e) {
-            Log.w("RemoteTileFetcher", "Failed to read cache", e);
+        byte[] cacheData = null;
+        if (usesTileCache(tile)) {
+            final TileID tileID = tile.fetchInfo.tileID;
+            cacheData = tileCache.getTile(tileID.x,tileID.y,tileID.level,tile.fetchInfo.cacheSource);
+        }
+        if (cacheData == null && tile.isLocal) {
+            cacheData = readCacheFile(tile);
         }
 
-        if (success) {
+        if (cacheData != null) {
             if (!valid)
                 return;
 
+            final byte[] data = cacheData;
+            final int size = data.length;
+            tile.fromCache = true;
             Handler handler = new Handler(getLooper());
             handler.post(() -> {
                 allStats.localData = allStats.localData + size;
@@ -581,6 +596,29 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
         }
     }
 
+    // Read the whole cache file, or return null
+    protected byte[] readCacheFile(final TileInfo tile)
+    {
+        final File cacheFile = tile.fetchInfo.cacheFile;
+        if (cacheFile == null)
+            return null;
+
+        final byte[] data = new byte[(int) cacheFile.length()];
+        try {
+            try (FileInputStream fileStream = new FileInputStream(cacheFile)) {
+                try (BufferedInputStream buf = new BufferedInputStream(fileStream)) {
+                    int bytesRead = buf.read(data, 0, data.length);
+                    if (bytesRead == data.length) {
+                        return data;
+                    }
+                }
+            }
+        } catch (Exception e) {
+            Log.w("RemoteTileFetcher", "Failed to read cache", e);
+        }
+        return null;
+    }
+
     // Deal with a tile that was or was not loaded.
     // On our own thread
     protected void handleFinishLoading(TileInfo inTile,final byte[] data,final Exception error)
@@ -630,9 +668,18 @@ public class RemoteTileFetcher extends HandlerThread implements TileFetcher
     // Write to the local cache.  Called on a random thread.
     protected void writeToCache(TileInfo tile,byte[] data)
     {
-        RemoteTileFetchInfo info = (tile != null) ? tile.fetchInfo : null;
+        if (tile == null || tile.fromCache || data == null || data.length < 1)
+            return;
+
+        if (usesTileCache(tile)) {
+            final TileID tileID = tile.fetchInfo.tileID;
+            tileCache.putTile(tileID.x,tileID.y,tileID.level,tile.fetchInfo.cacheSource,data);
+            return;
+        }
+
+        RemoteTileFetchInfo info = tile.fetchInfo;
         File cacheFile = (info != null) ? info.cacheFile : null;
-        if (cacheFile == null || data == null || data.length < 1)
+        if (cacheFile == null)
             return;
 
         File parent = cacheFile.getParentFile();
@@ -240,6 +240,9 @@ public class RemoteTileInfoNew extends TileInfoNew
         if (cacheDir != null) {
             fetchInfo.cacheFile = new File(cacheDir,buildCacheName(tileID.x,tileID.y,tileID.level,flipY));
         }
+        fetchInfo.tileID = tileID;
+        if (!baseURLs.isEmpty())
+            fetchInfo.cacheSource = baseURLs.get(0);
 
         return fetchInfo;
     }
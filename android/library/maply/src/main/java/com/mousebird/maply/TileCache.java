@@ -0,0 +1,80 @@
+/*
+ *  TileCache.java
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+package com.mousebird.maply;
+
+import java.io.File;
+
+/**
+ * Persistent on-disk tile cache.
+ * <br>
+ * Tiles are kept in a few large pack files with a memory mapped index,
+ * rather than a file per tile.  Hand one to a RemoteTileFetcher and it'll
+ * look there before going to the network and save what comes back.
+ * <br>
+ * All the methods are thread safe.
+ */
+public class TileCache
+{
+    /**
+     * Set up a cache in the given directory that stays under maxBytes.
+     * Call open() before using it.
+     */
+    public TileCache(File dir,long maxBytes)
+    {
+        initialise(dir.getAbsolutePath(),maxBytes);
+    }
+
+    /**
+     * Open or create the cache.  Returns false if it couldn't.
+     */
+    public native boolean open();
+
+    /**
+     * Write everything out and close the files.
+     */
+    public native void close();
+
+    /**
+     * Data for the given tile from the given source, or null if it's not there.
+     */
+    public native byte[] getTile(int x,int y,int level,String source);
+
+    /**
+     * Add the data for the given tile from the given source, replacing what was there.
+     */
+    public native boolean putTile(int x,int y,int level,String source,byte[] data);
+
+    /**
+     * Forget about a single tile.
+     */
+    public native void removeTile(int x,int y,int level,String source);
+
+    public void finalize()
+    {
+        dispose();
+    }
+    static
+    {
+        nativeInit();
+    }
+    private static native void nativeInit();
+    native void initialise(String dir,long maxBytes);
+    native void dispose();
+    private long nativeHandle;
+}
@@ -55,16 +55,23 @@ friend class BasicDrawableBuilderGLES;
 friend class BasicDrawableBuilderMTL;
     
 public:
-    /// Simple triangle.  Can obviously only have 2^16 vertices
+    /// Simple triangle.  These go to the renderer as 16 bit indices unless
+    ///  the drawable has more than 2^16 vertices.
     class Triangle
     {
     public:
         Triangle();
         /// Construct with vertex IDs
-        Triangle(unsigned short v0,unsigned short v1,unsigned short v2);
-        unsigned short verts[3];
+        Triangle(unsigned int v0,unsigned int v1,unsigned int v2);
+        uint32_t verts[3];
     };
 
+    /// Size in bytes of the index buffer for the given triangles
+    static size_t indexBufferSize(size_t numTris,bool wide) { return numTris * 3 * (wide ? sizeof(uint32_t) : sizeof(uint16_t)); }
+
+    /// Copy triangles into an index buffer as 16 or 32 bit indices
+    static void copyIndices(const std::vector<Triangle> &tris,bool wide,void *dest);
+
     /// Construct empty
     BasicDrawable(const std::string &name);
     virtual ~BasicDrawable();
@@ -80,6 +87,12 @@ public:
     /// Return the local MBR, if we're working in a non-geo coordinate system
     virtual Mbr getLocalMbr() const override;
 
+    /// What the local MBR is in, if the builder told us
+    virtual LocalMbrType getLocalMbrType() const override;
+
+    /// Height and zoom ranges we're visible in
+    virtual DrawableVisibleRange getVisibleRange() const override;
+
     /// Return the Matrix if there is an active one (ideally not)
     virtual const Eigen::Matrix4d *getMatrix() const override;
 
@@ -244,6 +257,7 @@ public:
     SimpleIdentity calcProgramId;  // Program to use for calculation
     SimpleIdentity renderTargetID;
     Mbr localMbr;  // Extents in a local space, if we're not using lat/lon/radius
+    LocalMbrType localMbrType;  // What localMbr is in, if we know
     std::vector<TexInfo> texInfo;
     float lineWidth;
     // For zBufferOffDefault mode we'll sort this to the end
@@ -264,6 +278,8 @@ public:
 
     // We'll nuke the data arrays when we hand over the data to GL
     unsigned int numPoints, numTris;
+    // Set if the index buffer is 32 bits, decided when we hand over the data
+    bool wideIndices;
     RGBAColor color;
     bool hasOverrideColor;  // If set, we've changed the default color
     
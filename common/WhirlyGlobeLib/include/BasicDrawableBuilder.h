@@ -52,8 +52,8 @@ public:
     /// Set the fade in and out
     void setFade(TimeInterval inFadeDown,TimeInterval inFadeUp);
 
-    /// Set local extents
-    void setLocalMbr(Mbr mbr);
+    /// Set local extents, and what they're in if the scene can cull with them
+    void setLocalMbr(Mbr mbr,LocalMbrType type = LocalMbrUnknown);
     const Mbr &getLocalMbr();
     
     /// Set the viewer based visibility
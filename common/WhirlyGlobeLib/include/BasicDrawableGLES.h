@@ -68,6 +68,12 @@ public:
     /// Override this to add your own data to interleaved vertex buffers.
     virtual void addPointToBuffer(unsigned char *basePtr,int which,const Point3d *center);
 
+    /// Type of the indices in the element buffer
+    GLenum getIndexType() const { return wideIndices ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT; }
+
+    /// Pack the unprocessed triangles as getIndexType() indices, for drawing from client memory
+    void packIndices(std::vector<unsigned char> &indices) const;
+
 public:
     // Unprocessed data arrays
     std::vector<Eigen::Vector3f> points;
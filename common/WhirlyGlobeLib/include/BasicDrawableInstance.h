@@ -81,6 +81,9 @@ public:
     
     /// We're allowed to turn drawables off completely
     virtual bool isOn(WhirlyKit::RendererFrameInfo *frameInfo) const;
+
+    /// Height and zoom ranges we're visible in
+    virtual DrawableVisibleRange getVisibleRange() const;
         
     /// We can ask to use the z buffer
     virtual void setRequestZBuffer(bool val);
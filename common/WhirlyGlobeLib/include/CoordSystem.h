@@ -69,6 +69,14 @@ public:
     /// Convert from display coordinates to geocentric
     virtual Point3f geocentricToLocal(Point3f) const = 0;
     virtual Point3d geocentricToLocal(Point3d) const = 0;
+
+    /// Convert a run of lat/lon points to the local coordinate system.
+    /// The batch defaults call the single point versions, subclasses do it in one go.
+    virtual void geographicToLocal(const Point2d *geo,Point3d *local,size_t count) const;
+    /// Convert a run of local points to geocentric.  Works in place (geoc may be the same as local).
+    virtual void localToGeocentric(const Point3d *local,Point3d *geoc,size_t count) const;
+    /// Convert a run of geocentric points to local.  Works in place (local may be the same as geoc).
+    virtual void geocentricToLocal(const Point3d *geoc,Point3d *local,size_t count) const;
     
     /// Return true if the given coordinate system is the same as the one passed in
     virtual bool isSameAs(CoordSystem *coordSys) const { return false; }
@@ -79,6 +87,8 @@ typedef std::shared_ptr<CoordSystem> CoordSystemRef;
 /// Convert a point from one coordinate system to another
 Point3f CoordSystemConvert(CoordSystem *inSystem,CoordSystem *outSystem,Point3f inCoord);
 Point3d CoordSystemConvert3d(CoordSystem *inSystem,CoordSystem *outSystem,Point3d inCoord);
+/// Convert a run of points from one coordinate system to another.  Works in place.
+void CoordSystemConvert3d(CoordSystem *inSystem,CoordSystem *outSystem,const Point3d *inCoords,Point3d *outCoords,size_t count);
     
 /** The Coordinate System Display Adapter handles the task of
     converting coordinates in the native system to data values we
@@ -137,6 +147,8 @@ public:
     /// Convert from the system's local coordinates to display coordinates
     virtual Point3f localToDisplay(Point3f) const = 0;
     virtual Point3d localToDisplay(Point3d) const = 0;
+    /// Convert a run of local points to display coordinates.  Works in place.
+    virtual void localToDisplay(const Point3d *local,Point3d *disp,size_t count) const;
     
     /// Convert from display coordinates to the local system's coordinates
     virtual Point3f displayToLocal(Point3f) const = 0;
@@ -145,6 +157,12 @@ public:
     /// For flat systems the normal is Z up.  For the globe, it's based on the location.
     virtual Point3f normalForLocal(Point3f) const = 0;
     virtual Point3d normalForLocal(Point3d) const = 0;
+    /// Normals for a run of local points.  Works in place.
+    virtual void normalForLocal(const Point3d *local,Point3d *norms,size_t count) const;
+
+    /// Convert a run of lat/lon points in our coordinate system all the way to display coordinates.
+    /// Normals are filled in too, if you pass somewhere to put them.
+    void geographicToDisplay(const Point2d *geo,Point3d *disp,Point3d *norms,size_t count) const;
 
     /// Get a reference to the coordinate system
     virtual CoordSystem *getCoordSystem() const = 0;
@@ -183,6 +201,7 @@ public:
     /// Convert from the system's local coordinates to display coordinates
     virtual Point3f localToDisplay(Point3f) const override;
     virtual Point3d localToDisplay(Point3d) const override;
+    virtual void localToDisplay(const Point3d *local,Point3d *disp,size_t count) const override;
     
     /// Convert from display coordinates to the local system's coordinates
     virtual Point3f displayToLocal(Point3f) const override;
@@ -191,6 +210,7 @@ public:
     /// For flat systems the normal is Z up.
     virtual Point3f normalForLocal(Point3f) const override { return Point3f(0,0,1); }
     virtual Point3d normalForLocal(Point3d) const override { return Point3d(0,0,1); }
+    virtual void normalForLocal(const Point3d *local,Point3d *norms,size_t count) const override;
     
     /// Get a reference to the coordinate system
     virtual CoordSystem *getCoordSystem() const override { return coordSys; }
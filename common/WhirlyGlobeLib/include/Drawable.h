@@ -54,6 +54,27 @@ typedef std::set<DrawableTweakerRef> DrawableTweakerRefSet;
 class RenderTargetContainer;
 typedef std::shared_ptr<RenderTargetContainer> RenderTargetContainerRef;
 
+/// What a drawable's local MBR is in.  The scene only culls with the ones it understands.
+/// Geographic means radians, with all the geometry on (or under) the surface within the MBR.
+typedef enum {LocalMbrUnknown,LocalMbrGeographic} LocalMbrType;
+
+/** Height and zoom ranges a drawable is visible within.
+    The scene groups drawables that share these and culls each group with one check.
+ */
+struct DrawableVisibleRange
+{
+    DrawableVisibleRange();
+
+    /// Same height and zoom checks as the drawable's isOn()
+    bool isVisible(const RendererFrameInfo *frameInfo) const;
+
+    bool operator < (const DrawableVisibleRange &that) const;
+
+    float minVisible,maxVisible;
+    int zoomSlot;
+    double minZoomVis,maxZoomVis;
+};
+
 /** The Drawable base class.  Inherit from this and fill in the virtual
     methods.  In general, use the BasicDrawable.
  */
@@ -74,6 +95,12 @@ public:
     /// Return the local MBR, if we're working in a non-geo coordinate system
     virtual Mbr getLocalMbr() const = 0;
 
+    /// What the local MBR is in, if we know
+    virtual LocalMbrType getLocalMbrType() const { return LocalMbrUnknown; }
+
+    /// Height and zoom ranges we're visible in.  Unlimited unless the subclass says otherwise.
+    virtual DrawableVisibleRange getVisibleRange() const { return DrawableVisibleRange(); }
+
     /// We use this to sort drawables
     virtual int64_t getDrawOrder() const = 0;
     
@@ -152,10 +179,16 @@ protected:
 /// Turn off visibility checking
 static const float DrawVisibleInvalid = 1e10;
     
-/// Maximum number of points we want in a drawable
+/// Maximum number of points we want in a drawable with 16 bit indices
 static const unsigned int MaxDrawablePoints = ((1<<16)-1);
     
-/// Maximum number of triangles we want in a drawable
+/// Maximum number of triangles we want in a drawable with 16 bit indices
 static const unsigned int MaxDrawableTriangles = (MaxDrawablePoints / 3);
 
+/// Maximum number of points in a drawable if the renderer can do 32 bit indices
+static const unsigned int MaxWideDrawablePoints = (1<<20);
+
+/// Maximum number of triangles in a drawable if the renderer can do 32 bit indices
+static const unsigned int MaxWideDrawableTriangles = (1<<20);
+
 }
@@ -0,0 +1,161 @@
+/*
+ *  DrawableBuilderNull.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "BasicDrawableBuilder.h"
+#import "BasicDrawableInstanceBuilder.h"
+#import "BillboardDrawableBuilder.h"
+#import "ScreenSpaceDrawableBuilder.h"
+#import "ParticleSystemDrawableBuilder.h"
+#import "WideVectorDrawableBuilder.h"
+#import "DrawableNull.h"
+
+namespace WhirlyKit
+{
+
+/// Null renderer tweaker.  Evaluates the expressions and sets the override color.
+struct BasicDrawableTweakerNull : public BasicDrawableTweaker
+{
+    virtual void tweakForFrame(Drawable *inDraw,RendererFrameInfo *frameInfo) override;
+};
+
+/// Null renderer screen space tweaker.  Only the drawable side, there's no shader to set.
+struct ScreenSpaceTweakerNull : public ScreenSpaceTweaker
+{
+    virtual void tweakForFrame(Drawable *inDraw,RendererFrameInfo *frameInfo) override;
+
+    FloatExpressionInfoRef scaleExp;
+};
+typedef std::shared_ptr<ScreenSpaceTweakerNull> ScreenSpaceTweakerNullRef;
+
+/// Null renderer wide vector tweaker.  Sets the same drawable uniforms the GL version does.
+struct WideVectorTweakerNull : public WideVectorTweaker
+{
+    virtual void tweakForFrame(Drawable *inDraw,RendererFrameInfo *frameInfo) override;
+};
+
+/** Null renderer version of the BasicDrawable Builder.
+  */
+class BasicDrawableBuilderNull : virtual public BasicDrawableBuilder
+{
+public:
+    /// Construct empty
+    BasicDrawableBuilderNull(const std::string &name,Scene *scene,bool setupStandard=true);
+    ~BasicDrawableBuilderNull();
+
+    /// Add a new vertex related attribute.
+    virtual int addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int slot = -1,int numThings = -1) override;
+
+    /// Fill out and return the drawable
+    virtual BasicDrawableRef getDrawable() override;
+
+protected:
+    virtual DrawableTweakerRef makeTweaker() const override;
+    virtual void setupTweaker(const DrawableTweakerRef &inTweaker) const override;
+
+    bool drawableGotten;
+};
+
+/// Null renderer version of the BasicDrawableInstance Builder
+class BasicDrawableInstanceBuilderNull : public BasicDrawableInstanceBuilder
+{
+public:
+    BasicDrawableInstanceBuilderNull(const std::string &name,Scene *scene);
+    ~BasicDrawableInstanceBuilderNull();
+
+    /// Fill out and return the drawable
+    virtual BasicDrawableInstanceRef getDrawable() override;
+
+protected:
+    bool drawableGotten;
+};
+
+/// Null renderer version of the Billboard Builder
+class BillboardDrawableBuilderNull : public BasicDrawableBuilderNull, public BillboardDrawableBuilder
+{
+public:
+    BillboardDrawableBuilderNull(const std::string &name,Scene *scene);
+
+    virtual int addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int slot = -1,int numThings = -1) override;
+
+    virtual BasicDrawableRef getDrawable() override;
+};
+
+/// Null renderer version of the ScreenSpaceDrawable Builder
+class ScreenSpaceDrawableBuilderNull : virtual public BasicDrawableBuilderNull, virtual public ScreenSpaceDrawableBuilder
+{
+public:
+    ScreenSpaceDrawableBuilderNull(const std::string &name,Scene *scene);
+
+    virtual int addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int slot = -1,int numThings = -1) override;
+
+    /// Fill out and return the drawable
+    virtual BasicDrawableRef getDrawable() override;
+
+    virtual DrawableTweakerRef makeTweaker() const override;
+
+    virtual void setupTweaker(BasicDrawable &draw) const override;
+    virtual void setupTweaker(const DrawableTweakerRef &inTweaker) const override;
+};
+
+/// Null renderer version of the particle system drawable builder
+class ParticleSystemDrawableBuilderNull : public ParticleSystemDrawableBuilder
+{
+public:
+    ParticleSystemDrawableBuilderNull(const std::string &name,Scene *scene);
+    virtual ~ParticleSystemDrawableBuilderNull();
+
+    virtual void setup(const std::vector<SingleVertexAttributeInfo> &inVertAttrs,
+               const std::vector<SingleVertexAttributeInfo> &inVaryAttrs,
+               const std::vector<SimpleIdentity> &inVaryNames,
+               int numTotalPoints,int batchSize,int vertexSize,bool useRectangles,bool useInstancing) override;
+
+    ParticleSystemDrawable *getDrawable() override;
+
+protected:
+    bool drawableGotten;
+};
+
+/// Null renderer version of the WideVectorDrawable Builder
+class WideVectorDrawableBuilderNull : virtual public WideVectorDrawableBuilder
+{
+public:
+    WideVectorDrawableBuilderNull(const std::string &name,const SceneRenderer *sceneRenderer,Scene *scene);
+
+    virtual void Init(unsigned int numVertex,unsigned int numTri,unsigned int numCenterline,
+            WideVecImplType implType,
+            bool globeMode,
+            const WideVectorInfo *vecInfo) override;
+
+    /// Used when we're changing values on geometry already generated
+    virtual void generateChanges(const SimpleIDSet &drawID,ChangeSet &changes) override;
+
+    virtual int addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int slot = -1,int numThings = -1) override;
+
+    // Return the basic drawable
+    virtual BasicDrawableRef getBasicDrawable() override;
+
+    // No instancing for the null renderer, same as GL
+    virtual BasicDrawableInstanceRef getInstanceDrawable() override;
+
+    virtual DrawableTweakerRef makeTweaker() const override;
+
+    bool drawableGotten;
+};
+
+}
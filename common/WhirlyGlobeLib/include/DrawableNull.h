@@ -0,0 +1,140 @@
+/*
+ *  DrawableNull.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "Drawable.h"
+#import "BasicDrawable.h"
+#import "BasicDrawableInstance.h"
+#import "ParticleSystemDrawable.h"
+
+namespace WhirlyKit
+{
+
+/// What the null renderer would have sent to the GPU in a single frame
+struct FrameStatsNull
+{
+    /// Drawables that passed the on/visibility checks
+    int drawablesVisible = 0;
+    /// Drawables we'd have drawn, counting each offset matrix
+    int drawablesDrawn = 0;
+    /// Drawables skipped because their program is missing
+    int drawablesSkipped = 0;
+    /// Vertices and triangles we'd have drawn
+    int64_t points = 0;
+    int64_t triangles = 0;
+    /// Instances drawn by instanced drawables
+    int64_t instances = 0;
+};
+
+/**
+    Drawable for the null renderer.  There's nothing to draw with,
+    so we just add up what we would have drawn.
+ */
+class DrawableNull : virtual public Drawable
+{
+public:
+    virtual ~DrawableNull();
+
+    /// Add this drawable's geometry to the frame stats
+    virtual void draw(RendererFrameInfo *frameInfo,Scene *scene,FrameStatsNull &stats) = 0;
+};
+typedef std::shared_ptr<DrawableNull> DrawableNullRef;
+
+/** Null renderer version of the BasicDrawable.
+    Works out the buffer sizes we'd have used and then drops the data, like the GL version does.
+  */
+class BasicDrawableNull : virtual public BasicDrawable, virtual public DrawableNull
+{
+public:
+    BasicDrawableNull(const std::string &name);
+    virtual ~BasicDrawableNull();
+
+    /// Record the buffer we'd have made and toss the data
+    virtual void setupForRenderer(const RenderSetupInfo *setupInfo,Scene *scene) override;
+
+    /// Give back the buffer we recorded
+    virtual void teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *scene,RenderTeardownInfoRef teardown) override;
+
+    /// Count our points and triangles
+    virtual void draw(RendererFrameInfo *frameInfo,Scene *scene,FrameStatsNull &stats) override;
+
+    /// Size of a single interleaved vertex with all its attributes
+    unsigned int singleVertexSize() const;
+
+public:
+    // Unprocessed data arrays
+    std::vector<Eigen::Vector3f> points;
+    std::vector<Triangle> tris;
+
+    bool isSetup;
+    // Vertex and index memory we'd have used
+    size_t bufferSize;
+};
+typedef std::shared_ptr<BasicDrawableNull> BasicDrawableNullRef;
+
+/// Null renderer version of the BasicDrawableInstance
+class BasicDrawableInstanceNull : virtual public BasicDrawableInstance, virtual public DrawableNull
+{
+public:
+    BasicDrawableInstanceNull(const std::string &name);
+
+    /// Record the instance buffer we'd have made
+    virtual void setupForRenderer(const RenderSetupInfo *setupInfo,Scene *scene) override;
+
+    /// Give back the instance buffer
+    virtual void teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *scene,RenderTeardownInfoRef teardown) override;
+
+    /// Count the master's geometry once per instance
+    virtual void draw(RendererFrameInfo *frameInfo,Scene *scene,FrameStatsNull &stats) override;
+
+public:
+    bool isSetup;
+    size_t bufferSize;
+};
+typedef std::shared_ptr<BasicDrawableInstanceNull> BasicDrawableInstanceNullRef;
+
+/// Null renderer version of the particle system drawable
+class ParticleSystemDrawableNull : virtual public ParticleSystemDrawable, virtual public DrawableNull
+{
+friend class ParticleSystemDrawableBuilderNull;
+public:
+    ParticleSystemDrawableNull(const std::string &name);
+
+    /// Count the bytes for a batch of individual attributes
+    virtual void addAttributeData(const RenderSetupInfo *setupInfo,const std::vector<AttributeData> &attrData,const Batch &batch) override;
+
+    /// Count the bytes for a batch passed in as one block
+    virtual void addAttributeData(const RenderSetupInfo *setupInfo,const RawDataRef &data,const Batch &batch) override;
+
+    /// Record the particle buffer we'd have made
+    virtual void setupForRenderer(const RenderSetupInfo *setupInfo,Scene *scene) override;
+
+    /// Give back the particle buffer
+    virtual void teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *scene,RenderTeardownInfoRef teardown) override;
+
+    /// Count the live particles
+    virtual void draw(RendererFrameInfo *frameInfo,Scene *scene,FrameStatsNull &stats) override;
+
+public:
+    bool isSetup;
+    size_t bufferSize;
+    // Bytes handed to us in batches so far
+    size_t batchBytes;
+};
+
+}
@@ -37,7 +37,7 @@ class DynamicTexture : virtual public TextureBase
 public:
     /// Constructor for sorting
     DynamicTexture(const std::string &name);
-    DynamicTexture(SimpleIdentity myId) : TextureBase(myId), layoutGrid(NULL) { }
+    DynamicTexture(SimpleIdentity myId) : TextureBase(myId) { }
     virtual void setup(int texSize,int cellSize,TextureType type,bool clearTextures);
     virtual ~DynamicTexture();
     
@@ -92,6 +92,9 @@ public:
     /// Return texture cell utilization
     void getUtilization(int &numCell,int &usedCell);
     
+    /// Return texture cell utilization along with the free cells trapped below used ones
+    void getUtilization(int &numCell,int &usedCell,int &holeCell);
+    
 protected:
     /// Used for debugging
     std::string name;
@@ -107,8 +110,12 @@ protected:
     /// Texture memory format
     TextureType type;
 
-    // Use to track where sub textures are
-    bool *layoutGrid;
+    // Use to track where sub textures are.  One bit per cell, rowWords per row.
+    std::vector<uint64_t> layoutGrid;
+    int rowWords;
+    
+    // One past the highest used cell in each column
+    std::vector<int> skyline;
     
     std::mutex regionLock;
     /// These regions have been released by the renderer
@@ -0,0 +1,187 @@
+/*
+ *  FlatDictionary.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <memory>
+#import <string_view>
+#import <unordered_set>
+#import <vector>
+#import "Dictionary.h"
+#import "DictionaryC.h"
+#import "StringIndexer.h"
+
+namespace WhirlyKit
+{
+
+/**
+ Storage for flat attribute records and their strings.
+
+ Memory is handed out of big blocks and only freed when the arena goes away.
+ Strings are interned, so a value repeated across features is stored once.
+ One writer at a time.  Records keep a reference to the arena they live in.
+ */
+class AttrArena
+{
+public:
+    AttrArena(size_t blockSize = DefaultBlockSize);
+
+    /// Allocate memory that lives as long as the arena
+    void *alloc(size_t len,size_t align);
+
+    /// Copy a string into the arena, or find the copy we already have
+    std::string_view internString(std::string_view str);
+
+    /// Total size of the blocks we've allocated
+    size_t getSize() const { return totalSize; }
+
+    static const size_t DefaultBlockSize = 16*1024;
+
+protected:
+    size_t blockSize;
+    std::vector<std::unique_ptr<char[]> > blocks;
+    char *cur;
+    size_t left;
+    size_t totalSize;
+    std::unordered_set<std::string_view> strings;
+};
+typedef std::shared_ptr<AttrArena> AttrArenaRef;
+
+/// A single value in a flat attribute record.  Strings point elsewhere.
+struct FlatAttr
+{
+    FlatAttr() : key(0), type(DictTypeNone), strLen(0), i64Val(0) { }
+    FlatAttr(StringIdentity key,int val) : key(key), type(DictTypeInt), strLen(0), i64Val(0) { iVal = val; }
+    FlatAttr(StringIdentity key,double val) : key(key), type(DictTypeDouble), strLen(0), dVal(val) { }
+    FlatAttr(StringIdentity key,std::string_view val) : key(key), type(DictTypeString), strLen((uint32_t)val.size()), str(val.data()) { }
+
+    std::string_view getStringView() const { return std::string_view(str, strLen); }
+
+    StringIdentity key;
+    DictionaryType type;
+    // Length of the string, kept out here so the value fits in 8 bytes
+    uint32_t strLen;
+    union {
+        int iVal;
+        int64_t i64Val;
+        double dVal;
+        const char *str;
+    };
+};
+
+class FlatDictionary;
+typedef std::shared_ptr<FlatDictionary> FlatDictionaryRef;
+
+/**
+ An immutable attribute record laid out flat.
+
+ This is a list of interned keys and tagged values, with the strings living
+ in an arena.  It's far smaller and quicker to build than a MutableDictionaryC,
+ which makes it a better fit for the thousands of features in a vector tile.
+
+ It behaves just like a MutableDictionaryC when read.  It's not really meant
+ to be written to, but if it is, we copy it into a MutableDictionaryC and work
+ on that from then on.
+ */
+class FlatDictionary : public MutableDictionary
+{
+public:
+    /// Wrap a list of values without copying them.  Strings and values must outlive the dictionary.
+    /// The arena, if there is one, is the one they live in.
+    FlatDictionary(AttrArenaRef arena,const FlatAttr *attrs,unsigned int numAttrs);
+    virtual ~FlatDictionary() = default;
+
+    /// Make a record with a copy of the values in the given arena.
+    /// The strings are copied too, unless they're already in there.
+    static FlatDictionaryRef Make(const AttrArenaRef &arena,const FlatAttr *attrs,unsigned int numAttrs,bool copyStrings = true);
+
+    /// Add a value to a list we're building up.  Follows MutableDictionaryC's rules for repeated keys.
+    static void AddAttr(std::vector<FlatAttr> &attrs,const FlatAttr &attr);
+
+    virtual MutableDictionaryRef copy() const override;
+
+    virtual int count() const override;
+    virtual bool empty() const override { return count() == 0; }
+
+    /// Returns true if the field exists
+    virtual bool hasField(const std::string &name) const override;
+    /// Returns the field type
+    virtual DictionaryType getType(const std::string &name) const override;
+
+    /// Return an int, using the default if it's missing
+    virtual int getInt(const std::string &name,int defVal) const override;
+    /// Return a 64 bit unique identity or 0 if missing
+    virtual SimpleIdentity getIdentity(const std::string &name) const override;
+    /// Return a 64 bit value or 0 if missing
+    virtual int64_t getInt64(const std::string &name,int64_t defVal) const override;
+    /// Interpret an int as a boolean
+    virtual bool getBool(const std::string &name,bool defVal) const override;
+    /// Interpret an int as a RGBA color
+    virtual RGBAColor getColor(const std::string &name,const RGBAColor &defVal) const override;
+    /// Return a double, using the default if it's missing
+    virtual double getDouble(const std::string &name,double defVal) const override;
+    /// Return a string, or empty if it's missing
+    virtual std::string getString(const std::string &name) const override;
+    /// Return a string, using the default if it's missing
+    virtual std::string getString(const std::string &name,const std::string &defVal) const override;
+    /// Flat records don't hold dictionaries
+    virtual DictionaryRef getDict(const std::string &name) const override;
+    // Return a generic entry
+    virtual DictionaryEntryRef getEntry(const std::string &name) const override;
+    // Flat records don't hold arrays
+    virtual std::vector<DictionaryEntryRef> getArray(const std::string &name) const override;
+    // Return an array of keys
+    virtual std::vector<std::string> getKeys() const override;
+
+    /// These all switch us over to a MutableDictionaryC
+    virtual void clear() override;
+    virtual void removeField(const std::string &name) override;
+    virtual void setInt(const std::string &name,int val) override;
+    virtual void setInt64(const std::string &name,int64_t val) override;
+    virtual void setIdentifiable(const std::string &name,SimpleIdentity val) override;
+    virtual void setDouble(const std::string &name,double val) override;
+    virtual void setString(const std::string &name,const std::string &val) override;
+    virtual void addEntries(const Dictionary *other) override;
+
+    /// True until someone writes to us.  The values can only be looked up by key while this is set.
+    bool isFlat() const { return !thawed; }
+
+    /// Look for a value by its interned key, skipping the string lookup.  Only valid while isFlat().
+    const FlatAttr *findAttr(StringIdentity key) const
+    {
+        for (unsigned int ii=0;ii<numAttrs;ii++)
+            if (attrs[ii].key == key)
+                return &attrs[ii];
+        return nullptr;
+    }
+
+protected:
+    // Look for a value by key
+    const FlatAttr *find(const std::string &name) const;
+
+    // Copy ourselves into a mutable dictionary
+    MutableDictionaryC &thaw();
+
+    AttrArenaRef arena;
+    const FlatAttr *attrs;
+    unsigned int numAttrs;
+
+    // Set once someone writes to us
+    std::unique_ptr<MutableDictionaryC> thawed;
+};
+
+}
@@ -40,13 +40,16 @@ public:
     virtual Point3f geographicToLocal(GeoCoord c) const override { return Point3f(c.lon(),c.lat(),0.0); }
     virtual Point3d geographicToLocal3d(GeoCoord c) const override { return Point3d(c.lon(),c.lat(),0.0); }
     virtual Point3d geographicToLocal(Point2d c) const override { return Point3d(c.x(),c.y(),0.0); }
+    virtual void geographicToLocal(const Point2d *geo,Point3d *local,size_t count) const override;
 
     /// Convert from local coordinates to WGS84 geocentric
     virtual Point3f localToGeocentric(Point3f) const override;
     virtual Point3d localToGeocentric(Point3d) const override;
+    virtual void localToGeocentric(const Point3d *local,Point3d *geoc,size_t count) const override;
     /// Convert from WGS84 geocentric to local coordinates
     virtual Point3f geocentricToLocal(Point3f) const override;
     virtual Point3d geocentricToLocal(Point3d) const override;
+    virtual void geocentricToLocal(const Point3d *geoc,Point3d *local,size_t count) const override;
         
     /// Return true if the other coordinate system is also Plate Carree
     virtual bool isSameAs(CoordSystem *coordSys) const override;
@@ -70,13 +73,16 @@ public:
     virtual Point3f geographicToLocal(GeoCoord) const override;
     virtual Point3d geographicToLocal3d(GeoCoord) const override;
     virtual Point3d geographicToLocal(Point2d) const override;
+    virtual void geographicToLocal(const Point2d *geo,Point3d *local,size_t count) const override;
     
     /// Convert from local coordinates to WGS84 geocentric
     virtual Point3f localToGeocentric(Point3f) const override;
     virtual Point3d localToGeocentric(Point3d) const override;
+    virtual void localToGeocentric(const Point3d *local,Point3d *geoc,size_t count) const override;
     /// Convert from WGS84 geocentric to local coordinates
     virtual Point3f geocentricToLocal(Point3f) const override;
     virtual Point3d geocentricToLocal(Point3d) const override;
+    virtual void geocentricToLocal(const Point3d *geoc,Point3d *local,size_t count) const override;
     
     /// Return true if the other coordinate system is Flat Earth with the same origin
     virtual bool isSameAs(CoordSystem *coordSys) const override;
@@ -110,13 +116,16 @@ public:
     virtual Point3f geographicToLocal(GeoCoord) const override;
     virtual Point3d geographicToLocal3d(GeoCoord) const override;
     virtual Point3d geographicToLocal(Point2d) const override;
+    virtual void geographicToLocal(const Point2d *geo,Point3d *local,size_t count) const override;
     
     /// Convert from local coordinates to WGS84 geocentric
     virtual Point3f localToGeocentric(Point3f p) const override { return p; }
     virtual Point3d localToGeocentric(Point3d p) const override { return p; }
+    virtual void localToGeocentric(const Point3d *local,Point3d *geoc,size_t count) const override;
     /// Convert from WGS84 geocentric to local coordinates
     virtual Point3f geocentricToLocal(Point3f p) const override { return p; }
     virtual Point3d geocentricToLocal(Point3d p) const override { return p; }
+    virtual void geocentricToLocal(const Point3d *geoc,Point3d *local,size_t count) const override;
     
     /// Return true if the other coordinate system is Flat Earth with the same origin
     virtual bool isSameAs(CoordSystem *coordSys) const override;
@@ -0,0 +1,107 @@
+/*
+ *  GeoJSONReader.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <string>
+#import <vector>
+#import "VectorData.h"
+#import "Dictionary.h"
+
+namespace WhirlyKit
+{
+
+/**
+ Streaming GeoJSON reader.
+
+ This walks the text once, front to back, without building a DOM.
+ Coordinates go straight into the rings of the shapes they belong to and
+ properties go into a platform dictionary (MutableDictionaryMake) shared by
+ a feature's shapes, so callers can use and change them as they always have.
+ Keys may show up in any order within an object.
+
+ It handles FeatureCollection, Feature and bare geometry at the top level,
+ as well as newline delimited GeoJSON, one object per line.
+
+ A reader isn't thread safe, but it's cheap.  Use one per thread.
+ */
+class GeoJSONReader
+{
+public:
+    GeoJSONReader();
+
+    /// Parse a GeoJSON document, adding to the shapes we find.
+    /// The CRS name is filled in if there was one.  Returns false on failure.
+    bool parse(const char *json,size_t len,ShapeSet &shapes,std::string &crs);
+
+    /// Parse newline delimited GeoJSON, where each line is a Feature or geometry.
+    /// Chunks of lines are parsed on up to numThreads threads (0 for one per core)
+    ///  and then merged.  Returns false if any line fails.
+    static bool ParseLines(const char *json,size_t len,ShapeSet &shapes,int numThreads = 0);
+
+    /// Parse a single line of newline delimited GeoJSON.  Blank lines are fine.
+    bool parseLine(const char *line,size_t len,ShapeSet &shapes);
+
+    /// Description of what went wrong with the last parse
+    const std::string &getError() const { return error; }
+
+protected:
+    // Coordinates for one geometry along with where the nested arrays end
+    struct Coords
+    {
+        void clear();
+
+        std::vector<Point2f> pts;
+        // End of each entry in the coordinates array, as an index into pts
+        std::vector<uint32_t> childEnds;
+        // End of each entry one level further down, as an index into pts
+        std::vector<uint32_t> grandEnds;
+        // End of each entry's children, as an index into grandEnds
+        std::vector<uint32_t> childGrandEnds;
+        // The coordinates array is itself a position
+        bool rootIsPosition;
+        // An entry in the coordinates array is a position
+        bool childIsPosition;
+    };
+
+    enum ObjectLevel {TopLevel,FeatureLevel,GeometryLevel};
+
+    bool fail(const char *what);
+    inline void skipSpace();
+    inline bool expect(char c);
+
+    bool parseString(std::string &str);
+    bool parseNumber(double &val);
+    bool skipValue();
+    bool parseLiteral(const char *lit,size_t litLen);
+
+    // Parse a GeoJSON object (feature collection, feature or geometry)
+    bool parseObject(ShapeSet &shapes,ObjectLevel level,size_t depth,std::string *crs);
+    bool parseProperties(MutableDictionaryRef &dict);
+    bool parseCoordinates(Coords &coords);
+    bool parseCoordArray(Coords &coords,size_t depth);
+    bool parseCRS(std::string &crs);
+    bool buildGeometry(const std::string &type,const Coords &coords,ShapeSet &shapes);
+
+    const char *start,*ptr,*end;
+    std::string error;
+    // Scratch space, reused between objects
+    std::string key,strVal;
+    std::vector<Coords> coordStack;
+};
+
+}
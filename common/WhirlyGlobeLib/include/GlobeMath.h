@@ -39,20 +39,27 @@ public:
     virtual Point3f geographicToLocal(GeoCoord p) const override { return Point3f(p.lon(),p.lat(),0.0); }
     virtual Point3d geographicToLocal3d(GeoCoord p) const override { return Point3d(p.lon(),p.lat(),0.0); }
     virtual Point3d geographicToLocal(Point2d p) const override { return Point3d(p.x(),p.y(),0.0); }
+    virtual void geographicToLocal(const Point2d *geo,Point3d *local,size_t count) const override;
 
     /// Convert from local coordinates to WGS84 geocentric
     virtual Point3f localToGeocentric(Point3f p) const override { return LocalToGeocentric(p); }
     virtual Point3d localToGeocentric(Point3d p) const override { return LocalToGeocentric(p); }
+    virtual void localToGeocentric(const Point3d *local,Point3d *geoc,size_t count) const override { LocalToGeocentric(local,geoc,count); }
     /// Static version for convenience
     static Point3f LocalToGeocentric(Point3f);
     static Point3d LocalToGeocentric(Point3d);
+    /// Static version for a run of points.  This is one trip through proj.4 rather than one per point.
+    static void LocalToGeocentric(const Point3d *local,Point3d *geoc,size_t count);
     
     /// Convert from WGS84 geocentric to local coordinates
     virtual Point3f geocentricToLocal(Point3f p) const override { return GeocentricToLocal(p); }
     virtual Point3d geocentricToLocal(Point3d p) const override { return GeocentricToLocal(p); }
+    virtual void geocentricToLocal(const Point3d *geoc,Point3d *local,size_t count) const override { GeocentricToLocal(geoc,local,count); }
     /// Static version for convenience
     static Point3f GeocentricToLocal(Point3f);
     static Point3d GeocentricToLocal(Point3d);
+    /// Static version for a run of points
+    static void GeocentricToLocal(const Point3d *geoc,Point3d *local,size_t count);
     
     /// Convenience routine to convert a whole MBR to local coordinates
     static Mbr GeographicMbrToLocal(GeoMbr);
@@ -81,9 +88,11 @@ public:
     /// Convert from geographic+height to fake display geocentric
     virtual Point3f localToDisplay(Point3f p) const override { return LocalToDisplay(p); }
     virtual Point3d localToDisplay(Point3d p) const override { return LocalToDisplay(p); }
+    virtual void localToDisplay(const Point3d *local,Point3d *disp,size_t count) const override { LocalToDisplay(local,disp,count); }
     /// Static version
     static Point3f LocalToDisplay(Point3f);
     static Point3d LocalToDisplay(Point3d);
+    static void LocalToDisplay(const Point3d *local,Point3d *disp,size_t count);
 
     /// Convert from fake display geocentric to geographic+height
     virtual Point3f displayToLocal(Point3f p) const override { return DisplayToLocal(p); }
@@ -95,6 +104,7 @@ public:
     /// Return a normal for the given point
     virtual Point3f normalForLocal(Point3f p) const override { return LocalToDisplay(p); }
     virtual Point3d normalForLocal(Point3d p) const override { return LocalToDisplay(p); }
+    virtual void normalForLocal(const Point3d *local,Point3d *norms,size_t count) const override { LocalToDisplay(local,norms,count); }
     
     /// Get a reference to the coordinate system
     virtual CoordSystem *getCoordSystem() const override { return &geoCoordSys; }
@@ -124,9 +134,11 @@ public:
     /// Convert from geographic+height to fake display geocentric
     virtual Point3f localToDisplay(Point3f p) const override { return LocalToDisplay(p); }
     virtual Point3d localToDisplay(Point3d p) const override { return LocalToDisplay(p); }
+    virtual void localToDisplay(const Point3d *local,Point3d *disp,size_t count) const override { LocalToDisplay(local,disp,count); }
     /// Static version
     static Point3f LocalToDisplay(Point3f p);
     static Point3d LocalToDisplay(Point3d p);
+    static void LocalToDisplay(const Point3d *local,Point3d *disp,size_t count);
     
     /// Convert from fake display geocentric to geographic+height
     virtual Point3f displayToLocal(Point3f p) const override { return DisplayToLocal(p); }
@@ -138,6 +150,7 @@ public:
     /// Return a normal for the given point
     virtual Point3f normalForLocal(Point3f p) const override { return LocalToDisplay(p); }
     virtual Point3d normalForLocal(Point3d p) const override { return LocalToDisplay(p); }
+    virtual void normalForLocal(const Point3d *local,Point3d *norms,size_t count) const override { LocalToDisplay(local,norms,count); }
     
     /// Get a reference to the coordinate system
     virtual CoordSystem *getCoordSystem() const override { return &geoCoordSys; }
@@ -34,4 +34,39 @@ bool ClipLoopsToGrid(const std::vector<VectorRing> &rings,Point2f org,Point2f sp
 bool ClipLoopToMbr(const VectorRing &ring,const Mbr &mbr, bool closed,std::vector<VectorRing> &rets,double polyScale = 0.0);
 bool ClipLoopsToMbr(const std::vector<VectorRing> &rings,const Mbr &mbr, bool closed,std::vector<VectorRing> &rets,double polyScale = 0.0);
 
+/** Clips closed rings to an axis aligned box with Sutherland-Hodgman.
+    All the rings of a feature are clipped in one go.  The first ring is the outer,
+    the rest are holes.  Results come out the way Clipper returns them: outer
+    rings counter clockwise, holes clockwise.
+
+    Rings that would come apart into more than one piece go through Clipper instead.
+    Scratch memory is kept between calls, so reuse one per thread.
+  */
+class RectClipper
+{
+public:
+    RectClipper();
+
+    /// Clip the rings to the box, adding the results to rets.
+    /// polyScale is passed on to Clipper if we need it.
+    bool clipLoops(const VectorRing *rings,unsigned int numRings,const Mbr &mbr,std::vector<VectorRing> &rets,double polyScale = 0.0);
+
+protected:
+    // How a ring relates to the box
+    typedef enum {RingInside,RingOutside,RingContainsBox,RingCrosses,RingComplex} RingClass;
+
+    // Copy a ring into the coordinate arrays and work out how it sits
+    RingClass loadRing(const VectorRing &ring);
+    // Clip the loaded ring against all four sides
+    void clipRing();
+    // Add what's in the coordinate arrays to rets, wound the given way
+    void emitRing(const std::vector<float> &ringX,const std::vector<float> &ringY,bool ccw,std::vector<VectorRing> &rets);
+
+    float minX,minY,maxX,maxY;
+    // Coordinates, and scratch for the clipping passes
+    std::vector<float> xs,ys,tmpX,tmpY;
+    std::vector<int32_t> codes;
+    std::vector<VectorRing> results;
+};
+
 }
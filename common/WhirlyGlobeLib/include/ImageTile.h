@@ -49,6 +49,8 @@ public:
     int borderSize;
     int width,height,components;
     int targetWidth,targetHeight;
+    // Set if the data was decoded straight into the loader's texture format
+    bool dataInFormat;
 };
 
 typedef std::shared_ptr<ImageTile> ImageTileRef;
@@ -113,6 +113,24 @@ public:
     WhirlyKit::Point2d offset;
     // Set if we changed something during evaluation
     bool changed;
+
+    // Position in the importance ordering
+    unsigned int sortRank;
+    // Screen location for this round
+    Point2f screenPt;
+    bool screenInside;
+    // Screen location when it was last tested, less the accumulated view shift
+    Point2f layoutAnchor;
+    // Screen area it took up when last tested, also less the view shift.  Invalid if not placed.
+    Mbr layoutMbr;
+    // Orientation picked when last tested, or -1 if it wasn't placed
+    int layoutOrient;
+    // Set if the last test result can be reused
+    bool layoutTested;
+    // The last layout that looked at this object
+    unsigned int layoutFrame;
+    // Placement carried over in the layout manager's overlap helper, if any
+    int placedID;
 };
 
 typedef std::set<LayoutObjectEntry *,IdentifiableSorter> LayoutEntrySet;
@@ -228,6 +246,10 @@ public:
     /// Add a generator for cluster images
     void addClusterGenerator(PlatformThreadInfo *,ClusterGenerator *clusterGen);
 
+    /// Reuse the last layout for objects that haven't moved more than the threshold (in pixels)
+    ///  relative to the rest of the screen.  Anything near an object that did change is retested.
+    void setIncrementalLayout(bool enable,float moveThreshold = 1.0);
+
     /// Show lines around layout objects for debugging/troubleshooting
     bool getShowDebugBoundaries() const { return showDebugBoundaries; }
     void setShowDebugBoundaries(bool show) {
@@ -250,6 +272,14 @@ protected:
                                          const Eigen::Matrix4d &normalMat,
                                          const Point2f &frameBufferSize);
 
+    void sortLayoutObjects();
+    void groupLayoutObjects();
+
+    void resetPlacements(const Mbr &screenMbr,bool keep);
+    bool hasPlacement(const LayoutObjectEntry *entry) const;
+    void addPlacement(LayoutObjectEntry *entry,const Mbr &placedMbr,int rank);
+    void removePlacement(LayoutObjectEntry *entry);
+
     bool runLayoutRules(PlatformThreadInfo *threadInfo,
                         const ViewStateRef &viewState,
                         std::vector<ClusterEntry> &clusterEntries,
@@ -274,6 +304,45 @@ protected:
     bool showDebugBoundaries;
     /// Objects we're controlling the placement for
     LayoutEntrySet layoutObjects;
+    /// The same objects, sorted by importance
+    std::vector<LayoutObjectEntry *> sortedObjects;
+    /// Set if sortedObjects needs to be rebuilt
+    bool sortedObjectsDirty;
+    /// A run of regular objects that are close together in display space
+    struct LayoutObjectGroup
+    {
+        Point3d ll,ur;
+        unsigned int start,end;
+    };
+    /// Regular objects (no shape, cluster or unique ID) in groups we can skip when off screen
+    std::vector<LayoutObjectGroup> objectGroups;
+    std::vector<LayoutObjectEntry *> groupedObjects;
+    /// Everything else, which we look at on every layout
+    std::vector<LayoutObjectEntry *> ungroupedObjects;
+    /// Grouped objects we looked at on the last layout
+    std::vector<LayoutObjectEntry *> visitedObjects;
+    /// Objects the last layout could have changed
+    std::vector<LayoutObjectEntry *> updatedObjects;
+    /// Counts up with each layout
+    unsigned int layoutFrame;
+    /// Reuse the previous layout where we can
+    bool incrementalLayout;
+    /// How far an object can move before we test it again
+    float incrementalThreshold;
+    /// Set if we can't reuse anything from the last layout
+    bool fullLayoutNeeded;
+    /// How far the view has moved the objects since the last full layout
+    Point2f layoutShift;
+    /// Placements we carry from one layout to the next, less the view shift
+    OverlapHelper placedOverlap;
+    /// The object for each placement, or null if it's been taken out
+    std::vector<LayoutObjectEntry *> placedOwners;
+    int numPlacedOwners;
+    /// View shift when the placements were last gathered up
+    Point2f placedShift;
+    /// Screen setup for the last layout
+    Point2f lastFrameBufferSize;
+    float lastResScale;
     /// Drawables created on the last round
     SimpleIDSet drawIDs;
     /// Clusters on the current round
@@ -0,0 +1,106 @@
+/*
+ *  MBTilesReader.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <string>
+#import <vector>
+#import <mutex>
+#import <memory>
+#import "WhirlyVector.h"
+#import "RawData.h"
+#import "QuadTreeNew.h"
+
+namespace WhirlyKit
+{
+
+/**
+ Reads tiles out of an MBTiles file.
+
+ Connections to the database are pooled.  Each fetch checks out a connection,
+ along with its prepared statements, and hands it back when done, so several
+ threads can read at once without stepping on each other.
+
+ Tile rows are TMS, as they are in the file.  Gzipped tiles (usually vector tiles)
+ are decompressed on the way out unless that's turned off.
+
+ All methods are thread safe.
+ */
+class MBTilesReader
+{
+public:
+    MBTilesReader(const std::string &fileName);
+    virtual ~MBTilesReader();
+
+    /// Open the file and read the metadata.  Returns false on failure.
+    bool open();
+
+    /// Close all the connections
+    void close();
+
+    /// Decompress gzipped tiles.  On by default.
+    void setDecompress(bool newVal) { decompress = newVal; }
+
+    /// Levels as given by the metadata or the tiles themselves
+    int getMinZoom() const { return minZoom; }
+    int getMaxZoom() const { return maxZoom; }
+
+    /// Format from the metadata (e.g. png, jpg, pbf).  May be empty.
+    const std::string &getFormat() const { return format; }
+
+    /// Geographic bounds from the metadata, or the whole earth if there weren't any
+    const GeoMbr &getGeoMbr() const { return geoMbr; }
+
+    /// Fetch a single tile.  Returns null if it's not there.
+    RawDataRef fetchTile(const QuadTreeIdentifier &ident);
+
+    /// Fetch a group of tiles, batching the queries where we can.
+    /// Returns one entry per tile, null if it's not there.
+    std::vector<RawDataRef> fetchTiles(const std::vector<QuadTreeIdentifier> &idents);
+
+    /// Largest number of tiles we'll look for in one query
+    static const int MaxBatchSize = 64;
+
+protected:
+    class Connection;
+    typedef std::unique_ptr<Connection> ConnectionRef;
+
+    // Check out a connection, opening a new one if need be
+    ConnectionRef getConnection();
+    // Put a connection back in the pool
+    void releaseConnection(ConnectionRef &&conn);
+
+    // Read the metadata from the database
+    bool readMetadata(Connection *conn);
+
+    // Copy or decompress the tile data into something we can hand back
+    RawDataRef makeTileData(Connection *conn,const void *data,int len);
+
+    std::mutex lock;
+    std::string fileName;
+    std::vector<ConnectionRef> connections;
+    bool isOpen;
+
+    bool decompress;
+    bool tilesStyle;
+    int minZoom,maxZoom;
+    std::string format;
+    GeoMbr geoMbr;
+};
+typedef std::shared_ptr<MBTilesReader> MBTilesReaderRef;
+
+}
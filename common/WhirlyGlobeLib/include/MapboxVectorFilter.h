@@ -19,8 +19,13 @@
 */
 
 #import "Dictionary.h"
+#import "FlatDictionary.h"
 #import "QuadTreeNew.h"
+#import "StringIndexer.h"
 #import <string>
+#import <string_view>
+#import <unordered_map>
+#import <vector>
 
 namespace WhirlyKit
 {
@@ -68,4 +73,94 @@ public:
     std::vector<MapboxVectorFilterRef> subFilters;
 };
 
+/** @brief Filters for a group of layers, compiled down to a flat list of nodes.
+    Layers that read the same source layer share one of these.  Identical sub-filters
+     compile to the same node, so they're evaluated once per feature, and each
+     attribute is looked up at most once per feature.
+    Attributes are referred to by their StringIndexer IDs, so the flat records
+     the tile parser builds are searched directly, without hashing the names.
+    Anything the compiled form can't handle exactly falls back to MapboxVectorFilter::testFeature.
+  */
+class MapboxVectorFilterProgram
+{
+public:
+    /// @brief Per-feature evaluation state.  Keep one around per thread and reuse it.
+    class State
+    {
+        friend class MapboxVectorFilterProgram;
+    protected:
+        struct Attr
+        {
+            bool fetched = false;
+            DictionaryType type = DictTypeNone;
+            // Points into the feature's record when it's flat, otherwise into strStore
+            std::string_view str;
+            std::string strStore;
+            double dVal = 0.0;
+            int iVal = 0;
+            int64_t i64Val = 0;
+        };
+
+        const Dictionary *attrs = nullptr;
+        const FlatDictionary *flatAttrs = nullptr;
+        const QuadTreeIdentifier *tileID = nullptr;
+        std::vector<int8_t> results;
+        std::vector<Attr> attrVals;
+    };
+
+    /// @brief Compile a filter in.  Returns the node to test, or -1 if there was no filter.
+    int addFilter(const MapboxVectorFilterRef &filter);
+
+    /// @brief Get the state ready for a new feature
+    void begin(State &state,const Dictionary &attrs,const QuadTreeIdentifier &tileID) const;
+
+    /// @brief Test the current feature against the filter compiled to the given node
+    bool test(State &state,int node) const;
+
+    /// @brief Number of distinct nodes after sharing
+    int numNodes() const { return (int)nodes.size(); }
+
+protected:
+    // A constant from the style sheet in a form we can compare quickly
+    struct Value
+    {
+        DictionaryType type;
+        std::string str;
+        double dVal;
+        int iVal;
+        int64_t i64Val;
+    };
+
+    enum NodeType {NodeGeneric,NodeGeom,NodeCompare,NodeIn,NodeHas,NodeAll,NodeAny};
+
+    struct Node
+    {
+        NodeType nodeType;
+        MapboxVectorFilterType filterType;
+        MapboxVectorGeometryType geomType;
+        int attr;
+        // Constants for comparisons, children for all/any
+        unsigned int firstArg,numArgs;
+        // Original filter, for anything we can't do here
+        MapboxVectorFilterRef filter;
+    };
+
+    int compile(const MapboxVectorFilterRef &filter);
+    int addNode(const Node &node,const std::string &key);
+    int attrID(const std::string &name);
+    bool addValue(const DictionaryEntryRef &entry,std::string &key);
+    const State::Attr &fetch(State &state,int attr) const;
+    bool eval(State &state,int node) const;
+    bool evalNode(State &state,const Node &node) const;
+
+    std::vector<Node> nodes;
+    std::vector<Value> values;
+    std::vector<int> children;
+    // Each attribute we look at gets a slot in the state, by its interned key
+    std::vector<StringIdentity> attrKeys;
+    std::vector<std::string> attrNames;
+    std::unordered_map<StringIdentity,int> attrSlots;
+    std::unordered_map<std::string,int> nodeIDs;
+};
+
 }
@@ -24,6 +24,7 @@
 #import "MapboxVectorTileParser.h"
 #import "MaplyVectorStyleC.h"
 #import "MapboxVectorStyleSpritesImpl.h"
+#import "MapboxVectorFilter.h"
 #import <set>
 
 namespace WhirlyKit
@@ -335,8 +336,12 @@ public:
     virtual double calculateTextWidth(PlatformThreadInfo *inInst,const LabelInfoRef &labelInfo,const std::string &testStr) = 0;
     
     /// Add a sprite sheet for use by the layers
+    /// This may be called while tiles are building, so it replaces the sprites atomically
     virtual void addSprites(MapboxVectorStyleSpritesRef newSprites);
 
+    /// The current sprite sheet, if any.  Use this rather than reading sprites directly.
+    MapboxVectorStyleSpritesRef getSprites() const { return std::atomic_load(&sprites); }
+
     /// Create a local platform component object
     virtual ComponentObjectRef makeComponentObject(PlatformThreadInfo *inst, const Dictionary *desc = nullptr) = 0;
 
@@ -363,6 +368,15 @@ public:
     /// @brief Layers sorted by source layer name
     std::unordered_multimap<std::string, MapboxVectorStyleLayerRef> layersBySource;
 
+    /// @brief Filters for all the layers that read a given source layer, compiled together
+    struct SourceLayerFilters
+    {
+        MapboxVectorFilterProgram program;
+        /// Layers in the same order as layersBySource, with the node to test for each
+        std::vector<std::pair<MapboxVectorStyleLayerRef,int> > layers;
+    };
+    std::unordered_map<std::string, SourceLayerFilters> filtersBySource;
+
     VectorManagerRef vecManage;
     WideVectorManagerRef wideVecManage;
     MarkerManagerRef markerManage;
@@ -21,6 +21,7 @@
 #import "QuadTreeNew.h"
 #import "ImageTile.h"
 #import "ComponentManager.h"
+#import "FlatDictionary.h"
 
 namespace WhirlyKit
 {
@@ -90,6 +91,9 @@ public:
     
     /// In some cases we're just creating low level ChangeSets
     ChangeSet changes;
+
+    /// Feature attributes for this tile live here
+    AttrArenaRef attrArena;
 };
 typedef std::shared_ptr<VectorTileData> VectorTileDataRef;
   
@@ -153,7 +157,28 @@ public:
     void setDebugOutline(bool b = true) { debugOutline = b; }
 
     const VectorStyleDelegateImplRef &getStyleDelegate() const { return styleDelegate; }
+
+    /// Make and release the per-thread platform info used by a worker thread
+    using ThreadInfoMaker = std::function<PlatformThreadInfo *()>;
+    using ThreadInfoReleaser = std::function<void(PlatformThreadInfo *)>;
+
+    /// Build the styles for a tile on a pool of worker threads rather than one after the other.
+    /// The calling thread works on the tile too.  Results are merged in style order, so the
+    ///  output is the same as a serial build.  Pass 0 threads to turn this back off.
+    /// Worker threads get their platform info from makeInfo, which is required.
+    /// Workers that can't get one sit out.  If makeInfo isn't set, or none of
+    ///  the workers get platform info, tiles are built serially.
+    /// Safe to call while other threads are parsing.
+    void setParallelBuild(unsigned int numThreads,
+                          ThreadInfoMaker makeInfo = ThreadInfoMaker(),
+                          ThreadInfoReleaser releaseInfo = ThreadInfoReleaser());
+
 protected:
+    class BuildPool;
+
+    /// Sort a style's results into categories and merge them into the tile
+    void mergeStyleData(long long styleID,VectorTileData *tileData,VectorTileData *styleData);
+
     /// If set, we'll parse into local coordinates as specified by the bounding box, rather than geo coords
     bool localCoords;
 
@@ -177,6 +202,9 @@ protected:
 
     VectorStyleDelegateImplRef styleDelegate;
     std::map<long long,std::string> styleCategories;
+
+    /// Workers for parallel style building, if turned on
+    std::shared_ptr<BuildPool> buildPool;
 };
 
 typedef std::shared_ptr<MapboxVectorTileParser> MapboxVectorTileParserRef;
@@ -0,0 +1,128 @@
+/*
+ *  MappedShapeReader.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <string>
+#import <vector>
+#import "VectorData.h"
+#import "VectorObject.h"
+#import "Dictionary.h"
+
+namespace WhirlyKit
+{
+
+/**
+ Memory mapped Shapefile reader.
+
+ Maps the .shp, .shx and .dbf files and decodes records straight out of them,
+ rather than going through shapelib a record at a time.  Nothing is read until
+ it's asked for and records can be decoded from several threads at once.
+
+ Attributes go into a platform dictionary per record, as with ShapeReader.  Pass a set of attribute
+ names to only decode those.  Like ShapeReader, each record also gets its
+ index in "wgshapefileidx".
+
+ The .shx file is optional, we'll walk the .shp file if it's missing.
+ The .dbf is optional as well.
+ */
+class MappedShapeReader : public VectorReader
+{
+public:
+    /// Construct with the name of the .shp file (or the name without an extension)
+    MappedShapeReader(const std::string &fileName);
+    virtual ~MappedShapeReader();
+
+    /// Return true if we managed to map the file
+    virtual bool isValid() override;
+
+    /// Return the next feature
+    virtual VectorShapeRef getNextObject(const StringSet *filterAttrs) override;
+
+    /// We can do random seeking
+    virtual bool canReadByIndex() override { return true; }
+
+    /// The total number of shapes in the file
+    virtual unsigned int getNumObjects() override;
+
+    /// Fetch an object by the index.  Null records come back as empty shapes.
+    virtual VectorShapeRef getObjectByIndex(unsigned int vecIndex,const StringSet *filterAttrs) override;
+
+    /// Decode the records in [start,end) into shapes.
+    /// Null records are skipped, unless keepNulls is set, in which case they come back as empty shapes.
+    /// Safe to call from several threads at once.
+    void readRange(unsigned int start,unsigned int end,const StringSet *filterAttrs,std::vector<VectorShapeRef> &shapes,bool keepNulls = false);
+
+    /// Decode the whole file into vector objects holding up to batchSize records each.
+    /// Batches are decoded on up to numThreads threads (0 for one per core) and come back in file order.
+    std::vector<VectorObjectRef> readBatches(unsigned int batchSize,const StringSet *filterAttrs,int numThreads = 0,bool keepNulls = false);
+
+protected:
+    // A read only memory mapped file
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        // We own the mapping, so no copies
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        bool open(const std::string &fileName);
+
+        const unsigned char *data;
+        size_t len;
+    };
+
+    // A field in the .dbf file
+    struct Field
+    {
+        std::string name;
+        DictionaryType type;
+        char dbfType;
+        int offset,width;
+    };
+
+    bool openFiles(const std::string &baseName);
+    bool readIndex();
+    bool readDbfHeader();
+
+    // Which fields to decode for the given filter
+    std::vector<const Field *> projectFields(const StringSet *filterAttrs) const;
+
+    // Decode the geometry for a record, or return null for a null record
+    VectorShapeRef decodeShape(unsigned int which) const;
+
+    // An empty shape of the file's type, to stand in for a null record
+    VectorShapeRef makeEmptyShape() const;
+    // Decode the attributes for a record into a new dictionary
+    MutableDictionaryRef decodeAttrs(unsigned int which,const std::vector<const Field *> &fields) const;
+
+    MappedFile shp,shx,dbf;
+    bool valid;
+    int shapeType;
+    unsigned int where;
+    // Byte offset of each record in the .shp file
+    std::vector<uint32_t> recordOffsets;
+
+    unsigned int numDbfRecords;
+    unsigned int dbfHeaderLen,dbfRecordLen;
+    std::vector<Field> fields;
+};
+
+}
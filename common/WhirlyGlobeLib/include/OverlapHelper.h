@@ -19,6 +19,7 @@
  */
 
 #import <math.h>
+#import <climits>
 #import <set>
 #import <map>
 #import "Identifiable.h"
@@ -51,21 +52,55 @@ public:
     
     // Force an object in no matter what
     void addObject(const Point2dVector &pts);
-    
+
+    // Add an object that only blocks checks with a higher rank.  Returns its ID.
+    int addObject(const Mbr &objMbr,int rank);
+
+    // See if there's an object with a lower rank in the way
+    bool checkObject(const Mbr &objMbr,int rank = INT_MAX);
+
+    // Change the rank of an object we've already added
+    void setObjectRank(int which,int rank);
+
+    // Take an object back out.  It won't block anything from here on.
+    void removeObject(int which);
+
+    // Number of objects added, including the ones taken out
+    int numObjects() const { return (int)objects.size(); }
+
 protected:
-    // Object and its bounds
-    class BoundedObject
+    // Work out which cells the bounds cover
+    void calcCells(const Mbr &objMbr,int &sx,int &sy,int &ex,int &ey) const;
+
+    // See if any existing object with a lower rank overlaps the bounds
+    bool checkCells(const Mbr &objMbr,int sx,int sy,int ex,int ey,int rank = INT_MAX);
+
+    // Add the bounds as a new object in the given cells
+    int addToCells(const Mbr &objMbr,int sx,int sy,int ex,int ey,int rank = INT_MIN);
+
+    // One entry in a cell's list of objects
+    struct CellEntry
     {
-    public:
-        ~BoundedObject() { }
-        Point2dVector pts;
+        int object;
+        int next;
     };
-    
+
     Mbr mbr;
-    std::vector<BoundedObject> objects;
     int sizeX,sizeY;
     Point2f cellSize;
-    std::vector<std::vector<int> > grid;
+    // Bounds of the objects we've added.  The overlap test only needs these.
+    std::vector<Mbr> objects;
+    // Objects only block checks with a higher rank.  Removed ones have the highest rank there is.
+    std::vector<int> objectRanks;
+    // Last check each object was tested in, so we only test it once per check
+    std::vector<unsigned int> objectChecks;
+    unsigned int curCheck;
+    // First entry for each cell, or -1
+    std::vector<int> cellHeads;
+    // Cell entries for all the cells, chained together
+    std::vector<CellEntry> cellEntries;
+    // One bit per cell, set if there's anything in it
+    std::vector<uint64_t> cellsOccupied;
 };
 
 // Used to figure out what clusters
@@ -117,8 +152,8 @@ public:
     // Remove the given index from the cells it covers
     void removeFromCells(const Mbr &mbr,int index);
     
-    // Return all the objects within the overlap
-    void findObjectsWithin(const Mbr &mbr,std::set<int> &objSet);
+    // Return all the objects within the overlap, sorted
+    void findObjectsWithin(const Mbr &mbr,std::vector<int> &objs);
     
     void calcCells(const Mbr &mbr,int &sx,int &sy,int &ex,int &ey);
 
@@ -128,11 +163,11 @@ public:
     std::vector<SimpleObject> simpleObjects;
     std::vector<ClusterObject> clusterObjects;
 
-    // Grid we're sorting into for fast lookup
+    // Grid we're sorting into for fast lookup.  Each cell is kept sorted.
     int sizeX,sizeY;
     float resScale;
     Point2d cellSize;
-    std::vector<std::set<int> > grid;
+    std::vector<std::vector<int> > grid;
 };
     
 }
@@ -21,6 +21,7 @@
 #import <string>
 #import <map>
 #import "WhirlyTypes.h"
+#import "PerformanceTrace.h"
 
 namespace WhirlyKit
 {
@@ -61,8 +62,12 @@ public:
     /// Start timing the given thing
     void startTiming(const std::string &);
     
-    /// Stop timing the given thing and add it to the existing timings
+    /// Stop timing the given thing and add it to the existing timings.
+    /// With tracing built in, this also records a trace span.
     void stopTiming(const std::string &);
+
+    /// Add a duration measured elsewhere to the existing timings
+    void addTime(const std::string &what,TimeInterval dur);
     
     /// Add a count for a particular instance
     void addCount(const std::string &what,int count);
@@ -73,13 +78,17 @@ public:
     /// Clean out existing timings
     void clear();
     
-    /// Write out the timings to NSLog
+    /// Write out the timings to NSLog, along with the trace durations if tracing is built in
     void log();
     
 protected:
     std::map<std::string,TimeInterval> actives;
     std::map<std::string,TimeEntry> timeEntries;
     std::map<std::string,CountEntry> countEntries;
+#if WK_TRACE_ENABLED
+    // Trace names we've already registered, so stopTiming doesn't go through the registry lock
+    std::map<std::string,TraceNameID> traceNameIDs;
+#endif
 };
     
 }
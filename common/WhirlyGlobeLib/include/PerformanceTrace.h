@@ -0,0 +1,189 @@
+/*
+ *  PerformanceTrace.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <atomic>
+#import <cstdint>
+#import <string>
+#import <vector>
+#import "WhirlyTypes.h"
+
+// Set WK_TRACE_ENABLED=1 to build the tracing in.
+// Otherwise the WK_TRACE_ macros below compile to nothing.
+#if !defined(WK_TRACE_ENABLED)
+#  define WK_TRACE_ENABLED 0
+#endif
+
+namespace WhirlyKit
+{
+
+/// Trace names are registered once and then referred to by number
+typedef uint16_t TraceNameID;
+
+/** Low overhead event tracing.
+    Each thread records into its own fixed size ring buffer without locking.
+    When a buffer fills up, the oldest events are overwritten.
+    Names are registered once, usually through the static in the WK_TRACE_ macros,
+    so recording an event is just a couple of timestamps and a store.
+    What's been recorded can be written out as Chrome trace JSON (chrome://tracing or Perfetto)
+    or summarized as duration percentiles.
+  */
+class PerformanceTrace
+{
+public:
+    typedef enum : uint8_t {Span,Instant,Counter,AsyncBegin,AsyncEnd} EventType;
+
+    /// A single recorded event.  Times are nanoseconds since the trace started.
+    struct Event
+    {
+        uint64_t start;
+        uint64_t dur;
+        /// Counter value, async ID, or an ID to tie a span to (e.g. a tile)
+        int64_t value;
+        TraceNameID name;
+        EventType type;
+    };
+
+    /// Durations for one name, in seconds.
+    /// Async events are measured from begin to end for the same ID.
+    struct Histogram
+    {
+        std::string name;
+        int count;
+        TimeInterval minDur,p50,p90,p99,maxDur;
+    };
+
+    /// Events kept per thread before we start overwriting.
+    /// One slot is always the next to be written, so getEvents returns BufferSize-1 per thread at most.
+    static const unsigned int BufferSize = 1<<13;
+
+    /// Turn recording on or off.  On by default when tracing is built in.
+    static void setEnabled(bool enable);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    /// Register a name, or return the existing ID for it.
+    /// This locks, so keep the result around.
+    static TraceNameID registerName(const char *name);
+
+    /// Return the name for an ID
+    static std::string getName(TraceNameID nameID);
+
+    /// Name the calling thread in the output
+    static void setThreadName(const std::string &name);
+
+    /// Nanoseconds since the trace started
+    static uint64_t now();
+
+    /// Record a span that's already been timed
+    static void addSpan(TraceNameID name,uint64_t start,uint64_t end,int64_t value = 0);
+
+    /// Record a single point in time
+    static void addInstant(TraceNameID name,int64_t value = 0);
+
+    /// Record a value that changes over time, like a queue depth
+    static void addCounter(TraceNameID name,int64_t value);
+
+    /// Start of something that ends later, possibly on another thread
+    static void addAsyncBegin(TraceNameID name,int64_t asyncID);
+
+    /// End of an async event, matched to the begin by name and ID
+    static void addAsyncEnd(TraceNameID name,int64_t asyncID);
+
+    /// Forget everything recorded so far
+    static void clear();
+
+    /// Copy out what's been recorded, per thread.
+    /// It's safe to do this while other threads are recording, but they may
+    ///  overwrite events at the very start of their buffers as we copy.  Those are dropped.
+    static void getEvents(std::vector<std::pair<int,std::vector<Event>>> &events);
+
+    /// Everything recorded so far as Chrome trace JSON
+    static std::string exportChromeTrace();
+
+    /// Write the Chrome trace JSON to a file
+    static bool writeChromeTrace(const std::string &fileName);
+
+    /// Duration percentiles for spans and async events, sorted by name
+    static std::vector<Histogram> makeHistograms();
+
+    /// Write the duration percentiles to the log
+    static void log();
+
+    /// Pack a tile identifier into an async ID
+    static int64_t tileID(int level,int x,int y)
+        { return ((int64_t)level << 56) | ((int64_t)(x & 0xfffffff) << 28) | (int64_t)(y & 0xfffffff); }
+
+protected:
+    static std::atomic<bool> enabled;
+};
+
+/// Records a span from construction to destruction
+class TraceSpan
+{
+public:
+    TraceSpan(TraceNameID name,int64_t value = 0)
+        : name(name), value(value), active(PerformanceTrace::isEnabled()),
+          start(active ? PerformanceTrace::now() : 0) { }
+    ~TraceSpan() { if (active) PerformanceTrace::addSpan(name,start,PerformanceTrace::now(),value); }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+protected:
+    TraceNameID name;
+    int64_t value;
+    bool active;
+    uint64_t start;
+};
+
+}
+
+#if WK_TRACE_ENABLED
+
+#define WK_TRACE_CONCAT2(a,b) a##b
+#define WK_TRACE_CONCAT(a,b) WK_TRACE_CONCAT2(a,b)
+
+// Register the name the first time through and reuse the ID after that
+#define WK_TRACE_NAME(name) \
+    ([]{ static const WhirlyKit::TraceNameID traceNameID = WhirlyKit::PerformanceTrace::registerName(name); return traceNameID; }())
+
+/// Time the rest of the enclosing scope
+#define WK_TRACE_SCOPE(name) \
+    WhirlyKit::TraceSpan WK_TRACE_CONCAT(wkTraceSpan,__LINE__)(WK_TRACE_NAME(name))
+/// Time the rest of the enclosing scope, tagged with an ID such as PerformanceTrace::tileID()
+#define WK_TRACE_SCOPE_ID(name,id) \
+    WhirlyKit::TraceSpan WK_TRACE_CONCAT(wkTraceSpan,__LINE__)(WK_TRACE_NAME(name),(id))
+#define WK_TRACE_INSTANT(name) \
+    do { if (WhirlyKit::PerformanceTrace::isEnabled()) WhirlyKit::PerformanceTrace::addInstant(WK_TRACE_NAME(name)); } while (0)
+#define WK_TRACE_COUNTER(name,val) \
+    do { if (WhirlyKit::PerformanceTrace::isEnabled()) WhirlyKit::PerformanceTrace::addCounter(WK_TRACE_NAME(name),(val)); } while (0)
+#define WK_TRACE_ASYNC_BEGIN(name,id) \
+    do { if (WhirlyKit::PerformanceTrace::isEnabled()) WhirlyKit::PerformanceTrace::addAsyncBegin(WK_TRACE_NAME(name),(id)); } while (0)
+#define WK_TRACE_ASYNC_END(name,id) \
+    do { if (WhirlyKit::PerformanceTrace::isEnabled()) WhirlyKit::PerformanceTrace::addAsyncEnd(WK_TRACE_NAME(name),(id)); } while (0)
+
+#else
+
+#define WK_TRACE_SCOPE(name) do { } while (0)
+#define WK_TRACE_SCOPE_ID(name,id) do { } while (0)
+#define WK_TRACE_INSTANT(name) do { } while (0)
+#define WK_TRACE_COUNTER(name,val) do { } while (0)
+#define WK_TRACE_ASYNC_BEGIN(name,id) do { } while (0)
+#define WK_TRACE_ASYNC_END(name,id) do { } while (0)
+
+#endif
@@ -43,13 +43,17 @@ public:
     virtual Point3f geographicToLocal(GeoCoord) const override;
     virtual Point3d geographicToLocal3d(GeoCoord) const override;
     virtual Point3d geographicToLocal(Point2d) const override;
+    /// Batch versions go through proj.4 all at once
+    virtual void geographicToLocal(const Point2d *geo,Point3d *local,size_t count) const override;
     
     /// Convert from the local coordinate system to geocentric
     virtual Point3f localToGeocentric(Point3f) const override;
     virtual Point3d localToGeocentric(Point3d) const override;
+    virtual void localToGeocentric(const Point3d *local,Point3d *geoc,size_t count) const override;
     /// Convert from display coordinates to geocentric
     virtual Point3f geocentricToLocal(Point3f) const override;
     virtual Point3d geocentricToLocal(Point3d) const override;
+    virtual void geocentricToLocal(const Point3d *geoc,Point3d *local,size_t count) const override;
     
     /// True if the other system is Spherical Mercator with the same origin
     virtual bool isSameAs(CoordSystem *coordSys) const override;
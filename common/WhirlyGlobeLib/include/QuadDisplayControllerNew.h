@@ -90,9 +90,9 @@ public:
     /// Load some tiles, unload others, and the rest had their importance values change
     /// Return the nodes we wanted to keep rather than delete
     virtual QuadTreeNew::NodeSet quadLoaderUpdate(PlatformThreadInfo *threadInfo,
-                                                  const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,
+                                                  const WhirlyKit::QuadTreeNew::ImportantNodeVector &loadTiles,
                                                   const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
-                                                  const WhirlyKit::QuadTreeNew::ImportantNodeSet &updateTiles,
+                                                  const WhirlyKit::QuadTreeNew::ImportantNodeVector &updateTiles,
                                                   int targetLevel,
                                                   ChangeSet &changes) = 0;
     
@@ -197,7 +197,7 @@ protected:
     bool singleLevel;
     std::vector<int> levelLoads;
 
-    QuadTreeNew::ImportantNodeSet currentNodes;
+    QuadTreeNew::ImportantNodeVector currentNodes;
     
     float lastTargetLevel;   // For tracking continuous zoom
     float lastTargetDecimal; 
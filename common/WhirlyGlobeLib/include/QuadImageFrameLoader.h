@@ -230,6 +230,12 @@ public:
 
     // Return all the low level data (and reset it) if we're in that mode
     virtual void getLoadedData(std::vector<RawDataRef> &allData);
+
+    // Start the "Tile Load" trace event, if tracing is on
+    void beginLoadTrace();
+
+    // End the "Tile Load" trace event behind the given changes, if it's still open
+    void endLoadTrace(ChangeSet &changes);
             
 protected:
     // Specialized frame asset
@@ -242,6 +248,9 @@ protected:
     
     // Set if the sampling layer thinks this should be on
     bool shouldEnable;
+
+    // Set while the "Tile Load" trace event is waiting on the last frame
+    bool loadTraceOpen;
     
     // One set of instance IDs per focus
     std::vector<std::vector<SimpleIdentity> > instanceDrawIDs;
@@ -280,6 +289,10 @@ public:
         // Node we're using a texture from (could be this one)
         QuadTreeNew::Node texNode;
         std::vector<SimpleIdentity> texIDs;
+
+        bool operator == (const FrameInfo &that) const {
+            return enabled == that.enabled && texNode == that.texNode && texIDs == that.texIDs;
+        }
     };
     
     // Component objects associated with the tile
@@ -291,13 +304,19 @@ public:
 typedef std::shared_ptr<QIFTileState> QIFTileStateRef;
     
 // Used to track loading state and hand it over to the main thread
+// Tile states are shared between successive render states and never modified
+//  once built, so a tile that didn't change is carried over rather than copied.
 class QIFRenderState
 {
 public:
     QIFRenderState();
     QIFRenderState(int numFocus,int numFrames);
     
-    std::map<QuadTreeNew::Node,QIFTileStateRef> tiles;
+    // Tile states in node order (level, then y, then x)
+    std::vector<QIFTileStateRef> tiles;
+
+    // Bumped by the layer thread for each state it hands over
+    unsigned int version;
 
     int texSize,borderSize;
     
@@ -397,6 +416,7 @@ public:
 
     /// In-memory texture type
     void setTexType(TextureType type) { texType = type; }
+    TextureType getTexType() const { return texType; }
     
     /// If we're using border pixels, set the individual texture size and border size
     void setTexSize(int texSize,int borderSize);
@@ -444,7 +464,7 @@ public:
     /// Before we tell the delegate to unload tiles, see if they want to keep them around
     /// Returns the tiles we want to preserve after all
     virtual QuadTreeNew::NodeSet builderUnloadCheck(QuadTileBuilder *inBuilder,
-                                                    const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,
+                                                    const WhirlyKit::QuadTreeNew::ImportantNodeVector &loadTiles,
                                                     const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
                                                     int inTargetLevel) override;
     
@@ -613,6 +633,11 @@ protected:
     // Tile rendering info supplied from the layer thread
     QIFRenderState renderState;
     
+    // Last render state we built on the layer thread.  Used to reuse unchanged tiles.
+    std::shared_ptr<const QIFRenderState> lastBuiltState;
+    // Scratch tile state so unchanged tiles don't allocate
+    std::unique_ptr<QIFTileState> scratchTileState;
+    
     bool changesSinceLastFlush;
     
     // We number load requests so we can catch old ones after doing a reload
@@ -104,7 +104,7 @@ public:
     /// Before we tell the delegate to unload tiles, see if they want to keep them around
     /// Returns the tiles we want to preserve after all
     virtual QuadTreeNew::NodeSet builderUnloadCheck(QuadTileBuilder *inBuilder,
-                                                    const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,
+                                                    const WhirlyKit::QuadTreeNew::ImportantNodeVector &loadTiles,
                                                     const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
                                                     int targetLevel) override;
     
@@ -139,6 +139,19 @@ protected:
     
     bool builderStarted = false;
     bool valid = true;
+
+    // Display solids are expensive to build and don't change with the view, so keep them around.
+    // Only touched from the layer thread, via the display controller.
+    struct CachedSolid
+    {
+        Mbr mbr;
+        DisplaySolidRef solid;
+        unsigned int lastUsed;
+    };
+    DisplaySolidRef &cachedSolid(const QuadTreeIdentifier &ident,const Mbr &mbr);
+
+    std::unordered_map<int64_t,CachedSolid> solidCache;
+    unsigned int viewGeneration = 0;
 };
     
 }
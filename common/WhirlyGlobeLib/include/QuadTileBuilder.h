@@ -35,7 +35,7 @@ public:
     LoadedTileVec loadTiles;
     QuadTreeNew::NodeSet unloadTiles;
     LoadedTileVec enableTiles,disableTiles;
-    QuadTreeNew::ImportantNodeSet changeTiles;
+    QuadTreeNew::ImportantNodeVector changeTiles;
 };
 
 /// Protocol used by the tile builder to notify an interested party about what's
@@ -52,7 +52,7 @@ public:
     /// Before we tell the delegate to unload tiles, see if they want to keep them around
     /// Returns the tiles we want to preserve after all
     virtual QuadTreeNew::NodeSet builderUnloadCheck(QuadTileBuilder *builder,
-                                                  const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,
+                                                  const WhirlyKit::QuadTreeNew::ImportantNodeVector &loadTiles,
                                                   const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
                                                   int targetLevel) = 0;
     
@@ -136,9 +136,9 @@ protected:
     /// Load some tiles, unload others, and the rest had their importance values change
     /// Return the nodes we wanted to keep rather than delete
     virtual QuadTreeNew::NodeSet quadLoaderUpdate(PlatformThreadInfo *threadInfo,
-                                                  const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,
+                                                  const WhirlyKit::QuadTreeNew::ImportantNodeVector &loadTiles,
                                                   const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
-                                                  const WhirlyKit::QuadTreeNew::ImportantNodeSet &updateTiles,
+                                                  const WhirlyKit::QuadTreeNew::ImportantNodeVector &updateTiles,
                                                   int targetLevel,
                                                   ChangeSet &changes);
     
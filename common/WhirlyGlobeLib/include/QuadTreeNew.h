@@ -20,6 +20,7 @@
 
 #import "WhirlyVector.h"
 #import <set>
+#import <vector>
 
 namespace WhirlyKit
 {
@@ -121,20 +122,23 @@ public:
         double importance;
     };
     typedef std::set<ImportantNode> ImportantNodeSet;
+    typedef std::vector<ImportantNode> ImportantNodeVector;
 
     // Calculate a set of nodes to load based on importance, but only up to the maximum
     // siblingNodes forces us to load all four children of a given parent
-    ImportantNodeSet calcCoverageImportance(const std::vector<double> &minImportance,int maxNodes,
-                                            bool siblingNodes,std::vector<double> &maxRejectedImport);
+    // The nodes come back unique and sorted, least important first
+    ImportantNodeVector calcCoverageImportance(const std::vector<double> &minImportance,int maxNodes,
+                                               bool siblingNodes,std::vector<double> &maxRejectedImport);
     
     /** Calculate the set of nodes to load based on importance.
         First figure out the highest level we could load.
         Try to load all visible tiles at that level.
         If it's too many, back off a level. Repeat.
+        The nodes come back unique and sorted, least important first.
       */
-    std::tuple<int,ImportantNodeSet> calcCoverageVisible(const std::vector<double> &minImportance,
-                                                         int maxNodes,const std::vector<int> &levelLoads,
-                                                         bool keepMinLevel,std::vector<double> &maxRejectedImport);
+    std::tuple<int,ImportantNodeVector> calcCoverageVisible(const std::vector<double> &minImportance,
+                                                            int maxNodes,const std::vector<int> &levelLoads,
+                                                            bool keepMinLevel,std::vector<double> &maxRejectedImport);
     
     // Generate a bounding box 
     MbrD generateMbrForNode(const Node &node) const;
@@ -144,12 +148,12 @@ public:
     virtual double importance(const Node &node) = 0;
     virtual bool visible(const Node &node) = 0;
     
-    // Recursively visit the quad tree evaluating as we go
+    // Recursively visit the quad tree evaluating as we go.  Nodes are unique, but not sorted.
     void evalNodeImportance(ImportantNode node,const std::vector<double> &minImportance,
-                            ImportantNodeSet &importSet,std::vector<double> &maxRejectedImport);
+                            ImportantNodeVector &importNodes,std::vector<double> &maxRejectedImport);
     // This version uses pure visibility and goes down to a predefined level
     bool evalNodeVisible(ImportantNode node,const std::vector<double> &minImportance,int maxNodes,
-                         const std::set<int> &levelsToLoad,int maxLevel,ImportantNodeSet &visibleSet);
+                         const std::vector<bool> &levelsToLoad,int maxLevel,ImportantNodeVector &visibleNodes);
     
     /// Bounding box
     MbrD mbr;
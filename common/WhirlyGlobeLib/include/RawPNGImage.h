@@ -19,10 +19,78 @@
  */
 
 #import <vector>
+#import <memory>
+#import "RawData.h"
+#import "Texture.h"
+
+struct z_stream_s;
 
 namespace WhirlyKit
 {
 
+/// Output for color PNGs.  Greyscale PNGs always come out as one byte per pixel.
+typedef enum {RawPNGRGBA,RawPNG565,RawPNG4444} RawPNGFormat;
+
+/**
+ Decodes PNG images a row at a time, straight into the output buffer.
+ Greyscale values are remapped as the rows are written and color images can
+ be converted to 16 bit pixels on the way out.  The decompressor and row buffers
+ are kept between images and output buffers are reused once the data that
+ holds them is released.
+
+ Not thread safe.  Use one per thread.
+ */
+class RawPNGDecoder
+{
+public:
+    RawPNGDecoder();
+    ~RawPNGDecoder();
+
+    /// Figure out the size of the image and the bytes per pixel we'll produce
+    bool inspect(const unsigned char *data,size_t length,RawPNGFormat format,
+                 unsigned int &width,unsigned int &height,int &byteWidth,
+                 unsigned int &err);
+
+    /// Decode into a buffer supplied by the caller.  Use inspect to size it.
+    bool decodeInto(const unsigned char *data,size_t length,
+                    const std::vector<int> &valueMap,RawPNGFormat format,
+                    unsigned char *outData,size_t outLen,
+                    unsigned int &err);
+
+    /// Decode into one of our pooled buffers.
+    /// Returns NULL on failure, check the err value.
+    RawDataRef decode(const unsigned char *data,size_t length,
+                      const std::vector<int> &valueMap,RawPNGFormat format,
+                      unsigned int &width,unsigned int &height,int &byteWidth,
+                      unsigned int &err);
+
+protected:
+    class BufferPool;
+
+    // Copy a decoded row to the output, converting as we go
+    void writeRow(const unsigned char *src,int srcChannels,unsigned char *dest,unsigned int width,RawPNGFormat format);
+
+    // Read the next chunk of decompressed data
+    bool inflateBytes(unsigned char *dest,size_t len);
+
+    std::shared_ptr<BufferPool> pool;
+    z_stream_s *stream;
+
+    // Image data chunks for the current image
+    std::vector<std::pair<const unsigned char *,size_t> > idatChunks;
+    size_t nextChunk;
+    bool streamDone;
+
+    // This row and the last one
+    std::vector<unsigned char> rowBuffer;
+
+    // Greyscale value remapping
+    unsigned char valueLookup[256];
+};
+
+/// The decoder output that matches a texture format, so the texture can use it as is
+extern RawPNGFormat RawPNGFormatForTexType(TextureType texType);
+
 /**
  Pulls the raw data out of a PNG image.
  Returns NULL on failure, check the err value.
@@ -33,4 +101,15 @@ extern unsigned char *RawPNGImageLoaderInterpreter(unsigned int &width,unsigned
                                                    int &byteWidth,
                                                    unsigned int &err);
 
+/**
+ Pulls the raw data out of a PNG image into a pooled buffer.
+ Returns NULL on failure, check the err value.
+ */
+extern RawDataRef RawPNGImageLoaderInterpreter(unsigned int &width,unsigned int &height,
+                                               const unsigned char *data,size_t length,
+                                               const std::vector<int> &valueMap,
+                                               RawPNGFormat format,
+                                               int &byteWidth,
+                                               unsigned int &err);
+
 }
@@ -20,13 +20,18 @@
 
 #import <vector>
 #import <set>
+#import <deque>
+#import <atomic>
 #import <unordered_map>
+#import <unordered_set>
+#import <typeindex>
 #import "WhirlyVector.h"
 #import "Texture.h"
 #import "Program.h"
 #import "BasicDrawableInstance.h"
 #import "ActiveModel.h"
 #import "CoordSystem.h"
+#import "PerformanceTrace.h"
 
 namespace WhirlyKit
 {
@@ -193,6 +198,21 @@ protected:
     BlockFunc func;
 };
 
+/// Ends an async trace event when the change is executed.
+/// Put this after the changes it's tracking to include their time in the queue.
+class TraceAsyncEndReq : public ChangeRequest
+{
+public:
+    TraceAsyncEndReq(TraceNameID name,int64_t asyncID) : name(name), asyncID(asyncID) { }
+
+    /// Record the end
+    void execute(Scene *scene,SceneRenderer *renderer,View *view);
+
+protected:
+    TraceNameID name;
+    int64_t asyncID;
+};
+
 /// Set the zoom slot to a given zoom value
 class SetZoomSlotReq : public ChangeRequest
 {
@@ -276,6 +296,14 @@ public:
     
     /// True if there are pending updates
     bool hasChanges(TimeInterval now) const;
+
+    /// Limit the time (in seconds) spent executing change requests in a single frame.
+    /// Anything that doesn't fit is left, in order, for the next frame.
+    /// At least one request runs per frame.  0 (the default) means no limit.
+    void setChangeBudget(TimeInterval budget);
+
+    /// Return the per-frame change execution budget
+    TimeInterval getChangeBudget() const;
     
     /// Add sub texture mappings.
     /// These are mappings from images to parts of texture atlases.
@@ -355,6 +383,17 @@ public:
     
     // Return all the drawables in a list.  Only call this on the main thread.
     std::vector<Drawable *> getDrawables() const;
+
+    /// Return the drawables that might be on for this frame, sorted by draw priority and then ID.
+    /// Drawables with the same height and zoom ranges are culled together.  The ones with a geographic
+    ///  MBR are also checked against the view frustum for each of the model/view/projection matrices.
+    /// Adds and removes since the last call are merged in here.  Only call this on the main thread.
+    void getSortedDrawables(const RendererFrameInfo *frameInfo,const std::vector<Eigen::Matrix4d> &mvpMats,
+                            std::vector<Drawable *> &retDraws);
+
+    /// Call this after changing a drawable's priority or visible range in place, so we re-sort and re-cull it.
+    /// Drawable change requests do this for you.
+    void updateDrawable(Drawable *draw);
     
     // Used for offline frame by frame rendering
     void setCurrentTime(TimeInterval newTime);
@@ -445,6 +484,44 @@ protected:
     /// All the drawables we've been handed, sorted by ID
     mutable std::mutex drawablesLock;
     DrawableRefSet drawables;
+
+    /// Entry in the draw order, with a bounding sphere in display space if we can cull it by itself
+    struct DrawOrderEntry
+    {
+        unsigned int priority;
+        SimpleIdentity drawID;
+        Drawable *draw;
+        Point3d center;
+        double radius;  // Negative if we don't know where it is
+
+        bool operator < (const DrawOrderEntry &that) const
+        {
+            return (priority == that.priority) ? (drawID < that.drawID) : (priority < that.priority);
+        }
+    };
+
+    /// Drawables that share a visible range, sorted by priority and ID.  They're culled together.
+    struct DrawCullNode
+    {
+        std::vector<DrawOrderEntry> entries;
+    };
+
+    /// Cull nodes by visible range, and which one each drawable is in.  Protected by drawablesLock.
+    std::map<DrawableVisibleRange,DrawCullNode> drawCullNodes;
+    std::unordered_map<const Drawable *,DrawCullNode *> drawCullNodeOf;
+
+    /// Draw order changes since the last frame, merged in all at once.  Protected by drawablesLock.
+    /// Removes go by pointer, so we never look at a drawable once it's gone.
+    std::unordered_set<Drawable *> drawOrderAdds;
+    std::unordered_set<const Drawable *> drawOrderRemoves;
+
+    // Queue a drawable to be added to or removed from the draw order.  Caller holds drawablesLock.
+    void addToDrawOrder(Drawable *draw);
+    void removeFromDrawOrder(Drawable *draw);
+    // Merge the queued changes into the cull nodes.  Caller holds drawablesLock.
+    void mergeDrawOrder();
+    // Drop the draw order along with the drawables, on teardown
+    void clearDrawOrder();
     
     typedef std::unordered_map<SimpleIdentity,TextureBaseRef> TextureRefSet;
     /// Textures, sorted by ID
@@ -453,11 +530,52 @@ protected:
     /// Mutex for accessing textures
     mutable std::mutex textureLock;
 
+    /// A change request along with the order and time it was added
+    struct QueuedChange
+    {
+        ChangeRequest *change;
+        uint64_t seq;
+        TimeInterval queuedAt;
+    };
+
+    /// Change requests are staged in one of several shards, picked by thread,
+    ///  so the layer threads aren't all contending on one lock.
+    struct ChangeShard
+    {
+        std::mutex lock;
+        std::vector<QueuedChange> changes;
+    };
+    static const int NumChangeShards = 8;
+    ChangeShard changeShards[NumChangeShards];
+    /// Sequence number for the next change, handed out under a shard lock
+    std::atomic<uint64_t> changeSeq;
+    /// Number of changes sitting in the shards
+    std::atomic<int> numStagedChanges;
+
+    /// Pick the staging shard for the calling thread
+    ChangeShard &shardForThread();
+
+    /// Move staged changes over to the render side, in the order they were added.
+    /// Call with the changeRequestLock held.
+    void drainChangeShards(TimeInterval now);
+
+    /// Protects the render side of the change queue
     mutable std::mutex changeRequestLock;
-    /// We keep a list of change requests to execute
-    /// This can be accessed in multiple threads, so we lock it
-    ChangeSet changeRequests;
-    SortedChangeSet timedChangeRequests;
+    /// Change requests ready to execute, in order
+    std::deque<QueuedChange> changeRequests;
+    /// Drained from the shards, but waiting on earlier changes that haven't landed yet
+    std::vector<QueuedChange> heldChangeRequests;
+    /// Changes to run at a given time, kept as a min heap on when
+    std::vector<ChangeRequest *> timedChangeRequests;
+    /// Scratch space for draining the shards
+    std::vector<QueuedChange> drainedChangeRequests;
+    /// Time budget for executing changes per frame, set from any thread
+    std::atomic<TimeInterval> changeBudget;
+    /// Perf timer names for the change request types we've run, only used on the render thread
+    std::unordered_map<std::type_index,std::string> changeNames;
+
+    /// Readable perf timer name for the change's type, worked out once per type
+    const std::string &getChangeName(const ChangeRequest *change);
 
         mutable std::mutex subTexLock;
     typedef std::set<SubTexture> SubTextureSet;
@@ -104,6 +104,11 @@ public:
     std::vector<DirectionalLight> *lights;
     /// Program being used for this frame
     Program *program;
+    /// Zoom slot values captured for this frame, if set (MaplyMaxZoomSlots entries)
+    const float *zoomSlots;
+
+    /// Look up a zoom slot from the per-frame copy, falling back to the scene
+    float getZoomSlotValue(int zoomSlot) const;
 };
 
 /** We support three different ways of using z buffer.  (1) Regular mode where it's on.
@@ -182,6 +187,23 @@ protected:
 };
 typedef std::shared_ptr<WorkGroup> WorkGroupRef;
 
+/// A drawable in the draw list, along with the offset matrix to draw it with
+template<typename DrawableType>
+struct DrawListEntry
+{
+    DrawListEntry(DrawableType *drawable,unsigned int offset) : drawable(drawable), offset(offset) { }
+
+    DrawableType *drawable;
+    unsigned int offset;
+};
+
+/// Transforms for each of a frame's offset matrices (only one if we're not wrapping)
+struct OffsetTransforms
+{
+    std::vector<Eigen::Matrix4d> mvpMats,mvMats;
+    std::vector<Eigen::Matrix4f> mvpMats4f,mvpInvMats4f,mvMats4f,mvNormalMats4f;
+};
+
 /// Base class for the scene renderer.
 /// It's subclassed for the specific version of OpenGL ES
 class SceneRenderer : public DelayedDeletable
@@ -193,7 +215,7 @@ public:
     virtual ~SceneRenderer();
     
     /// Renderer type.  Back down to one on iOS.
-    typedef enum {RenderGLES,RenderMetal} Type;
+    typedef enum {RenderGLES,RenderMetal,RenderNull} Type;
     virtual Type getType() = 0;
     
     /// Set the render until time.  This is used by things like fade to keep
@@ -300,6 +322,15 @@ public:
     
     /// Return the render setup info for the appropriate rendering type
     virtual const RenderSetupInfo *getRenderSetupInfo() const = 0;
+
+    /// True if we can draw with 32 bit indices, so drawables can have more than 2^16 vertices
+    virtual bool hasWideIndices() const { return false; }
+
+    /// Maximum number of points the builders should put in a drawable before starting another
+    unsigned int getMaxDrawablePoints() const { return hasWideIndices() ? MaxWideDrawablePoints : MaxDrawablePoints; }
+
+    /// Maximum number of triangles the builders should put in a drawable before starting another
+    unsigned int getMaxDrawableTriangles() const { return hasWideIndices() ? MaxWideDrawableTriangles : MaxDrawableTriangles; }
     
     /// Construct a basic drawable builder for the appropriate rendering type
     virtual BasicDrawableBuilderRef makeBasicDrawableBuilder(const std::string &name) const = 0;
@@ -415,8 +446,73 @@ public:
     
     // Map Name IDs to slots (when using Metal)
     std::map<SimpleIdentity,int> slotMap;
+
+protected:
+    /// Fill in the matrices, eye position and such from the view at the start of a frame
+    void setupFrameInfo(RendererFrameInfo &frameInfo,TimeInterval duration,TimeInterval now);
+
+    /// Work out the transforms for each of the frame info's offset matrices
+    void calcOffsetTransforms(const RendererFrameInfo &frameInfo);
+
+    /// Set the frame info's transforms for a drawable drawn with the given offset matrix.
+    /// Call calcOffsetTransforms first.
+    void setDrawTransforms(RendererFrameInfo &frameInfo,const Drawable *drawable,unsigned int offset) const;
+
+    /// Collect the scene's drawables of the given type that are on for this frame and put them in draw order,
+    ///  once for each offset matrix.  The scene keeps them sorted by priority and culls what it can,
+    ///  so we just filter the rest.  Call calcOffsetTransforms first.
+    /// With the z buffer off by default, the ones that want it go last within their priority.
+    template<typename DrawableType>
+    void buildDrawList(RendererFrameInfo *frameInfo,std::vector<DrawableType *> &visibleDrawables,
+                       std::vector<DrawListEntry<DrawableType>> &drawList);
+
+    // Transforms for this frame's offset matrices
+    OffsetTransforms offsetTransforms;
+
+    // Scratch space for building the draw list, reused between frames
+    std::vector<Drawable *> sortedDrawables;
 };
 
+template<typename DrawableType>
+void SceneRenderer::buildDrawList(RendererFrameInfo *frameInfo,std::vector<DrawableType *> &visibleDrawables,
+                                  std::vector<DrawListEntry<DrawableType>> &drawList)
+{
+    scene->getSortedDrawables(frameInfo,offsetTransforms.mvpMats,sortedDrawables);
+    visibleDrawables.clear();
+    for (auto *draw : sortedDrawables)
+    {
+        auto *theDrawable = dynamic_cast<DrawableType *>(draw);
+        if (theDrawable && theDrawable->isOn(frameInfo))
+            visibleDrawables.push_back(theDrawable);
+    }
+
+    const unsigned int numOffsets = frameInfo->offsetMatrices.size();
+    const bool sortLinesToEnd = (zBufferMode == zBufferOffDefault);
+    drawList.clear();
+    drawList.reserve(visibleDrawables.size() * numOffsets);
+    for (size_t start=0;start<visibleDrawables.size();)
+    {
+        const unsigned int drawPriority = visibleDrawables[start]->getDrawPriority();
+        size_t end = start+1;
+        while (end < visibleDrawables.size() && visibleDrawables[end]->getDrawPriority() == drawPriority)
+            end++;
+
+        for (int pass=0;pass<(sortLinesToEnd ? 2 : 1);pass++)
+        {
+            for (size_t ii=start;ii<end;ii++)
+            {
+                DrawableType *theDrawable = visibleDrawables[ii];
+                if (sortLinesToEnd && theDrawable->getRequestZBuffer() != (pass == 1))
+                    continue;
+                for (unsigned int off=0;off<numOffsets;off++)
+                    drawList.emplace_back(theDrawable,off);
+            }
+        }
+
+        start = end;
+    }
+}
+
 typedef std::shared_ptr<SceneRenderer> SceneRendererRef;
     
 }
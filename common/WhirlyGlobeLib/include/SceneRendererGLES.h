@@ -32,6 +32,7 @@
 namespace WhirlyKit
 {
 class SceneRendererGLES;
+class DrawableGLES;
 
 /** Renderer Frame Info.
  Data about the current frame, passed around by the renderer.
@@ -74,6 +75,9 @@ public:
 
     // Various information about the renderer passed around to call
     virtual const RenderSetupInfo *getRenderSetupInfo() const;
+
+    /// OpenGL ES 3 has 32 bit indices
+    virtual bool hasWideIndices() const override { return setupInfo.glesVersion >= 3; }
     
     virtual void setView(View *newView);
     virtual void setScene(Scene *newScene);
@@ -136,6 +140,10 @@ public:
     // If set we draw one extra frame after updates stop
     bool extraFrameMode;
     int extraFrameCount;
+
+    // Scratch space for building the draw list, reused between frames
+    std::vector<DrawableGLES *> visibleDrawables;
+    std::vector<DrawListEntry<DrawableGLES>> drawList;
 };
     
 typedef std::shared_ptr<SceneRendererGLES> SceneRendererGLESRef;
@@ -0,0 +1,156 @@
+/*
+ *  SceneRendererNull.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <atomic>
+#import "WhirlyVector.h"
+#import "WhirlyKitView.h"
+#import "Scene.h"
+#import "SceneRenderer.h"
+#import "DrawableNull.h"
+
+namespace WhirlyKit
+{
+
+/** Setup info for the null renderer.
+    Drawables and textures report the GPU memory they would have used here.
+    They may do that from any thread.
+ */
+class RenderSetupInfoNull : public RenderSetupInfo
+{
+public:
+    RenderSetupInfoNull();
+
+    void addBuffer(size_t size) { numBuffers++;  bufferBytes += size; }
+    void removeBuffer(size_t size) { numBuffers--;  bufferBytes -= size; }
+    void addTexture(size_t size,size_t uploaded) { numTextures++;  textureBytes += size;  uploadBytes += uploaded; }
+    void removeTexture(size_t size) { numTextures--;  textureBytes -= size; }
+    void addUpload(size_t size) { uploadBytes += size; }
+
+    /// Set if we're acting like a renderer with 32 bit indices
+    bool wideIndices;
+
+    /// Buffers and textures currently live
+    std::atomic<int64_t> numBuffers,bufferBytes;
+    std::atomic<int64_t> numTextures,textureBytes;
+    /// Total texture data handed over, including dynamic texture updates
+    std::atomic<int64_t> uploadBytes;
+};
+
+class WorkGroupNull : public WorkGroup
+{
+public:
+    WorkGroupNull(GroupType groupType);
+    virtual RenderTargetContainerRef makeRenderTargetContainer(RenderTargetRef) override;
+};
+
+class RenderTargetContainerNull : public RenderTargetContainer
+{
+public:
+    RenderTargetContainerNull(RenderTargetRef renderTarget) : RenderTargetContainer(renderTarget) { }
+};
+
+/** Scene for the null renderer.
+    Just tears down the CPU side objects.
+  */
+class SceneNull : public Scene
+{
+public:
+    SceneNull(CoordSystemDisplayAdapter *adapter);
+
+    /// Tear everything down
+    virtual void teardown(PlatformThreadInfo*) override;
+};
+
+/** Headless scene renderer.
+    This produces drawables, textures and render targets that live entirely on the CPU
+    and record what they would have sent to the GPU.  The frame loop is the same as the
+    OpenGL ES one (change processing, active models, visibility checks, sorting and
+    tweakers) without any of the drawing.  It's meant for profiling and benchmarks
+    on machines without a GPU.
+ */
+class SceneRendererNull : public SceneRenderer
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+    SceneRendererNull();
+    virtual ~SceneRendererNull();
+
+    virtual Type getType() override;
+
+    // Where the drawables and textures keep their counts
+    virtual const RenderSetupInfo *getRenderSetupInfo() const override;
+
+    /// Act like OpenGL ES 3 unless told otherwise
+    virtual bool hasWideIndices() const override { return setupInfo.wideIndices; }
+
+    /// Called right after the constructor
+    virtual bool setup(int sizeX,int sizeY,float scale,bool wideIndices = true);
+
+    /// Resize the pretend framebuffer
+    virtual bool resize(int sizeX,int sizeY);
+
+    /// Run a frame without drawing anything
+    void render(TimeInterval period);
+
+    /// What we would have drawn in the last frame
+    const FrameStatsNull &getFrameStats() const { return frameStats; }
+
+    /// Buffer and texture totals so far
+    const RenderSetupInfoNull &getSetupInfo() const { return setupInfo; }
+
+    /// Construct a basic drawable builder for the appropriate rendering type
+    virtual BasicDrawableBuilderRef makeBasicDrawableBuilder(const std::string &name) const override;
+
+    /// Construct a basic drawables instance builder for the current rendering type
+    virtual BasicDrawableInstanceBuilderRef makeBasicDrawableInstanceBuilder(const std::string &name) const override;
+
+    /// Construct a billboard drawable builder for the current rendering type
+    virtual BillboardDrawableBuilderRef makeBillboardDrawableBuilder(const std::string &name) const override;
+
+    /// Construct a screen-space drawable builder for the current rendering type
+    virtual ScreenSpaceDrawableBuilderRef makeScreenSpaceDrawableBuilder(const std::string &name) const override;
+
+    /// Construct a particle system builder of the appropriate rendering type
+    virtual ParticleSystemDrawableBuilderRef makeParticleSystemDrawableBuilder(const std::string &name) const override;
+
+    /// Construct a wide vector drawable builder of the appropriate rendering type
+    virtual WideVectorDrawableBuilderRef makeWideVectorDrawableBuilder(const std::string &name) const override;
+
+    /// Construct a renderer-specific render target
+    virtual RenderTargetRef makeRenderTarget() const override;
+
+    /// Construct a renderer-specific dynamic texture
+    virtual DynamicTextureRef makeDynamicTexture(const std::string &name) const override;
+
+protected:
+    // Counts for the drawables and textures
+    RenderSetupInfoNull setupInfo;
+
+    // What we drew last frame
+    FrameStatsNull frameStats;
+
+    // Scratch space for building the draw list, reused between frames
+    std::vector<DrawableNull *> visibleDrawables;
+    std::vector<DrawListEntry<DrawableNull>> drawList;
+};
+
+typedef std::shared_ptr<SceneRendererNull> SceneRendererNullRef;
+
+}
@@ -21,6 +21,8 @@
 #import <math.h>
 #import <set>
 #import <map>
+#import <unordered_map>
+#import <unordered_set>
 #import "Identifiable.h"
 #import "WhirlyGeometry.h"
 #import "WhirlyKitView.h"
@@ -177,7 +179,64 @@ public:
 };
   
 typedef std::set<WhirlyKit::BillboardSelectable> BillboardSelectableSet;
-    
+
+/** Bounding volume hierarchy over the display space extents of selectables.
+    The selection manager keeps one of these per type of 3D selectable so a
+    pick only has to project the objects whose bounds land near the touch.
+
+    Additions go into a pending list and removals are tombstoned.  The tree
+    is rebuilt lazily at query time once either gets too big.
+    Not thread safe, the selection manager's lock covers it.
+  */
+class SelectionSpatialIndex
+{
+public:
+    SelectionSpatialIndex();
+
+    /// Add an object with the given bounds in display space
+    void addSelectable(SimpleIdentity selectID,const Point3d &ll,const Point3d &ur);
+
+    /// Add an object bounded by the given display space points
+    void addSelectable(SimpleIdentity selectID,const Point3d *pts,unsigned int numPts);
+
+    /// Remove the given object, if it's in here
+    void removeSelectable(SimpleIdentity selectID);
+
+    /// Number of live objects
+    size_t size() const { return liveIDs.size() + pending.size(); }
+
+    /// Return the IDs of anything whose projected bounds fall within maxDist of the touch point.
+    /// This is conservative.  The caller still needs to do a proper test on each one.
+    void findCandidates(const Point2f &touchPt,float maxDist,const ViewState *viewState,
+                        const Point2f &frameSize,std::vector<SimpleIdentity> &selectIDs);
+
+protected:
+    struct Entry
+    {
+        Point3d ll,ur;
+        SimpleIdentity selectID;
+    };
+    struct Node
+    {
+        Point3d ll,ur;
+        int start,count;  // Range of entries, for leaves
+        int right;        // Right child (left is the next node), -1 for leaves
+    };
+
+    // Rebuild the whole tree from the live entries
+    void rebuild();
+    // Recursive helper for the tree build
+    int buildNode(int start,int count);
+    // Project the corners of a box to see if it's near the touch point
+    bool boxNearTouch(const Point3d &ll,const Point3d &ur,const Point2f &touchPt,float maxDist,
+                      const std::vector<Eigen::Matrix4d> &mats,const Point2f &frameSize) const;
+
+    std::vector<Entry> entries;   // In tree order
+    std::vector<Node> nodes;
+    std::unordered_set<SimpleIdentity> liveIDs;    // IDs in the tree that haven't been removed
+    std::unordered_map<SimpleIdentity,Entry> pending;   // Added since the last rebuild
+};
+
 #define kWKSelectionManager "WKSelectionManager"
     
 /** The selection manager tracks a variable number of objects that
@@ -290,6 +349,10 @@ public:
     
     /// Find all the objects within a given distance and return them, sorted by distance
     void pickObjects(Point2f touchPt,float maxDist,ViewStateRef viewState,std::vector<SelectedObject> &selObjs);
+
+    /// Use the spatial indices to narrow down the 3D selectables when picking.  On by default.
+    /// With this off every selectable is checked, which is mostly useful for comparison.
+    void setUseSpatialIndex(bool newVal);
     
     // Everything we need to project a world coordinate to one or more screen locations
     class PlacementInfo
@@ -327,6 +390,13 @@ protected:
     WhirlyKit::MovingPolytopeSelectableSet movingPolytopeSelectables;
     WhirlyKit::LinearSelectableSet linearSelectables;
     WhirlyKit::BillboardSelectableSet billboardSelectables;
+
+    /// Spatial indices over the static 3D selectables
+    SelectionSpatialIndex rect3DIndex;
+    SelectionSpatialIndex polytopeIndex;
+    SelectionSpatialIndex linearIndex;
+    SelectionSpatialIndex billboardIndex;
+    bool useSpatialIndex;
 };
 typedef std::shared_ptr<SelectionManager> SelectionManagerRef;
  
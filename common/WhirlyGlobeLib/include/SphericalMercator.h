@@ -43,13 +43,16 @@ public:
     virtual Point3f geographicToLocal(GeoCoord) const override;
     virtual Point3d geographicToLocal3d(GeoCoord) const override;
     virtual Point3d geographicToLocal(Point2d) const override;
+    virtual void geographicToLocal(const Point2d *geo,Point3d *local,size_t count) const override;
     
     /// Convert from the local coordinate system to geocentric
     virtual Point3f localToGeocentric(Point3f) const override;
     virtual Point3d localToGeocentric(Point3d) const override;
+    virtual void localToGeocentric(const Point3d *local,Point3d *geoc,size_t count) const override;
     /// Convert from display coordinates to geocentric
     virtual Point3f geocentricToLocal(Point3f) const override;
     virtual Point3d geocentricToLocal(Point3d) const override;
+    virtual void geocentricToLocal(const Point3d *geoc,Point3d *local,size_t count) const override;
     
     /// True if the other system is Spherical Mercator with the same origin
     virtual bool isSameAs(CoordSystem *coordSys) const override;
@@ -88,6 +91,7 @@ public:
     /// Convert from the system's local coordinates to display coordinates
     virtual WhirlyKit::Point3f localToDisplay(WhirlyKit::Point3f) const override;
     virtual WhirlyKit::Point3d localToDisplay(WhirlyKit::Point3d) const override;
+    virtual void localToDisplay(const Point3d *local,Point3d *disp,size_t count) const override;
     
     /// Convert from display coordinates to the local system's coordinates
     virtual WhirlyKit::Point3f displayToLocal(WhirlyKit::Point3f) const override;
@@ -96,6 +100,7 @@ public:
     /// For flat systems the normal is Z up.  For the globe, it's based on the location.
     virtual Point3f normalForLocal(Point3f) const override { return Point3f(0,0,1); }
     virtual Point3d normalForLocal(Point3d) const override { return Point3d(0,0,1); }
+    virtual void normalForLocal(const Point3d *local,Point3d *norms,size_t count) const override;
 
     /// Get a reference to the coordinate system
     virtual CoordSystem *getCoordSystem() const override {
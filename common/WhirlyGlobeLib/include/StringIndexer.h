@@ -22,6 +22,9 @@
 #import <unordered_map>
 #import <string>
 #import <mutex>
+#import <atomic>
+#import <memory>
+#import <string_view>
 
 namespace WhirlyKit
 {
@@ -98,12 +101,18 @@ extern StringIdentity a_modelDirNameID;
  than a string in certain high performance unordered maps and such.
  
  Only adds strings.  Never removes them.
+ Looking up a string that's already there doesn't take a lock.
  */
 class StringIndexer
 {
 public:
     // Return or make up a string identity
-    static StringIdentity getStringID(const std::string &);
+    static StringIdentity getStringID(std::string_view);
+    static StringIdentity getStringID(const std::string &str) { return getStringID(std::string_view(str)); }
+    static StringIdentity getStringID(const char *str) { return getStringID(std::string_view(str)); }
+
+    // Look up a string identity without adding it.  Returns false if we've never seen the string.
+    static bool findStringID(std::string_view,StringIdentity &strID);
     
     // Return the string for a string identity
     static std::string getString(StringIdentity);
@@ -114,10 +123,42 @@ protected:
     void operator=(StringIndexer const&)    = delete;
 
     static StringIndexer &getInstance() { return instance; }
-    
+
+    // A string we've indexed.  These are never moved or deleted.
+    struct Entry
+    {
+        Entry(std::string_view str,size_t hash,StringIdentity strID) : str(str), hash(hash), strID(strID) { }
+
+        const std::string str;
+        const size_t hash;
+        const StringIdentity strID;
+    };
+
+    // Open addressed hash table of entries.  Readers only ever see a table that's
+    //  filled in, so they don't need the lock.  We make a bigger one when it fills up.
+    struct Table
+    {
+        explicit Table(size_t size);
+
+        // Look for the string, returning null if it's not there
+        const Entry *find(std::string_view str,size_t hash) const;
+
+        // Add the entry.  Caller has the lock.
+        void insert(const Entry *entry);
+
+        const size_t mask;
+        std::unique_ptr<std::atomic<const Entry *>[]> slots;
+    };
+
+    // Add the string if it's not there.  Takes the lock.
+    const Entry *addString(std::string_view str,size_t hash);
+
+    std::atomic<const Table *> table;
+
+    // Everything below is protected by the mutex
     mutable std::mutex mutex;
-    std::unordered_map<std::string,StringIdentity> stringToIdent;
-    std::vector<std::string> identToString;
+    std::vector<std::unique_ptr<const Table> > tables;
+    std::vector<std::unique_ptr<const Entry> > identToString;
 
 private:
     static StringIndexer instance;
@@ -25,8 +25,70 @@
 namespace WhirlyKit
 {
 
-/** Tesselate the given ring, returning a list of triangles.
-    This is a fairly simple tesselator. */
+/// Tesselators TesselateRing and TesselateLoops can use
+typedef enum {TesselatorGLU,TesselatorEarcut} TesselatorType;
+
+/** Pick the tesselator used by TesselateRing and TesselateLoops.
+    Ear clipping is the default.  It hands anything self intersecting,
+    or that it can't cover properly, over to GLU.
+  */
+void SetTesselatorType(TesselatorType type);
+TesselatorType GetTesselatorType();
+
+/** Ear clipping tesselator with hole bridging.
+    Works on flat coordinate arrays and keeps its scratch memory between calls,
+    so reuse one per thread.  Z-order hashing kicks in for bigger polygons.
+  */
+class EarcutTesselator
+{
+public:
+    EarcutTesselator();
+    ~EarcutTesselator();
+
+    /** Tesselate the polygon in coords (x,y pairs).  The outer ring starts at
+        vertex 0 and each hole starts at the given vertex index.  Rings are not
+        closed.  Triangle vertex indices are appended to tris.
+      */
+    void tesselate(const double *coords,unsigned int numVerts,
+                   const std::vector<unsigned int> &holeStarts,
+                   std::vector<unsigned int> &tris);
+
+    /// Vertex in the linked lists we clip ears from
+    struct Node;
+
+protected:
+
+    Node *newNode(unsigned int i,double x,double y);
+    Node *linkedList(unsigned int start,unsigned int end,bool clockwise);
+    Node *filterPoints(Node *start,Node *end = nullptr);
+    void earcutLinked(Node *ear,int pass = 0);
+    bool isEar(Node *ear);
+    bool isEarHashed(Node *ear);
+    Node *cureLocalIntersections(Node *start);
+    void splitEarcut(Node *start);
+    Node *eliminateHoles(const std::vector<unsigned int> &holeStarts,Node *outerNode);
+    Node *eliminateHole(Node *hole,Node *outerNode);
+    Node *findHoleBridge(Node *hole,Node *outerNode);
+    Node *splitPolygon(Node *a,Node *b);
+    void indexCurve(Node *start);
+    int32_t zOrder(double x,double y) const;
+
+    const double *coords;
+    unsigned int numVerts;
+    std::vector<unsigned int> *tris;
+
+    // Nodes are handed out of blocks that stick around between calls
+    std::vector<Node *> blocks;
+    unsigned int nodesUsed;
+
+    // Scratch for hole processing
+    std::vector<Node *> holeQueue;
+
+    bool hashing;
+    double minX,minY,invSize;
+};
+
+/** Tesselate the given ring, returning a list of triangles. */
 void TesselateRing(const WhirlyKit::VectorRing &ring,VectorTrianglesRef tris);
 
 /** Tesselate the given areal feature.  The first ring is the outer,
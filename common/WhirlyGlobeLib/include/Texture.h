@@ -113,6 +113,8 @@ public:
     void setSingleByteSource(WKSingleByteSource source) { byteSource = source; }
     /// If set, this is a texture we're creating for output purposes
     void setIsEmptyTexture(bool inIsEmptyTexture) { isEmptyTexture = inIsEmptyTexture; }
+    /// Set if the raw data is already laid out in the texture format and needs no conversion
+    void setDataInFormat(bool inDataInFormat) { dataInFormat = inDataInFormat; }
 
     /// Raw texture data
     RawDataRef texData;
@@ -125,6 +127,8 @@ protected:
 	bool isPVRTC;
     /// This one has a header
     bool isPKM;
+    /// Data was produced in the texture format already
+    bool dataInFormat;
     /// If we're converting down to one byte, where do we get it?
     WKSingleByteSource byteSource;
 	
@@ -142,5 +146,13 @@ typedef std::shared_ptr<Texture> TextureRef;
 
 // Pull two 8 byte channels out of an RGBA image
 extern RawDataRef ConvertRGBATo16(RawDataRef inData,int width,int height,bool pad);
+
+// Convert RGBA pixels to 16 bit pixels in a buffer supplied by the caller.
+// These use NEON or SSE2 where available.
+extern void ConvertRGBATo565(const uint32_t *inPixels,uint16_t *outPixels,size_t pixelCount);
+extern void ConvertRGBATo4444(const uint32_t *inPixels,uint16_t *outPixels,size_t pixelCount);
+extern void ConvertRGBATo5551(const uint32_t *inPixels,uint16_t *outPixels,size_t pixelCount);
+// Just the red and green channels, a byte each
+extern void ConvertRGBAToRG(const uint32_t *inPixels,uint16_t *outPixels,size_t pixelCount);
     
 }
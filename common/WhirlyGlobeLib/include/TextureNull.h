@@ -0,0 +1,126 @@
+/*
+ *  TextureNull.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "Texture.h"
+#import "DynamicTextureAtlas.h"
+#import "RenderTarget.h"
+#import "Program.h"
+
+namespace WhirlyKit
+{
+
+/// Bytes per texel for the given format, as the GPU would store it
+int TextureTypeBytesPerPixel(TextureType type);
+
+/** Null renderer version of the Texture.
+    We do the same data conversion the GL version does, record the size and drop the data.
+ */
+class TextureNull : virtual public Texture
+{
+public:
+    TextureNull(const std::string &name);
+    TextureNull(const std::string &name,RawDataRef texData,bool isPVRTC);
+
+    /// Convert the data and record the texture we'd have made
+    virtual bool createInRenderer(const RenderSetupInfo *setupInfo) override;
+
+    /// Give back the texture memory we recorded
+    virtual void destroyInRenderer(const RenderSetupInfo *setupInfo,Scene *scene) override;
+
+    /// Memory the texture would take up on the GPU
+    size_t getTexSize() const { return texSize; }
+
+protected:
+    bool isSetup;
+    size_t texSize;
+};
+typedef std::shared_ptr<TextureNull> TextureNullRef;
+
+/// Null renderer version of the dynamic texture.  Counts the texture and the updates to it.
+class DynamicTextureNull : virtual public DynamicTexture
+{
+public:
+    DynamicTextureNull(const std::string &name);
+
+    /// Record the empty texture we'd have made
+    virtual bool createInRenderer(const RenderSetupInfo *setupInfo) override;
+
+    /// Give back the texture memory
+    virtual void destroyInRenderer(const RenderSetupInfo *setupInfo,Scene *scene) override;
+
+    /// Count the bytes we'd have uploaded
+    virtual void addTextureData(int startX,int startY,int width,int height,RawDataRef data) override;
+
+    /// Nothing to clear
+    virtual void clearTextureData(int startX,int startY,int width,int height,ChangeSet &changes,bool mainThreadMerge,unsigned char *emptyData) override;
+
+protected:
+    const RenderSetupInfo *setupInfo;
+    size_t texBytes;
+};
+
+/// Null renderer render target.  Just keeps track of its size and texture.
+class RenderTargetNull : public RenderTarget
+{
+public:
+    RenderTargetNull();
+    RenderTargetNull(SimpleIdentity newID);
+
+    /// Set up the render target
+    virtual bool init(SceneRenderer *renderer,Scene *scene,SimpleIdentity targetTexID) override;
+
+    /// Pick up the size of the target texture
+    virtual bool setTargetTexture(SceneRenderer *renderer,Scene *scene,SimpleIdentity newTargetTexID) override;
+
+    virtual void setClearColor(const RGBAColor &color) override;
+
+    /// Nothing to clean up
+    virtual void clear() override;
+
+    /// Texture we're rendering to, if any
+    SimpleIdentity targetTexID;
+
+protected:
+    using RenderTarget::init;
+};
+typedef std::shared_ptr<RenderTargetNull> RenderTargetNullRef;
+
+/** Null renderer shader program.
+    Add these to the scene under the usual shader names so the managers can find them.
+ */
+class ProgramNull : public Program
+{
+public:
+    ProgramNull(const std::string &name,bool lights = false);
+
+    virtual bool isValid() const override { return true; }
+    virtual bool hasLights() const override { return lights; }
+
+    /// Nothing to bind the texture to
+    virtual bool setTexture(StringIdentity nameID,TextureBase *tex,int textureSlot) override { return true; }
+    virtual void clearTexture(SimpleIdentity texID) override { }
+
+    virtual void teardownForRenderer(const RenderSetupInfo *setupInfo,Scene *scene,RenderTeardownInfoRef teardown) override { }
+
+protected:
+    bool lights;
+};
+typedef std::shared_ptr<ProgramNull> ProgramNullRef;
+
+}
@@ -0,0 +1,142 @@
+/*
+ *  TileCache.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <string>
+#import <vector>
+#import <map>
+#import <mutex>
+#import <memory>
+#import "RawData.h"
+#import "QuadTreeNew.h"
+
+namespace WhirlyKit
+{
+
+/**
+ Persistent cache of tile data on disk.
+
+ Tile data is appended to pack files and located through a hash index, keyed by
+ tile and source, that's memory mapped.  Hits come back as views directly on the
+ mapped pack files, so there's no copying.
+
+ When the cache gets too big we drop the oldest pack, after copying over anything
+ in it that's been used since it was written.  The index is rebuilt from the pack
+ files if it wasn't closed cleanly.
+
+ All methods are thread safe.
+
+ The remote tile fetchers check it before going to the network and put what comes back,
+ for the tile sources that give themselves a cache source name.
+ */
+class TileCache
+{
+public:
+    /// Construct with the directory to keep the cache in, the size to stay under
+    ///  and the size of the individual pack files
+    TileCache(const std::string &dir,size_t maxBytes,size_t packBytes = 16*1024*1024);
+    virtual ~TileCache();
+
+    /// Open or create the cache.  Returns false on failure.
+    bool open();
+
+    /// Write everything out and close the files
+    void close();
+
+    /// Look for the data for a tile from a given source.  Returns null if it's not there.
+    RawDataRef getTile(const QuadTreeIdentifier &ident,const std::string &source);
+
+    /// Add the data for a tile from a given source, replacing whatever was there
+    bool putTile(const QuadTreeIdentifier &ident,const std::string &source,const RawData &data);
+
+    /// Forget about a single tile.  This is recorded in the pack files too, so it sticks if the index is rebuilt.
+    void removeTile(const QuadTreeIdentifier &ident,const std::string &source);
+
+    /// Drop old pack files until we're under the size limit
+    void compact();
+
+    /// Push the index and the pack files to disk
+    void flush();
+
+    /// Basic usage info
+    class Stats
+    {
+    public:
+        Stats();
+
+        int numTiles;
+        int numPacks;
+        size_t totalBytes;
+        long long hits,misses;
+    };
+    Stats getStats();
+
+    /// Pack file we're serving data out of.  Mapped until the last reference goes away.
+    class Pack;
+    typedef std::shared_ptr<Pack> PackRef;
+
+protected:
+    struct IndexHeader;
+    struct IndexEntry;
+
+    // Hash the source name.  Needs to be the same from run to run.
+    static uint64_t sourceHash(const std::string &source);
+
+    // Set up the index file with the given number of entries
+    bool makeIndex(const std::string &fileName,unsigned int capacity);
+    // Map an existing index file
+    bool mapIndex(const std::string &fileName);
+    void unmapIndex();
+
+    // Where the entry for the given key is or would go
+    IndexEntry *findEntry(int64_t node,uint64_t source,bool forInsert);
+    // Add or replace an entry, growing the index if need be
+    bool setEntry(int64_t node,uint64_t source,uint32_t pack,uint64_t offset,uint32_t length,uint64_t written);
+    // Rehash into a bigger index
+    bool growIndex();
+
+    // Open or create a pack file
+    PackRef openPack(uint32_t packID,bool create);
+    // Start a new pack to write to
+    bool startPack();
+    // Write a record to the active pack
+    bool appendRecord(int64_t node,uint64_t source,const unsigned char *data,uint32_t length,uint32_t flags,uint64_t &offset);
+
+    // Rebuild the index by reading all the pack files
+    bool rebuildIndex();
+
+    // Drop the oldest pack.  Caller holds the lock.
+    bool evictOldestPack();
+
+    std::mutex lock;
+    std::string dir;
+    size_t maxBytes,packBytes;
+
+    int indexFD;
+    size_t indexLen;
+    IndexHeader *header;
+    IndexEntry *entries;
+
+    std::map<uint32_t,PackRef> packs;
+    PackRef activePack;
+
+    long long hits,misses;
+};
+typedef std::shared_ptr<TileCache> TileCacheRef;
+
+}
@@ -324,6 +324,12 @@ bool VectorWriteFile(const std::string &fileName,ShapeSet &shapes);
  */
 bool VectorParseGeoJSON(ShapeSet &shapes,const std::string &str,std::string &crs);
 
+/** Helper routine to parse newline delimited GeoJSON, one Feature or
+ geometry per line.  Chunks of lines are parsed in parallel on up to
+ numThreads threads (0 for one per core).  Return false on parse failure.
+ */
+bool VectorParseGeoJSONLines(ShapeSet &shapes,const std::string &str,int numThreads = 0);
+
 /** Helper routine to parse a GeoJSON assembly into an array of
  collections of vectors.  This format is returned by the experimental
  OSM server for vectors.
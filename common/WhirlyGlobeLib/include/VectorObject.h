@@ -184,6 +184,12 @@ public:
     /// @param json The GeoJSON data as a std::string
     /// @return True on success, false on failure.
     bool fromGeoJSON(const std::string &json,std::string &crs);
+
+    /// @brief Add objects from newline delimited GeoJSON, one feature per line.
+    /// @param json The GeoJSON data as a std::string
+    /// @param numThreads Number of threads to parse on, 0 for one per core
+    /// @return True on success, false on failure.
+    bool fromGeoJSONLines(const std::string &json,int numThreads = 0);
     
     /// @brief Read objects from the given shapefile
     /// @param fileName The filename of the Shapefile
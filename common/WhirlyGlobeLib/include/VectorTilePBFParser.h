@@ -19,27 +19,32 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
-typedef struct pb_istream_s pb_istream_t;
-typedef struct pb_field_iter_s pb_field_iter_t;
-typedef struct _vector_tile_Tile vector_tile_Tile;
-typedef struct _vector_tile_Tile_Feature vector_tile_Tile_Feature;
-typedef struct _vector_tile_Tile_Layer vector_tile_Tile_Layer;
-typedef struct _vector_tile_Tile_Value vector_tile_Tile_Value;
-
 namespace WhirlyKit
 {
 
-class MutableDictionaryC;
+class Dictionary;
+struct FlatAttr;
 class PlatformThreadInfo;
 class VectorTileData;
 class VectorStyleDelegateImpl;
 class VectorObject;
 
-typedef std::shared_ptr<MutableDictionaryC> MutableDictionaryCRef;
 typedef std::shared_ptr<VectorObject> VectorObjectRef;
 
+/**
+ Decodes Mapbox Vector Tiles straight out of the tile bytes.
+ 
+ Layers and features are kept as views into the buffer until we know we want them.
+ Features are run through the uuid filter and the styles before any geometry is
+ decoded or any attribute dictionary is allocated for them.  Scratch buffers are
+ kept per-thread and reused from one tile to the next.
+
+ Attributes for the features we keep are flat records in the tile data's arena.
+ */
 class VectorTilePBFParser
 {
 public:
@@ -92,11 +97,9 @@ public:
     }
 
 private:
-    typedef VectorTilePBFParser This;
-
     typedef std::unordered_set<SimpleIdentity> SimpleIDUSet;
 
-    // This holds a tile value in less space than the one generated by nanopb
+    // This holds a tile value compactly.  Strings point into the tile data.
     struct SmallValue
     {
         enum SmallValueType : int8_t {
@@ -121,67 +124,33 @@ private:
         SmallValueType type;
     };
 
-    struct Feature
-    {
-        uint32_t tagIndex;
-        uint32_t geomIndex;
-        MapnikGeometryType geomType;
-        Feature() : tagIndex(0), geomIndex(0), geomType(GeomTypeUnknown) {}
-        Feature(uint32_t tagIdx, uint32_t geomIdx, MapnikGeometryType gType)
-            : tagIndex(tagIdx), geomIndex(geomIdx), geomType(gType) { }
-    };
+    // Reused between tiles, one per thread
+    struct Scratch;
 
 private:
     static inline int32_t decodeParamInt(int32_t p);
     static inline std::pair<uint8_t, int32_t> decodeCommand(int32_t c);
 
-    // nanopb callbacks
-    static bool layerDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg);
-    static bool featureDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg);
-    static bool stringDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg);
-    static bool stringVecDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg);
-    static bool intVecDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg);
-    static bool valueVecDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg);
-
-    // Wrapped callbacks
-    inline bool layerDecode(pb_istream_t *stream, const pb_field_iter_t *field);
-    inline bool featureDecode(pb_istream_t *stream, const pb_field_iter_t *field);
-
     // Parsing methods
-    inline bool processTags(const MutableDictionaryCRef &attributes, size_t tagIdx, size_t geomIdx, const Feature &feature);
-    inline bool checkStyles(SimpleIDUSet& styleIDs, const MutableDictionaryCRef &attributes, const std::string &layerName);
+    inline bool parseLayer(std::string_view layerData);
+    inline bool parseFeature(std::string_view featureData, MapnikGeometryType &geomType, std::string_view &geomData);
+    inline bool parseValue(std::string_view valueData, std::vector<SmallValue> &values);
+    inline bool decodeGeometry(std::string_view geomData);
+    inline bool checkUUID() const;
+    inline bool processTags(std::vector<FlatAttr> &attrs);
+    inline bool checkStyles(SimpleIDUSet& styleIDs, const Dictionary &attributes, const std::string &layerName);
     inline void parseLineString(const uint32_t *geometry, size_t geomCount, ShapeSet& shapes) const;
     inline bool parsePolygon(const uint32_t *geometry, size_t geomCount, VectorAreal& shape);
     inline bool parsePoints(const uint32_t *geometry, size_t geomCount, VectorPoints& shape);
     inline void addFeature(const VectorObjectRef &vecObj, const SimpleIDUSet &styleIDs);
-    inline void layerElement();
-    inline bool layerStart();
-    inline bool layerFinish();
-
-    static inline int layerKeyHeuristic(int layerBytesLeft) { return 100; }
-    static inline int layerValueHeuristic(int layerBytesLeft) { return 100; }
 
-    // We assume features are mostly geometry
-    static inline int featureHeuristic(int layerBytesLeft) { return layerBytesLeft / 100; }
-    static inline int featureTagHeuristic(int layerBytesLeft) { return layerBytesLeft / 50; }
-    static inline int featureGeometryHeuristic(int layerBytesLeft) { return layerBytesLeft / 10; }
-    static inline int featureStyleHeuristic() { return 50; }
+    static inline size_t featureStyleHeuristic() { return 50; }
 
-private:
-    // Default state of message structures, for easy setup
-    static const vector_tile_Tile_Layer _defaultLayer;
-    static const vector_tile_Tile_Feature _defaultFeature;
-    static const vector_tile_Tile_Value _defaultValue;
-    
 private:
     // Data parsed and collected
     double _layerScale = 0;
-    std::vector<uint32_t> _featureTags;
-    std::vector<uint32_t> _featureGeometry;
-    std::vector<Feature> _features;
-    std::vector<std::string_view> _layerKeys;
-    std::vector<SmallValue> _layerValues;
     std::string _parseError;
+    Scratch *_scratch = nullptr;
 
 private:
     // Data provided by the caller
@@ -16,6 +16,7 @@
  *  limitations under the License.
  */
 
+#import <cstring>
 #import "Program.h"
 #import "BasicDrawable.h"
 #import "BasicDrawableInstance.h"
@@ -32,13 +33,29 @@ BasicDrawable::Triangle::Triangle()
 {
 }
 
-BasicDrawable::Triangle::Triangle(unsigned short v0,unsigned short v1,unsigned short v2)
+BasicDrawable::Triangle::Triangle(unsigned int v0,unsigned int v1,unsigned int v2)
 {
     verts[0] = v0;  verts[1] = v1;  verts[2] = v2;
 }
+
+void BasicDrawable::copyIndices(const std::vector<Triangle> &tris,bool wide,void *dest)
+{
+    if (wide)
+    {
+        memcpy(dest, tris.data(), tris.size()*sizeof(Triangle));
+    } else {
+        uint16_t *idx = (uint16_t *)dest;
+        for (const auto &tri : tris)
+        {
+            *idx++ = (uint16_t)tri.verts[0];
+            *idx++ = (uint16_t)tri.verts[1];
+            *idx++ = (uint16_t)tri.verts[2];
+        }
+    }
+}
     
 BasicDrawable::BasicDrawable(const std::string &name)
-: Drawable(name), motion(false)
+: Drawable(name), motion(false), localMbrType(LocalMbrUnknown), wideIndices(false)
 {
 }
 
@@ -130,7 +147,7 @@ bool BasicDrawable::isOn(RendererFrameInfo *frameInfo) const
     
     // Zoom based check.  We need to be in the current zoom range
     if (zoomSlot > -1 && zoomSlot <= MaplyMaxZoomSlots) {
-        float zoom = frameInfo->scene->getZoomSlotValue(zoomSlot);
+        float zoom = frameInfo->getZoomSlotValue(zoomSlot);
         if (zoom != MAXFLOAT) {
             if (minZoomVis != DrawVisibleInvalid && zoom < minZoomVis)
                 return false;
@@ -162,6 +179,22 @@ Mbr BasicDrawable::getLocalMbr() const
     return localMbr;
 }
 
+LocalMbrType BasicDrawable::getLocalMbrType() const
+{
+    return localMbrType;
+}
+
+DrawableVisibleRange BasicDrawable::getVisibleRange() const
+{
+    DrawableVisibleRange range;
+    range.minVisible = minVisible;
+    range.maxVisible = maxVisible;
+    range.zoomSlot = zoomSlot;
+    range.minZoomVis = minZoomVis;
+    range.maxZoomVis = maxZoomVis;
+    return range;
+}
+
 void BasicDrawable::setDrawOrder(int64_t newOrder)
 {
     if (newOrder != drawOrder)
@@ -678,7 +711,11 @@ void TransformChangeRequest::execute2(Scene *scene,SceneRenderer *renderer,Drawa
 {
     BasicDrawableRef basicDraw = std::dynamic_pointer_cast<BasicDrawable>(draw);
     if (basicDraw.get())
+    {
         basicDraw->setMatrix(&newMat);
+        // Once it's moved, the MBR doesn't say where it is
+        basicDraw->localMbrType = LocalMbrUnknown;
+    }
 }
 
 DrawOrderChangeRequest::DrawOrderChangeRequest(SimpleIdentity drawId,int64_t drawOrder)
@@ -160,9 +160,10 @@ void BasicDrawableBuilder::setFade(TimeInterval inFadeDown,TimeInterval inFadeUp
     basicDraw->fadeUp = inFadeUp;  basicDraw->fadeDown = inFadeDown;
 }
 
-void BasicDrawableBuilder::setLocalMbr(Mbr mbr)
+void BasicDrawableBuilder::setLocalMbr(Mbr mbr,LocalMbrType type)
 {
     basicDraw->localMbr = mbr;
+    basicDraw->localMbrType = type;
 }
     
 const Mbr &BasicDrawableBuilder::getLocalMbr()
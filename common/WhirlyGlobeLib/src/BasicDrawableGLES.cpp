@@ -127,11 +127,12 @@ void BasicDrawableGLES::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scen
     // Size of a single vertex entry
     const int numVerts = (int)points.size();
     
+    // Indices are 16 bit unless there are too many vertices for that
+    wideIndices = numVerts > (1<<16);
+    const size_t triBufferSize = indexBufferSize(tris.size(),wideIndices);
+
     // Set up the buffer
-    int bufferSize = vertexSize*numVerts;
-    if (!tris.empty()) {
-        bufferSize += tris.size()*sizeof(Triangle);
-    }
+    int bufferSize = vertexSize*numVerts + triBufferSize;
     sharedBuffer = setupInfo->memManager->getBufferID(bufferSize,GL_STATIC_DRAW);
     if (!sharedBuffer) {
         wkLogLevel(Error, "Empty buffer in BasicDrawable::setupGL() (requested %d)", bufferSize);
@@ -149,15 +150,11 @@ void BasicDrawableGLES::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scen
             // And copy in the element buffer
             if (tris.size()) {
                 triBuffer = vertexSize * numVerts;
-                unsigned char *triBasePtr = (unsigned char *) glMem + triBuffer;
-                for (unsigned int ii = 0; ii < tris.size(); ii++, triBasePtr += sizeof(Triangle))
-                    memcpy(triBasePtr, &tris[ii], sizeof(Triangle));
+                copyIndices(tris, wideIndices, (unsigned char *) glMem + triBuffer);
             }
             glUnmapBuffer(GL_ARRAY_BUFFER);
         }
     } else {
-        bufferSize = numVerts*vertexSize+tris.size()*sizeof(Triangle);
-        
         // Gotta do this the hard way
         std::vector<unsigned char> glMemBuf(bufferSize);
         unsigned char *glMem = &glMemBuf[0];
@@ -167,8 +164,7 @@ void BasicDrawableGLES::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scen
         
         // Now the element buffer
         triBuffer = numVerts*vertexSize;
-        for (unsigned int ii=0;ii<tris.size();ii++,basePtr+=sizeof(Triangle))
-            memcpy(basePtr, &tris[ii], sizeof(Triangle));
+        copyIndices(tris, wideIndices, basePtr);
         
         glBufferData(GL_ARRAY_BUFFER, bufferSize, glMem, GL_STATIC_DRAW);
     }
@@ -284,6 +280,13 @@ GLuint BasicDrawableGLES::setupVAO(ProgramGLES *prog)
     return theVertArrayObj;
 }
     
+void BasicDrawableGLES::packIndices(std::vector<unsigned char> &indices) const
+{
+    indices.resize(indexBufferSize(tris.size(),wideIndices));
+    if (!tris.empty())
+        copyIndices(tris, wideIndices, &indices[0]);
+}
+
 bool BasicDrawableGLES::isSetupInGL()
 {
     return isSetupGL;
@@ -573,7 +576,7 @@ void BasicDrawableGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inScene)
         switch (type)
         {
             case Triangles:
-                glDrawElements(GL_TRIANGLES, numTris*3, GL_UNSIGNED_SHORT, CALCBUFOFF(0,triBuffer));
+                glDrawElements(GL_TRIANGLES, numTris*3, getIndexType(), CALCBUFOFF(0,triBuffer));
                 CheckGLError("BasicDrawable::drawVBO2() glDrawElements");
                 break;
             case Points:
@@ -602,14 +605,19 @@ void BasicDrawableGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inScene)
                     if (!boundElements)
                         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triBuffer);
                     CheckGLError("BasicDrawable::drawVBO2() glBindBuffer");
-                    glDrawElements(GL_TRIANGLES, numTris*3, GL_UNSIGNED_SHORT, (void *)((uintptr_t)triBuffer));
+                    glDrawElements(GL_TRIANGLES, numTris*3, getIndexType(), (void *)((uintptr_t)triBuffer));
                     CheckGLError("BasicDrawable::drawVBO2() glDrawElements");
                     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
                 } else {
                     if (!boundElements)
-                        glDrawElements(GL_TRIANGLES, (GLsizei)tris.size()*3, GL_UNSIGNED_SHORT, &tris[0]);
-                    else
-                        glDrawElements(GL_TRIANGLES, numTris*3, GL_UNSIGNED_SHORT, 0);
+                    {
+                        // Indices from client memory have to match the type we tell GL, same as the buffer
+                        std::vector<unsigned char> indices;
+                        packIndices(indices);
+                        if (!indices.empty())
+                            glDrawElements(GL_TRIANGLES, (GLsizei)tris.size()*3, getIndexType(), &indices[0]);
+                    } else
+                        glDrawElements(GL_TRIANGLES, numTris*3, getIndexType(), 0);
                     CheckGLError("BasicDrawable::drawVBO2() glDrawElements");
                 }
             }
@@ -142,7 +142,7 @@ bool BasicDrawableInstance::isOn(WhirlyKit::RendererFrameInfo *frameInfo) const
     
     // Zoom based check.  We need to be in the current zoom range
     if (zoomSlot > -1 && zoomSlot <= MaplyMaxZoomSlots) {
-        float zoom = frameInfo->scene->getZoomSlotValue(zoomSlot);
+        float zoom = frameInfo->getZoomSlotValue(zoomSlot);
         if (zoom != MAXFLOAT) {
             if (minZoomVis != DrawVisibleInvalid && zoom < minZoomVis)
                 return false;
@@ -205,6 +205,17 @@ void BasicDrawableInstance::setEnable(bool newEnable)
     enable = newEnable;
 }
 
+DrawableVisibleRange BasicDrawableInstance::getVisibleRange() const
+{
+    DrawableVisibleRange range;
+    range.minVisible = minVis;
+    range.maxVisible = maxVis;
+    range.zoomSlot = zoomSlot;
+    range.minZoomVis = minZoomVis;
+    range.maxZoomVis = maxZoomVis;
+    return range;
+}
+
 void BasicDrawableInstance::setEnableTimeRange(TimeInterval inStartEnable,TimeInterval inEndEnable)
 {
     startEnable = inStartEnable;  endEnable = inEndEnable;
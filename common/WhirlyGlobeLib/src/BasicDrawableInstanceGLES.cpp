@@ -480,9 +480,9 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
                 case Triangles:
                     if (instBuffer)
                     {
-                        glDrawElementsInstanced(GL_TRIANGLES, basicDrawGL->numTris*3, GL_UNSIGNED_SHORT, CALCBUFOFF(0,basicDrawGL->triBuffer), numInstances);
+                        glDrawElementsInstanced(GL_TRIANGLES, basicDrawGL->numTris*3, basicDrawGL->getIndexType(), CALCBUFOFF(0,basicDrawGL->triBuffer), numInstances);
                     } else
-                        glDrawElements(GL_TRIANGLES, basicDrawGL->numTris*3, GL_UNSIGNED_SHORT, CALCBUFOFF(0,basicDrawGL->triBuffer));
+                        glDrawElements(GL_TRIANGLES, basicDrawGL->numTris*3, basicDrawGL->getIndexType(), CALCBUFOFF(0,basicDrawGL->triBuffer));
                     CheckGLError("BasicDrawable::drawVBO2() glDrawElements");
                     break;
                 case Points:
@@ -535,18 +535,26 @@ void BasicDrawableInstanceGLES::draw(RendererFrameInfoGLES *frameInfo,Scene *inS
                         CheckGLError("BasicDrawable::drawVBO2() glBindBuffer");
                         if (instBuffer)
                         {
-                            glDrawElementsInstanced(GL_TRIANGLES, basicDrawGL->numTris*3, GL_UNSIGNED_SHORT, 0, numInstances);
+                            glDrawElementsInstanced(GL_TRIANGLES, basicDrawGL->numTris*3, basicDrawGL->getIndexType(), 0, numInstances);
                         } else
-                            glDrawElements(GL_TRIANGLES, basicDrawGL->numTris*3, GL_UNSIGNED_SHORT, (void *)((uintptr_t)basicDrawGL->triBuffer));
+                            glDrawElements(GL_TRIANGLES, basicDrawGL->numTris*3, basicDrawGL->getIndexType(), (void *)((uintptr_t)basicDrawGL->triBuffer));
                         CheckGLError("BasicDrawable::drawVBO2() glDrawElements");
                         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
                     } else {
-                        if (instBuffer)
+                        // Indices from client memory have to match the type we tell GL, same as the buffer
+                        std::vector<unsigned char> indices;
+                        basicDrawGL->packIndices(indices);
+                        if (!indices.empty())
                         {
-                            glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)basicDrawGL->tris.size()*3, GL_UNSIGNED_SHORT, &basicDrawGL->tris[0], numInstances);
-                        } else
-                            glDrawElements(GL_TRIANGLES, (GLsizei)basicDrawGL->tris.size()*3, GL_UNSIGNED_SHORT, &basicDrawGL->tris[0]);
-                        CheckGLError("BasicDrawable::drawVBO2() glDrawElements");
+                            if (boundElements)
+                                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+                            if (instBuffer)
+                            {
+                                glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)basicDrawGL->tris.size()*3, basicDrawGL->getIndexType(), &indices[0], numInstances);
+                            } else
+                                glDrawElements(GL_TRIANGLES, (GLsizei)basicDrawGL->tris.size()*3, basicDrawGL->getIndexType(), &indices[0]);
+                            CheckGLError("BasicDrawable::drawVBO2() glDrawElements");
+                        }
                     }
                 }
                     break;
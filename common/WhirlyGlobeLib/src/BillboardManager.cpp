@@ -113,8 +113,8 @@ void BillboardBuilder::addBillboard(const Point3d &center, const Point2dVector &
         
     // Get the drawable ready
     if (!drawable || !drawable->compareVertexAttributes(vertAttrs) ||
-        (drawable->getNumPoints()+4 > MaxDrawablePoints) ||
-        (drawable->getNumTris()+2 > MaxDrawableTriangles))
+        (drawable->getNumPoints()+4 > sceneRender->getMaxDrawablePoints()) ||
+        (drawable->getNumTris()+2 > sceneRender->getMaxDrawableTriangles()))
     {
         if (drawable)
             flush();
@@ -16,6 +16,7 @@
  *  limitations under the License.
  */
 
+#import <algorithm>
 #import "Platform.h"
 #import "WhirlyKitLog.h"
 #import "CoordSystem.h"
@@ -49,6 +50,58 @@ Point3d CoordSystemConvert3d(CoordSystem *inSystem,CoordSystem *outSystem,Point3
     return outPt;
 }
 
+void CoordSystemConvert3d(CoordSystem *inSystem,CoordSystem *outSystem,const Point3d *inCoords,Point3d *outCoords,size_t count)
+{
+    if (inSystem->isSameAs(outSystem))
+    {
+        if (inCoords != outCoords)
+            std::copy(inCoords,inCoords+count,outCoords);
+        return;
+    }
+
+    inSystem->localToGeocentric(inCoords,outCoords,count);
+    outSystem->geocentricToLocal(outCoords,outCoords,count);
+}
+
+void CoordSystem::geographicToLocal(const Point2d *geo,Point3d *local,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        local[ii] = geographicToLocal(geo[ii]);
+}
+
+void CoordSystem::localToGeocentric(const Point3d *local,Point3d *geoc,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        geoc[ii] = localToGeocentric(local[ii]);
+}
+
+void CoordSystem::geocentricToLocal(const Point3d *geoc,Point3d *local,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        local[ii] = geocentricToLocal(geoc[ii]);
+}
+
+void CoordSystemDisplayAdapter::localToDisplay(const Point3d *local,Point3d *disp,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        disp[ii] = localToDisplay(local[ii]);
+}
+
+void CoordSystemDisplayAdapter::normalForLocal(const Point3d *local,Point3d *norms,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        norms[ii] = normalForLocal(local[ii]);
+}
+
+void CoordSystemDisplayAdapter::geographicToDisplay(const Point2d *geo,Point3d *disp,Point3d *norms,size_t count) const
+{
+    getCoordSystem()->geographicToLocal(geo,disp,count);
+    // Normals are based on the local coordinates, so do those first
+    if (norms)
+        normalForLocal(disp,norms,count);
+    localToDisplay(disp,disp,count);
+}
+
 GeneralCoordSystemDisplayAdapter::GeneralCoordSystemDisplayAdapter(CoordSystem *coordSys,const Point3d &ll,const Point3d &ur,
                                                                    const Point3d &inCenter,const Point3d &inScale) :
     CoordSystemDisplayAdapter(coordSys,inCenter),
@@ -96,6 +149,22 @@ Point3d GeneralCoordSystemDisplayAdapter::localToDisplay(Point3d localPt) const
             center;
 }
     
+void GeneralCoordSystemDisplayAdapter::localToDisplay(const Point3d *local,Point3d *disp,size_t count) const
+{
+    const double sx = scale.x(), sy = scale.y(), sz = scale.z();
+    const double cx = center.x(), cy = center.y(), cz = center.z();
+    for (size_t ii=0;ii<count;ii++)
+    {
+        const Point3d &pt = local[ii];
+        disp[ii] = Point3d(pt.x()*sx - cx,pt.y()*sy - cy,pt.z()*sz - cz);
+    }
+}
+
+void GeneralCoordSystemDisplayAdapter::normalForLocal(const Point3d *,Point3d *norms,size_t count) const
+{
+    std::fill(norms,norms+count,Point3d(0,0,1));
+}
+
 Point3f GeneralCoordSystemDisplayAdapter::displayToLocal(Point3f dispPt) const
 {
     return Point3f(dispPt.x()/scale.x(),dispPt.y()/scale.y(),dispPt.z()/scale.z()) +
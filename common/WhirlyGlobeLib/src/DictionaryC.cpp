@@ -766,6 +766,24 @@ void MutableDictionaryC::addEntries(const Dictionary *inOther)
     {
         addEntries(other);
     }
+    else if (inOther)
+    {
+        // Some other implementation, go through the generic interface
+        for (const auto &key : inOther->getKeys())
+        {
+            switch (inOther->getType(key))
+            {
+                case DictTypeInt:      setInt(key, inOther->getInt(key));  break;
+                case DictTypeInt64:    setInt64(key, inOther->getInt64(key));  break;
+                case DictTypeIdentity: setIdentifiable(key, inOther->getIdentity(key));  break;
+                case DictTypeDouble:   setDouble(key, inOther->getDouble(key));  break;
+                case DictTypeString:   setString(key, inOther->getString(key));  break;
+                default:
+                    wkLogLevel(Warn, "Unsupported type %d in addEntries", inOther->getType(key));
+                    break;
+            }
+        }
+    }
 }
 
 void MutableDictionaryC::addEntries(const MutableDictionaryC *other)
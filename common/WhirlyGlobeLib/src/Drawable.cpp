@@ -18,8 +18,10 @@
  *
  */
 
+#import <tuple>
 #import "Drawable.h"
 #import "Scene.h"
+#import "SceneRenderer.h"
 #import "WhirlyKitLog.h"
 
 using namespace Eigen;
@@ -36,6 +38,45 @@ Drawable::~Drawable()
 {
 }
     
+DrawableVisibleRange::DrawableVisibleRange()
+    : minVisible(DrawVisibleInvalid), maxVisible(DrawVisibleInvalid),
+      zoomSlot(-1), minZoomVis(DrawVisibleInvalid), maxZoomVis(DrawVisibleInvalid)
+{
+}
+
+bool DrawableVisibleRange::isVisible(const RendererFrameInfo *frameInfo) const
+{
+    // Height based check
+    if (minVisible != DrawVisibleInvalid && maxVisible != DrawVisibleInvalid)
+    {
+        const double visVal = frameInfo->theView->heightAboveSurface();
+        if (!((minVisible <= visVal && visVal <= maxVisible) ||
+              (maxVisible <= visVal && visVal <= minVisible)))
+            return false;
+    }
+
+    // Zoom based check
+    if (zoomSlot > -1 && zoomSlot <= MaplyMaxZoomSlots)
+    {
+        const float zoom = frameInfo->getZoomSlotValue(zoomSlot);
+        if (zoom != MAXFLOAT)
+        {
+            if (minZoomVis != DrawVisibleInvalid && zoom < minZoomVis)
+                return false;
+            if (maxZoomVis != DrawVisibleInvalid && zoom >= maxZoomVis)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool DrawableVisibleRange::operator < (const DrawableVisibleRange &that) const
+{
+    return std::tie(minVisible,maxVisible,zoomSlot,minZoomVis,maxZoomVis) <
+           std::tie(that.minVisible,that.maxVisible,that.zoomSlot,that.minZoomVis,that.maxZoomVis);
+}
+
 void Drawable::runTweakers(RendererFrameInfo *frame)
 {
     for (DrawableTweakerRefSet::iterator it = tweakers.begin();
@@ -47,7 +88,11 @@ void DrawableChangeRequest::execute(Scene *scene,SceneRenderer *renderer,WhirlyK
 {
 	DrawableRef theDrawable = scene->getDrawable(drawId);
 	if (theDrawable)
+	{
 		execute2(scene,renderer,theDrawable);
+		// Priority or visibility may have changed
+		scene->updateDrawable(theDrawable.get());
+	}
 }
     
 }
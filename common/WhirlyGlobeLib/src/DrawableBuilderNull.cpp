@@ -0,0 +1,338 @@
+/*
+ *  DrawableBuilderNull.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "DrawableBuilderNull.h"
+#import "SceneRenderer.h"
+#import "SharedAttributes.h"
+#import "WhirlyKitLog.h"
+
+using namespace Eigen;
+
+namespace WhirlyKit
+{
+
+void BasicDrawableTweakerNull::tweakForFrame(Drawable *inDraw,RendererFrameInfo *frameInfo)
+{
+    if (colorExp || opacityExp)
+    if (auto draw = dynamic_cast<BasicDrawable*>(inDraw))
+    {
+        const float zoom = getZoom(*inDraw,*frameInfo->scene,-1.0f);
+        if (zoom >= 0)
+        {
+            auto c = colorExp ? colorExp->evaluate(zoom, color) : color;
+            if (opacityExp)
+            {
+                const auto a = (uint8_t) (255.0f * opacityExp->evaluate(zoom, 1.0f));
+                c = RGBAColor::FromInt((int)(((uint32_t)c.asInt() & 0x00FFFFFFU) | ((uint32_t)a << 24U)));
+            }
+            c.r *= c.a/255.0;  c.g *= c.a/255.0;  c.b *= c.a/255.0;
+            draw->setOverrideColor(c);
+        }
+    }
+}
+
+void ScreenSpaceTweakerNull::tweakForFrame(Drawable *inDraw,RendererFrameInfo *frameInfo)
+{
+    // The GL version hands the scale to the shader, we just work it out
+    if (opacityExp || colorExp || scaleExp)
+    {
+        const float zoom = getZoom(*inDraw,*frameInfo->scene,0.0f);
+        if (scaleExp)
+            (void)scaleExp->evaluate(zoom, 1.0);
+    }
+    if (auto draw = dynamic_cast<BasicDrawable*>(inDraw))
+    {
+        if (draw->hasMotion())
+        {
+            draw->setUniform(u_TimeNameID, (float) (frameInfo->currentTime - startTime));
+        }
+    }
+}
+
+void WideVectorTweakerNull::tweakForFrame(Drawable *inDraw,RendererFrameInfo *frameInfo)
+{
+    auto basicDraw = dynamic_cast<BasicDrawable *>(inDraw);
+    if (!basicDraw)
+    {
+        wkLogLevel(Warn, "Invalid drawable passed to WideVectorTweakerNull");
+        return;
+    }
+
+    const double frameSize = std::min(frameInfo->sceneRenderer->framebufferWidth, frameInfo->sceneRenderer->framebufferHeight);
+    const double screenSize = std::min(frameInfo->screenSizeInDisplayCoords.x(), frameInfo->screenSizeInDisplayCoords.y());
+    const double screenWidth = frameInfo->screenSizeInDisplayCoords.x();
+    const double pixDispScale = screenSize / frameSize;
+    const double texScale = frameSize / (screenWidth * texRepeat);
+    const float zoom = (opacityExp || colorExp || widthExp) ? getZoom(*inDraw,*frameInfo->scene,0.0f) : 0.0f;
+
+    Vector4f c = colorExp ? colorExp->evaluateF(zoom,color) : color.asRGBAVecF();
+
+    if (opacityExp)
+    {
+        c.w() = opacityExp->evaluate(zoom, 1.0f);
+    }
+
+    // Multiply the alpha through, otherwise you just get the max color
+    c *= c.w();
+
+    basicDraw->setOverrideColor(RGBAColor(c));
+
+    const float width = (widthExp ? widthExp->evaluate(zoom, lineWidth) : lineWidth) + 2 * edgeSize;
+    basicDraw->setUniform(u_w2NameID, width / 2);
+    basicDraw->setUniform(u_Realw2NameID, (float)(pixDispScale * width / 2));
+    basicDraw->setUniform(u_EdgeNameID, edgeSize);
+    basicDraw->setUniform(u_texScaleNameID, (float)texScale);
+
+    if (offsetSet)
+    {
+        const float theOffset = offsetExp ? offsetExp->evaluate(zoom, offset) : offset;
+        basicDraw->setUniform(u_wideOffsetNameID, theOffset);
+    }
+}
+
+BasicDrawableBuilderNull::BasicDrawableBuilderNull(const std::string &name,Scene *scene,bool setupStandard)
+    : BasicDrawableBuilder(name,scene), drawableGotten(false)
+{
+    basicDraw = std::make_shared<BasicDrawableNull>(name);
+    BasicDrawableBuilder::Init();
+    if (setupStandard)
+        setupStandardAttributes();  // NOLINT: derived virtual not called here
+}
+
+BasicDrawableBuilderNull::~BasicDrawableBuilderNull()
+{
+    if (!drawableGotten)
+        basicDraw.reset();
+}
+
+// NOLINTNEXTLINE(google-default-arguments)
+int BasicDrawableBuilderNull::addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int slot,int numThings)
+{
+    auto *attr = new VertexAttribute(dataType,slot,nameID);
+    if (numThings > 0)
+        attr->reserve(numThings);
+    basicDraw->vertexAttributes.push_back(attr);
+
+    return (int)(basicDraw->vertexAttributes.size()-1);
+}
+
+BasicDrawableRef BasicDrawableBuilderNull::getDrawable()
+{
+    auto draw = std::dynamic_pointer_cast<BasicDrawableNull>(basicDraw);
+
+    if (draw && !drawableGotten) {
+        draw->points = points;
+        draw->tris = tris;
+
+        ((BasicDrawableBuilder*)this)->setupTweaker(*draw);
+
+        drawableGotten = true;
+    }
+
+    return draw;
+}
+
+DrawableTweakerRef BasicDrawableBuilderNull::makeTweaker() const
+{
+    if (colorExp || opacityExp)
+    {
+        return std::make_shared<BasicDrawableTweakerNull>();
+    }
+    return {};
+}
+
+void BasicDrawableBuilderNull::setupTweaker(const DrawableTweakerRef &inTweaker) const
+{
+    if (auto tweaker = std::dynamic_pointer_cast<BasicDrawableTweaker>(inTweaker))
+    {
+        tweaker->color = basicDraw->color;
+        tweaker->colorExp = colorExp;
+        tweaker->opacityExp = opacityExp;
+    }
+}
+
+BasicDrawableInstanceBuilderNull::BasicDrawableInstanceBuilderNull(const std::string &name,Scene *scene) :
+    BasicDrawableInstanceBuilder(name,scene),
+    drawableGotten(false)
+{
+    drawInst = std::make_shared<BasicDrawableInstanceNull>(name);
+
+    Init();
+}
+
+BasicDrawableInstanceBuilderNull::~BasicDrawableInstanceBuilderNull()
+{
+    if (!drawableGotten)
+        drawInst.reset();
+}
+
+BasicDrawableInstanceRef BasicDrawableInstanceBuilderNull::getDrawable()
+{
+    drawableGotten = true;
+    return drawInst;
+}
+
+BillboardDrawableBuilderNull::BillboardDrawableBuilderNull(const std::string &name,Scene *scene)
+    : BasicDrawableBuilderNull(name,scene,true)
+{
+}
+
+int BillboardDrawableBuilderNull::addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int slot,int numThings)
+{
+    return BasicDrawableBuilderNull::addAttribute(dataType, nameID, slot, numThings);
+}
+
+BasicDrawableRef BillboardDrawableBuilderNull::getDrawable()
+{
+    return BasicDrawableBuilderNull::getDrawable();
+}
+
+ScreenSpaceDrawableBuilderNull::ScreenSpaceDrawableBuilderNull(const std::string &name,Scene *scene)
+    : BasicDrawableBuilderNull(name,scene,true)
+{
+}
+
+int ScreenSpaceDrawableBuilderNull::addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int slot,int numThings)
+{
+    return BasicDrawableBuilderNull::addAttribute(dataType, nameID, slot, numThings);
+}
+
+DrawableTweakerRef ScreenSpaceDrawableBuilderNull::makeTweaker() const
+{
+    return std::make_shared<ScreenSpaceTweakerNull>();
+}
+
+void ScreenSpaceDrawableBuilderNull::setupTweaker(BasicDrawable &draw) const
+{
+    // Diamond inheritance, this method only exists to eliminate ambiguity
+    BasicDrawableBuilder::setupTweaker(draw);
+}
+
+void ScreenSpaceDrawableBuilderNull::setupTweaker(const DrawableTweakerRef &inTweaker) const
+{
+    // Need to set up both parts of the tweaker
+    BasicDrawableBuilderNull::setupTweaker(inTweaker);
+    ScreenSpaceDrawableBuilder::setupTweaker(inTweaker);
+    ScreenSpaceTweakerNullRef theTweaker = std::dynamic_pointer_cast<ScreenSpaceTweakerNull>(inTweaker);
+    if (theTweaker && scaleExp) {
+        theTweaker->scaleExp = scaleExp;
+    }
+}
+
+BasicDrawableRef ScreenSpaceDrawableBuilderNull::getDrawable()
+{
+    if (drawableGotten)
+        return BasicDrawableBuilderNull::getDrawable();
+
+    auto theDraw = BasicDrawableBuilderNull::getDrawable();
+    theDraw->motion = motion;
+
+    setupTweaker(*theDraw);
+
+    return theDraw;
+}
+
+ParticleSystemDrawableBuilderNull::ParticleSystemDrawableBuilderNull(const std::string &name,Scene *scene)
+    : ParticleSystemDrawableBuilder(name,scene), drawableGotten(false)
+{
+    draw = new ParticleSystemDrawableNull(name);
+}
+
+void ParticleSystemDrawableBuilderNull::setup(const std::vector<SingleVertexAttributeInfo> &inVertAttrs,
+                   const std::vector<SingleVertexAttributeInfo> &inVaryAttrs,
+                   const std::vector<SimpleIdentity> &inVaryNames,
+                   int numTotalPoints,int batchSize,int vertexSize,bool useRectangles,bool useInstancing)
+{
+    auto drawNull = dynamic_cast<ParticleSystemDrawableNull *>(draw);
+
+    for (const auto &attr : inVertAttrs)
+        drawNull->vertexSize += attr.size();
+
+    ParticleSystemDrawableBuilder::setup(inVertAttrs,inVaryAttrs,inVaryNames,numTotalPoints,batchSize,drawNull->vertexSize,useRectangles,useInstancing);
+}
+
+ParticleSystemDrawableBuilderNull::~ParticleSystemDrawableBuilderNull()
+{
+    if (!drawableGotten && draw)
+        delete draw;
+}
+
+ParticleSystemDrawable *ParticleSystemDrawableBuilderNull::getDrawable()
+{
+    if (!draw)
+        return nullptr;
+
+    drawableGotten = true;
+
+    return draw;
+}
+
+WideVectorDrawableBuilderNull::WideVectorDrawableBuilderNull(const std::string &name,const SceneRenderer *sceneRenderer,Scene *scene) :
+    WideVectorDrawableBuilder(name,sceneRenderer,scene),
+    drawableGotten(false)
+{
+}
+
+void WideVectorDrawableBuilderNull::Init(unsigned int numVert,unsigned int numTri,unsigned int numCenterline,
+                                         WideVecImplType implType,
+                                         bool globeMode,
+                                         const WideVectorInfo *vecInfo)
+{
+    WideVectorDrawableBuilder::Init(numVert,numTri,0,implType,globeMode,vecInfo);
+}
+
+void WideVectorDrawableBuilderNull::generateChanges(const SimpleIDSet &drawIDs,ChangeSet &changes)
+{
+    // Changed line width
+    for (auto drawID: drawIDs)
+        changes.push_back(new LineWidthChangeRequest(drawID, lineWidth));
+}
+
+// NOLINTNEXTLINE(google-default-arguments)
+int WideVectorDrawableBuilderNull::addAttribute(BDAttributeDataType dataType,StringIdentity nameID,int slot,int numThings)
+{
+    return basicDrawable->addAttribute(dataType, nameID, slot, numThings);
+}
+
+DrawableTweakerRef WideVectorDrawableBuilderNull::makeTweaker() const
+{
+    return std::make_shared<WideVectorTweakerNull>();
+}
+
+BasicDrawableRef WideVectorDrawableBuilderNull::getBasicDrawable()
+{
+    if (drawableGotten)
+    {
+        return basicDrawable->getDrawable();
+    }
+
+    drawableGotten = true;
+    auto theDraw = basicDrawable->getDrawable();
+
+    setupTweaker(*theDraw);
+
+    return theDraw;
+}
+
+BasicDrawableInstanceRef WideVectorDrawableBuilderNull::getInstanceDrawable()
+{
+    return nullptr;
+}
+
+}
@@ -0,0 +1,213 @@
+/*
+ *  DrawableNull.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "DrawableNull.h"
+#import "SceneRendererNull.h"
+
+namespace WhirlyKit
+{
+
+DrawableNull::~DrawableNull()
+{
+}
+
+BasicDrawableNull::BasicDrawableNull(const std::string &name)
+    : Drawable(name), BasicDrawable(name), isSetup(false), bufferSize(0)
+{
+}
+
+BasicDrawableNull::~BasicDrawableNull()
+{
+}
+
+unsigned int BasicDrawableNull::singleVertexSize() const
+{
+    unsigned int vertSize = 3*sizeof(float);
+    for (const auto *attr : vertexAttributes)
+        if (attr->numElements() != 0)
+            vertSize += attr->size();
+
+    return vertSize;
+}
+
+void BasicDrawableNull::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scene *scene)
+{
+    auto setupInfo = (RenderSetupInfoNull *)inSetupInfo;
+
+    if (isSetup)
+        return;
+
+    // Same layout the GL version would use, an interleaved vertex buffer followed by the indices
+    const size_t numVerts = points.size();
+    wideIndices = numVerts > (1<<16);
+    bufferSize = singleVertexSize() * numVerts + indexBufferSize(tris.size(),wideIndices);
+    if (setupInfo)
+        setupInfo->addBuffer(bufferSize);
+
+    // The data would be in the buffer now, so let it go
+    numPoints = (int)points.size();
+    points.clear();
+    numTris = (int)tris.size();
+    tris.clear();
+    for (auto *attr : vertexAttributes)
+        attr->clear();
+
+    isSetup = true;
+}
+
+void BasicDrawableNull::teardownForRenderer(const RenderSetupInfo *inSetupInfo,Scene *scene,RenderTeardownInfoRef teardown)
+{
+    auto setupInfo = (RenderSetupInfoNull *)inSetupInfo;
+
+    if (!isSetup)
+        return;
+
+    if (setupInfo)
+        setupInfo->removeBuffer(bufferSize);
+    bufferSize = 0;
+    isSetup = false;
+}
+
+void BasicDrawableNull::draw(RendererFrameInfo *frameInfo,Scene *scene,FrameStatsNull &stats)
+{
+    stats.points += numPoints;
+    stats.triangles += numTris;
+}
+
+BasicDrawableInstanceNull::BasicDrawableInstanceNull(const std::string &name)
+    : Drawable(name), BasicDrawableInstance(name), isSetup(false), bufferSize(0)
+{
+}
+
+void BasicDrawableInstanceNull::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scene *scene)
+{
+    auto setupInfo = (RenderSetupInfoNull *)inSetupInfo;
+
+    if (isSetup)
+        return;
+
+    numInstances = (int)instances.size();
+    if (instances.empty())
+        return;
+
+    // Center, matrix, color and color flag, plus direction if they move.  Same as the GL version.
+    const size_t instSize = sizeof(float)*3 + sizeof(float)*16 + sizeof(float) + 4 + (moving ? sizeof(float)*3 : 0);
+    bufferSize = instSize * instances.size();
+    if (setupInfo)
+        setupInfo->addBuffer(bufferSize);
+
+    isSetup = true;
+}
+
+void BasicDrawableInstanceNull::teardownForRenderer(const RenderSetupInfo *inSetupInfo,Scene *scene,RenderTeardownInfoRef teardown)
+{
+    auto setupInfo = (RenderSetupInfoNull *)inSetupInfo;
+
+    if (!isSetup)
+        return;
+
+    if (setupInfo)
+        setupInfo->removeBuffer(bufferSize);
+    bufferSize = 0;
+    isSetup = false;
+}
+
+void BasicDrawableInstanceNull::draw(RendererFrameInfo *frameInfo,Scene *scene,FrameStatsNull &stats)
+{
+    if (!basicDraw)
+        return;
+
+    // Reuse style just draws the master again with different settings
+    const int64_t count = (instanceStyle == ReuseStyle) ? 1 : numInstances;
+    stats.points += count * basicDraw->numPoints;
+    stats.triangles += count * basicDraw->numTris;
+    if (instanceStyle != ReuseStyle)
+        stats.instances += count;
+}
+
+ParticleSystemDrawableNull::ParticleSystemDrawableNull(const std::string &name)
+    : Drawable(name), ParticleSystemDrawable(name), isSetup(false), bufferSize(0), batchBytes(0)
+{
+}
+
+void ParticleSystemDrawableNull::addAttributeData(const RenderSetupInfo *setupInfo,const std::vector<AttributeData> &attrData,const Batch &batch)
+{
+    batchBytes += (size_t)batchSize * vertexSize;
+
+    std::lock_guard<std::mutex> guardLock(batchLock);
+    batches[batch.batchID] = batch;
+    batches[batch.batchID].active = true;
+    chunksDirty = true;
+}
+
+void ParticleSystemDrawableNull::addAttributeData(const RenderSetupInfo *setupInfo,const RawDataRef &data,const Batch &batch)
+{
+    if (data)
+        batchBytes += data->getLen();
+
+    std::lock_guard<std::mutex> guardLock(batchLock);
+    batches[batch.batchID] = batch;
+    batches[batch.batchID].active = true;
+    chunksDirty = true;
+}
+
+void ParticleSystemDrawableNull::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scene *scene)
+{
+    auto setupInfo = (RenderSetupInfoNull *)inSetupInfo;
+
+    if (isSetup)
+        return;
+
+    bufferSize = (size_t)vertexSize * numTotalPoints;
+    if (setupInfo)
+        setupInfo->addBuffer(bufferSize);
+
+    isSetup = true;
+}
+
+void ParticleSystemDrawableNull::teardownForRenderer(const RenderSetupInfo *inSetupInfo,Scene *scene,RenderTeardownInfoRef teardown)
+{
+    auto setupInfo = (RenderSetupInfoNull *)inSetupInfo;
+
+    if (!isSetup)
+        return;
+
+    if (setupInfo)
+        setupInfo->removeBuffer(bufferSize);
+    bufferSize = 0;
+    isSetup = false;
+}
+
+void ParticleSystemDrawableNull::draw(RendererFrameInfo *frameInfo,Scene *scene,FrameStatsNull &stats)
+{
+    if (lastUpdateTime < frameInfo->currentTime) {
+        updateBatches(frameInfo->currentTime);
+        updateChunks();
+        lastUpdateTime = frameInfo->currentTime;
+    }
+
+    for (const BufferChunk &chunk : chunks)
+    {
+        stats.points += chunk.numVertices;
+        if (useRectangles)
+            stats.triangles += 2 * chunk.numVertices;
+    }
+}
+
+}
@@ -22,6 +22,7 @@
 #import "Scene.h"
 #import "SceneRenderer.h"
 #import "WhirlyKitLog.h"
+#import <bitset>
 
 using namespace Eigen;
 
@@ -34,7 +35,7 @@ DynamicTexture::Region::Region()
 }
 
 DynamicTexture::DynamicTexture(const std::string &name)
-: TextureBase(name), layoutGrid(NULL)
+: TextureBase(name)
 {
 }
 
@@ -45,18 +46,13 @@ void DynamicTexture::setup(int inTexSize,int inCellSize,TextureType inType,bool
     type = inType;
     clearTextures = inClearTextures;
     numCell = texSize/cellSize;
-    layoutGrid = new bool[numCell * numCell];
-    for (unsigned int ii=0;ii<numCell * numCell;ii++)
-        layoutGrid[ii] = false;
+    rowWords = (numCell+63)/64;
+    layoutGrid.assign(rowWords * numCell, 0);
+    skyline.assign(numCell, 0);
 }
 
 DynamicTexture::~DynamicTexture()
 {
-    if (!layoutGrid)
-        return;
-    
-    delete [] layoutGrid;
-    layoutGrid = NULL;
 }
     
 void DynamicTexture::addTexture(Texture *tex,const Region &region)
@@ -70,18 +66,63 @@ void DynamicTexture::addTexture(Texture *tex,const Region &region)
     addTextureData(startX,startY,width,height,data);
 }
 
+// Bits sx through ex (inclusive) of the given word
+static inline uint64_t SpanMask(int sx,int ex)
+{
+    const uint64_t upper = (ex >= 63) ? ~(uint64_t)0 : (((uint64_t)1 << (ex+1)) - 1);
+    return upper & (~(uint64_t)0 << sx);
+}
+
+// Index of the lowest set bit.  Word must be non-zero.
+static inline int LowBit(uint64_t word)
+{
+    int bit = 0;
+    for (int shift = 32; shift > 0; shift /= 2)
+        if (!(word & (((uint64_t)1 << shift) - 1)))
+        {
+            word >>= shift;
+            bit += shift;
+        }
+    return bit;
+}
+
 void DynamicTexture::setRegion(const Region &region, bool enable)
 {
     int sx = std::max(region.sx,0), sy = std::max(region.sy,0);
     int ex = std::min(region.ex,numCell-1), ey = std::min(region.ey,numCell-1);
+    if (sx > ex || sy > ey)
+        return;
+    
+    for (int iy=sy;iy<=ey;iy++)
+    {
+        uint64_t *row = &layoutGrid[iy*rowWords];
+        for (int word = sx/64;word <= ex/64;word++)
+        {
+            const uint64_t mask = SpanMask(std::max(sx-word*64,0),std::min(ex-word*64,63));
+            if (enable)
+                row[word] |= mask;
+            else
+                row[word] &= ~mask;
+        }
+    }
     
-    for (unsigned int ix=sx;ix<=ex;ix++)
-        for (unsigned int iy=sy;iy<=ey;iy++)
+    // Keep the skyline up to date
+    for (int ix=sx;ix<=ex;ix++)
+    {
+        if (enable)
+            skyline[ix] = std::max(skyline[ix],ey+1);
+        else if (skyline[ix] <= ey+1)
         {
-            layoutGrid[iy*numCell+ix] = enable;
+            // The top of this column may have come off, so look for the new one
+            int iy = std::min(skyline[ix],numCell)-1;
+            const uint64_t bit = (uint64_t)1 << (ix%64);
+            while (iy >= 0 && !(layoutGrid[iy*rowWords+ix/64] & bit))
+                iy--;
+            skyline[ix] = iy+1;
         }
+    }
 }
-    
+
 void DynamicTexture::clearRegion(const Region &clearRegion,ChangeSet &changes,bool mainThreadMerge,unsigned char *emptyData)
 {
     int startX = clearRegion.sx * cellSize;
@@ -113,38 +154,46 @@ bool DynamicTexture::findRegion(int sizeX,int sizeY,Region &region)
         setRegion(ii, false);
     }
     
-    // Now look for a region that'll fit
-    // Look for a spot big enough
-    bool found = false;
-    int foundX=0,foundY=0;
-    for (int iy=0;iy<=numCell-sizeY && !found;iy++)
-        for (int ix=0;ix<=numCell-sizeX && !found;ix++)
+    if (sizeX > numCell || sizeY > numCell)
+        return false;
+    
+    // First fit, row by row, a word of cells at a time
+    std::vector<uint64_t> openCells(rowWords);
+    const int extraBits = rowWords*64 - numCell;
+    for (int iy=0;iy<=numCell-sizeY;iy++)
+    {
+        // Cells open in every row the region would cover.  Bits past the edge aren't.
+        for (int word=0;word<rowWords;word++)
         {
-            bool clear = true;
-            for (int testY=0;testY<sizeY && clear;testY++)
-                for (int testX=0;testX<sizeX && clear;testX++)
-                {
-                    if (layoutGrid[(testY+iy)*numCell+(testX+ix)])
-                        clear = false;
-                }
-            if (clear)
+            uint64_t used = 0;
+            for (int testY=iy;testY<iy+sizeY;testY++)
+                used |= layoutGrid[testY*rowWords+word];
+            openCells[word] = ~used;
+        }
+        if (extraBits > 0)
+            openCells[rowWords-1] &= ~(uint64_t)0 >> extraBits;
+        
+        // Leave a bit set only where sizeX open cells start
+        for (int fold=1;fold<sizeX;fold++)
+            for (int word=0;word<rowWords;word++)
             {
-                foundX = ix;
-                foundY = iy;
-                found = true;
+                const uint64_t carry = (word+1 < rowWords) ? openCells[word+1] << 63 : 0;
+                openCells[word] &= (openCells[word] >> 1) | carry;
             }
-        }
-    
-    if (!found)
-        return false;
-    
-    // Found one, so fill it in
-    region.sx = foundX;  region.sy = foundY;
-    region.ex = foundX+sizeX-1;  region.ey = foundY+sizeY-1;
+        
+        for (int word=0;word<rowWords;word++)
+            if (openCells[word])
+            {
+                const int ix = word*64 + LowBit(openCells[word]);
+                region.sx = ix;  region.sy = iy;
+                region.ex = ix+sizeX-1;  region.ey = iy+sizeY-1;
+                return true;
+            }
+    }
     
-    return true;
+    return false;
 }
-    
+
 void DynamicTexture::addRegionToClear(const Region &region)
 {
     std::lock_guard<std::mutex> guardLock(regionLock);
@@ -157,14 +206,23 @@ bool DynamicTexture::empty()
 }
 
 void DynamicTexture::getUtilization(int &outNumCell,int &usedCell)
+{
+    int holeCell;
+    getUtilization(outNumCell, usedCell, holeCell);
+}
+
+void DynamicTexture::getUtilization(int &outNumCell,int &usedCell,int &holeCell)
 {
     outNumCell = numCell*numCell;
     usedCell = 0;
-    for (unsigned int ii=0;ii<numCell*numCell;ii++)
-    {
-        if (layoutGrid[ii])
-            usedCell++;
-    }
+    for (const uint64_t word : layoutGrid)
+        usedCell += (int)std::bitset<64>(word).count();
+    
+    // Free cells below the skyline are holes
+    int belowSkyline = 0;
+    for (const int height : skyline)
+        belowSkyline += height;
+    holeCell = belowSkyline - usedCell;
 }
     
 void DynamicTextureClearRegion::execute(Scene *scene,SceneRenderer *renderer,View *view)
@@ -518,15 +576,16 @@ void DynamicTextureAtlas::getUsage(int &numRegions,int &dynamicTextures)
 
 void DynamicTextureAtlas::log()
 {
-    int numCells=0,usedCells=0;
+    int numCells=0,usedCells=0,holeCells=0;
     for (DynamicTextureSet::iterator it = textures.begin();
          it != textures.end(); ++it)
     {
         DynamicTextureVec *texVec = *it;
-        int thisNumCells,thisUsedCells;
-        texVec->at(0)->getUtilization(thisNumCells,thisUsedCells);
+        int thisNumCells,thisUsedCells,thisHoleCells;
+        texVec->at(0)->getUtilization(thisNumCells,thisUsedCells,thisHoleCells);
         numCells += thisNumCells;
         usedCells += thisUsedCells;
+        holeCells += thisHoleCells;
     }
 
     int texelSize = 4;
@@ -561,7 +620,11 @@ void DynamicTextureAtlas::log()
     
     wkLogLevel(Warn,"DynamicTextureAtlas: %ld textures, (%.2f MB)",textures.size(),textures.size() * texSize*texSize*texelSize/(float)(1024*1024));
     if (numCells > 0)
+    {
         wkLogLevel(Warn,"DynamicTextureAtlas: using %.2f%% of the cells",100 * usedCells / (float)numCells);
+        if (numCells > usedCells)
+            wkLogLevel(Warn,"DynamicTextureAtlas: %.2f%% of the free cells are holes",100 * holeCells / (float)(numCells - usedCells));
+    }
 }
 
 }
@@ -0,0 +1,440 @@
+/*
+ *  FlatDictionary.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <algorithm>
+#import <cstring>
+#import "FlatDictionary.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+// These live in DictionaryC.cpp
+extern RGBAColor ARGBtoRGBAColor(uint32_t v);
+extern RGBAColor parseColor(const char* p, RGBAColor ret);
+
+AttrArena::AttrArena(size_t blockSize)
+    : blockSize(blockSize), cur(nullptr), left(0), totalSize(0)
+{
+}
+
+void *AttrArena::alloc(size_t len,size_t align)
+{
+    size_t pad = (align - ((uintptr_t)cur % align)) % align;
+    if (!cur || pad + len > left)
+    {
+        // Big requests get their own block
+        const size_t newSize = std::max(blockSize,len + align);
+        blocks.emplace_back(new char[newSize]);
+        cur = blocks.back().get();
+        left = newSize;
+        totalSize += newSize;
+        pad = (align - ((uintptr_t)cur % align)) % align;
+    }
+
+    char *ret = cur + pad;
+    cur += pad + len;
+    left -= pad + len;
+
+    return ret;
+}
+
+std::string_view AttrArena::internString(std::string_view str)
+{
+    if (str.empty())
+        return std::string_view("",0);
+
+    const auto it = strings.find(str);
+    if (it != strings.end())
+        return *it;
+
+    char *data = (char *)alloc(str.size(),1);
+    memcpy(data,str.data(),str.size());
+    const std::string_view newStr(data,str.size());
+    strings.insert(newStr);
+
+    return newStr;
+}
+
+FlatDictionary::FlatDictionary(AttrArenaRef arena,const FlatAttr *attrs,unsigned int numAttrs)
+    : arena(std::move(arena)), attrs(attrs), numAttrs(numAttrs)
+{
+}
+
+FlatDictionaryRef FlatDictionary::Make(const AttrArenaRef &arena,const FlatAttr *attrs,unsigned int numAttrs,bool copyStrings)
+{
+    FlatAttr *newAttrs = nullptr;
+    if (numAttrs > 0)
+    {
+        newAttrs = (FlatAttr *)arena->alloc(numAttrs * sizeof(FlatAttr),alignof(FlatAttr));
+        for (unsigned int ii=0;ii<numAttrs;ii++)
+        {
+            newAttrs[ii] = attrs[ii];
+            if (copyStrings && attrs[ii].type == DictTypeString)
+            {
+                const auto str = arena->internString(attrs[ii].getStringView());
+                newAttrs[ii].str = str.data();
+            }
+        }
+    }
+
+    return std::make_shared<FlatDictionary>(arena,newAttrs,numAttrs);
+}
+
+void FlatDictionary::AddAttr(std::vector<FlatAttr> &attrs,const FlatAttr &attr)
+{
+    for (auto it = attrs.begin(); it != attrs.end(); ++it)
+    {
+        if (it->key != attr.key)
+            continue;
+
+        // Same rules as MutableDictionaryC.  Strings replace, a type mismatch removes the key.
+        if (attr.type == DictTypeString || it->type == attr.type)
+            *it = attr;
+        else
+            attrs.erase(it);
+        return;
+    }
+
+    attrs.push_back(attr);
+}
+
+const FlatAttr *FlatDictionary::find(const std::string &name) const
+{
+    // A key nobody has interned can't be in here
+    StringIdentity key;
+    if (!StringIndexer::findStringID(name,key))
+        return nullptr;
+
+    return findAttr(key);
+}
+
+MutableDictionaryC &FlatDictionary::thaw()
+{
+    if (!thawed)
+    {
+        thawed = std::make_unique<MutableDictionaryC>(numAttrs);
+        for (unsigned int ii=0;ii<numAttrs;ii++)
+        {
+            const FlatAttr &attr = attrs[ii];
+            const std::string key = StringIndexer::getString(attr.key);
+            switch (attr.type)
+            {
+                case DictTypeInt:       thawed->setInt(key,attr.iVal);   break;
+                case DictTypeInt64:     thawed->setInt64(key,attr.i64Val);   break;
+                case DictTypeIdentity:  thawed->setIdentifiable(key,attr.i64Val);   break;
+                case DictTypeDouble:    thawed->setDouble(key,attr.dVal);   break;
+                case DictTypeString:    thawed->setString(key,std::string(attr.getStringView()));   break;
+                default:
+                    break;
+            }
+        }
+
+        // Don't need these anymore
+        attrs = nullptr;
+        numAttrs = 0;
+        arena.reset();
+    }
+
+    return *thawed;
+}
+
+MutableDictionaryRef FlatDictionary::copy() const
+{
+    if (thawed)
+        return thawed->copy();
+
+    // Copies can share the arena, but not somebody else's memory
+    if (arena)
+        return std::make_shared<FlatDictionary>(arena,attrs,numAttrs);
+
+    auto newArena = std::make_shared<AttrArena>();
+    return Make(newArena,attrs,numAttrs);
+}
+
+int FlatDictionary::count() const
+{
+    return thawed ? thawed->count() : (int)numAttrs;
+}
+
+bool FlatDictionary::hasField(const std::string &name) const
+{
+    if (thawed)
+        return thawed->hasField(name);
+
+    return find(name) != nullptr;
+}
+
+DictionaryType FlatDictionary::getType(const std::string &name) const
+{
+    if (thawed)
+        return thawed->getType(name);
+
+    const FlatAttr *attr = find(name);
+    return attr ? attr->type : DictTypeNone;
+}
+
+int FlatDictionary::getInt(const std::string &name,int defVal) const
+{
+    if (thawed)
+        return thawed->getInt(name,defVal);
+
+    const FlatAttr *attr = find(name);
+    if (!attr)
+        return defVal;
+
+    switch (attr->type) {
+        case DictTypeInt:     return attr->iVal;
+        case DictTypeInt64:   return (int)attr->i64Val;
+        case DictTypeDouble:  return (int)attr->dVal;
+        default:
+            wkLogLevel(Warn, "Unsupported conversion from type %d to int", attr->type);
+            return defVal;
+    }
+}
+
+SimpleIdentity FlatDictionary::getIdentity(const std::string &name) const
+{
+    if (thawed)
+        return thawed->getIdentity(name);
+
+    const FlatAttr *attr = find(name);
+    if (!attr)
+        return EmptyIdentity;
+
+    switch (attr->type) {
+        case DictTypeInt:            return attr->iVal;
+        case DictTypeInt64:
+        case DictTypeIdentity:       return attr->i64Val;
+        case DictTypeDouble:         return (SimpleIdentity)attr->dVal;
+        default:
+            wkLogLevel(Warn, "Unsupported conversion from type %d to identity", attr->type);
+            return EmptyIdentity;
+    }
+}
+
+int64_t FlatDictionary::getInt64(const std::string &name,int64_t defVal) const
+{
+    if (thawed)
+        return thawed->getInt64(name,defVal);
+
+    const FlatAttr *attr = find(name);
+    if (!attr)
+        return defVal;
+
+    switch (attr->type) {
+        case DictTypeInt:      return attr->iVal;
+        case DictTypeInt64:
+        case DictTypeIdentity: return attr->i64Val;
+        case DictTypeDouble:   return (int64_t)attr->dVal;
+        default:
+            wkLogLevel(Warn, "Unsupported conversion from type %d to int64", attr->type);
+            return defVal;
+    }
+}
+
+bool FlatDictionary::getBool(const std::string &name,bool defVal) const
+{
+    if (thawed)
+        return thawed->getBool(name,defVal);
+
+    const FlatAttr *attr = find(name);
+    if (!attr)
+        return defVal;
+
+    switch (attr->type) {
+        case DictTypeInt:   return attr->iVal != 0;
+        case DictTypeInt64: return attr->i64Val != 0;
+        default:
+            wkLogLevel(Warn, "Unsupported conversion from type %d to bool", attr->type);
+            return defVal;
+    }
+}
+
+RGBAColor FlatDictionary::getColor(const std::string &name,const RGBAColor &defVal) const
+{
+    if (thawed)
+        return thawed->getColor(name,defVal);
+
+    const FlatAttr *attr = find(name);
+    if (!attr)
+        return defVal;
+
+    switch (attr->type)
+    {
+        case DictTypeString:
+        {
+            // We're looking for #RRGGBBAA, #RRGGBB, #RGBA, or #RGB
+            const std::string str(attr->getStringView());
+            if (str.length() < 4 || str[0] != '#')
+                return defVal;
+
+            return parseColor(&str.c_str()[1], defVal);
+        }
+        case DictTypeInt:
+            return ARGBtoRGBAColor(attr->iVal);
+        default:
+            wkLogLevel(Warn, "Unsupported conversion from type %d to color", attr->type);
+            return defVal;
+    }
+}
+
+double FlatDictionary::getDouble(const std::string &name,double defVal) const
+{
+    if (thawed)
+        return thawed->getDouble(name,defVal);
+
+    const FlatAttr *attr = find(name);
+    if (!attr)
+        return defVal;
+
+    switch (attr->type) {
+        case DictTypeInt:      return attr->iVal;
+        case DictTypeInt64:
+        case DictTypeIdentity: return attr->i64Val;
+        case DictTypeDouble:   return attr->dVal;
+        default:
+            wkLogLevel(Warn, "Unsupported conversion from type %d to double", attr->type);
+            return defVal;
+    }
+}
+
+std::string FlatDictionary::getString(const std::string &name) const
+{
+    return getString(name, std::string());
+}
+
+std::string FlatDictionary::getString(const std::string &name,const std::string &defVal) const
+{
+    if (thawed)
+        return thawed->getString(name,defVal);
+
+    const FlatAttr *attr = find(name);
+    if (!attr)
+        return defVal;
+
+    switch (attr->type)
+    {
+        case DictTypeString:   return std::string(attr->getStringView());
+        case DictTypeInt:      return std::to_string(attr->iVal);
+        case DictTypeInt64:
+        case DictTypeIdentity: return std::to_string(attr->i64Val);
+        case DictTypeDouble:   return std::to_string(attr->dVal);
+        default:
+            wkLogLevel(Warn, "Unsupported conversion from type %d to string", attr->type);
+            return defVal;
+    }
+}
+
+DictionaryRef FlatDictionary::getDict(const std::string &name) const
+{
+    if (thawed)
+        return thawed->getDict(name);
+
+    // Flat dictionaries don't hold sub-dictionaries, so anything we find is the wrong type
+    if (const FlatAttr *attr = find(name))
+        wkLogLevel(Warn, "Unsupported conversion from type %d to dictionary", attr->type);
+    else
+        wkLogLevel(Warn, "Missing key %s", name.c_str());
+    return DictionaryRef();
+}
+
+DictionaryEntryRef FlatDictionary::getEntry(const std::string &name) const
+{
+    if (thawed)
+        return thawed->getEntry(name);
+
+    const FlatAttr *attr = find(name);
+    if (!attr)
+        return DictionaryEntryRef();
+
+    switch (attr->type) {
+        case DictTypeInt:        return std::make_shared<DictionaryEntryCBasic>(attr->iVal);
+        case DictTypeIdentity:
+        case DictTypeInt64:      return std::make_shared<DictionaryEntryCBasic>(attr->i64Val);
+        case DictTypeDouble:     return std::make_shared<DictionaryEntryCBasic>(attr->dVal);
+        case DictTypeString:     return std::make_shared<DictionaryEntryCString>(std::string(attr->getStringView()));
+        default:
+            wkLogLevel(Warn, "Unsupported conversion from type %d to entry", attr->type);
+            return DictionaryEntryRef();
+    }
+}
+
+std::vector<DictionaryEntryRef> FlatDictionary::getArray(const std::string &name) const
+{
+    if (thawed)
+        return thawed->getArray(name);
+
+    return std::vector<DictionaryEntryRef>();
+}
+
+std::vector<std::string> FlatDictionary::getKeys() const
+{
+    if (thawed)
+        return thawed->getKeys();
+
+    std::vector<std::string> keys;
+    keys.reserve(numAttrs);
+    for (unsigned int ii=0;ii<numAttrs;ii++)
+        keys.push_back(StringIndexer::getString(attrs[ii].key));
+
+    return keys;
+}
+
+void FlatDictionary::clear()
+{
+    thaw().clear();
+}
+
+void FlatDictionary::removeField(const std::string &name)
+{
+    thaw().removeField(name);
+}
+
+void FlatDictionary::setInt(const std::string &name,int val)
+{
+    thaw().setInt(name,val);
+}
+
+void FlatDictionary::setInt64(const std::string &name,int64_t val)
+{
+    thaw().setInt64(name,val);
+}
+
+void FlatDictionary::setIdentifiable(const std::string &name,SimpleIdentity val)
+{
+    thaw().setIdentifiable(name,val);
+}
+
+void FlatDictionary::setDouble(const std::string &name,double val)
+{
+    thaw().setDouble(name,val);
+}
+
+void FlatDictionary::setString(const std::string &name,const std::string &val)
+{
+    thaw().setString(name,val);
+}
+
+void FlatDictionary::addEntries(const Dictionary *other)
+{
+    thaw().addEntries(other);
+}
+
+}
@@ -16,6 +16,7 @@
  *  limitations under the License.
  */
 
+#import <algorithm>
 #import "FlatMath.h"
 #import "GlobeMath.h"
 
@@ -43,6 +44,22 @@ Point3d PlateCarreeCoordSystem::geocentricToLocal(Point3d geocPt) const
     return GeoCoordSystem::GeocentricToLocal(geocPt);
 }
     
+void PlateCarreeCoordSystem::geographicToLocal(const Point2d *geo,Point3d *local,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        local[ii] = Point3d(geo[ii].x(),geo[ii].y(),0.0);
+}
+
+void PlateCarreeCoordSystem::localToGeocentric(const Point3d *local,Point3d *geoc,size_t count) const
+{
+    GeoCoordSystem::LocalToGeocentric(local,geoc,count);
+}
+
+void PlateCarreeCoordSystem::geocentricToLocal(const Point3d *geoc,Point3d *local,size_t count) const
+{
+    GeoCoordSystem::GeocentricToLocal(geoc,local,count);
+}
+    
 bool PlateCarreeCoordSystem::isSameAs(CoordSystem *coordSys) const
 {
     const auto other = dynamic_cast<PlateCarreeCoordSystem *>(coordSys);
@@ -116,6 +133,16 @@ Point3d FlatEarthCoordSystem::geographicToLocal(Point2d geo) const
     return pt;
 }
 
+void FlatEarthCoordSystem::geographicToLocal(const Point2d *geo,Point3d *local,size_t count) const
+{
+    const double scaleX = converge * MetersPerRadian;
+    for (size_t ii=0;ii<count;ii++)
+    {
+        const Point2d &pt = geo[ii];
+        local[ii] = Point3d((pt.x() - origin.lon()) * scaleX,(pt.y() - origin.lat()) * MetersPerRadian,0.0);
+    }
+}
+
 /// Convert from local coordinates to WGS84 geocentric
 Point3f FlatEarthCoordSystem::localToGeocentric(Point3f localPt) const
 {
@@ -129,6 +156,17 @@ Point3d FlatEarthCoordSystem::localToGeocentric(Point3d localPt) const
     return GeoCoordSystem::LocalToGeocentric(Point3d(geoCoord.x(),geoCoord.y(),localPt.z()));
 }
     
+void FlatEarthCoordSystem::localToGeocentric(const Point3d *local,Point3d *geoc,size_t count) const
+{
+    const double scaleX = MetersPerRadian * converge;
+    for (size_t ii=0;ii<count;ii++)
+    {
+        const Point3d &pt = local[ii];
+        geoc[ii] = Point3d(pt.x() / scaleX + origin.lon(),pt.y() / MetersPerRadian + origin.lat(),pt.z());
+    }
+    GeoCoordSystem::LocalToGeocentric(geoc,geoc,count);
+}
+    
 /// Convert from WGS84 geocentric to local coordinates
 Point3f FlatEarthCoordSystem::geocentricToLocal(Point3f geocPt) const
 {
@@ -144,6 +182,18 @@ Point3d FlatEarthCoordSystem::geocentricToLocal(Point3d geocPt) const
     return Point3d(localPt.x(),localPt.y(),geoCoordPlus.z());
 }
     
+void FlatEarthCoordSystem::geocentricToLocal(const Point3d *geoc,Point3d *local,size_t count) const
+{
+    GeoCoordSystem::GeocentricToLocal(geoc,local,count);
+    const double scaleX = converge * MetersPerRadian;
+    for (size_t ii=0;ii<count;ii++)
+    {
+        Point3d &pt = local[ii];
+        pt.x() = (pt.x() - origin.lon()) * scaleX;
+        pt.y() = (pt.y() - origin.lat()) * MetersPerRadian;
+    }
+}
+    
 bool FlatEarthCoordSystem::isSameAs(CoordSystem *coordSys) const
 {
     const auto other = dynamic_cast<FlatEarthCoordSystem *>(coordSys);
@@ -207,6 +257,24 @@ Point3d PassThroughCoordSystem::geographicToLocal(Point2d geo) const
     return pt;
 }
 
+void PassThroughCoordSystem::geographicToLocal(const Point2d *geo,Point3d *local,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        local[ii] = Point3d(geo[ii].x(),geo[ii].y(),0.0);
+}
+
+void PassThroughCoordSystem::localToGeocentric(const Point3d *local,Point3d *geoc,size_t count) const
+{
+    if (geoc != local)
+        std::copy(local,local+count,geoc);
+}
+
+void PassThroughCoordSystem::geocentricToLocal(const Point3d *geoc,Point3d *local,size_t count) const
+{
+    if (geoc != local)
+        std::copy(geoc,geoc+count,local);
+}
+
 bool PassThroughCoordSystem::isSameAs(CoordSystem *coordSys) const
 {
     const auto other = dynamic_cast<PassThroughCoordSystem *>(coordSys);
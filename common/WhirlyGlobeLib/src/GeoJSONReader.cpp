@@ -0,0 +1,831 @@
+/*
+ *  GeoJSONReader.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include <thread>
+#include <string.h>
+#include <stdlib.h>
+#import "GeoJSONReader.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+// Deeper than this and it's not GeoJSON we can use
+static const size_t MaxNestingDepth = 64;
+
+static const double Pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline bool IsSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Append a code point as UTF-8
+static void AppendUTF8(std::string &str,uint32_t cp)
+{
+    if (cp < 0x80)
+        str += (char)cp;
+    else if (cp < 0x800)
+    {
+        str += (char)(0xC0 | (cp >> 6));
+        str += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000)
+    {
+        str += (char)(0xE0 | (cp >> 12));
+        str += (char)(0x80 | ((cp >> 6) & 0x3F));
+        str += (char)(0x80 | (cp & 0x3F));
+    } else {
+        str += (char)(0xF0 | (cp >> 18));
+        str += (char)(0x80 | ((cp >> 12) & 0x3F));
+        str += (char)(0x80 | ((cp >> 6) & 0x3F));
+        str += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+static bool ParseHex4(const char *ptr,uint32_t &val)
+{
+    val = 0;
+    for (int ii=0;ii<4;ii++)
+    {
+        const char c = ptr[ii];
+        val <<= 4;
+        if (c >= '0' && c <= '9')
+            val |= c - '0';
+        else if (c >= 'a' && c <= 'f')
+            val |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            val |= c - 'A' + 10;
+        else
+            return false;
+    }
+    return true;
+}
+
+void GeoJSONReader::Coords::clear()
+{
+    pts.clear();
+    childEnds.clear();
+    grandEnds.clear();
+    childGrandEnds.clear();
+    rootIsPosition = false;
+    childIsPosition = false;
+}
+
+GeoJSONReader::GeoJSONReader()
+: start(nullptr), ptr(nullptr), end(nullptr)
+{
+}
+
+bool GeoJSONReader::fail(const char *what)
+{
+    // Keep the innermost problem, it's the useful one
+    if (error.empty())
+        error = std::string(what) + " at offset " + std::to_string(ptr - start);
+    return false;
+}
+
+void GeoJSONReader::skipSpace()
+{
+    while (ptr < end && IsSpace(*ptr))
+        ptr++;
+}
+
+bool GeoJSONReader::expect(char c)
+{
+    skipSpace();
+    if (ptr >= end || *ptr != c)
+        return false;
+    ptr++;
+    return true;
+}
+
+bool GeoJSONReader::parseString(std::string &str)
+{
+    skipSpace();
+    if (ptr >= end || *ptr != '"')
+        return fail("Expecting a string");
+    ptr++;
+
+    // Most strings don't have escapes, so just copy them
+    const char *strStart = ptr;
+    while (ptr < end && *ptr != '"' && *ptr != '\\')
+        ptr++;
+    if (ptr >= end)
+        return fail("Unterminated string");
+    str.assign(strStart, ptr - strStart);
+    if (*ptr == '"')
+    {
+        ptr++;
+        return true;
+    }
+
+    while (ptr < end)
+    {
+        const char c = *ptr++;
+        if (c == '"')
+            return true;
+        if (c != '\\')
+        {
+            str += c;
+            continue;
+        }
+        if (ptr >= end)
+            break;
+        switch (*ptr++)
+        {
+            case '"': str += '"'; break;
+            case '\\': str += '\\'; break;
+            case '/': str += '/'; break;
+            case 'b': str += '\b'; break;
+            case 'f': str += '\f'; break;
+            case 'n': str += '\n'; break;
+            case 'r': str += '\r'; break;
+            case 't': str += '\t'; break;
+            case 'u':
+            {
+                uint32_t cp;
+                if (end - ptr < 4 || !ParseHex4(ptr, cp))
+                    return fail("Bad unicode escape");
+                ptr += 4;
+                // Surrogate pair
+                if (cp >= 0xD800 && cp <= 0xDBFF && end - ptr >= 6 && ptr[0] == '\\' && ptr[1] == 'u')
+                {
+                    uint32_t low;
+                    if (ParseHex4(ptr+2, low) && low >= 0xDC00 && low <= 0xDFFF)
+                    {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        ptr += 6;
+                    }
+                }
+                AppendUTF8(str, cp);
+            }
+                break;
+            default:
+                return fail("Bad escape in string");
+        }
+    }
+
+    return fail("Unterminated string");
+}
+
+bool GeoJSONReader::parseNumber(double &val)
+{
+    skipSpace();
+    const char *numStart = ptr;
+    bool neg = false;
+    if (ptr < end && *ptr == '-')
+    {
+        neg = true;
+        ptr++;
+    }
+    if (ptr >= end || !IsDigit(*ptr))
+        return fail("Expecting a number");
+
+    // Collect up to 19 digits of mantissa and a power of ten
+    uint64_t mant = 0;
+    int exp10 = 0;
+    bool truncated = false;
+    for (;ptr < end && IsDigit(*ptr);ptr++)
+    {
+        if (mant < 1000000000000000000ULL)
+            mant = mant * 10 + (*ptr - '0');
+        else {
+            truncated |= *ptr != '0';
+            exp10++;
+        }
+    }
+    if (ptr < end && *ptr == '.')
+    {
+        ptr++;
+        if (ptr >= end || !IsDigit(*ptr))
+            return fail("Bad number");
+        for (;ptr < end && IsDigit(*ptr);ptr++)
+        {
+            if (mant < 1000000000000000000ULL)
+            {
+                mant = mant * 10 + (*ptr - '0');
+                exp10--;
+            } else
+                truncated |= *ptr != '0';
+        }
+    }
+    if (ptr < end && (*ptr == 'e' || *ptr == 'E'))
+    {
+        ptr++;
+        bool expNeg = false;
+        if (ptr < end && (*ptr == '-' || *ptr == '+'))
+            expNeg = *ptr++ == '-';
+        if (ptr >= end || !IsDigit(*ptr))
+            return fail("Bad number");
+        int exp = 0;
+        for (;ptr < end && IsDigit(*ptr);ptr++)
+            if (exp < 10000)
+                exp = exp * 10 + (*ptr - '0');
+        exp10 += expNeg ? -exp : exp;
+    }
+
+    // Exact when both the mantissa and the power of ten are exact doubles
+    if (!truncated && mant <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22)
+    {
+        double dVal = (double)mant;
+        dVal = exp10 < 0 ? dVal / Pow10[-exp10] : dVal * Pow10[exp10];
+        val = neg ? -dVal : dVal;
+        return true;
+    }
+
+    // Let the C library deal with the hard ones
+    const std::string numStr(numStart, ptr - numStart);
+    val = strtod(numStr.c_str(), nullptr);
+
+    return true;
+}
+
+bool GeoJSONReader::parseLiteral(const char *lit,size_t litLen)
+{
+    if ((size_t)(end - ptr) < litLen || strncmp(ptr, lit, litLen) != 0)
+        return fail("Unexpected characters");
+    ptr += litLen;
+    return true;
+}
+
+bool GeoJSONReader::skipValue()
+{
+    skipSpace();
+    if (ptr >= end)
+        return fail("Unexpected end of data");
+
+    switch (*ptr)
+    {
+        case '"':
+            return parseString(strVal);
+        case 't':
+            return parseLiteral("true", 4);
+        case 'f':
+            return parseLiteral("false", 5);
+        case 'n':
+            return parseLiteral("null", 4);
+        case '{':
+        case '[':
+        {
+            // We don't care what's in here, so just match up the brackets
+            int nest = 0;
+            while (ptr < end)
+            {
+                const char c = *ptr++;
+                if (c == '"')
+                {
+                    while (ptr < end && *ptr != '"')
+                        ptr += *ptr == '\\' ? 2 : 1;
+                    if (ptr >= end)
+                        break;
+                    ptr++;
+                } else if (c == '{' || c == '[')
+                    nest++;
+                else if (c == '}' || c == ']')
+                {
+                    if (--nest == 0)
+                        return true;
+                }
+            }
+            return fail("Unterminated object or array");
+        }
+        default:
+        {
+            double val;
+            return parseNumber(val);
+        }
+    }
+}
+
+// Next thing is either a comma and more entries or the closing bracket
+#define NEXT_OR_CLOSE(close) \
+    skipSpace(); \
+    if (ptr < end && *ptr == ',') { ptr++; continue; } \
+    if (ptr < end && *ptr == close) { ptr++; break; } \
+    return fail("Expecting , or " #close);
+
+bool GeoJSONReader::parseCoordArray(Coords &coords,size_t depth)
+{
+    if (depth > MaxNestingDepth)
+        return fail("Coordinates nested too deeply");
+
+    skipSpace();
+    if (ptr < end && *ptr == ']')
+    {
+        ptr++;
+        return true;
+    }
+    if (ptr >= end)
+        return fail("Unexpected end of data");
+
+    if (*ptr == '-' || IsDigit(*ptr))
+    {
+        // A position.  There might be a Z value or other junk, but we just want the first two.
+        // The exception is a bare list of numbers, which we take in pairs.
+        if (depth == 0)
+            coords.rootIsPosition = true;
+        else if (depth == 1)
+            coords.childIsPosition = true;
+        int num = 0;
+        double lon = 0.0;
+        while (true)
+        {
+            if (depth == 0 || num < 2)
+            {
+                double val;
+                if (!parseNumber(val))
+                    return false;
+                if (num % 2 == 0)
+                    lon = val;
+                else
+                    coords.pts.push_back(GeoCoord::CoordFromDegrees((float)lon,(float)val));
+            } else if (!skipValue())
+                return false;
+            num++;
+            NEXT_OR_CLOSE(']')
+        }
+        if (num < 2)
+            return fail("Position needs two coordinates");
+
+        return true;
+    }
+
+    while (true)
+    {
+        if (!expect('['))
+            return fail("Expecting an array in coordinates");
+        if (!parseCoordArray(coords, depth+1))
+            return false;
+
+        // Note where each entry ends so we can carve them up once we know the type
+        if (depth == 0)
+        {
+            coords.childEnds.push_back(coords.pts.size());
+            coords.childGrandEnds.push_back(coords.grandEnds.size());
+        } else if (depth == 1)
+            coords.grandEnds.push_back(coords.pts.size());
+        NEXT_OR_CLOSE(']')
+    }
+
+    return true;
+}
+
+bool GeoJSONReader::parseCoordinates(Coords &coords)
+{
+    coords.clear();
+    if (!expect('['))
+        return fail("Expecting coordinates array");
+
+    return parseCoordArray(coords, 0);
+}
+
+bool GeoJSONReader::buildGeometry(const std::string &type,const Coords &coords,ShapeSet &shapes)
+{
+    if (type == "Point" || type == "MultiPoint")
+    {
+        VectorPointsRef pts = VectorPoints::createPoints();
+        pts->pts.assign(coords.pts.begin(), coords.pts.end());
+        pts->initGeoMbr();
+        shapes.insert(pts);
+    } else if (type == "LineString")
+    {
+        VectorLinearRef lin = VectorLinear::createLinear();
+        lin->pts.assign(coords.pts.begin(), coords.pts.end());
+        lin->initGeoMbr();
+        shapes.insert(lin);
+    } else if (type == "Polygon")
+    {
+        // Array of arrays of coordinates
+        if (coords.rootIsPosition)
+            return fail("Expecting an array of loops in Polygon");
+        VectorArealRef ar = VectorAreal::createAreal();
+        ar->loops.resize(coords.childEnds.size());
+        uint32_t start = 0;
+        for (unsigned int ii=0;ii<coords.childEnds.size();ii++)
+        {
+            ar->loops[ii].assign(coords.pts.begin() + start, coords.pts.begin() + coords.childEnds[ii]);
+            start = coords.childEnds[ii];
+        }
+        ar->initGeoMbr();
+        shapes.insert(ar);
+    } else if (type == "MultiLineString")
+    {
+        if (coords.rootIsPosition)
+            return fail("Expecting an array of lines in MultiLineString");
+        uint32_t start = 0;
+        for (uint32_t childEnd : coords.childEnds)
+        {
+            VectorLinearRef lin = VectorLinear::createLinear();
+            lin->pts.assign(coords.pts.begin() + start, coords.pts.begin() + childEnd);
+            lin->initGeoMbr();
+            shapes.insert(lin);
+            start = childEnd;
+        }
+    } else if (type == "MultiPolygon")
+    {
+        if (coords.rootIsPosition || coords.childIsPosition)
+            return fail("Expecting an array of polygons in MultiPolygon");
+        uint32_t whichGrand = 0;
+        uint32_t start = 0;
+        for (uint32_t grandEnd : coords.childGrandEnds)
+        {
+            VectorArealRef ar = VectorAreal::createAreal();
+            ar->loops.resize(grandEnd - whichGrand);
+            for (auto &loop : ar->loops)
+            {
+                const uint32_t loopEnd = coords.grandEnds[whichGrand++];
+                loop.assign(coords.pts.begin() + start, coords.pts.begin() + loopEnd);
+                start = loopEnd;
+            }
+            ar->initGeoMbr();
+            shapes.insert(ar);
+        }
+    } else
+        return fail("Unknown geometry type");
+
+    return true;
+}
+
+bool GeoJSONReader::parseProperties(MutableDictionaryRef &dict)
+{
+    dict = MutableDictionaryMake();
+
+    skipSpace();
+    if (ptr >= end || *ptr != '{')
+        // Not an object, so nothing to add
+        return skipValue();
+    ptr++;
+    skipSpace();
+    if (ptr < end && *ptr == '}')
+    {
+        ptr++;
+        return true;
+    }
+
+    while (true)
+    {
+        if (!parseString(key) || !expect(':'))
+            return fail("Expecting a property name");
+        skipSpace();
+        if (ptr >= end)
+            return fail("Unexpected end of data");
+
+        // We only keep strings, numbers and booleans
+        switch (*ptr)
+        {
+            case '"':
+                if (!parseString(strVal))
+                    return false;
+                if (!key.empty())
+                    dict->setString(key, strVal);
+                break;
+            case 't':
+            case 'f':
+            {
+                const bool val = *ptr == 't';
+                if (!(val ? parseLiteral("true", 4) : parseLiteral("false", 5)))
+                    return false;
+                if (!key.empty())
+                    dict->setInt(key, (int)val);
+            }
+                break;
+            case '-':
+            case '0': case '1': case '2': case '3': case '4':
+            case '5': case '6': case '7': case '8': case '9':
+            {
+                double val;
+                if (!parseNumber(val))
+                    return false;
+                if (!key.empty())
+                    dict->setDouble(key, val);
+            }
+                break;
+            default:
+                if (!skipValue())
+                    return false;
+                break;
+        }
+        NEXT_OR_CLOSE('}')
+    }
+
+    return true;
+}
+
+bool GeoJSONReader::parseCRS(std::string &crs)
+{
+    skipSpace();
+    if (ptr >= end || *ptr != '{')
+        return skipValue();
+    ptr++;
+
+    // Looking for {"type": "name", "properties": {"name": ...}}
+    std::string type,name;
+    skipSpace();
+    if (ptr < end && *ptr == '}')
+    {
+        ptr++;
+        return true;
+    }
+    while (true)
+    {
+        if (!parseString(key) || !expect(':'))
+            return fail("Expecting a name in crs");
+        skipSpace();
+        if (key == "type" && ptr < end && *ptr == '"')
+        {
+            if (!parseString(type))
+                return false;
+        } else if (key == "properties" && ptr < end && *ptr == '{')
+        {
+            ptr++;
+            skipSpace();
+            if (ptr < end && *ptr == '}')
+                ptr++;
+            else
+                while (true)
+                {
+                    if (!parseString(key) || !expect(':'))
+                        return fail("Expecting a name in crs");
+                    skipSpace();
+                    if (key == "name" && ptr < end && *ptr == '"')
+                    {
+                        if (!parseString(name))
+                            return false;
+                    } else if (!skipValue())
+                        return false;
+                    NEXT_OR_CLOSE('}')
+                }
+        } else if (!skipValue())
+            return false;
+        NEXT_OR_CLOSE('}')
+    }
+
+    if (type == "name" && !name.empty())
+        crs = name;
+
+    return true;
+}
+
+bool GeoJSONReader::parseObject(ShapeSet &shapes,ObjectLevel level,size_t depth,std::string *crs)
+{
+    if (depth > MaxNestingDepth)
+        return fail("Objects nested too deeply");
+    if (!expect('{'))
+        return fail("Expecting an object");
+    if (coordStack.size() <= depth)
+        coordStack.resize(depth+1);
+
+    // Keys can come in any order, so we hang on to what we find until the end
+    std::string type;
+    bool hasType = false, hasCoords = false, hasGeom = false, hasGeoms = false, hasFeatures = false;
+    ShapeSet geomShapes;
+    MutableDictionaryRef props;
+
+    skipSpace();
+    if (ptr < end && *ptr == '}')
+        ptr++;
+    else
+        while (true)
+        {
+            if (!parseString(key) || !expect(':'))
+                return fail("Expecting a name");
+            skipSpace();
+            if (ptr >= end)
+                return fail("Unexpected end of data");
+
+            if (key == "type" && *ptr == '"')
+            {
+                if (!parseString(type))
+                    return false;
+                hasType = true;
+            } else if (key == "coordinates")
+            {
+                if (!parseCoordinates(coordStack[depth]))
+                    return false;
+                hasCoords = true;
+            } else if (key == "geometry" && level != GeometryLevel && *ptr == '{')
+            {
+                if (!parseObject(geomShapes, GeometryLevel, depth+1, nullptr))
+                    return false;
+                hasGeom = true;
+            } else if (key == "geometries" && *ptr == '[')
+            {
+                ptr++;
+                skipSpace();
+                if (ptr < end && *ptr == ']')
+                    ptr++;
+                else
+                    while (true)
+                    {
+                        if (!parseObject(geomShapes, GeometryLevel, depth+1, nullptr))
+                            return false;
+                        NEXT_OR_CLOSE(']')
+                    }
+                hasGeoms = true;
+            } else if (key == "features" && level == TopLevel && *ptr == '[')
+            {
+                // Features go right into the output as we find them
+                ptr++;
+                skipSpace();
+                if (ptr < end && *ptr == ']')
+                    ptr++;
+                else
+                    while (true)
+                    {
+                        if (!parseObject(shapes, FeatureLevel, depth+1, nullptr))
+                            return false;
+                        NEXT_OR_CLOSE(']')
+                    }
+                hasFeatures = true;
+            } else if (key == "properties" && level != GeometryLevel)
+            {
+                if (!parseProperties(props))
+                    return false;
+            } else if (key == "crs" && crs)
+            {
+                if (!parseCRS(*crs))
+                    return false;
+            } else if (!skipValue())
+                return false;
+
+            NEXT_OR_CLOSE('}')
+        }
+
+    bool isFeature = level == FeatureLevel;
+    if (level == TopLevel)
+    {
+        if (!hasType)
+            return fail("Missing type");
+        if (type == "FeatureCollection")
+            return hasFeatures ? true : fail("Missing features");
+        isFeature = type == "Feature";
+    }
+
+    if (isFeature)
+    {
+        if (!hasGeom)
+            return fail("Feature is missing geometry");
+        // Properties are optional
+        if (props)
+            for (const auto &shape : geomShapes)
+                shape->setAttrDict(props);
+        shapes.insert(geomShapes.begin(), geomShapes.end());
+
+        return true;
+    }
+
+    // Geometry
+    if (!hasType)
+        return fail("Missing geometry type");
+    if (type == "GeometryCollection")
+    {
+        if (!hasGeoms)
+            return fail("Missing geometries");
+        shapes.insert(geomShapes.begin(), geomShapes.end());
+        return true;
+    }
+    if (!hasCoords)
+        return fail("Missing coordinates");
+
+    return buildGeometry(type, coordStack[depth], shapes);
+}
+
+bool GeoJSONReader::parse(const char *json,size_t len,ShapeSet &shapes,std::string &crs)
+{
+    start = ptr = json;
+    end = json + len;
+    error.clear();
+
+    // Skip a UTF-8 byte order mark
+    if (len >= 3 && !strncmp(ptr, "\xEF\xBB\xBF", 3))
+        ptr += 3;
+
+    std::string crsName;
+    if (!parseObject(shapes, TopLevel, 0, &crsName))
+        return false;
+    skipSpace();
+    if (ptr != end)
+        return fail("Unexpected data after the end");
+
+    if (!crsName.empty())
+        crs = crsName;
+
+    return true;
+}
+
+bool GeoJSONReader::parseLine(const char *line,size_t len,ShapeSet &shapes)
+{
+    start = ptr = line;
+    end = line + len;
+    error.clear();
+
+    // GeoJSON text sequences start each record with an RS
+    while (ptr < end && (IsSpace(*ptr) || *ptr == 0x1e))
+        ptr++;
+    if (ptr == end)
+        return true;
+
+    if (!parseObject(shapes, TopLevel, 0, nullptr))
+        return false;
+    skipSpace();
+    if (ptr != end)
+        return fail("Unexpected data after the end");
+
+    return true;
+}
+
+// Parse the lines in [json,end) into shapes
+static bool ParseLineChunk(const char *json,const char *end,ShapeSet &shapes,std::string &error)
+{
+    GeoJSONReader reader;
+    while (json < end)
+    {
+        const char *lineEnd = (const char *)memchr(json, '\n', end - json);
+        if (!lineEnd)
+            lineEnd = end;
+        if (!reader.parseLine(json, lineEnd - json, shapes))
+        {
+            error = reader.getError();
+            return false;
+        }
+        json = lineEnd + 1;
+    }
+
+    return true;
+}
+
+bool GeoJSONReader::ParseLines(const char *json,size_t len,ShapeSet &shapes,int numThreads)
+{
+    if (numThreads <= 0)
+        numThreads = std::max(1U, std::thread::hardware_concurrency());
+    // Not worth a thread for less than this
+    static const size_t MinChunkSize = 256*1024;
+    numThreads = std::max(1, std::min(numThreads, (int)(len / MinChunkSize)));
+
+    // Split on line boundaries into roughly equal chunks
+    const char *end = json + len;
+    std::vector<const char *> chunks(numThreads+1, end);
+    chunks[0] = json;
+    for (int ii=1;ii<numThreads;ii++)
+    {
+        const char *split = std::max(json + len * ii / numThreads, chunks[ii-1]);
+        const char *lineEnd = (const char *)memchr(split, '\n', end - split);
+        chunks[ii] = lineEnd ? lineEnd + 1 : end;
+    }
+
+    std::vector<ShapeSet> chunkShapes(numThreads);
+    std::vector<std::string> errors(numThreads);
+    std::vector<char> results(numThreads, false);
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads-1);
+    for (int ii=1;ii<numThreads;ii++)
+        threads.emplace_back([&,ii]{
+            results[ii] = ParseLineChunk(chunks[ii], chunks[ii+1], chunkShapes[ii], errors[ii]);
+        });
+    results[0] = ParseLineChunk(chunks[0], chunks[1], chunkShapes[0], errors[0]);
+    for (auto &thread : threads)
+        thread.join();
+
+    size_t numShapes = shapes.size();
+    for (int ii=0;ii<numThreads;ii++)
+    {
+        if (!results[ii])
+        {
+            wkLogLevel(Warn, "GeoJSONReader: Failed to parse line: %s", errors[ii].c_str());
+            return false;
+        }
+        numShapes += chunkShapes[ii].size();
+    }
+
+    shapes.reserve(numShapes);
+    for (const auto &theseShapes : chunkShapes)
+        shapes.insert(theseShapes.begin(), theseShapes.end());
+
+    return true;
+}
+
+}
@@ -173,7 +173,7 @@ void GeometryRaw::buildDrawables(std::vector<BasicDrawableBuilderRef> &draws,con
     {
         RawTriangle tri = triangles[ii];
         // See if we need a new drawable
-        if (!draw || draw->getNumPoints() + 3 > MaxDrawablePoints || draw->getNumTris() + 1 > MaxDrawableTriangles)
+        if (!draw || draw->getNumPoints() + 3 > sceneRender->getMaxDrawablePoints() || draw->getNumTris() + 1 > sceneRender->getMaxDrawableTriangles())
         {
             draw = sceneRender->makeBasicDrawableBuilder("Raw Geometry");
             if (geomInfo)
@@ -493,7 +493,7 @@ void GeometryRawPoints::buildDrawables(std::vector<BasicDrawableBuilderRef> &dra
     for (unsigned int vert=0;vert<numVals;vert++)
     {
         // See if we need a new drawable
-        if (!draw || draw->getNumPoints() + 3 > MaxDrawablePoints)
+        if (!draw || draw->getNumPoints() + 3 > sceneRender->getMaxDrawablePoints())
         {
             if (geomInfo) {
                 geomInfo->setupBasicDrawable(draw);
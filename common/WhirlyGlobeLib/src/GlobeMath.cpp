@@ -17,6 +17,7 @@
  */
 
 
+#import <algorithm>
 #import "GlobeMath.h"
 #import "FlatMath.h"
 #import "proj_api.h"
@@ -83,6 +84,37 @@ Point3d GeoCoordSystem::GeocentricToLocal(Point3d geocPt)
     return Point3d(x,y,z);
 }
 
+// Point3d is three packed doubles, which lets us hand a run of them straight to proj.4
+static_assert(sizeof(Point3d) == 3*sizeof(double), "Point3d must be packed for pj_transform");
+
+void GeoCoordSystem::LocalToGeocentric(const Point3d *localPts,Point3d *geocPts,size_t count)
+{
+    if (count == 0)
+        return;
+    InitProj4();
+
+    if (geocPts != localPts)
+        std::copy(localPts,localPts+count,geocPts);
+    pj_transform( pj_latlon, pj_geocentric, (long)count, 3, &geocPts[0].x(), &geocPts[0].y(), &geocPts[0].z() );
+}
+
+void GeoCoordSystem::GeocentricToLocal(const Point3d *geocPts,Point3d *localPts,size_t count)
+{
+    if (count == 0)
+        return;
+    InitProj4();
+
+    if (geocPts != localPts)
+        std::copy(geocPts,geocPts+count,localPts);
+    pj_transform( pj_geocentric, pj_latlon, (long)count, 3, &localPts[0].x(), &localPts[0].y(), &localPts[0].z() );
+}
+
+void GeoCoordSystem::geographicToLocal(const Point2d *geo,Point3d *local,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        local[ii] = Point3d(geo[ii].x(),geo[ii].y(),0.0);
+}
+
 Mbr GeoCoordSystem::GeographicMbrToLocal(GeoMbr geoMbr)
 {
     Mbr localMbr;
@@ -125,6 +157,22 @@ Point3d FakeGeocentricDisplayAdapter::LocalToDisplay(Point3d geoPt)
     return pt;
 }
 
+void FakeGeocentricDisplayAdapter::LocalToDisplay(const Point3d *geoPts,Point3d *dispPts,size_t count)
+{
+    for (size_t ii=0;ii<count;ii++)
+    {
+        const Point3d geoPt = geoPts[ii];
+        const double z = sin(geoPt.y());
+        const double rad = sqrt(1.0-z*z);
+        Point3d pt(rad*cos(geoPt.x()),rad*sin(geoPt.x()),z);
+        if (geoPt.z() != 0.0)
+        {
+            pt *= 1.0 + geoPt.z() / EarthRadius;
+        }
+        dispPts[ii] = pt;
+    }
+}
+
 Point3f FakeGeocentricDisplayAdapter::DisplayToLocal(Point3f pt)
 {
     pt.normalize();
@@ -166,6 +214,13 @@ Point3d GeocentricDisplayAdapter::LocalToDisplay(Point3d geoPt)
     return Point3d(geoCpt.x()/EarthRadius,geoCpt.y()/EarthRadius,geoCpt.z()/EarthRadius);
 }
 
+void GeocentricDisplayAdapter::LocalToDisplay(const Point3d *geoPts,Point3d *dispPts,size_t count)
+{
+    GeoCoordSystem::LocalToGeocentric(geoPts,dispPts,count);
+    for (size_t ii=0;ii<count;ii++)
+        dispPts[ii] /= EarthRadius;
+}
+
 Point3f GeocentricDisplayAdapter::DisplayToLocal(Point3f pt)
 {
     const Point3f geoCpt = pt * EarthRadius;
@@ -19,6 +19,12 @@
 #import "GridClipper.h"
 #import "clipper.hpp"
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#import <arm_neon.h>
+#elif defined(__SSE2__)
+#import <emmintrin.h>
+#endif
+
 namespace WhirlyKit
 {
     
@@ -49,6 +55,292 @@ OutCode ComputeOutCode(double x, double y, const Mbr &mbr)
     return code;
 }
     
+static bool ClipLoopsToMbrClipper(const VectorRing *rings,unsigned int numRings,const Mbr &mbr, bool closed,std::vector<VectorRing> &rets,double polyScale);
+
+// Outcodes for a run of points.  Four at a time where we've got SIMD.
+static void ComputeOutCodes(const float *xs,const float *ys,size_t numPts,
+                            float minX,float minY,float maxX,float maxY,
+                            int32_t *codes,int32_t &orCodes,int32_t &andCodes)
+{
+    size_t ii = 0;
+    int32_t orAll = 0, andAll = LEFT | RIGHT | BOTTOM | TOP;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (numPts >= 4)
+    {
+        const float32x4_t vMinX = vdupq_n_f32(minX), vMinY = vdupq_n_f32(minY);
+        const float32x4_t vMaxX = vdupq_n_f32(maxX), vMaxY = vdupq_n_f32(maxY);
+        uint32x4_t vOr = vdupq_n_u32(0), vAnd = vdupq_n_u32(andAll);
+        for (;ii+4<=numPts;ii+=4)
+        {
+            const float32x4_t x = vld1q_f32(&xs[ii]), y = vld1q_f32(&ys[ii]);
+            const uint32x4_t code = vorrq_u32(vorrq_u32(vandq_u32(vcltq_f32(x,vMinX),vdupq_n_u32(LEFT)),
+                                                        vandq_u32(vcgtq_f32(x,vMaxX),vdupq_n_u32(RIGHT))),
+                                              vorrq_u32(vandq_u32(vcltq_f32(y,vMinY),vdupq_n_u32(BOTTOM)),
+                                                        vandq_u32(vcgtq_f32(y,vMaxY),vdupq_n_u32(TOP))));
+            vst1q_s32(&codes[ii],vreinterpretq_s32_u32(code));
+            vOr = vorrq_u32(vOr,code);
+            vAnd = vandq_u32(vAnd,code);
+        }
+        uint32_t lanes[4];
+        vst1q_u32(lanes,vOr);
+        orAll |= lanes[0] | lanes[1] | lanes[2] | lanes[3];
+        vst1q_u32(lanes,vAnd);
+        andAll &= lanes[0] & lanes[1] & lanes[2] & lanes[3];
+    }
+#elif defined(__SSE2__)
+    if (numPts >= 4)
+    {
+        const __m128 vMinX = _mm_set1_ps(minX), vMinY = _mm_set1_ps(minY);
+        const __m128 vMaxX = _mm_set1_ps(maxX), vMaxY = _mm_set1_ps(maxY);
+        __m128i vOr = _mm_setzero_si128(), vAnd = _mm_set1_epi32(andAll);
+        for (;ii+4<=numPts;ii+=4)
+        {
+            const __m128 x = _mm_loadu_ps(&xs[ii]), y = _mm_loadu_ps(&ys[ii]);
+            const __m128i code = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(x,vMinX)),_mm_set1_epi32(LEFT)),
+                                                           _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(x,vMaxX)),_mm_set1_epi32(RIGHT))),
+                                              _mm_or_si128(_mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(y,vMinY)),_mm_set1_epi32(BOTTOM)),
+                                                           _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(y,vMaxY)),_mm_set1_epi32(TOP))));
+            _mm_storeu_si128((__m128i *)&codes[ii],code);
+            vOr = _mm_or_si128(vOr,code);
+            vAnd = _mm_and_si128(vAnd,code);
+        }
+        int32_t lanes[4];
+        _mm_storeu_si128((__m128i *)lanes,vOr);
+        orAll |= lanes[0] | lanes[1] | lanes[2] | lanes[3];
+        _mm_storeu_si128((__m128i *)lanes,vAnd);
+        andAll &= lanes[0] & lanes[1] & lanes[2] & lanes[3];
+    }
+#endif
+    for (;ii<numPts;ii++)
+    {
+        int32_t code = INSIDE;
+        if (xs[ii] < minX)
+            code |= LEFT;
+        else if (xs[ii] > maxX)
+            code |= RIGHT;
+        if (ys[ii] < minY)
+            code |= BOTTOM;
+        else if (ys[ii] > maxY)
+            code |= TOP;
+        codes[ii] = code;
+        orAll |= code;
+        andAll &= code;
+    }
+
+    orCodes = orAll;
+    andCodes = andAll;
+}
+
+// Does the segment pass through the inside of the box.  Liang-Barsky.
+static bool SegmentCrossesBox(double px,double py,double qx,double qy,double minX,double minY,double maxX,double maxY)
+{
+    const double dx = qx - px, dy = qy - py;
+    const double p[4] = {-dx, dx, -dy, dy};
+    const double q[4] = {px - minX, maxX - px, py - minY, maxY - py};
+    double t0 = 0.0, t1 = 1.0;
+    for (unsigned int ii=0;ii<4;ii++)
+    {
+        if (p[ii] == 0.0)
+        {
+            if (q[ii] < 0.0)
+                return false;
+        } else {
+            const double t = q[ii] / p[ii];
+            if (p[ii] < 0.0)
+                t0 = std::max(t0, t);
+            else
+                t1 = std::min(t1, t);
+        }
+    }
+
+    return t0 < t1;
+}
+
+// Clip the polygon against one side of the box
+static void ClipSide(const std::vector<float> &inX,const std::vector<float> &inY,
+                     std::vector<float> &outX,std::vector<float> &outY,
+                     bool alongX,bool keepAbove,float val)
+{
+    outX.clear();
+    outY.clear();
+    const size_t numPts = inX.size();
+    if (numPts == 0)
+        return;
+
+    const std::vector<float> &inA = alongX ? inX : inY;
+    float px = inX[numPts-1], py = inY[numPts-1];
+    bool pIn = keepAbove ? inA[numPts-1] >= val : inA[numPts-1] <= val;
+    for (size_t ii=0;ii<numPts;ii++)
+    {
+        const float cx = inX[ii], cy = inY[ii];
+        const bool cIn = keepAbove ? inA[ii] >= val : inA[ii] <= val;
+        if (cIn != pIn)
+        {
+            // Crossing point, right on the side
+            if (alongX)
+            {
+                const double t = ((double)val - px) / ((double)cx - px);
+                outX.push_back(val);
+                outY.push_back(py + t * ((double)cy - py));
+            } else {
+                const double t = ((double)val - py) / ((double)cy - py);
+                outX.push_back(px + t * ((double)cx - px));
+                outY.push_back(val);
+            }
+        }
+        if (cIn)
+        {
+            outX.push_back(cx);
+            outY.push_back(cy);
+        }
+        px = cx;  py = cy;  pIn = cIn;
+    }
+}
+
+RectClipper::RectClipper()
+: minX(0.0), minY(0.0), maxX(0.0), maxY(0.0)
+{
+}
+
+RectClipper::RingClass RectClipper::loadRing(const VectorRing &ring)
+{
+    xs.clear();
+    ys.clear();
+    size_t numPts = ring.size();
+    // Closing point is implied
+    if (numPts > 1 && ring[0] == ring[numPts-1])
+        numPts--;
+    for (size_t ii=0;ii<numPts;ii++)
+    {
+        xs.push_back(ring[ii].x());
+        ys.push_back(ring[ii].y());
+    }
+    if (numPts < 3)
+        return RingOutside;
+
+    codes.resize(numPts);
+    int32_t orCodes,andCodes;
+    ComputeOutCodes(xs.data(), ys.data(), numPts, minX, minY, maxX, maxY, codes.data(), orCodes, andCodes);
+    if (orCodes == INSIDE)
+        return RingInside;
+    if (andCodes != INSIDE)
+        return RingOutside;
+
+    // Count the times we come into the box.  More than once and the result may come apart.
+    int entries = 0;
+    for (size_t ii = 0, jj = numPts - 1; ii < numPts; jj = ii++)
+    {
+        const int32_t pCode = codes[jj], cCode = codes[ii];
+        if (pCode != INSIDE && cCode == INSIDE)
+            entries++;
+        else if (pCode != INSIDE && (pCode & cCode) == 0 &&
+                 SegmentCrossesBox(xs[jj], ys[jj], xs[ii], ys[ii], minX, minY, maxX, maxY))
+            entries++;
+    }
+    if (entries > 1)
+        return RingComplex;
+    if (entries == 1)
+        return RingCrosses;
+
+    // Everything's outside and nothing crosses.  Either we're around the box or off to the side.
+    const float cx = (minX + maxX) / 2.0, cy = (minY + maxY) / 2.0;
+    bool inside = false;
+    for (size_t ii = 0, jj = numPts - 1; ii < numPts; jj = ii++)
+    {
+        if (((ys[ii] > cy) != (ys[jj] > cy)) &&
+            (cx < ((double)xs[jj] - xs[ii]) * ((double)cy - ys[ii]) / ((double)ys[jj] - ys[ii]) + xs[ii]))
+            inside = !inside;
+    }
+
+    return inside ? RingContainsBox : RingOutside;
+}
+
+void RectClipper::clipRing()
+{
+    ClipSide(xs, ys, tmpX, tmpY, true, true, minX);
+    ClipSide(tmpX, tmpY, xs, ys, true, false, maxX);
+    ClipSide(xs, ys, tmpX, tmpY, false, true, minY);
+    ClipSide(tmpX, tmpY, xs, ys, false, false, maxY);
+}
+
+void RectClipper::emitRing(const std::vector<float> &ringX,const std::vector<float> &ringY,bool ccw,std::vector<VectorRing> &rets)
+{
+    VectorRing outRing;
+    outRing.reserve(ringX.size());
+    for (size_t ii=0;ii<ringX.size();ii++)
+    {
+        const Point2f pt(ringX[ii],ringY[ii]);
+        if (outRing.empty() || outRing.back() != pt)
+            outRing.push_back(pt);
+    }
+    while (outRing.size() > 1 && outRing.front() == outRing.back())
+        outRing.pop_back();
+    if (outRing.size() < 3)
+        return;
+
+    // Clipper doesn't return anything without area either
+    double area = 0.0;
+    for (size_t ii = 0, jj = outRing.size() - 1; ii < outRing.size(); jj = ii++)
+        area += ((double)outRing[jj].x() - outRing[ii].x()) * ((double)outRing[jj].y() + outRing[ii].y());
+    if (area == 0.0)
+        return;
+    if ((area > 0.0) != ccw)
+        std::reverse(outRing.begin(), outRing.end());
+
+    rets.push_back(std::move(outRing));
+}
+
+bool RectClipper::clipLoops(const VectorRing *rings,unsigned int numRings,const Mbr &mbr,std::vector<VectorRing> &rets,double polyScale)
+{
+    minX = mbr.ll().x();  minY = mbr.ll().y();
+    maxX = mbr.ur().x();  maxY = mbr.ur().y();
+
+    results.clear();
+    for (unsigned int ri=0;ri<numRings;ri++)
+    {
+        const bool isOuter = ri == 0;
+        switch (loadRing(rings[ri]))
+        {
+            case RingInside:
+                emitRing(xs, ys, isOuter, results);
+                break;
+            case RingOutside:
+                // The outer's gone, so the holes are too
+                if (isOuter)
+                    return true;
+                break;
+            case RingContainsBox:
+                // A hole around the box means there's nothing left
+                if (!isOuter)
+                {
+                    results.clear();
+                    return true;
+                }
+                tmpX = {minX, maxX, maxX, minX};
+                tmpY = {minY, minY, maxY, maxY};
+                emitRing(tmpX, tmpY, isOuter, results);
+                break;
+            case RingCrosses:
+                // Clipper would merge a hole cut by the box into the outer ring
+                if (!isOuter)
+                    return ClipLoopsToMbrClipper(rings, numRings, mbr, true, rets, polyScale);
+                clipRing();
+                emitRing(xs, ys, isOuter, results);
+                break;
+            case RingComplex:
+                // Might come apart into several pieces, which Clipper handles
+                return ClipLoopsToMbrClipper(rings, numRings, mbr, true, rets, polyScale);
+        }
+    }
+
+    for (auto &ring : results)
+        rets.push_back(std::move(ring));
+
+    return true;
+}
+
+static thread_local RectClipper rectClipper;
+
 // Clip the given loop to the given MBR
 bool ClipLoopToMbr(const VectorRing &ring,const Mbr &mbr, bool closed,std::vector<VectorRing> &rets,double polyScale)
 {
@@ -126,54 +418,22 @@ bool ClipLoopToMbr(const VectorRing &ring,const Mbr &mbr, bool closed,std::vecto
             rets.push_back(outRing);
     } else
     {
-        Path subject(ring.size());
-        for (unsigned int ii=0;ii<ring.size();ii++)
-        {
-            const Point2f &pt = ring[ii];
-            subject[ii] = IntPoint(pt.x()*polyScale,pt.y()*polyScale);
-        }
-        Path clip(4);
-        clip[0] = IntPoint(mbr.ll().x()*polyScale,mbr.ll().y()*polyScale);
-        clip[1] = IntPoint(mbr.ur().x()*polyScale,mbr.ll().y()*polyScale);
-        clip[2] = IntPoint(mbr.ur().x()*polyScale,mbr.ur().y()*polyScale);
-        clip[3] = IntPoint(mbr.ll().x()*polyScale,mbr.ur().y()*polyScale);
-        
-        Clipper c;
-        c.AddPath(subject, ptSubject, closed);
-        c.AddPath(clip, ptClip, true);
-        Paths solution;
-        if (!c.Execute(ctIntersection, solution))
-        {
-            return false;
-        }
-        
-        for (unsigned int ii=0;ii<solution.size();ii++)
-        {
-            Path &outPoly = solution[ii];
-            VectorRing outRing;
-            for (unsigned jj=0;jj<outPoly.size();jj++)
-            {
-                IntPoint &outPt = outPoly[jj];
-                outRing.push_back(Point2f(outPt.X/polyScale,outPt.Y/polyScale));
-            }
-            
-            if (outRing.size() > 2)
-                rets.push_back(outRing);
-        }
+        return rectClipper.clipLoops(&ring, 1, mbr, rets, polyScale);
     }
     return true;
 }
 
-// Clip the given loop to the given MBR
-bool ClipLoopsToMbr(const std::vector<VectorRing> &rings,const Mbr &mbr, bool closed,std::vector<VectorRing> &rets,double polyScale)
+// Clip a group of loops to the given MBR with Clipper
+static bool ClipLoopsToMbrClipper(const VectorRing *rings,unsigned int numRings,const Mbr &mbr, bool closed,std::vector<VectorRing> &rets,double polyScale)
 {
     if (polyScale == 0.0)
         polyScale = PolyScale;
 
     Clipper c;
     
-    for (const auto &ring: rings)
+    for (unsigned int ri=0;ri<numRings;ri++)
     {
+        const VectorRing &ring = rings[ri];
         Path subject(ring.size());
         for (unsigned int ii=0;ii<ring.size();ii++)
         {
@@ -213,6 +473,15 @@ bool ClipLoopsToMbr(const std::vector<VectorRing> &rings,const Mbr &mbr, bool cl
     return true;
 }
 
+// Clip the given loops to the given MBR
+bool ClipLoopsToMbr(const std::vector<VectorRing> &rings,const Mbr &mbr, bool closed,std::vector<VectorRing> &rets,double polyScale)
+{
+    if (!closed)
+        return ClipLoopsToMbrClipper(rings.data(), rings.size(), mbr, closed, rets, polyScale);
+
+    return rectClipper.clipLoops(rings.data(), rings.size(), mbr, rets, polyScale);
+}
+
 // Clip the given loop to the given grid (org and spacing)
 // Return true on success and the new polygons in the rets
 bool ClipLoopToGrid(const VectorRing &ring,Point2f org,Point2f spacing,std::vector<VectorRing> &rets)
@@ -226,14 +495,16 @@ bool ClipLoopToGrid(const VectorRing &ring,Point2f org,Point2f spacing,std::vect
     int ur_iy = (int)std::ceil((mbr.ur().y()-org.y())/spacing.y());
     
     // Clip in strips from left to right
+    RectClipper &clipper = rectClipper;
+    std::vector<VectorRing> leftStrip;
     for (int ix=ll_ix;ix<=ur_ix;ix++)
     {
         Point2f l0(ix*spacing.x()+org.x(),mbr.ll().y());
         Point2f l1((ix+1)*spacing.x()+org.x(),mbr.ur().y());
         Mbr left(l0,l1);
         
-        std::vector<VectorRing> leftStrip;
-        ClipLoopToMbr(ring,left, true, leftStrip);
+        leftStrip.clear();
+        clipper.clipLoops(&ring, 1, left, leftStrip);
         
         // Now clip the left strip vertically
         for (int iy=ll_iy;iy<=ur_iy;iy++)
@@ -243,7 +514,7 @@ bool ClipLoopToGrid(const VectorRing &ring,Point2f org,Point2f spacing,std::vect
             Point2f b1(mbr.ur().x(),(iy+1)*spacing.y()+org.y());
             Mbr bot(b0,b1);
             for (unsigned int ic=0;ic<leftStrip.size();ic++)
-                ClipLoopToMbr(leftStrip[ic], bot, true, rets);
+                clipper.clipLoops(&leftStrip[ic], 1, bot, rets);
         }
     }
     
@@ -269,14 +540,16 @@ bool ClipLoopsToGrid(const std::vector<VectorRing> &rings,Point2f org,Point2f sp
     int ur_iy = (int)std::ceil((mbr.ur().y()-org.y())/spacing.y());
     
     // Clip in strips from left to right
+    RectClipper &clipper = rectClipper;
+    std::vector<VectorRing> leftStrip;
     for (int ix=ll_ix;ix<=ur_ix;ix++)
     {
         Point2f l0(ix*spacing.x()+org.x(),mbr.ll().y());
         Point2f l1((ix+1)*spacing.x()+org.x(),mbr.ur().y());
         Mbr left(l0,l1);
         
-        std::vector<VectorRing> leftStrip;
-        ClipLoopsToMbr(rings,left, true, leftStrip);
+        leftStrip.clear();
+        clipper.clipLoops(rings.data(), rings.size(), left, leftStrip);
         
         // Now clip the left strip vertically
         for (int iy=ll_iy;iy<=ur_iy;iy++)
@@ -286,7 +559,7 @@ bool ClipLoopsToGrid(const std::vector<VectorRing> &rings,Point2f org,Point2f sp
             Point2f b1(mbr.ur().x(),(iy+1)*spacing.y()+org.y());
             Mbr bot(b0,b1);
             for (unsigned int ic=0;ic<leftStrip.size();ic++)
-                ClipLoopToMbr(leftStrip[ic], bot, true, rets);
+                clipper.clipLoops(&leftStrip[ic], 1, bot, rets);
         }
     }
     
@@ -25,13 +25,13 @@ namespace WhirlyKit
     
 ImageTile::ImageTile()
     : borderSize(0),width(0), height(0), components(0),
-    targetWidth(0), targetHeight(0)
+    targetWidth(0), targetHeight(0), dataInFormat(false)
 {
 }
     
 ImageTile::ImageTile(const std::string &name)
-    : borderSize(0),width(0), height(0), components(0),
-    targetWidth(0), targetHeight(0), name(name)
+    : name(name), borderSize(0),width(0), height(0), components(0),
+    targetWidth(0), targetHeight(0), dataInFormat(false)
 {
 }
 
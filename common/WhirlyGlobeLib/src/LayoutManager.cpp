@@ -70,12 +70,30 @@ LayoutObjectEntry::LayoutObjectEntry(SimpleIdentity theId)
     currentCluster = newCluster = -1;
     offset = Point2d(MAXFLOAT,MAXFLOAT);
     changed = true;
+    sortRank = 0;
+    screenPt = layoutAnchor = Point2f(0.0,0.0);
+    screenInside = false;
+    layoutOrient = -1;
+    layoutTested = false;
+    layoutFrame = 0;
+    placedID = -1;
 }
     
 LayoutManager::LayoutManager() :
     maxDisplayObjects(0),
     hasUpdates(false),
     showDebugBoundaries(false),
+    sortedObjectsDirty(true),
+    layoutFrame(0),
+    incrementalLayout(false),
+    incrementalThreshold(1.0),
+    fullLayoutNeeded(true),
+    layoutShift(0.0,0.0),
+    placedOverlap(Mbr(),1,1),
+    numPlacedOwners(0),
+    placedShift(0.0,0.0),
+    lastFrameBufferSize(0.0,0.0),
+    lastResScale(0.0),
     clusterGen(nullptr),
     vecProgID(EmptyIdentity)
 {
@@ -97,6 +115,7 @@ void LayoutManager::setMaxDisplayObjects(int numObjects)
     std::lock_guard<std::mutex> guardLock(lock);
 
     maxDisplayObjects = numObjects;
+    fullLayoutNeeded = true;
 }
 
 void LayoutManager::setOverrideUUIDs(const std::set<std::string> &uuids)
@@ -104,6 +123,16 @@ void LayoutManager::setOverrideUUIDs(const std::set<std::string> &uuids)
     std::lock_guard<std::mutex> guardLock(lock);
 
     overrideUUIDs = uuids;
+    fullLayoutNeeded = true;
+}
+
+void LayoutManager::setIncrementalLayout(bool enable,float moveThreshold)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    incrementalLayout = enable;
+    incrementalThreshold = moveThreshold;
+    fullLayoutNeeded = true;
 }
     
 void LayoutManager::addLayoutObjects(const std::vector<LayoutObject> &newObjects)
@@ -117,6 +146,7 @@ void LayoutManager::addLayoutObjects(const std::vector<LayoutObject> &newObjects
         entry->obj = newObject;
         layoutObjects.insert(entry);
     }
+    sortedObjectsDirty = true;
     hasUpdates = true;
 }
 
@@ -131,6 +161,7 @@ void LayoutManager::addLayoutObjects(const std::vector<LayoutObject *> &newObjec
         entry->obj = *newObject;
         layoutObjects.insert(entry);
     }
+    sortedObjectsDirty = true;
     hasUpdates = true;
 }
 
@@ -171,6 +202,7 @@ void LayoutManager::removeLayoutObjects(const SimpleIDSet &oldObjects)
             layoutObjects.erase(eit);
         }
     }
+    sortedObjectsDirty = true;
     hasUpdates = true;
 }
     
@@ -403,6 +435,204 @@ static Point2d offsetForOrientation(int orient, const Point2d &span)
     }
 }
 
+// Work out the screen points for the given placement of a point object
+static void placementPts(const LayoutObject &obj, int orient, const Point2f &objPt, const Matrix2d &screenRotMat,
+                         float resScale, Point2d &objOffset, Point2dVector &objPts)
+{
+    // Layout points are relative to the object, figure out where they are on the screen
+    const Mbr layoutMbr(obj.layoutPts);
+    const Point2f span = layoutMbr.span();
+    const Point2f &layoutOrg = layoutMbr.ll();
+
+    // Set up the offset for this orientation
+    objOffset = offsetForOrientation(orient, span.cast<double>());
+
+    objPts[0] = objOffset + layoutOrg.cast<double>();
+    objPts[1] = objPts[0] + Point2d(span.x(), 0.0);
+    objPts[2] = objPts[0] + Point2d(span.x(), span.y());
+    objPts[3] = objPts[0] + Point2d(0.0, span.y());
+
+    for (auto &p : objPts)
+    {
+        const Point2d offPt = screenRotMat * (p * resScale);
+        p = Point2d(offPt.x(),-offPt.y()) + objPt.cast<double>();
+    }
+}
+
+static Mbr shiftMbr(const Mbr &mbr, const Point2f &shift)
+{
+    return mbr.valid() ? Mbr(mbr.ll() + shift, mbr.ur() + shift) : Mbr();
+}
+
+static bool mbrNear(const Mbr &a, const Mbr &b, float dist)
+{
+    return (a.ll() - b.ll()).cwiseAbs().maxCoeff() <= dist &&
+           (a.ur() - b.ur()).cwiseAbs().maxCoeff() <= dist;
+}
+
+static Point2dVector mbrPts(const Point2f &ll, const Point2f &ur)
+{
+    return { Point2d(ll.x(),ll.y()), Point2d(ur.x(),ll.y()), Point2d(ur.x(),ur.y()), Point2d(ll.x(),ur.y()) };
+}
+
+// Keep the objects sorted by importance so we don't have to sort them all on every layout
+void LayoutManager::sortLayoutObjects()
+{
+    if (!sortedObjectsDirty)
+        return;
+
+    sortedObjects.assign(layoutObjects.begin(),layoutObjects.end());
+    std::sort(sortedObjects.begin(),sortedObjects.end(),LayoutEntrySorter());
+    for (unsigned int ii=0;ii<sortedObjects.size();ii++)
+        sortedObjects[ii]->sortRank = ii;
+    groupLayoutObjects();
+
+    sortedObjectsDirty = false;
+}
+
+// Spread the low 10 bits out to every third bit
+static uint32_t spreadBits(uint32_t val)
+{
+    val &= 0x3ff;
+    val = (val | (val << 16)) & 0x030000ff;
+    val = (val | (val << 8)) & 0x0300f00f;
+    val = (val | (val << 4)) & 0x030c30c3;
+    val = (val | (val << 2)) & 0x09249249;
+    return val;
+}
+
+// Objects per group
+static const unsigned int ObjectGroupSize = 64;
+
+// Sort the regular objects along a Morton curve through display space and chop them into groups.
+//  Most of the groups will be off screen at any given time and we can skip them in one go.
+void LayoutManager::groupLayoutObjects()
+{
+    objectGroups.clear();
+    groupedObjects.clear();
+    ungroupedObjects.clear();
+
+    Point3d ll(MAXFLOAT,MAXFLOAT,MAXFLOAT),ur(-MAXFLOAT,-MAXFLOAT,-MAXFLOAT);
+    for (auto entry : sortedObjects)
+    {
+        if (entry->obj.layoutShape.empty() && entry->obj.clusterGroup < 0 && entry->obj.uniqueID.empty())
+        {
+            groupedObjects.push_back(entry);
+            ll = ll.cwiseMin(entry->obj.worldLoc);
+            ur = ur.cwiseMax(entry->obj.worldLoc);
+        } else
+            ungroupedObjects.push_back(entry);
+    }
+    if (groupedObjects.empty())
+        return;
+
+    const Point3d span = (ur - ll).cwiseMax(Point3d(1e-10,1e-10,1e-10));
+    std::vector<std::pair<uint32_t,LayoutObjectEntry *>> codes;
+    codes.reserve(groupedObjects.size());
+    for (auto entry : groupedObjects)
+    {
+        const Point3d cell = (entry->obj.worldLoc - ll).cwiseQuotient(span) * 1023.0;
+        codes.emplace_back(spreadBits((uint32_t)cell.x()) | spreadBits((uint32_t)cell.y()) << 1 | spreadBits((uint32_t)cell.z()) << 2,entry);
+    }
+    std::sort(codes.begin(),codes.end(),
+              [](const std::pair<uint32_t,LayoutObjectEntry *> &a,const std::pair<uint32_t,LayoutObjectEntry *> &b)
+              {
+                  return a.first == b.first ? a.second->sortRank < b.second->sortRank : a.first < b.first;
+              });
+
+    for (unsigned int ii=0;ii<codes.size();ii++)
+    {
+        const Point3d &loc = codes[ii].second->obj.worldLoc;
+        groupedObjects[ii] = codes[ii].second;
+        if (ii % ObjectGroupSize == 0)
+            objectGroups.push_back({loc,loc,ii,ii});
+        auto &group = objectGroups.back();
+        group.ll = group.ll.cwiseMin(loc);
+        group.ur = group.ur.cwiseMax(loc);
+        group.end = ii+1;
+    }
+
+    // We don't know which of these were in use before
+    visitedObjects = groupedObjects;
+}
+
+// Planes around the part of display space that lands on the screen (plus the buffer) for each view matrix.
+//  A point is on screen for a given matrix if it's on the positive side of all five planes.
+static Vector4dVector screenPlanes(ViewState *viewState,const Point2f &frameBufferSize,float buffer)
+{
+    if (viewState->ll.x() == viewState->ur.x())
+        viewState->calcFrustumWidth(frameBufferSize.x(),frameBufferSize.y());
+    const Point2d span = viewState->ur - viewState->ll;
+    const Point2d ll = (viewState->ll - span * buffer) / viewState->nearPlane;
+    const Point2d ur = (viewState->ur + span * buffer) / viewState->nearPlane;
+
+    // In eye space x/-z and y/-z have to be within the frustum and z has to be negative
+    const Eigen::Vector4d eyePlanes[5] = { {1.0,0.0,ll.x(),0.0}, {-1.0,0.0,-ur.x(),0.0},
+                                           {0.0,1.0,ll.y(),0.0}, {0.0,-1.0,-ur.y(),0.0},
+                                           {0.0,0.0,-1.0,0.0} };
+    Vector4dVector planes;
+    for (const auto &fullMatrix : viewState->fullMatrices)
+        for (const auto &plane : eyePlanes)
+            planes.push_back(fullMatrix.transpose() * plane);
+    return planes;
+}
+
+// True if some part of the box could be on the positive side of all the planes for one of the view matrices
+static bool boxOnScreen(const Vector4dVector &planes,const Point3d &ll,const Point3d &ur)
+{
+    for (unsigned int pi=0;pi<planes.size();pi+=5)
+    {
+        bool inside = true;
+        for (unsigned int ii=pi;ii<pi+5 && inside;ii++)
+        {
+            const Eigen::Vector4d &plane = planes[ii];
+            double maxDist = plane.w();
+            for (unsigned int ci=0;ci<3;ci++)
+                maxDist += std::max(plane[ci] * ll[ci],plane[ci] * ur[ci]);
+            inside = maxDist >= 0.0;
+        }
+        if (inside)
+            return true;
+    }
+    return false;
+}
+
+// Start the carried placements over, bringing the current ones along if asked
+void LayoutManager::resetPlacements(const Mbr &screenMbr,bool keep)
+{
+    std::vector<LayoutObjectEntry *> owners;
+    owners.swap(placedOwners);
+    numPlacedOwners = 0;
+    placedShift = layoutShift;
+    placedOverlap = OverlapHelper(shiftMbr(screenMbr,-layoutShift),OverlapSampleX,OverlapSampleY);
+    if (keep)
+        for (auto entry : owners)
+            if (entry)
+                addPlacement(entry,entry->layoutMbr,0);
+}
+
+bool LayoutManager::hasPlacement(const LayoutObjectEntry *entry) const
+{
+    return entry->placedID >= 0 && entry->placedID < (int)placedOwners.size() && placedOwners[entry->placedID] == entry;
+}
+
+void LayoutManager::addPlacement(LayoutObjectEntry *entry,const Mbr &placedMbr,int rank)
+{
+    entry->placedID = placedOverlap.addObject(placedMbr,rank);
+    placedOwners.push_back(entry);
+    numPlacedOwners++;
+}
+
+void LayoutManager::removePlacement(LayoutObjectEntry *entry)
+{
+    if (!hasPlacement(entry))
+        return;
+    placedOverlap.removeObject(entry->placedID);
+    placedOwners[entry->placedID] = nullptr;
+    numPlacedOwners--;
+    entry->placedID = -1;
+}
+
 // Do the actual layout logic.  We'll modify the offset and on value in place.
 bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                                    const ViewStateRef &viewState,
@@ -410,8 +640,13 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                                    std::vector<ClusterGenerator::ClusterClassParams> &outClusterParams,
                                    ChangeSet &changes)
 {
+    WK_TRACE_SCOPE("LayoutManager::runLayoutRules");
+
+    updatedObjects.clear();
     if (layoutObjects.empty())
         return false;
+
+    WK_TRACE_COUNTER("Layout objects",layoutObjects.size());
     
     bool hadChanges = false;
         
@@ -419,6 +654,12 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
     LayoutContainerVec layoutObjs;
     // Special snowflake layout objects (with unique names)
     UniqueLayoutObjectMap uniqueLayoutObjs;
+
+    // Regular objects go into their slot in the importance order
+    sortLayoutObjects();
+    std::vector<LayoutObjectEntry *> rankedObjs(sortedObjects.size(),nullptr);
+    // Objects that dropped out entirely
+    std::vector<LayoutObjectEntry *> droppedObjs;
     
     // The globe has some special requirements
     auto globeViewState = dynamic_cast<WhirlyGlobe::GlobeViewState *>(viewState.get());
@@ -429,9 +670,44 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
     Matrix4d fullMatrix = viewState->fullMatrices[0];
     Matrix4d fullNormalMatrix = viewState->fullNormalMatrices[0];
     Matrix4d normalMat = viewState->fullMatrices[0].inverse().transpose();
-    
+
+    // Extents for the layout helpers
+    const Point2f frameBufferSize(renderer->framebufferWidth, renderer->framebufferHeight);
+    const Mbr screenMbr(frameBufferSize * -ScreenBuffer,
+                        frameBufferSize * (1.0 + ScreenBuffer));
+
+    // Most of the regular objects are off screen, so skip over whole groups of them
+    layoutFrame++;
+    const auto planes = screenPlanes(viewState.get(),frameBufferSize,ScreenBuffer);
+    std::vector<LayoutObjectEntry *> visitObjs(ungroupedObjects);
+    for (const auto &group : objectGroups)
+        if (boxOnScreen(planes,group.ll,group.ur))
+            visitObjs.insert(visitObjs.end(),groupedObjects.begin()+group.start,groupedObjects.begin()+group.end);
+
+    // Anything we looked at last time and skipped this time has gone off screen
+    for (auto obj : visitObjs)
+    {
+        obj->layoutFrame = layoutFrame;
+    }
+    for (auto obj : visitedObjects)
+    {
+        if (obj->layoutFrame != layoutFrame && obj->obj.enable)
+        {
+            if (obj->currentEnable)
+                hadChanges = true;
+            obj->newEnable = false;
+            obj->newCluster = -1;
+            droppedObjs.push_back(obj);
+            updatedObjects.push_back(obj);
+        }
+    }
+    visitedObjects.assign(visitObjs.begin()+ungroupedObjects.size(),visitObjs.end());
+
+    // Everything else has been off for at least a round and will stay that way
+    updatedObjects.insert(updatedObjects.end(),visitObjs.begin(),visitObjs.end());
+
     // Turn everything off and sort by importance
-    for (const auto &layoutObject : layoutObjects)
+    for (auto layoutObject : visitObjs)
     {
         LayoutObjectEntry *layoutObj = layoutObject;
         if (layoutObj->obj.enable)
@@ -459,6 +735,15 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                     }
                 }
 
+                // Work out where it lands.  Most objects are off screen, so we drop those here
+                //  rather than carrying them through the layout, unless they share a unique ID.
+                if (use && obj->obj.layoutShape.empty())
+                {
+                    obj->screenInside = calcScreenPt(obj->screenPt,&obj->obj,viewState,screenMbr,frameBufferSize);
+                    if (!obj->screenInside && obj->obj.clusterGroup < 0 && obj->obj.uniqueID.empty())
+                        use = false;
+                }
+
                 if (use)
                 {
                     obj->newCluster = -1;
@@ -485,7 +770,7 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                     } else {
                         // Not a cluster
                         if (layoutObj->obj.uniqueID.empty())
-                            layoutObjs.push_back(LayoutObjectContainer(layoutObj));
+                            rankedObjs[layoutObj->sortRank] = layoutObj;
                         else {
                             // Add it to a container for its unique name
                             auto it = uniqueLayoutObjs.find(layoutObj->obj.uniqueID);
@@ -503,21 +788,24 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                 } else {
                     obj->newEnable = false;
                     obj->newCluster = -1;
+                    droppedObjs.push_back(obj);
                 }
             } else {
                 obj->newEnable = false;
                 obj->newCluster = -1;
+                droppedObjs.push_back(obj);
             }
             // Note: Update this for clusters
             if ((use && !obj->currentEnable) || (!use && obj->currentEnable))
                 hadChanges = true;
         }
     }
-    
-    // Extents for the layout helpers
-    const Point2f frameBufferSize(renderer->framebufferWidth, renderer->framebufferHeight);
-    const Mbr screenMbr(frameBufferSize * -ScreenBuffer,
-                        frameBufferSize * (1.0 + ScreenBuffer));
+
+    // These are already in order
+    for (auto obj : rankedObjs)
+        if (obj)
+            layoutObjs.emplace_back(obj);
+    const size_t numRanked = layoutObjs.size();
 
     // Need to scale for retina displays
     const float resScale = renderer->getScale();
@@ -659,11 +947,12 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
     // Set up the overlap sampler
     OverlapHelper overlapMan(screenMbr,OverlapSampleX,OverlapSampleY);
     
-    // Add in the unique objects, cluster entries and then sort them all
+    // Add in the unique objects, sort them along with the unclustered objects, and merge into the rest
     for (auto &it : uniqueLayoutObjs) {
         layoutObjs.push_back(it.second);
     }
-    std::sort(layoutObjs.begin(),layoutObjs.end());
+    std::sort(layoutObjs.begin()+numRanked,layoutObjs.end());
+    std::inplace_merge(layoutObjs.begin(),layoutObjs.begin()+numRanked,layoutObjs.end());
     
     // Clusters have priority in the overlap.
     for (const auto &it : clusterEntries) {
@@ -675,10 +964,81 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
         overlapMan.addObject(objPts);
     }
 
+    // See if we can build on the last layout
+    bool incremental = incrementalLayout && !fullLayoutNeeded && clusterEntries.empty() &&
+                       maxDisplayObjects == 0 && !showDebugBoundaries &&
+                       frameBufferSize == lastFrameBufferSize && resScale == lastResScale;
+    fullLayoutNeeded = !clusterEntries.empty();
+    lastFrameBufferSize = frameBufferSize;
+    lastResScale = resScale;
+    if (incremental)
+    {
+        // Work out how far the view moved everything as a whole
+        std::vector<LayoutObjectEntry *> shiftObjs;
+        Point2f shiftSum(0.0,0.0);
+        for (const auto &container : layoutObjs)
+        {
+            for (auto entry : container.objs)
+            {
+                if (entry->obj.layoutShape.empty() && entry->screenInside && entry->layoutTested)
+                {
+                    shiftSum += entry->screenPt - entry->layoutAnchor - layoutShift;
+                    shiftObjs.push_back(entry);
+                }
+            }
+        }
+        if (!shiftObjs.empty())
+            layoutShift += shiftSum / shiftObjs.size();
+
+        // If most of them moved relative to the rest, as they do in a zoom, it's cheaper to start over
+        unsigned int numMoved = 0;
+        for (auto entry : shiftObjs)
+            if ((entry->screenPt - entry->layoutAnchor - layoutShift).cwiseAbs().maxCoeff() > incrementalThreshold)
+                numMoved++;
+        incremental = 2*numMoved <= shiftObjs.size();
+    }
+    if (!incremental)
+    {
+        layoutShift = Point2f(0.0,0.0);
+    }
+
+    // Areas where the layout changed this time around.  Anything in reach of these gets tested again.
+    OverlapHelper dirtyMan(screenMbr,OverlapSampleX,OverlapSampleY);
+    const auto markDirty = [&](const Mbr &mbr)
+    {
+        if (incremental && mbr.valid())
+            dirtyMan.addObject(mbrPts(mbr.ll(),mbr.ur()));
+    };
+
+    for (auto obj : droppedObjs)
+    {
+        markDirty(shiftMbr(obj->layoutMbr,layoutShift));
+        removePlacement(obj);
+        obj->layoutMbr.reset();
+        obj->layoutOrient = -1;
+        obj->layoutTested = false;
+    }
+
+    // Point placements stay in their own overlap helper from one layout to the next.
+    //  Gather them up again if they've drifted too far from its grid or most of them are gone.
+    const Point2f drift = (layoutShift - placedShift).cwiseAbs();
+    if (!incremental)
+        resetPlacements(screenMbr,false);
+    else if (drift.x() > frameBufferSize.x()/4 || drift.y() > frameBufferSize.y()/4 ||
+             placedOverlap.numObjects() > 2*numPlacedOwners + 64)
+        resetPlacements(screenMbr,true);
+
+    // A placement only gets in the way of objects after it in this round's order
+    for (unsigned int ci=0;ci<layoutObjs.size();ci++)
+        for (auto entry : layoutObjs[ci].objs)
+            if (hasPlacement(entry))
+                placedOverlap.setObjectRank(entry->placedID,ci);
+
     // Lay out the various objects that are active
     int numSoFar = 0;
-    for (auto container : layoutObjs)
+    for (unsigned int ci=0;ci<layoutObjs.size();ci++)
     {
+        auto &container = layoutObjs[ci];
         bool isActive;
         Point2d objOffset(0.0,0.0);
         Point2dVector objPts(4);
@@ -701,11 +1061,19 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
         
         for (auto layoutObj : container.objs) {
             layoutObj->newEnable = false;
-            layoutObj->obj.layoutModelPlaces.clear();
-            layoutObj->obj.layoutPlaces.clear();
+
+            // What we found, for the next incremental layout
+            bool tested = true;
+            bool reusable = false;
+            int placedOrient = -1;
+            Mbr placedMbr;
+            Point2f objPt(0.0,0.0);
 
             // Layout along a shape
             if (!layoutObj->obj.layoutShape.empty()) {
+                layoutObj->obj.layoutModelPlaces.clear();
+                layoutObj->obj.layoutPlaces.clear();
+
                 // Sometimes there are just a few instances
                 int numInstances = 0;
                 
@@ -865,7 +1233,10 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
 //                                    }
 //                                }
 
-                                if (!overlapMan.checkObject(objPts)) {
+                                Mbr overlapMbr;
+                                overlapMbr.addPoints(objPts);
+                                if (!overlapMan.checkObject(overlapMbr) ||
+                                    !placedOverlap.checkObject(shiftMbr(overlapMbr,-layoutShift),ci)) {
                                     failed = true;
                                     break;
                                 }
@@ -881,7 +1252,10 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                                 
                                 // Add the individual glyphs to the overlap manager
                                 for (auto &glyph: overlapPts)
+                                {
                                     overlapMan.addObject(glyph);
+                                    placedMbr.addPoints(glyph);
+                                }
                             }
                             
                             if (layoutObj->obj.layoutRepeat > 0 && numInstances >= layoutObj->obj.layoutRepeat)
@@ -901,6 +1275,7 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                         layoutObj->obj.layoutModelPlaces = layoutModelInstances;
                         layoutObj->newCluster = -1;
                         layoutObj->offset = Point2d(0.0,0.0);
+                        placedOrient = 0;
                     } else {
                         isActive = false;
                     }
@@ -933,26 +1308,57 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                 
                 if (isActive)
                 {
-                    Point2f objPt;
-                    bool isInside = calcScreenPt(objPt,&layoutObj->obj,viewState,screenMbr,frameBufferSize);
-                    
-                    isActive &= isInside;
-                    
+                    objPt = layoutObj->screenPt;
+                    isActive &= layoutObj->screenInside;
+
+                    // If it hasn't moved and nothing around it changed, we can reuse the last result
+                    if (isActive && incremental && layoutObj->layoutTested &&
+                        (objPt - layoutObj->layoutAnchor - layoutShift).cwiseAbs().maxCoeff() <= incrementalThreshold)
+                    {
+                        // Anywhere any of its placements could reach
+                        const Mbr layoutMbr(layoutObj->obj.layoutPts);
+                        const Point2f reach = (layoutMbr.ll().cwiseAbs() + layoutMbr.span()) * resScale +
+                                              Point2f(incrementalThreshold,incrementalThreshold);
+                        if (dirtyMan.checkObject(mbrPts(objPt - reach,objPt + reach)))
+                        {
+                            if (layoutObj->layoutOrient < 0)
+                            {
+                                // Still blocked by whatever blocked it last time
+                                isActive = false;
+                                objOffset = layoutObj->offset;
+                                tested = false;
+                            } else if (hasPlacement(layoutObj)) {
+                                // Its placement is still there, unless something else landed on it this time
+                                const Mbr keptMbr = shiftMbr(layoutObj->layoutMbr,layoutShift);
+                                if (overlapMan.checkObject(keptMbr) || container.importance >= MAXFLOAT)
+                                {
+                                    pickedOne = true;
+                                    tested = false;
+                                    objOffset = layoutObj->offset;
+                                }
+                            }
+                        }
+                    }
+                    if (tested)
+                        removePlacement(layoutObj);
+
                     // Deal with the rotation
                     float screenRot = 0.0;
                     Matrix2d screenRotMat = Matrix2d::Identity();
-                    if (layoutObj->obj.rotation != 0.0)
+                    if (tested && layoutObj->obj.rotation != 0.0)
                     {
                         screenRotMat = calcScreenRot(screenRot, viewState, globeViewState, &layoutObj->obj,
                                                      objPt, modelTrans, normalMat, frameBufferSize);
                     }
                     
                     // Now for the overlap checks
-                    if (isActive)
+                    if (tested && isActive)
                     {
                         // Try the four different orientations
                         if (!layoutObj->obj.layoutPts.empty())
                         {
+                            reusable = (layoutObj->obj.rotation == 0.0);
+
                             bool validOrient = false;
                             for (unsigned int orient=0;orient<6;orient++)
                             {
@@ -960,32 +1366,23 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                                 if (!(layoutObj->obj.acceptablePlacement & (1<<orient)))
                                     continue;
 
-                                // Layout points are relative to the object, figure out where they are on the screen
-                                const Point2dVector &layoutPts = layoutObj->obj.layoutPts;
-                                const Mbr layoutMbr(layoutPts);
-                                const Point2f span = layoutMbr.span();
-                                const Point2f &layoutOrg = layoutMbr.ll();
-
-                                // Set up the offset for this orientation
-                                objOffset = offsetForOrientation(orient, span.cast<double>());
-
-                                objPts[0] = objOffset + layoutOrg.cast<double>();
-                                objPts[1] = objPts[0] + Point2d(span.x(), 0.0);
-                                objPts[2] = objPts[0] + Point2d(span.x(), span.y());
-                                objPts[3] = objPts[0] + Point2d(0.0, span.y());
-
-                                for (auto &p : objPts)
-                                {
-                                    const Point2d offPt = screenRotMat * (p * resScale);
-                                    p = Point2d(offPt.x(),-offPt.y()) + objPt.cast<double>();
-                                }
+                                placementPts(layoutObj->obj, orient, objPt, screenRotMat, resScale, objOffset, objPts);
 
                                 //wkLogLevel(Debug, "Center pt = (%f,%f), orient = %d, pts:",objPt.x(),objPt.y(),orient);
                                 //for (const auto &p : objPts) wkLogLevel(Debug, "  (%f,%f)\n",p.x(),p.y());
                                 
                                 // Now try it.  Objects we've pegged as essential always win
-                                if (overlapMan.addCheckObject(objPts) || container.importance >= MAXFLOAT)
+                                Mbr objMbr;
+                                objMbr.addPoints(objPts);
+                                const bool fits = overlapMan.checkObject(objMbr) &&
+                                                  placedOverlap.checkObject(shiftMbr(objMbr,-layoutShift),ci);
+                                if (fits || container.importance >= MAXFLOAT)
                                 {
+                                    if (fits && reusable)
+                                        addPlacement(layoutObj,shiftMbr(objMbr,-layoutShift),ci);
+                                    else if (fits)
+                                        overlapMan.addObject(objPts);
+
                                     if (showDebugBoundaries)
                                     {
                                         // Debugging visual output
@@ -996,6 +1393,8 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
 
                                     validOrient = true;
                                     pickedOne = true;
+                                    placedOrient = (int)orient;
+                                    placedMbr.addPoints(objPts);
                                     break;
                                 }
 
@@ -1017,6 +1416,24 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
                 }
             }
 
+            // Keep track of what happened for next time, and note where it changed
+            if (incrementalLayout && tested)
+            {
+                if (!isActive)
+                    placedMbr.reset();
+                const Mbr oldMbr = shiftMbr(layoutObj->layoutMbr,layoutShift);
+                if (oldMbr.valid() != placedMbr.valid() ||
+                    (placedMbr.valid() && !mbrNear(oldMbr,placedMbr,incrementalThreshold)))
+                {
+                    markDirty(oldMbr);
+                    markDirty(placedMbr);
+                }
+                layoutObj->layoutAnchor = objPt - layoutShift;
+                layoutObj->layoutMbr = shiftMbr(placedMbr,-layoutShift);
+                layoutObj->layoutOrient = isActive ? placedOrient : -1;
+                layoutObj->layoutTested = reusable;
+            }
+
             if (isActive)
                 numSoFar++;
             
@@ -1044,6 +1461,8 @@ static float const NewObjectFadeIn = 0.0;
 // Layout all the objects we're tracking
 void LayoutManager::updateLayout(PlatformThreadInfo *threadInfo,const ViewStateRef &viewState,ChangeSet &changes)
 {
+    WK_TRACE_SCOPE("LayoutManager::updateLayout");
+
     CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
     
     if (!vecManage)
@@ -1072,6 +1491,12 @@ void LayoutManager::updateLayout(PlatformThreadInfo *threadInfo,const ViewStateR
     std::vector<ClusterEntry> oldClusters = std::move(clusters);
     std::vector<ClusterGenerator::ClusterClassParams> oldClusterParams = std::move(clusterParams);
 
+    // Objects were added, removed or changed, so we can't build on the last layout
+    if (hasUpdates)
+    {
+        fullLayoutNeeded = true;
+    }
+
     // This will recalculate the offsets and enables
     // If there were any changes, we need to regenerate
     bool layoutChanges = runLayoutRules(threadInfo,viewState,clusters,clusterParams,changes);
@@ -1105,7 +1530,7 @@ void LayoutManager::updateLayout(PlatformThreadInfo *threadInfo,const ViewStateR
 
     // Generate the drawables
     ScreenSpaceBuilder ssBuild(renderer,coordAdapter,renderer->scale);
-    for (const auto &layoutObj : layoutObjects)
+    for (const auto &layoutObj : updatedObjects)
     {
         layoutObj->obj.offset = Point2d(layoutObj->offset.x(),layoutObj->offset.y());
         if (!layoutObj->currentEnable)
@@ -18,6 +18,8 @@
 
 #import "LoadedTileNew.h"
 #import "BasicDrawableBuilder.h"
+#import "FlatMath.h"
+#import "SphericalMercator.h"
 #import "WhirlyKitLog.h"
 
 using namespace Eigen;
@@ -126,6 +128,16 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
     const GeoCoord geoLL(geomManage->coordSys->localToGeographic(Point3d(chunkLL.x(),chunkLL.y(),0.0)));
     const GeoCoord geoUR(geomManage->coordSys->localToGeographic(Point3d(chunkUR.x(),chunkUR.y(),0.0)));
     
+    // The chunk stays inside its geographic MBR if the tile's coordinate system keeps lines of latitude
+    //  and longitude straight, and the pole caps aren't built into it.  The scene can cull with that.
+    const CoordSystem *tileCoordSys = geomManage->coordSys.get();
+    const bool poleCapsInChunk = geomManage->coverPoles && !geomManage->coordAdapter->isFlat() &&
+                                 !geomManage->useNorthPoleColor && !geomManage->useSouthPoleColor;
+    const bool straightGeo = dynamic_cast<const SphericalMercatorCoordSystem *>(tileCoordSys) ||
+                             dynamic_cast<const PlateCarreeCoordSystem *>(tileCoordSys) ||
+                             dynamic_cast<const GeoCoordSystem *>(tileCoordSys);
+    const LocalMbrType chunkMbrType = (straightGeo && !poleCapsInChunk) ? LocalMbrGeographic : LocalMbrUnknown;
+
     BasicDrawableBuilderRef chunk = sceneRender->makeBasicDrawableBuilder("LoadedTileNew chunk");
     chunk->reserve((sphereTessX+1)*(sphereTessY+1),2*sphereTessX*sphereTessY);
     // Note: Make this flexible
@@ -146,7 +158,7 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
     chunk->setDrawPriority(drawPriority);
     chunk->setVisibleRange(geomSettings.minVis, geomSettings.maxVis);
 //    chunk->setColor(geomSettings.color);
-    chunk->setLocalMbr(Mbr(Point2f(geoLL.x(),geoLL.y()),Point2f(geoUR.x(),geoUR.y())));
+    chunk->setLocalMbr(Mbr(Point2f(geoLL.x(),geoLL.y()),Point2f(geoUR.x(),geoUR.y())),chunkMbrType);
     chunk->setProgram(geomSettings.programID);
     chunk->setOnOff(false);
 
@@ -211,27 +223,29 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
         if (geomSettings.includeElev)
             elevs.resize((sphereTessX+1)*(sphereTessY+1));
         std::vector<TexCoord> texCoords((sphereTessX+1)*(sphereTessY+1));
+        const float locZ = 0.0;
         for (unsigned int iy=0;iy<sphereTessY+1;iy++)
         {
             for (unsigned int ix=0;ix<sphereTessX+1;ix++)
             {
-                float locZ = 0.0;
-                const auto cs = geomManage->coordSys.get();
-                auto loc3D = geomManage->coordAdapter->localToDisplay(CoordSystemConvert3d(cs,sceneCoordSys,Point3d(chunkLL.x()+ix*incr.x(),chunkLL.y()+iy*incr.y(),locZ)));
-                if (geomManage->coordAdapter->isFlat())
-                    loc3D.z() = locZ;
-                
-                // Use Z priority to sort the levels
-                //                    if (singleLevel != -1)
-                //                        loc3D.z() = (drawPriority + nodeInfo->ident.level * 0.01)/10000;
-                
-                locs[iy*(sphereTessX+1)+ix] = loc3D;
+                locs[iy*(sphereTessX+1)+ix] = Point3d(chunkLL.x()+ix*incr.x(),chunkLL.y()+iy*incr.y(),locZ);
                 
                 // Do the texture coordinate separately
                 const TexCoord texCoord(ix*texIncr.x(),1.0-(iy*texIncr.y()));
                 texCoords[iy*(sphereTessX+1)+ix] = texCoord;
             }
         }
+
+        // Convert the whole grid to display coordinates in one go
+        CoordSystemConvert3d(geomManage->coordSys.get(),sceneCoordSys,locs.data(),locs.data(),locs.size());
+        geomManage->coordAdapter->localToDisplay(locs.data(),locs.data(),locs.size());
+        if (geomManage->coordAdapter->isFlat())
+            for (auto &loc3D : locs)
+                loc3D.z() = locZ;
+
+        // Use Z priority to sort the levels
+        //                    if (singleLevel != -1)
+        //                        loc3D.z() = (drawPriority + nodeInfo->ident.level * 0.01)/10000;
         
         // Without elevation data we can share the vertices
         for (unsigned int iy=0;iy<sphereTessY+1;iy++)
@@ -527,7 +541,7 @@ void TileGeomManager::setup(SceneRenderer *inSceneRender,TileGeomSettings &geomS
 }
     
 TileGeomManager::NodeChanges TileGeomManager::addRemoveTiles(
-        const QuadTreeNew::ImportantNodeSet &addTiles,
+        const QuadTreeNew::ImportantNodeVector &addTiles,
         const QuadTreeNew::NodeSet &removeTiles,ChangeSet &changes)
 {
     NodeChanges nodeChanges;
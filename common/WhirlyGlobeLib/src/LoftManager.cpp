@@ -99,7 +99,7 @@ public:
     // Initialize or flush a drawable, as needed
     void setupDrawable(int numToAdd)
     {
-        if (!drawable || (drawable->getNumPoints()+numToAdd > MaxDrawablePoints))
+        if (!drawable || (drawable->getNumPoints()+numToAdd > sceneRender->getMaxDrawablePoints()))
         {
             // We're done with it, toss it to the scene
             if (drawable)
@@ -119,21 +119,31 @@ public:
         }
     }
     
-    // Add a triangle, keeping track of limits
-    void addLoftTriangle(Point2f verts[3],float height)
+    // Convert a run of geo points, offset by the geo center, to display coordinates and normals in one go
+    void geoToDisplay(const VectorRing &pts)
     {
         CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
+
+        geoPts.resize(pts.size());
+        dispPts.resize(pts.size());
+        normPts.resize(pts.size());
+        for (unsigned int ii=0;ii<pts.size();ii++)
+            geoPts[ii] = Point2d(pts[ii].x()+geoCenter.x(),pts[ii].y()+geoCenter.y());
+        coordAdapter->geographicToDisplay(geoPts.data(),dispPts.data(),normPts.data(),pts.size());
+    }
+    
+    // Add a triangle, keeping track of limits
+    // The vertices index into the points we last converted
+    void addLoftTriangle(const int verts[3],float height)
+    {
         setupDrawable(3);
         
         int startVert = drawable->getNumPoints();
         for (unsigned int ii=0;ii<3;ii++)
         {
-            // Get some real world coordinates and corresponding normal
-            Point2f &geoPt = verts[ii];
-            Point2d geoCoordD(geoPt.x()+geoCenter.x(),geoPt.y()+geoCenter.y());
-            Point3d localPt = coordAdapter->getCoordSystem()->geographicToLocal(geoCoordD);
-            Point3d dispPt = coordAdapter->localToDisplay(localPt);
-            Point3d norm = coordAdapter->normalForLocal(localPt);
+            // Real world coordinates and corresponding normal
+            const Point3d &dispPt = dispPts[verts[ii]];
+            const Point3d &norm = normPts[verts[ii]];
             Point3d pt1 = dispPt + norm * height - center;
             
             drawable->addPoint(pt1);
@@ -151,22 +161,24 @@ public:
     //  in the height
     void addPolyGroup(VectorTrianglesRef mesh)
     {
+        // The triangles share vertices, so convert them all at once
+        VectorRing meshPts;
+        meshPts.reserve(mesh->pts.size());
+        for (const auto &pt : mesh->pts)
+            meshPts.emplace_back(pt.x(),pt.y());
+        geoToDisplay(meshPts);
+
         for (unsigned int ii=0;ii<mesh->tris.size();ii++)
         {
-            VectorRing tri;
-            mesh->getTriangle(ii, tri);
-            if (tri.size() == 3)
+            const VectorTriangles::Triangle &tri = mesh->tris[ii];
+            int verts[3];
+            verts[2] = tri.pts[0];  verts[1] = tri.pts[1];  verts[0] = tri.pts[2];
+            addLoftTriangle(verts,polyInfo.height);
+            // If they've got a base, we want to see it from the underside, probably
+            if (polyInfo.base > 0.0)
             {
-                Point2f verts[3];
-                verts[2] = tri[0];  verts[1] = tri[1];  verts[0] = tri[2];
-                addLoftTriangle(verts,polyInfo.height);
-                // If they've got a base, we want to see it from the underside, probably
-                if (polyInfo.base > 0.0)
-                {
-                    Point2f verts[3];
-                    verts[1] = tri[0];  verts[2] = tri[1];  verts[0] = tri[2];
-                    addLoftTriangle(verts,polyInfo.base);
-                }
+                verts[1] = tri.pts[0];  verts[2] = tri.pts[1];  verts[0] = tri.pts[2];
+                addLoftTriangle(verts,polyInfo.base);
             }
         }
     }
@@ -179,21 +191,18 @@ public:
         double height = (useHeight ? polyInfo.height : 0.0);
         
         setupDrawable(0);
-        CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
         
         for (unsigned int ii=0;ii<rings.size();ii++)
         {
             VectorRing &verts = rings[ii];
+            // Convert to real world coordinates and offset from the globe
+            geoToDisplay(verts);
+
             Point3d prevPt,prevNorm,firstPt,firstNorm;
             for (unsigned int jj=0;jj<verts.size();jj++)
             {
-                // Convert to real world coordinates and offset from the globe
-                Point2f &geoPt = verts[jj];
-                Point2d geoCoordD(geoPt.x()+geoCenter.x(),geoPt.y()+geoCenter.y());
-                Point3d localPt = coordAdapter->getCoordSystem()->geographicToLocal(geoCoordD);
-                Point3d dispPt = coordAdapter->localToDisplay(localPt);
-                Point3d norm = coordAdapter->normalForLocal(localPt);
-                Point3d pt = dispPt + norm * height - center;
+                const Point3d &norm = normPts[jj];
+                Point3d pt = dispPts[jj] + norm * height - center;
                 
                 // Add to drawable
                 // Depending on the type, we do this differently
@@ -223,22 +232,19 @@ public:
     
     void addSkirtPoints(VectorRing &pts)
     {
-        CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
-        
         // Decide if we'll appending to an existing drawable or
         //  create a new one
         int ptCount = (int)(4*(pts.size()+1));
         setupDrawable(ptCount);
+
+        // Get some real world coordinates and corresponding normals
+        geoToDisplay(pts);
         
         Point3d prevPt0,prevPt1,prevNorm,firstPt0,firstPt1,firstNorm;
         for (unsigned int jj=0;jj<pts.size();jj++)
         {
-            // Get some real world coordinates and corresponding normal
-            Point2f &geoPt = pts[jj];
-            Point2d geoCoordD(geoPt.x()+geoCenter.x(),geoPt.y()+geoCenter.y());
-            Point3d localPt = coordAdapter->getCoordSystem()->geographicToLocal(geoCoordD);
-            Point3d norm = coordAdapter->normalForLocal(localPt);
-            Point3d pt0 = coordAdapter->localToDisplay(localPt);
+            const Point3d &norm = normPts[jj];
+            Point3d pt0 = dispPts[jj];
             Point3d pt1 = pt0 + norm * polyInfo.height;
             if (polyInfo.base > 0.0)
                 pt0 = pt0 + norm * polyInfo.base;
@@ -311,21 +317,19 @@ public:
     {
         if (primType != Lines)
             return;
-        CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
         
         // Decide if we'll appending to an existing drawable or
         //  create a new one
         int ptCount = (int)(2*pts.size());
         setupDrawable(ptCount);
+
+        // Get some real world coordinates and corresponding normals
+        geoToDisplay(pts);
         
         for (unsigned int jj=0;jj<pts.size();jj++)
         {
-            // Get some real world coordinates and corresponding normal
-            Point2f &geoPt = pts[jj];
-            Point2d geoCoordD(geoPt.x()+geoCenter.x(),geoPt.y()+geoCenter.y());
-            Point3d localPt = coordAdapter->getCoordSystem()->geographicToLocal(geoCoordD);
-            Point3d norm = coordAdapter->normalForLocal(localPt);
-            Point3d pt0 = coordAdapter->localToDisplay(localPt);
+            const Point3d &norm = normPts[jj];
+            Point3d pt0 = dispPts[jj];
             Point3d pt1 = pt0 + norm * polyInfo.height;
             if (polyInfo.base > 0.0)
                 pt0 = pt0 + norm * polyInfo.base;
@@ -376,6 +380,9 @@ protected:
     Point2d geoCenter;
     bool applyCenter;
     bool centerValid;
+    // Scratch space for converting coordinates
+    std::vector<Point2d> geoPts;
+    std::vector<Point3d> dispPts,normPts;
 };
     
     
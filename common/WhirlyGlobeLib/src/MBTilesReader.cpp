@@ -0,0 +1,341 @@
+/*
+ *  MBTilesReader.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include <map>
+#include <string.h>
+#include <sqlite3.h>
+#include <zlib.h>
+#import "MBTilesReader.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+// Tile data we copied or decompressed out of the database
+class MBTileData : public RawData
+{
+public:
+    MBTileData(std::vector<unsigned char> &&data) : data(std::move(data)) { }
+
+    virtual const unsigned char *getRawData() const override { return data.data(); }
+    virtual unsigned long getLen() const override { return data.size(); }
+
+protected:
+    std::vector<unsigned char> data;
+};
+
+// A database connection along with the statements we've prepared on it
+// and a decompressor.  Only used by one thread at a time.
+class MBTilesReader::Connection
+{
+public:
+    Connection() : db(nullptr), streamInit(false)
+    {
+        memset(&stream, 0, sizeof(stream));
+    }
+
+    ~Connection()
+    {
+        for (auto &it : batchStmts)
+            sqlite3_finalize(it.second);
+        if (streamInit)
+            inflateEnd(&stream);
+        if (db)
+            sqlite3_close(db);
+    }
+
+    // Statement to look for the given number of rows in one column
+    sqlite3_stmt *getBatchStmt(int numRows,bool tilesStyle)
+    {
+        auto it = batchStmts.find(numRows);
+        if (it != batchStmts.end())
+            return it->second;
+
+        std::string sql = tilesStyle ?
+            "SELECT tile_row,tile_data FROM tiles WHERE zoom_level=?1 AND tile_column=?2 AND tile_row IN (" :
+            "SELECT map.tile_row,images.tile_data FROM map JOIN images ON map.tile_id=images.tile_id "
+            "WHERE map.zoom_level=?1 AND map.tile_column=?2 AND map.tile_row IN (";
+        for (int ii=0;ii<numRows;ii++)
+            sql += ii == 0 ? "?" : ",?";
+        sql += ");";
+
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            wkLogLevel(Error, "MBTilesReader: Failed to prepare statement: %s", sqlite3_errmsg(db));
+            return nullptr;
+        }
+        batchStmts[numRows] = stmt;
+
+        return stmt;
+    }
+
+    sqlite3 *db;
+    std::map<int,sqlite3_stmt *> batchStmts;
+    z_stream stream;
+    bool streamInit;
+};
+
+MBTilesReader::MBTilesReader(const std::string &fileName)
+: fileName(fileName), isOpen(false), decompress(true), tilesStyle(true), minZoom(0), maxZoom(0)
+{
+}
+
+MBTilesReader::~MBTilesReader()
+{
+    close();
+}
+
+bool MBTilesReader::open()
+{
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        if (isOpen)
+            return true;
+        isOpen = true;
+    }
+
+    ConnectionRef conn = getConnection();
+    if (!conn || !readMetadata(conn.get()))
+    {
+        conn.reset();
+        close();
+        return false;
+    }
+    releaseConnection(std::move(conn));
+
+    return true;
+}
+
+void MBTilesReader::close()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    // Connections that are checked out get closed when they come back
+    isOpen = false;
+    connections.clear();
+}
+
+MBTilesReader::ConnectionRef MBTilesReader::getConnection()
+{
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        if (!isOpen)
+            return ConnectionRef();
+        if (!connections.empty())
+        {
+            ConnectionRef conn = std::move(connections.back());
+            connections.pop_back();
+            return conn;
+        }
+    }
+
+    // Each connection is only used by one thread at a time, so skip SQLite's locking
+    ConnectionRef conn(new Connection());
+    if (sqlite3_open_v2(fileName.c_str(), &conn->db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK)
+    {
+        wkLogLevel(Error, "MBTilesReader: Failed to open %s", fileName.c_str());
+        return ConnectionRef();
+    }
+
+    return conn;
+}
+
+void MBTilesReader::releaseConnection(ConnectionRef &&conn)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (isOpen && conn)
+        connections.push_back(std::move(conn));
+}
+
+// Run a query that returns a single value as a string
+static bool ReadValue(sqlite3 *db,const char *sql,std::string &value)
+{
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        return false;
+
+    bool found = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL)
+    {
+        const unsigned char *text = sqlite3_column_text(stmt, 0);
+        value = text ? (const char *)text : "";
+        found = true;
+    }
+    sqlite3_finalize(stmt);
+
+    return found;
+}
+
+bool MBTilesReader::readMetadata(Connection *conn)
+{
+    std::string value;
+
+    // No bounds implies it covers the whole earth
+    double ll_lon = -180.0, ll_lat = -85.0511, ur_lon = 180.0, ur_lat = 85.0511;
+    if (ReadValue(conn->db, "SELECT value FROM metadata WHERE name='bounds';", value))
+    {
+        if (sscanf(value.c_str(), "%lf , %lf , %lf , %lf", &ll_lon, &ll_lat, &ur_lon, &ur_lat) != 4)
+        {
+            wkLogLevel(Error, "MBTilesReader: Bad bounds in %s", fileName.c_str());
+            return false;
+        }
+    }
+    geoMbr.ll() = GeoCoord::CoordFromDegrees(ll_lon,ll_lat);
+    geoMbr.ur() = GeoCoord::CoordFromDegrees(ur_lon,ur_lat);
+
+    // Read the levels the hard way if we have to
+    minZoom = 0;  maxZoom = 8;
+    if (ReadValue(conn->db, "SELECT value FROM metadata WHERE name='minzoom';", value) ||
+        ReadValue(conn->db, "SELECT min(zoom_level) FROM tiles;", value))
+        minZoom = atoi(value.c_str());
+    if (ReadValue(conn->db, "SELECT value FROM metadata WHERE name='maxzoom';", value) ||
+        ReadValue(conn->db, "SELECT max(zoom_level) FROM tiles;", value))
+        maxZoom = atoi(value.c_str());
+
+    if (ReadValue(conn->db, "SELECT value FROM metadata WHERE name='format';", value))
+        format = value;
+
+    // See if there's a tiles table or it's the older(?) style
+    tilesStyle = ReadValue(conn->db, "SELECT name FROM sqlite_master WHERE (type='table' OR type='view') AND name='tiles';", value);
+
+    return true;
+}
+
+RawDataRef MBTilesReader::makeTileData(Connection *conn,const void *data,int len)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    if (!bytes || len <= 0)
+        return RawDataRef();
+
+    // Gzipped, most likely a vector tile
+    if (decompress && len >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b)
+    {
+        z_stream &stream = conn->stream;
+        // Reuse the decompressor between tiles.  32 means detect the header.
+        if (!conn->streamInit)
+        {
+            if (inflateInit2(&stream, 15 + 32) != Z_OK)
+                return RawDataRef();
+            conn->streamInit = true;
+        } else
+            inflateReset(&stream);
+
+        std::vector<unsigned char> out(std::max(len * 4, 4096));
+        stream.next_in = (Bytef *)bytes;
+        stream.avail_in = len;
+        size_t outLen = 0;
+        int ret = Z_OK;
+        while (ret == Z_OK)
+        {
+            if (outLen == out.size())
+                out.resize(out.size() * 2);
+            stream.next_out = out.data() + outLen;
+            stream.avail_out = (uInt)(out.size() - outLen);
+            ret = inflate(&stream, Z_NO_FLUSH);
+            outLen = out.size() - stream.avail_out;
+        }
+        if (ret != Z_STREAM_END)
+        {
+            wkLogLevel(Warn, "MBTilesReader: Failed to decompress tile in %s", fileName.c_str());
+            return RawDataRef();
+        }
+        out.resize(outLen);
+
+        return std::make_shared<MBTileData>(std::move(out));
+    }
+
+    return std::make_shared<MBTileData>(std::vector<unsigned char>(bytes, bytes + len));
+}
+
+RawDataRef MBTilesReader::fetchTile(const QuadTreeIdentifier &ident)
+{
+    return fetchTiles(std::vector<QuadTreeIdentifier>{ident})[0];
+}
+
+std::vector<RawDataRef> MBTilesReader::fetchTiles(const std::vector<QuadTreeIdentifier> &idents)
+{
+    std::vector<RawDataRef> tiles(idents.size());
+    if (idents.empty())
+        return tiles;
+
+    ConnectionRef conn = getConnection();
+    if (!conn)
+        return tiles;
+
+    // Group the tiles by level and column.  Each group gets one query.
+    std::vector<size_t> order(idents.size());
+    for (size_t ii=0;ii<order.size();ii++)
+        order[ii] = ii;
+    std::sort(order.begin(), order.end(),
+              [&idents](size_t a,size_t b) {
+                  const QuadTreeIdentifier &ia = idents[a], &ib = idents[b];
+                  if (ia.level != ib.level)
+                      return ia.level < ib.level;
+                  if (ia.x != ib.x)
+                      return ia.x < ib.x;
+                  return ia.y < ib.y;
+              });
+
+    for (size_t start = 0; start < order.size(); )
+    {
+        const QuadTreeIdentifier &first = idents[order[start]];
+        size_t end = start + 1;
+        while (end < order.size() && end - start < MaxBatchSize &&
+               idents[order[end]].level == first.level && idents[order[end]].x == first.x)
+            end++;
+
+        // Round up so we don't prepare a statement for every possible size
+        const int numRows = (int)(end - start);
+        int numParams = 1;
+        while (numParams < numRows)
+            numParams *= 2;
+
+        sqlite3_stmt *stmt = conn->getBatchStmt(numParams, tilesStyle);
+        if (!stmt)
+            break;
+        sqlite3_bind_int(stmt, 1, first.level);
+        sqlite3_bind_int(stmt, 2, first.x);
+        for (int ii=0;ii<numParams;ii++)
+            sqlite3_bind_int(stmt, 3 + ii, idents[order[start + std::min(ii,numRows-1)]].y);
+
+        int ret;
+        while ((ret = sqlite3_step(stmt)) == SQLITE_ROW)
+        {
+            const int row = sqlite3_column_int(stmt, 0);
+            const auto data = makeTileData(conn.get(), sqlite3_column_blob(stmt, 1), sqlite3_column_bytes(stmt, 1));
+            // The same tile may have been asked for more than once
+            for (size_t ii=start;ii<end;ii++)
+                if (idents[order[ii]].y == row)
+                    tiles[order[ii]] = data;
+        }
+        if (ret != SQLITE_DONE)
+            wkLogLevel(Warn, "MBTilesReader: Query failed in %s: %s", fileName.c_str(), sqlite3_errmsg(conn->db));
+        sqlite3_reset(stmt);
+
+        start = end;
+    }
+
+    releaseConnection(std::move(conn));
+
+    return tiles;
+}
+
+}
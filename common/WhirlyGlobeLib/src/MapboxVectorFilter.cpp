@@ -21,6 +21,7 @@
 #import "MapboxVectorFilter.h"
 #import "MapboxVectorStyleSetC.h"
 #import "WhirlyKitLog.h"
+#import <cstring>
 
 namespace WhirlyKit
 {
@@ -201,4 +202,376 @@ bool MapboxVectorFilter::testFeature(const Dictionary &attrs,const QuadTreeIdent
     }
 }
 
+int MapboxVectorFilterProgram::addFilter(const MapboxVectorFilterRef &filter)
+{
+    return filter ? compile(filter) : -1;
+}
+
+int MapboxVectorFilterProgram::attrID(const std::string &name)
+{
+    const StringIdentity key = StringIndexer::getStringID(name);
+    const auto it = attrSlots.find(key);
+    if (it != attrSlots.end())
+        return it->second;
+
+    const int newID = (int)attrKeys.size();
+    attrKeys.push_back(key);
+    attrNames.push_back(name);
+    attrSlots[key] = newID;
+    return newID;
+}
+
+bool MapboxVectorFilterProgram::addValue(const DictionaryEntryRef &entry,std::string &key)
+{
+    if (!entry)
+        return false;
+
+    Value val;
+    val.type = entry->getType();
+    val.dVal = 0.0;
+    val.iVal = 0;
+    val.i64Val = 0;
+    switch (val.type)
+    {
+        case DictTypeString:
+            val.str = entry->getString();
+            key += "s" + std::to_string(val.str.size()) + ":" + val.str;
+            break;
+        case DictTypeInt:
+        case DictTypeInt64:
+        case DictTypeIdentity:
+        case DictTypeDouble:
+            val.dVal = entry->getDouble();
+            val.iVal = entry->getInt();
+            val.i64Val = (int64_t)entry->getIdentity();
+        {
+            // Use the exact bits so nearby values don't get merged
+            uint64_t dBits;
+            memcpy(&dBits,&val.dVal,sizeof(dBits));
+            key += "n" + std::to_string(val.type) + ":" + std::to_string(val.i64Val) + ":" + std::to_string(dBits);
+            break;
+        }
+        default:
+            return false;
+    }
+    key += ";";
+    values.push_back(val);
+    return true;
+}
+
+int MapboxVectorFilterProgram::addNode(const Node &node,const std::string &key)
+{
+    const auto it = nodeIDs.find(key);
+    if (it != nodeIDs.end())
+        return it->second;
+
+    const int newID = (int)nodes.size();
+    nodes.push_back(node);
+    nodeIDs[key] = newID;
+    return newID;
+}
+
+int MapboxVectorFilterProgram::compile(const MapboxVectorFilterRef &filter)
+{
+    Node node;
+    node.nodeType = NodeGeneric;
+    node.filterType = filter->filterType;
+    node.geomType = filter->geomType;
+    node.attr = -1;
+    node.firstArg = 0;
+    node.numArgs = 0;
+    node.filter = filter;
+
+    // Anything odd gets evaluated the old way, and isn't shared
+    const std::string genericKey = "g" + std::to_string((uintptr_t)filter.get());
+
+    std::string key;
+    switch (filter->filterType)
+    {
+        case MBFilterEqual:
+        case MBFilterNotEqual:
+        case MBFilterGreaterThan:
+        case MBFilterGreaterThanEqual:
+        case MBFilterLessThan:
+        case MBFilterLessThanEqual:
+            if (filter->geomType != MBGeomNone)
+            {
+                if (filter->filterType != MBFilterEqual && filter->filterType != MBFilterNotEqual)
+                    return addNode(node,genericKey);
+                node.nodeType = NodeGeom;
+                node.attr = attrID(geometryType);
+                key = "t" + std::to_string(filter->filterType) + ":" + std::to_string(filter->geomType);
+            }
+            else
+            {
+                const auto valStart = values.size();
+                node.attr = attrID(filter->attrName);
+                key = "c" + std::to_string(filter->filterType) + ":" + std::to_string(node.attr) + ":";
+                if (!addValue(filter->attrVal,key))
+                {
+                    values.resize(valStart);
+                    return addNode(node,genericKey);
+                }
+                node.nodeType = NodeCompare;
+                node.firstArg = valStart;
+                node.numArgs = 1;
+            }
+            break;
+        case MBFilterIn:
+        case MBFilterNotIn:
+        {
+            const auto valStart = values.size();
+            node.attr = attrID(filter->attrName);
+            key = "i" + std::to_string(filter->filterType) + ":" + std::to_string(node.attr) + ":";
+            for (const auto &val : filter->attrVals)
+            {
+                if (!addValue(val,key))
+                {
+                    values.resize(valStart);
+                    return addNode(node,genericKey);
+                }
+            }
+            node.nodeType = NodeIn;
+            node.firstArg = valStart;
+            node.numArgs = values.size() - valStart;
+            break;
+        }
+        case MBFilterHas:
+        case MBFilterNotHas:
+            node.nodeType = NodeHas;
+            node.attr = attrID(filter->attrName);
+            key = "h" + std::to_string(filter->filterType) + ":" + std::to_string(node.attr);
+            break;
+        case MBFilterAll:
+        case MBFilterAny:
+        {
+            // Children go first so they're shared when they can be
+            std::vector<int> subNodes;
+            subNodes.reserve(filter->subFilters.size());
+            key = "a" + std::to_string(filter->filterType) + ":";
+            for (const auto &subFilter : filter->subFilters)
+            {
+                const int subNode = compile(subFilter);
+                subNodes.push_back(subNode);
+                key += std::to_string(subNode) + ",";
+            }
+            node.nodeType = (filter->filterType == MBFilterAll) ? NodeAll : NodeAny;
+            node.firstArg = children.size();
+            node.numArgs = subNodes.size();
+            const auto it = nodeIDs.find(key);
+            if (it != nodeIDs.end())
+                return it->second;
+            children.insert(children.end(),subNodes.begin(),subNodes.end());
+            break;
+        }
+        default:
+            return addNode(node,genericKey);
+    }
+
+    return addNode(node,key);
+}
+
+void MapboxVectorFilterProgram::begin(State &state,const Dictionary &attrs,const QuadTreeIdentifier &tileID) const
+{
+    state.attrs = &attrs;
+    // The tile parser's records can be searched by key directly
+    const auto flatAttrs = dynamic_cast<const FlatDictionary *>(&attrs);
+    state.flatAttrs = (flatAttrs && flatAttrs->isFlat()) ? flatAttrs : nullptr;
+    state.tileID = &tileID;
+    state.results.assign(nodes.size(),-1);
+    if (state.attrVals.size() < attrKeys.size())
+        state.attrVals.resize(attrKeys.size());
+    for (unsigned int ii=0;ii<attrKeys.size();ii++)
+        state.attrVals[ii].fetched = false;
+}
+
+bool MapboxVectorFilterProgram::test(State &state,int node) const
+{
+    return node < 0 || eval(state,node);
+}
+
+const MapboxVectorFilterProgram::State::Attr &MapboxVectorFilterProgram::fetch(State &state,int attr) const
+{
+    auto &val = state.attrVals[attr];
+    if (val.fetched)
+        return val;
+    val.fetched = true;
+    val.str = std::string_view();
+    val.dVal = 0.0;
+    val.iVal = 0;
+    val.i64Val = 0;
+
+    // Same conversions as FlatDictionary's getters
+    if (state.flatAttrs)
+    {
+        const FlatAttr *flatAttr = state.flatAttrs->findAttr(attrKeys[attr]);
+        val.type = flatAttr ? flatAttr->type : DictTypeNone;
+        switch (val.type)
+        {
+            case DictTypeString:
+                val.str = flatAttr->getStringView();
+                break;
+            case DictTypeInt:
+                val.dVal = flatAttr->iVal;
+                val.iVal = flatAttr->iVal;
+                val.i64Val = flatAttr->iVal;
+                break;
+            case DictTypeInt64:
+            case DictTypeIdentity:
+                val.dVal = (double)flatAttr->i64Val;
+                val.iVal = (int)flatAttr->i64Val;
+                val.i64Val = flatAttr->i64Val;
+                break;
+            case DictTypeDouble:
+                val.dVal = flatAttr->dVal;
+                val.iVal = (int)flatAttr->dVal;
+                val.i64Val = (int64_t)flatAttr->dVal;
+                break;
+            default:
+                break;
+        }
+        return val;
+    }
+
+    const auto &name = attrNames[attr];
+    val.type = state.attrs->getType(name);
+    switch (val.type)
+    {
+        case DictTypeString:
+            val.strStore = state.attrs->getString(name);
+            val.str = val.strStore;
+            break;
+        case DictTypeInt:
+        case DictTypeInt64:
+        case DictTypeIdentity:
+        case DictTypeDouble:
+            val.dVal = state.attrs->getDouble(name);
+            val.iVal = state.attrs->getInt(name);
+            val.i64Val = state.attrs->getInt64(name);
+            break;
+        default:
+            break;
+    }
+    return val;
+}
+
+bool MapboxVectorFilterProgram::eval(State &state,int node) const
+{
+    auto &result = state.results[node];
+    if (result < 0)
+        result = evalNode(state,nodes[node]) ? 1 : 0;
+    return result != 0;
+}
+
+// Compare a style constant to a feature value the way DictionaryEntry::isEqual would.
+// Returns -1 for combinations we leave to the original filter.
+static int valuesEqual(DictionaryType valType,const std::string &valStr,double valD,int valI,int64_t valI64,
+                       DictionaryType attrType,std::string_view attrStr,double attrD,int attrI,int64_t attrI64)
+{
+    const bool attrIsNum = (attrType == DictTypeInt || attrType == DictTypeInt64 ||
+                            attrType == DictTypeIdentity || attrType == DictTypeDouble);
+    switch (valType)
+    {
+        case DictTypeString:   return (attrType == DictTypeString) ? (valStr == attrStr) : -1;
+        case DictTypeInt:      return attrIsNum ? (valI == attrI) : -1;
+        case DictTypeInt64:
+        case DictTypeIdentity: return attrIsNum ? (valI64 == attrI64) : -1;
+        case DictTypeDouble:   return attrIsNum ? (valD == attrD) : -1;
+        default:               return -1;
+    }
+}
+
+bool MapboxVectorFilterProgram::evalNode(State &state,const Node &node) const
+{
+    switch (node.nodeType)
+    {
+        case NodeGeom:
+        {
+            const int geomType = fetch(state,node.attr).iVal - 1;
+            return (node.filterType == MBFilterEqual) ? (geomType == node.geomType) : (geomType != node.geomType);
+        }
+        case NodeHas:
+            return (fetch(state,node.attr).type != DictTypeNone) == (node.filterType == MBFilterHas);
+        case NodeAll:
+            for (unsigned int ii=0;ii<node.numArgs;ii++)
+                if (!eval(state,children[node.firstArg+ii]))
+                    return false;
+            return true;
+        case NodeAny:
+            for (unsigned int ii=0;ii<node.numArgs;ii++)
+                if (eval(state,children[node.firstArg+ii]))
+                    return true;
+            return false;
+        case NodeIn:
+        {
+            const auto &attr = fetch(state,node.attr);
+            const bool isIn = (node.filterType == MBFilterIn);
+            switch (attr.type)
+            {
+                case DictTypeNone:
+                    return !isIn;
+                case DictTypeString:
+                case DictTypeInt:
+                case DictTypeInt64:
+                case DictTypeIdentity:
+                case DictTypeDouble:
+                    break;
+                default:
+                    return node.filter->testFeature(*state.attrs,*state.tileID);
+            }
+            for (unsigned int ii=0;ii<node.numArgs;ii++)
+            {
+                const auto &val = values[node.firstArg+ii];
+                const int eq = valuesEqual(val.type,val.str,val.dVal,val.iVal,val.i64Val,
+                                           attr.type,attr.str,attr.dVal,attr.iVal,attr.i64Val);
+                if (eq < 0)
+                    return node.filter->testFeature(*state.attrs,*state.tileID);
+                if (eq)
+                    return isIn;
+            }
+            return !isIn;
+        }
+        case NodeCompare:
+        {
+            const auto &attr = fetch(state,node.attr);
+            const auto &val = values[node.firstArg];
+            switch (attr.type)
+            {
+                case DictTypeNone:
+                    // A missing value and != is valid
+                    return (node.filterType == MBFilterNotEqual);
+                case DictTypeString:
+                    if (val.type != DictTypeString)
+                        break;
+                    switch (node.filterType)
+                    {
+                        case MBFilterEqual:    return attr.str == val.str;
+                        case MBFilterNotEqual: return attr.str != val.str;
+                        default: return true;  // Note: Not expecting other comparisons to strings
+                    }
+                case DictTypeInt:
+                case DictTypeDouble:
+                    if (val.type == DictTypeString)
+                        break;
+                    switch (node.filterType)
+                    {
+                        case MBFilterEqual:            return attr.dVal == val.dVal;
+                        case MBFilterNotEqual:         return attr.dVal != val.dVal;
+                        case MBFilterGreaterThan:      return attr.dVal > val.dVal;
+                        case MBFilterGreaterThanEqual: return attr.dVal >= val.dVal;
+                        case MBFilterLessThan:         return attr.dVal < val.dVal;
+                        case MBFilterLessThanEqual:    return attr.dVal <= val.dVal;
+                        default: return true;
+                    }
+                default:
+                    break;
+            }
+            return node.filter->testFeature(*state.attrs,*state.tileID);
+        }
+        case NodeGeneric:
+        default:
+            return node.filter->testFeature(*state.attrs,*state.tileID);
+    }
+}
+
 }
@@ -505,7 +505,16 @@ bool MapboxVectorStyleSetImpl::parse(PlatformThreadInfo *inst,const DictionaryRe
         }
         which++;
     }
-    
+
+    // Compile the filters once, grouped by source layer, so the ones that
+    //  look at the same features can share work
+    filtersBySource.clear();
+    for (const auto &it : layersBySource)
+    {
+        auto &filters = filtersBySource[it.first];
+        filters.layers.emplace_back(it.second, filters.program.addFilter(it.second->filter));
+    }
+
     return true;
 }
 
@@ -960,17 +969,26 @@ std::vector<VectorStyleImplRef> MapboxVectorStyleSetImpl::stylesForFeature(Platf
 {
     std::vector<VectorStyleImplRef> styles;
 
-    const auto range = layersBySource.equal_range(layerName);
-    for (auto i = range.first; i != range.second; ++i)
+    const auto it = filtersBySource.find(layerName);
+    if (it == filtersBySource.end())
+    {
+        return styles;
+    }
+
+    // Filter results and attribute lookups are cached in here for the one feature
+    static thread_local MapboxVectorFilterProgram::State filterState;
+
+    const auto &filters = it->second;
+    filters.program.begin(filterState, attrs, tileID);
+    for (const auto &layerFilter : filters.layers)
     {
-        auto &layer = i->second;
-        if (!layer->filter || layer->filter->testFeature(attrs, tileID))
+        if (filters.program.test(filterState, layerFilter.second))
         {
             if (styles.empty())
             {
-                styles.reserve(std::distance(range.first, range.second));
+                styles.reserve(filters.layers.size());
             }
-            styles.push_back(layer);
+            styles.push_back(layerFilter.first);
         }
     }
     
@@ -1008,7 +1026,7 @@ std::vector<VectorStyleImplRef> MapboxVectorStyleSetImpl::allStyles(PlatformThre
 
 void MapboxVectorStyleSetImpl::addSprites(MapboxVectorStyleSpritesRef newSprites)
 {
-    sprites = std::move(newSprites);
+    std::atomic_store(&sprites, std::move(newSprites));
 }
 
 //#define LOW_LEVEL_UNIT_TESTS
@@ -21,6 +21,7 @@
 #import "WhirlyKitLog.h"
 #import <vector>
 #import <regex>
+#import <atomic>
 
 namespace WhirlyKit
 {
@@ -321,8 +322,12 @@ std::unique_ptr<Marker> MapboxVectorLayerSymbol::setupMarker(PlatformThreadInfo
     if (symbolName.empty())
         return nullptr;
 
+    const auto sprites = styleSet->getSprites();
+    if (!sprites)
+        return nullptr;
+
     Point2d markerSize;
-    const auto subTex = styleSet->sprites->getTexture(symbolName,markerSize);
+    const auto subTex = sprites->getTexture(symbolName,markerSize);
 
     if (markerSize.x() == 0.0)
     {
@@ -451,7 +456,7 @@ void MapboxVectorLayerSymbol::buildObjects(PlatformThreadInfo *inst,
     const auto textField = (textColor && textSize > 0.0 && layout.textField) ?
                             layout.textField->textForZoom(zoomLevel) : MapboxRegexField();
 
-    const bool iconInclude = layout.iconImageField && styleSet->sprites;
+    const bool iconInclude = layout.iconImageField && styleSet->getSprites();
     const bool textInclude = (textField.valid && !textField.chunks.empty());
     if (!textInclude && !iconInclude)
     {
@@ -557,7 +562,7 @@ void MapboxVectorLayerSymbol::buildObjects(PlatformThreadInfo *inst,
 #if DEBUG
             if (vecObj->shapes.size() > 1)
             {
-                static int warned = 0;
+                static std::atomic<int> warned(0);
                 if (!warned++)
                 {
                     wkLogLevel(Warn, "MapboxVectorLayerSymbol: Linear vector object contains %d shapes", vecObj->shapes.size());
@@ -627,7 +632,7 @@ void MapboxVectorLayerSymbol::buildObjects(PlatformThreadInfo *inst,
 #if DEBUG
             if (vecObj->shapes.size() > 1)
             {
-                static int warned = 0;
+                static std::atomic<int> warned(0);
                 if (!warned++)
                 {
                     wkLogLevel(Warn, "MapboxVectorLayerSymbol: Areal vector object contains %d shapes", vecObj->shapes.size());
@@ -25,6 +25,11 @@
 
 #include <utility>
 #import <vector>
+#import <algorithm>
+#import <atomic>
+#import <condition_variable>
+#import <deque>
+#import <thread>
 
 using namespace Eigen;
 
@@ -32,11 +37,12 @@ namespace WhirlyKit
 {
     
 VectorTileData::VectorTileData()
+    : attrArena(std::make_shared<AttrArena>())
 {
 }
     
 VectorTileData::VectorTileData(const VectorTileData &that)
-    : ident(that.ident), bbox(that.bbox), geoBBox(that.geoBBox)
+    : ident(that.ident), bbox(that.bbox), geoBBox(that.geoBBox), attrArena(std::make_shared<AttrArena>())
 {
 }
     
@@ -81,6 +87,9 @@ void VectorTileData::clear()
     categories.clear();
     
     changes.clear();
+
+    // Anything still using the old attributes keeps the old arena alive
+    attrArena = std::make_shared<AttrArena>();
 }
 
 MapboxVectorTileParser::MapboxVectorTileParser(PlatformThreadInfo *inst,VectorStyleDelegateImplRef styleDelegate)
@@ -99,6 +108,184 @@ MapboxVectorTileParser::MapboxVectorTileParser(PlatformThreadInfo *inst,VectorSt
 
 MapboxVectorTileParser::~MapboxVectorTileParser()
 {
+    buildPool.reset();
+}
+
+/**
+ Worker threads for building a tile's styles in parallel.
+ Each call to run() posts a batch of tasks.  Workers, and the thread that called run(),
+  pull tasks from the oldest unfinished batch until it's drained.  Several loader threads
+  can be running batches at once.
+ */
+class MapboxVectorTileParser::BuildPool
+{
+public:
+    using Task = std::function<void(PlatformThreadInfo *,size_t)>;
+
+    BuildPool(unsigned int numThreads,ThreadInfoMaker makeInfo,ThreadInfoReleaser releaseInfo)
+        : makeInfo(std::move(makeInfo)), releaseInfo(std::move(releaseInfo))
+    {
+        threads.reserve(numThreads);
+        for (unsigned int ii=0;ii<numThreads;ii++)
+        {
+            threads.emplace_back([this]{ workerMain(); });
+        }
+    }
+
+    ~BuildPool()
+    {
+        {
+            std::lock_guard<std::mutex> guardLock(lock);
+            stopping = true;
+        }
+        cond.notify_all();
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    /// Number of workers that got their platform info and are taking tasks
+    unsigned int numWorkers() const { return readyWorkers.load(); }
+
+    /// Run the tasks on the pool and the calling thread, returning when they're all done
+    void run(PlatformThreadInfo *inst,size_t numTasks,const Task &task)
+    {
+        auto batch = std::make_shared<Batch>(numTasks,task);
+        {
+            std::lock_guard<std::mutex> guardLock(lock);
+            batches.push_back(batch);
+        }
+        cond.notify_all();
+
+        while (runOne(*batch,inst))
+        {
+        }
+
+        // Wait for anything the workers are still on
+        {
+            std::unique_lock<std::mutex> batchLock(batch->lock);
+            batch->cond.wait(batchLock,[&]{ return batch->done == batch->numTasks; });
+        }
+
+        retire(batch);
+    }
+
+protected:
+    struct Batch
+    {
+        Batch(size_t numTasks,const Task &task) : numTasks(numTasks), task(task) { }
+
+        const size_t numTasks;
+        const Task &task;
+        std::atomic<size_t> next { 0 };
+        std::atomic<size_t> done { 0 };
+        std::mutex lock;
+        std::condition_variable cond;
+    };
+    typedef std::shared_ptr<Batch> BatchRef;
+
+    // Grab the next task in the batch and run it.  Returns false if there weren't any left.
+    bool runOne(Batch &batch,PlatformThreadInfo *inst)
+    {
+        const size_t which = batch.next.fetch_add(1);
+        if (which >= batch.numTasks)
+        {
+            return false;
+        }
+
+        try
+        {
+            batch.task(inst,which);
+        }
+        catch (const std::exception &ex)
+        {
+            wkLogLevel(Error, "MapboxVectorTileParser: Exception building style: %s", ex.what());
+        }
+        catch (...)
+        {
+            wkLogLevel(Error, "MapboxVectorTileParser: Exception building style");
+        }
+
+        if (batch.done.fetch_add(1) + 1 == batch.numTasks)
+        {
+            std::lock_guard<std::mutex> batchLock(batch.lock);
+            batch.cond.notify_all();
+        }
+        return true;
+    }
+
+    void retire(const BatchRef &batch)
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        const auto it = std::find(batches.begin(),batches.end(),batch);
+        if (it != batches.end())
+        {
+            batches.erase(it);
+        }
+    }
+
+    void workerMain()
+    {
+        // Styles can't run without the platform info (e.g. the JNI env), so don't take any tasks
+        PlatformThreadInfo *inst = makeInfo ? makeInfo() : nullptr;
+        if (!inst)
+        {
+            wkLogLevel(Warn, "MapboxVectorTileParser: No platform info for a build thread, it won't be used");
+            return;
+        }
+        readyWorkers++;
+
+        while (true)
+        {
+            BatchRef batch;
+            {
+                std::unique_lock<std::mutex> guardLock(lock);
+                cond.wait(guardLock,[this]{ return stopping || !batches.empty(); });
+                if (stopping)
+                {
+                    break;
+                }
+                batch = batches.front();
+            }
+
+            while (runOne(*batch,inst))
+            {
+            }
+
+            // Nothing left to hand out, so nobody else needs to see it
+            retire(batch);
+        }
+
+        readyWorkers--;
+        if (releaseInfo)
+        {
+            releaseInfo(inst);
+        }
+    }
+
+    ThreadInfoMaker makeInfo;
+    ThreadInfoReleaser releaseInfo;
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    std::condition_variable cond;
+    std::deque<BatchRef> batches;
+    bool stopping = false;
+    std::atomic<unsigned int> readyWorkers { 0 };
+};
+
+void MapboxVectorTileParser::setParallelBuild(unsigned int numThreads,
+                                              ThreadInfoMaker makeInfo,
+                                              ThreadInfoReleaser releaseInfo)
+{
+    // The loader threads may be parsing, so swap the pool atomically.
+    // Any parse still using the old one keeps it alive until it's done.
+    std::shared_ptr<BuildPool> newPool;
+    if (numThreads > 0 && makeInfo)
+    {
+        newPool = std::make_shared<BuildPool>(numThreads,std::move(makeInfo),std::move(releaseInfo));
+    }
+    std::atomic_store(&buildPool,newPool);
 }
 
 void MapboxVectorTileParser::setUUIDName(const std::string &name)
@@ -147,12 +334,21 @@ bool MapboxVectorTileParser::parse(PlatformThreadInfo *styleInst,
 //    wkLogLevel(Verbose, "MapboxVectorTileParser: Parse [%d/%d/%d] starting",
 //               tileData->ident.level, tileData->ident.x, tileData->ident.y);
 //#endif
+    WK_TRACE_SCOPE_ID("MapboxVectorTileParser::parse",
+                      PerformanceTrace::tileID(tileData->ident.level,tileData->ident.x,tileData->ident.y));
+
     const auto t0 = std::chrono::steady_clock::now();
 
     VectorTilePBFParser parser(tileData, &*styleDelegate, styleInst, filterName, filterValues,
                                tileData->vecObjsByStyle, localCoords, parseAll,
                                keepVectors ? &tileData->vecObjs : nullptr, cancelFn);
-    if (!parser.parse(rawData->getRawData(), rawData->getLen()))
+    bool parsed;
+    {
+        WK_TRACE_SCOPE_ID("MapboxVectorTileParser decode",
+                          PerformanceTrace::tileID(tileData->ident.level,tileData->ident.x,tileData->ident.y));
+        parsed = parser.parse(rawData->getRawData(), rawData->getLen());
+    }
+    if (!parsed)
     {
         if (parser.getParseCancelled())
         {
@@ -203,37 +399,58 @@ bool MapboxVectorTileParser::parse(PlatformThreadInfo *styleInst,
 //        tileData->mergeFrom(styleData.get());
 //    }
     
-    // Run the styles over their assembled data
-    for (const auto &it : tileData->vecObjsByStyle)
+    // Run the styles over their assembled data.
+    // Keep a reference to the pool in case it's replaced while we're running.
+    const auto pool = std::atomic_load(&buildPool);
+    if (pool && pool->numWorkers() > 0 && tileData->vecObjsByStyle.size() > 1)
     {
-        std::vector<VectorObjectRef> &vecs = *it.second;
+        // Each style builds into its own data, then we merge in the usual order
+        const std::vector<std::pair<SimpleIdentity,std::vector<VectorObjectRef> *>> styleVecs(
+                tileData->vecObjsByStyle.begin(), tileData->vecObjsByStyle.end());
+        std::vector<VectorTileDataRef> styleResults(styleVecs.size());
 
-        auto styleData = std::make_shared<VectorTileData>(*tileData);
-
-        // Ask the subclass to run the style and fill in the VectorTileData
-        buildForStyle(styleInst,it.first,vecs,styleData,cancelFn);
+        pool->run(styleInst, styleVecs.size(), [&](PlatformThreadInfo *inst, size_t which)
+        {
+            if (cancelFn(inst))
+            {
+                return;
+            }
+            auto styleData = std::make_shared<VectorTileData>(*tileData);
+            buildForStyle(inst,styleVecs[which].first,*styleVecs[which].second,styleData,cancelFn);
+            styleResults[which] = std::move(styleData);
+        });
 
         if (cancelFn(styleInst))
         {
             return false;
         }
 
-        // Sort the results into categories if needed
-        auto catIt = styleCategories.find(it.first);
-        if (catIt != styleCategories.end() && !styleData->compObjs.empty())
+        for (size_t ii=0;ii<styleVecs.size();ii++)
         {
-            const std::string &category = catIt->second;
-            auto compObjs = styleData->compObjs;
-            auto categoryIt = tileData->categories.find(category);
-            if (categoryIt != tileData->categories.end())
+            if (styleResults[ii])
             {
-                compObjs.insert(compObjs.end(), categoryIt->second.begin(), categoryIt->second.end());
+                mergeStyleData(styleVecs[ii].first,tileData,styleResults[ii].get());
             }
-            tileData->categories[category] = compObjs;
         }
-        
-        // Merge this into the general return data
-        tileData->mergeFrom(styleData.get());
+    }
+    else
+    {
+        for (const auto &it : tileData->vecObjsByStyle)
+        {
+            std::vector<VectorObjectRef> &vecs = *it.second;
+
+            auto styleData = std::make_shared<VectorTileData>(*tileData);
+
+            // Ask the subclass to run the style and fill in the VectorTileData
+            buildForStyle(styleInst,it.first,vecs,styleData,cancelFn);
+
+            if (cancelFn(styleInst))
+            {
+                return false;
+            }
+
+            mergeStyleData(it.first,tileData,styleData.get());
+        }
     }
     
     // These are layered on top for debugging
@@ -283,12 +500,35 @@ bool MapboxVectorTileParser::parse(PlatformThreadInfo *styleInst,
     return true;
 }
 
+void MapboxVectorTileParser::mergeStyleData(long long styleID,VectorTileData *tileData,VectorTileData *styleData)
+{
+    // Sort the results into categories if needed
+    auto catIt = styleCategories.find(styleID);
+    if (catIt != styleCategories.end() && !styleData->compObjs.empty())
+    {
+        const std::string &category = catIt->second;
+        auto compObjs = styleData->compObjs;
+        auto categoryIt = tileData->categories.find(category);
+        if (categoryIt != tileData->categories.end())
+        {
+            compObjs.insert(compObjs.end(), categoryIt->second.begin(), categoryIt->second.end());
+        }
+        tileData->categories[category] = compObjs;
+    }
+    
+    // Merge this into the general return data
+    tileData->mergeFrom(styleData);
+}
+
 void MapboxVectorTileParser::buildForStyle(PlatformThreadInfo *styleInst,
                                            long long styleID,
                                            const std::vector<VectorObjectRef> &vecObjs,
                                            const VectorTileDataRef &data,
                                            const CancelFunction &cancelFn)
     {
+        WK_TRACE_SCOPE_ID("MapboxVectorTileParser::buildForStyle",
+                          PerformanceTrace::tileID(data->ident.level,data->ident.x,data->ident.y));
+
         if (auto style = styleDelegate->styleForUUID(styleInst,styleID))
         {
             style->buildObjects(styleInst,vecObjs,data,nullptr,cancelFn);
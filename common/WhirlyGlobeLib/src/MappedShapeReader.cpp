@@ -0,0 +1,482 @@
+/*
+ *  MappedShapeReader.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+#import "MappedShapeReader.h"
+#import "CoordSystem.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+// Shape types from the spec.  Z and M variants share the XY layout.
+enum {
+    ShpNull = 0,
+    ShpPoint = 1, ShpPointZ = 11, ShpPointM = 21,
+    ShpArc = 3, ShpArcZ = 13, ShpArcM = 23,
+    ShpPolygon = 5, ShpPolygonZ = 15, ShpPolygonM = 25,
+    ShpMultiPoint = 8, ShpMultiPointZ = 18, ShpMultiPointM = 28
+};
+
+// Shapefiles are little endian apart from a few header fields, as is everything we run on
+static inline uint32_t ReadLE32(const unsigned char *ptr)
+{
+    uint32_t val;
+    memcpy(&val, ptr, sizeof(val));
+    return val;
+}
+
+static inline uint32_t ReadBE32(const unsigned char *ptr)
+{
+    return (uint32_t)ptr[0] << 24 | (uint32_t)ptr[1] << 16 | (uint32_t)ptr[2] << 8 | ptr[3];
+}
+
+static inline uint16_t ReadLE16(const unsigned char *ptr)
+{
+    return (uint16_t)(ptr[0] | ptr[1] << 8);
+}
+
+// Convert a run of XY doubles in degrees to radians
+static void ReadPoints(const unsigned char *src,const unsigned char *srcEnd,VectorRing &pts)
+{
+    const size_t numPts = (srcEnd - src) / 16;
+    pts.resize(numPts);
+    for (size_t ii=0;ii<numPts;ii++,src+=16)
+    {
+        double xy[2];
+        memcpy(xy, src, sizeof(xy));
+        pts[ii] = Point2f(DegToRad<float>(xy[0]),DegToRad<float>(xy[1]));
+    }
+}
+
+MappedShapeReader::MappedFile::MappedFile()
+: data(nullptr), len(0)
+{
+}
+
+MappedShapeReader::MappedFile::~MappedFile()
+{
+    if (data)
+        munmap((void *)data, len);
+}
+
+bool MappedShapeReader::MappedFile::open(const std::string &fileName)
+{
+    const int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping hangs around after the file is closed
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    data = (const unsigned char *)map;
+    len = info.st_size;
+
+    return true;
+}
+
+MappedShapeReader::MappedShapeReader(const std::string &fileName)
+: valid(false), shapeType(ShpNull), where(0), numDbfRecords(0), dbfHeaderLen(0), dbfRecordLen(0)
+{
+    // Like shapelib, we'll take the name with or without an extension
+    std::string baseName = fileName;
+    const size_t len = baseName.size();
+    if (len > 4 && baseName[len-4] == '.' &&
+        (!strcasecmp(&baseName[len-3], "shp") || !strcasecmp(&baseName[len-3], "shx") || !strcasecmp(&baseName[len-3], "dbf")))
+        baseName.resize(len-4);
+
+    valid = openFiles(baseName) && readIndex();
+    if (valid && dbf.data && !readDbfHeader())
+    {
+        wkLogLevel(Warn, "MappedShapeReader: Ignoring bad attribute file for %s", fileName.c_str());
+        numDbfRecords = 0;
+        fields.clear();
+    }
+}
+
+MappedShapeReader::~MappedShapeReader()
+{
+}
+
+bool MappedShapeReader::openFiles(const std::string &baseName)
+{
+    if (!shp.open(baseName + ".shp") && !shp.open(baseName + ".SHP"))
+        return false;
+    if (!shx.open(baseName + ".shx"))
+        shx.open(baseName + ".SHX");
+    if (!dbf.open(baseName + ".dbf"))
+        dbf.open(baseName + ".DBF");
+
+    return true;
+}
+
+bool MappedShapeReader::readIndex()
+{
+    // File code and shape type from the header
+    if (shp.len < 100 || ReadBE32(shp.data) != 9994)
+    {
+        wkLogLevel(Error, "MappedShapeReader: Not a shapefile");
+        return false;
+    }
+    shapeType = (int)ReadLE32(shp.data + 32);
+
+    if (shx.data && shx.len >= 100 && ReadBE32(shx.data) == 9994)
+    {
+        // Offsets are in 16 bit words
+        const size_t numRecords = (shx.len - 100) / 8;
+        recordOffsets.resize(numRecords);
+        for (size_t ii=0;ii<numRecords;ii++)
+            recordOffsets[ii] = ReadBE32(shx.data + 100 + ii*8) * 2;
+    } else {
+        // No index, so walk the records
+        size_t pos = 100;
+        while (pos + 8 <= shp.len)
+        {
+            recordOffsets.push_back((uint32_t)pos);
+            pos += 8 + (size_t)ReadBE32(shp.data + pos + 4) * 2;
+        }
+    }
+
+    return true;
+}
+
+bool MappedShapeReader::readDbfHeader()
+{
+    if (dbf.len < 32)
+        return false;
+    numDbfRecords = ReadLE32(dbf.data + 4);
+    dbfHeaderLen = ReadLE16(dbf.data + 8);
+    dbfRecordLen = ReadLE16(dbf.data + 10);
+    if (dbfHeaderLen > dbf.len || dbfRecordLen == 0)
+        return false;
+    // Don't trust the record count past the end of the file
+    numDbfRecords = std::min(numDbfRecords, (unsigned int)((dbf.len - dbfHeaderLen) / dbfRecordLen));
+
+    // Field descriptors run until the terminator.  Records start with a deleted flag.
+    int offset = 1;
+    for (unsigned int pos = 32; pos + 32 <= dbfHeaderLen && dbf.data[pos] != 0x0D; pos += 32)
+    {
+        const unsigned char *info = dbf.data + pos;
+        Field field;
+        char name[12];
+        strncpy(name, (const char *)info, 11);
+        name[11] = 0;
+        for (int ii = 10; ii > 0 && name[ii] == ' '; ii--)
+            name[ii] = 0;
+        field.name = name;
+        field.dbfType = (char)info[11];
+        field.offset = offset;
+        int decimals = 0;
+        if (field.dbfType == 'N' || field.dbfType == 'F')
+        {
+            field.width = info[16];
+            decimals = info[17];
+        } else
+            field.width = info[16] + info[17] * 256;
+        offset += field.width;
+
+        // Same interpretation as shapelib.  We skip logicals, like ShapeReader.
+        if (field.dbfType == 'L')
+            field.type = DictTypeNone;
+        else if (field.dbfType == 'N' || field.dbfType == 'F')
+            field.type = (decimals > 0 || field.width > 10) ? DictTypeDouble : DictTypeInt;
+        else
+            field.type = DictTypeString;
+        fields.push_back(field);
+    }
+
+    return offset <= (int)dbfRecordLen;
+}
+
+bool MappedShapeReader::isValid()
+{
+    return valid;
+}
+
+unsigned int MappedShapeReader::getNumObjects()
+{
+    return recordOffsets.size();
+}
+
+std::vector<const MappedShapeReader::Field *> MappedShapeReader::projectFields(const StringSet *filterAttrs) const
+{
+    std::vector<const Field *> projFields;
+    projFields.reserve(fields.size());
+    for (const auto &field : fields)
+        if (field.type != DictTypeNone && (!filterAttrs || filterAttrs->find(field.name) != filterAttrs->end()))
+            projFields.push_back(&field);
+
+    return projFields;
+}
+
+VectorShapeRef MappedShapeReader::decodeShape(unsigned int which) const
+{
+    const size_t off = recordOffsets[which];
+    if (off + 12 > shp.len)
+        return VectorShapeRef();
+    const unsigned char *content = shp.data + off + 8;
+    const unsigned char *contentEnd = content + std::min((size_t)ReadBE32(shp.data + off + 4) * 2, shp.len - off - 8);
+    const size_t contentLen = contentEnd - content;
+
+    switch (ReadLE32(content))
+    {
+        case ShpPoint:
+        case ShpPointZ:
+        case ShpPointM:
+        {
+            if (contentLen < 20)
+                return VectorShapeRef();
+            VectorPointsRef points = VectorPoints::createPoints();
+            ReadPoints(content + 4, content + 20, points->pts);
+            points->initGeoMbr();
+            return points;
+        }
+        case ShpMultiPoint:
+        case ShpMultiPointZ:
+        case ShpMultiPointM:
+        {
+            // Bounding box, then the points
+            if (contentLen < 40)
+                return VectorShapeRef();
+            // Compare counts rather than byte lengths, which can overflow a 32 bit size_t
+            const size_t numPoints = ReadLE32(content + 36);
+            if (numPoints > (contentLen - 40) / 16)
+                return VectorShapeRef();
+            VectorPointsRef points = VectorPoints::createPoints();
+            ReadPoints(content + 40, content + 40 + numPoints * 16, points->pts);
+            points->initGeoMbr();
+            return points;
+        }
+        case ShpArc:
+        case ShpArcZ:
+        case ShpArcM:
+        case ShpPolygon:
+        case ShpPolygonZ:
+        case ShpPolygonM:
+        {
+            // Bounding box, then the part starts and the points
+            if (contentLen < 44)
+                return VectorShapeRef();
+            // Check the counts against what's left before multiplying, so a bad header can't overflow
+            const size_t numParts = ReadLE32(content + 36);
+            const size_t numPoints = ReadLE32(content + 40);
+            if (numParts > (contentLen - 44) / 4 || numPoints > (contentLen - 44 - numParts * 4) / 16)
+                return VectorShapeRef();
+            const unsigned char *parts = content + 44;
+            const unsigned char *points = parts + numParts * 4;
+
+            const int type = (int)ReadLE32(content);
+            if (type == ShpArc || type == ShpArcZ || type == ShpArcM)
+            {
+                // As with ShapeReader, the parts run together into one linear
+                VectorLinearRef linear = VectorLinear::createLinear();
+                ReadPoints(points, points + numPoints * 16, linear->pts);
+                linear->initGeoMbr();
+                return linear;
+            }
+
+            // Each part is a loop
+            VectorArealRef areal = VectorAreal::createAreal();
+            areal->loops.reserve(numParts);
+            for (size_t ii=0;ii<numParts;ii++)
+            {
+                const size_t start = std::min((size_t)ReadLE32(parts + ii*4), numPoints);
+                const size_t end = ii+1 < numParts ? std::min((size_t)ReadLE32(parts + (ii+1)*4), numPoints) : numPoints;
+                if (end <= start)
+                    continue;
+                areal->loops.resize(areal->loops.size()+1);
+                ReadPoints(points + start * 16, points + end * 16, areal->loops.back());
+            }
+            areal->initGeoMbr();
+            return areal;
+        }
+        default:
+            // Null shapes and multipatches
+            return VectorShapeRef();
+    }
+}
+
+MutableDictionaryRef MappedShapeReader::decodeAttrs(unsigned int which,const std::vector<const Field *> &projFields) const
+{
+    MutableDictionaryRef dict = MutableDictionaryMake();
+
+    if (which < numDbfRecords)
+    {
+        const char *rec = (const char *)dbf.data + dbfHeaderLen + (size_t)which * dbfRecordLen;
+        for (const Field *field : projFields)
+        {
+            // Trim the spaces off both ends, as shapelib does
+            const char *val = rec + field->offset;
+            const char *valEnd = val + strnlen(val, field->width);
+            while (val < valEnd && *val == ' ')
+                val++;
+            while (valEnd > val && valEnd[-1] == ' ')
+                valEnd--;
+            const size_t valLen = valEnd - val;
+
+            switch (field->type)
+            {
+                case DictTypeInt:
+                case DictTypeDouble:
+                {
+                    // Blank or asterisks mean null
+                    if (valLen == 0 || *val == '*')
+                        break;
+                    char buf[256];
+                    memcpy(buf, val, valLen);
+                    buf[valLen] = 0;
+                    const double dVal = strtod(buf, nullptr);
+                    if (field->type == DictTypeInt)
+                        dict->setInt(field->name, (int)dVal);
+                    else
+                        dict->setDouble(field->name, dVal);
+                }
+                    break;
+                case DictTypeString:
+                    if (valLen == 0 || (field->dbfType == 'D' && valLen >= 8 && !strncmp(val, "00000000", 8)))
+                        break;
+                    dict->setString(field->name, std::string(val, valLen));
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    // Let the user know what index this is
+    dict->setInt("wgshapefileidx", which);
+
+    return dict;
+}
+
+VectorShapeRef MappedShapeReader::makeEmptyShape() const
+{
+    switch (shapeType)
+    {
+        case ShpArc: case ShpArcZ: case ShpArcM:
+            return VectorLinear::createLinear();
+        case ShpPolygon: case ShpPolygonZ: case ShpPolygonM:
+            return VectorAreal::createAreal();
+        default:
+            return VectorPoints::createPoints();
+    }
+}
+
+VectorShapeRef MappedShapeReader::getObjectByIndex(unsigned int vecIndex,const StringSet *filterAttrs)
+{
+    if (vecIndex >= recordOffsets.size())
+        return VectorShapeRef();
+
+    VectorShapeRef shape = decodeShape(vecIndex);
+    // Hand back something of the right sort so the indices still line up
+    if (!shape)
+        shape = makeEmptyShape();
+    shape->setAttrDict(decodeAttrs(vecIndex, projectFields(filterAttrs)));
+
+    return shape;
+}
+
+VectorShapeRef MappedShapeReader::getNextObject(const StringSet *filterAttrs)
+{
+    // Reached the end
+    if (where >= recordOffsets.size())
+        return VectorShapeRef();
+
+    return getObjectByIndex(where++, filterAttrs);
+}
+
+void MappedShapeReader::readRange(unsigned int start,unsigned int end,const StringSet *filterAttrs,std::vector<VectorShapeRef> &shapes,bool keepNulls)
+{
+    end = std::min(end, (unsigned int)recordOffsets.size());
+    if (start >= end)
+        return;
+
+    const auto projFields = projectFields(filterAttrs);
+    shapes.reserve(shapes.size() + (end - start));
+    for (unsigned int which = start; which < end; which++)
+    {
+        VectorShapeRef shape = decodeShape(which);
+        if (!shape)
+        {
+            if (!keepNulls)
+                continue;
+            shape = makeEmptyShape();
+        }
+        shape->setAttrDict(decodeAttrs(which, projFields));
+        shapes.push_back(shape);
+    }
+}
+
+std::vector<VectorObjectRef> MappedShapeReader::readBatches(unsigned int batchSize,const StringSet *filterAttrs,int numThreads,bool keepNulls)
+{
+    batchSize = std::max(batchSize, 1U);
+    const unsigned int numBatches = (recordOffsets.size() + batchSize - 1) / batchSize;
+    std::vector<VectorObjectRef> batches(numBatches);
+    if (numBatches == 0)
+        return batches;
+
+    if (numThreads <= 0)
+        numThreads = std::max(1U, std::thread::hardware_concurrency());
+    numThreads = std::min(numThreads, (int)numBatches);
+
+    // Threads grab the next batch until they run out
+    std::atomic<unsigned int> nextBatch(0);
+    auto work = [&]()
+    {
+        std::vector<VectorShapeRef> shapes;
+        unsigned int which;
+        while ((which = nextBatch++) < numBatches)
+        {
+            shapes.clear();
+            readRange(which * batchSize, (which + 1) * batchSize, filterAttrs, shapes, keepNulls);
+            VectorObjectRef vecObj = std::make_shared<VectorObject>();
+            vecObj->shapes.reserve(shapes.size());
+            vecObj->shapes.insert(shapes.begin(), shapes.end());
+            batches[which] = vecObj;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads-1);
+    for (int ii=1;ii<numThreads;ii++)
+        threads.emplace_back(work);
+    work();
+    for (auto &thread : threads)
+        thread.join();
+
+    return batches;
+}
+
+}
@@ -27,108 +27,155 @@ namespace WhirlyKit
 {
 
 OverlapHelper::OverlapHelper(const Mbr &mbr,int sizeX,int sizeY)
-: mbr(mbr), sizeX(sizeX), sizeY(sizeY)
+: mbr(mbr), sizeX(sizeX), sizeY(sizeY), curCheck(0)
 {
-    grid.resize(sizeX*sizeY);
     cellSize = Point2f((mbr.ur().x()-mbr.ll().x())/sizeX,(mbr.ur().y()-mbr.ll().y())/sizeY);
+    cellHeads.resize(sizeX*sizeY,-1);
+    cellsOccupied.resize((sizeX*sizeY+63)/64,0);
 }
 
-// Try to add an object.  Might fail (kind of the whole point).
-bool OverlapHelper::addCheckObject(const Point2dVector &pts)
+// Same result as ConvexPolyIntersect(), which is a bounding box test
+static inline bool MbrsOverlap(const Mbr &a,const Mbr &b)
 {
-    Mbr objMbr;
-    for (unsigned int ii=0;ii<pts.size();ii++)
-        objMbr.addPoint(pts[ii]);
-    int sx = floorf((objMbr.ll().x()-mbr.ll().x())/cellSize.x());
+    if (!a.valid() || !b.valid())
+        return a.overlaps(b);
+
+    return a.ll().x() <= b.ur().x() && b.ll().x() <= a.ur().x() &&
+           a.ll().y() <= b.ur().y() && b.ll().y() <= a.ur().y();
+}
+
+void OverlapHelper::calcCells(const Mbr &objMbr,int &sx,int &sy,int &ex,int &ey) const
+{
+    sx = floorf((objMbr.ll().x()-mbr.ll().x())/cellSize.x());
     if (sx < 0) sx = 0;
-    int sy = floorf((objMbr.ll().y()-mbr.ll().y())/cellSize.y());
+    sy = floorf((objMbr.ll().y()-mbr.ll().y())/cellSize.y());
     if (sy < 0) sy = 0;
-    int ex = ceilf((objMbr.ur().x()-mbr.ll().x())/cellSize.x());
+    ex = ceilf((objMbr.ur().x()-mbr.ll().x())/cellSize.x());
     if (ex >= sizeX)  ex = sizeX-1;
-    int ey = ceilf((objMbr.ur().y()-mbr.ll().y())/cellSize.y());
+    ey = ceilf((objMbr.ur().y()-mbr.ll().y())/cellSize.y());
     if (ey >= sizeY)  ey = sizeY-1;
-    for (int ix=sx;ix<=ex;ix++)
-        for (int iy=sy;iy<=ey;iy++)
+}
+
+bool OverlapHelper::checkCells(const Mbr &objMbr,int sx,int sy,int ex,int ey,int rank)
+{
+    if (objects.empty() || sx > ex)
+        return true;
+
+    // Stamp the objects as we test them, since they'll show up in more than one cell
+    if (++curCheck == 0)
+    {
+        std::fill(objectChecks.begin(),objectChecks.end(),0);
+        curCheck = 1;
+    }
+
+    for (int iy=sy;iy<=ey;iy++)
+    {
+        for (int ix=sx;ix<=ex;ix++)
         {
-            std::vector<int> &objList = grid[iy*sizeX + ix];
-            for (unsigned int ii=0;ii<objList.size();ii++)
+            const int cell = iy*sizeX + ix;
+            if (!(cellsOccupied[cell/64] & ((uint64_t)1 << (cell%64))))
+                continue;
+
+            for (int ci=cellHeads[cell];ci>=0;ci=cellEntries[ci].next)
             {
-                BoundedObject &testObj = objects[objList[ii]];
-                // This will result in testing the same thing multiple times
-                if (ConvexPolyIntersect(testObj.pts,pts))
+                const int which = cellEntries[ci].object;
+                if (objectChecks[which] == curCheck)
+                    continue;
+                objectChecks[which] = curCheck;
+
+                if (objectRanks[which] < rank && MbrsOverlap(objects[which],objMbr))
                     return false;
             }
         }
-    
-    // Okay, so it doesn't overlap.  Let's add it where needed.
-    objects.resize(objects.size()+1);
-    int newId = (int)(objects.size()-1);
-    BoundedObject &newObj = objects[newId];
-    newObj.pts = pts;
-    for (int ix=sx;ix<=ex;ix++)
-        for (int iy=sy;iy<=ey;iy++)
+    }
+
+    return true;
+}
+
+int OverlapHelper::addToCells(const Mbr &objMbr,int sx,int sy,int ex,int ey,int rank)
+{
+    const int newId = (int)objects.size();
+    objects.push_back(objMbr);
+    objectRanks.push_back(rank);
+    objectChecks.push_back(0);
+
+    for (int iy=sy;iy<=ey;iy++)
+    {
+        for (int ix=sx;ix<=ex;ix++)
         {
-            std::vector<int> &objList = grid[iy*sizeX + ix];
-            objList.push_back(newId);
+            const int cell = iy*sizeX + ix;
+            cellEntries.push_back(CellEntry{newId,cellHeads[cell]});
+            cellHeads[cell] = (int)cellEntries.size()-1;
+            cellsOccupied[cell/64] |= (uint64_t)1 << (cell%64);
         }
-    
+    }
+
+    return newId;
+}
+
+// Try to add an object.  Might fail (kind of the whole point).
+bool OverlapHelper::addCheckObject(const Point2dVector &pts)
+{
+    Mbr objMbr;
+    objMbr.addPoints(pts);
+    int sx,sy,ex,ey;
+    calcCells(objMbr,sx,sy,ex,ey);
+
+    if (!checkCells(objMbr,sx,sy,ex,ey))
+        return false;
+
+    // Okay, so it doesn't overlap.  Let's add it where needed.
+    addToCells(objMbr,sx,sy,ex,ey);
+
     return true;
 }
 
 bool OverlapHelper::checkObject(const Point2dVector &pts)
 {
     Mbr objMbr;
-    for (unsigned int ii=0;ii<pts.size();ii++)
-        objMbr.addPoint(pts[ii]);
-    int sx = floorf((objMbr.ll().x()-mbr.ll().x())/cellSize.x());
-    if (sx < 0) sx = 0;
-    int sy = floorf((objMbr.ll().y()-mbr.ll().y())/cellSize.y());
-    if (sy < 0) sy = 0;
-    int ex = ceilf((objMbr.ur().x()-mbr.ll().x())/cellSize.x());
-    if (ex >= sizeX)  ex = sizeX-1;
-    int ey = ceilf((objMbr.ur().y()-mbr.ll().y())/cellSize.y());
-    if (ey >= sizeY)  ey = sizeY-1;
-    for (int ix=sx;ix<=ex;ix++)
-        for (int iy=sy;iy<=ey;iy++)
-        {
-            std::vector<int> &objList = grid[iy*sizeX + ix];
-            for (unsigned int ii=0;ii<objList.size();ii++)
-            {
-                BoundedObject &testObj = objects[objList[ii]];
-                // This will result in testing the same thing multiple times
-                if (ConvexPolyIntersect(testObj.pts,pts))
-                    return false;
-            }
-        }
+    objMbr.addPoints(pts);
+    int sx,sy,ex,ey;
+    calcCells(objMbr,sx,sy,ex,ey);
 
-    return true;
+    return checkCells(objMbr,sx,sy,ex,ey);
 }
 
 void OverlapHelper::addObject(const Point2dVector &pts)
 {
     Mbr objMbr;
-    for (unsigned int ii=0;ii<pts.size();ii++)
-        objMbr.addPoint(pts[ii]);
-    int sx = floorf((objMbr.ll().x()-mbr.ll().x())/cellSize.x());
-    if (sx < 0) sx = 0;
-    int sy = floorf((objMbr.ll().y()-mbr.ll().y())/cellSize.y());
-    if (sy < 0) sy = 0;
-    int ex = ceilf((objMbr.ur().x()-mbr.ll().x())/cellSize.x());
-    if (ex >= sizeX)  ex = sizeX-1;
-    int ey = ceilf((objMbr.ur().y()-mbr.ll().y())/cellSize.y());
-    if (ey >= sizeY)  ey = sizeY-1;
-    
-    // Okay, so it doesn't overlap.  Let's add it where needed.
-    objects.resize(objects.size()+1);
-    int newId = (int)(objects.size()-1);
-    BoundedObject &newObj = objects[newId];
-    newObj.pts = pts;
-    for (int ix=sx;ix<=ex;ix++)
-        for (int iy=sy;iy<=ey;iy++)
-        {
-            std::vector<int> &objList = grid[iy*sizeX + ix];
-            objList.push_back(newId);
-        }
+    objMbr.addPoints(pts);
+    int sx,sy,ex,ey;
+    calcCells(objMbr,sx,sy,ex,ey);
+
+    addToCells(objMbr,sx,sy,ex,ey);
+}
+
+int OverlapHelper::addObject(const Mbr &objMbr,int rank)
+{
+    int sx,sy,ex,ey;
+    calcCells(objMbr,sx,sy,ex,ey);
+
+    return addToCells(objMbr,sx,sy,ex,ey,rank);
+}
+
+bool OverlapHelper::checkObject(const Mbr &objMbr,int rank)
+{
+    int sx,sy,ex,ey;
+    calcCells(objMbr,sx,sy,ex,ey);
+
+    return checkCells(objMbr,sx,sy,ex,ey,rank);
+}
+
+void OverlapHelper::setObjectRank(int which,int rank)
+{
+    if (which >= 0 && which < (int)objectRanks.size())
+        objectRanks[which] = rank;
+}
+
+void OverlapHelper::removeObject(int which)
+{
+    // It stays in the cells, but nothing outranks it
+    setObjectRank(which,INT_MAX);
 }
     
 ClusterHelper::ObjectWithBounds::ObjectWithBounds()
@@ -173,8 +220,10 @@ void ClusterHelper::addToCells(const Mbr &mbr,int index)
     for (int ix=sx;ix<=ex;ix++)
         for (int iy=sy;iy<=ey;iy++)
         {
-            std::set<int> &objSet = grid[iy*sizeX + ix];
-            objSet.insert(index);
+            std::vector<int> &objs = grid[iy*sizeX + ix];
+            const auto it = std::lower_bound(objs.begin(),objs.end(),index);
+            if (it == objs.end() || *it != index)
+                objs.insert(it,index);
         }
 }
     
@@ -183,16 +232,18 @@ void ClusterHelper::removeFromCells(const Mbr &mbr,int index)
     int sx,sy,ex,ey;
     calcCells(mbr,sx,sy,ex,ey);
     
-    // Add the new object to the grid
+    // Remove the object from the grid
     for (int ix=sx;ix<=ex;ix++)
         for (int iy=sy;iy<=ey;iy++)
         {
-            std::set<int> &objSet = grid[iy*sizeX + ix];
-            objSet.erase(index);
+            std::vector<int> &objs = grid[iy*sizeX + ix];
+            const auto it = std::lower_bound(objs.begin(),objs.end(),index);
+            if (it != objs.end() && *it == index)
+                objs.erase(it);
         }
 }
     
-void ClusterHelper::findObjectsWithin(const Mbr &mbr,std::set<int> &objSet)
+void ClusterHelper::findObjectsWithin(const Mbr &mbr,std::vector<int> &objs)
 {
     int sx,sy,ex,ey;
     calcCells(mbr,sx,sy,ex,ey);
@@ -201,10 +252,14 @@ void ClusterHelper::findObjectsWithin(const Mbr &mbr,std::set<int> &objSet)
     {
         for (int iy=sy;iy<=ey;iy++)
         {
-            std::set<int> &thisGridSet = grid[iy*sizeX + ix];
-            objSet.insert(thisGridSet.begin(),thisGridSet.end());
+            const std::vector<int> &cellObjs = grid[iy*sizeX + ix];
+            objs.insert(objs.end(),cellObjs.begin(),cellObjs.end());
         }
     }
+
+    // Objects will show up in more than one cell
+    std::sort(objs.begin(),objs.end());
+    objs.erase(std::unique(objs.begin(),objs.end()),objs.end());
 }
 
 // Try to add an object.  Might fail (kind of the whole point).
@@ -221,7 +276,7 @@ void ClusterHelper::addObject(LayoutObjectEntry *objEntry,const Point2dVector &p
     const Mbr ptsMbr(pts);
     
     // All the things we might overlap
-    std::set<int> objSet;
+    std::vector<int> objSet;
     findObjectsWithin(ptsMbr, objSet);
     
     // Look for overlaps
@@ -299,7 +354,7 @@ void ClusterHelper::resolveClusters()
         if (simpleObj->parentObject < 0)
         {
             Mbr simpleMbr;  simpleMbr.addPoints(simpleObj->pts);
-            std::set<int> testObjs;
+            std::vector<int> testObjs;
             findObjectsWithin(simpleMbr, testObjs);
             for (auto which : testObjs)
             {
@@ -326,7 +381,7 @@ void ClusterHelper::resolveClusters()
         if (!clusterObj->children.empty())
         {
             Mbr thisMbr;  thisMbr.addPoints(clusterObj->pts);
-            std::set<int> testObjs;
+            std::vector<int> testObjs;
             findObjectsWithin(thisMbr, testObjs);
             for (auto which : testObjs)
             {
@@ -217,7 +217,7 @@ void ParticleSystemManager::addParticleBatch(SimpleIdentity sysID,const Particle
         if (draw) {
             ParticleSystemDrawable::Batch theBatch;
             if (draw->findEmptyBatch(theBatch)) {
-                if (renderer->getType() == SceneRenderer::RenderGLES) {
+                if (renderer->getType() != SceneRenderer::RenderMetal) {
                     // For OpenGL we match everything up
                     std::vector<ParticleSystemDrawable::AttributeData> attrData;
                     for (unsigned int ii=0;ii<batch.attrData.size();ii++) {
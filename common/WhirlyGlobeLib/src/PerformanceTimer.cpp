@@ -95,12 +95,33 @@ void PerformanceTimer::stopTiming(const std::string &what)
     TimeInterval start = it->second;
     actives.erase(it);
     
+    const TimeInterval dur = TimeGetCurrent()-start;
+    addTime(what,dur);
+
+#if WK_TRACE_ENABLED
+    if (PerformanceTrace::isEnabled())
+    {
+        const uint64_t end = PerformanceTrace::now();
+        const uint64_t durNs = (uint64_t)(dur * 1e9);
+
+        // Register each name once per timer
+        auto nameIt = traceNameIDs.find(what);
+        if (nameIt == traceNameIDs.end())
+            nameIt = traceNameIDs.emplace(what,PerformanceTrace::registerName(what.c_str())).first;
+
+        PerformanceTrace::addSpan(nameIt->second,end > durNs ? end - durNs : 0,end);
+    }
+#endif
+}
+
+void PerformanceTimer::addTime(const std::string &what,TimeInterval dur)
+{
     std::map<std::string,TimeEntry>::iterator eit = timeEntries.find(what);
     if (eit != timeEntries.end())
-        eit->second.addTime(TimeGetCurrent()-start);
+        eit->second.addTime(dur);
     else {
         TimeEntry newEntry;
-        newEntry.addTime(TimeGetCurrent()-start);
+        newEntry.addTime(dur);
         newEntry.name = what;
         timeEntries[what] = newEntry;
     }
@@ -165,6 +186,10 @@ void PerformanceTimer::log()
             sprintf(line,"%s: min, max, avg = (%d,%d,%2.f,  %d) count",entry.name.c_str(),entry.minCount,entry.maxCount,(float)entry.avgCount / (float)entry.numRuns,entry.avgCount);
         }
     }
+
+#if WK_TRACE_ENABLED
+    PerformanceTrace::log();
+#endif
 }
     
 }
@@ -0,0 +1,462 @@
+/*
+ *  PerformanceTrace.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <algorithm>
+#import <chrono>
+#import <cinttypes>
+#import <cmath>
+#import <cstdio>
+#import <map>
+#import <memory>
+#import <mutex>
+#import <unordered_map>
+#import "PerformanceTrace.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+std::atomic<bool> PerformanceTrace::enabled(WK_TRACE_ENABLED != 0);
+
+namespace
+{
+
+static_assert((PerformanceTrace::BufferSize & (PerformanceTrace::BufferSize-1)) == 0, "Trace buffer size must be a power of two");
+
+// An event stored as atomic words, so other threads can copy it while the owner overwrites it.
+// A copy that races with a write can come out torn, getEvents spots those and drops them.
+struct EventSlot
+{
+    void store(const PerformanceTrace::Event &event)
+    {
+        start.store(event.start,std::memory_order_relaxed);
+        dur.store(event.dur,std::memory_order_relaxed);
+        value.store((uint64_t)event.value,std::memory_order_relaxed);
+        nameType.store(event.name | ((uint64_t)event.type << 16),std::memory_order_relaxed);
+    }
+
+    PerformanceTrace::Event load() const
+    {
+        const uint64_t nt = nameType.load(std::memory_order_relaxed);
+        return PerformanceTrace::Event { start.load(std::memory_order_relaxed),
+                                         dur.load(std::memory_order_relaxed),
+                                         (int64_t)value.load(std::memory_order_relaxed),
+                                         (TraceNameID)(nt & 0xffff),
+                                         (PerformanceTrace::EventType)(nt >> 16) };
+    }
+
+    std::atomic<uint64_t> start,dur,value,nameType;
+};
+
+// One of these per recording thread.
+// Only the owning thread writes the events, everyone else just reads.
+struct ThreadBuffer
+{
+    ThreadBuffer(int tid) : tid(tid), inUse(false), writePos(0), readFrom(0) { }
+
+    const int tid;
+    // These are protected by the registry lock
+    std::string threadName;
+    bool inUse;
+
+    // Total number of events ever written
+    std::atomic<uint64_t> writePos;
+    // Anything before this has been cleared
+    std::atomic<uint64_t> readFrom;
+    EventSlot events[PerformanceTrace::BufferSize];
+};
+
+// Names and thread buffers
+struct TraceRegistry
+{
+    TraceRegistry() { names.emplace_back("Other"); }
+
+    std::mutex lock;
+    std::vector<std::string> names;
+    std::unordered_map<std::string,TraceNameID> nameIDs;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+// Never deleted, threads may be recording while the process shuts down
+static TraceRegistry &registry()
+{
+    static TraceRegistry *reg = new TraceRegistry();
+    return *reg;
+}
+
+// Hands the buffer back when the thread goes away so the next thread can reuse it
+struct ThreadBufferHolder
+{
+    ~ThreadBufferHolder()
+    {
+        if (buffer)
+        {
+            std::lock_guard<std::mutex> guardLock(registry().lock);
+            buffer->inUse = false;
+            buffer->threadName.clear();
+        }
+    }
+
+    ThreadBuffer *buffer = nullptr;
+};
+
+static thread_local ThreadBufferHolder threadBuffer;
+
+static ThreadBuffer *getThreadBuffer()
+{
+    if (threadBuffer.buffer)
+        return threadBuffer.buffer;
+
+    auto &reg = registry();
+    std::lock_guard<std::mutex> guardLock(reg.lock);
+    for (const auto &buf : reg.buffers)
+        if (!buf->inUse)
+        {
+            threadBuffer.buffer = buf.get();
+            break;
+        }
+    if (!threadBuffer.buffer)
+    {
+        reg.buffers.emplace_back(new ThreadBuffer((int)reg.buffers.size()+1));
+        threadBuffer.buffer = reg.buffers.back().get();
+    }
+    threadBuffer.buffer->inUse = true;
+
+    return threadBuffer.buffer;
+}
+
+static void addEvent(const PerformanceTrace::Event &event)
+{
+    ThreadBuffer *buf = getThreadBuffer();
+    const uint64_t pos = buf->writePos.load(std::memory_order_relaxed);
+    // Pairs with the fence in getEvents.  A reader that copies any of this event will also see writePos at pos or later.
+    std::atomic_thread_fence(std::memory_order_release);
+    buf->events[pos & (PerformanceTrace::BufferSize-1)].store(event);
+    buf->writePos.store(pos+1,std::memory_order_release);
+}
+
+static const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+
+// Names are ours, but be careful anyway
+static void appendEscaped(std::string &str,const std::string &name)
+{
+    for (char c : name)
+    {
+        if (c == '"' || c == '\\')
+            str += '\\';
+        if ((unsigned char)c < 0x20)
+            c = ' ';
+        str += c;
+    }
+}
+
+// Nearest rank
+static TimeInterval percentile(const std::vector<uint64_t> &sorted,double frac)
+{
+    size_t which = (size_t)std::ceil(frac * sorted.size());
+    which = std::min(std::max(which,(size_t)1),sorted.size()) - 1;
+    return sorted[which] / 1e9;
+}
+
+}
+
+void PerformanceTrace::setEnabled(bool enable)
+{
+    enabled.store(enable,std::memory_order_relaxed);
+}
+
+TraceNameID PerformanceTrace::registerName(const char *name)
+{
+    auto &reg = registry();
+    std::lock_guard<std::mutex> guardLock(reg.lock);
+
+    const auto it = reg.nameIDs.find(name);
+    if (it != reg.nameIDs.end())
+        return it->second;
+
+    // Out of IDs, lump the rest together
+    if (reg.names.size() > UINT16_MAX)
+        return 0;
+
+    const TraceNameID nameID = (TraceNameID)reg.names.size();
+    reg.names.emplace_back(name);
+    reg.nameIDs[name] = nameID;
+
+    return nameID;
+}
+
+std::string PerformanceTrace::getName(TraceNameID nameID)
+{
+    auto &reg = registry();
+    std::lock_guard<std::mutex> guardLock(reg.lock);
+
+    return (nameID < reg.names.size()) ? reg.names[nameID] : std::string();
+}
+
+void PerformanceTrace::setThreadName(const std::string &name)
+{
+    ThreadBuffer *buf = getThreadBuffer();
+    std::lock_guard<std::mutex> guardLock(registry().lock);
+    buf->threadName = name;
+}
+
+uint64_t PerformanceTrace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceEpoch).count();
+}
+
+void PerformanceTrace::addSpan(TraceNameID name,uint64_t start,uint64_t end,int64_t value)
+{
+    addEvent(Event { start, end > start ? end - start : 0, value, name, Span });
+}
+
+void PerformanceTrace::addInstant(TraceNameID name,int64_t value)
+{
+    addEvent(Event { now(), 0, value, name, Instant });
+}
+
+void PerformanceTrace::addCounter(TraceNameID name,int64_t value)
+{
+    addEvent(Event { now(), 0, value, name, Counter });
+}
+
+void PerformanceTrace::addAsyncBegin(TraceNameID name,int64_t asyncID)
+{
+    addEvent(Event { now(), 0, asyncID, name, AsyncBegin });
+}
+
+void PerformanceTrace::addAsyncEnd(TraceNameID name,int64_t asyncID)
+{
+    addEvent(Event { now(), 0, asyncID, name, AsyncEnd });
+}
+
+void PerformanceTrace::clear()
+{
+    auto &reg = registry();
+    std::lock_guard<std::mutex> guardLock(reg.lock);
+
+    for (const auto &buf : reg.buffers)
+        buf->readFrom.store(buf->writePos.load(std::memory_order_acquire),std::memory_order_relaxed);
+}
+
+void PerformanceTrace::getEvents(std::vector<std::pair<int,std::vector<Event>>> &events)
+{
+    auto &reg = registry();
+    std::lock_guard<std::mutex> guardLock(reg.lock);
+
+    events.clear();
+    events.reserve(reg.buffers.size());
+    for (const auto &buf : reg.buffers)
+    {
+        // The slot after the newest event is the next one the owner writes, so the oldest of a full buffer
+        //  is never safe to read.  That leaves BufferSize-1 at most.
+        const uint64_t end = buf->writePos.load(std::memory_order_acquire);
+        const uint64_t begin = std::max(buf->readFrom.load(std::memory_order_relaxed),
+                                        end > BufferSize-1 ? end - (BufferSize-1) : 0);
+        if (begin >= end)
+            continue;
+
+        std::vector<Event> threadEvents;
+        threadEvents.reserve(end - begin);
+        for (uint64_t pos = begin; pos < end; pos++)
+            threadEvents.push_back(buf->events[pos & (BufferSize-1)].load());
+
+        // The owner may have lapped us while we copied.  Drop anything that could have been overwritten,
+        //  counting the slot for newEnd, which may be half written.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t newEnd = buf->writePos.load(std::memory_order_relaxed);
+        if (newEnd + 1 > begin + BufferSize)
+        {
+            const uint64_t numLost = std::min(newEnd + 1 - BufferSize - begin,(uint64_t)threadEvents.size());
+            threadEvents.erase(threadEvents.begin(),threadEvents.begin()+numLost);
+        }
+
+        events.emplace_back(buf->tid,std::move(threadEvents));
+    }
+}
+
+std::string PerformanceTrace::exportChromeTrace()
+{
+    std::vector<std::pair<int,std::vector<Event>>> events;
+    getEvents(events);
+
+    std::vector<std::string> names;
+    std::map<int,std::string> threadNames;
+    {
+        auto &reg = registry();
+        std::lock_guard<std::mutex> guardLock(reg.lock);
+        names = reg.names;
+        for (const auto &buf : reg.buffers)
+            if (!buf->threadName.empty())
+                threadNames[buf->tid] = buf->threadName;
+    }
+
+    std::string str = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char line[256];
+
+    for (const auto &it : threadNames)
+    {
+        snprintf(line,sizeof(line),"%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"",
+                 first ? "" : ",\n", it.first);
+        str += line;
+        appendEscaped(str,it.second);
+        str += "\"}}";
+        first = false;
+    }
+
+    for (const auto &threadEvents : events)
+    {
+        const int tid = threadEvents.first;
+        for (const auto &event : threadEvents.second)
+        {
+            str += first ? "{\"name\":\"" : ",\n{\"name\":\"";
+            first = false;
+            appendEscaped(str,event.name < names.size() ? names[event.name] : names[0]);
+
+            const double ts = event.start / 1e3;
+            switch (event.type)
+            {
+                case Span:
+                    if (event.value)
+                        snprintf(line,sizeof(line),"\",\"cat\":\"whirlykit\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"id\":\"0x%" PRIx64 "\"}}",
+                                 ts,event.dur / 1e3,tid,(uint64_t)event.value);
+                    else
+                        snprintf(line,sizeof(line),"\",\"cat\":\"whirlykit\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                                 ts,event.dur / 1e3,tid);
+                    break;
+                case Instant:
+                    snprintf(line,sizeof(line),"\",\"cat\":\"whirlykit\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"id\":\"0x%" PRIx64 "\"}}",
+                             ts,tid,(uint64_t)event.value);
+                    break;
+                case Counter:
+                    snprintf(line,sizeof(line),"\",\"cat\":\"whirlykit\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"value\":%" PRId64 "}}",
+                             ts,tid,event.value);
+                    break;
+                case AsyncBegin:
+                case AsyncEnd:
+                    snprintf(line,sizeof(line),"\",\"cat\":\"whirlykit\",\"ph\":\"%s\",\"id\":\"0x%" PRIx64 "\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+                             event.type == AsyncBegin ? "b" : "e",(uint64_t)event.value,ts,tid);
+                    break;
+            }
+            str += line;
+        }
+    }
+    str += "]}\n";
+
+    return str;
+}
+
+bool PerformanceTrace::writeChromeTrace(const std::string &fileName)
+{
+    FILE *fp = fopen(fileName.c_str(),"w");
+    if (!fp)
+    {
+        wkLogLevel(Warn,"PerformanceTrace: Failed to open %s for writing",fileName.c_str());
+        return false;
+    }
+
+    const std::string str = exportChromeTrace();
+    const bool ok = fwrite(str.data(),1,str.size(),fp) == str.size();
+    fclose(fp);
+
+    return ok;
+}
+
+std::vector<PerformanceTrace::Histogram> PerformanceTrace::makeHistograms()
+{
+    std::vector<std::pair<int,std::vector<Event>>> events;
+    getEvents(events);
+
+    std::map<TraceNameID,std::vector<uint64_t>> durs;
+
+    // Async events usually begin and end on different threads, so put them in time order first
+    std::vector<Event> asyncEvents;
+    for (const auto &threadEvents : events)
+        for (const auto &event : threadEvents.second)
+        {
+            if (event.type == Span)
+                durs[event.name].push_back(event.dur);
+            else if (event.type == AsyncBegin || event.type == AsyncEnd)
+                asyncEvents.push_back(event);
+        }
+    std::stable_sort(asyncEvents.begin(),asyncEvents.end(),
+                     [](const Event &a,const Event &b) { return a.start < b.start; });
+
+    std::map<std::pair<TraceNameID,int64_t>,uint64_t> asyncStarts;
+    for (const auto &event : asyncEvents)
+    {
+        const auto key = std::make_pair(event.name,event.value);
+        if (event.type == AsyncBegin)
+        {
+            // A repeated begin restarts it
+            asyncStarts[key] = event.start;
+        }
+        else
+        {
+            const auto it = asyncStarts.find(key);
+            if (it != asyncStarts.end())
+            {
+                durs[event.name].push_back(event.start - it->second);
+                asyncStarts.erase(it);
+            }
+        }
+    }
+
+    std::vector<Histogram> hists;
+    hists.reserve(durs.size());
+    for (auto &it : durs)
+    {
+        auto &vals = it.second;
+        if (vals.empty())
+            continue;
+        std::sort(vals.begin(),vals.end());
+
+        Histogram hist;
+        hist.name = getName(it.first);
+        hist.count = (int)vals.size();
+        hist.minDur = vals.front() / 1e9;
+        hist.p50 = percentile(vals,0.5);
+        hist.p90 = percentile(vals,0.9);
+        hist.p99 = percentile(vals,0.99);
+        hist.maxDur = vals.back() / 1e9;
+        hists.push_back(hist);
+    }
+    std::sort(hists.begin(),hists.end(),
+              [](const Histogram &a,const Histogram &b) { return a.name < b.name; });
+
+    return hists;
+}
+
+void PerformanceTrace::log()
+{
+    const auto hists = makeHistograms();
+    if (hists.empty())
+        return;
+
+    wkLogLevel(Verbose,"---Trace Durations---");
+    for (const auto &hist : hists)
+    {
+        wkLogLevel(Verbose,"%s: count, min, p50, p90, p99, max = (%d, %.2f,%.2f,%.2f,%.2f,%.2f) ms",
+                   hist.name.c_str(),hist.count,
+                   1000*hist.minDur,1000*hist.p50,1000*hist.p90,1000*hist.p99,1000*hist.maxDur);
+    }
+}
+
+}
@@ -16,6 +16,9 @@
  *  limitations under the License.
  */
 
+#import <algorithm>
+#import <cmath>
+#import <vector>
 #import "WhirlyKitLog.h"
 #import "Proj4CoordSystem.h"
 #import "GlobeMath.h"
@@ -127,6 +130,37 @@ Point3d Proj4CoordSystem::geographicToLocal(Point2d geo) const
     return {x,y,z};
 }
 
+// Run a batch of points through proj.4 in place.
+// Points it couldn't convert come back as zero, like the single point versions.
+// Returns false if proj.4 gave up on the whole batch.
+static bool TransformPoints(void *src,void *dst,Point3d *pts,size_t count)
+{
+    if (count == 0)
+        return true;
+
+    // Point3d is three packed doubles, so we can hand proj.4 the points directly
+    static_assert(sizeof(Point3d) == 3*sizeof(double), "Point3d must be packed for pj_transform");
+    if (pj_transform(src, dst, (long)count, 3, &pts[0].x(), &pts[0].y(), &pts[0].z()) != 0)
+        return false;
+
+    for (size_t ii=0;ii<count;ii++)
+        if (pts[ii].x() == HUGE_VAL)
+            pts[ii] = Point3d(0,0,0);
+    return true;
+}
+
+void Proj4CoordSystem::geographicToLocal(const Point2d *geo,Point3d *local,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+        local[ii] = Point3d(geo[ii].x(),geo[ii].y(),0.0);
+    if (!TransformPoints(pj_latlon, pj, local, count))
+    {
+        // Let the single point version sort out which ones failed
+        for (size_t ii=0;ii<count;ii++)
+            local[ii] = geographicToLocal(geo[ii]);
+    }
+}
+
 /// Convert from the local coordinate system to geocentric
 Point3f Proj4CoordSystem::localToGeocentric(Point3f localPt) const
 {
@@ -185,6 +219,41 @@ Point3d Proj4CoordSystem::geocentricToLocal(Point3d geocPt) const
     return {x,y,z};
 }
 
+void Proj4CoordSystem::localToGeocentric(const Point3d *local,Point3d *geoc,size_t count) const
+{
+    // Working in place, so keep the originals around in case we have to redo them one at a time
+    std::vector<Point3d> inPts;
+    if (local == geoc)
+    {
+        inPts.assign(local,local+count);
+        local = inPts.data();
+    }
+    else
+        std::copy(local,local+count,geoc);
+    if (!TransformPoints(pj, pj_geocentric, geoc, count))
+    {
+        for (size_t ii=0;ii<count;ii++)
+            geoc[ii] = localToGeocentric(local[ii]);
+    }
+}
+
+void Proj4CoordSystem::geocentricToLocal(const Point3d *geoc,Point3d *local,size_t count) const
+{
+    std::vector<Point3d> inPts;
+    if (geoc == local)
+    {
+        inPts.assign(geoc,geoc+count);
+        geoc = inPts.data();
+    }
+    else
+        std::copy(geoc,geoc+count,local);
+    if (!TransformPoints(pj_geocentric, pj, local, count))
+    {
+        for (size_t ii=0;ii<count;ii++)
+            local[ii] = geocentricToLocal(geoc[ii]);
+    }
+}
+
 bool Proj4CoordSystem::isSameAs(CoordSystem *coordSys) const
 {
     const auto other = dynamic_cast<Proj4CoordSystem *>(coordSys);
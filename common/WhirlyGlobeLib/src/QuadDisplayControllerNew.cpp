@@ -187,7 +187,7 @@ bool QuadDisplayControllerNew::viewUpdate(PlatformThreadInfo *threadInfo,ViewSta
     }
     
     // Nodes to load are different for single level vs regular loading
-    QuadTreeNew::ImportantNodeSet newNodes;
+    QuadTreeNew::ImportantNodeVector newNodes;
     int targetLevel = -1;
     std::vector<double> maxRejectedImport((reportedMaxZoom > 0 ? reportedMaxZoom : maxLevel) +1,0.0);
     if (singleLevel) {
@@ -205,7 +205,7 @@ bool QuadDisplayControllerNew::viewUpdate(PlatformThreadInfo *threadInfo,ViewSta
 //        wkLogLevel(Debug," %d: (%d,%d), import = %f",node.level,node.x,node.y,node.importance);
 //    }
     
-    QuadTreeNew::ImportantNodeSet toAdd,toUpdate;
+    QuadTreeNew::ImportantNodeVector toAdd,toUpdate;
     QuadTreeNew::NodeSet toRemove;
     
     // Need a version of new and old that has no importance values, since those change
@@ -222,28 +222,32 @@ bool QuadDisplayControllerNew::viewUpdate(PlatformThreadInfo *threadInfo,ViewSta
             toRemove.insert(node);
     
     // Nodes to add and nodes to update importance for
+    // These stay in the same order as the new nodes
     for (const auto &node : newNodes)
         if (testCurrentNodes.find(node) == testCurrentNodes.end())
-            toAdd.insert(node);
+            toAdd.push_back(node);
         else
-            toUpdate.insert(node);
+            toUpdate.push_back(node);
     
     QuadTreeNew::NodeSet removesToKeep;
     removesToKeep = loader->quadLoaderUpdate(threadInfo, toAdd, toRemove, toUpdate, targetLevel, changes);
     
     const bool needsDelayCheck = !removesToKeep.empty();
     
-    currentNodes = newNodes;
+    // Kept nodes have no importance, so they go in front
+    currentNodes.clear();
+    currentNodes.reserve(removesToKeep.size() + newNodes.size());
     for (const auto &node : removesToKeep) {
-        currentNodes.insert(QuadTreeNew::ImportantNode(node,0.0));
+        currentNodes.emplace_back(node,0.0);
     }
+    currentNodes.insert(currentNodes.end(),newNodes.begin(),newNodes.end());
     
     // If we're at the max level, we may want to reach beyond
     int testTargetLevel = targetLevel;
     if (reportedMaxZoom > maxZoom && targetLevel == maxZoom) {
         int oldMaxLevel = maxLevel;
         maxLevel = reportedMaxZoom;
-        QuadTreeNew::ImportantNodeSet testNodes;
+        QuadTreeNew::ImportantNodeVector testNodes;
         std::vector<double> maxRejectedImportLocal(reportedMaxZoom + 1, 0.0);
         std::tie(testTargetLevel,testNodes) = calcCoverageVisible(reportedMinImportancePerLevel, maxTiles, levelLoads, localKeepMinLevel, maxRejectedImportLocal);
         maxLevel = oldMaxLevel;
@@ -122,7 +122,7 @@ bool QIFFrameAsset::hasLoadReturn()
     return loadReturnSet;
 }
 
-QIFTileAsset::QIFTileAsset(const QuadTreeNew::ImportantNode &ident) : state(Waiting), shouldEnable(false), ident(ident), drawPriority(0)
+QIFTileAsset::QIFTileAsset(const QuadTreeNew::ImportantNode &ident) : state(Waiting), ident(ident), shouldEnable(false), loadTraceOpen(false), drawPriority(0)
 {
 }
     
@@ -406,6 +406,30 @@ void QIFTileAsset::frameFailed(PlatformThreadInfo *threadInfo,QuadImageFrameLoad
         frame->loadFailed(threadInfo,loader);
 }
     
+void QIFTileAsset::beginLoadTrace()
+{
+#if WK_TRACE_ENABLED
+    if (PerformanceTrace::isEnabled())
+    {
+        PerformanceTrace::addAsyncBegin(WK_TRACE_NAME("Tile Load"),PerformanceTrace::tileID(ident.level,ident.x,ident.y));
+        loadTraceOpen = true;
+    }
+#endif
+}
+
+void QIFTileAsset::endLoadTrace(ChangeSet &changes)
+{
+#if WK_TRACE_ENABLED
+    if (loadTraceOpen)
+    {
+        // Goes in behind the tile's own changes
+        changes.push_back(new TraceAsyncEndReq(WK_TRACE_NAME("Tile Load"),
+                                               PerformanceTrace::tileID(ident.level,ident.x,ident.y)));
+        loadTraceOpen = false;
+    }
+#endif
+}
+
 void QIFTileAsset::getLoadedData(std::vector<RawDataRef> &allData)
 {
     for (const auto& frame : frames) {
@@ -531,10 +555,11 @@ QIFTileState::FrameInfo::FrameInfo() :
 { }
 
 QIFRenderState::QIFRenderState()
-: lastUpdate(0.0), lastRenderTime(0.0), texSize(0), borderSize(0)
+: version(0), texSize(0), borderSize(0), lastRenderTime(0.0), lastUpdate(0.0)
 { }
 
 QIFRenderState::QIFRenderState(int numFocus,int numFrames) :
+    version(0),
     texSize(0),
     borderSize(0),
     lastRenderTime(0)
@@ -615,14 +640,13 @@ void QIFRenderState::updateScene(Scene *,
         //        NSLog(@"numFrames = %d, activeFrames[0] = %d, activeFrames[1] = %d",numFrames,activeFrames[0],activeFrames[1]);
         
         // Work through the tiles, figure out what's to be on and off
-        for (const auto& tileIt : tiles) {
-            const auto tileID = tileIt.first;
-            const auto tile = tileIt.second;
+        for (const auto& tile : tiles) {
+            const auto &tileID = tile->node;
             bool enable = bigEnable && tile->enable;
             if (enable) {
                 // Assign as many active textures as we've got
                 for (unsigned int ii=0;ii<numFrames;ii++) {
-                    const auto frame = tile->frames[activeFrames[ii]];
+                    const auto &frame = tile->frames[activeFrames[ii]];
                     if (!frame.texIDs.empty()) {
                         const auto relLevel = (unsigned)std::max(0, tileID.level - frame.texNode.level);
                         const int relX = tileID.x - frame.texNode.x * (int)(1U<<relLevel);
@@ -947,6 +971,9 @@ QIFTileAssetRef QuadImageFrameLoader::addNewTile(PlatformThreadInfo *threadInfo,
     if (debugMode)
         wkLogLevel(Debug,"MaplyQuadImageLoader: Starting fetch for tile %d: (%d,%d)",ident.level,ident.x,ident.y);
     
+    // Tile latency runs from here to when its last frame is applied in the renderer
+    newTile->beginLoadTrace();
+
     // Normal remote data fetching
     newTile->startFetching(threadInfo,this, nullptr, batchOps, changes);
         
@@ -961,6 +988,7 @@ void QuadImageFrameLoader::removeTile(PlatformThreadInfo *threadInfo,const QuadT
         if (debugMode)
             wkLogLevel(Debug,"MaplyQuadImageLoader: Unloading tile %d: (%d,%d)",ident.level,ident.x,ident.y);
         
+        it->second->endLoadTrace(changes);
         it->second->clear(threadInfo, this, batchOps, changes);
         
         batchOps->deletes.emplace_back(ident.x,ident.y,ident.level);
@@ -972,6 +1000,9 @@ void QuadImageFrameLoader::removeTile(PlatformThreadInfo *threadInfo,const QuadT
     
 void QuadImageFrameLoader::mergeLoadedTile(PlatformThreadInfo *threadInfo,QuadLoaderReturn *loadReturn,ChangeSet &changes)
 {
+    WK_TRACE_SCOPE_ID("QuadImageFrameLoader::mergeLoadedTile",
+                      PerformanceTrace::tileID(loadReturn->ident.level,loadReturn->ident.x,loadReturn->ident.y));
+
     changesSinceLastFlush = true;
 
     if (debugMode)
@@ -1039,11 +1070,17 @@ void QuadImageFrameLoader::mergeLoadedTile(PlatformThreadInfo *threadInfo,QuadLo
         compManager->removeComponentObjects(threadInfo, compObjs, changes);
         loadReturn->clear();
     }
+
+    // Loaded, failed or canceled, the tile's done once nothing else is on the way
+    if (tile && !tile->anyFramesLoading(this))
+        tile->endLoadTrace(changes);
 }
     
 // Figure out what needs to be on/off for the non-frame cases
 void QuadImageFrameLoader::updateRenderState(ChangeSet &changes)
 {
+    WK_TRACE_SCOPE("QuadImageFrameLoader::updateRenderState");
+
     // See if there's any loading happening
     bool allLoaded = true;
     for (const auto& it : tiles) {
@@ -1156,76 +1193,125 @@ void QuadImageFrameLoader::updateRenderState(ChangeSet &changes)
 
 // Build up the drawing state for use on the main thread
 // All the texture are assigned there
+// Tiles whose frames (and parents) haven't changed keep the state we built last time,
+//  and if nothing changed at all we don't hand anything over.
 void QuadImageFrameLoader::buildRenderState(ChangeSet &changes)
 {
     const int numFrames = getNumFrames();
-    QIFRenderState newRenderState(numFocus,numFrames);
-    newRenderState.texSize = texSize;
-    newRenderState.borderSize = borderSize;
+    auto newRenderState = std::make_shared<QIFRenderState>(numFocus,numFrames);
+    newRenderState->texSize = texSize;
+    newRenderState->borderSize = borderSize;
     for (int frameID=0;frameID<numFrames;frameID++)
-        newRenderState.topTilesLoaded[frameID] = true;
-        
+        newRenderState->topTilesLoaded[frameID] = true;
+    newRenderState->tiles.reserve(tiles.size());
+
+    if (!scratchTileState)
+        scratchTileState = std::make_unique<QIFTileState>(0,QuadTreeNew::Node(0,0,-1));
+    QIFTileState &scratch = *scratchTileState;
+
+    // Both lists are in node order, so we can walk the old one alongside
+    static const std::vector<QIFTileStateRef> noTiles;
+    const auto &lastTiles = lastBuiltState ? lastBuiltState->tiles : noTiles;
+    auto lastIt = lastTiles.begin();
+    bool changed = !lastBuiltState || lastTiles.size() != tiles.size() ||
+                    lastBuiltState->texSize != texSize || lastBuiltState->borderSize != borderSize;
+
+    // Where each tile landed in the new state.  Parents sort ahead of their children.
+    std::unordered_map<int64_t,size_t> tileIndex;
+    tileIndex.reserve(tiles.size());
+
     // Work through the tiles, figure out their textures as we go
     for (const auto& tileIt : tiles) {
-        const auto tileID = tileIt.first;
-        const auto tile = tileIt.second;
+        const auto &tileID = tileIt.first;
+        const auto &tile = tileIt.second;
         
-        const auto tileState = std::make_shared<QIFTileState>(numFrames,tileID);
-        tileState->instanceDrawIDs = tile->instanceDrawIDs;
-        tileState->enable = tile->getShouldEnable();
-        tileState->compObjs = tile->getCompObjs();
-        tileState->ovlCompObjs = tile->getOvlCompObjs();
+        // The parent has already resolved its textures, possibly from its own parents
+        const QIFTileState *parentState = nullptr;
+        if (tileID.level > 0) {
+            const auto it = tileIndex.find(QuadTreeIdentifier::NodeNumber(tileID.x/2,tileID.y/2,tileID.level-1));
+            if (it != tileIndex.end())
+                parentState = newRenderState->tiles[it->second].get();
+        }
+
+        scratch.node = tileID;
+        scratch.enable = tile->getShouldEnable();
+        scratch.instanceDrawIDs = tile->instanceDrawIDs;
+        scratch.frames.resize(numFrames);
         
         // Work through the frames
         for (int frameID=0;frameID<numFrames;frameID++) {
             const auto inFrame = tile->getFrame(frameID);
-            auto &outFrame = tileState->frames[frameID];
+            auto &outFrame = scratch.frames[frameID];
+            outFrame.enabled = false;
+            outFrame.texNode = tileID;
+            outFrame.texIDs.clear();
             
             // Shouldn't happen
             if (!inFrame)
                 continue;
             
-            // Look for a tile or parent tile that has a texture ID
-            QuadTreeNew::Node texNode = tile->getIdent();   // NOLINT Slicing ImportantNode to Node
-            do {
-                const auto it = tiles.find(texNode);
-                if (it == tiles.end())
-                    break;
-                const auto parentTile = it->second;
-                const auto parentFrame = parentTile->getFrame(frameID);
-                if (parentFrame && !parentFrame->getTexIDs().empty()) {
-                    // Got one, so stop
-                    outFrame.texIDs = parentFrame->getTexIDs();
-                    outFrame.texNode = parentTile->getIdent();  // NOLINT Slicing ImportantNode to Node
-                    break;
+            // Use our own texture or whatever the parent ended up with
+            if (!inFrame->getTexIDs().empty()) {
+                outFrame.texIDs = inFrame->getTexIDs();
+            } else if (parentState) {
+                const auto &parentFrame = parentState->frames[frameID];
+                if (!parentFrame.texIDs.empty()) {
+                    outFrame.texIDs = parentFrame.texIDs;
+                    outFrame.texNode = parentFrame.texNode;
                 }
-                
-                // Work our way up the hierarchy
-                if (texNode.level <= 0)
-                    break;
-                texNode.level -= 1;
-                texNode.x /= 2;
-                texNode.y /= 2;
-            } while (outFrame.texIDs.empty());
+            }
             
             // Metrics for overall loading used by the display side
             if (outFrame.texIDs.empty() && inFrame->getState() != QIFFrameAsset::Loaded) {
-                if (tile->getIdent().level == params.minZoom && requiringTopTilesLoaded)
-                    newRenderState.topTilesLoaded[frameID] = false;
+                if (tileID.level == params.minZoom && requiringTopTilesLoaded)
+                    newRenderState->topTilesLoaded[frameID] = false;
             } else {
-                newRenderState.tilesLoaded[frameID]++;
+                newRenderState->tilesLoaded[frameID]++;
+            }
+        }
+        
+        // Reuse the last state for this tile if it's the same
+        while (lastIt != lastTiles.end() && (*lastIt)->node < tileID)
+            ++lastIt;
+        QIFTileStateRef tileState;
+        if (lastIt != lastTiles.end() && (*lastIt)->node == tileID) {
+            const auto &lastState = **lastIt;
+            if (lastState.enable == scratch.enable &&
+                lastState.instanceDrawIDs == scratch.instanceDrawIDs &&
+                lastState.frames == scratch.frames &&
+                lastState.compObjs == tile->getCompObjs() &&
+                lastState.ovlCompObjs == tile->getOvlCompObjs()) {
+                tileState = *lastIt;
             }
         }
+        if (!tileState) {
+            tileState = std::make_shared<QIFTileState>(scratch);
+            tileState->compObjs = tile->getCompObjs();
+            tileState->ovlCompObjs = tile->getOvlCompObjs();
+            changed = true;
+        }
         
-        newRenderState.tiles[tileID] = tileState;
+        tileIndex[tileID.NodeNumber()] = newRenderState->tiles.size();
+        newRenderState->tiles.push_back(std::move(tileState));
+    }
+    
+    if (!changed &&
+        newRenderState->tilesLoaded == lastBuiltState->tilesLoaded &&
+        newRenderState->topTilesLoaded == lastBuiltState->topTilesLoaded) {
+        // The main thread already has all this
+        return;
     }
     
+    newRenderState->version = lastBuiltState ? lastBuiltState->version + 1 : 1;
+    lastBuiltState = newRenderState;
+    
+    // Tile states are shared, so this only copies the pointers
     auto theLastRunReqFlag = lastRunReqFlag;
     auto mergeReq = new RunBlockReq([this,newRenderState,theLastRunReqFlag](Scene *scene,SceneRenderer *renderer,View *view)
     {
         if (*theLastRunReqFlag) {
             if (builder)
-                renderState = newRenderState;
+                renderState = *newRenderState;
         }
     });
     
@@ -1250,7 +1336,7 @@ void QuadImageFrameLoader::setBuilder(QuadTileBuilder *inBuilder,QuadDisplayCont
 /// Before we tell the delegate to unload tiles, see if they want to keep them around
 /// Returns the tiles we want to preserve after all
 QuadTreeNew::NodeSet QuadImageFrameLoader::builderUnloadCheck(QuadTileBuilder *inBuilder,
-        const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,
+        const WhirlyKit::QuadTreeNew::ImportantNodeVector &loadTiles,
         const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
         int inTargetLevel)
 {
@@ -1326,6 +1412,8 @@ void QuadImageFrameLoader::builderLoad(PlatformThreadInfo *threadInfo,
                                        const WhirlyKit::TileBuilderDelegateInfo &updates,
                                        ChangeSet &changes)
 {
+    WK_TRACE_SCOPE("QuadImageFrameLoader::builderLoad");
+
     // Not initialized yet
     if (!this->builder)
         return;
@@ -1494,6 +1582,7 @@ void QuadImageFrameLoader::cleanup(PlatformThreadInfo *threadInfo,ChangeSet &cha
     QIFBatchOps *batchOps = makeBatchOps(threadInfo);
     
     for (const auto& tile : tiles) {
+        tile.second->endLoadTrace(changes);
         tile.second->clear(threadInfo,this, batchOps, changes);
     }
     tiles.clear();
@@ -142,13 +142,40 @@ double QuadSamplingController::importanceForTile(const QuadTreeIdentifier &ident
         return MAXFLOAT;
     }
     
-    DisplaySolidRef dispSolid;
     return ScreenImportance(viewState.get(), frameSize, viewState->eyeVec, 1,
-                 params.coordSys.get(), coordAdapter, mbr, ident, dispSolid);
+                 params.coordSys.get(), coordAdapter, mbr, ident, cachedSolid(ident, mbr));
 }
 
+// Keep this many display solids around, even if they weren't used recently
+static constexpr size_t MinCachedSolids = 4096;
+
 void QuadSamplingController::newViewState(ViewStateRef viewState)
 {
+    viewGeneration++;
+
+    // Toss anything that wasn't used in the last update
+    if (solidCache.size() > MinCachedSolids)
+    {
+        for (auto it = solidCache.begin(); it != solidCache.end(); )
+        {
+            if (it->second.lastUsed + 1 < viewGeneration)
+                it = solidCache.erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+DisplaySolidRef &QuadSamplingController::cachedSolid(const QuadTreeIdentifier &ident,const Mbr &mbr)
+{
+    CachedSolid &entry = solidCache[ident.NodeNumber()];
+    entry.lastUsed = viewGeneration;
+    // The bounds depend on the display controller's scaling, which could change
+    if (entry.solid && !(entry.mbr == mbr))
+        entry.solid.reset();
+    entry.mbr = mbr;
+
+    return entry.solid;
 }
 
 bool QuadSamplingController::visibilityForTile(const QuadTreeIdentifier &ident,
@@ -159,9 +186,8 @@ bool QuadSamplingController::visibilityForTile(const QuadTreeIdentifier &ident,
     if (ident.level == 0)
         return true;
     
-    DisplaySolidRef dispSolid;
     return TileIsOnScreen(viewState.get(), frameSize,  params.coordSys.get(),
-                          scene->getCoordAdapter(), mbr, ident, dispSolid);
+                          scene->getCoordAdapter(), mbr, ident, cachedSolid(ident, mbr));
 }
     
 /// **** QuadTileBuilderDelegate methods ****
@@ -182,7 +208,7 @@ void QuadSamplingController::setBuilder(QuadTileBuilder *inBuilder, QuadDisplayC
 }
     
 QuadTreeNew::NodeSet QuadSamplingController::builderUnloadCheck(QuadTileBuilder *inBuilder,
-                                        const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,
+                                        const WhirlyKit::QuadTreeNew::ImportantNodeVector &loadTiles,
                                         const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
                                         int targetLevel)
 {
@@ -152,7 +152,7 @@ void QuadTileBuilder::setController(QuadDisplayControllerNew *inControl)
     
 /// Load some tiles, unload others, and the rest had their importance values change
 /// Return the nodes we wanted to keep rather than delete
-QuadTreeNew::NodeSet QuadTileBuilder::quadLoaderUpdate(PlatformThreadInfo *threadInfo,const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,const WhirlyKit::QuadTreeNew::ImportantNodeSet &updateTiles,int targetLevel, ChangeSet &changes)
+QuadTreeNew::NodeSet QuadTileBuilder::quadLoaderUpdate(PlatformThreadInfo *threadInfo,const WhirlyKit::QuadTreeNew::ImportantNodeVector &loadTiles,const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,const WhirlyKit::QuadTreeNew::ImportantNodeVector &updateTiles,int targetLevel, ChangeSet &changes)
 {
     TileBuilderDelegateInfo info;
     info.unloadTiles = unloadTiles;
@@ -164,7 +164,7 @@ QuadTreeNew::NodeSet QuadTileBuilder::quadLoaderUpdate(PlatformThreadInfo *threa
         // Remove the keep nodes and add them to update with very little importance
         for (const QuadTreeNew::Node &node: toKeep) {
             info.unloadTiles.erase(node);
-            info.changeTiles.insert(QuadTreeNew::ImportantNode(node,0.0));
+            info.changeTiles.emplace_back(node,0.0);
         }
     }
     
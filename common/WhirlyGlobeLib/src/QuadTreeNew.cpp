@@ -17,6 +17,8 @@
  */
 
 #import "QuadTreeNew.h"
+#import <algorithm>
+#import <unordered_set>
 
 static constexpr int maxMaxLevel = 24;
 
@@ -98,9 +100,9 @@ QuadTreeNew::QuadTreeNew(const MbrD &mbr,int minLevel,int maxLevel)
 {
 }
 
-QuadTreeNew::ImportantNodeSet QuadTreeNew::calcCoverageImportance(const std::vector<double> &minImportance,int maxNodes,bool siblingNodes,std::vector<double> &maxRejectedImport)
+QuadTreeNew::ImportantNodeVector QuadTreeNew::calcCoverageImportance(const std::vector<double> &minImportance,int maxNodes,bool siblingNodes,std::vector<double> &maxRejectedImport)
 {
-    ImportantNodeSet sortedNodes;
+    ImportantNodeVector sortedNodes;
     
     // Start at the lowest level and work our way to higher resolution
     const int numX = 1<<minLevel;
@@ -111,15 +113,15 @@ QuadTreeNew::ImportantNodeSet QuadTreeNew::calcCoverageImportance(const std::vec
             ImportantNode node(ix,iy,minLevel);
             evalNodeImportance(node,minImportance,sortedNodes,maxRejectedImport);
         }
+    std::sort(sortedNodes.begin(),sortedNodes.end());
     
     // Add the most important nodes first until we run out
-    ImportantNodeSet retNodes;
-    NodeSet testRetNodes;
+    ImportantNodeVector retNodes;
+    std::unordered_set<int64_t> testRetNodes;
     for (auto nodeIt = sortedNodes.rbegin();nodeIt != sortedNodes.rend();nodeIt++) {
-        if (testRetNodes.find(*nodeIt) == testRetNodes.end())
+        if (testRetNodes.insert(nodeIt->NodeNumber()).second)
         {
-            retNodes.insert(*nodeIt);
-            testRetNodes.insert(*nodeIt);
+            retNodes.push_back(*nodeIt);
         }
         // Make sure all the siblings are in there for some modes
         if (siblingNodes) {
@@ -130,21 +132,21 @@ QuadTreeNew::ImportantNodeSet QuadTreeNew::calcCoverageImportance(const std::vec
                     for (int ix=0;ix<2;ix++) {
                         ImportantNode childIdent(parentIdent.x*2+ix,parentIdent.y*2+iy,ident.level);
                         childIdent.importance = ident.importance;
-                        if (testRetNodes.find(childIdent) == testRetNodes.end()) {
-                            retNodes.insert(childIdent);
-                            testRetNodes.insert(childIdent);
+                        if (testRetNodes.insert(childIdent.NodeNumber()).second) {
+                            retNodes.push_back(childIdent);
                         }
                     }
             }
         }
-        if (retNodes.size() >= maxNodes || nodeIt->importance < minImportance[nodeIt->level])
+        if ((int)retNodes.size() >= maxNodes || nodeIt->importance < minImportance[nodeIt->level])
             break;
     }
     
+    std::sort(retNodes.begin(),retNodes.end());
     return retNodes;
 }
     
-void QuadTreeNew::evalNodeImportance(ImportantNode node,const std::vector<double> &minImportance,ImportantNodeSet &importSet,std::vector<double> &maxRejectedImport)
+void QuadTreeNew::evalNodeImportance(ImportantNode node,const std::vector<double> &minImportance,ImportantNodeVector &importNodes,std::vector<double> &maxRejectedImport)
 {
     node.importance = importance(node);
     
@@ -162,7 +164,7 @@ void QuadTreeNew::evalNodeImportance(ImportantNode node,const std::vector<double
     }
 
     if (node.level >= minLevel)
-        importSet.insert(node);
+        importNodes.push_back(node);
     
     if (node.level < maxLevel) {
         // Add the children
@@ -171,14 +173,14 @@ void QuadTreeNew::evalNodeImportance(ImportantNode node,const std::vector<double
             for (int ix=0;ix<2;ix++) {
                 int indX = 2*node.x + ix;
                 ImportantNode childNode(indX,indY,node.level+1);
-                evalNodeImportance(childNode,minImportance,importSet,maxRejectedImport);
+                evalNodeImportance(childNode,minImportance,importNodes,maxRejectedImport);
             }
         }
     }
 }
     
 bool QuadTreeNew::evalNodeVisible(ImportantNode node, const std::vector<double> &minImportance, int maxNodes,
-                                  const std::set<int> &levelsToLoad, int inMaxLevel, ImportantNodeSet &visibleSet)
+                                  const std::vector<bool> &levelsToLoad, int inMaxLevel, ImportantNodeVector &visibleNodes)
 {
     if (node.level > inMaxLevel)
         return true;
@@ -194,11 +196,11 @@ bool QuadTreeNew::evalNodeVisible(ImportantNode node, const std::vector<double>
         return true;
 
     // Only add to the visible set if we want it
-    if (levelsToLoad.find(node.level) != levelsToLoad.end())
-        visibleSet.insert(node);
+    if (levelsToLoad[node.level])
+        visibleNodes.push_back(node);
 
     // Exceeded the number of nodes we can plausibly load.  Fail.
-    if (visibleSet.size() > maxNodes)
+    if ((int)visibleNodes.size() > maxNodes)
         return false;
     
     // Test the children
@@ -208,7 +210,7 @@ bool QuadTreeNew::evalNodeVisible(ImportantNode node, const std::vector<double>
             for (int ix=0;ix<2;ix++) {
                 int indX = 2*node.x + ix;
                 ImportantNode childNode(indX,indY,node.level+1);
-                if (!evalNodeVisible(childNode, minImportance, maxNodes, levelsToLoad, inMaxLevel, visibleSet))
+                if (!evalNodeVisible(childNode, minImportance, maxNodes, levelsToLoad, inMaxLevel, visibleNodes))
                     return false;
             }
         }
@@ -217,12 +219,12 @@ bool QuadTreeNew::evalNodeVisible(ImportantNode node, const std::vector<double>
     return true;
 }
     
-std::tuple<int,QuadTreeNew::ImportantNodeSet> QuadTreeNew::calcCoverageVisible(
+std::tuple<int,QuadTreeNew::ImportantNodeVector> QuadTreeNew::calcCoverageVisible(
         const std::vector<double> &minImportance,
         int maxNodes,const std::vector<int> &levelLoads,
         bool keepMinLevel,std::vector<double> &maxRejectedImport)
 {
-    ImportantNodeSet sortedNodes;
+    ImportantNodeVector sortedNodes;
 
     // Start at the lowest level and work our way to higher resolution
     const ImportantNode node(0,0,0);
@@ -237,32 +239,34 @@ std::tuple<int,QuadTreeNew::ImportantNodeSet> QuadTreeNew::calcCoverageVisible(
     
     // Try to load the target level (and anything else we're required to)
     int chosenLevel = targetLevel;
-    ImportantNodeSet chosenNodes;
+    ImportantNodeVector levelNodes;
     while (chosenLevel >= minLevel) {
         // Resolve the offsets and such if they are there
-        std::set<int> levelsToLoad;
+        std::vector<bool> levelsToLoad(std::max(chosenLevel,maxLevel)+1,false);
         if (keepMinLevel)
-            levelsToLoad.insert(minLevel);
-        levelsToLoad.insert(chosenLevel);
+            levelsToLoad[minLevel] = true;
+        levelsToLoad[chosenLevel] = true;
         for (int level : levelLoads) {
             if (level < 0)
                 level = targetLevel + level;
             if (level >= 0 && level < maxLevel)
-                levelsToLoad.insert(level);
+                levelsToLoad[level] = true;
         }
 
         // Get visibility for all the nodes down to our target level
         // Also make sure we're not exceeding our maximum as we go
         // Kept within the limit, so return these nodes
-        ImportantNodeSet levelNodes;
+        levelNodes.clear();
         if (evalNodeVisible(node,minImportance,maxNodes,levelsToLoad,chosenLevel,levelNodes)) {
-            chosenNodes = levelNodes;
-            break;
+            // Each node is only visited once, so they're already unique
+            std::sort(levelNodes.begin(),levelNodes.end());
+            return {chosenLevel,std::move(levelNodes)};
         }
         chosenLevel--;
     }
 
-    return {chosenLevel,chosenNodes};
+    levelNodes.clear();
+    return {chosenLevel,std::move(levelNodes)};
 }
     
 }
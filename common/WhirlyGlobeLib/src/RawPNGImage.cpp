@@ -19,14 +19,417 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <string>
+#include <mutex>
+#include <zlib.h>
 #import "WhirlyKitLog.h"
 #import "RawPNGImage.h"
+#import "Texture.h"
 #import "lodepng.h"
 
 namespace WhirlyKit
 {
 
+// Output buffers we hand out and get back when the data is released
+class RawPNGDecoder::BufferPool
+{
+public:
+    ~BufferPool()
+    {
+        for (const auto &block : blocks)
+            free(block.first);
+    }
+
+    // Smallest block that'll fit, or a new one
+    unsigned char *get(size_t size,size_t &capacity)
+    {
+        {
+            std::lock_guard<std::mutex> guardLock(lock);
+            size_t best = blocks.size();
+            for (size_t ii=0;ii<blocks.size();ii++)
+                if (blocks[ii].second >= size && (best == blocks.size() || blocks[ii].second < blocks[best].second))
+                    best = ii;
+            if (best < blocks.size())
+            {
+                unsigned char *buf = blocks[best].first;
+                capacity = blocks[best].second;
+                blocks[best] = blocks.back();
+                blocks.pop_back();
+                return buf;
+            }
+        }
+
+        capacity = size;
+        return (unsigned char *)malloc(size);
+    }
+
+    void put(unsigned char *buf,size_t capacity)
+    {
+        {
+            std::lock_guard<std::mutex> guardLock(lock);
+            if (blocks.size() < MaxBlocks)
+            {
+                blocks.emplace_back(buf,capacity);
+                return;
+            }
+        }
+        free(buf);
+    }
+
+protected:
+    // Enough for the tiles a few loader threads have in flight
+    static const int MaxBlocks = 16;
+
+    std::mutex lock;
+    std::vector<std::pair<unsigned char *,size_t> > blocks;
+};
+
+RawPNGDecoder::RawPNGDecoder() :
+    pool(std::make_shared<BufferPool>()),
+    stream(nullptr),
+    nextChunk(0),
+    streamDone(false)
+{
+}
+
+RawPNGDecoder::~RawPNGDecoder()
+{
+    if (stream)
+    {
+        inflateEnd(stream);
+        delete stream;
+    }
+}
+
+static inline unsigned int ReadBigEndian32(const unsigned char *data)
+{
+    return ((unsigned int)data[0] << 24) | ((unsigned int)data[1] << 16) | ((unsigned int)data[2] << 8) | data[3];
+}
+
+// Bytes per output pixel, given the PNG's color type
+static int OutputByteWidth(LodePNGColorType colorType,RawPNGFormat format)
+{
+    if (colorType == LCT_GREY)
+        return 1;
+    return format == RawPNGRGBA ? 4 : 2;
+}
+
+bool RawPNGDecoder::inspect(const unsigned char *data,size_t length,RawPNGFormat format,
+                            unsigned int &width,unsigned int &height,int &byteWidth,
+                            unsigned int &err)
+{
+    LodePNGState pngState;
+    lodepng_state_init(&pngState);
+    err = lodepng_inspect(&width, &height, &pngState, data, length);
+    byteWidth = OutputByteWidth(pngState.info_png.color.colortype,format);
+    lodepng_state_cleanup(&pngState);
+
+    return err == 0;
+}
+
+bool RawPNGDecoder::inflateBytes(unsigned char *dest,size_t len)
+{
+    stream->next_out = dest;
+    stream->avail_out = (uInt)len;
+    while (stream->avail_out > 0)
+    {
+        if (streamDone)
+            return false;
+        if (stream->avail_in == 0)
+        {
+            if (nextChunk >= idatChunks.size())
+                return false;
+            stream->next_in = (Bytef *)idatChunks[nextChunk].first;
+            stream->avail_in = (uInt)idatChunks[nextChunk].second;
+            nextChunk++;
+            continue;
+        }
+        const int ret = ::inflate(stream, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END)
+            streamDone = true;
+        else if (ret != Z_OK && ret != Z_BUF_ERROR)
+            return false;
+    }
+
+    return true;
+}
+
+// Undo the PNG filter on a row, in place
+static bool UnfilterRow(unsigned char filter,unsigned char *row,const unsigned char *prev,size_t rowBytes,size_t bpp)
+{
+    switch (filter)
+    {
+        case 0:
+            break;
+        case 1:
+            for (size_t ii=bpp;ii<rowBytes;ii++)
+                row[ii] += row[ii-bpp];
+            break;
+        case 2:
+            for (size_t ii=0;ii<rowBytes;ii++)
+                row[ii] += prev[ii];
+            break;
+        case 3:
+            for (size_t ii=0;ii<bpp;ii++)
+                row[ii] += prev[ii] >> 1;
+            for (size_t ii=bpp;ii<rowBytes;ii++)
+                row[ii] += (row[ii-bpp] + prev[ii]) >> 1;
+            break;
+        case 4:
+            for (size_t ii=0;ii<bpp;ii++)
+                row[ii] += prev[ii];
+            for (size_t ii=bpp;ii<rowBytes;ii++)
+            {
+                const int a = row[ii-bpp], b = prev[ii], c = prev[ii-bpp];
+                const int pa = std::abs(b - c), pb = std::abs(a - c), pc = std::abs(a + b - 2*c);
+                row[ii] += (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+            }
+            break;
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+void RawPNGDecoder::writeRow(const unsigned char *src,int srcChannels,unsigned char *dest,unsigned int width,RawPNGFormat format)
+{
+    switch (srcChannels)
+    {
+        case 1:
+            for (unsigned int ii=0;ii<width;ii++)
+                dest[ii] = valueLookup[src[ii]];
+            break;
+        case 3:
+            if (format == RawPNGRGBA)
+            {
+                for (unsigned int ii=0;ii<width;ii++,src+=3,dest+=4)
+                {
+                    dest[0] = src[0];  dest[1] = src[1];  dest[2] = src[2];  dest[3] = 255;
+                }
+            } else {
+                uint16_t *dest16 = (uint16_t *)dest;
+                for (unsigned int ii=0;ii<width;ii++,src+=3)
+                    dest16[ii] = (format == RawPNG565) ?
+                        (uint16_t)(((src[0] >> 3) << 11) | ((src[1] >> 2) << 5) | (src[2] >> 3)) :
+                        (uint16_t)(((src[0] >> 4) << 12) | ((src[1] >> 4) << 8) | ((src[2] >> 4) << 4) | 0xF);
+            }
+            break;
+        case 4:
+            if (format == RawPNGRGBA)
+                memcpy(dest, src, width*4);
+            else if (format == RawPNG565)
+                ConvertRGBATo565((const uint32_t *)src, (uint16_t *)dest, width);
+            else
+                ConvertRGBATo4444((const uint32_t *)src, (uint16_t *)dest, width);
+            break;
+    }
+}
+
+bool RawPNGDecoder::decodeInto(const unsigned char *data,size_t length,
+                               const std::vector<int> &valueMap,RawPNGFormat format,
+                               unsigned char *outData,size_t outLen,
+                               unsigned int &err)
+{
+    LodePNGState pngState;
+    lodepng_state_init(&pngState);
+    unsigned int width = 0, height = 0;
+    err = lodepng_inspect(&width, &height, &pngState, data, length);
+    const LodePNGColorMode colorMode = pngState.info_png.color;
+    const unsigned int interlace = pngState.info_png.interlace_method;
+    lodepng_state_cleanup(&pngState);
+    if (err)
+        return false;
+
+    const int byteWidth = OutputByteWidth(colorMode.colortype,format);
+    if (outLen < (size_t)width * height * byteWidth)
+    {
+        err = 83;
+        return false;
+    }
+
+    // Greyscale values get mapped on the way out
+    for (size_t ii=0;ii<256;ii++)
+    {
+        const int newVal = ii < valueMap.size() ? valueMap[ii] : -1;
+        valueLookup[ii] = newVal >= 0 ? newVal : ii;
+    }
+
+    // We can stream the common 8 bit types.  Find the image data as we check the chunks.
+    const int srcChannels = (colorMode.colortype == LCT_GREY) ? 1 : ((colorMode.colortype == LCT_RGB) ? 3 : 4);
+    bool streamable = colorMode.bitdepth == 8 && interlace == 0 &&
+                      (colorMode.colortype == LCT_GREY || colorMode.colortype == LCT_RGB || colorMode.colortype == LCT_RGBA);
+    idatChunks.clear();
+    if (streamable)
+    {
+        const unsigned char *end = data + length;
+        const unsigned char *chunk = data + 33;
+        while (true)
+        {
+            if (chunk + 12 > end)
+            {
+                err = 30;
+                return false;
+            }
+            const size_t chunkLength = lodepng_chunk_length(chunk);
+            if (chunkLength > (size_t)(end - chunk) - 12)
+            {
+                err = 64;
+                return false;
+            }
+            if (lodepng_chunk_type_equals(chunk, "IEND"))
+                break;
+
+            const bool isIDAT = lodepng_chunk_type_equals(chunk, "IDAT");
+            if (isIDAT || !lodepng_chunk_ancillary(chunk) || lodepng_chunk_type_equals(chunk, "tRNS"))
+            {
+                if (ReadBigEndian32(chunk + 8 + chunkLength) != crc32(0, chunk + 4, (uInt)chunkLength + 4))
+                {
+                    err = 57;
+                    return false;
+                }
+            }
+            if (isIDAT)
+                idatChunks.emplace_back(chunk + 8, chunkLength);
+            else if (lodepng_chunk_type_equals(chunk, "tRNS") && colorMode.colortype == LCT_RGB)
+            {
+                // Color key transparency, which lodepng handles
+                streamable = false;
+                break;
+            }
+
+            chunk += chunkLength + 12;
+        }
+    }
+
+    if (!streamable)
+    {
+        // Let lodepng do the odd cases, then copy out
+        unsigned char *decoded = nullptr;
+        const bool grey = colorMode.colortype == LCT_GREY;
+        err = lodepng_decode_memory(&decoded, &width, &height, data, length, grey ? LCT_GREY : LCT_RGBA, 8);
+        if (!err)
+        {
+            const int decodedChannels = grey ? 1 : 4;
+            for (unsigned int iy=0;iy<height;iy++)
+                writeRow(&decoded[(size_t)iy*width*decodedChannels], decodedChannels, &outData[(size_t)iy*width*byteWidth], width, format);
+        }
+        free(decoded);
+        return err == 0;
+    }
+
+    // Decompressor sticks around between images
+    if (!stream)
+    {
+        stream = new z_stream_s();
+        if (inflateInit(stream) != Z_OK)
+        {
+            delete stream;
+            stream = nullptr;
+            err = 83;
+            return false;
+        }
+    } else
+        inflateReset(stream);
+    stream->avail_in = 0;
+    nextChunk = 0;
+    streamDone = false;
+
+    // Two rows, current and previous, with the previous one empty to start
+    const size_t rowBytes = (size_t)width * srcChannels;
+    rowBuffer.resize(2 * rowBytes);
+    unsigned char *row = &rowBuffer[0], *prevRow = &rowBuffer[rowBytes];
+    memset(prevRow, 0, rowBytes);
+
+    for (unsigned int iy=0;iy<height;iy++)
+    {
+        unsigned char filter = 0;
+        if (!inflateBytes(&filter, 1) || !inflateBytes(row, rowBytes))
+        {
+            err = 91;
+            return false;
+        }
+        if (!UnfilterRow(filter, row, prevRow, rowBytes, srcChannels))
+        {
+            err = 36;
+            return false;
+        }
+        writeRow(row, srcChannels, &outData[(size_t)iy*width*byteWidth], width, format);
+        std::swap(row, prevRow);
+    }
+
+    // Run to the end so the checksum gets tested
+    unsigned char extra;
+    if (!streamDone && inflateBytes(&extra, 1))
+    {
+        // More data than the image needs
+        err = 91;
+        return false;
+    }
+    if (!streamDone)
+    {
+        err = 91;
+        return false;
+    }
+
+    return true;
+}
+
+RawDataRef RawPNGDecoder::decode(const unsigned char *data,size_t length,
+                                 const std::vector<int> &valueMap,RawPNGFormat format,
+                                 unsigned int &width,unsigned int &height,int &byteWidth,
+                                 unsigned int &err)
+{
+    if (!inspect(data, length, format, width, height, byteWidth, err))
+        return RawDataRef();
+
+    const size_t outLen = (size_t)width * height * byteWidth;
+    size_t capacity = 0;
+    unsigned char *outData = pool->get(outLen, capacity);
+    if (!outData)
+    {
+        err = 83;
+        return RawDataRef();
+    }
+    if (!decodeInto(data, length, valueMap, format, outData, outLen, err))
+    {
+        pool->put(outData, capacity);
+        return RawDataRef();
+    }
+
+    // Buffer goes back in the pool when the data is released, if we're still around
+    std::weak_ptr<BufferPool> weakPool = pool;
+    return std::make_shared<RawDataWrapper>(outData, outLen, [weakPool,capacity](const void *buf)
+    {
+        if (auto thePool = weakPool.lock())
+            thePool->put((unsigned char *)buf, capacity);
+        else
+            free((void *)buf);
+    });
+}
+
+RawPNGFormat RawPNGFormatForTexType(TextureType texType)
+{
+    switch (texType)
+    {
+        case TexTypeShort565:
+            return RawPNG565;
+        case TexTypeShort4444:
+            return RawPNG4444;
+        default:
+            // Everything else starts from RGBA, if the texture converts it at all
+            return RawPNGRGBA;
+    }
+}
+
+// Loader threads each get their own decoder
+static RawPNGDecoder &ThreadDecoder()
+{
+    static thread_local RawPNGDecoder decoder;
+    return decoder;
+}
+
 unsigned char *RawPNGImageLoaderInterpreter(unsigned int &width,unsigned int &height,
                                           const unsigned char *data,size_t length,
                                           const std::vector<int> &valueMap,
@@ -36,15 +439,16 @@ unsigned char *RawPNGImageLoaderInterpreter(unsigned int &width,unsigned int &he
     unsigned char *outData = NULL;
 
     try {
-        LodePNGState pngState;
-        lodepng_state_init(&pngState);
-        err = lodepng_inspect(&width, &height, &pngState, data, length);
-        if (pngState.info_png.color.colortype == LCT_GREY) {
-            byteWidth = 1;
-            err = lodepng_decode_memory(&outData, &width, &height, data, length, LCT_GREY, 8);
-        } else {
-            byteWidth = 4;
-            err = lodepng_decode_memory(&outData, &width, &height, data, length, LCT_RGBA, 8);
+        RawPNGDecoder &decoder = ThreadDecoder();
+        if (decoder.inspect(data, length, RawPNGRGBA, width, height, byteWidth, err)) {
+            const size_t outLen = (size_t)width * height * byteWidth;
+            outData = (unsigned char *)malloc(outLen);
+            if (!outData) {
+                err = 83;
+            } else if (!decoder.decodeInto(data, length, valueMap, RawPNGRGBA, outData, outLen, err)) {
+                free(outData);
+                outData = NULL;
+            }
         }
     }
     catch (const std::exception &ex) {
@@ -55,20 +459,30 @@ unsigned char *RawPNGImageLoaderInterpreter(unsigned int &width,unsigned int &he
         wkLogLevel(Error, "Exception in MaplyQuadImageLoader::dataForTile");
         err = -1;
     }
-    
-    // Remap data values
-    if (byteWidth == 1 && !valueMap.empty()) {
-        unsigned char *data = outData;
-        for (unsigned int ii=0;ii<width*height;ii++) {
-            int newVal = valueMap[*data];
-            if (newVal >= 0)
-                *data = newVal;
-            data++;
-        }
-    }
-    
+
     return outData;
 }
 
+RawDataRef RawPNGImageLoaderInterpreter(unsigned int &width,unsigned int &height,
+                                        const unsigned char *data,size_t length,
+                                        const std::vector<int> &valueMap,
+                                        RawPNGFormat format,
+                                        int &byteWidth,
+                                        unsigned int &err)
+{
+    try {
+        return ThreadDecoder().decode(data, length, valueMap, format, width, height, byteWidth, err);
+    }
+    catch (const std::exception &ex) {
+        wkLogLevel(Error, "Exception in MaplyQuadImageLoader::dataForTile: %s", ex.what());
+        err = -1;
+    }
+    catch (...) {
+        wkLogLevel(Error, "Exception in MaplyQuadImageLoader::dataForTile");
+        err = -1;
+    }
+
+    return RawDataRef();
 }
 
+}
@@ -18,10 +18,15 @@
  *
  */
 
+#import <typeinfo>
+#import <cxxabi.h>
 #import "WhirlyKitLog.h"
 #import "Scene.h"
+#import "SceneRenderer.h"
 #import "GlobeView.h"
 #import "GlobeMath.h"
+#import "FlatMath.h"
+#import "SphericalMercator.h"
 #import "TextureAtlas.h"
 #import "Platform.h"
 #import "FontTextureManager.h"
@@ -75,7 +80,10 @@ Scene::Scene(CoordSystemDisplayAdapter *adapter) :
     currentTime(0.0),
     coordAdapter(adapter),
     overlapMargin(0.0),
-    textures(100)
+    textures(100),
+    changeSeq(0),
+    numStagedChanges(0),
+    changeBudget(0.0)
 {
     SetupDrawableStrings();
     
@@ -139,13 +147,22 @@ Scene::~Scene()
     
     managers.clear();
     
-    auto theChangeRequests = changeRequests;
-    changeRequests.clear();
-    for (auto & theChangeRequest : theChangeRequests)
+    // Note: Tear down change requests?
+    for (auto &shard : changeShards)
     {
-        // Note: Tear down change requests?
-        delete theChangeRequest;
+        for (const auto &queued : shard.changes)
+            delete queued.change;
+        shard.changes.clear();
     }
+    for (const auto &queued : changeRequests)
+        delete queued.change;
+    changeRequests.clear();
+    for (const auto &queued : heldChangeRequests)
+        delete queued.change;
+    heldChangeRequests.clear();
+    for (auto change : timedChangeRequests)
+        delete change;
+    timedChangeRequests.clear();
     
     activeModels.clear();
     
@@ -167,36 +184,127 @@ void Scene::setDisplayAdapter(CoordSystemDisplayAdapter *newCoordAdapter)
     coordAdapter = newCoordAdapter;
 }
     
+// Threads are handed shards in turn the first time they add changes.
+// Hashing the thread ID doesn't work here, on some platforms it's an aligned pointer.
+static std::atomic<unsigned int> nextChangeShard(0);
+
+Scene::ChangeShard &Scene::shardForThread()
+{
+    static thread_local const unsigned int threadShard = nextChangeShard.fetch_add(1,std::memory_order_relaxed);
+    return changeShards[threadShard % NumChangeShards];
+}
+
 // Add change requests to our list
 void Scene::addChangeRequests(const ChangeSet &newChanges)
 {
-    std::lock_guard<std::mutex> guardLock(changeRequestLock);
-    
+    if (newChanges.empty())
+        return;
+
+    const TimeInterval queuedAt = TimeGetCurrent();
+    ChangeShard &shard = shardForThread();
+    std::lock_guard<std::mutex> guardLock(shard.lock);
+
+    // Sequence numbers are handed out under the shard lock so the
+    //  render thread can tell when it has seen everything before a given one
+    int numAdded = 0;
+    shard.changes.reserve(shard.changes.size() + newChanges.size());
     for (ChangeRequest *change : newChanges)
     {
-        if (change && change->when > 0.0)
-            timedChangeRequests.insert(change);
-        else
-            changeRequests.push_back(change);
+        if (change)
+        {
+            shard.changes.push_back(QueuedChange{change,changeSeq++,queuedAt});
+            numAdded++;
+        }
     }
+    numStagedChanges += numAdded;
 }
 
 // Add a single change request
 void Scene::addChangeRequest(ChangeRequest *newChange)
 {
-    std::lock_guard<std::mutex> guardLock(changeRequestLock);
+    if (!newChange)
+        return;
 
-    if (newChange && newChange->when > 0.0)
-        timedChangeRequests.insert(newChange);
-    else
-        changeRequests.push_back(newChange);
+    const TimeInterval queuedAt = TimeGetCurrent();
+    ChangeShard &shard = shardForThread();
+    std::lock_guard<std::mutex> guardLock(shard.lock);
+
+    shard.changes.push_back(QueuedChange{newChange,changeSeq++,queuedAt});
+    numStagedChanges++;
 }
 
 int Scene::getNumChangeRequests() const
 {
     std::lock_guard<std::mutex> guardLock(changeRequestLock);
 
-    return changeRequests.size();
+    return numStagedChanges + changeRequests.size() + heldChangeRequests.size();
+}
+
+void Scene::setChangeBudget(TimeInterval budget)
+{
+    changeBudget = budget;
+}
+
+TimeInterval Scene::getChangeBudget() const
+{
+    return changeBudget;
+}
+
+// Timed changes are kept in a min heap
+static bool TimedChangeHeapSort(const ChangeRequest *a,const ChangeRequest *b)
+{
+    return a->when > b->when;
+}
+
+void Scene::drainChangeShards(TimeInterval now)
+{
+    // Anything numbered below this is sitting in a shard already
+    const uint64_t seqLimit = changeSeq;
+
+    // Start with the ones we held back last time
+    drainedChangeRequests.clear();
+    drainedChangeRequests.swap(heldChangeRequests);
+
+    int numDrained = 0;
+    for (auto &shard : changeShards)
+    {
+        std::lock_guard<std::mutex> guardLock(shard.lock);
+        if (!shard.changes.empty())
+        {
+            numDrained += shard.changes.size();
+            drainedChangeRequests.insert(drainedChangeRequests.end(),shard.changes.begin(),shard.changes.end());
+            shard.changes.clear();
+        }
+    }
+    numStagedChanges -= numDrained;
+
+    // Put them back in the order they were added
+    std::sort(drainedChangeRequests.begin(),drainedChangeRequests.end(),
+              [](const QueuedChange &a,const QueuedChange &b){ return a.seq < b.seq; });
+
+    for (const auto &queued : drainedChangeRequests)
+    {
+        if (queued.seq >= seqLimit)
+        {
+            // Something before this one may not have landed in its shard yet
+            heldChangeRequests.push_back(queued);
+        } else if (queued.change->when > 0.0) {
+            timedChangeRequests.push_back(queued.change);
+            std::push_heap(timedChangeRequests.begin(),timedChangeRequests.end(),TimedChangeHeapSort);
+        } else {
+            changeRequests.push_back(queued);
+        }
+    }
+    drainedChangeRequests.clear();
+
+    // See if any of the timed changes are ready
+    while (!timedChangeRequests.empty() && now >= timedChangeRequests.front()->when)
+    {
+        ChangeRequest *req = timedChangeRequests.front();
+        std::pop_heap(timedChangeRequests.begin(),timedChangeRequests.end(),TimedChangeHeapSort);
+        timedChangeRequests.pop_back();
+        changeRequests.push_back(QueuedChange{req,0,req->when});
+    }
 }
 
 DrawableRef Scene::getDrawable(SimpleIdentity drawId) const
@@ -303,6 +411,139 @@ std::vector<Drawable *> Scene::getDrawables() const
     return retDraws;
 }
 
+// Left, right, bottom and top clipping planes for a model/view/projection matrix, normalized.
+// We skip near and far, which differ between the renderers and rarely cull anything.
+static void FrustumSidePlanes(const Eigen::Matrix4d &mvpMat,Vector4dVector &planes)
+{
+    for (int row=0;row<2;row++)
+    {
+        for (double sign : {1.0,-1.0})
+        {
+            const Eigen::Vector4d plane = mvpMat.row(3).transpose() + sign * mvpMat.row(row).transpose();
+            planes.push_back(plane / plane.head<3>().norm());
+        }
+    }
+}
+
+// True if the sphere is at least partly inside one of the frustums, four planes each
+static bool SphereInFrustums(const Vector4dVector &planes,const Point3d &center,double radius)
+{
+    for (size_t start=0;start<planes.size();start+=4)
+    {
+        bool inside = true;
+        for (size_t ii=start;ii<start+4 && inside;ii++)
+            inside = planes[ii].head<3>().dot(center) + planes[ii].w() >= -radius;
+        if (inside)
+            return true;
+    }
+    return false;
+}
+
+// Bounding sphere in display space for a geographic MBR with the geometry on or under the surface.
+// We only do this for the display adapters where a geographic box is bounded by its corners.
+static bool GeoMbrDisplayBounds(const CoordSystemDisplayAdapter *coordAdapter,const Mbr &mbr,Point3d &center,double &radius)
+{
+    if (!mbr.valid())
+        return false;
+
+    CoordSystem *coordSys = coordAdapter->getCoordSystem();
+    const GeoCoord corners[4] = { GeoCoord(mbr.ll().x(),mbr.ll().y()), GeoCoord(mbr.ur().x(),mbr.ll().y()),
+                                  GeoCoord(mbr.ur().x(),mbr.ur().y()), GeoCoord(mbr.ll().x(),mbr.ur().y()) };
+    if (coordAdapter->isFlat())
+    {
+        // Lines of latitude and longitude stay straight in these
+        if (!dynamic_cast<SphericalMercatorCoordSystem *>(coordSys) && !dynamic_cast<PlateCarreeCoordSystem *>(coordSys))
+            return false;
+        Point3d ll,ur;
+        for (int ii=0;ii<4;ii++)
+        {
+            const Point3d pt = coordAdapter->localToDisplay(coordSys->geographicToLocal3d(corners[ii]));
+            ll = ii ? ll.cwiseMin(pt) : pt;
+            ur = ii ? ur.cwiseMax(pt) : pt;
+        }
+        center = (ll + ur) / 2.0;
+        radius = (ur - ll).norm() / 2.0;
+    } else {
+        // On the unit sphere the farthest point from the middle is a corner, up to half way around
+        if (!dynamic_cast<const FakeGeocentricDisplayAdapter *>(coordAdapter) || mbr.ur().x() - mbr.ll().x() > M_PI)
+            return false;
+        const Point2f mid = mbr.mid();
+        center = coordAdapter->localToDisplay(coordSys->geographicToLocal3d(GeoCoord(mid.x(),mid.y())));
+        radius = 0.0;
+        for (const auto &corner : corners)
+            radius = std::max(radius,(coordAdapter->localToDisplay(coordSys->geographicToLocal3d(corner)) - center).norm());
+    }
+
+    // A little extra for rounding and small offsets along the normal
+    radius = radius * 1.01 + 1e-6;
+    return true;
+}
+
+void Scene::getSortedDrawables(const RendererFrameInfo *frameInfo,const std::vector<Eigen::Matrix4d> &mvpMats,
+                               std::vector<Drawable *> &retDraws)
+{
+    std::lock_guard<std::mutex> guardLock(drawablesLock);
+
+    mergeDrawOrder();
+
+    // Whole nodes go if we're out of their height or zoom range
+    std::vector<std::pair<const DrawOrderEntry *,const DrawOrderEntry *>> visibleNodes;
+    size_t numEntries = 0;
+    for (const auto &it : drawCullNodes)
+    {
+        if (it.first.isVisible(frameInfo))
+        {
+            const auto &entries = it.second.entries;
+            visibleNodes.emplace_back(entries.data(),entries.data()+entries.size());
+            numEntries += entries.size();
+        }
+    }
+
+    Vector4dVector planes;
+    planes.reserve(4*mvpMats.size());
+    for (const auto &mvpMat : mvpMats)
+        FrustumSidePlanes(mvpMat,planes);
+
+    // Merge the visible nodes back into one draw order, leaving out what's off screen
+    retDraws.clear();
+    retDraws.reserve(numEntries);
+    const auto laterNode = [](const std::pair<const DrawOrderEntry *,const DrawOrderEntry *> &a,
+                              const std::pair<const DrawOrderEntry *,const DrawOrderEntry *> &b)
+        { return *b.first < *a.first; };
+    std::vector<Drawable *> stale;
+    std::make_heap(visibleNodes.begin(),visibleNodes.end(),laterNode);
+    while (!visibleNodes.empty())
+    {
+        std::pop_heap(visibleNodes.begin(),visibleNodes.end(),laterNode);
+        auto &node = visibleNodes.back();
+        const DrawOrderEntry &entry = *node.first;
+        if (entry.radius < 0.0 || SphereInFrustums(planes,entry.center,entry.radius))
+        {
+            retDraws.push_back(entry.draw);
+            if (entry.priority != entry.draw->getDrawPriority())
+                stale.push_back(entry.draw);
+        }
+        if (++node.first == node.second)
+            visibleNodes.pop_back();
+        else
+            std::push_heap(visibleNodes.begin(),visibleNodes.end(),laterNode);
+    }
+
+    // Someone changed a priority without telling us.  Sort this frame the slow way and fix the entries for the next.
+    if (!stale.empty())
+    {
+        std::sort(retDraws.begin(),retDraws.end(),[](const Drawable *a,const Drawable *b) {
+            const unsigned int priA = a->getDrawPriority(), priB = b->getDrawPriority();
+            return (priA == priB) ? (a->getId() < b->getId()) : (priA < priB);
+        });
+        for (Drawable *draw : stale)
+        {
+            removeFromDrawOrder(draw);
+            addToDrawOrder(draw);
+        }
+    }
+}
+
 void Scene::setCurrentTime(TimeInterval newTime)
 {
     currentTime = newTime;
@@ -328,19 +569,21 @@ TimeInterval Scene::getBaseTime() const
     return baseTime;
 }
     
-int Scene::preProcessChanges(WhirlyKit::View *view,SceneRenderer *renderer,__unused TimeInterval now)
+int Scene::preProcessChanges(WhirlyKit::View *view,SceneRenderer *renderer,TimeInterval now)
 {
     ChangeSet preRequests;
 
     {
         std::lock_guard<std::mutex> guardLock(changeRequestLock);
+        drainChangeShards(now);
+
         // Just doing the ones that require a pre-process
-        for (auto &changeRequest : changeRequests)
+        for (auto &queued : changeRequests)
         {
-            ChangeRequest *req = changeRequest;
+            ChangeRequest *req = queued.change;
             if (req && req->needPreExecute()) {
                 preRequests.push_back(req);
-                changeRequest = nullptr;
+                queued.change = nullptr;
             }
         }
     }
@@ -358,47 +601,88 @@ int Scene::preProcessChanges(WhirlyKit::View *view,SceneRenderer *renderer,__unu
 // We'll grab the lock and we're only expecting to be called in the rendering thread
 int Scene::processChanges(WhirlyKit::View *view,SceneRenderer *renderer,TimeInterval now)
 {
+    WK_TRACE_SCOPE("Scene::processChanges");
+
     std::lock_guard<std::mutex> guardLock(changeRequestLock);
-    // See if any of the timed changes are ready
-    std::vector<ChangeRequest *> toMove;
-    for (ChangeRequest *req : timedChangeRequests)
+    drainChangeShards(now);
+
+    WK_TRACE_COUNTER("Change queue depth",changeRequests.size());
+
+    const bool perf = renderer && renderer->perfInterval > 0;
+    if (perf)
+        renderer->perfTimer.addCount("Change queue depth", (int)changeRequests.size());
+
+    // Read the budget once so a change from another thread can't land mid-frame
+    const TimeInterval budget = changeBudget;
+    const TimeInterval startTime = (budget > 0.0) ? TimeGetCurrent() : 0.0;
+    int numChanges = 0;
+    while (!changeRequests.empty())
     {
-        if (now >= req->when)
-            toMove.push_back(req);
-        else
+        // Over budget, but always make some progress
+        if (budget > 0.0 && numChanges > 0 && TimeGetCurrent() - startTime > budget)
             break;
-    }
-    for (ChangeRequest *req : toMove)
-    {
-        timedChangeRequests.erase(req);
-        changeRequests.push_back(req);
-    }
-    
-    for (auto req : changeRequests)
-    {
-        if (req) {
-            req->execute(this,renderer,view);
-            delete req;
+
+        const QueuedChange queued = changeRequests.front();
+        changeRequests.pop_front();
+        numChanges++;
+
+        // Might have been run in the pre-process
+        if (!queued.change)
+            continue;
+
+        if (perf)
+        {
+            const TimeInterval execStart = TimeGetCurrent();
+            renderer->perfTimer.addTime("Change wait", execStart - queued.queuedAt);
+            queued.change->execute(this,renderer,view);
+            renderer->perfTimer.addTime(getChangeName(queued.change), TimeGetCurrent() - execStart);
+        } else {
+            queued.change->execute(this,renderer,view);
         }
+        delete queued.change;
     }
-    int numChanges = changeRequests.size();
-    changeRequests.clear();
-    
+
+    if (perf && !changeRequests.empty())
+        renderer->perfTimer.addCount("Changes deferred", (int)changeRequests.size());
+
     return numChanges;
 }
     
+// Mangled type names differ between compilers, so demangle and drop the namespace.
+// "WhirlyKit::AddTextureReq" comes out as "Change: AddTextureReq".
+const std::string &Scene::getChangeName(const ChangeRequest *change)
+{
+    const std::type_info &type = typeid(*change);
+    auto it = changeNames.find(type);
+    if (it != changeNames.end())
+        return it->second;
+
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    std::string name = (status == 0 && demangled) ? demangled : type.name();
+    free(demangled);
+    const auto sep = name.rfind("::");
+    if (sep != std::string::npos)
+        name = name.substr(sep+2);
+
+    return changeNames.emplace(type, "Change: " + name).first->second;
+}
+
 bool Scene::hasChanges(TimeInterval now) const
 {
-    bool changes = false;
-    std::unique_lock<std::mutex> lock(changeRequestLock,std::try_to_lock);
-    if (lock.owns_lock())
+    bool changes = numStagedChanges > 0;
+    if (!changes)
     {
-        changes = !changeRequests.empty();
-        
-        if (!changes && !timedChangeRequests.empty())
-            changes = now >= (*timedChangeRequests.begin())->when;
+        std::unique_lock<std::mutex> lock(changeRequestLock,std::try_to_lock);
+        if (lock.owns_lock())
+        {
+            changes = !changeRequests.empty() || !heldChangeRequests.empty();
 
-        lock.unlock();
+            if (!changes && !timedChangeRequests.empty())
+                changes = now >= timedChangeRequests.front()->when;
+
+            lock.unlock();
+        }
     }
     
     // How about the active models?
@@ -470,7 +754,11 @@ void Scene::addDrawable(DrawableRef draw)
 {
     std::lock_guard<std::mutex> guardLock(drawablesLock);
 
-    drawables[draw->getId()] = std::move(draw);
+    auto &entry = drawables[draw->getId()];
+    if (entry)
+        removeFromDrawOrder(entry.get());
+    addToDrawOrder(draw.get());
+    entry = std::move(draw);
 }
     
 void Scene::remDrawable(const DrawableRef &draw)
@@ -484,7 +772,96 @@ void Scene::remDrawable(SimpleIdentity id)
 
     const auto it = drawables.find(id);
     if (it != drawables.end())
+    {
+        removeFromDrawOrder(it->second.get());
         drawables.erase(it);
+    }
+}
+
+void Scene::updateDrawable(Drawable *draw)
+{
+    std::lock_guard<std::mutex> guardLock(drawablesLock);
+
+    // Only if it's still ours
+    const auto it = drawables.find(draw->getId());
+    if (it != drawables.end() && it->second.get() == draw)
+    {
+        removeFromDrawOrder(draw);
+        addToDrawOrder(draw);
+    }
+}
+
+void Scene::addToDrawOrder(Drawable *draw)
+{
+    drawOrderAdds.insert(draw);
+}
+
+void Scene::removeFromDrawOrder(Drawable *draw)
+{
+    // The pointer may be reused before we merge, so a queued add doesn't cancel the remove
+    drawOrderAdds.erase(draw);
+    drawOrderRemoves.insert(draw);
+}
+
+void Scene::mergeDrawOrder()
+{
+    if (!drawOrderRemoves.empty())
+    {
+        std::unordered_set<DrawCullNode *> changedNodes;
+        for (const Drawable *draw : drawOrderRemoves)
+        {
+            const auto it = drawCullNodeOf.find(draw);
+            if (it != drawCullNodeOf.end())
+            {
+                changedNodes.insert(it->second);
+                drawCullNodeOf.erase(it);
+            }
+        }
+        for (DrawCullNode *node : changedNodes)
+        {
+            auto &entries = node->entries;
+            entries.erase(std::remove_if(entries.begin(),entries.end(),
+                                         [this](const DrawOrderEntry &e) { return drawOrderRemoves.count(e.draw) > 0; }),
+                          entries.end());
+        }
+        for (auto it = drawCullNodes.begin();it != drawCullNodes.end();)
+            it = it->second.entries.empty() ? drawCullNodes.erase(it) : std::next(it);
+        drawOrderRemoves.clear();
+    }
+
+    if (!drawOrderAdds.empty())
+    {
+        // Tack the new entries on to each node, then sort them and merge them in once
+        std::unordered_map<DrawCullNode *,size_t> oldSizes;
+        for (Drawable *draw : drawOrderAdds)
+        {
+            DrawCullNode *node = &drawCullNodes[draw->getVisibleRange()];
+            oldSizes.emplace(node,node->entries.size());
+            drawCullNodeOf[draw] = node;
+
+            // Left unbounded unless we can make sense of its MBR
+            DrawOrderEntry entry { draw->getDrawPriority(), draw->getId(), draw, Point3d(0,0,0), -1.0 };
+            if (draw->getLocalMbrType() == LocalMbrGeographic)
+                GeoMbrDisplayBounds(coordAdapter,draw->getLocalMbr(),entry.center,entry.radius);
+            node->entries.push_back(entry);
+        }
+        for (const auto &it : oldSizes)
+        {
+            auto &entries = it.first->entries;
+            const auto mid = entries.begin() + it.second;
+            std::sort(mid,entries.end());
+            std::inplace_merge(entries.begin(),mid,entries.end());
+        }
+        drawOrderAdds.clear();
+    }
+}
+
+void Scene::clearDrawOrder()
+{
+    drawCullNodes.clear();
+    drawCullNodeOf.clear();
+    drawOrderAdds.clear();
+    drawOrderRemoves.clear();
 }
 
 void Scene::addTexture(TextureBaseRef texRef)
@@ -772,6 +1149,11 @@ void RunBlockReq::execute(Scene *scene,SceneRenderer *renderer,WhirlyKit::View *
     func(scene,renderer,view);
 }
     
+void TraceAsyncEndReq::execute(Scene *scene,SceneRenderer *renderer,View *view)
+{
+    PerformanceTrace::addAsyncEnd(name,asyncID);
+}
+
 SetZoomSlotReq::SetZoomSlotReq(int zoomSlot,float zoomVal)
 : zoomSlot(zoomSlot), zoomVal(zoomVal)
 {
@@ -53,6 +53,7 @@ void SceneGLES::teardown(PlatformThreadInfo* threadInfo)
         it.second->teardownForRenderer(setupInfo,this, nullptr);
     }
     drawables.clear();
+    clearDrawOrder();
 
     for (const auto& it : textures)
     {
@@ -19,6 +19,7 @@
  */
 
 #import "SceneRenderer.h"
+#import "MaplyView.h"
 
 using namespace Eigen;
 
@@ -41,7 +42,8 @@ bool matrixAisSameAsB(Matrix4d &a,Matrix4d &b)
     
 RendererFrameInfo::RendererFrameInfo()
 : sceneRenderer(NULL), theView(NULL), scene(NULL), frameLen(0), currentTime(0),
-heightAboveSurface(0), screenSizeInDisplayCoords(0,0), lights(NULL), program(NULL)
+heightAboveSurface(0), screenSizeInDisplayCoords(0,0), lights(NULL), program(NULL),
+zoomSlots(NULL)
 {
 }
 
@@ -50,6 +52,13 @@ RendererFrameInfo::RendererFrameInfo(const RendererFrameInfo &that)
     *this = that;
 }
 
+float RendererFrameInfo::getZoomSlotValue(int zoomSlot) const
+{
+    if (zoomSlots)
+        return (zoomSlot < 0 || zoomSlot >= MaplyMaxZoomSlots) ? 0.0f : zoomSlots[zoomSlot];
+    return scene ? scene->getZoomSlotValue(zoomSlot) : 0.0f;
+}
+
 WorkGroup::~WorkGroup()
 {
     for (auto &targetCon : renderTargetContainers) {
@@ -502,5 +511,104 @@ void SceneRenderer::shutdown()
     workGroups.clear();
     lights.clear();
 }
-    
+
+void SceneRenderer::setupFrameInfo(RendererFrameInfo &frameInfo,TimeInterval duration,TimeInterval now)
+{
+    // See if we're dealing with a globe or map view
+    float overlapMarginX = 0.0;
+    if (dynamic_cast<Maply::MapView *>(theView))
+    {
+        overlapMarginX = (float)scene->getOverlapMargin();
+    }
+
+    // Get the model and view matrices
+    const Eigen::Matrix4d modelTrans4d = theView->calcModelMatrix();
+    const Eigen::Matrix4f modelTrans = Matrix4dToMatrix4f(modelTrans4d);
+    const Eigen::Matrix4d viewTrans4d = theView->calcViewMatrix();
+    const Eigen::Matrix4f viewTrans = Matrix4dToMatrix4f(viewTrans4d);
+
+    // Set up a projection matrix
+    const Point2f frameSize(framebufferWidth,framebufferHeight);
+    const Eigen::Matrix4d projMat4d = theView->calcProjectionMatrix(frameSize,0.0);
+
+    const Eigen::Matrix4f projMat = Matrix4dToMatrix4f(projMat4d);
+    const Eigen::Matrix4f modelAndViewMat = viewTrans * modelTrans;
+    const Eigen::Matrix4d modelAndViewMat4d = viewTrans4d * modelTrans4d;
+    const Eigen::Matrix4d pvMat = projMat4d * viewTrans4d;
+    const Eigen::Matrix4f mvpMat = projMat * (modelAndViewMat);
+
+    frameInfo.sceneRenderer = this;
+    frameInfo.theView = theView;
+    frameInfo.viewTrans = viewTrans;
+    frameInfo.viewTrans4d = viewTrans4d;
+    frameInfo.modelTrans = modelTrans;
+    frameInfo.modelTrans4d = modelTrans4d;
+    frameInfo.scene = scene;
+    frameInfo.frameLen = duration;
+    frameInfo.currentTime = now;
+    frameInfo.projMat = projMat;
+    frameInfo.projMat4d = projMat4d;
+    frameInfo.mvpMat = mvpMat;
+    frameInfo.mvpInvMat = mvpMat.inverse();
+    frameInfo.mvpNormalMat = mvpMat.inverse().transpose();
+    frameInfo.viewModelNormalMat = Matrix4dToMatrix4f(modelAndViewMat4d.inverse().transpose());
+    frameInfo.viewAndModelMat = modelAndViewMat;
+    frameInfo.viewAndModelMat4d = modelAndViewMat4d;
+    frameInfo.pvMat = Matrix4dToMatrix4f(pvMat);
+    frameInfo.pvMat4d = pvMat;
+    theView->getOffsetMatrices(frameInfo.offsetMatrices, frameSize, overlapMarginX);
+    frameInfo.screenSizeInDisplayCoords = theView->screenSizeInDisplayCoords(frameSize);
+    frameInfo.lights = &lights;
+
+    // We need a reverse of the eye vector in model space
+    // We'll use this to determine what's pointed away
+    const Vector4f eyeVec4 = modelTrans.inverse() * Vector4f(0,0,1,0);
+    frameInfo.eyeVec = Vector3f(eyeVec4.x(),eyeVec4.y(),eyeVec4.z());
+    const Vector4f fullEyeVec4 = modelAndViewMat.inverse() * Vector4f(0,0,1,0);
+    frameInfo.fullEyeVec = -Vector3f(fullEyeVec4.x(),fullEyeVec4.y(),fullEyeVec4.z());
+    const Vector4d eyeVec4d = modelTrans4d.inverse() * Vector4d(0,0,1,0.0);
+    frameInfo.heightAboveSurface = (float)theView->heightAboveSurface();
+    frameInfo.eyePos = Vector3d(eyeVec4d.x(),eyeVec4d.y(),eyeVec4d.z()) * (1.0+frameInfo.heightAboveSurface);
+}
+
+void SceneRenderer::calcOffsetTransforms(const RendererFrameInfo &frameInfo)
+{
+    const std::vector<Matrix4d> &offsetMats = frameInfo.offsetMatrices;
+    const unsigned int numOffsets = offsetMats.size();
+    offsetTransforms.mvpMats.resize(numOffsets);
+    offsetTransforms.mvMats.resize(numOffsets);
+    offsetTransforms.mvpMats4f.resize(numOffsets);
+    offsetTransforms.mvpInvMats4f.resize(numOffsets);
+    offsetTransforms.mvMats4f.resize(numOffsets);
+    offsetTransforms.mvNormalMats4f.resize(numOffsets);
+    for (unsigned int off=0;off<numOffsets;off++)
+    {
+        // Tweak with the appropriate offset matrix
+        offsetTransforms.mvMats[off] = frameInfo.viewTrans4d * offsetMats[off] * frameInfo.modelTrans4d;
+        offsetTransforms.mvpMats[off] = frameInfo.projMat4d * offsetTransforms.mvMats[off];
+        offsetTransforms.mvpMats4f[off] = Matrix4dToMatrix4f(offsetTransforms.mvpMats[off]);
+        offsetTransforms.mvpInvMats4f[off] = Matrix4dToMatrix4f(offsetTransforms.mvpMats[off].inverse());
+        offsetTransforms.mvMats4f[off] = Matrix4dToMatrix4f(offsetTransforms.mvMats[off]);
+        offsetTransforms.mvNormalMats4f[off] = Matrix4dToMatrix4f(offsetTransforms.mvMats[off].inverse().transpose());
+    }
+}
+
+void SceneRenderer::setDrawTransforms(RendererFrameInfo &frameInfo,const Drawable *drawable,unsigned int off) const
+{
+    if (const Matrix4d *localMat = drawable->getMatrix())
+    {
+        const Eigen::Matrix4d newMvpMat = offsetTransforms.mvpMats[off] * (*localMat);
+        const Eigen::Matrix4d newMvMat = offsetTransforms.mvMats[off] * (*localMat);
+        frameInfo.mvpMat = Matrix4dToMatrix4f(newMvpMat);
+        frameInfo.mvpInvMat = Matrix4dToMatrix4f(newMvpMat.inverse());
+        frameInfo.viewAndModelMat = Matrix4dToMatrix4f(newMvMat);
+        frameInfo.viewModelNormalMat = Matrix4dToMatrix4f(newMvMat.inverse().transpose());
+    } else {
+        frameInfo.mvpMat = offsetTransforms.mvpMats4f[off];
+        frameInfo.mvpInvMat = offsetTransforms.mvpInvMats4f[off];
+        frameInfo.viewAndModelMat = offsetTransforms.mvMats4f[off];
+        frameInfo.viewModelNormalMat = offsetTransforms.mvNormalMats4f[off];
+    }
+}
+
 }
@@ -26,7 +26,6 @@
 #import "WideVectorDrawableBuilderGLES.h"
 #import "ParticleSystemDrawableBuilderGLES.h"
 #import "DynamicTextureAtlasGLES.h"
-#import "MaplyView.h"
 #import "WhirlyKitLog.h"
 
 using namespace Eigen;
@@ -178,80 +177,6 @@ bool SceneRendererGLES::resize(int sizeX,int sizeY)
 
 SceneRendererGLES::~SceneRendererGLES() = default;
 
-// Keep track of a drawable and the MVP we're supposed to use with it
-class DrawableContainer
-{
-public:
-    explicit DrawableContainer(DrawableGLES *draw) :
-        drawable(draw),
-        mvpMat(Eigen::Matrix4d::Identity()),
-        mvMat(Eigen::Matrix4d::Identity()),
-        mvNormalMat(Eigen::Matrix4d::Identity())
-    {
-    }
-
-    DrawableContainer(DrawableGLES *draw,Matrix4d mvpMat,Matrix4d mvMat,Matrix4d mvNormalMat) :
-        drawable(draw),
-        mvpMat(std::move(mvpMat)),
-        mvMat(std::move(mvMat)),
-        mvNormalMat(std::move(mvNormalMat))
-    {
-    }
-
-    DrawableGLES *drawable;
-    Matrix4d mvpMat,mvMat,mvNormalMat;
-};
-
-// Alpha stuff goes at the end
-// Otherwise sort by draw priority
-class DrawListSortStruct2
-{
-public:
-    DrawListSortStruct2() = delete;
-    DrawListSortStruct2(bool useZBuffer,const RendererFrameInfo *frameInfo) : useZBuffer(useZBuffer), frameInfo(frameInfo)
-    {
-    }
-    DrawListSortStruct2(const DrawListSortStruct2 &that) = default;
-    DrawListSortStruct2 & operator =(const DrawListSortStruct2 &that)
-    {
-        if (this != &that)
-        {
-            useZBuffer = that.useZBuffer;
-            frameInfo = that.frameInfo;
-        }
-        return *this;
-    }
-    bool operator()(const DrawableContainer &conA, const DrawableContainer &conB) const
-    {
-        const Drawable *a = conA.drawable;
-        const Drawable *b = conB.drawable;
-
-        if (a->getDrawPriority() == b->getDrawPriority())
-        {
-            if (useZBuffer)
-            {
-                const bool bufferA = a->getRequestZBuffer();
-                const bool bufferB = b->getRequestZBuffer();
-                if (bufferA != bufferB)
-                    return !bufferA;
-            }
-            // Ensure a stable order among items with identical priority and z-buffering
-            const auto idA = a->getId();
-            const auto idB = b->getId();
-            if (idA == idB) {
-                // Different offsets of the same item
-                return (&conA < &conB);
-            }
-            return (idA < idB);
-        }
-        
-        return a->getDrawPriority() < b->getDrawPriority();
-    }
-    
-    bool useZBuffer;
-    const RendererFrameInfo *frameInfo;
-};
-
 void SceneRendererGLES::setExtraFrameMode(bool newMode)
 {
     extraFrameMode = newMode;
@@ -269,6 +194,8 @@ void SceneRendererGLES::render(TimeInterval duration)
     if (!scene)
         return;
     
+    WK_TRACE_SCOPE("SceneRenderer::render");
+
     frameCount++;
         
     theView->animate();
@@ -290,32 +217,6 @@ void SceneRendererGLES::render(TimeInterval duration)
         glEnable(GL_BLEND);
     }
     
-    // See if we're dealing with a globe or map view
-    float overlapMarginX = 0.0;
-    if (__unused const auto mapView = dynamic_cast<Maply::MapView *>(theView))
-    {
-        overlapMarginX = (float)scene->getOverlapMargin();
-    }
-    
-    // Get the model and view matrices
-    const Eigen::Matrix4d modelTrans4d = theView->calcModelMatrix();
-    const Eigen::Matrix4f modelTrans = Matrix4dToMatrix4f(modelTrans4d);
-    const Eigen::Matrix4d viewTrans4d = theView->calcViewMatrix();
-    const Eigen::Matrix4f viewTrans = Matrix4dToMatrix4f(viewTrans4d);
-    
-    // Set up a projection matrix
-    const Point2f frameSize(framebufferWidth,framebufferHeight);
-    const Eigen::Matrix4d projMat4d = theView->calcProjectionMatrix(frameSize,0.0);
-
-    const Eigen::Matrix4f projMat = Matrix4dToMatrix4f(projMat4d);
-    Eigen::Matrix4f modelAndViewMat = viewTrans * modelTrans;
-    Eigen::Matrix4d modelAndViewMat4d = viewTrans4d * modelTrans4d;
-    Eigen::Matrix4d pvMat = projMat4d * viewTrans4d;
-    const Eigen::Matrix4f mvpMat = projMat * (modelAndViewMat);
-    Eigen::Matrix4f mvpNormalMat4f = mvpMat.inverse().transpose();
-    Eigen::Matrix4d modelAndViewNormalMat4d = modelAndViewMat4d.inverse().transpose();
-    Eigen::Matrix4f modelAndViewNormalMat = Matrix4dToMatrix4f(modelAndViewNormalMat4d);
-    
     switch (zBufferMode)
     {
         case zBufferOn:
@@ -349,45 +250,7 @@ void SceneRendererGLES::render(TimeInterval duration)
         
         RendererFrameInfoGLES baseFrameInfo;
         baseFrameInfo.glesVersion = setupInfo.glesVersion;
-        baseFrameInfo.sceneRenderer = this;
-        baseFrameInfo.theView = theView;
-        baseFrameInfo.viewTrans = viewTrans;
-        baseFrameInfo.viewTrans4d = viewTrans4d;
-        baseFrameInfo.modelTrans = modelTrans;
-        baseFrameInfo.modelTrans4d = modelTrans4d;
-        baseFrameInfo.scene = scene;
-        baseFrameInfo.frameLen = duration;
-        baseFrameInfo.currentTime = scene->getCurrentTime();
-        baseFrameInfo.projMat = projMat;
-        baseFrameInfo.projMat4d = projMat4d;
-        baseFrameInfo.mvpMat = mvpMat;
-        Eigen::Matrix4f mvpInvMat = mvpMat.inverse();
-        baseFrameInfo.mvpInvMat = mvpInvMat;
-        baseFrameInfo.mvpNormalMat = mvpNormalMat4f;
-        baseFrameInfo.viewModelNormalMat = modelAndViewNormalMat;
-        baseFrameInfo.viewAndModelMat = modelAndViewMat;
-        baseFrameInfo.viewAndModelMat4d = modelAndViewMat4d;
-        baseFrameInfo.pvMat = Matrix4dToMatrix4f(pvMat);
-        baseFrameInfo.pvMat4d = pvMat;
-        theView->getOffsetMatrices(baseFrameInfo.offsetMatrices, frameSize, overlapMarginX);
-        const Point2d screenSize = theView->screenSizeInDisplayCoords(frameSize);
-        baseFrameInfo.screenSizeInDisplayCoords = screenSize;
-        baseFrameInfo.lights = &lights;
-        
-        // We need a reverse of the eye vector in model space
-        // We'll use this to determine what's pointed away
-        Eigen::Matrix4f modelTransInv = modelTrans.inverse();
-        Vector4f eyeVec4 = modelTransInv * Vector4f(0,0,1,0);
-        Vector3f eyeVec3(eyeVec4.x(),eyeVec4.y(),eyeVec4.z());
-        baseFrameInfo.eyeVec = eyeVec3;
-        Eigen::Matrix4f fullTransInv = modelAndViewMat.inverse();
-        Vector4f fullEyeVec4 = fullTransInv * Vector4f(0,0,1,0);
-        Vector3f fullEyeVec3(fullEyeVec4.x(),fullEyeVec4.y(),fullEyeVec4.z());
-        baseFrameInfo.fullEyeVec = -fullEyeVec3;
-        Vector4d eyeVec4d = modelTrans4d.inverse() * Vector4d(0,0,1,0.0);
-        baseFrameInfo.heightAboveSurface = 0.0;
-        baseFrameInfo.heightAboveSurface = (float)theView->heightAboveSurface();
-        baseFrameInfo.eyePos = Vector3d(eyeVec4d.x(),eyeVec4d.y(),eyeVec4d.z()) * (1.0+baseFrameInfo.heightAboveSurface);
+        setupFrameInfo(baseFrameInfo,duration,now);
         
         if (perfInterval > 0)
             perfTimer.startTiming("Scene preprocessing");
@@ -429,68 +292,25 @@ void SceneRendererGLES::render(TimeInterval duration)
         if (perfInterval > 0)
             perfTimer.stopTiming("Scene processing");
         
+        // Snapshot the zoom slots so the drawables don't each take the lock
+        float frameZoomSlots[MaplyMaxZoomSlots];
+        scene->copyZoomSlots(frameZoomSlots);
+        baseFrameInfo.zoomSlots = frameZoomSlots;
+        
+        if (perfInterval > 0)
+            perfTimer.startTiming("Draw List");
+        
         // Work through the available offset matrices (only 1 if we're not wrapping)
-        std::vector<Matrix4d> &offsetMats = baseFrameInfo.offsetMatrices;
-        // Turn these drawables in to a vector
-        std::vector<DrawableContainer> drawList;
-        std::vector<DrawableRef> screenDrawables;
-        std::vector<DrawableRef> generatedDrawables;
-        std::vector<Matrix4d> mvpMats;
-        std::vector<Matrix4d> mvpInvMats;
-        std::vector<Matrix4f> mvpMats4f;
-        std::vector<Matrix4f> mvpInvMats4f;
-        mvpMats.resize(offsetMats.size());
-        mvpInvMats.resize(offsetMats.size());
-        mvpMats4f.resize(offsetMats.size());
-        mvpInvMats4f.resize(offsetMats.size());
-        for (unsigned int off=0;off<offsetMats.size();off++)
+        //  and put the visible drawables in order
+        calcOffsetTransforms(baseFrameInfo);
+        buildDrawList(&baseFrameInfo,visibleDrawables,drawList);
+        
+        if (perfInterval > 0)
         {
-            RendererFrameInfo offFrameInfo(baseFrameInfo);  // NOLINT: slicing from GLES frame
-            // Tweak with the appropriate offset matrix
-            modelAndViewMat4d = viewTrans4d * offsetMats[off] * modelTrans4d;
-            pvMat = projMat4d * viewTrans4d * offsetMats[off];
-            modelAndViewMat = Matrix4dToMatrix4f(modelAndViewMat4d);
-            mvpMats[off] = projMat4d * modelAndViewMat4d;
-            mvpInvMats[off] = (Eigen::Matrix4d)mvpMats[off].inverse();
-            mvpMats4f[off] = Matrix4dToMatrix4f(mvpMats[off]);
-            mvpInvMats4f[off] = Matrix4dToMatrix4f(mvpInvMats[off]);
-            modelAndViewNormalMat4d = modelAndViewMat4d.inverse().transpose();
-            modelAndViewNormalMat = Matrix4dToMatrix4f(modelAndViewNormalMat4d);
-            const Matrix4d &thisMvpMat = mvpMats[off];
-            offFrameInfo.mvpMat = mvpMats4f[off];
-            offFrameInfo.mvpInvMat = mvpInvMats4f[off];
-            mvpNormalMat4f = Matrix4dToMatrix4f(mvpMats[off].inverse().transpose());
-            offFrameInfo.mvpNormalMat = mvpNormalMat4f;
-            offFrameInfo.viewModelNormalMat = modelAndViewNormalMat;
-            offFrameInfo.viewAndModelMat4d = modelAndViewMat4d;
-            offFrameInfo.viewAndModelMat = modelAndViewMat;
-            offFrameInfo.pvMat = Matrix4dToMatrix4f(pvMat);
-            offFrameInfo.pvMat4d = pvMat;
-
-            auto rawDrawables = scene->getDrawables();
-            drawList.reserve(rawDrawables.size());
-            for (auto *draw : rawDrawables)
-            {
-                auto *theDrawable = dynamic_cast<DrawableGLES *>(draw);
-                if (theDrawable && theDrawable->isOn(&offFrameInfo))
-                {
-                    if (const Matrix4d *localMat = theDrawable->getMatrix())
-                    {
-                        Eigen::Matrix4d newMvpMat = thisMvpMat * (*localMat);
-                        Eigen::Matrix4d newMvMat = modelAndViewMat4d * (*localMat);
-                        Eigen::Matrix4d newMvNormalMat = newMvMat.inverse().transpose();
-                        drawList.emplace_back(theDrawable,newMvpMat,newMvMat,newMvNormalMat);
-                    } else {
-                        drawList.emplace_back(theDrawable,thisMvpMat,modelAndViewMat4d,modelAndViewNormalMat4d);
-                    }
-                }
-            }
+            perfTimer.stopTiming("Draw List");
+            perfTimer.addCount("Drawables visible", (int)visibleDrawables.size());
         }
         
-        // Sort the drawables (possibly multiple of the same if we have offset matrices)
-        const bool sortLinesToEnd = (zBufferMode == zBufferOffDefault);
-        std::sort(drawList.begin(),drawList.end(),DrawListSortStruct2(sortLinesToEnd,&baseFrameInfo));
-        
         if (perfInterval > 0)
             perfTimer.startTiming("Calculation Shaders");
 
@@ -593,14 +413,8 @@ void SceneRendererGLES::render(TimeInterval duration)
                 }
                 
                 // Set up transforms to use right now
-                const Matrix4f currentMvpMat = Matrix4dToMatrix4f(drawContain.mvpMat);
-                const Matrix4f currentMvpInvMat = Matrix4dToMatrix4f(drawContain.mvpMat.inverse());
-                const Matrix4f currentMvMat = Matrix4dToMatrix4f(drawContain.mvMat);
-                const Matrix4f currentMvNormalMat = Matrix4dToMatrix4f(drawContain.mvNormalMat);
-                baseFrameInfo.mvpMat = currentMvpMat;
-                baseFrameInfo.mvpInvMat = currentMvpInvMat;
-                baseFrameInfo.viewAndModelMat = currentMvMat;
-                baseFrameInfo.viewModelNormalMat = currentMvNormalMat;
+                setDrawTransforms(baseFrameInfo,drawContain.drawable,drawContain.offset);
+                const Matrix4f &currentMvpMat = baseFrameInfo.mvpMat;
                 
                 // Figure out the program to use for drawing
                 const SimpleIdentity drawProgramId = drawContain.drawable->getProgram();
@@ -656,7 +470,6 @@ void SceneRendererGLES::render(TimeInterval duration)
             perfTimer.stopTiming("Draw Execution");
         
         // Anything generated needs to be cleaned up
-        generatedDrawables.clear();
         drawList.clear();
     }
     
@@ -0,0 +1,332 @@
+/*
+ *  SceneRendererNull.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "SceneRendererNull.h"
+#import "DrawableBuilderNull.h"
+#import "TextureNull.h"
+#import "FontTextureManager.h"
+#import "WhirlyKitLog.h"
+
+using namespace Eigen;
+
+namespace WhirlyKit
+{
+
+RenderSetupInfoNull::RenderSetupInfoNull()
+    : wideIndices(true), numBuffers(0), bufferBytes(0), numTextures(0), textureBytes(0), uploadBytes(0)
+{
+}
+
+WorkGroupNull::WorkGroupNull(GroupType inGroupType)
+{
+    groupType = inGroupType;
+
+    // For calculation we don't really have a render target
+    if (groupType == Calculation)
+        renderTargetContainers.push_back(WorkGroupNull::makeRenderTargetContainer(nullptr));
+}
+
+RenderTargetContainerRef WorkGroupNull::makeRenderTargetContainer(RenderTargetRef renderTarget)
+{
+    return std::make_shared<RenderTargetContainerNull>(renderTarget);
+}
+
+SceneNull::SceneNull(CoordSystemDisplayAdapter *adapter)
+    : Scene(adapter)
+{
+}
+
+void SceneNull::teardown(PlatformThreadInfo* threadInfo)
+{
+    for (const auto& it : drawables)
+    {
+        it.second->teardownForRenderer(setupInfo,this, nullptr);
+    }
+    drawables.clear();
+    clearDrawOrder();
+
+    for (const auto& it : textures)
+    {
+        it.second->destroyInRenderer(setupInfo,this);
+    }
+    textures.clear();
+
+    for (const auto &i : programs)
+    {
+        i.second->teardownForRenderer(setupInfo, this, nullptr);
+    }
+    programs.clear();
+
+    if (fontTextureManager)
+    {
+        fontTextureManager->teardown(threadInfo);
+    }
+}
+
+SceneRendererNull::SceneRendererNull()
+{
+    init(); // NOLINT: derived virtual methods not called
+
+    workGroups.emplace_back(std::make_shared<WorkGroupNull>(WorkGroup::Calculation));
+    workGroups.emplace_back(std::make_shared<WorkGroupNull>(WorkGroup::Offscreen));
+    workGroups.emplace_back(std::make_shared<WorkGroupNull>(WorkGroup::ReduceOps));
+    workGroups.emplace_back(std::make_shared<WorkGroupNull>(WorkGroup::ScreenRender));
+}
+
+SceneRendererNull::~SceneRendererNull() = default;
+
+SceneRenderer::Type SceneRendererNull::getType()
+{
+    return SceneRenderer::RenderNull;
+}
+
+const RenderSetupInfo *SceneRendererNull::getRenderSetupInfo() const
+{
+    return &setupInfo;
+}
+
+bool SceneRendererNull::setup(int sizeX,int sizeY,float inScale,bool wideIndices)
+{
+    frameCount = 0;
+    framesPerSec = 0.0;
+    numDrawables = 0;
+    frameCountStart = 0.0;
+    zBufferMode = zBufferOn;
+    clearColor = RGBAColor(0,0,0,0);
+    perfInterval = -1;
+    scale = inScale;
+
+    framebufferWidth = sizeX;
+    framebufferHeight = sizeY;
+
+    setupInfo.wideIndices = wideIndices;
+
+    auto defaultTarget = std::make_shared<RenderTargetNull>(EmptyIdentity);
+    defaultTarget->width = sizeX;
+    defaultTarget->height = sizeY;
+    defaultTarget->init(this,nullptr,EmptyIdentity);
+    defaultTarget->blendEnable = true;
+    defaultTarget->clearEveryFrame = true;
+    renderTargets.push_back(defaultTarget);
+
+    // Nothing special for teardown
+    teardownInfo = RenderTeardownInfoRef(new RenderTeardownInfo());
+
+    return true;
+}
+
+bool SceneRendererNull::resize(int sizeX,int sizeY)
+{
+    framebufferWidth = sizeX;
+    framebufferHeight = sizeY;
+
+    RenderTargetRef defaultTarget = renderTargets.back();
+    defaultTarget->width = sizeX;
+    defaultTarget->height = sizeY;
+
+    return true;
+}
+
+void SceneRendererNull::render(TimeInterval duration)
+{
+    if (!scene || !theView)
+        return;
+
+    WK_TRACE_SCOPE("SceneRenderer::render");
+
+    frameCount++;
+
+    theView->animate();
+
+    const TimeInterval now = scene->getCurrentTime();
+
+    lastDraw = now;
+
+    if (perfInterval > 0)
+        perfTimer.startTiming("Render Frame");
+
+    frameStats = FrameStatsNull();
+
+    RendererFrameInfo baseFrameInfo;
+    setupFrameInfo(baseFrameInfo,duration,now);
+
+    if (perfInterval > 0)
+        perfTimer.startTiming("Scene preprocessing");
+
+    // Run the preprocess for the changes.  These modify things the active models need.
+    const int numPreProcessChanges = scene->preProcessChanges(theView, this, now);
+
+    if (perfInterval > 0)
+    {
+        perfTimer.addCount("Preprocess Changes", numPreProcessChanges);
+        perfTimer.stopTiming("Scene preprocessing");
+        perfTimer.startTiming("Active Model Runs");
+    }
+
+    // Let the active models to their thing
+    auto activeModels = scene->getActiveModels();
+    for (const auto &activeModel : activeModels)
+        activeModel->updateForFrame(&baseFrameInfo);
+
+    if (perfInterval > 0)
+    {
+        perfTimer.addCount("Active Models", (int)activeModels.size());
+        perfTimer.stopTiming("Active Model Runs");
+        perfTimer.addCount("Scene changes", scene->getNumChangeRequests());
+        perfTimer.startTiming("Scene processing");
+    }
+
+    // Merge any outstanding changes into the scenegraph
+    scene->processChanges(theView,this,now);
+
+    if (perfInterval > 0)
+        perfTimer.stopTiming("Scene processing");
+
+    // Snapshot the zoom slots so the drawables don't each take the lock
+    float frameZoomSlots[MaplyMaxZoomSlots];
+    scene->copyZoomSlots(frameZoomSlots);
+    baseFrameInfo.zoomSlots = frameZoomSlots;
+
+    if (perfInterval > 0)
+        perfTimer.startTiming("Draw List");
+
+    // Same filtering, ordering and transforms as the GL renderer
+    calcOffsetTransforms(baseFrameInfo);
+    buildDrawList(&baseFrameInfo,visibleDrawables,drawList);
+    frameStats.drawablesVisible = (int)visibleDrawables.size();
+
+    if (perfInterval > 0)
+    {
+        perfTimer.stopTiming("Draw List");
+        perfTimer.addCount("Drawables visible", frameStats.drawablesVisible);
+        perfTimer.startTiming("Draw Execution");
+    }
+
+    SimpleIdentity curProgramId = EmptyIdentity;
+    Program *curProgram = nullptr;
+    for (const RenderTargetRef &renderTarget : renderTargets)
+    {
+        if (renderTarget->clearOnce)
+            renderTarget->clearOnce = false;
+
+        for (const auto &drawContain : drawList)
+        {
+            // Only draw drawables that are active for the current render target
+            if (drawContain.drawable->getRenderTarget() != renderTarget->getId())
+                continue;
+
+            // Set up transforms to use right now
+            setDrawTransforms(baseFrameInfo,drawContain.drawable,drawContain.offset);
+
+            // Figure out the program to use for drawing
+            const SimpleIdentity drawProgramId = drawContain.drawable->getProgram();
+            if (drawProgramId != curProgramId)
+            {
+                curProgramId = drawProgramId;
+                curProgram = (drawProgramId == EmptyIdentity) ? nullptr : scene->getProgram(drawProgramId);
+            }
+            if (!curProgram)
+            {
+                // The GL renderer would skip these too
+                frameStats.drawablesSkipped++;
+                continue;
+            }
+            baseFrameInfo.program = curProgram;
+
+            // Run any tweakers right here
+            drawContain.drawable->runTweakers(&baseFrameInfo);
+
+            drawContain.drawable->draw(&baseFrameInfo,scene,frameStats);
+            frameStats.drawablesDrawn++;
+        }
+    }
+
+    numDrawables = frameStats.drawablesDrawn;
+
+    if (perfInterval > 0)
+    {
+        perfTimer.addCount("Drawables drawn", frameStats.drawablesDrawn);
+        perfTimer.stopTiming("Draw Execution");
+    }
+
+    snapshotCallback(now);
+
+    if (perfInterval > 0)
+        perfTimer.stopTiming("Render Frame");
+
+    // Update the frames per sec
+    if (perfInterval > 0 && frameCount > (unsigned int)perfInterval)
+    {
+        const TimeInterval newNow = scene->getCurrentTime();
+        const TimeInterval howLong =  newNow - frameCountStart;
+        framesPerSec = (float)(frameCount / howLong);
+        frameCountStart = newNow;
+        frameCount = 0;
+
+        wkLogLevel(Verbose,"---Null Rendering Performance---");
+        wkLogLevel(Verbose," Frames per sec = %.2f",framesPerSec);
+        wkLogLevel(Verbose," Buffers = %lld (%lld bytes), Textures = %lld (%lld bytes)",
+                   (long long)setupInfo.numBuffers, (long long)setupInfo.bufferBytes,
+                   (long long)setupInfo.numTextures, (long long)setupInfo.textureBytes);
+        perfTimer.log();
+        perfTimer.clear();
+    }
+}
+
+BasicDrawableBuilderRef SceneRendererNull::makeBasicDrawableBuilder(const std::string &name) const
+{
+    return std::make_shared<BasicDrawableBuilderNull>(name,scene);
+}
+
+BasicDrawableInstanceBuilderRef SceneRendererNull::makeBasicDrawableInstanceBuilder(const std::string &name) const
+{
+    return std::make_shared<BasicDrawableInstanceBuilderNull>(name,scene);
+}
+
+BillboardDrawableBuilderRef SceneRendererNull::makeBillboardDrawableBuilder(const std::string &name) const
+{
+    return std::make_shared<BillboardDrawableBuilderNull>(name,scene);
+}
+
+ScreenSpaceDrawableBuilderRef SceneRendererNull::makeScreenSpaceDrawableBuilder(const std::string &name) const
+{
+    return std::make_shared<ScreenSpaceDrawableBuilderNull>(name,scene);
+}
+
+ParticleSystemDrawableBuilderRef SceneRendererNull::makeParticleSystemDrawableBuilder(const std::string &name) const
+{
+    return std::make_shared<ParticleSystemDrawableBuilderNull>(name,scene);
+}
+
+WideVectorDrawableBuilderRef SceneRendererNull::makeWideVectorDrawableBuilder(const std::string &name) const
+{
+    return std::make_shared<WideVectorDrawableBuilderNull>(name,this,scene);
+}
+
+RenderTargetRef SceneRendererNull::makeRenderTarget() const
+{
+    return std::make_shared<RenderTargetNull>();
+}
+
+DynamicTextureRef SceneRendererNull::makeDynamicTexture(const std::string &name) const
+{
+    return std::make_shared<DynamicTextureNull>(name);
+}
+
+}
@@ -308,8 +308,8 @@ ScreenSpaceBuilder::DrawableWrapRef ScreenSpaceBuilder::findOrAddDrawWrap(const
         drawWrap = it->second;
         
         // Make sure this one isn't too large
-        if (drawWrap && (drawWrap->locDraw->getNumPoints() + numVerts >= MaxDrawablePoints ||
-                         drawWrap->locDraw->getNumTris()   + numTris  >= MaxDrawableTriangles))
+        if (drawWrap && (drawWrap->locDraw->getNumPoints() + numVerts >= sceneRender->getMaxDrawablePoints() ||
+                         drawWrap->locDraw->getNumTris()   + numTris  >= sceneRender->getMaxDrawableTriangles()))
         {
             // It is, so we need to flush it and create a new one
             fullDrawables.push_back(drawWrap);
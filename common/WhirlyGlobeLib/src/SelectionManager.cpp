@@ -64,13 +64,204 @@ bool BillboardSelectable::operator < (const BillboardSelectable &that) const
     return selectID < that.selectID;
 }
 
+// Maximum number of objects in a leaf of the spatial index
+static const int SpatialIndexLeafSize = 8;
+// Don't bother rebuilding the index for fewer than this many changes
+static const size_t SpatialIndexMinChanges = 256;
+
+SelectionSpatialIndex::SelectionSpatialIndex()
+{
+}
+
+void SelectionSpatialIndex::addSelectable(SimpleIdentity selectID,const Point3d &ll,const Point3d &ur)
+{
+    // Replacing an existing one leaves a dead entry in the tree
+    liveIDs.erase(selectID);
+
+    Entry &entry = pending[selectID];
+    entry.ll = ll;
+    entry.ur = ur;
+    entry.selectID = selectID;
+}
+
+void SelectionSpatialIndex::addSelectable(SimpleIdentity selectID,const Point3d *pts,unsigned int numPts)
+{
+    if (numPts == 0)
+        return;
+
+    Point3d ll = pts[0], ur = pts[0];
+    for (unsigned int ii=1;ii<numPts;ii++)
+    {
+        ll = ll.cwiseMin(pts[ii]);
+        ur = ur.cwiseMax(pts[ii]);
+    }
+    addSelectable(selectID,ll,ur);
+}
+
+void SelectionSpatialIndex::removeSelectable(SimpleIdentity selectID)
+{
+    liveIDs.erase(selectID);
+    pending.erase(selectID);
+}
+
+void SelectionSpatialIndex::rebuild()
+{
+    // Keep the live entries and add the pending ones
+    std::vector<Entry> newEntries;
+    newEntries.reserve(liveIDs.size() + pending.size());
+    for (const Entry &entry : entries)
+        if (liveIDs.find(entry.selectID) != liveIDs.end())
+            newEntries.push_back(entry);
+    for (const auto &it : pending)
+    {
+        newEntries.push_back(it.second);
+        liveIDs.insert(it.first);
+    }
+    pending.clear();
+    entries.swap(newEntries);
+
+    nodes.clear();
+    if (!entries.empty())
+    {
+        nodes.reserve(2 * entries.size() / SpatialIndexLeafSize + 1);
+        buildNode(0,(int)entries.size());
+    }
+}
+
+int SelectionSpatialIndex::buildNode(int start,int count)
+{
+    const int nodeIdx = (int)nodes.size();
+    nodes.emplace_back();
+
+    // Bounds of the whole node and of the entry centers
+    Point3d ll = entries[start].ll, ur = entries[start].ur;
+    Point3d midLL = (ll + ur)/2.0, midUR = midLL;
+    for (int ii=start+1;ii<start+count;ii++)
+    {
+        const Entry &entry = entries[ii];
+        ll = ll.cwiseMin(entry.ll);
+        ur = ur.cwiseMax(entry.ur);
+        const Point3d mid = (entry.ll + entry.ur)/2.0;
+        midLL = midLL.cwiseMin(mid);
+        midUR = midUR.cwiseMax(mid);
+    }
+    nodes[nodeIdx].ll = ll;
+    nodes[nodeIdx].ur = ur;
+    nodes[nodeIdx].start = start;
+    nodes[nodeIdx].count = count;
+    nodes[nodeIdx].right = -1;
+
+    if (count <= SpatialIndexLeafSize)
+        return nodeIdx;
+
+    // Split on the median along the longest axis
+    const Point3d span = midUR - midLL;
+    const int axis = (span.x() >= span.y() && span.x() >= span.z()) ? 0 : (span.y() >= span.z() ? 1 : 2);
+    const int half = count/2;
+    std::nth_element(entries.begin()+start,entries.begin()+start+half,entries.begin()+start+count,
+                     [axis](const Entry &a,const Entry &b)
+                     {
+                         return a.ll[axis] + a.ur[axis] < b.ll[axis] + b.ur[axis];
+                     });
+
+    buildNode(start,half);
+    const int right = buildNode(start+half,count-half);
+    nodes[nodeIdx].right = right;
+
+    return nodeIdx;
+}
+
+bool SelectionSpatialIndex::boxNearTouch(const Point3d &ll,const Point3d &ur,const Point2f &touchPt,float maxDist,
+                                         const std::vector<Eigen::Matrix4d> &mats,const Point2f &frameSize) const
+{
+    for (const Eigen::Matrix4d &mat : mats)
+    {
+        Mbr screenMbr;
+        bool behindEye = false;
+        for (unsigned int ii=0;ii<8;ii++)
+        {
+            const Vector4d corner((ii & 1) ? ur.x() : ll.x(),(ii & 2) ? ur.y() : ll.y(),(ii & 4) ? ur.z() : ll.z(),1.0);
+            const Vector4d clipPt = mat * corner;
+            // Straddles the eye, so we can't bound it on the screen
+            if (clipPt.w() <= 0.0)
+            {
+                behindEye = true;
+                break;
+            }
+            const Point2f screenPt((clipPt.x()/clipPt.w() * 0.5 + 0.5) * frameSize.x(),
+                                   frameSize.y() - (clipPt.y()/clipPt.w() * 0.5 + 0.5) * frameSize.y());
+            screenMbr.addPoint(screenPt);
+        }
+        if (behindEye)
+            return true;
+
+        if (touchPt.x() >= screenMbr.ll().x() - maxDist && touchPt.x() <= screenMbr.ur().x() + maxDist &&
+            touchPt.y() >= screenMbr.ll().y() - maxDist && touchPt.y() <= screenMbr.ur().y() + maxDist)
+            return true;
+    }
+
+    return false;
+}
+
+void SelectionSpatialIndex::findCandidates(const Point2f &touchPt,float maxDist,const ViewState *viewState,
+                                           const Point2f &frameSize,std::vector<SimpleIdentity> &selectIDs)
+{
+    // Rebuild if enough has changed since last time
+    const size_t numChanges = pending.size() + (entries.size() - liveIDs.size());
+    if (numChanges > SpatialIndexMinChanges && numChanges > liveIDs.size() / 8)
+        rebuild();
+
+    // Everything goes straight to clip space
+    std::vector<Eigen::Matrix4d> mats;
+    mats.reserve(viewState->fullMatrices.size());
+    for (const Eigen::Matrix4d &fullMat : viewState->fullMatrices)
+        mats.push_back(viewState->projMatrix * fullMat);
+
+    // A little slop for the difference in projection methods
+    const float testDist = maxDist + 1.0;
+
+    if (!nodes.empty())
+    {
+        std::vector<int> stack;
+        stack.reserve(64);
+        stack.push_back(0);
+        while (!stack.empty())
+        {
+            const int nodeIdx = stack.back();
+            stack.pop_back();
+            const Node &node = nodes[nodeIdx];
+            if (!boxNearTouch(node.ll,node.ur,touchPt,testDist,mats,frameSize))
+                continue;
+
+            if (node.right < 0)
+            {
+                for (int ii=node.start;ii<node.start+node.count;ii++)
+                {
+                    const Entry &entry = entries[ii];
+                    if (liveIDs.find(entry.selectID) != liveIDs.end() &&
+                        (node.count == 1 || boxNearTouch(entry.ll,entry.ur,touchPt,testDist,mats,frameSize)))
+                        selectIDs.push_back(entry.selectID);
+                }
+            } else {
+                stack.push_back(node.right);
+                stack.push_back(nodeIdx+1);
+            }
+        }
+    }
+
+    // Recent additions
+    for (const auto &it : pending)
+        if (boxNearTouch(it.second.ll,it.second.ur,touchPt,testDist,mats,frameSize))
+            selectIDs.push_back(it.first);
+}
+
 SelectionManager::SelectedObject::SelectedObject()
 : distIn3D(0.0), screenDist(0.0), isCluster(false)
 {
 }
 
 SelectionManager::SelectionManager(Scene *scene)
-    : scene(scene)
+    : scene(scene), useSpatialIndex(true)
 {
 }
 
@@ -96,8 +287,12 @@ void SelectionManager::addSelectableRect(SimpleIdentity selectId,const Point3f *
         newSelect.pts[ii] = pts[ii];
     }
 
+    const Point3d pts3d[4] = { pts[0].cast<double>(), pts[1].cast<double>(),
+                               pts[2].cast<double>(), pts[3].cast<double>() };
+
     std::lock_guard<std::mutex> guardLock(lock);
-    rect3Dselectables.insert(newSelect);
+    if (rect3Dselectables.insert(newSelect).second)
+        rect3DIndex.addSelectable(selectId,pts3d,4);
 }
 
 // Add a rectangle (in 3-space) for selection, but only between the given visibilities
@@ -118,8 +313,12 @@ void SelectionManager::addSelectableRect(SimpleIdentity selectId,const Point3f *
         newSelect.pts[ii] = pts[ii];
     }
 
+    const Point3d pts3d[4] = { pts[0].cast<double>(), pts[1].cast<double>(),
+                               pts[2].cast<double>(), pts[3].cast<double>() };
+
     std::lock_guard<std::mutex> guardLock(lock);
-    rect3Dselectables.insert(newSelect);
+    if (rect3Dselectables.insert(newSelect).second)
+        rect3DIndex.addSelectable(selectId,pts3d,4);
 }
 
 /// Add a screen space rectangle (2D) for selection, between the given visibilities
@@ -215,9 +414,14 @@ void SelectionManager::addSelectableRectSolid(SimpleIdentity selectId,const Poin
         }
     }
     
+    Point3d pts3d[8];
+    for (unsigned int ii=0;ii<8;ii++)
+        pts3d[ii] = pts[ii].cast<double>();
+
     {
         std::lock_guard<std::mutex> guardLock(lock);
-        polytopeSelectables.insert(newSelect);
+        if (polytopeSelectables.insert(newSelect).second)
+            polytopeIndex.addSelectable(selectId,pts3d,8);
     }
 }
 
@@ -254,7 +458,8 @@ void SelectionManager::addSelectableRectSolid(SimpleIdentity selectId,const Poin
     }
     
     std::lock_guard<std::mutex> guardLock(lock);
-    polytopeSelectables.insert(newSelect);
+    if (polytopeSelectables.insert(newSelect).second)
+        polytopeIndex.addSelectable(selectId,pts,8);
 }
 
 void SelectionManager::addSelectableRectSolid(SimpleIdentity selectId,const BBox &bbox,
@@ -301,8 +506,13 @@ void SelectionManager::addPolytope(SimpleIdentity selectId,
         }
     }
     
+    BBox bbox;
+    for (const Point3dVector &surface : surfaces)
+        bbox.addPoints(surface);
+
     std::lock_guard<std::mutex> guardLock(lock);
-    polytopeSelectables.insert(newSelect);
+    if (polytopeSelectables.insert(newSelect).second && bbox.isValid())
+        polytopeIndex.addSelectable(selectId,bbox.ll(),bbox.ur());
 }
 
 void SelectionManager::addPolytopeFromBox(SimpleIdentity selectId,const Point3d &ll,const Point3d &ur,
@@ -440,7 +650,8 @@ void SelectionManager::addSelectableLinear(SimpleIdentity selectId,const Point3d
     newSelect.pts = pts;
 
     std::lock_guard<std::mutex> guardLock(lock);
-    linearSelectables.insert(newSelect);
+    if (linearSelectables.insert(newSelect).second && !pts.empty())
+        linearIndex.addSelectable(selectId,&pts[0],pts.size());
 }
 
 void SelectionManager::addSelectableBillboard(SimpleIdentity selectId,const Point3d &center,
@@ -460,8 +671,13 @@ void SelectionManager::addSelectableBillboard(SimpleIdentity selectId,const Poin
     newSelect.minVis = minVis;
     newSelect.maxVis = maxVis;
     
+    // The billboard can swing around its base to face the viewer
+    const double rad = sqrt(size.x()*size.x()/4.0 + size.y()*size.y());
+    const Point3d radPt(rad,rad,rad);
+
     std::lock_guard<std::mutex> guardLock(lock);
-    billboardSelectables.insert(newSelect);
+    if (billboardSelectables.insert(newSelect).second)
+        billboardIndex.addSelectable(selectId,center-radPt,center+radPt);
 }
 
 void SelectionManager::enableSelectable(SimpleIdentity selectID,bool enable)
@@ -639,6 +855,11 @@ void SelectionManager::removeSelectable(SimpleIdentity selectID)
     BillboardSelectableSet::iterator it4 = billboardSelectables.find(BillboardSelectable(selectID));
     if (it4 != billboardSelectables.end())
         billboardSelectables.erase(it4);
+
+    rect3DIndex.removeSelectable(selectID);
+    polytopeIndex.removeSelectable(selectID);
+    linearIndex.removeSelectable(selectID);
+    billboardIndex.removeSelectable(selectID);
 }
 
 void SelectionManager::removeSelectables(const SimpleIDSet &selectIDs)
@@ -698,6 +919,11 @@ void SelectionManager::removeSelectables(const SimpleIDSet &selectIDs)
             //found = true;
             billboardSelectables.erase(it4);
         }
+
+        rect3DIndex.removeSelectable(selectID);
+        polytopeIndex.removeSelectable(selectID);
+        linearIndex.removeSelectable(selectID);
+        billboardIndex.removeSelectable(selectID);
     }
     
 //    if (!found)
@@ -826,6 +1052,12 @@ void SelectionManager::pickObjects(Point2f touchPt,float maxDist,ViewStateRef th
     std::sort(selObjs.begin(),selObjs.end(),SelectedSorter);
 }
 
+void SelectionManager::setUseSpatialIndex(bool newVal)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    useSpatialIndex = newVal;
+}
+
 // Look for the single closest object
 SimpleIdentity SelectionManager::pickObject(Point2f touchPt,float maxDist,ViewStateRef theView)
 {
@@ -876,6 +1108,15 @@ Matrix2d SelectionManager::calcScreenRot(float &screenRot,ViewStateRef viewState
     return screenRotMat;
 }
 
+// Every object in the set, for when we're not using the spatial index
+template<typename T>
+static void AllSelectIDs(const T &selectables,std::vector<SimpleIdentity> &selectIDs)
+{
+    selectIDs.reserve(selectables.size());
+    for (const auto &sel : selectables)
+        selectIDs.push_back(sel.selectID);
+}
+
 /// Pass in the screen point where the user touched.  This returns the closest hit within the given distance
 void SelectionManager::pickObjects(Point2f touchPt,float maxDist,ViewStateRef viewState,bool multi,std::vector<SelectedObject> &selObjs)
 {
@@ -1001,13 +1242,24 @@ void SelectionManager::pickObjects(Point2f touchPt,float maxDist,ViewStateRef vi
     else
         eyePos = pInfo.mapViewState->eyePos;
 
+    // Candidates from the spatial indices, reused for each type
+    std::vector<SimpleIdentity> candIDs;
+
     if (!polytopeSelectables.empty())
     {
+        candIDs.clear();
+        if (useSpatialIndex)
+            polytopeIndex.findCandidates(touchPt,maxDist,pInfo.viewState.get(),pInfo.frameSizeScale,candIDs);
+        else
+            AllSelectIDs(polytopeSelectables,candIDs);
+
         // Work through the axis aligned rectangular solids
-        for (PolytopeSelectableSet::iterator it = polytopeSelectables.begin();
-             it != polytopeSelectables.end(); ++it)
+        for (SimpleIdentity candID : candIDs)
         {
-            PolytopeSelectable sel = *it;
+            const auto it = polytopeSelectables.find(PolytopeSelectable(candID));
+            if (it == polytopeSelectables.end())
+                continue;
+            const PolytopeSelectable &sel = *it;
             if (sel.selectID != EmptyIdentity && sel.enable)
             {
                 if (sel.minVis == DrawVisibleInvalid ||
@@ -1017,12 +1269,12 @@ void SelectionManager::pickObjects(Point2f touchPt,float maxDist,ViewStateRef vi
                     // Project each plane to the screen, including clipping
                     for (unsigned int ii=0;ii<sel.polys.size();ii++)
                     {
-                        Point3fVector &poly3f = sel.polys[ii];
+                        const Point3fVector &poly3f = sel.polys[ii];
                         Point3dVector poly;
                         poly.reserve(poly3f.size());
                         for (unsigned int jj=0;jj<poly3f.size();jj++)
                         {
-                            Point3f &pt = poly3f[jj];
+                            const Point3f &pt = poly3f[jj];
                             poly.push_back(Point3d(pt.x()+sel.centerPt.x(),pt.y()+sel.centerPt.y(),pt.z()+sel.centerPt.z()));
                         }
                         
@@ -1121,10 +1373,18 @@ void SelectionManager::pickObjects(Point2f touchPt,float maxDist,ViewStateRef vi
     
     if (!linearSelectables.empty())
     {
-        for (LinearSelectableSet::iterator it = linearSelectables.begin();
-             it != linearSelectables.end(); ++it)
+        candIDs.clear();
+        if (useSpatialIndex)
+            linearIndex.findCandidates(touchPt,maxDist,pInfo.viewState.get(),pInfo.frameSizeScale,candIDs);
+        else
+            AllSelectIDs(linearSelectables,candIDs);
+
+        for (SimpleIdentity candID : candIDs)
         {
-            LinearSelectable sel = *it;
+            const auto it = linearSelectables.find(LinearSelectable(candID));
+            if (it == linearSelectables.end())
+                continue;
+            const LinearSelectable &sel = *it;
             
             if (sel.selectID != EmptyIdentity && sel.enable)
             {
@@ -1173,11 +1433,19 @@ void SelectionManager::pickObjects(Point2f touchPt,float maxDist,ViewStateRef vi
     
     if (!rect3Dselectables.empty())
     {
+        candIDs.clear();
+        if (useSpatialIndex)
+            rect3DIndex.findCandidates(touchPt,maxDist,pInfo.viewState.get(),pInfo.frameSizeScale,candIDs);
+        else
+            AllSelectIDs(rect3Dselectables,candIDs);
+
         // Work through the 3D rectangles
-        for (RectSelectable3DSet::iterator it = rect3Dselectables.begin();
-             it != rect3Dselectables.end(); ++it)
+        for (SimpleIdentity candID : candIDs)
         {
-            RectSelectable3D sel = *it;
+            const auto it = rect3Dselectables.find(RectSelectable3D(candID));
+            if (it == rect3Dselectables.end())
+                continue;
+            const RectSelectable3D &sel = *it;
             if (sel.selectID != EmptyIdentity && sel.enable)
             {
                 if (sel.minVis == DrawVisibleInvalid ||
@@ -1237,11 +1505,19 @@ void SelectionManager::pickObjects(Point2f touchPt,float maxDist,ViewStateRef vi
     
     if (!billboardSelectables.empty())
     {
+        candIDs.clear();
+        if (useSpatialIndex)
+            billboardIndex.findCandidates(touchPt,maxDist,pInfo.viewState.get(),pInfo.frameSizeScale,candIDs);
+        else
+            AllSelectIDs(billboardSelectables,candIDs);
+
         // Work through the billboards
-        for (BillboardSelectableSet::iterator it = billboardSelectables.begin();
-             it != billboardSelectables.end(); ++it)
+        for (SimpleIdentity candID : candIDs)
         {
-            BillboardSelectable sel = *it;
+            const auto it = billboardSelectables.find(BillboardSelectable(candID));
+            if (it == billboardSelectables.end())
+                continue;
+            const BillboardSelectable &sel = *it;
             if (sel.selectID != EmptyIdentity && sel.enable)
             {
                 
@@ -1255,8 +1531,6 @@ void SelectionManager::pickObjects(Point2f touchPt,float maxDist,ViewStateRef vi
                 poly[3] = sel.size.x()/2.0 * axisX + center3d;
                 poly[2] = -sel.size.x()/2.0 * axisX + sel.size.y() * normal3d + center3d;
                 poly[1] = sel.size.x()/2.0 * axisX + sel.size.y() * normal3d + center3d;
-                
-                BillboardSelectable sel = *it;
 
                 Point2fVector screenPts;
                 ClipAndProjectPolygon(pInfo.viewState->fullMatrices[0],pInfo.viewState->projMatrix,pInfo.frameSizeScale,poly,screenPts);
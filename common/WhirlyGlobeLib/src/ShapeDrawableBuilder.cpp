@@ -76,7 +76,7 @@ void ShapeDrawableBuilder::addPoints(Point3dVector &pts,RGBAColor color,Mbr mbr,
     // Decide if we'll appending to an existing drawable or
     //  create a new one
     int ptCount = (int)(2*(pts.size()+1));
-    if (!drawable || (drawable->getNumPoints()+ptCount > MaxDrawablePoints) || (drawable->getLineWidth() != lineWidth))
+    if (!drawable || (drawable->getNumPoints()+ptCount > sceneRender->getMaxDrawablePoints()) || (drawable->getLineWidth() != lineWidth))
     {
         // We're done with it, toss it to the scene
         if (drawable)
@@ -236,8 +236,8 @@ void ShapeDrawableBuilderTri::addTriangle(Point3f p0,Point3f n0,RGBAColor c0,Poi
     Point3f center3f(center.x(),center.y(),center.z());
 
     if (!drawable ||
-        (drawable->getNumPoints()+3 > MaxDrawablePoints) ||
-        (drawable->getNumTris()+1 > MaxDrawableTriangles))
+        (drawable->getNumPoints()+3 > sceneRender->getMaxDrawablePoints()) ||
+        (drawable->getNumTris()+1 > sceneRender->getMaxDrawableTriangles()))
     {
         // We're done with it, toss it to the scene
         if (drawable)
@@ -267,8 +267,8 @@ void ShapeDrawableBuilderTri::addTriangle(Point3f p0,Point3f n0,RGBAColor c0,Poi
 void ShapeDrawableBuilderTri::addTriangle(const Point3d &p0,const Point3d &n0,RGBAColor c0,const TexCoord &tx0,const Point3d &p1,const Point3d &n1,RGBAColor c1,const TexCoord &tx1,const Point3d &p2,const Point3d &n2,RGBAColor c2,const TexCoord &tx2,Mbr shapeMbr)
 {
     if (!drawable ||
-        (drawable->getNumPoints()+3 > MaxDrawablePoints) ||
-        (drawable->getNumTris()+1 > MaxDrawableTriangles))
+        (drawable->getNumPoints()+3 > sceneRender->getMaxDrawablePoints()) ||
+        (drawable->getNumTris()+1 > sceneRender->getMaxDrawableTriangles()))
     {
         // We're done with it, toss it to the scene
         if (drawable)
@@ -301,8 +301,8 @@ void ShapeDrawableBuilderTri::addTriangle(const Point3d &p0,const Point3d &n0,RG
 void ShapeDrawableBuilderTri::addTriangle(Point3d p0,Point3d n0,RGBAColor c0,Point3d p1,Point3d n1,RGBAColor c1,Point3d p2,Point3d n2,RGBAColor c2,Mbr shapeMbr)
 {
     if (!drawable ||
-        (drawable->getNumPoints()+3 > MaxDrawablePoints) ||
-        (drawable->getNumTris()+1 > MaxDrawableTriangles))
+        (drawable->getNumPoints()+3 > sceneRender->getMaxDrawablePoints()) ||
+        (drawable->getNumTris()+1 > sceneRender->getMaxDrawableTriangles()))
     {
         // We're done with it, toss it to the scene
         if (drawable)
@@ -332,8 +332,8 @@ void ShapeDrawableBuilderTri::addTriangle(Point3d p0,Point3d n0,RGBAColor c0,Poi
 void ShapeDrawableBuilderTri::addTriangles(Point3dVector &pts,Point3dVector &norms,std::vector<RGBAColor> &colors,std::vector<BasicDrawable::Triangle> &tris)
 {
     if (!drawable ||
-        (drawable->getNumPoints()+pts.size() > MaxDrawablePoints) ||
-        (drawable->getNumTris()+tris.size() > MaxDrawableTriangles))
+        (drawable->getNumPoints()+pts.size() > sceneRender->getMaxDrawablePoints()) ||
+        (drawable->getNumTris()+tris.size() > sceneRender->getMaxDrawableTriangles()))
     {
         if (drawable)
             flush();
@@ -349,7 +349,7 @@ SimpleIdentity SphericalChunkManager::addChunks(const std::vector<SphericalChunk
         drawable->setTexId(0,texId);
         chunk.buildDrawable(renderer,drawable,chunkInfo.doEdgeMatching,skirtDraw,chunkInfo.enable,coordAdapter,chunkInfo);
 
-        if (drawable->getNumPoints() > MaxDrawablePoints || (lastTexID != -1 && lastTexID != texId)) {
+        if (drawable->getNumPoints() > getSceneRenderer()->getMaxDrawablePoints() || (lastTexID != -1 && lastTexID != texId)) {
             if (skirtDraw->getNumPoints() > 0) {
                 chunkRep->drawIDs.insert(skirtDraw->getDrawableID());
                 changes.push_back(new AddDrawableReq(skirtDraw->getDrawable()));
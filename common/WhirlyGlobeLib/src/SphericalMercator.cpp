@@ -16,6 +16,7 @@
  *  limitations under the License.
  */
 
+#import <algorithm>
 #import "SphericalMercator.h"
 #import "GlobeMath.h"
 
@@ -98,6 +99,15 @@ Point3d SphericalMercatorCoordSystem::geographicToLocal(Point2d geo) const
     return coord;    
 }
     
+void SphericalMercatorCoordSystem::geographicToLocal(const Point2d *geo,Point3d *local,size_t count) const
+{
+    for (size_t ii=0;ii<count;ii++)
+    {
+        const double lat = std::max(-PoleLimit,std::min(PoleLimit,geo[ii].y()));
+        local[ii] = Point3d(geo[ii].x() - originLon,log((1.0f+sin(lat))/cos(lat)),0.0);
+    }
+}
+    
 /// Convert from the local coordinate system to geocentric
 Point3f SphericalMercatorCoordSystem::localToGeocentric(Point3f localPt) const
 {
@@ -111,6 +121,17 @@ Point3d SphericalMercatorCoordSystem::localToGeocentric(Point3d localPt) const
     return GeoCoordSystem::LocalToGeocentric(Point3d(geoCoord.x(),geoCoord.y(),localPt.z()));
 }
     
+void SphericalMercatorCoordSystem::localToGeocentric(const Point3d *local,Point3d *geoc,size_t count) const
+{
+    // Unproject to lon/lat/height, then go to geocentric all at once
+    for (size_t ii=0;ii<count;ii++)
+    {
+        const Point3d &pt = local[ii];
+        geoc[ii] = Point3d(pt.x() + originLon,atan(sinh(pt.y())),pt.z());
+    }
+    GeoCoordSystem::LocalToGeocentric(geoc,geoc,count);
+}
+    
 /// Convert from display coordinates to geocentric
 Point3f SphericalMercatorCoordSystem::geocentricToLocal(Point3f geocPt) const
 {
@@ -126,6 +147,18 @@ Point3d SphericalMercatorCoordSystem::geocentricToLocal(Point3d geocPt) const
     return Point3d(localPt.x(),localPt.y(),geoCoordPlus.z());
 }
 
+void SphericalMercatorCoordSystem::geocentricToLocal(const Point3d *geoc,Point3d *local,size_t count) const
+{
+    GeoCoordSystem::GeocentricToLocal(geoc,local,count);
+    for (size_t ii=0;ii<count;ii++)
+    {
+        Point3d &pt = local[ii];
+        const double lat = std::max(-PoleLimit,std::min(PoleLimit,pt.y()));
+        pt.x() -= originLon;
+        pt.y() = log((1.0f+sin(lat))/cos(lat));
+    }
+}
+
 bool SphericalMercatorCoordSystem::isSameAs(CoordSystem *coordSys) const
 {
     const auto other = dynamic_cast<SphericalMercatorCoordSystem *>(coordSys);
@@ -183,6 +216,16 @@ WhirlyKit::Point3d SphericalMercatorDisplayAdapter::localToDisplay(WhirlyKit::Po
     return dispPt;
 }
     
+void SphericalMercatorDisplayAdapter::localToDisplay(const Point3d *local,Point3d *disp,size_t count) const
+{
+    const double ox = org.x(), oy = org.y();
+    for (size_t ii=0;ii<count;ii++)
+    {
+        const Point3d &pt = local[ii];
+        disp[ii] = Point3d(pt.x() - ox,pt.y() - oy,pt.z());
+    }
+}
+    
 /// Convert from display coordinates to the local system's coordinates
 WhirlyKit::Point3f SphericalMercatorDisplayAdapter::displayToLocal(WhirlyKit::Point3f dispPt) const
 {
@@ -196,4 +239,9 @@ WhirlyKit::Point3d SphericalMercatorDisplayAdapter::displayToLocal(WhirlyKit::Po
     return localPt;
 }
 
+void SphericalMercatorDisplayAdapter::normalForLocal(const Point3d *,Point3d *norms,size_t count) const
+{
+    std::fill(norms,norms+count,Point3d(0,0,1));
+}
+
 }
@@ -24,26 +24,101 @@ namespace WhirlyKit {
 
 StringIndexer StringIndexer::instance;
 
-StringIndexer::StringIndexer() : stringToIdent(500)
+StringIndexer::Table::Table(size_t size) :
+    mask(size - 1),
+    slots(new std::atomic<const Entry *>[size])
 {
+    for (size_t ii=0;ii<size;ii++)
+        slots[ii].store(nullptr,std::memory_order_relaxed);
+}
+
+const StringIndexer::Entry *StringIndexer::Table::find(std::string_view str,size_t hash) const
+{
+    for (size_t which = hash & mask;;which = (which + 1) & mask)
+    {
+        const Entry *entry = slots[which].load(std::memory_order_acquire);
+        if (!entry)
+            return nullptr;
+        if (entry->hash == hash && entry->str == str)
+            return entry;
+    }
+}
+
+void StringIndexer::Table::insert(const Entry *entry)
+{
+    size_t which = entry->hash & mask;
+    while (slots[which].load(std::memory_order_relaxed))
+        which = (which + 1) & mask;
+    slots[which].store(entry,std::memory_order_release);
+}
+
+StringIndexer::StringIndexer()
+{
+    tables.emplace_back(new Table(1024));
+    table.store(tables.back().get(),std::memory_order_release);
     identToString.reserve(500);
 }
 
-StringIdentity StringIndexer::getStringID(const std::string &str)
+const StringIndexer::Entry *StringIndexer::addString(std::string_view str,size_t hash)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Somebody may have beaten us to it
+    const Table *curTable = table.load(std::memory_order_acquire);
+    if (const Entry *entry = curTable->find(str,hash))
+        return entry;
+
+    identToString.emplace_back(new Entry(str,hash,identToString.size()));
+    const Entry *entry = identToString.back().get();
+
+    // Keep it at most half full.  Readers may still be using the old table, so it sticks around.
+    if (2*identToString.size() > curTable->mask+1)
+    {
+        std::unique_ptr<Table> newTable(new Table(2*(curTable->mask+1)));
+        for (const auto &oldEntry : identToString)
+            newTable->insert(oldEntry.get());
+        curTable = newTable.get();
+        tables.emplace_back(std::move(newTable));
+        table.store(curTable,std::memory_order_release);
+    } else {
+        const_cast<Table *>(curTable)->insert(entry);
+    }
+
+    return entry;
+}
+
+// Most recent lookups on this thread
+static constexpr unsigned int ThreadCacheSize = 64;
+
+StringIdentity StringIndexer::getStringID(std::string_view str)
 {
     StringIndexer &index = getInstance();
+    const size_t hash = std::hash<std::string_view>()(str);
 
-    // todo: upgradeable shared mutex would be perfect here
-    std::lock_guard<std::mutex> lock(index.mutex);
+    thread_local const Entry *threadCache[ThreadCacheSize] = { nullptr };
+    const Entry *&cached = threadCache[hash % ThreadCacheSize];
+    if (cached && cached->hash == hash && cached->str == str)
+        return cached->strID;
+
+    const Entry *entry = index.table.load(std::memory_order_acquire)->find(str,hash);
+    if (!entry)
+        entry = index.addString(str,hash);
+
+    cached = entry;
+    return entry->strID;
+}
+
+bool StringIndexer::findStringID(std::string_view str,StringIdentity &strID)
+{
+    const StringIndexer &index = getInstance();
+    const size_t hash = std::hash<std::string_view>()(str);
 
-    const auto it = index.stringToIdent.find(str);
-    if (it != index.stringToIdent.end())
-        return it->second;
+    const Entry *entry = index.table.load(std::memory_order_acquire)->find(str,hash);
+    if (!entry)
+        return false;
 
-    const int strID = index.identToString.size();
-    index.identToString.push_back(str);
-    index.stringToIdent[str] = strID;
-    return strID;
+    strID = entry->strID;
+    return true;
 }
 
 std::string StringIndexer::getString(StringIdentity strID)
@@ -52,7 +127,7 @@ std::string StringIndexer::getString(StringIdentity strID)
 
     std::lock_guard<std::mutex> lock(index.mutex);
 
-    return (strID < index.identToString.size()) ? index.identToString[strID] : std::string();
+    return (strID < index.identToString.size()) ? index.identToString[strID]->str : std::string();
 }
  
 // Note: This is from OpenGL.  Doesn't hold anymore on iOS
@@ -17,6 +17,7 @@
  */
 
 #import <list>
+#import <atomic>
 #import "Tesselator.h"
 #import "glues.h"
 
@@ -85,26 +86,28 @@ static void errorCallback(GLenum error,TriangulationInfo *triInfo)
 }
     
 static const float PolyScale2 = 1e6;
-    
-void TesselateRing(const WhirlyKit::VectorRing &ring,VectorTrianglesRef tris)
+
+// Add a triangle, making sure it's pointed up
+static void AddTriangle(VectorTrianglesRef tris,int a,int b,int c)
 {
-    std::vector<VectorRing> rings(1);
-    rings[0] = ring;
-    TesselateLoops(rings, tris);
+    VectorTriangles::Triangle triOut;
+    triOut.pts[0] = a;  triOut.pts[1] = b;  triOut.pts[2] = c;
+
+    const Point3f &pt0 = tris->pts[a], &pt1 = tris->pts[b], &pt2 = tris->pts[c];
+    Vector3f norm = (pt1-pt0).cross(pt2-pt0);
+    if (norm.z() >= 0.0)
+        std::swap(triOut.pts[0],triOut.pts[2]);
+
+    tris->tris.push_back(triOut);
 }
-    
-void TesselateLoops(const std::vector<VectorRing> &loops,VectorTrianglesRef tris)
+
+static void TesselateLoopsGLU(const VectorRing *loops,unsigned int numLoops,VectorTrianglesRef tris)
 {
-    if (loops.size() < 1)
-        return;
-    if (loops[0].size() < 1)
-        return;
-    
     GLUtesselator *tess = gluNewTess();
     
     TriangulationInfo tessInfo;
     int totPoints = 0;
-    for (unsigned int ii=0;ii<loops.size();ii++)
+    for (unsigned int ii=0;ii<numLoops;ii++)
         totPoints += loops[ii].size();
     tessInfo.pts.reserve(totPoints);
     tessInfo.newVert = false;
@@ -118,7 +121,7 @@ void TesselateLoops(const std::vector<VectorRing> &loops,VectorTrianglesRef tris
     gluTessBeginPolygon(tess,&tessInfo);
     
     Point2f org = (loops[0])[0];
-    for (unsigned int li=0;li<loops.size();li++)
+    for (unsigned int li=0;li<numLoops;li++)
     {
         gluTessBeginContour(tess);
         const VectorRing &ring = loops[li];
@@ -164,28 +167,855 @@ void TesselateLoops(const std::vector<VectorRing> &loops,VectorTrianglesRef tris
     {
         std::vector<int> &tri = tessInfo.tris[ii];
         if (tri.size() == 3)
+            AddTriangle(tris,tri[0]+startPoint,tri[1]+startPoint,tri[2]+startPoint);
+    }
+}
+
+struct EarcutTesselator::Node
+{
+    unsigned int i;
+    double x,y;
+    // Ring order
+    Node *prev,*next;
+    // Z-order curve value and order
+    int32_t z;
+    Node *prevZ,*nextZ;
+    // Holes that have been collapsed to a single point
+    bool steiner;
+};
+
+static const unsigned int EarcutBlockSize = 512;
+
+EarcutTesselator::EarcutTesselator()
+: coords(nullptr), numVerts(0), tris(nullptr), nodesUsed(0), hashing(false), minX(0.0), minY(0.0), invSize(0.0)
+{
+}
+
+EarcutTesselator::~EarcutTesselator()
+{
+    for (Node *block : blocks)
+        delete [] block;
+}
+
+EarcutTesselator::Node *EarcutTesselator::newNode(unsigned int i,double x,double y)
+{
+    const unsigned int which = nodesUsed / EarcutBlockSize;
+    if (which >= blocks.size())
+        blocks.push_back(new Node[EarcutBlockSize]);
+    Node *node = &blocks[which][nodesUsed % EarcutBlockSize];
+    nodesUsed++;
+
+    node->i = i;
+    node->x = x;  node->y = y;
+    node->prev = node->next = nullptr;
+    node->z = 0;
+    node->prevZ = node->nextZ = nullptr;
+    node->steiner = false;
+
+    return node;
+}
+
+// Signed area of a triangle
+static inline double EarArea(const EarcutTesselator::Node *p,const EarcutTesselator::Node *q,const EarcutTesselator::Node *r)
+{
+    return (q->y - p->y) * (r->x - q->x) - (q->x - p->x) * (r->y - q->y);
+}
+
+static inline bool EarEquals(const EarcutTesselator::Node *p1,const EarcutTesselator::Node *p2)
+{
+    return p1->x == p2->x && p1->y == p2->y;
+}
+
+static inline bool PointInTriangle(double ax,double ay,double bx,double by,double cx,double cy,double px,double py)
+{
+    return (cx - px) * (ay - py) >= (ax - px) * (cy - py) &&
+           (ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+           (bx - px) * (cy - py) >= (cx - px) * (by - py);
+}
+
+static inline int Sign(double val)
+{
+    return (0.0 < val) - (val < 0.0);
+}
+
+// For collinear p, q, r: is q on segment pr
+static inline bool OnSegment(double px,double py,double qx,double qy,double rx,double ry)
+{
+    return qx <= std::max(px, rx) && qx >= std::min(px, rx) && qy <= std::max(py, ry) && qy >= std::min(py, ry);
+}
+
+// Do segments p1q1 and p2q2 touch or cross
+static bool SegmentsIntersect(double p1x,double p1y,double q1x,double q1y,double p2x,double p2y,double q2x,double q2y)
+{
+    const int o1 = Sign((q1y - p1y) * (p2x - q1x) - (q1x - p1x) * (p2y - q1y));
+    const int o2 = Sign((q1y - p1y) * (q2x - q1x) - (q1x - p1x) * (q2y - q1y));
+    const int o3 = Sign((q2y - p2y) * (p1x - q2x) - (q2x - p2x) * (p1y - q2y));
+    const int o4 = Sign((q2y - p2y) * (q1x - q2x) - (q2x - p2x) * (q1y - q2y));
+
+    if (o1 != o2 && o3 != o4)
+        return true;
+    if (o1 == 0 && OnSegment(p1x, p1y, p2x, p2y, q1x, q1y))
+        return true;
+    if (o2 == 0 && OnSegment(p1x, p1y, q2x, q2y, q1x, q1y))
+        return true;
+    if (o3 == 0 && OnSegment(p2x, p2y, p1x, p1y, q2x, q2y))
+        return true;
+    if (o4 == 0 && OnSegment(p2x, p2y, q1x, q1y, q2x, q2y))
+        return true;
+
+    return false;
+}
+
+static inline bool NodesIntersect(const EarcutTesselator::Node *p1,const EarcutTesselator::Node *q1,const EarcutTesselator::Node *p2,const EarcutTesselator::Node *q2)
+{
+    return SegmentsIntersect(p1->x, p1->y, q1->x, q1->y, p2->x, p2->y, q2->x, q2->y);
+}
+
+// Does the diagonal ab cross any of the polygon's edges
+static bool IntersectsPolygon(const EarcutTesselator::Node *a,const EarcutTesselator::Node *b)
+{
+    const EarcutTesselator::Node *p = a;
+    do {
+        if (p->i != a->i && p->next->i != a->i && p->i != b->i && p->next->i != b->i &&
+            NodesIntersect(p, p->next, a, b))
+            return true;
+        p = p->next;
+    } while (p != a);
+
+    return false;
+}
+
+// Is the diagonal ab inside the polygon near a
+static inline bool LocallyInside(const EarcutTesselator::Node *a,const EarcutTesselator::Node *b)
+{
+    return EarArea(a->prev, a, a->next) < 0 ?
+        EarArea(a, b, a->next) >= 0 && EarArea(a, a->prev, b) >= 0 :
+        EarArea(a, b, a->prev) < 0 || EarArea(a, a->next, b) < 0;
+}
+
+// Is the middle of the diagonal ab inside the polygon
+static bool MiddleInside(const EarcutTesselator::Node *a,const EarcutTesselator::Node *b)
+{
+    const EarcutTesselator::Node *p = a;
+    bool inside = false;
+    const double px = (a->x + b->x) / 2, py = (a->y + b->y) / 2;
+    do {
+        if (((p->y > py) != (p->next->y > py)) && p->next->y != p->y &&
+            (px < (p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x))
+            inside = !inside;
+        p = p->next;
+    } while (p != a);
+
+    return inside;
+}
+
+// Can we split the polygon along ab
+static bool IsValidDiagonal(const EarcutTesselator::Node *a,const EarcutTesselator::Node *b)
+{
+    return a->next->i != b->i && a->prev->i != b->i && !IntersectsPolygon(a, b) &&
+        ((LocallyInside(a, b) && LocallyInside(b, a) && MiddleInside(a, b) &&
+          (EarArea(a->prev, a, b->prev) != 0.0 || EarArea(a, b->prev, b) != 0.0)) ||
+         (EarEquals(a, b) && EarArea(a->prev, a, a->next) > 0 && EarArea(b->prev, b, b->next) > 0));
+}
+
+static inline void RemoveNode(EarcutTesselator::Node *p)
+{
+    p->next->prev = p->prev;
+    p->prev->next = p->next;
+    if (p->prevZ)
+        p->prevZ->nextZ = p->nextZ;
+    if (p->nextZ)
+        p->nextZ->prevZ = p->prevZ;
+}
+
+// Sort the nodes along the z-order curve.  Merge sort on the linked list.
+static EarcutTesselator::Node *SortLinked(EarcutTesselator::Node *list)
+{
+    typedef EarcutTesselator::Node Node;
+    int inSize = 1, numMerges;
+    do {
+        Node *p = list, *tail = nullptr;
+        list = nullptr;
+        numMerges = 0;
+
+        while (p)
         {
-            VectorTriangles::Triangle triOut;
-            for (unsigned int jj=0;jj<3;jj++)
+            numMerges++;
+            Node *q = p;
+            int pSize = 0;
+            for (int ii=0;ii<inSize;ii++)
             {
-                triOut.pts[jj] = tri[jj]+startPoint;
+                pSize++;
+                q = q->nextZ;
+                if (!q)
+                    break;
             }
-            
-            // Make sure this is pointed up
-            Point3f pts[3];
-            for (unsigned int jj=0;jj<3;jj++)
-                pts[jj] = tris->pts[triOut.pts[jj]];
-            Vector3f norm = (pts[1]-pts[0]).cross(pts[2]-pts[0]);
-            if (norm.z() >= 0.0)
+            int qSize = inSize;
+
+            while (pSize > 0 || (qSize > 0 && q))
             {
-                int tmp = triOut.pts[0];
-                triOut.pts[0] = triOut.pts[2];
-                triOut.pts[2] = tmp;
+                Node *e;
+                if (pSize != 0 && (qSize == 0 || !q || p->z <= q->z))
+                {
+                    e = p;
+                    p = p->nextZ;
+                    pSize--;
+                } else {
+                    e = q;
+                    q = q->nextZ;
+                    qSize--;
+                }
+
+                if (tail)
+                    tail->nextZ = e;
+                else
+                    list = e;
+                e->prevZ = tail;
+                tail = e;
             }
-            
-            tris->tris.push_back(triOut);
+
+            p = q;
+        }
+
+        tail->nextZ = nullptr;
+        inSize *= 2;
+    } while (numMerges > 1);
+
+    return list;
+}
+
+int32_t EarcutTesselator::zOrder(double px,double py) const
+{
+    // Coordinates scaled to 15 bits and interleaved
+    int32_t x = (int32_t)((px - minX) * invSize);
+    int32_t y = (int32_t)((py - minY) * invSize);
+
+    x = (x | (x << 8)) & 0x00FF00FF;
+    x = (x | (x << 4)) & 0x0F0F0F0F;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+
+    y = (y | (y << 8)) & 0x00FF00FF;
+    y = (y | (y << 4)) & 0x0F0F0F0F;
+    y = (y | (y << 2)) & 0x33333333;
+    y = (y | (y << 1)) & 0x55555555;
+
+    return x | (y << 1);
+}
+
+EarcutTesselator::Node *EarcutTesselator::linkedList(unsigned int start,unsigned int end,bool clockwise)
+{
+    double sum = 0.0;
+    for (unsigned int ii = start, jj = end - 1; ii < end; jj = ii++)
+        sum += (coords[2*jj] - coords[2*ii]) * (coords[2*ii+1] + coords[2*jj+1]);
+
+    // Link up the points in the winding order we want
+    Node *last = nullptr;
+    auto insertNode = [this,&last](unsigned int ii)
+    {
+        Node *p = newNode(ii, coords[2*ii], coords[2*ii+1]);
+        if (!last)
+        {
+            p->prev = p;
+            p->next = p;
+        } else {
+            p->next = last->next;
+            p->prev = last;
+            last->next->prev = p;
+            last->next = p;
+        }
+        last = p;
+    };
+    if (clockwise == (sum > 0))
+    {
+        for (unsigned int ii = start; ii < end; ii++)
+            insertNode(ii);
+    } else {
+        for (unsigned int ii = end; ii-- > start; )
+            insertNode(ii);
+    }
+
+    if (last && EarEquals(last, last->next))
+    {
+        RemoveNode(last);
+        last = last->next;
+    }
+
+    return last;
+}
+
+// Get rid of duplicate and collinear points
+EarcutTesselator::Node *EarcutTesselator::filterPoints(Node *start,Node *end)
+{
+    if (!start)
+        return start;
+    if (!end)
+        end = start;
+
+    Node *p = start;
+    bool again;
+    do {
+        again = false;
+
+        if (!p->steiner && (EarEquals(p, p->next) || EarArea(p->prev, p, p->next) == 0))
+        {
+            RemoveNode(p);
+            p = end = p->prev;
+            if (p == p->next)
+                break;
+            again = true;
+        } else
+            p = p->next;
+    } while (again || p != end);
+
+    return end;
+}
+
+void EarcutTesselator::earcutLinked(Node *ear,int pass)
+{
+    if (!ear)
+        return;
+
+    if (!pass && hashing)
+        indexCurve(ear);
+
+    Node *stop = ear;
+
+    // Clip off ears until we're down to one triangle
+    while (ear->prev != ear->next)
+    {
+        Node *prev = ear->prev;
+        Node *next = ear->next;
+
+        if (hashing ? isEarHashed(ear) : isEar(ear))
+        {
+            tris->push_back(prev->i);
+            tris->push_back(ear->i);
+            tris->push_back(next->i);
+
+            RemoveNode(ear);
+
+            // Skipping the next vertex leads to fewer sliver triangles
+            ear = next->next;
+            stop = next->next;
+
+            continue;
+        }
+
+        ear = next;
+
+        // Made it all the way around without finding an ear
+        if (ear == stop)
+        {
+            if (!pass)
+                // Try again after cleaning up the points
+                earcutLinked(filterPoints(ear), 1);
+            else if (pass == 1)
+            {
+                // Then after fixing small self intersections
+                ear = cureLocalIntersections(filterPoints(ear));
+                earcutLinked(ear, 2);
+            } else if (pass == 2)
+                // As a last resort, split it in two
+                splitEarcut(ear);
+
+            break;
         }
     }
 }
 
+bool EarcutTesselator::isEar(Node *ear)
+{
+    const Node *a = ear->prev, *b = ear, *c = ear->next;
+
+    // Reflex, can't be an ear
+    if (EarArea(a, b, c) >= 0)
+        return false;
+
+    // Nothing else can be inside it
+    const double minTX = std::min(a->x, std::min(b->x, c->x)), minTY = std::min(a->y, std::min(b->y, c->y));
+    const double maxTX = std::max(a->x, std::max(b->x, c->x)), maxTY = std::max(a->y, std::max(b->y, c->y));
+    for (const Node *p = c->next; p != a; p = p->next)
+    {
+        if (p->x >= minTX && p->x <= maxTX && p->y >= minTY && p->y <= maxTY &&
+            PointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+            EarArea(p->prev, p, p->next) >= 0)
+            return false;
+    }
+
+    return true;
+}
+
+bool EarcutTesselator::isEarHashed(Node *ear)
+{
+    const Node *a = ear->prev, *b = ear, *c = ear->next;
+
+    if (EarArea(a, b, c) >= 0)
+        return false;
+
+    // Only look at points in the triangle's z-order range
+    const double minTX = std::min(a->x, std::min(b->x, c->x)), minTY = std::min(a->y, std::min(b->y, c->y));
+    const double maxTX = std::max(a->x, std::max(b->x, c->x)), maxTY = std::max(a->y, std::max(b->y, c->y));
+    const int32_t minZ = zOrder(minTX, minTY);
+    const int32_t maxZ = zOrder(maxTX, maxTY);
+
+    auto inside = [a,b,c,ear](const Node *p)
+    {
+        return p != ear->prev && p != ear->next &&
+            PointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+            EarArea(p->prev, p, p->next) >= 0;
+    };
+
+    // Look in both directions
+    const Node *p = ear->prevZ, *n = ear->nextZ;
+    while (p && p->z >= minZ && n && n->z <= maxZ)
+    {
+        if (inside(p))
+            return false;
+        p = p->prevZ;
+
+        if (inside(n))
+            return false;
+        n = n->nextZ;
+    }
+    for (; p && p->z >= minZ; p = p->prevZ)
+        if (inside(p))
+            return false;
+    for (; n && n->z <= maxZ; n = n->nextZ)
+        if (inside(n))
+            return false;
+
+    return true;
+}
+
+EarcutTesselator::Node *EarcutTesselator::cureLocalIntersections(Node *start)
+{
+    Node *p = start;
+    do {
+        Node *a = p->prev, *b = p->next->next;
+
+        // A local self intersection, a-p-p.next-b.  Turn it into a triangle.
+        if (!EarEquals(a, b) && NodesIntersect(a, p, p->next, b) && LocallyInside(a, b) && LocallyInside(b, a))
+        {
+            tris->push_back(a->i);
+            tris->push_back(p->i);
+            tris->push_back(b->i);
+
+            RemoveNode(p);
+            RemoveNode(p->next);
+
+            p = start = b;
+        }
+        p = p->next;
+    } while (p != start);
+
+    return filterPoints(p);
+}
+
+void EarcutTesselator::splitEarcut(Node *start)
+{
+    // Look for a diagonal that splits the polygon in two
+    Node *a = start;
+    do {
+        Node *b = a->next->next;
+        while (b != a->prev)
+        {
+            if (a->i != b->i && IsValidDiagonal(a, b))
+            {
+                Node *c = splitPolygon(a, b);
+
+                a = filterPoints(a, a->next);
+                c = filterPoints(c, c->next);
+
+                earcutLinked(a);
+                earcutLinked(c);
+                return;
+            }
+            b = b->next;
+        }
+        a = a->next;
+    } while (a != start);
+}
+
+EarcutTesselator::Node *EarcutTesselator::eliminateHoles(const std::vector<unsigned int> &holeStarts,Node *outerNode)
+{
+    holeQueue.clear();
+    for (unsigned int ii=0;ii<holeStarts.size();ii++)
+    {
+        const unsigned int start = holeStarts[ii];
+        const unsigned int end = ii+1 < holeStarts.size() ? holeStarts[ii+1] : numVerts;
+        Node *list = linkedList(start, end, false);
+        if (list)
+        {
+            if (list == list->next)
+                list->steiner = true;
+
+            // Leftmost point of the hole
+            Node *p = list, *leftmost = list;
+            do {
+                if (p->x < leftmost->x || (p->x == leftmost->x && p->y < leftmost->y))
+                    leftmost = p;
+                p = p->next;
+            } while (p != list);
+            holeQueue.push_back(leftmost);
+        }
+    }
+    std::sort(holeQueue.begin(), holeQueue.end(),
+              [](const Node *a,const Node *b) { return a->x < b->x; });
+
+    // Bridge the holes to the outer ring from left to right
+    for (Node *hole : holeQueue)
+        outerNode = eliminateHole(hole, outerNode);
+
+    return outerNode;
+}
+
+EarcutTesselator::Node *EarcutTesselator::eliminateHole(Node *hole,Node *outerNode)
+{
+    Node *bridge = findHoleBridge(hole, outerNode);
+    if (!bridge)
+        return outerNode;
+
+    Node *bridgeReverse = splitPolygon(bridge, hole);
+
+    // Filter the collinear points around the cuts
+    filterPoints(bridgeReverse, bridgeReverse->next);
+    return filterPoints(bridge, bridge->next);
+}
+
+// David Eberly's algorithm for finding a bridge between a hole and the outer polygon
+EarcutTesselator::Node *EarcutTesselator::findHoleBridge(Node *hole,Node *outerNode)
+{
+    Node *p = outerNode;
+    const double hx = hole->x, hy = hole->y;
+    double qx = -std::numeric_limits<double>::infinity();
+    Node *m = nullptr;
+
+    // Find the segment intersected by a ray from the hole's leftmost point to the left.
+    // The segment's endpoint with the lesser x will be a potential connection point.
+    do {
+        if (hy <= p->y && hy >= p->next->y && p->next->y != p->y)
+        {
+            const double x = p->x + (hy - p->y) * (p->next->x - p->x) / (p->next->y - p->y);
+            if (x <= hx && x > qx)
+            {
+                qx = x;
+                m = p->x < p->next->x ? p : p->next;
+                if (x == hx)
+                    // The hole touches the outer segment
+                    return m;
+            }
+        }
+        p = p->next;
+    } while (p != outerNode);
+
+    if (!m)
+        return nullptr;
+
+    // Look for points inside the triangle of the hole point, the segment intersection and the endpoint.
+    // If there are any, the one with the smallest angle to the ray is the connection point.
+    const Node *stop = m;
+    const double mx = m->x, my = m->y;
+    double tanMin = std::numeric_limits<double>::infinity();
+
+    p = m;
+    do {
+        if (hx >= p->x && p->x >= mx && hx != p->x &&
+            PointInTriangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y))
+        {
+            const double tanCur = std::abs(hy - p->y) / (hx - p->x);
+
+            if (LocallyInside(p, hole) &&
+                (tanCur < tanMin || (tanCur == tanMin && (p->x > m->x ||
+                    (p->x == m->x && EarArea(m->prev, m, p->prev) < 0 && EarArea(p->next, m, m->next) < 0)))))
+            {
+                m = p;
+                tanMin = tanCur;
+            }
+        }
+
+        p = p->next;
+    } while (p != stop);
+
+    return m;
+}
+
+// Link a and b with a bridge, splitting the polygon in two.
+// The second one is returned.
+EarcutTesselator::Node *EarcutTesselator::splitPolygon(Node *a,Node *b)
+{
+    Node *a2 = newNode(a->i, a->x, a->y);
+    Node *b2 = newNode(b->i, b->x, b->y);
+    Node *an = a->next;
+    Node *bp = b->prev;
+
+    a->next = b;
+    b->prev = a;
+
+    a2->next = an;
+    an->prev = a2;
+
+    b2->next = a2;
+    a2->prev = b2;
+
+    bp->next = b2;
+    b2->prev = bp;
+
+    return b2;
+}
+
+void EarcutTesselator::indexCurve(Node *start)
+{
+    Node *p = start;
+    do {
+        if (p->z == 0)
+            p->z = zOrder(p->x, p->y);
+        p->prevZ = p->prev;
+        p->nextZ = p->next;
+        p = p->next;
+    } while (p != start);
+
+    p->prevZ->nextZ = nullptr;
+    p->prevZ = nullptr;
+
+    SortLinked(p);
+}
+
+void EarcutTesselator::tesselate(const double *inCoords,unsigned int inNumVerts,
+                                 const std::vector<unsigned int> &holeStarts,
+                                 std::vector<unsigned int> &outTris)
+{
+    coords = inCoords;
+    numVerts = inNumVerts;
+    tris = &outTris;
+    nodesUsed = 0;
+    hashing = false;
+
+    if (numVerts < 3)
+        return;
+
+    const unsigned int outerEnd = holeStarts.empty() ? numVerts : holeStarts[0];
+    Node *outerNode = linkedList(0, outerEnd, true);
+    if (!outerNode || outerNode->next == outerNode->prev)
+        return;
+
+    if (!holeStarts.empty())
+        outerNode = eliminateHoles(holeStarts, outerNode);
+
+    // Z-order hashing only pays off for bigger polygons
+    if (numVerts > 80)
+    {
+        hashing = true;
+        minX = coords[0];  minY = coords[1];
+        double maxX = minX, maxY = minY;
+        for (unsigned int ii=1;ii<outerEnd;ii++)
+        {
+            minX = std::min(minX, coords[2*ii]);  maxX = std::max(maxX, coords[2*ii]);
+            minY = std::min(minY, coords[2*ii+1]);  maxY = std::max(maxY, coords[2*ii+1]);
+        }
+        // Scale to 15 bits
+        invSize = std::max(maxX - minX, maxY - minY);
+        invSize = invSize != 0.0 ? 32767.0 / invSize : 0.0;
+    }
+
+    earcutLinked(outerNode);
+
+    tris = nullptr;
+    coords = nullptr;
+}
+
+static std::atomic<TesselatorType> tesselatorType(TesselatorEarcut);
+
+void SetTesselatorType(TesselatorType type)
+{
+    tesselatorType = type;
+}
+
+TesselatorType GetTesselatorType()
+{
+    return tesselatorType;
+}
+
+// Scratch memory for the ear clipping path, kept per thread
+class EarcutScratch
+{
+public:
+    // An edge of one of the rings, for the self intersection check
+    typedef struct
+    {
+        double minX,maxX,minY,maxY;
+        unsigned int a,b;
+    } Edge;
+
+    EarcutTesselator tess;
+    std::vector<double> coords;
+    std::vector<unsigned int> ringStarts,holeStarts,tris;
+    std::vector<Edge> edges;
+    std::vector<unsigned int> active;
+};
+static thread_local EarcutScratch earcutScratch;
+
+// Look for edges that touch or cross, other than neighbors.
+// Sweeps from left to right, only comparing edges that overlap in x.
+static bool RingsIntersect(EarcutScratch &scratch,unsigned int numVerts)
+{
+    const double *coords = scratch.coords.data();
+    auto &edges = scratch.edges;
+    auto &active = scratch.active;
+
+    edges.clear();
+    for (unsigned int ri=0;ri<scratch.ringStarts.size();ri++)
+    {
+        const unsigned int start = scratch.ringStarts[ri];
+        const unsigned int end = ri+1 < scratch.ringStarts.size() ? scratch.ringStarts[ri+1] : numVerts;
+        for (unsigned int ii=start;ii<end;ii++)
+        {
+            const unsigned int jj = ii+1 == end ? start : ii+1;
+            edges.push_back({std::min(coords[2*ii],coords[2*jj]),std::max(coords[2*ii],coords[2*jj]),
+                             std::min(coords[2*ii+1],coords[2*jj+1]),std::max(coords[2*ii+1],coords[2*jj+1]),ii,jj});
+        }
+    }
+    std::sort(edges.begin(), edges.end(), [](const EarcutScratch::Edge &a,const EarcutScratch::Edge &b) { return a.minX < b.minX; });
+
+    active.clear();
+    for (unsigned int ei=0;ei<edges.size();ei++)
+    {
+        const auto &edge = edges[ei];
+
+        // Drop the edges we've passed
+        for (unsigned int ai=0;ai<active.size();)
+        {
+            if (edges[active[ai]].maxX < edge.minX)
+            {
+                active[ai] = active.back();
+                active.pop_back();
+            } else
+                ai++;
+        }
+
+        for (const unsigned int ai : active)
+        {
+            const auto &other = edges[ai];
+            if (other.minY > edge.maxY || other.maxY < edge.minY ||
+                other.a == edge.a || other.a == edge.b || other.b == edge.a || other.b == edge.b)
+                continue;
+            if (SegmentsIntersect(coords[2*edge.a],coords[2*edge.a+1],coords[2*edge.b],coords[2*edge.b+1],
+                                  coords[2*other.a],coords[2*other.a+1],coords[2*other.b],coords[2*other.b+1]))
+                return true;
+        }
+        active.push_back(ei);
+    }
+
+    return false;
+}
+
+// Area of a ring in the flat coordinates
+static double RingArea(const double *coords,unsigned int start,unsigned int end)
+{
+    double sum = 0.0;
+    for (unsigned int ii = start, jj = end - 1; ii < end; jj = ii++)
+        sum += (coords[2*jj] - coords[2*ii]) * (coords[2*ii+1] + coords[2*jj+1]);
+    return std::abs(sum) / 2.0;
+}
+
+// Returns false if the polygon needs to go to GLU instead
+static bool TesselateLoopsEarcut(const VectorRing *loops,unsigned int numLoops,VectorTrianglesRef tris)
+{
+    EarcutScratch &scratch = earcutScratch;
+    scratch.coords.clear();
+    scratch.ringStarts.clear();
+    scratch.holeStarts.clear();
+    scratch.tris.clear();
+
+    // Flatten the rings, skipping duplicates the same way we do for GLU
+    const Point2f org = loops[0][0];
+    for (unsigned int li=0;li<numLoops;li++)
+    {
+        const VectorRing &ring = loops[li];
+        const size_t ringStart = scratch.coords.size();
+        for (unsigned int ii=0;ii<ring.size();ii++)
+        {
+            const Point2f &pt = ring[ii];
+            if (ii==ring.size()-1 && pt.x() == ring[0].x() && pt.y() == ring[0].y())
+                continue;
+            if (ii > 0)
+            {
+                const Point2f &prevPt = ring[ii-1];
+                if (pt.x() == prevPt.x() && pt.y() == prevPt.y())
+                    continue;
+            }
+            scratch.coords.push_back((double)pt.x() - org.x());
+            scratch.coords.push_back((double)pt.y() - org.y());
+        }
+
+        // Degenerate holes don't do anything, but GLU can sort out a degenerate outer ring
+        if (scratch.coords.size() - ringStart < 6)
+        {
+            if (li == 0)
+                return false;
+            scratch.coords.resize(ringStart);
+            continue;
+        }
+        scratch.ringStarts.push_back(ringStart / 2);
+        if (li > 0)
+            scratch.holeStarts.push_back(ringStart / 2);
+    }
+    const unsigned int numVerts = scratch.coords.size() / 2;
+    const double *coords = scratch.coords.data();
+
+    if (RingsIntersect(scratch, numVerts))
+        return false;
+
+    scratch.tess.tesselate(coords, numVerts, scratch.holeStarts, scratch.tris);
+
+    // The triangles should cover the polygon exactly.  If not, let GLU sort it out.
+    double polyArea = 0.0;
+    for (unsigned int ri=0;ri<scratch.ringStarts.size();ri++)
+    {
+        const double area = RingArea(coords, scratch.ringStarts[ri], ri+1 < scratch.ringStarts.size() ? scratch.ringStarts[ri+1] : numVerts);
+        polyArea += ri == 0 ? area : -area;
+    }
+    double triArea = 0.0;
+    for (unsigned int ii=0;ii+2<scratch.tris.size();ii+=3)
+    {
+        const double *a = &coords[2*scratch.tris[ii]], *b = &coords[2*scratch.tris[ii+1]], *c = &coords[2*scratch.tris[ii+2]];
+        triArea += std::abs((a[0] - c[0]) * (b[1] - a[1]) - (a[0] - b[0]) * (c[1] - a[1])) / 2.0;
+    }
+    if (std::abs(polyArea - triArea) > 1e-6 * std::abs(polyArea))
+        return false;
+
+    const int startPoint = (int)(tris->pts.size());
+    tris->pts.reserve(tris->pts.size() + numVerts);
+    for (unsigned int ii=0;ii<numVerts;ii++)
+        tris->pts.push_back(Point3f(coords[2*ii]+org.x(),coords[2*ii+1]+org.y(),0.0));
+    tris->tris.reserve(tris->tris.size() + scratch.tris.size() / 3);
+    for (unsigned int ii=0;ii+2<scratch.tris.size();ii+=3)
+        AddTriangle(tris,scratch.tris[ii]+startPoint,scratch.tris[ii+1]+startPoint,scratch.tris[ii+2]+startPoint);
+
+    return true;
+}
+
+static void TesselateLoops(const VectorRing *loops,unsigned int numLoops,VectorTrianglesRef tris)
+{
+    if (numLoops < 1)
+        return;
+    if (loops[0].size() < 1)
+        return;
+
+    if (tesselatorType == TesselatorEarcut && TesselateLoopsEarcut(loops, numLoops, tris))
+        return;
+
+    TesselateLoopsGLU(loops, numLoops, tris);
+}
+
+void TesselateRing(const WhirlyKit::VectorRing &ring,VectorTrianglesRef tris)
+{
+    TesselateLoops(&ring, 1, tris);
+}
+
+void TesselateLoops(const std::vector<VectorRing> &loops,VectorTrianglesRef tris)
+{
+    TesselateLoops(loops.data(), loops.size(), tris);
+}
+
 }
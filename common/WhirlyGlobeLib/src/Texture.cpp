@@ -21,6 +21,12 @@
 #import "Texture.h"
 #import "WhirlyKitLog.h"
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#import <arm_neon.h>
+#elif defined(__SSE2__)
+#import <emmintrin.h>
+#endif
+
 using namespace WhirlyKit;
 using namespace Eigen;
 
@@ -33,23 +39,123 @@ using namespace Eigen;
 namespace WhirlyKit
 {
 
+// Pixel operations that work on a single pixel or, where we've got SIMD, four at a time
+static inline uint32_t PixAnd(uint32_t p,uint32_t mask) { return p & mask; }
+static inline uint32_t PixOr(uint32_t a,uint32_t b) { return a | b; }
+template<int N> static inline uint32_t PixShl(uint32_t p) { return p << N; }
+template<int N> static inline uint32_t PixShr(uint32_t p) { return p >> N; }
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define WK_PIXEL_SIMD 1
+typedef uint32x4_t Pix4;
+static inline Pix4 PixLoad4(const uint32_t *in) { return vld1q_u32(in); }
+static inline Pix4 PixAnd(Pix4 p,uint32_t mask) { return vandq_u32(p,vdupq_n_u32(mask)); }
+static inline Pix4 PixOr(Pix4 a,Pix4 b) { return vorrq_u32(a,b); }
+template<int N> static inline Pix4 PixShl(Pix4 p) { return vshlq_n_u32(p,N); }
+template<int N> static inline Pix4 PixShr(Pix4 p) { return vshrq_n_u32(p,N); }
+// Keep the low 16 bits of eight pixels
+static inline void PixStore8(uint16_t *out,Pix4 lo,Pix4 hi) { vst1q_u16(out,vcombine_u16(vmovn_u32(lo),vmovn_u32(hi))); }
+#elif defined(__SSE2__)
+#define WK_PIXEL_SIMD 1
+typedef __m128i Pix4;
+static inline Pix4 PixLoad4(const uint32_t *in) { return _mm_loadu_si128((const __m128i *)in); }
+static inline Pix4 PixAnd(Pix4 p,uint32_t mask) { return _mm_and_si128(p,_mm_set1_epi32((int)mask)); }
+static inline Pix4 PixOr(Pix4 a,Pix4 b) { return _mm_or_si128(a,b); }
+template<int N> static inline Pix4 PixShl(Pix4 p) { return _mm_slli_epi32(p,N); }
+template<int N> static inline Pix4 PixShr(Pix4 p) { return _mm_srli_epi32(p,N); }
+// Keep the low 16 bits of eight pixels.  Sign extend first so the saturating pack leaves them alone.
+static inline void PixStore8(uint16_t *out,Pix4 lo,Pix4 hi)
+{
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo,16),16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi,16),16);
+    _mm_storeu_si128((__m128i *)out,_mm_packs_epi32(lo,hi));
+}
+#endif
+
+// Run a 32 bit to 16 bit pixel conversion over a buffer
+template<typename Op>
+static inline void ConvertPixels(const uint32_t *inPixels,uint16_t *outPixels,size_t pixelCount)
+{
+    size_t ii = 0;
+#ifdef WK_PIXEL_SIMD
+    for (;ii+8<=pixelCount;ii+=8)
+        PixStore8(&outPixels[ii],Op::convert(PixLoad4(&inPixels[ii])),Op::convert(PixLoad4(&inPixels[ii+4])));
+#endif
+    for (;ii<pixelCount;ii++)
+        outPixels[ii] = (uint16_t)Op::convert(inPixels[ii]);
+}
+
+// RGBA (little endian) to RRRRRGGGGGGBBBBB
+struct PixTo565
+{
+    template<typename T> static inline T convert(T p)
+    {
+        return PixOr(PixOr(PixShl<8>(PixAnd(p,0xF8)),
+                           PixAnd(PixShr<5>(p),0x7E0)),
+                     PixAnd(PixShr<19>(p),0x1F));
+    }
+};
+
+// RGBA to RRRRGGGGBBBBAAAA
+struct PixTo4444
+{
+    template<typename T> static inline T convert(T p)
+    {
+        return PixOr(PixOr(PixShl<8>(PixAnd(p,0xF0)),
+                           PixAnd(PixShr<4>(p),0xF00)),
+                     PixOr(PixAnd(PixShr<16>(p),0xF0),
+                           PixShr<28>(p)));
+    }
+};
+
+// RGBA to RRRRRGGGGGBBBBBA
+struct PixTo5551
+{
+    template<typename T> static inline T convert(T p)
+    {
+        return PixOr(PixOr(PixShl<8>(PixAnd(p,0xF8)),
+                           PixAnd(PixShr<5>(p),0x7C0)),
+                     PixOr(PixAnd(PixShr<18>(p),0x3E),
+                           PixShr<31>(p)));
+    }
+};
+
+// RGBA to RG
+struct PixToRG
+{
+    template<typename T> static inline T convert(T p)
+    {
+        return PixAnd(p,0xFFFF);
+    }
+};
+
+void ConvertRGBATo565(const uint32_t *inPixels,uint16_t *outPixels,size_t pixelCount)
+{
+    ConvertPixels<PixTo565>(inPixels,outPixels,pixelCount);
+}
+
+void ConvertRGBATo4444(const uint32_t *inPixels,uint16_t *outPixels,size_t pixelCount)
+{
+    ConvertPixels<PixTo4444>(inPixels,outPixels,pixelCount);
+}
+
+void ConvertRGBATo5551(const uint32_t *inPixels,uint16_t *outPixels,size_t pixelCount)
+{
+    ConvertPixels<PixTo5551>(inPixels,outPixels,pixelCount);
+}
+
+void ConvertRGBAToRG(const uint32_t *inPixels,uint16_t *outPixels,size_t pixelCount)
+{
+    ConvertPixels<PixToRG>(inPixels,outPixels,pixelCount);
+}
+
 // Convert a buffer in RGBA to 2-byte 565
 // Code courtesy: http://stackoverflow.com/questions/7930148/opengl-es-on-ios-texture-loading-how-do-i-get-from-a-rgba8888-png-file-to-a-r
 RawDataRef ConvertRGBATo565(RawDataRef inData)
 {
     const uint32_t pixelCount = inData->getLen()/4;
     void *temp = malloc(pixelCount * 2);
-    const uint32_t *inPixel32  = (uint32_t *)inData->getRawData();
-    uint16_t *outPixel16 = (uint16_t *)temp;
-    
-    for(uint32_t i=0; i<pixelCount; i++, inPixel32++)
-    {
-        const uint32_t r = (((*inPixel32 >> 0)  & 0xFF) >> 3);
-        const uint32_t g = (((*inPixel32 >> 8)  & 0xFF) >> 2);
-        const uint32_t b = (((*inPixel32 >> 16) & 0xFF) >> 3);
-        
-        *outPixel16++ = (r << 11) | (g << 5) | (b << 0);
-    }
+    ConvertRGBATo565((const uint32_t *)inData->getRawData(),(uint16_t *)temp,pixelCount);
 
     ANALYSIS_ASSUME_FREED(temp);
 
@@ -62,18 +168,7 @@ RawDataRef ConvertRGBATo4444(RawDataRef inData)
 {
     const uint32_t pixelCount = inData->getLen()/4;
     void *temp = malloc(pixelCount * 2);
-    const uint32_t *inPixel32  = (uint32_t *)inData->getRawData();
-    uint16_t *outPixel16 = (uint16_t *)temp;
-    
-    for(uint32_t i=0; i<pixelCount; i++, inPixel32++)
-    {
-        const uint32_t r = (((*inPixel32 >> 0)  & 0xFF) >> 4);
-        const uint32_t g = (((*inPixel32 >> 8)  & 0xFF) >> 4);
-        const uint32_t b = (((*inPixel32 >> 16) & 0xFF) >> 4);
-        const uint32_t a = (((*inPixel32 >> 24) & 0xFF) >> 4);
-        
-        *outPixel16++ = (r << 12) | (g << 8) | (b << 4) | (a<< 0);
-    }
+    ConvertRGBATo4444((const uint32_t *)inData->getRawData(),(uint16_t *)temp,pixelCount);
 
     ANALYSIS_ASSUME_FREED(temp);
 
@@ -85,18 +180,7 @@ RawDataRef ConvertRGBATo5551(RawDataRef inData)
 {
     const uint32_t pixelCount = inData->getLen()/4;
     void *temp = malloc(pixelCount * 2);
-    const uint32_t *inPixel32  = (uint32_t *)inData->getRawData();
-    uint16_t *outPixel16 = (uint16_t *)temp;
-    
-    for(uint32_t i=0; i<pixelCount; i++, inPixel32++)
-    {
-        const uint32_t r = (((*inPixel32 >> 0)  & 0xFF) >> 3);
-        const uint32_t g = (((*inPixel32 >> 8)  & 0xFF) >> 3);
-        const uint32_t b = (((*inPixel32 >> 16) & 0xFF) >> 3);
-        const uint32_t a = (((*inPixel32 >> 24) & 0xFF) >> 7);
-        
-        *outPixel16++ = (r << 11) | (g << 6) | (b << 1) | (a << 0);
-    }
+    ConvertRGBATo5551((const uint32_t *)inData->getRawData(),(uint16_t *)temp,pixelCount);
 
     ANALYSIS_ASSUME_FREED(temp);
 
@@ -167,25 +251,17 @@ RawDataRef ConvertRGBATo16(RawDataRef inData,int width,int height,bool pad)
     const int outWidth = width + extra;
 
     unsigned char *temp = (unsigned char *)malloc(outWidth*height*2);
-    bzero(temp,outWidth*height*2);
     
     const uint32_t *inPixel32row  = (uint32_t *)inData->getRawData();
-    uint8_t *outPixel8row = (uint8_t *)temp;
+    uint16_t *outPixel16row = (uint16_t *)temp;
     for (int32_t h=0;h<height;h++) {
-        const uint32_t *inPixel32 = inPixel32row;
-        uint8_t *outPixel8 = outPixel8row;
-        for (int32_t w=0;w<width;w++) {
-            uint32_t r = ((*inPixel32 >> 0)  & 0xFF);
-            uint32_t g = ((*inPixel32 >> 8)  & 0xFF);
-            outPixel8[0] = r;
-            outPixel8[1] = g;
-            
-            inPixel32++;
-            outPixel8+=2;
-        }
+        ConvertRGBAToRG(inPixel32row,outPixel16row,width);
+        // Only the padding needs clearing
+        if (extra > 0)
+            bzero(&outPixel16row[width],2*extra);
         
         inPixel32row += width;
-        outPixel8row += 2*outWidth;
+        outPixel16row += outWidth;
     }
 
     ANALYSIS_ASSUME_FREED(temp);
@@ -252,18 +328,18 @@ TextureBase::~TextureBase()
 }
 
 Texture::Texture()
-: TextureBase(), isPVRTC(false), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(TexTypeUnsignedByte), byteSource(WKSingleRGB), interpType(TexInterpLinear), isEmptyTexture(false)
+: TextureBase(), isPVRTC(false), isPKM(false), dataInFormat(false), usesMipmaps(false), wrapU(false), wrapV(false), format(TexTypeUnsignedByte), byteSource(WKSingleRGB), interpType(TexInterpLinear), isEmptyTexture(false)
 {    
 }
 
 Texture::Texture(const std::string &name)
-	: TextureBase(name), isPVRTC(false), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(TexTypeUnsignedByte), byteSource(WKSingleRGB), interpType(TexInterpLinear), isEmptyTexture(false)
+	: TextureBase(name), isPVRTC(false), isPKM(false), dataInFormat(false), usesMipmaps(false), wrapU(false), wrapV(false), format(TexTypeUnsignedByte), byteSource(WKSingleRGB), interpType(TexInterpLinear), isEmptyTexture(false)
 {
 }
 
 // Construct with raw texture data
 Texture::Texture(const std::string &name,RawDataRef texData,bool isPVRTC)
-	: TextureBase(name), texData(texData), isPVRTC(isPVRTC), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(TexTypeUnsignedByte), byteSource(WKSingleRGB), interpType(TexInterpLinear), isEmptyTexture(false)
+	: TextureBase(name), texData(texData), isPVRTC(isPVRTC), isPKM(false), dataInFormat(false), usesMipmaps(false), wrapU(false), wrapV(false), format(TexTypeUnsignedByte), byteSource(WKSingleRGB), interpType(TexInterpLinear), isEmptyTexture(false)
 { 
 }
 
@@ -283,7 +359,7 @@ RawDataRef Texture::processData()
     if (!texData)
         return NULL;
     
-	if (isPVRTC || isPKM)
+	if (isPVRTC || isPKM || dataInFormat)
 	{
         return texData;
 	} else {
@@ -0,0 +1,203 @@
+/*
+ *  TextureNull.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "TextureNull.h"
+#import "SceneRendererNull.h"
+
+namespace WhirlyKit
+{
+
+int TextureTypeBytesPerPixel(TextureType type)
+{
+    switch (type)
+    {
+        case TexTypeSingleChannel:
+            return 1;
+        case TexTypeShort565:
+        case TexTypeShort4444:
+        case TexTypeShort5551:
+        case TexTypeDoubleChannel:
+        case TexTypeSingleFloat16:
+        case TexTypeSingleInt16:
+            return 2;
+        case TexTypeDoubleFloat16:
+            return 4;
+        case TexTypeQuadFloat16:
+        case TexTypeDoubleFloat32:
+        case TexTypeDoubleUInt32:
+            return 8;
+        case TexTypeQuadFloat32:
+        case TexTypeQuadUInt32:
+            return 16;
+        case TexTypeUnsignedByte:
+        case TexTypeSingleFloat32:
+        case TexTypeDepthFloat32:
+        case TexTypeSingleUInt32:
+        default:
+            return 4;
+    }
+}
+
+TextureNull::TextureNull(const std::string &name)
+    : TextureBase(name), Texture(name), isSetup(false), texSize(0)
+{
+}
+
+TextureNull::TextureNull(const std::string &name,RawDataRef texData,bool isPVRTC)
+    : TextureBase(name), Texture(name,texData,isPVRTC), isSetup(false), texSize(0)
+{
+}
+
+bool TextureNull::createInRenderer(const RenderSetupInfo *inSetupInfo)
+{
+    auto setupInfo = (RenderSetupInfoNull *)inSetupInfo;
+
+    if (!texData && !isEmptyTexture)
+        return false;
+
+    // We'll only create this once
+    if (isSetup)
+        return true;
+
+    // The conversion is real work, so we still do it
+    RawDataRef convertedData = processData();
+
+    if ((isPVRTC || isPKM) && convertedData)
+        texSize = convertedData->getLen();
+    else
+        texSize = (size_t)width * height * TextureTypeBytesPerPixel(format);
+    // A full mip chain adds about a third
+    if (usesMipmaps)
+        texSize += texSize / 3;
+
+    if (setupInfo)
+        setupInfo->addTexture(texSize, convertedData ? convertedData->getLen() : 0);
+
+    // Once it would be in the renderer, let's get rid of this copy
+    texData.reset();
+    isSetup = true;
+
+    return true;
+}
+
+void TextureNull::destroyInRenderer(const RenderSetupInfo *inSetupInfo,Scene *scene)
+{
+    auto setupInfo = (RenderSetupInfoNull *)inSetupInfo;
+
+    if (!isSetup)
+        return;
+
+    if (setupInfo)
+        setupInfo->removeTexture(texSize);
+    texSize = 0;
+    isSetup = false;
+}
+
+DynamicTextureNull::DynamicTextureNull(const std::string &name)
+    : TextureBase(name), DynamicTexture(name), setupInfo(nullptr), texBytes(0)
+{
+}
+
+bool DynamicTextureNull::createInRenderer(const RenderSetupInfo *inSetupInfo)
+{
+    // Already setup
+    if (setupInfo)
+        return true;
+
+    setupInfo = inSetupInfo;
+    texBytes = (size_t)texSize * texSize * TextureTypeBytesPerPixel(type);
+    if (setupInfo)
+        ((RenderSetupInfoNull *)setupInfo)->addTexture(texBytes, 0);
+
+    return true;
+}
+
+void DynamicTextureNull::destroyInRenderer(const RenderSetupInfo *inSetupInfo,Scene *scene)
+{
+    if (!setupInfo)
+        return;
+
+    ((RenderSetupInfoNull *)setupInfo)->removeTexture(texBytes);
+    texBytes = 0;
+    setupInfo = nullptr;
+}
+
+void DynamicTextureNull::addTextureData(int startX,int startY,int width,int height,RawDataRef data)
+{
+    if (setupInfo && data)
+        ((RenderSetupInfoNull *)setupInfo)->addUpload(data->getLen());
+}
+
+void DynamicTextureNull::clearTextureData(int startX,int startY,int width,int height,ChangeSet &changes,bool mainThreadMerge,unsigned char *emptyData)
+{
+}
+
+RenderTargetNull::RenderTargetNull()
+    : targetTexID(EmptyIdentity)
+{
+    RenderTarget::init();
+}
+
+RenderTargetNull::RenderTargetNull(SimpleIdentity newID)
+    : RenderTarget(newID), targetTexID(EmptyIdentity)
+{
+    RenderTarget::init();
+}
+
+bool RenderTargetNull::init(SceneRenderer *renderer,Scene *scene,SimpleIdentity inTargetTexID)
+{
+    if (inTargetTexID != EmptyIdentity && scene)
+        setTargetTexture(renderer,scene,inTargetTexID);
+    isSetup = true;
+
+    return true;
+}
+
+bool RenderTargetNull::setTargetTexture(SceneRenderer *renderer,Scene *scene,SimpleIdentity newTargetTexID)
+{
+    TextureBaseRef tex = scene->getTexture(newTargetTexID);
+    if (!tex)
+        return false;
+
+    targetTexID = newTargetTexID;
+    if (auto theTex = dynamic_cast<Texture *>(tex.get()))
+    {
+        width = theTex->getWidth();
+        height = theTex->getHeight();
+    }
+
+    return true;
+}
+
+void RenderTargetNull::setClearColor(const RGBAColor &color)
+{
+    color.asUnitFloats(clearColor);
+}
+
+void RenderTargetNull::clear()
+{
+}
+
+ProgramNull::ProgramNull(const std::string &inName,bool lights)
+    : lights(lights)
+{
+    name = inName;
+}
+
+}
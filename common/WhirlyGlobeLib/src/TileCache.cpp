@@ -0,0 +1,761 @@
+/*
+ *  TileCache.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2021 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <zlib.h>
+#import "TileCache.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+static const uint32_t IndexMagic = 0x5754434B;     // WKCT
+static const uint32_t RecordMagic = 0x5254434B;    // WKCR
+static const uint32_t IndexVersion = 1;
+static const unsigned int MinIndexCapacity = 4096;
+
+// Entry states
+static const uint32_t EntryEmpty = 0;
+static const uint32_t EntryLive = 1;
+static const uint32_t EntryRemoved = 2;
+
+// Start of the index file
+struct TileCache::IndexHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;      // Number of entries, a power of two
+    uint32_t numLive;       // Entries with data
+    uint32_t numUsed;       // Live or removed entries
+    uint32_t clean;         // Set when the cache was closed properly
+    uint32_t activePack;    // Pack we were writing to
+    uint32_t pad;
+    uint64_t clock;         // Bumped on every read or write.  Used for eviction.
+};
+
+// A single tile in the index
+struct TileCache::IndexEntry
+{
+    int64_t node;
+    uint64_t source;
+    uint64_t offset;        // Record location in the pack file
+    uint64_t written;       // Clock when we wrote the record
+    uint64_t lastUsed;      // Clock when we last read it
+    uint32_t pack;
+    uint32_t length;        // Tile data, not including the record header
+    uint32_t state;
+    uint32_t pad;
+};
+
+// Precedes each tile's data in a pack file.  Enough to rebuild the index.
+struct RecordHeader
+{
+    uint32_t magic;
+    uint32_t length;
+    int64_t node;
+    uint64_t source;
+    uint64_t written;
+    uint32_t crc;
+    uint32_t flags;
+};
+
+// Record flags
+static const uint32_t RecordRemoved = 1;    // No data, the tile was removed as of this record
+
+// Records start on 8 byte boundaries
+static inline uint64_t RecordSize(uint32_t length)
+{
+    return (sizeof(RecordHeader) + length + 7) & ~(uint64_t)7;
+}
+
+class TileCache::Pack
+{
+public:
+    Pack(uint32_t packID,int fd,const unsigned char *map,size_t mapLen,size_t size)
+    : packID(packID), fd(fd), map(map), mapLen(mapLen), size(size)
+    { }
+
+    ~Pack()
+    {
+        if (map)
+            munmap((void *)map, mapLen);
+        if (fd >= 0)
+            ::close(fd);
+    }
+
+    uint32_t packID;
+    int fd;
+    const unsigned char *map;
+    size_t mapLen;
+    // Bytes written
+    size_t size;
+};
+
+// A view on tile data in a mapped pack file
+class TileCacheData : public RawData
+{
+public:
+    TileCacheData(const TileCache::PackRef &pack,const unsigned char *data,unsigned long len)
+    : pack(pack), data(data), len(len)
+    { }
+
+    virtual const unsigned char *getRawData() const override { return data; }
+    virtual unsigned long getLen() const override { return len; }
+
+protected:
+    // Keeps the mapping around
+    TileCache::PackRef pack;
+    const unsigned char *data;
+    unsigned long len;
+};
+
+TileCache::Stats::Stats()
+: numTiles(0), numPacks(0), totalBytes(0), hits(0), misses(0)
+{
+}
+
+TileCache::TileCache(const std::string &dir,size_t maxBytes,size_t packBytes)
+: dir(dir), maxBytes(maxBytes), packBytes(packBytes),
+  indexFD(-1), indexLen(0), header(nullptr), entries(nullptr),
+  hits(0), misses(0)
+{
+}
+
+TileCache::~TileCache()
+{
+    close();
+}
+
+uint64_t TileCache::sourceHash(const std::string &source)
+{
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char c : source)
+    {
+        hash ^= (unsigned char)c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static inline uint64_t KeyHash(int64_t node,uint64_t source)
+{
+    uint64_t hash = (uint64_t)node * 0x9E3779B97F4A7C15ULL ^ source;
+    hash ^= hash >> 31;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+static std::string PackFileName(const std::string &dir,uint32_t packID)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/pack-%08u.dat", packID);
+    return dir + name;
+}
+
+bool TileCache::makeIndex(const std::string &fileName,unsigned int capacity)
+{
+    const size_t len = sizeof(IndexHeader) + (size_t)capacity * sizeof(IndexEntry);
+    const int fd = ::open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    if (ftruncate(fd, len) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // The file starts out zeroed, which is what empty entries look like
+    indexFD = fd;
+    indexLen = len;
+    header = (IndexHeader *)map;
+    entries = (IndexEntry *)((unsigned char *)map + sizeof(IndexHeader));
+    header->magic = IndexMagic;
+    header->version = IndexVersion;
+    header->capacity = capacity;
+
+    return true;
+}
+
+bool TileCache::mapIndex(const std::string &fileName)
+{
+    const int fd = ::open(fileName.c_str(), O_RDWR);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(IndexHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    indexFD = fd;
+    indexLen = info.st_size;
+    header = (IndexHeader *)map;
+    entries = (IndexEntry *)((unsigned char *)map + sizeof(IndexHeader));
+
+    // Make sure it's one of ours and matches its size
+    const unsigned int capacity = header->capacity;
+    if (header->magic != IndexMagic || header->version != IndexVersion ||
+        capacity == 0 || (capacity & (capacity-1)) != 0 ||
+        indexLen != sizeof(IndexHeader) + (size_t)capacity * sizeof(IndexEntry))
+    {
+        unmapIndex();
+        return false;
+    }
+
+    return true;
+}
+
+void TileCache::unmapIndex()
+{
+    if (header)
+        munmap(header, indexLen);
+    if (indexFD >= 0)
+        ::close(indexFD);
+    indexFD = -1;
+    indexLen = 0;
+    header = nullptr;
+    entries = nullptr;
+}
+
+TileCache::IndexEntry *TileCache::findEntry(int64_t node,uint64_t source,bool forInsert)
+{
+    const uint32_t mask = header->capacity - 1;
+    IndexEntry *firstRemoved = nullptr;
+    for (uint32_t slot = KeyHash(node, source) & mask, probe = 0; probe <= mask; slot = (slot + 1) & mask, probe++)
+    {
+        IndexEntry *entry = &entries[slot];
+        switch (entry->state)
+        {
+            case EntryLive:
+                if (entry->node == node && entry->source == source)
+                    return entry;
+                break;
+            case EntryRemoved:
+                if (!firstRemoved)
+                    firstRemoved = entry;
+                break;
+            default:
+                if (!forInsert)
+                    return nullptr;
+                return firstRemoved ? firstRemoved : entry;
+        }
+    }
+
+    return forInsert ? firstRemoved : nullptr;
+}
+
+bool TileCache::growIndex()
+{
+    // Double up if we're actually full, otherwise just clear out the removed entries
+    const unsigned int capacity = header->numLive * 2 > header->capacity / 2 ? header->capacity * 2 : header->capacity;
+
+    std::vector<IndexEntry> live;
+    live.reserve(header->numLive);
+    for (unsigned int ii=0;ii<header->capacity;ii++)
+        if (entries[ii].state == EntryLive)
+            live.push_back(entries[ii]);
+    const IndexHeader oldHeader = *header;
+    unmapIndex();
+
+    // Build the new one off to the side and swap it in
+    const std::string indexName = dir + "/index", tmpName = dir + "/index.tmp";
+    if (!makeIndex(tmpName, capacity))
+    {
+        // Go back to the old one so we're still usable
+        wkLogLevel(Error, "TileCache: Failed to grow index in %s", dir.c_str());
+        unlink(tmpName.c_str());
+        mapIndex(indexName);
+        return false;
+    }
+    header->activePack = oldHeader.activePack;
+    header->clock = oldHeader.clock;
+    for (const auto &entry : live)
+    {
+        IndexEntry *newEntry = findEntry(entry.node, entry.source, true);
+        *newEntry = entry;
+        header->numLive++;
+        header->numUsed++;
+    }
+    msync(header, indexLen, MS_SYNC);
+
+    return rename(tmpName.c_str(), indexName.c_str()) == 0;
+}
+
+bool TileCache::setEntry(int64_t node,uint64_t source,uint32_t pack,uint64_t offset,uint32_t length,uint64_t written)
+{
+    if ((header->numUsed + 1) * 10 > header->capacity * 7 && !growIndex())
+        return false;
+
+    IndexEntry *entry = findEntry(node, source, true);
+    if (!entry)
+        return false;
+    if (entry->state != EntryLive)
+    {
+        if (entry->state == EntryEmpty)
+            header->numUsed++;
+        header->numLive++;
+    }
+    entry->node = node;
+    entry->source = source;
+    entry->pack = pack;
+    entry->offset = offset;
+    entry->length = length;
+    entry->written = written;
+    entry->lastUsed = written;
+    entry->state = EntryLive;
+
+    return true;
+}
+
+TileCache::PackRef TileCache::openPack(uint32_t packID,bool create)
+{
+    const std::string fileName = PackFileName(dir, packID);
+    const int fd = ::open(fileName.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+    if (fd < 0)
+        return PackRef();
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        return PackRef();
+    }
+
+    // Map the whole size a pack can grow to, so we can keep reading as it's written
+    const size_t size = info.st_size;
+    const size_t mapLen = std::max(size, packBytes);
+    void *map = mmap(nullptr, mapLen, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        ::close(fd);
+        return PackRef();
+    }
+
+    return std::make_shared<Pack>(packID, fd, (const unsigned char *)map, mapLen, size);
+}
+
+bool TileCache::startPack()
+{
+    // The outgoing pack won't be synced again, so do it before the index can be marked clean
+    if (activePack)
+        fsync(activePack->fd);
+
+    const uint32_t packID = packs.empty() ? 0 : packs.rbegin()->first + 1;
+    PackRef pack = openPack(packID, true);
+    if (!pack)
+    {
+        wkLogLevel(Error, "TileCache: Failed to create pack file in %s", dir.c_str());
+        return false;
+    }
+
+    packs[packID] = pack;
+    activePack = pack;
+    header->activePack = packID;
+
+    return true;
+}
+
+bool TileCache::appendRecord(int64_t node,uint64_t source,const unsigned char *data,uint32_t length,uint32_t flags,uint64_t &offset)
+{
+    const uint64_t recordSize = RecordSize(length);
+    if (recordSize > packBytes)
+        return false;
+    if (!activePack || activePack->size + recordSize > packBytes)
+        if (!startPack())
+            return false;
+
+    RecordHeader record;
+    memset(&record, 0, sizeof(record));
+    record.magic = RecordMagic;
+    record.length = length;
+    record.node = node;
+    record.source = source;
+    record.written = ++header->clock;
+    record.crc = (uint32_t)crc32(0, data, length);
+    record.flags = flags;
+
+    offset = activePack->size;
+    if (pwrite(activePack->fd, &record, sizeof(record), offset) != sizeof(record) ||
+        (length > 0 && pwrite(activePack->fd, data, length, offset + sizeof(record)) != (ssize_t)length))
+    {
+        wkLogLevel(Error, "TileCache: Failed to write to pack file in %s", dir.c_str());
+        return false;
+    }
+    activePack->size += recordSize;
+
+    return true;
+}
+
+bool TileCache::rebuildIndex()
+{
+    // Pack files we've got, which may have torn records at the end
+    std::vector<uint32_t> packIDs;
+    if (DIR *dirp = opendir(dir.c_str()))
+    {
+        while (struct dirent *dirEnt = readdir(dirp))
+        {
+            unsigned int packID = 0;
+            char tail[8] = {0};
+            if (strlen(dirEnt->d_name) == 17 && sscanf(dirEnt->d_name, "pack-%8u%4s", &packID, tail) == 2 && !strcmp(tail, ".dat"))
+                packIDs.push_back(packID);
+        }
+        closedir(dirp);
+    }
+    std::sort(packIDs.begin(), packIDs.end());
+
+    if (!makeIndex(dir + "/index", MinIndexCapacity))
+        return false;
+
+    // When each removed tile was removed, so older copies stay gone
+    std::map<std::pair<int64_t,uint64_t>,uint64_t> removed;
+
+    uint64_t clock = 0;
+    for (const uint32_t packID : packIDs)
+    {
+        PackRef pack = openPack(packID, false);
+        if (!pack)
+            continue;
+        packs[packID] = pack;
+
+        // Read records until we run out or hit a bad one
+        uint64_t offset = 0;
+        while (offset + sizeof(RecordHeader) <= pack->size)
+        {
+            const RecordHeader *record = (const RecordHeader *)(pack->map + offset);
+            const uint64_t recordSize = RecordSize(record->length);
+            if (record->magic != RecordMagic || offset + sizeof(RecordHeader) + record->length > pack->size ||
+                record->crc != (uint32_t)crc32(0, pack->map + offset + sizeof(RecordHeader), record->length))
+                break;
+
+            // Newest copy of a tile wins, unless it's been removed since
+            IndexEntry *existing = findEntry(record->node, record->source, false);
+            if (record->flags & RecordRemoved)
+            {
+                uint64_t &removedAt = removed[std::make_pair(record->node, record->source)];
+                removedAt = std::max(removedAt, record->written);
+                if (existing && existing->written < record->written)
+                {
+                    existing->state = EntryRemoved;
+                    header->numLive--;
+                }
+            } else if (!existing || existing->written < record->written)
+            {
+                const auto rit = removed.find(std::make_pair(record->node, record->source));
+                if ((rit == removed.end() || rit->second < record->written) &&
+                    !setEntry(record->node, record->source, packID, offset, record->length, record->written))
+                {
+                    // Growing the index failed
+                    unmapIndex();
+                    packs.clear();
+                    return false;
+                }
+            }
+            clock = std::max(clock, record->written);
+            offset += recordSize;
+        }
+
+        // Drop whatever was half written
+        if (offset < pack->size)
+        {
+            wkLogLevel(Warn, "TileCache: Truncating pack %u in %s",packID,dir.c_str());
+            if (ftruncate(pack->fd, offset) == 0)
+                pack->size = offset;
+        }
+    }
+    header->clock = clock;
+
+    return true;
+}
+
+bool TileCache::open()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (header)
+        return true;
+    mkdir(dir.c_str(), 0755);
+
+    // Use the index if it was closed properly, otherwise rebuild it from the packs
+    bool indexOkay = false;
+    if (mapIndex(dir + "/index"))
+    {
+        if (header->clean)
+        {
+            indexOkay = true;
+            for (unsigned int ii=0;ii<header->capacity && indexOkay;ii++)
+            {
+                const IndexEntry &entry = entries[ii];
+                if (entry.state == EntryLive && packs.find(entry.pack) == packs.end())
+                {
+                    PackRef pack = openPack(entry.pack, false);
+                    if (pack)
+                        packs[entry.pack] = pack;
+                    else
+                        indexOkay = false;
+                }
+            }
+            // The active pack may not have anything in the index yet
+            if (indexOkay && packs.find(header->activePack) == packs.end())
+                if (PackRef pack = openPack(header->activePack, false))
+                    packs[header->activePack] = pack;
+        }
+        if (!indexOkay)
+        {
+            unmapIndex();
+            packs.clear();
+        }
+    }
+    if (!indexOkay)
+    {
+        wkLogLevel(Info, "TileCache: Rebuilding index in %s", dir.c_str());
+        if (!rebuildIndex())
+        {
+            wkLogLevel(Error, "TileCache: Failed to set up index in %s", dir.c_str());
+            packs.clear();
+            return false;
+        }
+    }
+
+    // Keep appending to the last pack
+    auto it = packs.find(header->activePack);
+    if (it == packs.end() && !packs.empty())
+        it = std::prev(packs.end());
+    activePack = it == packs.end() ? PackRef() : it->second;
+
+    // Marked clean again when we close
+    header->clean = 0;
+    msync(header, sizeof(IndexHeader), MS_SYNC);
+
+    return true;
+}
+
+void TileCache::flush()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (activePack)
+        fsync(activePack->fd);
+    if (header)
+        msync(header, indexLen, MS_SYNC);
+}
+
+void TileCache::close()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (!header)
+        return;
+
+    if (activePack)
+        fsync(activePack->fd);
+    msync(header, indexLen, MS_SYNC);
+    header->clean = 1;
+    msync(header, sizeof(IndexHeader), MS_SYNC);
+    unmapIndex();
+
+    // Outstanding tile data keeps its own pack mapped
+    activePack.reset();
+    packs.clear();
+}
+
+RawDataRef TileCache::getTile(const QuadTreeIdentifier &ident,const std::string &source)
+{
+    const int64_t node = ident.NodeNumber();
+    const uint64_t sourceID = sourceHash(source);
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (!header)
+        return RawDataRef();
+
+    IndexEntry *entry = findEntry(node, sourceID, false);
+    if (!entry)
+    {
+        misses++;
+        return RawDataRef();
+    }
+
+    // Make sure the record is what we think it is
+    const auto it = packs.find(entry->pack);
+    const RecordHeader *record = nullptr;
+    if (it != packs.end() && entry->offset + sizeof(RecordHeader) + entry->length <= it->second->size)
+        record = (const RecordHeader *)(it->second->map + entry->offset);
+    if (!record || record->magic != RecordMagic || record->node != node || record->source != sourceID || record->length != entry->length)
+    {
+        entry->state = EntryRemoved;
+        header->numLive--;
+        misses++;
+        return RawDataRef();
+    }
+
+    entry->lastUsed = ++header->clock;
+    hits++;
+
+    return std::make_shared<TileCacheData>(it->second, (const unsigned char *)(record + 1), entry->length);
+}
+
+bool TileCache::putTile(const QuadTreeIdentifier &ident,const std::string &source,const RawData &data)
+{
+    const int64_t node = ident.NodeNumber();
+    const uint64_t sourceID = sourceHash(source);
+
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (!header || data.getLen() > UINT32_MAX)
+        return false;
+
+    uint64_t offset = 0;
+    if (!appendRecord(node, sourceID, data.getRawData(), (uint32_t)data.getLen(), 0, offset) ||
+        !setEntry(node, sourceID, activePack->packID, offset, (uint32_t)data.getLen(), header->clock))
+        return false;
+
+    // Stay under the size limit
+    size_t totalBytes = 0;
+    for (const auto &it : packs)
+        totalBytes += it.second->size;
+    if (totalBytes > maxBytes)
+    {
+        for (size_t numPacks = packs.size(); numPacks > 1 && totalBytes > maxBytes; numPacks--)
+        {
+            if (!evictOldestPack())
+                break;
+            totalBytes = 0;
+            for (const auto &it : packs)
+                totalBytes += it.second->size;
+        }
+    }
+
+    return true;
+}
+
+void TileCache::removeTile(const QuadTreeIdentifier &ident,const std::string &source)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (!header)
+        return;
+
+    const int64_t node = ident.NodeNumber();
+    const uint64_t sourceID = sourceHash(source);
+    IndexEntry *entry = findEntry(node, sourceID, false);
+    if (!entry)
+        return;
+
+    // Leave a marker in the pack so a rebuild doesn't bring it back
+    uint64_t offset = 0;
+    if (!appendRecord(node, sourceID, nullptr, 0, RecordRemoved, offset))
+        wkLogLevel(Warn, "TileCache: Failed to record removal in %s", dir.c_str());
+    entry->state = EntryRemoved;
+    header->numLive--;
+}
+
+bool TileCache::evictOldestPack()
+{
+    if (packs.size() < 2)
+        return false;
+    PackRef victim = packs.begin()->second;
+    if (victim == activePack)
+        return false;
+
+    // Anything read since it was written gets another chance in the active pack
+    for (unsigned int ii=0;ii<header->capacity;ii++)
+    {
+        IndexEntry &entry = entries[ii];
+        if (entry.state != EntryLive || entry.pack != victim->packID)
+            continue;
+
+        uint64_t offset = 0;
+        if (entry.lastUsed > entry.written && entry.offset + sizeof(RecordHeader) + entry.length <= victim->size &&
+            appendRecord(entry.node, entry.source, victim->map + entry.offset + sizeof(RecordHeader), entry.length, 0, offset))
+        {
+            entry.pack = activePack->packID;
+            entry.offset = offset;
+            entry.written = header->clock;
+            entry.lastUsed = header->clock;
+        } else {
+            entry.state = EntryRemoved;
+            header->numLive--;
+        }
+    }
+
+    // Copies and index go to disk before the old pack goes away.
+    // If we crash in between, the rebuild sorts it out.
+    fsync(activePack->fd);
+    msync(header, indexLen, MS_SYNC);
+    unlink(PackFileName(dir, victim->packID).c_str());
+    packs.erase(victim->packID);
+
+    return true;
+}
+
+void TileCache::compact()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    if (!header)
+        return;
+
+    size_t totalBytes = 0;
+    for (const auto &it : packs)
+        totalBytes += it.second->size;
+    for (size_t numPacks = packs.size(); numPacks > 1 && totalBytes > maxBytes; numPacks--)
+    {
+        if (!evictOldestPack())
+            break;
+        totalBytes = 0;
+        for (const auto &it : packs)
+            totalBytes += it.second->size;
+    }
+}
+
+TileCache::Stats TileCache::getStats()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    Stats stats;
+    stats.numTiles = header ? header->numLive : 0;
+    stats.numPacks = packs.size();
+    for (const auto &it : packs)
+        stats.totalBytes += it.second->size;
+    stats.hits = hits;
+    stats.misses = misses;
+
+    return stats;
+}
+
+}
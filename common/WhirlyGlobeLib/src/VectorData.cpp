@@ -19,6 +19,7 @@
 #import <string>
 #import "VectorData.h"
 #import "ShapeReader.h"
+#import "GeoJSONReader.h"
 #import "WhirlyKitLog.h"
 #import "libjson.h"
 
@@ -1115,28 +1116,24 @@ bool VectorParseGeoJSONCRS(JSONNode node,std::string &crsName)
     return false;
 }
     
-// Parse a set of features out of GeoJSON, using libjson
+// Parse a set of features out of GeoJSON.
+// This used to go through the libjson DOM, which was slow and hungry for large files.
 bool VectorParseGeoJSON(ShapeSet &shapes,const std::string &str,std::string &crs)
 {
-    json_string json = str;
-    JSONNode topNode = libjson::parse(json);
-
-    JSONNode crsNode;
-    if (!VectorParseTopNode(topNode,shapes,crsNode))
+    GeoJSONReader reader;
+    if (!reader.parse(str.data(),str.size(),shapes,crs))
     {
-//        NSLog(@"Failed to parse JSON in VectorParseGeoJSON");
+        wkLogLevel(Warn, "VectorParseGeoJSON: %s", reader.getError().c_str());
         return false;
     }
-
-    std::string crsName;
-    if (VectorParseGeoJSONCRS(crsNode,crsName))
-    {
-        if (!crsName.empty())
-            crs = crsName;
-    }
     
     return true;
 }
+
+bool VectorParseGeoJSONLines(ShapeSet &shapes,const std::string &str,int numThreads)
+{
+    return GeoJSONReader::ParseLines(str.data(),str.size(),shapes,numThreads);
+}
     
 bool VectorParseGeoJSONAssembly(const std::string &str,std::map<std::string,ShapeSet> &shapes)
 {
@@ -106,6 +106,25 @@ void VectorSceneRep::clear(ChangeSet &changes)
 
 static const std::string vecBuilderName("Vector Layer");
 
+// Convert a ring of geo points, offset by the geo center, to display coordinates and normals in one go
+static void RingToDisplay(const CoordSystemDisplayAdapter *coordAdapter,const VectorRing &pts,const Point2d &geoCenter,
+                          std::vector<Point2d> &geoPts,std::vector<Point3d> &dispPts,std::vector<Point3d> &normPts)
+{
+    geoPts.resize(pts.size());
+    dispPts.resize(pts.size());
+    normPts.resize(pts.size());
+    for (unsigned int jj=0;jj<pts.size();jj++)
+        geoPts[jj] = Point2d(pts[jj].x()+geoCenter.x(),pts[jj].y()+geoCenter.y());
+    coordAdapter->geographicToDisplay(geoPts.data(),dispPts.data(),normPts.data(),pts.size());
+}
+
+// Geographic extents of a drawable with the center offset put back, so the scene can cull with them
+static Mbr GeoDrawMbr(const Mbr &drawMbr,const Point2d &geoCenter)
+{
+    const Point2f offset(geoCenter.x(),geoCenter.y());
+    return Mbr(drawMbr.ll() + offset,drawMbr.ur() + offset);
+}
+
 /* Drawable Builder
  Used to construct drawables with multiple shapes in them.
  Eventually, we'll move this out to be a more generic object.
@@ -159,7 +178,7 @@ public:
         // Decide if we'll appending to an existing drawable or
         //  create a new one
         const int ptCount = (int)(2*(pts.size()+1));
-        if (!drawable || (drawable->getNumPoints()+ptCount > MaxDrawablePoints))
+        if (!drawable || (drawable->getNumPoints()+ptCount > sceneRender->getMaxDrawablePoints()))
         {
             // We're done with it, toss it to the scene
             if (drawable)
@@ -176,17 +195,16 @@ public:
             drawable->setOpacityExpression(vecInfo->opacityExp);
         }
         drawMbr.addPoints(pts);
+
+        // Convert to real world coordinates and offset from the globe
+        RingToDisplay(coordAdapter,pts,geoCenter,geoPts,dispPts,normPts);
         
         Point3f prevPt,prevNorm,firstPt,firstNorm;
         for (unsigned int jj=0;jj<pts.size();jj++)
         {
-            // Convert to real world coordinates and offset from the globe
-            const Point2f &geoPt = pts[jj];
-            const Point2d geoCoordD(geoPt.x()+geoCenter.x(),geoPt.y()+geoCenter.y());
-            const Point3d localPt = coordAdapter->getCoordSystem()->geographicToLocal(geoCoordD);
-            const Point3d norm3d = coordAdapter->normalForLocal(localPt);
+            const Point3d &norm3d = normPts[jj];
             const Point3f norm(norm3d.x(),norm3d.y(),norm3d.z());
-            const Point3d pt3d = coordAdapter->localToDisplay(localPt) - center;
+            const Point3d pt3d = dispPts[jj] - center;
             const Point3f pt(pt3d.x(),pt3d.y(),pt3d.z());
             
             // Add to drawable
@@ -239,7 +257,7 @@ public:
         {
             if (drawable->getNumPoints() > 0)
             {
-                drawable->setLocalMbr(drawMbr);
+                drawable->setLocalMbr(GeoDrawMbr(drawMbr,geoCenter),LocalMbrGeographic);
                 sceneRep->drawIDs.insert(drawable->getDrawableID());
                 if (centerValid)
                 {
@@ -272,6 +290,9 @@ protected:
     Point2d geoCenter;
     bool centerValid;
     const GeometryType primType;
+    // Scratch space for converting coordinates
+    std::vector<Point2d> geoPts;
+    std::vector<Point3d> dispPts,normPts;
 };
 
 /* Drawable Builder (Triangle version)
@@ -377,17 +398,26 @@ public:
             centroid.y() = attrs->getDouble(MaplyVecCenterY);
         }
         
+        // Convert to real world coordinates and offset from the globe.
+        // The triangles share vertices, so do them all at once.
+        VectorRing meshPts;
+        meshPts.reserve(mesh->pts.size());
+        for (const auto &pt : mesh->pts)
+            meshPts.emplace_back(pt.x(),pt.y());
+        RingToDisplay(coordAdapter,meshPts,geoCenter,geoPts,dispPts,normPts);
+
         for (unsigned int ir=0;ir<mesh->tris.size();ir++)
         {
             VectorRing pts;
             mesh->getTriangle(ir, pts);
+            const VectorTriangles::Triangle &tri = mesh->tris[ir];
             // Decide if we'll appending to an existing drawable or
             //  create a new one
             const int ptCount = (int)pts.size();
             const int triCount = (int)(pts.size()-2);
             if (!drawable ||
-                (drawable->getNumPoints()+ptCount > MaxDrawablePoints) ||
-                (drawable->getNumTris()+triCount > MaxDrawableTriangles))
+                (drawable->getNumPoints()+ptCount > sceneRender->getMaxDrawablePoints()) ||
+                (drawable->getNumTris()+triCount > sceneRender->getMaxDrawableTriangles()))
             {
                 // We're done with it, toss it to the scene
                 if (drawable)
@@ -434,14 +464,13 @@ public:
                 for (unsigned int jj=0;jj<pts.size();jj++)
                 {
                     const Point2f &geoPt = pts[jj];
-                    const Point2d geoCoordD(geoPt.x()+geoCenter.x(),geoPt.y()+geoCenter.y());
                     
                     TexCoord texCoord;
                     switch (vecInfo->texProj)
                     {
                         case TextureProjectionTanPlane:
                         {
-                            const Point3d dispPt = coordAdapter->localToDisplay(coordAdapter->getCoordSystem()->geographicToLocal(geoCoordD))-center;
+                            const Point3d dispPt = dispPts[tri.pts[jj]]-center;
                             const Point3d dir = dispPt - planeOrg;
                             const Point3d comp(dir.dot(planeX),dir.dot(planeY),dir.dot(planeUp));
                             texCoord.x() = comp.x() * vecInfo->texScale.x();
@@ -476,13 +505,9 @@ public:
             // Add the points
             for (unsigned int jj=0;jj<pts.size();jj++)
             {
-                // Convert to real world coordinates and offset from the globe
-                const Point2f &geoPt = pts[jj];
-                const Point2d geoCoordD(geoPt.x()+geoCenter.x(),geoPt.y()+geoCenter.y());
-                const Point3d localPt = coordAdapter->getCoordSystem()->geographicToLocal(geoCoordD);
-                const Point3d norm3d = coordAdapter->normalForLocal(localPt);
+                const Point3d &norm3d = normPts[tri.pts[jj]];
                 const Point3f norm(norm3d.x(),norm3d.y(),norm3d.z());
-                const Point3d pt3d = coordAdapter->localToDisplay(localPt) - center;
+                const Point3d pt3d = dispPts[tri.pts[jj]] - center;
                 const Point3f pt(pt3d.x(),pt3d.y(),pt3d.z());
                 
                 drawable->addPoint(pt);
@@ -517,7 +542,7 @@ public:
                     drawable->addTweaker(std::make_shared<BasicDrawableScreenTexTweaker>(centerPt,texScale));
                 }
 
-                drawable->setLocalMbr(drawMbr);
+                drawable->setLocalMbr(GeoDrawMbr(drawMbr,geoCenter),LocalMbrGeographic);
                 if (centerValid)
                 {
                     const Eigen::Affine3d trans(Eigen::Translation3d(center.x(),center.y(),center.z()));
@@ -550,6 +575,9 @@ protected:
     bool centerValid;
     BasicDrawableBuilderRef drawable;
     const VectorInfo *vecInfo;
+    // Scratch space for converting coordinates
+    std::vector<Point2d> geoPts;
+    std::vector<Point3d> dispPts,normPts;
 };
 
 VectorManager::VectorManager()
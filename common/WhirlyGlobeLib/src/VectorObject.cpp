@@ -19,7 +19,7 @@
 #import "VectorObject.h"
 #import "GlobeMath.h"
 #import "VectorData.h"
-#import "ShapeReader.h"
+#import "MappedShapeReader.h"
 #import "Tesselator.h"
 #import "GridClipper.h"
 #import "WhirlyKitLog.h"
@@ -51,6 +51,11 @@ bool VectorObject::fromGeoJSON(const std::string &json,std::string &crs)
 {
     return VectorParseGeoJSON(shapes,json,crs);
 }
+
+bool VectorObject::fromGeoJSONLines(const std::string &json,int numThreads)
+{
+    return VectorParseGeoJSONLines(shapes,json,numThreads);
+}
     
 bool VectorObject::FromGeoJSONAssembly(const std::string &json,std::map<std::string,VectorObject *> &vecData)
 {
@@ -73,14 +78,15 @@ bool VectorObject::FromGeoJSONAssembly(const std::string &json,std::map<std::str
     
 bool VectorObject::fromShapeFile(const std::string &fileName)
 {
-    ShapeReader shapeReader(fileName);
+    MappedShapeReader shapeReader(fileName);
     if (!shapeReader.isValid())
         return false;
     
-    const int numObj = shapeReader.getNumObjects();
-    shapes.reserve(shapes.size() + numObj);
-    for (unsigned int ii=0;ii<numObj;ii++) {
-        shapes.insert(shapeReader.getObjectByIndex(ii, NULL));
+    // Decode in parallel and then merge.  Null records come back empty, as they did from ShapeReader.
+    const auto batches = shapeReader.readBatches(4096, NULL, 0, true);
+    shapes.reserve(shapes.size() + shapeReader.getNumObjects());
+    for (const auto &batch : batches) {
+        shapes.insert(batch->shapes.begin(), batch->shapes.end());
     }
     
     return true;
@@ -23,10 +23,9 @@
 #import "VectorObject.h"
 #import "WhirlyKitLog.h"
 #import "DictionaryC.h"
+#import "FlatDictionary.h"
 
-#import "vector_tile.pb.h"
-#import "maply_pb_decode.h"
-
+#import <cstring>
 #import <vector>
 #import <string>
 
@@ -38,45 +37,157 @@ namespace {
     const std::string layerNameKey("layer_name");       //NOLINT
     const std::string geometryTypeKey("geometry_type"); //NOLINT
     const std::string layerOrderKey("layer_order");     //NOLINT
-}
 
-const vector_tile_Tile_Layer VectorTilePBFParser::_defaultLayer = {
-    /* name       */ { &VectorTilePBFParser::stringDecode,    nullptr },
-    /* features   */ { &VectorTilePBFParser::featureDecode,   nullptr },
-    /* keys       */ { &VectorTilePBFParser::stringVecDecode, nullptr },
-    /* values     */ { &VectorTilePBFParser::valueVecDecode,  nullptr },
-    /* has_extent */ false,
-    /* extent     */ 0,
-    /* version    */ 0,
-    /* extensions */ nullptr,
-};
+    // Field numbers from vector_tile.proto
+    enum : uint32_t {
+        TileLayerField = 3,
+        LayerNameField = 1, LayerFeatureField = 2, LayerKeyField = 3, LayerValueField = 4, LayerExtentField = 5,
+        FeatureTagsField = 2, FeatureTypeField = 3, FeatureGeometryField = 4,
+        ValueStringField = 1, ValueFloatField = 2, ValueDoubleField = 3, ValueIntField = 4,
+        ValueUIntField = 5, ValueSIntField = 6, ValueBoolField = 7,
+    };
 
-const vector_tile_Tile_Feature VectorTilePBFParser::_defaultFeature = {
-    /* has_id   */ false,
-    /* id       */ 0LL,
-    /* tags     */ { &VectorTilePBFParser::intVecDecode, nullptr },
-    /* has_type */ false,
-    /* type     */ vector_tile_Tile_GeomType_UNKNOWN,
-    /* geometry */ { &VectorTilePBFParser::intVecDecode, nullptr },
-};
+    enum : uint32_t { WireVarint = 0, WireFixed64 = 1, WireBytes = 2, WireFixed32 = 5 };
 
-const vector_tile_Tile_Value VectorTilePBFParser::_defaultValue = {
-    /* pb_callback_t string_value */ { &VectorTilePBFParser::stringDecode, nullptr },
-    /* bool has_float_value       */ false,
-    /* float float_value          */ 0.0f,
-    /* bool has_double_value      */ false,
-    /* double double_value        */ 0.0,
-    /* bool has_int_value         */ false,
-    /* int64_t int_value          */ 0LL,
-    /* bool has_uint_value        */ false,
-    /* uint64_t uint_value        */ 0ULL,
-    /* bool has_sint_value        */ false,
-    /* int64_t sint_value         */ 0LL,
-    /* has_bool_value             */ false,
-    /* bool_value                 */ false,
-    /* extensions                 */ nullptr,
-};
+    // Default layer extent, per the spec
+    constexpr uint32_t DefaultExtent = 4096;
+
+    // Minimal protobuf reader that works directly on the tile bytes.
+    // Nothing is copied; strings and sub-messages come back as views into the buffer.
+    struct PBFReader
+    {
+        PBFReader(const uint8_t *data, size_t len) : cur(data), end(data + len) { }
+        explicit PBFReader(std::string_view data) : PBFReader((const uint8_t *)data.data(), data.size()) { }
+
+        bool atEnd() const { return cur >= end; }
+
+        bool varint(uint64_t &val)
+        {
+            val = 0;
+            for (unsigned shift = 0; shift < 64 && cur < end; shift += 7)
+            {
+                const uint8_t b = *cur++;
+                val |= (uint64_t)(b & 0x7fU) << shift;
+                if (!(b & 0x80U))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool tag(uint32_t &field, uint32_t &wireType)
+        {
+            uint64_t val;
+            if (!varint(val))
+            {
+                return false;
+            }
+            field = (uint32_t)(val >> 3U);
+            wireType = (uint32_t)(val & 7U);
+            return field != 0;
+        }
+
+        bool bytes(std::string_view &val)
+        {
+            uint64_t len;
+            if (!varint(len) || len > (uint64_t)(end - cur))
+            {
+                return false;
+            }
+            val = std::string_view((const char *)cur, (size_t)len);
+            cur += len;
+            return true;
+        }
+
+        // Protobuf fixed values are little-endian, as are all the platforms we run on
+        template <typename T> bool fixed(T &val)
+        {
+            if ((size_t)(end - cur) < sizeof(T))
+            {
+                return false;
+            }
+            memcpy(&val, cur, sizeof(T));
+            cur += sizeof(T);
+            return true;
+        }
+
+        bool skip(uint32_t wireType)
+        {
+            uint64_t dummy;
+            std::string_view dummyBytes;
+            switch (wireType)
+            {
+                case WireVarint:  return varint(dummy);
+                case WireFixed64: return skipBytes(8);
+                case WireBytes:   return bytes(dummyBytes);
+                case WireFixed32: return skipBytes(4);
+                default:          return false;     // groups are not used in vector tiles
+            }
+        }
+
+        bool skipBytes(size_t len)
+        {
+            if ((size_t)(end - cur) < len)
+            {
+                return false;
+            }
+            cur += len;
+            return true;
+        }
 
+        // Repeated integers may be packed or not
+        bool uint32s(uint32_t wireType, std::vector<uint32_t> &vals)
+        {
+            uint64_t val;
+            if (wireType == WireVarint)
+            {
+                if (!varint(val))
+                {
+                    return false;
+                }
+                vals.push_back((uint32_t)val);
+                return true;
+            }
+            std::string_view packed;
+            return wireType == WireBytes && bytes(packed) && PBFReader(packed).packed(vals);
+        }
+
+        // Read the rest as packed integers
+        bool packed(std::vector<uint32_t> &vals)
+        {
+            uint64_t val;
+            while (!atEnd())
+            {
+                if (!varint(val))
+                {
+                    return false;
+                }
+                vals.push_back((uint32_t)val);
+            }
+            return true;
+        }
+
+        const uint8_t *cur;
+        const uint8_t *end;
+    };
+}
+
+// Buffers we hang on to between tiles
+struct VectorTilePBFParser::Scratch
+{
+    std::vector<std::string_view> layerKeys;
+    std::vector<SmallValue> layerValues;
+    std::vector<std::string_view> features;
+    std::vector<uint32_t> featureTags;
+    std::vector<uint32_t> featureGeometry;
+    SimpleIDUSet styleIDs;
+    // Interned layer keys and the layer's string values, copied into the arena when first used
+    std::vector<StringIdentity> layerKeyIDs;
+    std::vector<std::string_view> layerStrings;
+    std::vector<FlatAttr> attrs;
+    bool inUse = false;
+};
 
 VectorTilePBFParser::VectorTilePBFParser(
         VectorTileData *tileData,
@@ -111,28 +222,61 @@ VectorTilePBFParser::VectorTilePBFParser(
 
 bool VectorTilePBFParser::parse(const uint8_t* data, size_t length)
 {
-    _vector_tile_Tile tile = {
-        /* layer     */ { layerDecode, this },
-        /*extensions */ nullptr,
-    };
+    // Use this thread's scratch buffers, unless someone up the stack already is
+    static thread_local Scratch threadScratch;
+    std::unique_ptr<Scratch> localScratch;
+    if (threadScratch.inUse)
+    {
+        localScratch = std::make_unique<Scratch>();
+        _scratch = localScratch.get();
+    }
+    else
+    {
+        _scratch = &threadScratch;
+    }
+    _scratch->inUse = true;
 
-    auto stream = pb_istream_from_buffer(data, length);
-    if (!pb_decode(&stream, vector_tile_Tile_fields, &tile))
+    // Tile contains a collection of Layers
+    bool ok = true;
+    PBFReader reader(data, length);
+    while (ok && !reader.atEnd())
     {
-        _parseError = stream.errmsg ? stream.errmsg : std::string();
-        return false;
+        uint32_t field, wireType;
+        if (!reader.tag(field, wireType))
+        {
+            _parseError = "invalid tag";
+            ok = false;
+            break;
+        }
+        if (field == TileLayerField && wireType == WireBytes)
+        {
+            std::string_view layerData;
+            if (!reader.bytes(layerData))
+            {
+                _parseError = "truncated layer";
+                ok = false;
+            }
+            else
+            {
+                ok = parseLayer(layerData);
+            }
+        }
+        else if (!reader.skip(wireType))
+        {
+            _parseError = "invalid field";
+            ok = false;
+        }
     }
 
-    return true;
-}
+    _scratch->layerStrings.clear();
+    _scratch->attrs.clear();
+    _scratch->inUse = false;
+    _scratch = nullptr;
 
-// Tile contains a collection of Layers
-bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg)
-{
-    return (*(This**)arg)->layerDecode(stream, field);
+    return ok;
 }
 
-bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_t *field)
+bool VectorTilePBFParser::parseLayer(std::string_view layerData)
 {
     if (_checkCancelled(_styleInst))
     {
@@ -140,41 +284,69 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
         return false;
     }
 
-    vector_tile_Tile_Layer layer = _defaultLayer;
-    std::string_view layerNameView;
+    auto &scratch = *_scratch;
+    scratch.layerKeys.clear();
+    scratch.layerValues.clear();
+    scratch.features.clear();
 
-    layer.name.arg = &layerNameView;
-    layer.features.arg = this;
-    layer.keys.arg = &_layerKeys;
-    layer.values.arg = &_layerValues;
-
-    const auto layerBytes = (uint32_t)stream->bytes_left;
-    _layerKeys.clear();
-    _layerKeys.reserve(layerKeyHeuristic(layerBytes));
-    _layerValues.clear();
-    _layerValues.reserve(layerValueHeuristic(layerBytes));
-    _featureTags.clear();
-    _featureTags.reserve(featureTagHeuristic(layerBytes));
-    _featureGeometry.clear();
-    _featureGeometry.reserve(featureGeometryHeuristic(layerBytes));
-    _features.clear();
-    _features.reserve(featureHeuristic(layerBytes));
-
-    if (!pb_decode(stream, vector_tile_Tile_Layer_fields, &layer))
+    // Just collect views of everything, features are decoded later if we want them
+    std::string_view layerNameView;
+    uint64_t extent = DefaultExtent;
+    PBFReader reader(layerData);
+    while (!reader.atEnd())
     {
-        return false;
+        uint32_t field, wireType;
+        if (!reader.tag(field, wireType))
+        {
+            _parseError = "invalid layer tag";
+            return false;
+        }
+
+        bool ok = true;
+        std::string_view bytes;
+        switch (wireType == WireBytes ? field : 0)
+        {
+            case LayerNameField:
+                ok = reader.bytes(layerNameView);
+                break;
+            case LayerFeatureField:
+                ok = reader.bytes(bytes);
+                scratch.features.push_back(bytes);
+                break;
+            case LayerKeyField:
+                ok = reader.bytes(bytes);
+                scratch.layerKeys.push_back(bytes);
+                break;
+            case LayerValueField:
+                ok = reader.bytes(bytes) && parseValue(bytes, scratch.layerValues);
+                break;
+            default:
+                if (field == LayerExtentField && wireType == WireVarint)
+                {
+                    ok = reader.varint(extent);
+                }
+                else
+                {
+                    ok = reader.skip(wireType);
+                }
+                break;
+        }
+        if (!ok)
+        {
+            _parseError = "invalid layer field";
+            return false;
+        }
     }
 
     auto layerName = std::string(layerNameView);
 
-    // When `has_extent` is false, nanopb sets the default in `extent`
-    _layerScale = (double)layer.extent / TileSize;
+    _layerScale = (double)extent / TileSize;
 
     // Prevent a divide-by-zero, or negative scales
     if (_layerScale <= 0)
     {
         wkLogLevel(Warn, "VectorTilePBFParser: Invalid layer extent (%s / %d / %d)",
-                   layerName.c_str(), layer.extent, TileSize);
+                   layerName.c_str(), (int)extent, TileSize);
         _skippedLayerCount += 1;
         return true;
     }
@@ -202,9 +374,29 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
         return true;
     }
 
-    size_t prevTagIndex = 0;
-    size_t prevGeomIndex = 0;
-    for (auto const &feature : _features)
+    // Intern the keys once per layer.  Strings go into the arena the first time they're used.
+    static const StringIdentity layerNameKeyID = StringIndexer::getStringID(layerNameKey);
+    static const StringIdentity geometryTypeKeyID = StringIndexer::getStringID(geometryTypeKey);
+    static const StringIdentity layerOrderKeyID = StringIndexer::getStringID(layerOrderKey);
+    const auto &arena = _tileData->attrArena;
+    const auto layerNameStr = arena->internString(layerName);
+    scratch.layerKeyIDs.resize(scratch.layerKeys.size());
+    for (size_t ii=0;ii<scratch.layerKeys.size();ii++)
+    {
+        scratch.layerKeyIDs[ii] = StringIndexer::getStringID(scratch.layerKeys[ii]);
+    }
+    scratch.layerStrings.assign(scratch.layerValues.size(), std::string_view());
+
+    // The attributes are filled in here to check the styles and only copied out
+    //  for the features we keep.
+    auto &attrs = scratch.attrs;
+    auto &styleIDs = scratch.styleIDs;
+    if (styleIDs.bucket_count() < featureStyleHeuristic())
+    {
+        styleIDs.reserve(featureStyleHeuristic());
+    }
+
+    for (const auto &featureData : scratch.features)
     {
         if (_checkCancelled(_styleInst))
         {
@@ -212,26 +404,34 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
             return false;
         }
 
-        auto attributes = std::make_shared<MutableDictionaryC>();
-        attributes->setString(layerNameKey, layerName);
-        attributes->setInt(geometryTypeKey, (int)feature.geomType);
-        attributes->setInt(layerOrderKey, (int)_layerCount);
+        MapnikGeometryType geomType = GeomTypeUnknown;
+        std::string_view geomData;
+        if (!parseFeature(featureData, geomType, geomData))
+        {
+            _parseError = "invalid feature";
+            return false;
+        }
 
-        const bool tagsOk = processTags(attributes, prevTagIndex, prevGeomIndex, feature);
-        //const auto curTagIndex = prevTagIndex;
-        const auto curGeomIndex = prevGeomIndex;
-        const auto curGeomCount = feature.geomIndex - prevGeomIndex;
-        prevTagIndex = feature.tagIndex;
-        prevGeomIndex = feature.geomIndex;
-        
-        if (!tagsOk)
+        // Reject on the raw values, if we can
+        if (!checkUUID())
+        {
+            _skippedFeatureCount += 1;
+            continue;
+        }
+
+        attrs.clear();
+        attrs.emplace_back(layerNameKeyID, layerNameStr);
+        attrs.emplace_back(geometryTypeKeyID, (int)geomType);
+        attrs.emplace_back(layerOrderKeyID, (int)_layerCount);
+
+        if (!processTags(attrs))
         {
             _skippedFeatureCount += 1;
             continue;
         }
 
-        SimpleIDUSet styleIDs(featureStyleHeuristic());
-        if (!checkStyles(styleIDs, attributes, layerName))
+        styleIDs.clear();
+        if (!checkStyles(styleIDs, FlatDictionary(AttrArenaRef(), attrs.data(), attrs.size()), layerName))
         {
             // Skip this feature
             _skippedFeatureCount += 1;
@@ -240,20 +440,28 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
 
         _featureCount += 1;
 
+        if (!decodeGeometry(geomData))
+        {
+            _parseError = "invalid feature geometry";
+            return false;
+        }
+        const uint32_t *geom = scratch.featureGeometry.data();
+        const size_t geomCount = scratch.featureGeometry.size();
+
         auto vecObj = std::make_shared<VectorObject>();
 
         // Parse geometry
         try
         {
-            switch (feature.geomType)
+            switch (geomType)
             {
                 case GeomTypeLineString:
-                    parseLineString(&_featureGeometry[curGeomIndex], curGeomCount, vecObj->shapes);
+                    parseLineString(geom, geomCount, vecObj->shapes);
                     break;
                 case GeomTypePolygon:
                 {
                     auto shape = VectorAreal::createAreal();
-                    if (parsePolygon(&_featureGeometry[curGeomIndex], curGeomCount, *shape))
+                    if (parsePolygon(geom, geomCount, *shape))
                     {
                         vecObj->shapes.insert(shape);
                     }
@@ -262,7 +470,7 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
                 case GeomTypePoint:
                 {
                     auto shape = VectorPoints::createPoints();
-                    if (parsePoints(&_featureGeometry[curGeomIndex], curGeomCount, *shape))
+                    if (parsePoints(geom, geomCount, *shape))
                     {
                         vecObj->shapes.insert(shape);
                     }
@@ -271,7 +479,7 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
                 default:
                 case GeomTypeUnknown:
 #if DEBUG
-                    wkLogLevel(Warn, "VectorTilePBFParser: Unknown geometry type %d", feature.geomType);
+                    wkLogLevel(Warn, "VectorTilePBFParser: Unknown geometry type %d", geomType);
 #endif
                     _unknownGeomTypes += 1;
                     break;
@@ -281,18 +489,25 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
         {
             wkLogLevel(Error, "VectorTilePBFParser: Vector Parsing Error: %s", ex.what());
             _parseErrors += 1;
-            vecObj.reset();
+            continue;
         }
         catch (...)
         {
             wkLogLevel(Error, "VectorTilePBFParser: Vector Parsing Error: ?");   // Bad, don't throw non-exceptions!
             _parseErrors += 1;
-            vecObj.reset();
+            continue;
         }
 
+        if (vecObj->shapes.empty())
+        {
+            continue;
+        }
+
+        // Now it's worth making a real copy of the attributes.  The strings are already in the arena.
+        const auto featAttrs = FlatDictionary::Make(arena, attrs.data(), attrs.size(), false);
         for (const auto &shape: vecObj->shapes)
         {
-            shape->setAttrDict(attributes);
+            shape->setAttrDict(featAttrs);
         }
 
         addFeature(vecObj, styleIDs);
@@ -315,65 +530,191 @@ std::pair<uint8_t, int32_t> VectorTilePBFParser::decodeCommand(int32_t c) {
     return std::make_pair(c & ((1 << CmdBits) - 1), c >> CmdBits);  //NOLINT these are right out of the spec
 }
 
-// Layer contains a collection of Features
-bool VectorTilePBFParser::featureDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg)
+// Feature has tags, a type, and geometry.  We decode the tags and hang on to the geometry.
+bool VectorTilePBFParser::parseFeature(std::string_view featureData, MapnikGeometryType &geomType, std::string_view &geomData)
 {
-    return (*(This**)arg)->featureDecode(stream, field);
+    auto &tags = _scratch->featureTags;
+    tags.clear();
+
+    PBFReader reader(featureData);
+    while (!reader.atEnd())
+    {
+        uint32_t field, wireType;
+        if (!reader.tag(field, wireType))
+        {
+            return false;
+        }
+
+        bool ok;
+        uint64_t val;
+        switch (field)
+        {
+            case FeatureTagsField:
+                ok = reader.uint32s(wireType, tags);
+                break;
+            case FeatureTypeField:
+                ok = (wireType == WireVarint) ? reader.varint(val) : reader.skip(wireType);
+                if (ok && wireType == WireVarint)
+                {
+                    geomType = static_cast<MapnikGeometryType>(val);
+                }
+                break;
+            case FeatureGeometryField:
+                ok = (wireType == WireBytes) ? reader.bytes(geomData) : reader.skip(wireType);
+                break;
+            default:
+                ok = reader.skip(wireType);
+                break;
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
-bool VectorTilePBFParser::featureDecode(pb_istream_t *stream, const pb_field_iter_t *field)
+// Geometry is a packed list of command and parameter integers
+bool VectorTilePBFParser::decodeGeometry(std::string_view geomData)
 {
-    auto feature = _defaultFeature;
-    feature.tags.arg = &_featureTags;
-    feature.geometry.arg = &_featureGeometry;
+    auto &geom = _scratch->featureGeometry;
+    geom.clear();
+    geom.reserve(geomData.size());
+    return PBFReader(geomData).packed(geom);
+}
 
-    if (!pb_decode(stream, vector_tile_Tile_Feature_fields, &feature))
+// Layer contains a collection of Values
+bool VectorTilePBFParser::parseValue(std::string_view valueData, std::vector<SmallValue> &vec)
+{
+    std::string_view string;
+    bool hasFloat = false, hasDouble = false, hasInt = false, hasUInt = false, hasSInt = false, hasBool = false;
+    float floatValue = 0.0f;
+    double doubleValue = 0.0;
+    uint64_t intValue = 0, uintValue = 0, sintValue = 0, boolValue = 0;
+
+    PBFReader reader(valueData);
+    while (!reader.atEnd())
     {
-        return false;
+        uint32_t field, wireType;
+        if (!reader.tag(field, wireType))
+        {
+            return false;
+        }
+
+        bool ok;
+        switch ((field << 3U) | wireType)
+        {
+            case (ValueStringField << 3U) | WireBytes:  ok = reader.bytes(string); break;
+            case (ValueFloatField << 3U) | WireFixed32: ok = hasFloat = reader.fixed(floatValue); break;
+            case (ValueDoubleField << 3U) | WireFixed64:ok = hasDouble = reader.fixed(doubleValue); break;
+            case (ValueIntField << 3U) | WireVarint:    ok = hasInt = reader.varint(intValue); break;
+            case (ValueUIntField << 3U) | WireVarint:   ok = hasUInt = reader.varint(uintValue); break;
+            case (ValueSIntField << 3U) | WireVarint:   ok = hasSInt = reader.varint(sintValue); break;
+            case (ValueBoolField << 3U) | WireVarint:   ok = hasBool = reader.varint(boolValue); break;
+            default:                                    ok = reader.skip(wireType); break;
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+
+    const auto sint = (int64_t)((sintValue >> 1U) ^ -(sintValue & 1U));   //NOLINT zigzag
+
+         if (hasFloat)  vec.push_back({{.floatValue  = floatValue},          SmallValue::SmallValFloat});
+    else if (hasDouble) vec.push_back({{.doubleValue = doubleValue},         SmallValue::SmallValDouble});  //NOLINT
+    else if (hasInt)    vec.push_back({{.intValue    = (int64_t)intValue},   SmallValue::SmallValInt});     //NOLINT
+    else if (hasUInt)   vec.push_back({{.uintValue   = uintValue},           SmallValue::SmallValUInt});    //NOLINT
+    else if (hasSInt)   vec.push_back({{.sintValue   = sint},                SmallValue::SmallValSInt});    //NOLINT
+    else if (hasBool)   vec.push_back({{.boolValue   = (boolValue != 0)},    SmallValue::SmallValBool});    //NOLINT
+    else                vec.push_back({{.stringValue = string},              SmallValue::SmallValString});  //NOLINT
+
+    return true;
+}
+
+// Check the uuid filter against the raw tags, before we build any attributes.
+// The dictionary-based check in checkStyles still applies to anything we can't decide here.
+bool VectorTilePBFParser::checkUUID() const
+{
+    if (_uuidName.empty() || _uuidName == layerNameKey ||
+        _uuidName == geometryTypeKey || _uuidName == layerOrderKey)
+    {
+        return true;
     }
 
-    const auto geomType = static_cast<MapnikGeometryType>(feature.type);
-    _features.emplace_back(_featureTags.size(),_featureGeometry.size(),geomType);
+    const auto &tags = _scratch->featureTags;
+    const auto &keys = _scratch->layerKeys;
+    const auto &values = _scratch->layerValues;
+    const SmallValue *found = nullptr;
+    for (size_t m = 0; m + 1 < tags.size(); m += 2)
+    {
+        if (tags[m] < keys.size() && tags[m + 1] < values.size() && keys[tags[m]] == _uuidName)
+        {
+            // Later values win, as with the dictionary
+            found = &values[tags[m + 1]];
+        }
+    }
 
+    if (!found)
+    {
+        return _uuidValues.find(std::string()) != _uuidValues.end();
+    }
+    if (found->type == SmallValue::SmallValString)
+    {
+        return _uuidValues.find(std::string(found->stringValue)) != _uuidValues.end();
+    }
     return true;
 }
 
-bool VectorTilePBFParser::processTags(const MutableDictionaryCRef &attributes, size_t tagIdx, size_t geomIdx, const Feature &feature)
+bool VectorTilePBFParser::processTags(std::vector<FlatAttr> &attrs)
 {
-    const auto tagCount = feature.tagIndex - tagIdx;
-    if (tagCount % 2 != 0)
+    const auto &tags = _scratch->featureTags;
+    const auto &keys = _scratch->layerKeys;
+    const auto &keyIDs = _scratch->layerKeyIDs;
+    const auto &values = _scratch->layerValues;
+    auto &strings = _scratch->layerStrings;
+
+    if (tags.size() % 2 != 0)
     {
         wkLogLevel(Warn, "VectorTilePBFParser: Odd feature tags!");
     }
 
-    for (size_t m = tagIdx; m + 1 < feature.tagIndex; m += 2)
+    for (size_t m = 0; m + 1 < tags.size(); m += 2)
     {
-        const auto keyIndex = _featureTags[m];
-        const auto valueIndex = _featureTags[m + 1];
+        const auto keyIndex = tags[m];
+        const auto valueIndex = tags[m + 1];
 
-        if (keyIndex >= _layerKeys.size() || valueIndex >= _layerValues.size()) {
-            wkLogLevel(Warn, "VectorTilePBFParser: Invalid feature tag %d/%d (%d/%d)", keyIndex, valueIndex, (int)_layerKeys.size(), (int)_layerValues.size());
+        if (keyIndex >= keys.size() || valueIndex >= values.size()) {
+            wkLogLevel(Warn, "VectorTilePBFParser: Invalid feature tag %d/%d (%d/%d)", keyIndex, valueIndex, (int)keys.size(), (int)values.size());
             _badAttributes += 1;
             continue;
         }
 
-        const auto &key = _layerKeys[keyIndex];
+        const auto &key = keys[keyIndex];
         if (key.empty()) {
             continue;
         }
 
-        // TODO: We don't really need transient string allocations here
-        const auto skey = std::string(key);
+        const auto skey = keyIDs[keyIndex];
 
-        const auto &value = _layerValues[valueIndex];
+        const auto &value = values[valueIndex];
         switch (value.type) {
-            case SmallValue::SmallValString: attributes->setString(skey, std::string(value.stringValue)); break;
-            case SmallValue::SmallValFloat:  attributes->setDouble(skey, value.floatValue); break;
-            case SmallValue::SmallValDouble: attributes->setDouble(skey, value.doubleValue); break;
-            case SmallValue::SmallValInt:    attributes->setInt(skey, value.intValue); break;
-            case SmallValue::SmallValUInt:   attributes->setInt(skey, (int)value.uintValue); break;
-            case SmallValue::SmallValSInt:   attributes->setInt(skey, (int)value.sintValue); break;
-            case SmallValue::SmallValBool:   attributes->setInt(skey, (int)value.boolValue); break;
+            case SmallValue::SmallValString:
+            {
+                auto &str = strings[valueIndex];
+                if (!str.data())
+                {
+                    str = _tileData->attrArena->internString(value.stringValue);
+                }
+                FlatDictionary::AddAttr(attrs, FlatAttr(skey, str));
+                break;
+            }
+            case SmallValue::SmallValFloat:  FlatDictionary::AddAttr(attrs, FlatAttr(skey, (double)value.floatValue)); break;
+            case SmallValue::SmallValDouble: FlatDictionary::AddAttr(attrs, FlatAttr(skey, value.doubleValue)); break;
+            case SmallValue::SmallValInt:    FlatDictionary::AddAttr(attrs, FlatAttr(skey, (int)value.intValue)); break;
+            case SmallValue::SmallValUInt:   FlatDictionary::AddAttr(attrs, FlatAttr(skey, (int)value.uintValue)); break;
+            case SmallValue::SmallValSInt:   FlatDictionary::AddAttr(attrs, FlatAttr(skey, (int)value.sintValue)); break;
+            case SmallValue::SmallValBool:   FlatDictionary::AddAttr(attrs, FlatAttr(skey, (int)value.boolValue)); break;
             default:
             case SmallValue::SmallValNone:
                 _unknownValueTypes += 1;
@@ -385,7 +726,7 @@ bool VectorTilePBFParser::processTags(const MutableDictionaryCRef &attributes, s
     return true;
 }
 
-bool VectorTilePBFParser::checkStyles(SimpleIDUSet& styleIDs, const MutableDictionaryCRef &attributes, const std::string &layerName)
+bool VectorTilePBFParser::checkStyles(SimpleIDUSet& styleIDs, const Dictionary &attributes, const std::string &layerName)
 {
     // Ask for the styles that correspond to this feature
     // If there are none, we can skip this.
@@ -393,7 +734,7 @@ bool VectorTilePBFParser::checkStyles(SimpleIDUSet& styleIDs, const MutableDicti
     // Do a quick inclusion check
     if (!_uuidName.empty())
     {
-        std::string uuidVal = attributes->getString(_uuidName); // TODO: extra string copy
+        std::string uuidVal = attributes.getString(_uuidName); // TODO: extra string copy
         if (_uuidValues.find(uuidVal) == _uuidValues.end())
         {
             // Skip this feature
@@ -402,7 +743,7 @@ bool VectorTilePBFParser::checkStyles(SimpleIDUSet& styleIDs, const MutableDicti
     }
     
     // TODO: populate a reused vector?
-    const auto styles = _styleDelegate->stylesForFeature(_styleInst, *attributes, _tileData->ident, layerName);
+    const auto styles = _styleDelegate->stylesForFeature(_styleInst, attributes, _tileData->ident, layerName);
     for (const auto &style : styles)
     {
         styleIDs.insert(style->getUuid(_styleInst));
@@ -663,65 +1004,4 @@ void VectorTilePBFParser::addFeature(const VectorObjectRef &vecObj, const Simple
     }
 }
     
-// Layer contains a collection of Values
-bool VectorTilePBFParser::valueVecDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg) {
-    auto &vec = **(std::vector<SmallValue>**)arg;
-    
-    std::string_view string;
-    vector_tile_Tile_Value value = vector_tile_Tile_Value_init_zero;
-    value.string_value.funcs.decode = &stringDecode;
-    value.string_value.arg = &string;
-
-    if (!pb_decode(stream, vector_tile_Tile_Value_fields, &value))
-    {
-        return false;
-    }
-
-         if (value.has_float_value)  vec.push_back({{.floatValue  = value.float_value},  SmallValue::SmallValFloat});
-    else if (value.has_double_value) vec.push_back({{.doubleValue = value.double_value}, SmallValue::SmallValDouble});  //NOLINT
-    else if (value.has_int_value)    vec.push_back({{.intValue    = value.int_value},    SmallValue::SmallValInt});     //NOLINT
-    else if (value.has_uint_value)   vec.push_back({{.uintValue   = value.uint_value},   SmallValue::SmallValUInt});    //NOLINT
-    else if (value.has_sint_value)   vec.push_back({{.sintValue   = value.sint_value},   SmallValue::SmallValSInt});    //NOLINT
-    else if (value.has_bool_value)   vec.push_back({{.boolValue   = value.bool_value},   SmallValue::SmallValBool});    //NOLINT
-    else                             vec.push_back({{.stringValue = string},             SmallValue::SmallValString});  //NOLINT
-
-    return true;
-}
-
-// Decode a string into a variable
-bool VectorTilePBFParser::stringDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg)
-{
-    *((std::string_view*)*arg) = std::string_view((char*)stream->state, stream->bytes_left);
-    return true;
-}
-
-// Decode a single string into a vector
-bool VectorTilePBFParser::stringVecDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg)
-{
-    auto &vec = **(std::vector<std::string_view>**)arg;
-    vec.emplace_back((char*)stream->state, stream->bytes_left);
-    return true;
-}
-
-// Decode a repeated-integer into a vector
-bool VectorTilePBFParser::intVecDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg)
-{
-    auto &vec = **(std::vector<uint32_t>**)arg;
-    if (vec.empty())
-    {
-        vec.reserve(vec.size() + stream->bytes_left);
-    }
-    while (stream->bytes_left)
-    {
-        uint64_t value;
-        if (!pb_decode_varint(stream, &value))
-        {
-            return false;
-        }
-        vec.push_back((uint32_t)value);
-    }
-    return true;
-}
-
 }   // namespace WhirlyKit
-
@@ -664,18 +664,18 @@ public:
             }
         } else {
             // Basic mode builds up a lot more geometry
-            int ptGuess = std::min(std::max(ptCount,0),(int)MaxDrawablePoints);
-            int triGuess = std::min(std::max(triCount,0),(int)MaxDrawableTriangles);
+            int ptGuess = std::min(std::max(ptCount,0),(int)sceneRender->getMaxDrawablePoints());
+            int triGuess = std::min(std::max(triCount,0),(int)sceneRender->getMaxDrawableTriangles());
 
             if (!drawable ||
-                (drawable->getNumPoints()+ptGuess > MaxDrawablePoints) ||
-                (drawable->getNumTris()+triGuess > MaxDrawableTriangles))
+                (drawable->getNumPoints()+ptGuess > sceneRender->getMaxDrawablePoints()) ||
+                (drawable->getNumTris()+triGuess > sceneRender->getMaxDrawableTriangles()))
             {
                 flush();
                 
     //            NSLog(@"Pts = %d, tris = %d",ptGuess,triGuess);
-                int ptAlloc = std::min(std::max(ptCountAllocate,0),(int)MaxDrawablePoints);
-                int triAlloc = std::min(std::max(triCountAllocate,0),(int)MaxDrawableTriangles);
+                int ptAlloc = std::min(std::max(ptCountAllocate,0),(int)sceneRender->getMaxDrawablePoints());
+                int triAlloc = std::min(std::max(triCountAllocate,0),(int)sceneRender->getMaxDrawableTriangles());
                 WideVectorDrawableBuilderRef wideDrawable = sceneRender->makeWideVectorDrawableBuilder("Wide Vector");
                 wideDrawable->Init(ptAlloc,triAlloc,0,
                                    vecInfo->implType,
@@ -775,14 +775,14 @@ public:
                 drawable->addTriangle(BasicDrawable::Triangle(8,10,11));
             }
             
+            // Get the points in display space all at once
+            geoToDisplay(newPts,false);
+
             // Run through the points, adding centerline instances
             double len = 0.0;
             int startPt = drawable->getCenterLineCount();
             for (unsigned int ii=0;ii<newPts.size();ii++) {
-                const auto &pt = newPts[ii];
-
-                Point3d localPa = coordSys->geographicToLocal3d(GeoCoord(pt.x(),pt.y()));
-                Point3d dispPa = coordAdapter->localToDisplay(localPa);
+                const Point3d &dispPa = dispPts[ii];
 
                 int prev = startPt + ii - 1;
                 if (ii == 0) {
@@ -835,22 +835,23 @@ public:
             if (totalTriCount < 0)  totalTriCount = 0;
             if (totalPtCount < 0)  totalPtCount = 0;
             
+            // Get the points in display space all at once
+            const bool doNorms = !coordAdapter->isFlat();
+            geoToDisplay(pts,doNorms);
+
             // Work through the segments
             Point2f lastPt;
             bool validLastPt = false;
             for (int ii=startPoint;ii<(int)pts.size();ii++)
             {
-                // Get the points in display space
-                Point2f geoA = pts[(ii+pts.size())%pts.size()];
+                const unsigned int which = (ii+pts.size())%pts.size();
+                Point2f geoA = pts[which];
                 
                 if (validLastPt && geoA == lastPt)
                     continue;
 
-                Point3d localPa = coordSys->geographicToLocal3d(GeoCoord(geoA.x(),geoA.y()));
-                Point3d dispPa = coordAdapter->localToDisplay(localPa);
-                Point3d thisUp = up;
-                if (!coordAdapter->isFlat())
-                    thisUp = coordAdapter->normalForLocal(localPa);
+                const Point3d &dispPa = dispPts[which];
+                const Point3d &thisUp = doNorms ? normPts[which] : up;
                 
                 // Get a drawable ready
                 int triCount = 2+3;
@@ -955,6 +956,17 @@ protected:
         drawable = nullptr;
     }
 
+    // Convert a run of geo points to display space (and normals, if asked) in one go
+    void geoToDisplay(const VectorRing &pts,bool doNorms)
+    {
+        geoPts.resize(pts.size());
+        dispPts.resize(pts.size());
+        normPts.resize(doNorms ? pts.size() : 0);
+        for (unsigned int ii=0;ii<pts.size();ii++)
+            geoPts[ii] = Point2d(pts[ii].x(),pts[ii].y());
+        coordAdapter->geographicToDisplay(geoPts.data(),dispPts.data(),doNorms ? normPts.data() : nullptr,pts.size());
+    }
+
     bool centerValid;
     int numMaskIDs;
     std::vector<SimpleIdentity> maskEntries;
@@ -967,6 +979,9 @@ protected:
     const WideVectorInfo *vecInfo;
     WideVectorDrawableBuilderRef drawable;
     std::vector<WideVectorDrawableBuilderRef> drawables;
+    // Scratch space for converting coordinates
+    std::vector<Point2d> geoPts;
+    std::vector<Point3d> dispPts,normPts;
 };
     
 WideVectorSceneRep::WideVectorSceneRep()
@@ -0,0 +1,211 @@
+//
+//  CoordSystemTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <vector>
+#import "GlobeMath.h"
+#import "FlatMath.h"
+#import "SphericalMercator.h"
+#import "Proj4CoordSystem.h"
+#import "Platform.h"
+
+using namespace WhirlyKit;
+
+// Same as the web mercator layers use
+static const char *MercatorProj4 = "+proj=merc +a=6378137 +b=6378137 +lat_ts=0.0 +lon_0=0.0 +x_0=0.0 +y_0=0 +k=1.0 +units=m +nadgrids=@null +wktext +no_defs";
+
+// Vertex grids for a run of tiles, in radians, the way the builders see them
+static std::vector<Point2d> MakeGeoPoints(size_t numPoints)
+{
+    std::vector<Point2d> pts(numPoints);
+    const size_t gridSize = 17;
+    for (size_t ii=0;ii<numPoints;ii++)
+    {
+        const size_t tile = ii / (gridSize*gridSize), vert = ii % (gridSize*gridSize);
+        const double tileLon = -M_PI + (tile % 64) * 2.0 * M_PI / 64, tileLat = -1.3 + (tile / 64 % 64) * 2.6 / 64;
+        pts[ii] = Point2d(tileLon + (vert % gridSize) * 2.0 * M_PI / 64 / (gridSize-1),
+                          tileLat + (vert / gridSize) * 2.6 / 64 / (gridSize-1));
+    }
+    return pts;
+}
+
+// Geographic to display coordinates and normals a point at a time, as the builders used to
+static void GeographicToDisplayPerPoint(CoordSystemDisplayAdapter *adapter,const std::vector<Point2d> &geo,
+                                        std::vector<Point3d> &disp,std::vector<Point3d> &norms)
+{
+    CoordSystem *coordSys = adapter->getCoordSystem();
+    for (size_t ii=0;ii<geo.size();ii++)
+    {
+        const Point3d local = coordSys->geographicToLocal(geo[ii]);
+        norms[ii] = adapter->normalForLocal(local);
+        disp[ii] = adapter->localToDisplay(local);
+    }
+}
+
+// Per vertex cost of the two approaches, in nanoseconds
+static void TimeGeographicToDisplay(CoordSystemDisplayAdapter *adapter,const std::vector<Point2d> &geo,double &perPoint,double &batch)
+{
+    std::vector<Point3d> disp(geo.size()), norms(geo.size());
+
+    TimeInterval startTime = TimeGetCurrent();
+    GeographicToDisplayPerPoint(adapter, geo, disp, norms);
+    perPoint = (TimeGetCurrent() - startTime) * 1e9 / geo.size();
+
+    startTime = TimeGetCurrent();
+    adapter->geographicToDisplay(geo.data(), disp.data(), norms.data(), geo.size());
+    batch = (TimeGetCurrent() - startTime) * 1e9 / geo.size();
+}
+
+// Within the given relative distance of each other
+static bool PointsMatch(const std::vector<Point3d> &a,const std::vector<Point3d> &b,double tol)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t ii=0;ii<a.size();ii++)
+        if ((a[ii] - b[ii]).norm() > tol * std::max(1.0,b[ii].norm()))
+            return false;
+    return true;
+}
+
+@interface CoordSystemTests : XCTestCase
+
+@end
+
+@implementation CoordSystemTests
+{
+    std::vector<Point2d> geoPts;
+}
+
+- (void)setUp {
+    geoPts = MakeGeoPoints(100000);
+}
+
+// The batch chain has to come out the same as doing it a point at a time
+- (void)checkAdapter:(CoordSystemDisplayAdapter *)adapter {
+    std::vector<Point3d> disp(geoPts.size()), norms(geoPts.size());
+    GeographicToDisplayPerPoint(adapter, geoPts, disp, norms);
+
+    std::vector<Point3d> batchDisp(geoPts.size()), batchNorms(geoPts.size());
+    adapter->geographicToDisplay(geoPts.data(), batchDisp.data(), batchNorms.data(), geoPts.size());
+    XCTAssertTrue(batchDisp == disp);
+    XCTAssertTrue(batchNorms == norms);
+}
+
+- (void)testFakeGeocentricBatch {
+    FakeGeocentricDisplayAdapter adapter;
+    [self checkAdapter:&adapter];
+}
+
+- (void)testSphericalMercatorBatch {
+    SphericalMercatorDisplayAdapter adapter(0.0, GeoCoord::CoordFromDegrees(-180.0,-85.0511), GeoCoord::CoordFromDegrees(180.0,85.0511));
+    [self checkAdapter:&adapter];
+}
+
+// Batch versions on the coordinate systems themselves, including in place and proj.4
+- (void)testCoordSystemBatch {
+    PlateCarreeCoordSystem plateCarree;
+    SphericalMercatorCoordSystem mercator;
+    GeoCoordSystem geoSys;
+    Proj4CoordSystem proj4(MercatorProj4);
+    XCTAssertTrue(proj4.isValid());
+
+    for (CoordSystem *coordSys : std::vector<CoordSystem *>{ &plateCarree, &mercator, &geoSys, &proj4 })
+    {
+        std::vector<Point3d> local(geoPts.size()), geoc(geoPts.size()), backLocal(geoPts.size());
+        for (size_t ii=0;ii<geoPts.size();ii++)
+        {
+            local[ii] = coordSys->geographicToLocal(geoPts[ii]);
+            geoc[ii] = coordSys->localToGeocentric(local[ii]);
+            backLocal[ii] = coordSys->geocentricToLocal(geoc[ii]);
+        }
+
+        std::vector<Point3d> batch(geoPts.size());
+        coordSys->geographicToLocal(geoPts.data(), batch.data(), geoPts.size());
+        XCTAssertTrue(PointsMatch(batch, local, 1e-12));
+        coordSys->localToGeocentric(batch.data(), batch.data(), batch.size());
+        XCTAssertTrue(PointsMatch(batch, geoc, 1e-12));
+        // The single point Mercator version goes through a float GeoCoord on the way back
+        coordSys->geocentricToLocal(batch.data(), batch.data(), batch.size());
+        XCTAssertTrue(PointsMatch(batch, backLocal, 1e-6));
+    }
+
+    // Mercator tiles going into a geographic scene
+    std::vector<Point3d> local(geoPts.size()), converted(geoPts.size());
+    mercator.geographicToLocal(geoPts.data(), local.data(), geoPts.size());
+    for (size_t ii=0;ii<local.size();ii++)
+        converted[ii] = CoordSystemConvert3d(&mercator, &geoSys, local[ii]);
+    CoordSystemConvert3d(&mercator, &geoSys, local.data(), local.data(), local.size());
+    XCTAssertTrue(local == converted);
+}
+
+- (void)testFakeGeocentricPerformance {
+    FakeGeocentricDisplayAdapter adapter;
+    [self measureBlock:^{
+        double perPoint, batch;
+        TimeGeographicToDisplay(&adapter, geoPts, perPoint, batch);
+        NSLog(@"Fake geocentric geographic to display with normals: %.1f ns/vertex per point, %.1f ns/vertex batched", perPoint, batch);
+    }];
+}
+
+- (void)testSphericalMercatorPerformance {
+    SphericalMercatorDisplayAdapter adapter(0.0, GeoCoord::CoordFromDegrees(-180.0,-85.0511), GeoCoord::CoordFromDegrees(180.0,85.0511));
+    [self measureBlock:^{
+        double perPoint, batch;
+        TimeGeographicToDisplay(&adapter, geoPts, perPoint, batch);
+        NSLog(@"Spherical Mercator geographic to display with normals: %.1f ns/vertex per point, %.1f ns/vertex batched", perPoint, batch);
+    }];
+}
+
+// Goes through proj.4, so the batch version is one pj_transform call
+- (void)testProj4Performance {
+    Proj4CoordSystem proj4(MercatorProj4);
+    [self measureBlock:^{
+        std::vector<Point3d> local(geoPts.size());
+        TimeInterval startTime = TimeGetCurrent();
+        for (size_t ii=0;ii<geoPts.size();ii++)
+            local[ii] = proj4.geographicToLocal(geoPts[ii]);
+        const double perPoint = (TimeGetCurrent() - startTime) * 1e9 / geoPts.size();
+
+        startTime = TimeGetCurrent();
+        proj4.geographicToLocal(geoPts.data(), local.data(), geoPts.size());
+        const double batch = (TimeGetCurrent() - startTime) * 1e9 / geoPts.size();
+        NSLog(@"Proj.4 geographic to local: %.1f ns/vertex per point, %.1f ns/vertex batched", perPoint, batch);
+    }];
+}
+
+// Mercator tiles going into a globe, through CoordSystemConvert3d
+- (void)testConvertPerformance {
+    SphericalMercatorCoordSystem mercator;
+    GeoCoordSystem geoSys;
+    std::vector<Point3d> local(geoPts.size());
+    mercator.geographicToLocal(geoPts.data(), local.data(), geoPts.size());
+    [self measureBlock:^{
+        std::vector<Point3d> out(local.size());
+        TimeInterval startTime = TimeGetCurrent();
+        for (size_t ii=0;ii<local.size();ii++)
+            out[ii] = CoordSystemConvert3d(&mercator, &geoSys, local[ii]);
+        const double perPoint = (TimeGetCurrent() - startTime) * 1e9 / local.size();
+
+        startTime = TimeGetCurrent();
+        CoordSystemConvert3d(&mercator, &geoSys, local.data(), out.data(), local.size());
+        const double batch = (TimeGetCurrent() - startTime) * 1e9 / local.size();
+        NSLog(@"Mercator to geographic convert: %.1f ns/vertex per point, %.1f ns/vertex batched", perPoint, batch);
+    }];
+}
+
+@end
@@ -0,0 +1,219 @@
+//
+//  DynamicTextureTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <deque>
+#import <unordered_map>
+#import <vector>
+#import "DynamicTextureAtlas.h"
+
+using namespace WhirlyKit;
+
+// Just the cell bookkeeping, nothing goes to a renderer
+class TestDynamicTexture : public DynamicTexture
+{
+public:
+    TestDynamicTexture()
+        : DynamicTexture("Test Dynamic Texture"), TextureBase("Test Dynamic Texture")
+    {
+        // Same as the font texture atlas
+        setup(2048, 16, TexTypeUnsignedByte, false);
+    }
+
+    virtual bool createInRenderer(const RenderSetupInfo *setupInfo) override { return true; }
+    virtual void destroyInRenderer(const RenderSetupInfo *setupInfo,Scene *scene) override { }
+    virtual void addTextureData(int startX,int startY,int width,int height,RawDataRef data) override { }
+    virtual void clearTextureData(int startX,int startY,int width,int height,ChangeSet &changes,bool mainThreadMerge,unsigned char *emptyData) override { }
+};
+
+// Allocate a glyph, or release one nothing uses any more
+struct GlyphEvent
+{
+    bool alloc;
+    int glyph;
+    int cellsX,cellsY;
+};
+
+// Glyph traffic from panning around a dense city.  Each tile brings in a batch of
+//  street, shop and place names in a few fonts and sizes, some of them in CJK.
+//  Glyphs are shared between labels and released once the last tile using them goes away.
+static std::vector<GlyphEvent> MakeGlyphTrace(int numTiles,int labelsPerTile,int tilesKept)
+{
+    unsigned int rand = 2468;
+    auto next = [&rand](unsigned int limit) { rand = rand * 1103515245u + 12345u;  return (rand >> 8) % limit; };
+
+    // Point sizes at 2x, for the various label classes
+    const int fontSizes[] = { 24, 28, 32, 36, 44, 56 };
+    const int numFonts = 4;
+    const int cellSize = 16;
+
+    std::vector<GlyphEvent> trace;
+    std::unordered_map<int,int> glyphRefs;
+    std::deque<std::vector<int>> liveTiles;
+    for (int ti=0;ti<numTiles;ti++)
+    {
+        std::vector<int> tileGlyphs;
+        for (int li=0;li<labelsPerTile;li++)
+        {
+            const int size = fontSizes[next(6) * next(6) / 6];
+            const int font = next(numFonts);
+            const bool cjk = next(8) == 0;
+            const int numChars = cjk ? 2 + next(6) : 6 + next(18);
+            for (int ci=0;ci<numChars;ci++)
+            {
+                // Latin text mostly reuses a few dozen characters, CJK draws on thousands
+                const int charCode = cjk ? 0x4e00 + next(2000) * next(2000) / 2000 : 'A' + next(70);
+                const int glyph = (charCode * 8 + font) * 64 + size;
+                if (glyphRefs[glyph]++ == 0)
+                {
+                    const int width = cjk ? size : size * (4 + (int)next(6)) / 10;
+                    trace.push_back({ true, glyph, (width + 4 + cellSize - 1) / cellSize, (size * 12 / 10 + 4 + cellSize - 1) / cellSize });
+                }
+                tileGlyphs.push_back(glyph);
+            }
+        }
+        liveTiles.push_back(std::move(tileGlyphs));
+
+        // Tiles scroll off the screen
+        if (liveTiles.size() > tilesKept)
+        {
+            for (int glyph : liveTiles.front())
+                if (--glyphRefs[glyph] == 0)
+                {
+                    trace.push_back({ false, glyph, 0, 0 });
+                    glyphRefs.erase(glyph);
+                }
+            liveTiles.pop_front();
+        }
+    }
+    return trace;
+}
+
+struct ReplayStats
+{
+    int numAllocs = 0, numFailed = 0;
+    int numCell = 0, usedCell = 0, holeCell = 0;
+    double findTime = 0.0;
+};
+
+// Run the trace against a texture the way the atlas would, timing findRegion
+static ReplayStats ReplayGlyphTrace(const std::vector<GlyphEvent> &trace)
+{
+    ReplayStats stats;
+    TestDynamicTexture tex;
+    std::unordered_map<int,DynamicTexture::Region> regions;
+    for (const auto &event : trace)
+    {
+        if (event.alloc)
+        {
+            DynamicTexture::Region region;
+            const TimeInterval startTime = TimeGetCurrent();
+            const bool found = tex.findRegion(event.cellsX, event.cellsY, region);
+            stats.findTime += TimeGetCurrent() - startTime;
+            stats.numAllocs++;
+            if (found)
+            {
+                tex.setRegion(region, true);
+                regions[event.glyph] = region;
+            } else
+                stats.numFailed++;
+        } else {
+            const auto it = regions.find(event.glyph);
+            if (it != regions.end())
+            {
+                tex.addRegionToClear(it->second);
+                regions.erase(it);
+            }
+        }
+    }
+    tex.getUtilization(stats.numCell, stats.usedCell, stats.holeCell);
+    return stats;
+}
+
+@interface DynamicTextureTests : XCTestCase
+
+@end
+
+@implementation DynamicTextureTests
+{
+    std::vector<GlyphEvent> trace;
+}
+
+- (void)setUp {
+    trace = MakeGlyphTrace(400, 60, 12);
+}
+
+- (void)tearDown {
+    trace.clear();
+}
+
+// Regions handed out never overlap, and released space gets reused
+- (void)testNoOverlap {
+    TestDynamicTexture tex;
+    std::vector<DynamicTexture::Region> regions;
+    std::vector<bool> used(128*128, false);
+    bool overlap = false;
+    for (int ii=0;ii<600;ii++)
+    {
+        DynamicTexture::Region region;
+        if (!tex.findRegion(1 + ii % 3, 2 + ii % 2, region))
+            break;
+        XCTAssertEqual(region.ex - region.sx + 1, 1 + ii % 3);
+        XCTAssertEqual(region.ey - region.sy + 1, 2 + ii % 2);
+        for (int iy=region.sy;iy<=region.ey;iy++)
+            for (int ix=region.sx;ix<=region.ex;ix++)
+            {
+                overlap |= used[iy*128+ix];
+                used[iy*128+ix] = true;
+            }
+        tex.setRegion(region, true);
+        regions.push_back(region);
+    }
+    XCTAssertFalse(overlap);
+
+    int numCell, usedCell, holeCell;
+    tex.getUtilization(numCell, usedCell, holeCell);
+    const int usedBefore = usedCell;
+
+    // Free one in the middle and there's room for the same size again, without overlap
+    const DynamicTexture::Region freed = regions[300];
+    tex.addRegionToClear(freed);
+    for (int iy=freed.sy;iy<=freed.ey;iy++)
+        for (int ix=freed.sx;ix<=freed.ex;ix++)
+            used[iy*128+ix] = false;
+    DynamicTexture::Region region;
+    XCTAssertTrue(tex.findRegion(freed.ex - freed.sx + 1, freed.ey - freed.sy + 1, region));
+    for (int iy=region.sy;iy<=region.ey;iy++)
+        for (int ix=region.sx;ix<=region.ex;ix++)
+            XCTAssertFalse(used[iy*128+ix]);
+    tex.setRegion(region, true);
+    tex.getUtilization(numCell, usedCell, holeCell);
+    XCTAssertEqual(usedCell, usedBefore);
+}
+
+// Replay the trace, reporting findRegion time and how fragmented the texture ended up
+- (void)testGlyphTracePerformance {
+    [self measureBlock:^{
+        const ReplayStats stats = ReplayGlyphTrace(trace);
+        NSLog(@"%d allocations (%d failed) in %.2f ms, %.1f%% used, %.1f%% in holes",
+              stats.numAllocs, stats.numFailed, stats.findTime * 1000.0,
+              100.0 * stats.usedCell / stats.numCell, 100.0 * stats.holeCell / stats.numCell);
+    }];
+}
+
+@end
@@ -0,0 +1,221 @@
+//
+//  GeoJSONReaderTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <map>
+#import <string>
+#import "VectorData.h"
+#import "GeoJSONReader.h"
+
+using namespace WhirlyKit;
+
+// One feature with a mix of geometry and properties, about what a county or road layer looks like
+static std::string MakeFeature(int which,int ringSize)
+{
+    char buf[256];
+    std::string feat = "{\"type\":\"Feature\",\"properties\":{";
+    snprintf(buf, sizeof(buf), "\"id\":%d,\"name\":\"Feature %d\",\"value\":%.6f,\"flag\":%s,\"note\":null},",
+             which, which, which * 0.125 + 0.001, (which % 2) ? "true" : "false");
+    feat += buf;
+
+    const double lon = -120.0 + (which % 400) * 0.1, lat = 30.0 + (which / 400 % 100) * 0.1;
+    switch (which % 3)
+    {
+        case 0:
+            feat += "\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[[";
+            for (int ii=0;ii<=ringSize;ii++)
+            {
+                const double ang = 2*M_PI * (ii % ringSize) / ringSize;
+                snprintf(buf, sizeof(buf), "%s[%.7f,%.7f]", ii ? "," : "", lon + 0.04 * cos(ang), lat + 0.04 * sin(ang));
+                feat += buf;
+            }
+            feat += "]]}}";
+            break;
+        case 1:
+            feat += "\"geometry\":{\"type\":\"LineString\",\"coordinates\":[";
+            for (int ii=0;ii<ringSize;ii++)
+            {
+                snprintf(buf, sizeof(buf), "%s[%.7f,%.7f,12.5]", ii ? "," : "", lon + 0.001 * ii, lat + 0.0005 * ii);
+                feat += buf;
+            }
+            feat += "]}}";
+            break;
+        default:
+            snprintf(buf, sizeof(buf), "\"geometry\":{\"type\":\"Point\",\"coordinates\":[%.7f,%.7f]}}", lon, lat);
+            feat += buf;
+            break;
+    }
+
+    return feat;
+}
+
+static std::string MakeFeatureCollection(int numFeatures,int ringSize)
+{
+    std::string json = "{\"type\":\"FeatureCollection\",\"features\":[";
+    for (int ii=0;ii<numFeatures;ii++)
+    {
+        if (ii)
+            json += ",\n";
+        json += MakeFeature(ii, ringSize);
+    }
+    json += "]}";
+    return json;
+}
+
+static std::string MakeFeatureLines(int numFeatures,int ringSize)
+{
+    std::string json;
+    for (int ii=0;ii<numFeatures;ii++)
+        json += MakeFeature(ii, ringSize) + "\n";
+    return json;
+}
+
+// The old way in, through the libjson DOM.  Assemblies still go that way.
+static bool ParseWithLibJSON(const std::string &json,ShapeSet &shapes)
+{
+    std::map<std::string,ShapeSet> assembly;
+    if (!VectorParseGeoJSONAssembly("{\"layer\":" + json + "}", assembly))
+        return false;
+    shapes = assembly["layer"];
+    return true;
+}
+
+// Shapes by their id attribute
+static std::map<int,VectorShapeRef> ShapesByID(const ShapeSet &shapes)
+{
+    std::map<int,VectorShapeRef> byID;
+    for (const auto &shape : shapes)
+        byID[shape->getAttrDict()->getInt("id", -1)] = shape;
+    return byID;
+}
+
+static const VectorRing *ShapePoints(const VectorShapeRef &shape)
+{
+    if (const auto areal = std::dynamic_pointer_cast<VectorAreal>(shape))
+        return areal->loops.empty() ? nullptr : &areal->loops[0];
+    if (const auto lin = std::dynamic_pointer_cast<VectorLinear>(shape))
+        return &lin->pts;
+    if (const auto pts = std::dynamic_pointer_cast<VectorPoints>(shape))
+        return &pts->pts;
+    return nullptr;
+}
+
+@interface GeoJSONReaderTests : XCTestCase
+
+@end
+
+@implementation GeoJSONReaderTests
+
+// Both readers should produce the same shapes and attributes
+- (void)testMatchesLibJSON {
+    const int numFeatures = 600;
+    const std::string json = MakeFeatureCollection(numFeatures, 32);
+
+    ShapeSet readerShapes, libShapes;
+    std::string crs;
+    XCTAssertTrue(VectorParseGeoJSON(readerShapes, json, crs));
+    XCTAssertTrue(ParseWithLibJSON(json, libShapes));
+    XCTAssertEqual(readerShapes.size(), (size_t)numFeatures);
+    XCTAssertEqual(libShapes.size(), readerShapes.size());
+
+    const auto readerByID = ShapesByID(readerShapes);
+    const auto libByID = ShapesByID(libShapes);
+    XCTAssertEqual(readerByID.size(), (size_t)numFeatures);
+    for (const auto &it : readerByID)
+    {
+        const auto libIt = libByID.find(it.first);
+        XCTAssertTrue(libIt != libByID.end());
+        if (libIt == libByID.end())
+            continue;
+
+        const MutableDictionaryRef readerAttrs = it.second->getAttrDict();
+        const MutableDictionaryRef libAttrs = libIt->second->getAttrDict();
+        XCTAssertTrue(readerAttrs->getString("name") == libAttrs->getString("name"));
+        XCTAssertEqualWithAccuracy(readerAttrs->getDouble("value"), libAttrs->getDouble("value"), 1e-9);
+        XCTAssertEqual(readerAttrs->getBool("flag"), libAttrs->getBool("flag"));
+
+        const VectorRing *readerPts = ShapePoints(it.second);
+        const VectorRing *libPts = ShapePoints(libIt->second);
+        XCTAssertTrue(readerPts && libPts);
+        if (!readerPts || !libPts)
+            continue;
+        XCTAssertEqual(readerPts->size(), libPts->size());
+        for (size_t ii=0;ii<readerPts->size() && ii<libPts->size();ii++)
+            XCTAssertTrue(((*readerPts)[ii] - (*libPts)[ii]).norm() < 1e-6);
+    }
+}
+
+// Newline delimited input comes out the same as the collection, however many threads
+- (void)testLines {
+    const int numFeatures = 600;
+    ShapeSet collShapes, oneShapes, manyShapes;
+    std::string crs;
+    XCTAssertTrue(VectorParseGeoJSON(collShapes, MakeFeatureCollection(numFeatures, 16), crs));
+    const std::string lines = MakeFeatureLines(numFeatures, 16);
+    XCTAssertTrue(VectorParseGeoJSONLines(oneShapes, lines, 1));
+    XCTAssertTrue(VectorParseGeoJSONLines(manyShapes, lines, 4));
+    XCTAssertEqual(oneShapes.size(), collShapes.size());
+    XCTAssertEqual(manyShapes.size(), collShapes.size());
+
+    GeoJSONReader reader;
+    ShapeSet badShapes;
+    const char *truncated = "{\"type\":\"Feature\",\"geometry\":";
+    XCTAssertFalse(reader.parse(truncated, strlen(truncated), badShapes, crs));
+    XCTAssertFalse(reader.getError().empty());
+}
+
+// A large layer through the streaming reader (time and memory)
+- (void)testReaderPerformance {
+    const int numFeatures = 30000;
+    const std::string json = MakeFeatureCollection(numFeatures, 64);
+    NSLog(@"Parsing %.1f MB of GeoJSON with the reader", json.size() / (1024.0*1024.0));
+
+    [self measureWithMetrics:@[[[XCTClockMetric alloc] init],[[XCTMemoryMetric alloc] init]] block:^{
+        ShapeSet shapes;
+        std::string crs;
+        XCTAssertTrue(VectorParseGeoJSON(shapes, json, crs));
+        XCTAssertEqual(shapes.size(), (size_t)numFeatures);
+    }];
+}
+
+// The same layer through the libjson DOM, for comparison
+- (void)testLibJSONPerformance {
+    const int numFeatures = 30000;
+    const std::string json = MakeFeatureCollection(numFeatures, 64);
+    NSLog(@"Parsing %.1f MB of GeoJSON with libjson", json.size() / (1024.0*1024.0));
+
+    [self measureWithMetrics:@[[[XCTClockMetric alloc] init],[[XCTMemoryMetric alloc] init]] block:^{
+        ShapeSet shapes;
+        XCTAssertTrue(ParseWithLibJSON(json, shapes));
+        XCTAssertEqual(shapes.size(), (size_t)numFeatures);
+    }];
+}
+
+// Newline delimited, split across the cores
+- (void)testLinesPerformance {
+    const int numFeatures = 30000;
+    const std::string lines = MakeFeatureLines(numFeatures, 64);
+
+    [self measureWithMetrics:@[[[XCTClockMetric alloc] init],[[XCTMemoryMetric alloc] init]] block:^{
+        ShapeSet shapes;
+        XCTAssertTrue(VectorParseGeoJSONLines(shapes, lines));
+        XCTAssertEqual(shapes.size(), (size_t)numFeatures);
+    }];
+}
+
+@end
@@ -0,0 +1,242 @@
+//
+//  LayoutManagerTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <algorithm>
+#import <set>
+#import <vector>
+#import "SceneRendererNull.h"
+#import "LayoutManager.h"
+#import "GlobeView.h"
+
+using namespace WhirlyKit;
+
+static const int NumLabels = 50000;
+
+// The layout manager expects a cluster generator, even if nothing clusters
+class TestClusterGenerator : public ClusterGenerator
+{
+public:
+    void startLayoutObjects(PlatformThreadInfo *) override { }
+    void makeLayoutObject(PlatformThreadInfo *,int,const std::vector<LayoutObjectEntry *> &,LayoutObject &) override { }
+    void endLayoutObjects(PlatformThreadInfo *) override { }
+    void paramsForClusterClass(PlatformThreadInfo *,int,ClusterClassParams &) override { }
+};
+
+// Labels scattered over a country sized area, with a spread of sizes and importance like place names
+static std::vector<LayoutObject> MakeLabels(CoordSystemDisplayAdapter *coordAdapter,int numLabels)
+{
+    unsigned int rand = 54321;
+    auto next = [&rand](unsigned int limit) { rand = rand * 1103515245u + 12345u;  return (rand >> 8) % limit; };
+
+    std::vector<LayoutObject> labels(numLabels);
+    for (auto &label : labels)
+    {
+        const GeoCoord geo = GeoCoord::CoordFromDegrees(-10.0 + next(20000) / 1000.0, 35.0 + next(15000) / 1000.0);
+        label.setWorldLoc(coordAdapter->localToDisplay(coordAdapter->getCoordSystem()->geographicToLocal3d(geo)));
+        const Point2d size(30.0 + next(90), 12.0 + next(3) * 2.0);
+        label.setLayoutSize(size, Point2d(-size.x() / 2.0, -size.y() / 2.0));
+        label.setSelectSize(size, Point2d(-size.x() / 2.0, -size.y() / 2.0));
+        // A few big places and lots of little ones
+        const unsigned int tier = next(100);
+        label.importance = (tier < 2 ? 3000.0f : (tier < 15 ? 2000.0f : 1000.0f)) + (float)next(1000);
+        label.acceptablePlacement = WhirlyKitLayoutPlacementCenter | WhirlyKitLayoutPlacementRight | WhirlyKitLayoutPlacementLeft;
+    }
+    return labels;
+}
+
+struct CameraPos
+{
+    double lon,lat;
+    double height;
+};
+
+// A recorded session: a slow pan, a faster one, then zooming in and back out
+static std::vector<CameraPos> MakeCameraPath()
+{
+    std::vector<CameraPos> path;
+    double lon = -4.0, lat = 41.0, height = 0.03;
+    for (int ii=0;ii<120;ii++)
+    {
+        lon += 0.004;  lat += 0.001 * sin(ii / 20.0);
+        path.push_back({lon,lat,height});
+    }
+    for (int ii=0;ii<60;ii++)
+    {
+        lon += 0.015;  lat -= 0.006;
+        path.push_back({lon,lat,height});
+    }
+    for (int ii=0;ii<60;ii++)
+    {
+        height *= (ii < 30) ? 0.99 : 1.0/0.99;
+        path.push_back({lon,lat,height});
+    }
+    return path;
+}
+
+// IDs of everything the layout turned on
+static std::set<SimpleIdentity> VisibleIDs(LayoutManager *layoutManager,const ViewStateRef &viewState,SceneRenderer *renderer)
+{
+    std::vector<ScreenSpaceObjectLocation> objs;
+    layoutManager->getScreenSpaceObjects(SelectionManager::PlacementInfo(viewState,renderer), objs);
+    std::set<SimpleIdentity> ids;
+    for (const auto &obj : objs)
+        ids.insert(obj.shapeIDs.begin(), obj.shapeIDs.end());
+    return ids;
+}
+
+@interface LayoutManagerTests : XCTestCase
+
+@end
+
+@implementation LayoutManagerTests
+{
+    WhirlyGlobe::GlobeViewRef view;
+    SceneNull *scene;
+    SceneRendererNullRef renderer;
+    LayoutManagerRef layoutManager;
+    TestClusterGenerator clusterGen;
+    std::vector<CameraPos> cameraPath;
+}
+
+- (void)setUp {
+    renderer = std::make_shared<SceneRendererNull>();
+    renderer->setup(2048, 1536, 2.0);
+
+    view = std::make_shared<WhirlyGlobe::GlobeView>(nullptr);
+    scene = new SceneNull(view->coordAdapter);
+    renderer->setScene(scene);
+    renderer->setView(view.get());
+
+    layoutManager = scene->getManager<LayoutManager>(kWKLayoutManager);
+    layoutManager->addClusterGenerator(nullptr, &clusterGen);
+    layoutManager->addLayoutObjects(MakeLabels(view->coordAdapter, NumLabels));
+    cameraPath = MakeCameraPath();
+}
+
+- (void)tearDown {
+    layoutManager = nullptr;
+    scene->teardown(nullptr);
+    renderer->setScene(nullptr);
+    delete scene;
+    scene = nullptr;
+    renderer = nullptr;
+    view = nullptr;
+}
+
+// Move the camera and run the layout, the way the layout layer does when the view changes
+- (ViewStateRef)layoutAt:(const CameraPos &)pos {
+    view->setRotQuat(view->makeRotationToGeoCoord(GeoCoord::CoordFromDegrees(pos.lon, pos.lat), true), false);
+    view->setHeightAboveGlobe(pos.height, false);
+    ViewStateRef viewState = view->makeViewState(renderer.get());
+
+    ChangeSet changes;
+    layoutManager->updateLayout(nullptr, viewState, changes);
+    for (auto change : changes)
+        delete change;
+    return viewState;
+}
+
+// Play back the first part of the camera path, returning the average layout time per frame
+- (double)replayCameraPath:(bool)incremental frames:(int)numFrames {
+    layoutManager->setIncrementalLayout(incremental);
+    const TimeInterval startTime = TimeGetCurrent();
+    for (int ii=0;ii<numFrames;ii++)
+        [self layoutAt:cameraPath[ii]];
+    return (TimeGetCurrent() - startTime) / numFrames;
+}
+
+// Play back the whole camera path
+- (double)replayCameraPath:(bool)incremental {
+    return [self replayCameraPath:incremental frames:(int)cameraPath.size()];
+}
+
+// Nothing changes if the camera doesn't move
+- (void)testIncrementalStill {
+    layoutManager->setIncrementalLayout(true);
+    const ViewStateRef firstState = [self layoutAt:cameraPath.front()];
+    const std::set<SimpleIdentity> first = VisibleIDs(layoutManager.get(), firstState, renderer.get());
+    XCTAssertGreaterThan(first.size(), 50);
+
+    for (int ii=0;ii<3;ii++)
+    {
+        const ViewStateRef viewState = [self layoutAt:cameraPath.front()];
+        XCTAssertTrue(VisibleIDs(layoutManager.get(), viewState, renderer.get()) == first);
+    }
+}
+
+// After the whole path, incremental layout shows about as much as a full layout of the same view
+- (void)testIncrementalMatchesFull {
+    [self replayCameraPath:false];
+    const std::set<SimpleIdentity> full = VisibleIDs(layoutManager.get(), [self layoutAt:cameraPath.back()], renderer.get());
+
+    [self replayCameraPath:true];
+    const std::set<SimpleIdentity> incremental = VisibleIDs(layoutManager.get(), [self layoutAt:cameraPath.back()], renderer.get());
+
+    size_t numShared = 0;
+    for (auto theID : incremental)
+        numShared += full.count(theID);
+    NSLog(@"Full layout shows %d labels, incremental %d, %d in common", (int)full.size(), (int)incremental.size(), (int)numShared);
+    XCTAssertGreaterThan(full.size(), 50);
+    XCTAssertGreaterThan(incremental.size(), full.size() * 9 / 10);
+    XCTAssertLessThan(incremental.size(), full.size() * 11 / 10);
+}
+
+// Labels that go off screen are dropped, and the same ones come back when we return
+- (void)testOffScreenAndBack {
+    const CameraPos &start = cameraPath.front();
+    const std::set<SimpleIdentity> first = VisibleIDs(layoutManager.get(), [self layoutAt:start], renderer.get());
+    XCTAssertGreaterThan(first.size(), 50);
+
+    const CameraPos awayPos = { start.lon + 8.0, start.lat + 4.0, start.height };
+    const std::set<SimpleIdentity> away = VisibleIDs(layoutManager.get(), [self layoutAt:awayPos], renderer.get());
+    XCTAssertGreaterThan(away.size(), 50);
+    for (auto theID : away)
+        XCTAssertEqual(first.count(theID), 0);
+
+    XCTAssertTrue(VisibleIDs(layoutManager.get(), [self layoutAt:start], renderer.get()) == first);
+}
+
+// On the slow pan most labels keep their placement from the frame before, so incremental layout has less to do
+- (void)testIncrementalPanSpeedup {
+    const int numFrames = 120;
+    double fullTime = MAXFLOAT, incrementalTime = MAXFLOAT;
+    for (int ii=0;ii<5;ii++)
+    {
+        fullTime = std::min(fullTime, [self replayCameraPath:false frames:numFrames]);
+        incrementalTime = std::min(incrementalTime, [self replayCameraPath:true frames:numFrames]);
+    }
+    NSLog(@"Slow pan: full layout %.3f ms/frame, incremental %.3f ms/frame", fullTime * 1000.0, incrementalTime * 1000.0);
+    XCTAssertLessThan(incrementalTime, fullTime);
+}
+
+// Layout time per frame over the camera path, laying everything out every time
+- (void)testFullLayoutReplayPerformance {
+    [self measureBlock:^{
+        NSLog(@"Full layout: %.2f ms/frame over %d frames", [self replayCameraPath:false] * 1000.0, (int)cameraPath.size());
+    }];
+}
+
+// The same with incremental layout
+- (void)testIncrementalLayoutReplayPerformance {
+    [self measureBlock:^{
+        NSLog(@"Incremental layout: %.2f ms/frame over %d frames", [self replayCameraPath:true] * 1000.0, (int)cameraPath.size());
+    }];
+}
+
+@end
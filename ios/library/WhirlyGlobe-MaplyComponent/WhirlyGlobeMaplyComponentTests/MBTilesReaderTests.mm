@@ -0,0 +1,298 @@
+//
+//  MBTilesReaderTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <sqlite3.h>
+#import <zlib.h>
+#import <string>
+#import <thread>
+#import <vector>
+#import "MBTilesReader.h"
+#import "Platform.h"
+
+using namespace WhirlyKit;
+
+typedef std::vector<unsigned char> TileBytes;
+
+// The tiles we write are a square block at this level
+static const int TileLevel = 14;
+static const int TileX0 = 2600, TileY0 = 10000;
+static const int TileBlock = 64;
+
+// Something like a vector tile's payload, which compresses about as well
+static TileBytes MakePayload(int x,int y)
+{
+    TileBytes data(24*1024 + (x * 131 + y * 71) % 8192);
+    unsigned int noise = x * 2654435761u + y;
+    for (size_t ii=0;ii<data.size();ii++)
+    {
+        noise = noise * 1103515245u + 12345u;
+        data[ii] = (ii % 7 == 0) ? (unsigned char)(noise >> 24) : (unsigned char)((ii / 16 + x + y) & 0x3f);
+    }
+    return data;
+}
+
+static TileBytes Gzip(const TileBytes &data)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // 16 means write a gzip header
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    TileBytes out(deflateBound(&stream, data.size()));
+    stream.next_in = (Bytef *)data.data();
+    stream.avail_in = (uInt)data.size();
+    stream.next_out = out.data();
+    stream.avail_out = (uInt)out.size();
+    deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+
+static std::string TempFile(const char *name)
+{
+    const char *tmpDir = getenv("TMPDIR");
+    std::string path = tmpDir ? tmpDir : "/tmp";
+    if (path.empty() || path.back() != '/')
+        path += "/";
+    return path + name;
+}
+
+// Write a block of gzipped tiles into a new MBTiles file.  Only done once per run.
+static const std::string &TestFile()
+{
+    static std::string fileName;
+    if (!fileName.empty())
+        return fileName;
+
+    const std::string newName = TempFile("MBTilesReaderTests.mbtiles");
+    remove(newName.c_str());
+    sqlite3 *db = nullptr;
+    if (sqlite3_open(newName.c_str(), &db) != SQLITE_OK)
+        return fileName;
+    sqlite3_exec(db, "CREATE TABLE metadata (name text, value text);"
+                     "CREATE TABLE tiles (zoom_level integer, tile_column integer, tile_row integer, tile_data blob);"
+                     "CREATE UNIQUE INDEX tile_index on tiles (zoom_level, tile_column, tile_row);"
+                     "INSERT INTO metadata VALUES ('format','pbf');"
+                     "INSERT INTO metadata VALUES ('minzoom','14');"
+                     "INSERT INTO metadata VALUES ('maxzoom','14');"
+                     "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
+
+    sqlite3_stmt *stmt = nullptr;
+    sqlite3_prepare_v2(db, "INSERT INTO tiles VALUES (?,?,?,?);", -1, &stmt, nullptr);
+    for (int x=TileX0;x<TileX0+TileBlock;x++)
+        for (int y=TileY0;y<TileY0+TileBlock;y++)
+        {
+            const TileBytes tile = Gzip(MakePayload(x, y));
+            sqlite3_bind_int(stmt, 1, TileLevel);
+            sqlite3_bind_int(stmt, 2, x);
+            sqlite3_bind_int(stmt, 3, y);
+            sqlite3_bind_blob(stmt, 4, tile.data(), (int)tile.size(), SQLITE_TRANSIENT);
+            sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+        }
+    sqlite3_finalize(stmt);
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+
+    fileName = newName;
+    return fileName;
+}
+
+// Every tile in the block, in 8x8 patches, about what a loader asks for after a pan
+static std::vector<QuadTreeIdentifier> AllTiles()
+{
+    std::vector<QuadTreeIdentifier> idents;
+    for (int py=0;py<TileBlock;py+=8)
+        for (int px=0;px<TileBlock;px+=8)
+            for (int y=TileY0+py;y<TileY0+py+8;y++)
+                for (int x=TileX0+px;x<TileX0+px+8;x++)
+                    idents.push_back(QuadTreeIdentifier(x, y, TileLevel));
+    return idents;
+}
+
+// What the platform fetchers do: format a query for each tile and start a new inflate for each
+static size_t FetchOneByOne(sqlite3 *db,const std::vector<QuadTreeIdentifier> &idents)
+{
+    size_t totalBytes = 0;
+    char query[256];
+    for (const auto &ident : idents)
+    {
+        snprintf(query, sizeof(query), "SELECT tile_data FROM tiles WHERE zoom_level=%d AND tile_column=%d AND tile_row=%d;",
+                 ident.level, ident.x, ident.y);
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(db, query, -1, &stmt, nullptr) != SQLITE_OK)
+            continue;
+        if (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            const int len = sqlite3_column_bytes(stmt, 0);
+            z_stream stream;
+            memset(&stream, 0, sizeof(stream));
+            inflateInit2(&stream, 15 + 32);
+            TileBytes out(len * 8);
+            stream.next_in = (Bytef *)sqlite3_column_blob(stmt, 0);
+            stream.avail_in = len;
+            stream.next_out = out.data();
+            stream.avail_out = (uInt)out.size();
+            if (inflate(&stream, Z_FINISH) == Z_STREAM_END)
+                totalBytes += stream.total_out;
+            inflateEnd(&stream);
+        }
+        sqlite3_finalize(stmt);
+    }
+    return totalBytes;
+}
+
+static void LogThroughput(const char *what,size_t numTiles,size_t numBytes,TimeInterval howLong)
+{
+    howLong = std::max(howLong, 1e-9);
+    NSLog(@"%s: %d tiles, %.1f MB in %.3f s, %.0f tiles/s, %.1f MB/s", what, (int)numTiles,
+          numBytes / (1024.0*1024.0), howLong, numTiles / howLong, numBytes / (1024.0*1024.0) / howLong);
+}
+
+@interface MBTilesReaderTests : XCTestCase
+
+@end
+
+@implementation MBTilesReaderTests
+{
+    MBTilesReaderRef reader;
+}
+
+- (void)setUp {
+    reader = std::make_shared<MBTilesReader>(TestFile());
+    XCTAssertTrue(reader->open());
+}
+
+- (void)tearDown {
+    reader->close();
+    reader = nullptr;
+}
+
+// Metadata comes through, and the tiles come back decompressed
+- (void)testFetch {
+    XCTAssertTrue(reader->getFormat() == "pbf");
+    XCTAssertEqual(reader->getMinZoom(), TileLevel);
+    XCTAssertEqual(reader->getMaxZoom(), TileLevel);
+
+    const QuadTreeIdentifier ident(TileX0 + 3, TileY0 + 5, TileLevel);
+    const TileBytes expect = MakePayload(ident.x, ident.y);
+    RawDataRef tile = reader->fetchTile(ident);
+    XCTAssertTrue(tile && tile->getLen() == expect.size());
+    XCTAssertTrue(tile && memcmp(tile->getRawData(), expect.data(), expect.size()) == 0);
+
+    // Missing tiles come back empty
+    XCTAssertFalse(reader->fetchTile(QuadTreeIdentifier(TileX0 - 1, TileY0, TileLevel)));
+    XCTAssertFalse(reader->fetchTile(QuadTreeIdentifier(TileX0, TileY0, TileLevel + 1)));
+
+    // Turned off, we get the gzipped data as is
+    reader->setDecompress(false);
+    RawDataRef raw = reader->fetchTile(ident);
+    XCTAssertTrue(raw && raw->getLen() == Gzip(expect).size());
+    reader->setDecompress(true);
+}
+
+// Batches come back in the order asked for, with repeats and misses in place
+- (void)testFetchBatch {
+    std::vector<QuadTreeIdentifier> idents;
+    for (int ii=0;ii<150;ii++)
+        idents.push_back(QuadTreeIdentifier(TileX0 + (ii * 7) % TileBlock, TileY0 + (ii * 13) % TileBlock, TileLevel));
+    idents.push_back(idents[10]);
+    idents.push_back(QuadTreeIdentifier(TileX0 + TileBlock, TileY0, TileLevel));
+
+    const std::vector<RawDataRef> tiles = reader->fetchTiles(idents);
+    XCTAssertEqual(tiles.size(), idents.size());
+    for (size_t ii=0;ii<idents.size()-1;ii++)
+    {
+        const TileBytes expect = MakePayload(idents[ii].x, idents[ii].y);
+        XCTAssertTrue(tiles[ii] && tiles[ii]->getLen() == expect.size());
+        XCTAssertTrue(tiles[ii] && memcmp(tiles[ii]->getRawData(), expect.data(), expect.size()) == 0);
+    }
+    XCTAssertFalse(tiles.back());
+}
+
+// Several threads reading at once each get their own connection
+- (void)testConcurrentFetch {
+    const std::vector<QuadTreeIdentifier> idents = AllTiles();
+    std::vector<int> found(4, 0);
+    std::vector<std::thread> threads;
+    for (int which=0;which<(int)found.size();which++)
+        threads.emplace_back([&,which]{
+            for (size_t ii=which;ii<idents.size();ii+=found.size())
+                if (reader->fetchTile(idents[ii]))
+                    found[which]++;
+        });
+    for (auto &thread : threads)
+        thread.join();
+
+    int total = 0;
+    for (int count : found)
+        total += count;
+    XCTAssertEqual(total, (int)idents.size());
+}
+
+// A formatted query and a fresh inflate per tile, like the platform fetchers
+- (void)testQueryPerTilePerformance {
+    const std::vector<QuadTreeIdentifier> idents = AllTiles();
+    sqlite3 *db = nullptr;
+    const int ret = sqlite3_open_v2(TestFile().c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+    XCTAssertEqual(ret, SQLITE_OK);
+
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        const size_t numBytes = FetchOneByOne(db, idents);
+        LogThroughput("Query per tile", idents.size(), numBytes, TimeGetCurrent() - startTime);
+        XCTAssertTrue(numBytes > 0);
+    }];
+    sqlite3_close(db);
+}
+
+// One tile at a time through the reader's pooled statements and inflate stream
+- (void)testFetchTilePerformance {
+    const std::vector<QuadTreeIdentifier> idents = AllTiles();
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        size_t numBytes = 0;
+        for (const auto &ident : idents)
+            if (RawDataRef tile = reader->fetchTile(ident))
+                numBytes += tile->getLen();
+        LogThroughput("fetchTile", idents.size(), numBytes, TimeGetCurrent() - startTime);
+        XCTAssertTrue(numBytes > 0);
+    }];
+}
+
+// A patch of tiles at a time, batched into IN queries
+- (void)testFetchTilesPerformance {
+    const std::vector<QuadTreeIdentifier> allIdents = AllTiles();
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        size_t numBytes = 0;
+        for (size_t start=0;start<allIdents.size();start+=MBTilesReader::MaxBatchSize)
+        {
+            const std::vector<QuadTreeIdentifier> idents(allIdents.begin() + start,
+                                                         allIdents.begin() + std::min(allIdents.size(), start + MBTilesReader::MaxBatchSize));
+            for (const RawDataRef &tile : reader->fetchTiles(idents))
+                if (tile)
+                    numBytes += tile->getLen();
+        }
+        LogThroughput("fetchTiles", allIdents.size(), numBytes, TimeGetCurrent() - startTime);
+        XCTAssertTrue(numBytes > 0);
+    }];
+}
+
+@end
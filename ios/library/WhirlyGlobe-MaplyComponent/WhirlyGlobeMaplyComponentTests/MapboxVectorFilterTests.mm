@@ -0,0 +1,383 @@
+//
+//  MapboxVectorFilterTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <string>
+#import <vector>
+#import "MapboxVectorStyleSetC.h"
+#import "MapboxVectorStyleLayer.h"
+#import "FlatDictionary.h"
+#import "SceneRendererNull.h"
+#import "GlobeView.h"
+
+using namespace WhirlyKit;
+
+// Enough of the platform side to parse a style sheet
+class TestStyleSet : public MapboxVectorStyleSetImpl
+{
+public:
+    TestStyleSet(Scene *scene,CoordSystem *coordSys) :
+        MapboxVectorStyleSetImpl(scene,coordSys,std::make_shared<VectorStyleSettingsImpl>(1.0))
+    {
+    }
+
+    SimpleIdentity makeCircleTexture(PlatformThreadInfo *,double,const RGBAColor &,const RGBAColor &,
+                                     float,Point2f *) override { return EmptyIdentity; }
+    SimpleIdentity makeLineTexture(PlatformThreadInfo *,const std::vector<double> &) override { return EmptyIdentity; }
+    LabelInfoRef makeLabelInfo(PlatformThreadInfo *,const std::vector<std::string> &,float) override { return nullptr; }
+    SingleLabelRef makeSingleLabel(PlatformThreadInfo *,const std::string &) override { return nullptr; }
+    void addSelectionObject(SimpleIdentity,const VectorObjectRef &,const ComponentObjectRef &) override { }
+    double calculateTextWidth(PlatformThreadInfo *,const LabelInfoRef &,const std::string &) override { return 0.0; }
+    ComponentObjectRef makeComponentObject(PlatformThreadInfo *,const Dictionary *) override { return nullptr; }
+};
+
+// Bits of style sheet
+static DictionaryEntryRef Str(const char *str) { return std::make_shared<DictionaryEntryCString>(std::string(str)); }
+static DictionaryEntryRef Num(int val) { return std::make_shared<DictionaryEntryCBasic>(val); }
+static DictionaryEntryRef Num(double val) { return std::make_shared<DictionaryEntryCBasic>(val); }
+static DictionaryEntryRef Arr(const std::vector<DictionaryEntryRef> &vals) { return std::make_shared<DictionaryEntryCArray>(vals); }
+
+static DictionaryEntryRef MakeLayer(const char *ident,const char *type,const char *sourceLayer,
+                                    const std::vector<DictionaryEntryRef> &filter)
+{
+    auto layer = std::make_shared<MutableDictionaryC>();
+    layer->setString("id", ident);
+    layer->setString("type", type);
+    layer->setString("source-layer", sourceLayer);
+    if (!filter.empty())
+        layer->setArray("filter", filter);
+    return std::make_shared<DictionaryEntryCDict>(layer);
+}
+
+// Layers and filters in the style of the OpenMapTiles sheets
+static MutableDictionaryCRef MakeStyleSheet()
+{
+    const auto isPoly = Arr({Str("=="),Str("$type"),Str("Polygon")});
+    const auto isLine = Arr({Str("=="),Str("$type"),Str("LineString")});
+    const auto notBridgeTunnel = Arr({Str("!in"),Str("brunnel"),Str("bridge"),Str("tunnel")});
+    const std::vector<DictionaryEntryRef> layers = {
+        MakeLayer("water","fill","water",{Str("all"),isPoly,Arr({Str("!="),Str("brunnel"),Str("tunnel")})}),
+        MakeLayer("water-intermittent","fill","water",{Str("all"),isPoly,Arr({Str("=="),Str("intermittent"),Num(1)})}),
+        MakeLayer("landcover-glacier","fill","landcover",{Str("any"),Arr({Str("=="),Str("subclass"),Str("glacier")}),
+                                                                     Arr({Str("=="),Str("subclass"),Str("ice_shelf")})}),
+        MakeLayer("landcover-wood","fill","landcover",{Str("all"),isPoly,Arr({Str("=="),Str("class"),Str("wood")})}),
+        MakeLayer("landcover-grass","fill","landcover",{Str("all"),isPoly,Arr({Str("=="),Str("class"),Str("grass")})}),
+        MakeLayer("landcover-sand","fill","landcover",{Str("all"),isPoly,Arr({Str("=="),Str("class"),Str("sand")})}),
+        MakeLayer("landcover-wetland","fill","landcover",{Str("in"),Str("subclass"),Str("wetland"),Str("bog"),Str("marsh")}),
+        MakeLayer("landuse-residential","fill","landuse",{Str("all"),isPoly,
+                                                          Arr({Str("in"),Str("class"),Str("residential"),Str("suburb"),Str("neighbourhood")})}),
+        MakeLayer("landuse-commercial","fill","landuse",{Str("all"),isPoly,Arr({Str("=="),Str("class"),Str("commercial")})}),
+        MakeLayer("landuse-industrial","fill","landuse",{Str("in"),Str("class"),Str("industrial"),Str("garages"),Str("dam")}),
+        MakeLayer("landuse-cemetery","fill","landuse",{Str("=="),Str("class"),Str("cemetery")}),
+        MakeLayer("landuse-hospital","fill","landuse",{Str("=="),Str("class"),Str("hospital")}),
+        MakeLayer("landuse-school","fill","landuse",{Str("=="),Str("class"),Str("school")}),
+        MakeLayer("landuse-railway","fill","landuse",{Str("=="),Str("class"),Str("railway")}),
+        MakeLayer("park","fill","park",{Str("=="),Str("$type"),Str("Polygon")}),
+        MakeLayer("park-outline","line","park",{Str("=="),Str("$type"),Str("Polygon")}),
+        MakeLayer("waterway-tunnel","line","waterway",{Str("all"),isLine,Arr({Str("=="),Str("brunnel"),Str("tunnel")})}),
+        MakeLayer("waterway-river","line","waterway",{Str("all"),Arr({Str("=="),Str("class"),Str("river")}),
+                                                      Arr({Str("!="),Str("brunnel"),Str("tunnel")}),
+                                                      Arr({Str("!="),Str("intermittent"),Num(1)})}),
+        MakeLayer("waterway-other","line","waterway",{Str("all"),Arr({Str("!in"),Str("class"),Str("canal"),Str("river"),Str("stream")}),
+                                                      Arr({Str("=="),Str("intermittent"),Num(0)})}),
+        MakeLayer("waterway-stream","line","waterway",{Str("all"),Arr({Str("=="),Str("class"),Str("stream")}),
+                                                       Arr({Str("!="),Str("intermittent"),Num(1)})}),
+        MakeLayer("building","fill","building",{}),
+        MakeLayer("building-3d","fill","building",{Str("all"),Arr({Str("!has"),Str("hide_3d")}),Arr({Str("has"),Str("render_height")}),
+                                                   Arr({Str(">"),Str("render_height"),Num(10.0)})}),
+        MakeLayer("road-area","fill","transportation",{Str("all"),isPoly,Arr({Str("in"),Str("class"),Str("pier"),Str("bridge")})}),
+        MakeLayer("tunnel-motorway","line","transportation",{Str("all"),isLine,Arr({Str("all"),Arr({Str("=="),Str("brunnel"),Str("tunnel")}),
+                                                                                           Arr({Str("=="),Str("class"),Str("motorway")})})}),
+        MakeLayer("tunnel-minor","line","transportation",{Str("all"),isLine,Arr({Str("all"),Arr({Str("=="),Str("brunnel"),Str("tunnel")}),
+                                                                                        Arr({Str("in"),Str("class"),Str("minor"),Str("service")})})}),
+        MakeLayer("highway-path","line","transportation",{Str("all"),isLine,Arr({Str("all"),notBridgeTunnel,
+                                                                                        Arr({Str("=="),Str("class"),Str("path")})})}),
+        MakeLayer("highway-minor","line","transportation",{Str("all"),isLine,Arr({Str("all"),Arr({Str("!="),Str("brunnel"),Str("tunnel")}),
+                                                                                         Arr({Str("in"),Str("class"),Str("minor"),Str("service"),Str("track")})})}),
+        MakeLayer("highway-secondary-tertiary","line","transportation",{Str("all"),notBridgeTunnel,
+                                                                        Arr({Str("in"),Str("class"),Str("secondary"),Str("tertiary")})}),
+        MakeLayer("highway-primary","line","transportation",{Str("all"),isLine,Arr({Str("all"),notBridgeTunnel,
+                                                                                           Arr({Str("in"),Str("class"),Str("primary")})})}),
+        MakeLayer("highway-trunk","line","transportation",{Str("all"),isLine,Arr({Str("all"),notBridgeTunnel,
+                                                                                         Arr({Str("in"),Str("class"),Str("trunk")})})}),
+        MakeLayer("highway-motorway-link","line","transportation",{Str("all"),isLine,Arr({Str("all"),notBridgeTunnel,
+                                                                                                 Arr({Str("=="),Str("class"),Str("motorway")}),
+                                                                                                 Arr({Str("=="),Str("ramp"),Num(1)})})}),
+        MakeLayer("highway-motorway","line","transportation",{Str("all"),isLine,Arr({Str("all"),notBridgeTunnel,
+                                                                                            Arr({Str("=="),Str("class"),Str("motorway")}),
+                                                                                            Arr({Str("!="),Str("ramp"),Num(1)})})}),
+        MakeLayer("railway","line","transportation",{Str("all"),isLine,Arr({Str("all"),Arr({Str("=="),Str("class"),Str("rail")}),
+                                                                                   notBridgeTunnel})}),
+        MakeLayer("railway-transit","line","transportation",{Str("all"),Arr({Str("=="),Str("class"),Str("transit")}),
+                                                             Arr({Str("!has"),Str("service")})}),
+        MakeLayer("railway-service","line","transportation",{Str("all"),Arr({Str("=="),Str("class"),Str("rail")}),
+                                                             Arr({Str("has"),Str("service")})}),
+        MakeLayer("bridge-motorway","line","transportation",{Str("all"),Arr({Str("=="),Str("brunnel"),Str("bridge")}),
+                                                             Arr({Str("=="),Str("class"),Str("motorway")})}),
+        MakeLayer("bridge-minor","line","transportation",{Str("all"),Arr({Str("=="),Str("brunnel"),Str("bridge")}),
+                                                          Arr({Str("in"),Str("class"),Str("minor"),Str("service"),Str("track")})}),
+        MakeLayer("road-oneway","line","transportation",{Str("all"),Arr({Str("=="),Str("oneway"),Num(1)}),
+                                                         Arr({Str("in"),Str("class"),Str("motorway"),Str("trunk"),Str("primary"),
+                                                              Str("secondary"),Str("tertiary"),Str("minor"),Str("service")})}),
+        MakeLayer("road-oneway-opposite","line","transportation",{Str("all"),Arr({Str("=="),Str("oneway"),Num(-1)}),
+                                                                  Arr({Str("in"),Str("class"),Str("motorway"),Str("trunk"),Str("primary"),
+                                                                       Str("secondary"),Str("tertiary"),Str("minor"),Str("service")})}),
+        MakeLayer("boundary-land-level-4","line","boundary",{Str("all"),Arr({Str(">="),Str("admin_level"),Num(4)}),
+                                                             Arr({Str("<="),Str("admin_level"),Num(8)}),
+                                                             Arr({Str("!="),Str("maritime"),Num(1)})}),
+        MakeLayer("boundary-land-level-2","line","boundary",{Str("all"),Arr({Str("=="),Str("admin_level"),Num(2)}),
+                                                             Arr({Str("!="),Str("maritime"),Num(1)}),
+                                                             Arr({Str("!="),Str("disputed"),Num(1)})}),
+        MakeLayer("boundary-land-disputed","line","boundary",{Str("all"),Arr({Str("!="),Str("maritime"),Num(1)}),
+                                                              Arr({Str("=="),Str("disputed"),Num(1)})}),
+        MakeLayer("boundary-water","line","boundary",{Str("all"),Arr({Str("in"),Str("admin_level"),Num(2),Num(4)}),
+                                                      Arr({Str("=="),Str("maritime"),Num(1)})}),
+    };
+
+    auto sheet = std::make_shared<MutableDictionaryC>();
+    sheet->setString("name", "OpenMapTiles-ish");
+    sheet->setInt("version", 8);
+    sheet->setArray("layers", layers);
+    return sheet;
+}
+
+// How we make up an attribute: pick one of the strings, or a number below the limit.
+// Numbers are doubles when asked, the way some tile generators write them.
+struct AttrSpec
+{
+    const char *name;
+    int percent;
+    std::vector<const char *> strVals;
+    int numLimit;
+    bool asDouble;
+};
+
+struct SourceLayerSpec
+{
+    const char *name;
+    int numFeatures;
+    std::vector<int> geomTypes;
+    std::vector<AttrSpec> attrs;
+};
+
+static const std::vector<SourceLayerSpec> &SourceLayers()
+{
+    static const std::vector<SourceLayerSpec> specs = {
+        {"water",40,{3},{{"class",100,{"ocean","lake","river","pond"}},{"brunnel",20,{"tunnel","bridge"}},
+                         {"intermittent",50,{},2}}},
+        {"landcover",120,{3},{{"class",100,{"wood","grass","sand","wetland","farmland","ice"}},
+                              {"subclass",80,{"forest","park","wetland","bog","marsh","glacier","ice_shelf","meadow","beach"}}}},
+        {"landuse",120,{3,3,3,1},{{"class",100,{"residential","suburb","neighbourhood","commercial","industrial","garages",
+                                                 "dam","cemetery","hospital","school","railway","retail"}}}},
+        {"park",30,{3,3,1},{{"class",100,{"nature_reserve","national_park","protected_area"}},{"name",60,{"Park","Green","Common"}}}},
+        {"waterway",60,{2},{{"class",100,{"river","stream","canal","ditch","drain"}},{"brunnel",30,{"tunnel","bridge"}},
+                            {"intermittent",70,{},2}}},
+        {"building",400,{3},{{"render_height",70,{},60,true},{"render_min_height",30,{},20,true},{"hide_3d",10,{},2}}},
+        {"transportation",500,{2,2,2,2,2,3},{{"class",100,{"motorway","trunk","primary","secondary","tertiary","minor","service",
+                                                            "track","path","rail","transit","pier","bridge"}},
+                                              {"brunnel",25,{"bridge","tunnel","ford"}},{"ramp",15,{},2},{"oneway",40,{},2},
+                                              {"service",20,{"siding","yard","spur","driveway","parking_aisle"}},
+                                              {"surface",50,{"paved","unpaved"}},{"layer",20,{},5}}},
+        {"boundary",40,{2},{{"admin_level",100,{},11,false},{"admin_level",10,{},11,true},{"maritime",60,{},2},{"disputed",30,{},2}}},
+        {"poi",80,{1},{{"class",100,{"shop","cafe","school","park"}},{"rank",100,{},30}}},
+    };
+    return specs;
+}
+
+struct TestFeature
+{
+    const char *sourceLayer;
+    FlatDictionaryRef flatAttrs;
+    MutableDictionaryCRef attrs;
+};
+
+struct TestTile
+{
+    QuadTreeIdentifier tileID;
+    std::vector<TestFeature> features;
+};
+
+// The same tiles every time, each with a few thousand features like a city tile has
+static std::vector<TestTile> MakeTiles(int numTiles)
+{
+    static const StringIdentity geomTypeKey = StringIndexer::getStringID("geometry_type");
+    unsigned int rand = 12345;
+    auto next = [&rand](unsigned int limit) { rand = rand * 1103515245u + 12345u;  return (rand >> 8) % limit; };
+
+    std::vector<TestTile> tiles;
+    for (int ii=0;ii<numTiles;ii++)
+    {
+        TestTile tile;
+        tile.tileID = QuadTreeIdentifier(2620 + ii % 4, 6330 + ii / 4, 14);
+        const auto arena = std::make_shared<AttrArena>();
+        for (const auto &spec : SourceLayers())
+        {
+            for (int fi=0;fi<spec.numFeatures;fi++)
+            {
+                std::vector<FlatAttr> attrs;
+                attrs.emplace_back(geomTypeKey, spec.geomTypes[next((unsigned int)spec.geomTypes.size())]);
+                for (const auto &attrSpec : spec.attrs)
+                {
+                    if ((int)next(100) >= attrSpec.percent)
+                        continue;
+                    const StringIdentity key = StringIndexer::getStringID(attrSpec.name);
+                    if (!attrSpec.strVals.empty())
+                        FlatDictionary::AddAttr(attrs, FlatAttr(key, std::string_view(attrSpec.strVals[next((unsigned int)attrSpec.strVals.size())])));
+                    else if (attrSpec.asDouble)
+                        FlatDictionary::AddAttr(attrs, FlatAttr(key, (double)next(attrSpec.numLimit)));
+                    else
+                        FlatDictionary::AddAttr(attrs, FlatAttr(key, (int)next(attrSpec.numLimit) - (attrSpec.numLimit == 2 ? (int)next(2) : 0)));
+                }
+
+                TestFeature feature;
+                feature.sourceLayer = spec.name;
+                feature.flatAttrs = FlatDictionary::Make(arena, attrs.data(), (unsigned int)attrs.size());
+                feature.attrs = std::make_shared<MutableDictionaryC>();
+                feature.attrs->addEntries(feature.flatAttrs.get());
+                tile.features.push_back(std::move(feature));
+            }
+        }
+        tiles.push_back(std::move(tile));
+    }
+    return tiles;
+}
+
+// What the styles were before the filters were compiled: each layer's filter on its own
+static std::vector<VectorStyleImplRef> StylesByFilter(MapboxVectorStyleSetImpl *styleSet,const Dictionary &attrs,
+                                                      const QuadTreeIdentifier &tileID,const std::string &layerName)
+{
+    std::vector<VectorStyleImplRef> styles;
+    const auto range = styleSet->layersBySource.equal_range(layerName);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (!it->second->filter || it->second->filter->testFeature(attrs, tileID))
+            styles.push_back(it->second);
+    }
+    return styles;
+}
+
+static const int NumTiles = 16;
+
+@interface MapboxVectorFilterTests : XCTestCase
+
+@end
+
+@implementation MapboxVectorFilterTests
+{
+    WhirlyGlobe::GlobeViewRef view;
+    SceneNull *scene;
+    std::shared_ptr<TestStyleSet> styleSet;
+    std::vector<TestTile> tiles;
+}
+
+- (void)setUp {
+    view = std::make_shared<WhirlyGlobe::GlobeView>(nullptr);
+    scene = new SceneNull(view->coordAdapter);
+    styleSet = std::make_shared<TestStyleSet>(scene, view->coordAdapter->getCoordSystem());
+    styleSet->parse(nullptr, MakeStyleSheet());
+    tiles = MakeTiles(NumTiles);
+}
+
+- (void)tearDown {
+    tiles.clear();
+    styleSet = nullptr;
+    scene->teardown(nullptr);
+    delete scene;
+    scene = nullptr;
+    view = nullptr;
+}
+
+// Every layer made it in and its filter was compiled
+- (void)testParse {
+    XCTAssertEqual(styleSet->layers.size(), 43);
+    XCTAssertEqual(styleSet->filtersBySource.size(), 8);
+    for (const auto &it : styleSet->filtersBySource)
+    {
+        XCTAssertEqual(it.second.layers.size(), styleSet->layersBySource.count(it.first));
+        for (const auto &layerFilter : it.second.layers)
+            XCTAssertEqual(layerFilter.second < 0, !layerFilter.first->filter);
+    }
+}
+
+// The compiled filters agree with testFeature for every layer and feature,
+//  for the tile parser's flat records and for regular dictionaries
+- (void)testMatchesTestFeature {
+    MapboxVectorFilterProgram::State state;
+    int numMatched = 0, numTested = 0;
+    for (const auto &tile : tiles)
+        for (const auto &feature : tile.features)
+        {
+            const auto it = styleSet->filtersBySource.find(feature.sourceLayer);
+            if (it == styleSet->filtersBySource.end())
+                continue;
+            const auto &filters = it->second;
+            for (const Dictionary *attrs : {(const Dictionary *)feature.flatAttrs.get(),(const Dictionary *)feature.attrs.get()})
+            {
+                filters.program.begin(state, *attrs, tile.tileID);
+                for (const auto &layerFilter : filters.layers)
+                {
+                    const MapboxVectorFilterRef &filter = layerFilter.first->filter;
+                    const bool expected = !filter || filter->testFeature(*attrs, tile.tileID);
+                    const bool result = filters.program.test(state, layerFilter.second);
+                    XCTAssertEqual(result, expected, @"Layer %s", layerFilter.first->ident.c_str());
+                    numMatched += result;
+                    numTested++;
+                }
+            }
+        }
+    // Make sure the data actually exercises the filters
+    XCTAssertGreaterThan(numMatched, numTested / 20);
+    XCTAssertLessThan(numMatched, numTested / 2);
+}
+
+// The style set hands back the same styles, in the same order, as testing each layer
+- (void)testStylesForFeature {
+    for (const auto &tile : tiles)
+        for (const auto &feature : tile.features)
+        {
+            const auto styles = styleSet->stylesForFeature(nullptr, *feature.flatAttrs, tile.tileID, feature.sourceLayer);
+            const auto expected = StylesByFilter(styleSet.get(), *feature.flatAttrs, tile.tileID, feature.sourceLayer);
+            XCTAssertTrue(styles == expected);
+        }
+}
+
+// Style matching for the tile set with the compiled filters
+- (void)testStylesForFeaturePerformance {
+    [self measureBlock:^{
+        size_t numStyles = 0;
+        for (int pass=0;pass<4;pass++)
+            for (const auto &tile : tiles)
+                for (const auto &feature : tile.features)
+                    numStyles += styleSet->stylesForFeature(nullptr, *feature.flatAttrs, tile.tileID, feature.sourceLayer).size();
+        XCTAssertGreaterThan(numStyles, 0);
+    }];
+}
+
+// The same, testing each layer's filter on its own
+- (void)testFilterPerformance {
+    [self measureBlock:^{
+        size_t numStyles = 0;
+        for (int pass=0;pass<4;pass++)
+            for (const auto &tile : tiles)
+                for (const auto &feature : tile.features)
+                    numStyles += StylesByFilter(styleSet.get(), *feature.flatAttrs, tile.tileID, feature.sourceLayer).size();
+        XCTAssertGreaterThan(numStyles, 0);
+    }];
+}
+
+@end
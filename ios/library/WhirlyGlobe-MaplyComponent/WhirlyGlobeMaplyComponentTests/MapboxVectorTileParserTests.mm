@@ -0,0 +1,554 @@
+//
+//  MapboxVectorTileParserTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <algorithm>
+#import <atomic>
+#import <cstdlib>
+#import <map>
+#import <new>
+#import <string>
+#import <thread>
+#import <vector>
+#import "MapboxVectorTileParser.h"
+#import "MaplyVectorStyleC.h"
+#import "MBTilesReader.h"
+#import "Tesselator.h"
+
+using namespace WhirlyKit;
+
+// Count heap allocations, so the parser benchmarks can report them per tile
+static std::atomic<size_t> NumAllocations { 0 };
+
+void *operator new(size_t size)
+{
+    NumAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+// Just enough protobuf to write a Mapbox Vector Tile
+struct PBFWriter
+{
+    std::string buf;
+
+    void varint(uint64_t val)
+    {
+        while (val >= 0x80)
+        {
+            buf.push_back((char)((val & 0x7f) | 0x80));
+            val >>= 7;
+        }
+        buf.push_back((char)val);
+    }
+    void uintField(uint32_t field,uint64_t val) { varint(field << 3);  varint(val); }
+    void bytesField(uint32_t field,const std::string &str) { varint((field << 3) | 2);  varint(str.size());  buf += str; }
+    void packedField(uint32_t field,const std::vector<uint32_t> &vals)
+    {
+        PBFWriter packed;
+        for (uint32_t val : vals)
+            packed.varint(val);
+        bytesField(field, packed.buf);
+    }
+};
+
+static uint32_t ZigZag(int val) { return (uint32_t)((val << 1) ^ (val >> 31)); }
+static uint32_t Command(int cmd,int count) { return (uint32_t)((cmd & 0x7) | (count << 3)); }
+
+// Geometry commands for a lumpy ring or a wandering line around the given center, in tile units
+static std::vector<uint32_t> MakeGeometry(int cx,int cy,int numPts,bool ring,int seed)
+{
+    std::vector<uint32_t> geom;
+    int lastX = 0, lastY = 0;
+    for (int ii=0;ii<numPts;ii++)
+    {
+        int x, y;
+        if (ring)
+        {
+            const double ang = 2*M_PI * ii / numPts;
+            const double rad = 40.0 + 15.0 * sin(ang * (3 + seed % 4)) + (seed * 7 + ii * 13) % 9;
+            x = cx + (int)(rad * cos(ang));
+            y = cy - (int)(rad * sin(ang));
+        }
+        else
+        {
+            x = cx + ii * 6 - numPts * 3;
+            y = cy + (int)(20.0 * sin(ii * 0.3 + seed));
+        }
+        if (ii == 0)
+            geom.push_back(Command(SEG_MOVETO, 1));
+        else if (ii == 1)
+            geom.push_back(Command(SEG_LINETO, numPts - 1));
+        geom.push_back(ZigZag(x - lastX));
+        geom.push_back(ZigZag(y - lastY));
+        lastX = x;  lastY = y;
+    }
+    if (ring)
+        geom.push_back(Command(SEG_CLOSE_MASKED, 1));
+    return geom;
+}
+
+// A busy tile: each layer is a mix of polygons and lines, about like a dense z14 tile
+static std::string MakeTile(int numLayers,int featuresPerLayer,int ringSize,int seed)
+{
+    PBFWriter tile;
+    for (int li=0;li<numLayers;li++)
+    {
+        PBFWriter layer;
+        layer.uintField(15, 2);
+        layer.bytesField(1, "layer" + std::to_string(li));
+        for (int fi=0;fi<featuresPerLayer;fi++)
+        {
+            const bool ring = (fi + li) % 4 != 0;
+            PBFWriter feature;
+            feature.uintField(1, fi);
+            feature.packedField(2, { 0, (uint32_t)(fi % 3), 1, (uint32_t)(3 + fi % 2) });
+            feature.uintField(3, ring ? GeomTypePolygon : GeomTypeLineString);
+            feature.packedField(4, MakeGeometry(200 + (fi * 97 + seed * 31) % 3700, 200 + (fi * 61 + li * 17) % 3700,
+                                                ring ? ringSize : ringSize / 2, ring, fi + seed));
+            layer.bytesField(2, feature.buf);
+        }
+        layer.bytesField(3, "class");
+        layer.bytesField(3, "rank");
+        for (const char *val : { "residential", "park", "water" })
+        {
+            PBFWriter value;
+            value.bytesField(1, val);
+            layer.bytesField(4, value.buf);
+        }
+        for (int val : { 1, 2 })
+        {
+            PBFWriter value;
+            value.uintField(4, val);
+            layer.bytesField(4, value.buf);
+        }
+        layer.uintField(5, 4096);
+        tile.bytesField(3, layer.buf);
+    }
+    return tile.buf;
+}
+
+// Stands in for a fill or line layer.  Tesselates its areals, which is where the time goes for real ones.
+class TestStyle : public VectorStyleImpl
+{
+public:
+    TestStyle(long long uuid,std::string category) : uuid(uuid), category(std::move(category)) { }
+
+    virtual long long getUuid(PlatformThreadInfo *inst) override { return uuid; }
+    virtual std::string getCategory(PlatformThreadInfo *inst) override { return category; }
+    virtual bool geomAdditive(PlatformThreadInfo *inst) override { return false; }
+
+    virtual void buildObjects(PlatformThreadInfo *inst,
+                              const std::vector<VectorObjectRef> &vecObjs,
+                              const VectorTileDataRef &tileInfo,
+                              const Dictionary *desc,
+                              const CancelFunction &cancelFn) override
+    {
+        size_t numTris = 0, numPts = 0;
+        for (const auto &vecObj : vecObjs)
+        {
+            if (cancelFn(inst))
+                return;
+            for (const auto &shape : vecObj->shapes)
+            {
+                if (const auto areal = std::dynamic_pointer_cast<VectorAreal>(shape))
+                {
+                    VectorTrianglesRef tris = VectorTriangles::createTriangles();
+                    TesselateLoops(areal->loops, tris);
+                    numTris += tris->tris.size();
+                }
+                else if (const auto lin = std::dynamic_pointer_cast<VectorLinear>(shape))
+                {
+                    numPts += lin->pts.size();
+                }
+            }
+        }
+
+        auto compObj = std::make_shared<ComponentObject>(false, false);
+        compObj->uuid = std::to_string(uuid) + ":" + std::to_string(numTris) + ":" + std::to_string(numPts);
+        tileInfo->compObjs.push_back(compObj);
+        built++;
+    }
+
+    const long long uuid;
+    const std::string category;
+    std::atomic<int> built { 0 };
+};
+typedef std::shared_ptr<TestStyle> TestStyleRef;
+
+// One style per layer
+class TestStyleDelegate : public VectorStyleDelegateImpl
+{
+public:
+    TestStyleDelegate(int numLayers)
+    {
+        for (int li=0;li<numLayers;li++)
+        {
+            auto style = std::make_shared<TestStyle>(li + 1, (li % 3 == 0) ? "every-third" : "");
+            stylesByLayer["layer" + std::to_string(li)] = style;
+            stylesByUUID[style->uuid] = style;
+        }
+    }
+
+    virtual std::vector<VectorStyleImplRef> stylesForFeature(PlatformThreadInfo *inst,
+                                                             const Dictionary &attrs,
+                                                             const QuadTreeIdentifier &tileID,
+                                                             const std::string &layerName) override
+    {
+        const auto it = stylesByLayer.find(layerName);
+        return (it == stylesByLayer.end()) ? std::vector<VectorStyleImplRef>() : std::vector<VectorStyleImplRef> { it->second };
+    }
+    virtual bool layerShouldDisplay(PlatformThreadInfo *inst,const std::string &name,const QuadTreeNew::Node &tileID) override
+    {
+        return stylesByLayer.find(name) != stylesByLayer.end();
+    }
+    virtual VectorStyleImplRef styleForUUID(PlatformThreadInfo *inst,long long uuid) override
+    {
+        const auto it = stylesByUUID.find(uuid);
+        return (it == stylesByUUID.end()) ? VectorStyleImplRef() : it->second;
+    }
+    virtual std::vector<VectorStyleImplRef> allStyles(PlatformThreadInfo *inst) override
+    {
+        std::vector<VectorStyleImplRef> styles;
+        for (const auto &it : stylesByUUID)
+            styles.push_back(it.second);
+        return styles;
+    }
+    virtual VectorStyleImplRef backgroundStyle(PlatformThreadInfo *inst) const override { return VectorStyleImplRef(); }
+    virtual RGBAColorRef backgroundColor(PlatformThreadInfo *inst,double zoom) override { return RGBAColorRef(); }
+
+    std::map<std::string,TestStyleRef> stylesByLayer;
+    std::map<long long,TestStyleRef> stylesByUUID;
+};
+
+// Only counts what it gets, so parsing is all we time
+class CountingStyle : public VectorStyleImpl
+{
+public:
+    virtual long long getUuid(PlatformThreadInfo *inst) override { return 1; }
+    virtual std::string getCategory(PlatformThreadInfo *inst) override { return std::string(); }
+    virtual bool geomAdditive(PlatformThreadInfo *inst) override { return false; }
+
+    virtual void buildObjects(PlatformThreadInfo *inst,
+                              const std::vector<VectorObjectRef> &vecObjs,
+                              const VectorTileDataRef &tileInfo,
+                              const Dictionary *desc,
+                              const CancelFunction &cancelFn) override
+    {
+        built += vecObjs.size();
+    }
+
+    std::atomic<size_t> built { 0 };
+};
+typedef std::shared_ptr<CountingStyle> CountingStyleRef;
+
+// Styles every feature, or just the ones with about a third of the "class" values, like a typical map style
+class FilterStyleDelegate : public VectorStyleDelegateImpl
+{
+public:
+    FilterStyleDelegate(bool selective) : selective(selective), style(std::make_shared<CountingStyle>()) { }
+
+    virtual std::vector<VectorStyleImplRef> stylesForFeature(PlatformThreadInfo *inst,
+                                                             const Dictionary &attrs,
+                                                             const QuadTreeIdentifier &tileID,
+                                                             const std::string &layerName) override
+    {
+        if (selective && std::hash<std::string>()(attrs.getString("class")) % 3 != 0)
+            return std::vector<VectorStyleImplRef>();
+        return std::vector<VectorStyleImplRef> { style };
+    }
+    virtual bool layerShouldDisplay(PlatformThreadInfo *inst,const std::string &name,const QuadTreeNew::Node &tileID) override
+    {
+        return true;
+    }
+    virtual VectorStyleImplRef styleForUUID(PlatformThreadInfo *inst,long long uuid) override
+    {
+        return uuid == style->getUuid(inst) ? style : VectorStyleImplRef();
+    }
+    virtual std::vector<VectorStyleImplRef> allStyles(PlatformThreadInfo *inst) override
+    {
+        return std::vector<VectorStyleImplRef> { style };
+    }
+    virtual VectorStyleImplRef backgroundStyle(PlatformThreadInfo *inst) const override { return VectorStyleImplRef(); }
+    virtual RGBAColorRef backgroundColor(PlatformThreadInfo *inst,double zoom) override { return RGBAColorRef(); }
+
+    const bool selective;
+    CountingStyleRef style;
+};
+
+static const int NumLayers = 12;
+
+// Tile data for one tile, z14 unless otherwise specified, in spherical mercator
+static VectorTileDataRef MakeTileData(int x,int y,int level = 14)
+{
+    auto tileData = std::make_shared<VectorTileData>();
+    tileData->ident = QuadTreeIdentifier(x, y, level);
+    const double maxExtent = 20037508.342789244;
+    const double size = 2 * maxExtent / (1 << level);
+    tileData->bbox.addPoint(Point2d(-maxExtent + x * size, maxExtent - (y+1) * size));
+    tileData->bbox.addPoint(Point2d(-maxExtent + (x+1) * size, maxExtent - y * size));
+    return tileData;
+}
+
+static std::vector<std::string> ComponentUUIDs(const VectorTileData &tileData)
+{
+    std::vector<std::string> uuids;
+    for (const auto &compObj : tileData.compObjs)
+        uuids.push_back(compObj->uuid);
+    return uuids;
+}
+
+// Parse a tile, returning the time it took or a negative value on failure
+static double ParseTile(MapboxVectorTileParser &parser,const std::string &tile,const VectorTileDataRef &tileData)
+{
+    RawDataWrapper rawData(tile.data(), tile.size(), false);
+    PlatformThreadInfo inst;
+    const TimeInterval startTime = TimeGetCurrent();
+    if (!parser.parse(&inst, &rawData, tileData.get(), [](PlatformThreadInfo *){ return false; }))
+        return -1.0;
+    return TimeGetCurrent() - startTime;
+}
+
+static PlatformThreadInfo *MakeThreadInfo() { return new PlatformThreadInfo(); }
+static void ReleaseThreadInfo(PlatformThreadInfo *inst) { delete inst; }
+
+static unsigned int NumBuildThreads()
+{
+    return std::max(2U, std::thread::hardware_concurrency()) - 1;
+}
+
+// Print a histogram of per tile times, in doubling millisecond buckets
+static void LogLatencies(const char *what,std::vector<double> latencies)
+{
+    if (latencies.empty())
+        return;
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&](double frac) { return latencies[std::min(latencies.size()-1, (size_t)(frac * latencies.size()))] * 1000.0; };
+    NSLog(@"%s: %d tiles, p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms", what, (int)latencies.size(),
+          percentile(0.5), percentile(0.9), percentile(0.99), latencies.back() * 1000.0);
+
+    std::map<int,int> buckets;
+    for (double latency : latencies)
+    {
+        int bucket = 0;
+        while (bucket < 10 && latency * 1000.0 >= (1 << bucket))
+            bucket++;
+        buckets[bucket]++;
+    }
+    for (const auto &it : buckets)
+    {
+        NSLog(@"  %4d - %4d ms: %5d %s", it.first ? (1 << (it.first-1)) : 0, 1 << it.first, it.second,
+              std::string(std::max(1, it.second * 60 / (int)latencies.size()), '#').c_str());
+    }
+}
+
+// A tile and where it goes
+struct CorpusTile
+{
+    std::string data;
+    int x,y,level;
+};
+
+// Up to 64 tiles from the middle of the France extract in the resources checkout, if it's there
+static std::vector<CorpusTile> LoadTileCorpus()
+{
+    std::vector<CorpusTile> corpus;
+    const std::string testDir = std::string(__FILE__).substr(0, std::string(__FILE__).find_last_of('/'));
+    MBTilesReader reader(testDir + "/../../../../resources/vectors/France.mbtiles");
+    if (!reader.open())
+        return corpus;
+
+    const int level = std::min(reader.getMaxZoom(), 14);
+    const int numTiles = 1 << level;
+    const Point2f mid = reader.getGeoMbr().mid();
+    const int midX = (int)((mid.x() + M_PI) / (2*M_PI) * numTiles);
+    const int midY = (int)((1.0 - log(tan(mid.y()) + 1.0/cos(mid.y())) / M_PI) / 2.0 * numTiles);
+
+    std::vector<QuadTreeIdentifier> idents;
+    for (int iy=-4;iy<4;iy++)
+        for (int ix=-4;ix<4;ix++)
+            // Rows are TMS in the file
+            idents.emplace_back(midX + ix, numTiles - 1 - (midY + iy), level);
+    const std::vector<RawDataRef> tiles = reader.fetchTiles(idents);
+    for (unsigned int ii=0;ii<tiles.size();ii++)
+        if (tiles[ii])
+            corpus.push_back({ std::string((const char *)tiles[ii]->getRawData(), tiles[ii]->getLen()),
+                               idents[ii].x, numTiles - 1 - idents[ii].y, level });
+    return corpus;
+}
+
+@interface MapboxVectorTileParserTests : XCTestCase
+
+@end
+
+@implementation MapboxVectorTileParserTests
+{
+    std::shared_ptr<TestStyleDelegate> styleDelegate;
+    std::vector<std::string> tiles;
+}
+
+- (void)setUp {
+    styleDelegate = std::make_shared<TestStyleDelegate>(NumLayers);
+    for (int ii=0;ii<16;ii++)
+        tiles.push_back(MakeTile(NumLayers, 300, 64, ii));
+}
+
+- (void)tearDown {
+    tiles.clear();
+    styleDelegate = nullptr;
+}
+
+// The parallel build hands back the same objects, in the same order, as the serial one
+- (void)testParallelMatchesSerial {
+    PlatformThreadInfo inst;
+    MapboxVectorTileParser serial(&inst, styleDelegate);
+    MapboxVectorTileParser parallel(&inst, styleDelegate);
+    parallel.setParallelBuild(NumBuildThreads(), MakeThreadInfo, ReleaseThreadInfo);
+
+    for (int which=0;which<4;which++)
+    {
+        VectorTileDataRef serialData = MakeTileData(2620 + which, 6332);
+        VectorTileDataRef parallelData = MakeTileData(2620 + which, 6332);
+        XCTAssertTrue(ParseTile(serial, tiles[which], serialData) >= 0.0);
+        XCTAssertTrue(ParseTile(parallel, tiles[which], parallelData) >= 0.0);
+
+        XCTAssertEqual(serialData->compObjs.size(), (size_t)NumLayers);
+        XCTAssertTrue(ComponentUUIDs(*serialData) == ComponentUUIDs(*parallelData));
+        XCTAssertEqual(serialData->categories.size(), (size_t)1);
+        XCTAssertEqual(parallelData->categories.size(), serialData->categories.size());
+        XCTAssertEqual(parallelData->categories["every-third"].size(), serialData->categories["every-third"].size());
+    }
+
+    // Turning it off again goes back to building on the calling thread
+    parallel.setParallelBuild(0);
+    VectorTileDataRef offData = MakeTileData(2620, 6332);
+    XCTAssertTrue(ParseTile(parallel, tiles[0], offData) >= 0.0);
+    XCTAssertEqual(offData->compObjs.size(), (size_t)NumLayers);
+}
+
+// Cancelling partway through the styles stops the parse, serial or parallel
+- (void)testCancel {
+    PlatformThreadInfo inst;
+    for (bool useParallel : { false, true })
+    {
+        MapboxVectorTileParser parser(&inst, styleDelegate);
+        if (useParallel)
+            parser.setParallelBuild(NumBuildThreads(), MakeThreadInfo, ReleaseThreadInfo);
+
+        int builtBefore = 0;
+        for (const auto &it : styleDelegate->stylesByUUID)
+            builtBefore += it.second->built;
+
+        // Cancel once the first style has been built
+        const auto cancelFn = [&](PlatformThreadInfo *)
+        {
+            int built = 0;
+            for (const auto &it : styleDelegate->stylesByUUID)
+                built += it.second->built;
+            return built > builtBefore;
+        };
+
+        VectorTileDataRef tileData = MakeTileData(2620, 6332);
+        RawDataWrapper rawData(tiles[0].data(), tiles[0].size(), false);
+        XCTAssertFalse(parser.parse(&inst, &rawData, tileData.get(), cancelFn));
+
+        int builtAfter = 0;
+        for (const auto &it : styleDelegate->stylesByUUID)
+            builtAfter += it.second->built;
+        XCTAssertLessThan(builtAfter - builtBefore, NumLayers);
+    }
+}
+
+// Per tile latency for a run of tiles, then a histogram of the times
+- (void)timeTiles:(bool)useParallel {
+    PlatformThreadInfo inst;
+    auto parser = std::make_shared<MapboxVectorTileParser>(&inst, styleDelegate);
+    if (useParallel)
+        parser->setParallelBuild(NumBuildThreads(), MakeThreadInfo, ReleaseThreadInfo);
+
+    __block std::vector<double> latencies;
+    [self measureBlock:^{
+        for (int which=0;which<(int)tiles.size() * 2;which++)
+        {
+            VectorTileDataRef tileData = MakeTileData(2620 + which % 8, 6332 + which / 8);
+            const double howLong = ParseTile(*parser, tiles[which % tiles.size()], tileData);
+            XCTAssertTrue(howLong >= 0.0);
+            latencies.push_back(howLong);
+        }
+    }];
+
+    LogLatencies(useParallel ? "Parallel build" : "Serial build", latencies);
+}
+
+- (void)testSerialBuildLatency {
+    [self timeTiles:false];
+}
+
+- (void)testParallelBuildLatency {
+    [self timeTiles:true];
+}
+
+// Parse the real tiles if we have them or the synthetic ones if not, reporting tiles/s and allocations per tile
+- (void)parseCorpus:(bool)selective {
+    std::vector<CorpusTile> corpus = LoadTileCorpus();
+    const bool realTiles = !corpus.empty();
+    if (!realTiles)
+        for (unsigned int ii=0;ii<tiles.size();ii++)
+            corpus.push_back({ tiles[ii], 2620 + (int)ii % 8, 6332 + (int)ii / 8, 14 });
+
+    PlatformThreadInfo inst;
+    auto delegate = std::make_shared<FilterStyleDelegate>(selective);
+    MapboxVectorTileParser parser(&inst, delegate);
+
+    // Warm up the per thread buffers
+    XCTAssertTrue(ParseTile(parser, corpus.front().data, MakeTileData(corpus.front().x, corpus.front().y, corpus.front().level)) >= 0.0);
+
+    [self measureBlock:^{
+        const size_t builtBefore = delegate->style->built;
+        const size_t allocsBefore = NumAllocations;
+        double parseTime = 0.0;
+        for (const auto &tile : corpus)
+        {
+            const double howLong = ParseTile(parser, tile.data, MakeTileData(tile.x, tile.y, tile.level));
+            XCTAssertTrue(howLong >= 0.0);
+            parseTime += howLong;
+        }
+        NSLog(@"%s tiles, %s styles: %.0f tiles/s, %.0f allocations and %.0f features built per tile",
+              realTiles ? "Real" : "Synthetic", selective ? "selective" : "all inclusive",
+              corpus.size() / parseTime, (double)(NumAllocations - allocsBefore) / corpus.size(),
+              (double)(delegate->style->built - builtBefore) / corpus.size());
+    }];
+}
+
+// A style that only wants some of the features, so most are rejected before they're built
+- (void)testParseSelectivePerformance {
+    [self parseCorpus:true];
+}
+
+// Every feature gets built, which is what the parser had to do for everything before filtering first
+- (void)testParseAllPerformance {
+    [self parseCorpus:false];
+}
+
+@end
@@ -0,0 +1,272 @@
+//
+//  MappedShapeReaderTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <cmath>
+#import <string>
+#import <vector>
+#import <sys/stat.h>
+#import <unistd.h>
+#import "ShapeReader.h"
+#import "MappedShapeReader.h"
+#import "Platform.h"
+#import "shapefile/shapefil.h"
+
+using namespace WhirlyKit;
+
+// Enough records for a few million vertices, like a detailed coastline extract
+static const int CoastRecords = 1000;
+static const int CoastVerts = 2000;
+
+// Write out a polygon shapefile of wiggly coastlines, every fifth one with an island,
+//  along with the sort of attributes Natural Earth files carry
+static bool WriteCoastline(const std::string &baseName,int numRecords,int vertsPerRecord)
+{
+    SHPHandle shp = SHPCreate(baseName.c_str(), SHPT_POLYGON);
+    DBFHandle dbf = DBFCreate(baseName.c_str());
+    if (!shp || !dbf)
+    {
+        if (shp)
+            SHPClose(shp);
+        if (dbf)
+            DBFClose(dbf);
+        return false;
+    }
+    DBFAddField(dbf, "featurecla", FTString, 32, 0);
+    DBFAddField(dbf, "scalerank", FTInteger, 4, 0);
+    DBFAddField(dbf, "min_zoom", FTDouble, 8, 1);
+    DBFAddField(dbf, "name", FTString, 64, 0);
+    DBFAddField(dbf, "note", FTString, 128, 0);
+
+    unsigned int rand = 1357;
+    auto next = [&rand](unsigned int limit) { rand = rand * 1103515245u + 12345u;  return (rand >> 8) % limit; };
+
+    std::vector<double> xs,ys;
+    std::vector<int> partStarts;
+    for (int ri=0;ri<numRecords;ri++)
+    {
+        xs.clear();  ys.clear();  partStarts.clear();
+        const double cx = -170.0 + next(3400) / 10.0, cy = -70.0 + next(1400) / 10.0;
+        const int numParts = ri % 5 == 0 ? 2 : 1;
+        for (int pi=0;pi<numParts;pi++)
+        {
+            // Islands are smaller and off to the side
+            const double px = cx + pi * 4.0, rad = pi ? 0.5 : 2.0;
+            const int numVerts = pi ? vertsPerRecord / 10 : vertsPerRecord;
+            const int wiggles = 5 + next(20);
+            partStarts.push_back(xs.size());
+            for (int vi=0;vi<numVerts;vi++)
+            {
+                // Clockwise, as shapefile outer rings are
+                const double ang = -2.0 * M_PI * vi / numVerts;
+                const double r = rad * (1.0 + 0.3 * sin(wiggles * ang) + next(100) / 2000.0);
+                xs.push_back(px + r * cos(ang));
+                ys.push_back(cy + r * sin(ang));
+            }
+            xs.push_back(xs[partStarts.back()]);
+            ys.push_back(ys[partStarts.back()]);
+        }
+
+        SHPObject *obj = SHPCreateObject(SHPT_POLYGON, -1, partStarts.size(), partStarts.data(), nullptr,
+                                         xs.size(), xs.data(), ys.data(), nullptr, nullptr);
+        SHPWriteObject(shp, -1, obj);
+        SHPDestroyObject(obj);
+
+        DBFWriteStringAttribute(dbf, ri, 0, "Coastline");
+        DBFWriteIntegerAttribute(dbf, ri, 1, next(10));
+        DBFWriteDoubleAttribute(dbf, ri, 2, next(100) / 10.0);
+        DBFWriteStringAttribute(dbf, ri, 3, ("Coast " + std::to_string(ri)).c_str());
+        DBFWriteStringAttribute(dbf, ri, 4, "Digitized from 1:10m sources, generalized for small scales");
+    }
+
+    SHPClose(shp);
+    DBFClose(dbf);
+    return true;
+}
+
+static unsigned int CountVertices(const VectorShapeRef &shape)
+{
+    unsigned int numVerts = 0;
+    if (const auto areal = std::dynamic_pointer_cast<VectorAreal>(shape))
+        for (const VectorRing &ring : areal->loops)
+            numVerts += ring.size();
+    return numVerts;
+}
+
+@interface MappedShapeReaderTests : XCTestCase
+
+@end
+
+@implementation MappedShapeReaderTests
+{
+    std::string dir;
+    std::string baseName;
+}
+
+- (void)setUp {
+    NSString *tmpDir = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    dir = [tmpDir UTF8String];
+    mkdir(dir.c_str(), 0755);
+    baseName = dir + "/coast";
+}
+
+- (void)tearDown {
+    for (const char *ext : { ".shp", ".shx", ".dbf" })
+        unlink((baseName + ext).c_str());
+    rmdir(dir.c_str());
+}
+
+// Same shapes and attributes as shapelib, whichever way we read them
+- (void)testMatchesShapeReader {
+    XCTAssertTrue(WriteCoastline(baseName, 200, 100));
+    ShapeReader shapeReader(baseName + ".shp");
+    MappedShapeReader mappedReader(baseName + ".shp");
+    XCTAssertTrue(shapeReader.isValid());
+    XCTAssertTrue(mappedReader.isValid());
+    XCTAssertEqual(mappedReader.getNumObjects(), shapeReader.getNumObjects());
+
+    while (VectorShapeRef shape = shapeReader.getNextObject(nullptr))
+    {
+        VectorShapeRef mappedShape = mappedReader.getNextObject(nullptr);
+        const auto areal = std::dynamic_pointer_cast<VectorAreal>(shape);
+        const auto mappedAreal = std::dynamic_pointer_cast<VectorAreal>(mappedShape);
+        XCTAssertTrue(areal && mappedAreal);
+        if (!areal || !mappedAreal)
+            break;
+        XCTAssertTrue(mappedAreal->loops == areal->loops);
+
+        const auto attrs = shape->getAttrDict();
+        const auto mappedAttrs = mappedShape->getAttrDict();
+        XCTAssertEqual(mappedAttrs->count(), attrs->count());
+        for (const char *name : { "featurecla", "name", "note" })
+            XCTAssertTrue(mappedAttrs->getString(name) == attrs->getString(name));
+        XCTAssertEqual(mappedAttrs->getInt("scalerank"), attrs->getInt("scalerank"));
+        XCTAssertEqual(mappedAttrs->getDouble("min_zoom"), attrs->getDouble("min_zoom"));
+        XCTAssertEqual(mappedAttrs->getInt("wgshapefileidx"), attrs->getInt("wgshapefileidx"));
+    }
+    XCTAssertFalse(mappedReader.getNextObject(nullptr));
+
+    // Batches cover everything, and only carry the attributes asked for
+    const StringSet filterAttrs = { "scalerank" };
+    unsigned int numShapes = 0;
+    for (const auto &batch : mappedReader.readBatches(64, &filterAttrs, 4))
+        for (const auto &shape : batch->shapes)
+        {
+            XCTAssertEqual(shape->getAttrDict()->count(), 2);
+            XCTAssertTrue(shape->getAttrDict()->hasField("scalerank"));
+            numShapes++;
+        }
+    XCTAssertEqual(numShapes, 200);
+}
+
+// Null records are skipped by the batch reader unless asked for, and fromShapeFile keeps them like ShapeReader did
+- (void)testNullRecords {
+    SHPHandle shp = SHPCreate(baseName.c_str(), SHPT_POLYGON);
+    XCTAssertTrue(shp);
+    if (!shp)
+        return;
+    const double xs[] = { 0.0, 1.0, 1.0, 0.0 }, ys[] = { 0.0, 0.0, 1.0, 0.0 };
+    for (int ri=0;ri<10;ri++)
+    {
+        SHPObject *obj = ri % 3 == 0 ? SHPCreateSimpleObject(SHPT_NULL, 0, nullptr, nullptr, nullptr) :
+                                       SHPCreateSimpleObject(SHPT_POLYGON, 4, xs, ys, nullptr);
+        SHPWriteObject(shp, -1, obj);
+        SHPDestroyObject(obj);
+    }
+    SHPClose(shp);
+
+    MappedShapeReader reader(baseName + ".shp");
+    XCTAssertTrue(reader.isValid());
+    XCTAssertEqual(reader.getNumObjects(), 10);
+
+    unsigned int numShapes = 0, numEmpty = 0;
+    for (const auto &batch : reader.readBatches(4, nullptr, 2))
+        numShapes += batch->shapes.size();
+    XCTAssertEqual(numShapes, 6);
+
+    numShapes = 0;
+    for (const auto &batch : reader.readBatches(4, nullptr, 2, true))
+        for (const auto &shape : batch->shapes)
+        {
+            XCTAssertTrue(std::dynamic_pointer_cast<VectorAreal>(shape));
+            numShapes++;
+            numEmpty += CountVertices(shape) == 0;
+        }
+    XCTAssertEqual(numShapes, 10);
+    XCTAssertEqual(numEmpty, 4);
+
+    VectorObject vecObj;
+    XCTAssertTrue(vecObj.fromShapeFile(baseName + ".shp"));
+    XCTAssertEqual(vecObj.shapes.size(), 10);
+}
+
+// Reading the coastline a record at a time through shapelib, for comparison
+- (void)testShapeReaderPerformance {
+    XCTAssertTrue(WriteCoastline(baseName, CoastRecords, CoastVerts));
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        ShapeReader reader(baseName + ".shp");
+        unsigned int numVerts = 0;
+        while (VectorShapeRef shape = reader.getNextObject(nullptr))
+            numVerts += CountVertices(shape);
+        NSLog(@"ShapeReader: %d vertices in %.1f ms", numVerts, (TimeGetCurrent() - startTime) * 1000.0);
+    }];
+}
+
+- (void)testMappedReaderPerformance {
+    XCTAssertTrue(WriteCoastline(baseName, CoastRecords, CoastVerts));
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        MappedShapeReader reader(baseName + ".shp");
+        unsigned int numVerts = 0;
+        for (const auto &batch : reader.readBatches(64, nullptr, 1))
+            for (const auto &shape : batch->shapes)
+                numVerts += CountVertices(shape);
+        NSLog(@"MappedShapeReader, one thread: %d vertices in %.1f ms", numVerts, (TimeGetCurrent() - startTime) * 1000.0);
+    }];
+}
+
+- (void)testMappedReaderThreadsPerformance {
+    XCTAssertTrue(WriteCoastline(baseName, CoastRecords, CoastVerts));
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        MappedShapeReader reader(baseName + ".shp");
+        unsigned int numVerts = 0;
+        for (const auto &batch : reader.readBatches(64, nullptr, 0))
+            for (const auto &shape : batch->shapes)
+                numVerts += CountVertices(shape);
+        NSLog(@"MappedShapeReader, all cores: %d vertices in %.1f ms", numVerts, (TimeGetCurrent() - startTime) * 1000.0);
+    }];
+}
+
+// Just the one attribute the style needs
+- (void)testMappedReaderProjectedPerformance {
+    XCTAssertTrue(WriteCoastline(baseName, CoastRecords, CoastVerts));
+    const StringSet filterAttrs = { "scalerank" };
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        MappedShapeReader reader(baseName + ".shp");
+        unsigned int numVerts = 0;
+        for (const auto &batch : reader.readBatches(64, &filterAttrs, 0))
+            for (const auto &shape : batch->shapes)
+                numVerts += CountVertices(shape);
+        NSLog(@"MappedShapeReader, all cores, one attribute: %d vertices in %.1f ms", numVerts, (TimeGetCurrent() - startTime) * 1000.0);
+    }];
+}
+
+@end
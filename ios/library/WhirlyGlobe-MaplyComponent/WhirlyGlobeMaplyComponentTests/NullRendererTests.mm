@@ -0,0 +1,388 @@
+//
+//  NullRendererTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <algorithm>
+#import <set>
+#import <vector>
+#import "SceneRendererNull.h"
+#import "DrawableBuilderNull.h"
+#import "TextureNull.h"
+#import "GlobeView.h"
+
+using namespace WhirlyKit;
+
+// Triangles in each of our pretend tiles
+static const int TileGridSize = 8;
+static const int TileTris = TileGridSize * TileGridSize * 2;
+static const int TilePoints = (TileGridSize + 1) * (TileGridSize + 1);
+
+// Position of a point in one of our patches on the globe
+static Point3d PatchPoint(const Point2d &org,double size,int ix,int iy)
+{
+    const Point2d geo(org.x() + size * ix / TileGridSize, org.y() + size * iy / TileGridSize);
+    const double cosLat = cos(geo.y());
+    return Point3d(cosLat * cos(geo.x()), cosLat * sin(geo.x()), sin(geo.y()));
+}
+
+// A gridded patch on the globe, about what a tile loader would hand over
+static BasicDrawableRef MakePatchDrawable(SceneRendererNull *renderer,SimpleIdentity progID,const Point2d &org,double size,
+                                          LocalMbrType mbrType = LocalMbrUnknown)
+{
+    BasicDrawableBuilderRef builder = renderer->makeBasicDrawableBuilder("Null Renderer Tile");
+    builder->setType(Triangles);
+    builder->setProgram(progID);
+    builder->setLocalMbr(Mbr(Point2f(org.x(), org.y()), Point2f(org.x() + size, org.y() + size)), mbrType);
+    builder->reserve(TilePoints, TileTris);
+
+    for (int iy=0;iy<=TileGridSize;iy++)
+        for (int ix=0;ix<=TileGridSize;ix++)
+            builder->addPoint(PatchPoint(org, size, ix, iy));
+    for (int iy=0;iy<TileGridSize;iy++)
+        for (int ix=0;ix<TileGridSize;ix++)
+        {
+            const int ll = iy * (TileGridSize + 1) + ix;
+            builder->addTriangle(BasicDrawable::Triangle(ll, ll+1, ll+TileGridSize+2));
+            builder->addTriangle(BasicDrawable::Triangle(ll, ll+TileGridSize+2, ll+TileGridSize+1));
+        }
+
+    return builder->getDrawable();
+}
+
+static BasicDrawableRef MakeTileDrawable(SceneRendererNull *renderer,SimpleIdentity progID,int which)
+{
+    const double size = 0.1;
+    const Point2d org(-1.0 + (which % 20) * size, -0.5 + (which / 20 % 10) * size);
+    BasicDrawableRef draw = MakePatchDrawable(renderer, progID, org, size);
+    draw->setDrawPriority(which % 4);
+    return draw;
+}
+
+// Records the order drawables come up for drawing in
+struct DrawOrderTweaker : public DrawableTweaker
+{
+    virtual void tweakForFrame(Drawable *draw,RendererFrameInfo *frame) override
+        { drawIDs.push_back(draw->getId()); }
+
+    std::vector<SimpleIdentity> drawIDs;
+
+protected:
+    virtual float getZoom(const Drawable &inDraw,const Scene &scene,float def) const override { return def; }
+};
+typedef std::shared_ptr<DrawOrderTweaker> DrawOrderTweakerRef;
+
+// Something small, like a label or a bit of vector tile geometry
+static BasicDrawableRef MakeSmallDrawable(SceneRendererNull *renderer,SimpleIdentity progID,int which,
+                                          const DrawableTweakerRef &tweaker = nullptr)
+{
+    BasicDrawableBuilderRef builder = renderer->makeBasicDrawableBuilder("Null Renderer Small");
+    builder->setType(Triangles);
+    builder->setProgram(progID);
+    builder->setDrawPriority((which * 7) % 40);
+    builder->setRequestZBuffer(which % 5 == 0);
+    builder->setOnOff(which % 10 != 9);
+    if (tweaker)
+        builder->addTweaker(tweaker);
+    const Point3d org(1.0, (which % 100) * 0.001, (which / 100 % 100) * 0.001);
+    builder->addPoint(org);
+    builder->addPoint(Point3d(org + Point3d(0.0, 0.0005, 0.0)));
+    builder->addPoint(Point3d(org + Point3d(0.0, 0.0, 0.0005)));
+    builder->addTriangle(BasicDrawable::Triangle(0, 1, 2));
+    return builder->getDrawable();
+}
+
+@interface NullRendererTests : XCTestCase
+
+@end
+
+@implementation NullRendererTests
+{
+    WhirlyGlobe::GlobeViewRef view;
+    SceneNull *scene;
+    SceneRendererNullRef renderer;
+    SimpleIdentity progID;
+}
+
+// Same order the render controllers use: renderer, view, scene, then the shaders
+- (void)setUp {
+    renderer = std::make_shared<SceneRendererNull>();
+    renderer->setup(2048, 1536, 2.0);
+
+    view = std::make_shared<WhirlyGlobe::GlobeView>(nullptr);
+    scene = new SceneNull(view->coordAdapter);
+    renderer->setScene(scene);
+    renderer->setView(view.get());
+
+    ProgramNullRef prog = std::make_shared<ProgramNull>("Default Triangle;lighting=no");
+    progID = prog->getId();
+    scene->addProgram(prog);
+}
+
+- (void)tearDown {
+    scene->teardown(nullptr);
+    renderer->setScene(nullptr);
+    delete scene;
+    scene = nullptr;
+    renderer = nullptr;
+    view = nullptr;
+}
+
+// Add the tiles through the change queue, the way the managers do it
+- (std::vector<SimpleIdentity>)addTiles:(int)numTiles {
+    std::vector<SimpleIdentity> drawIDs;
+    ChangeSet changes;
+    for (int ii=0;ii<numTiles;ii++)
+    {
+        BasicDrawableRef draw = MakeTileDrawable(renderer.get(), progID, ii);
+        drawIDs.push_back(draw->getId());
+        changes.push_back(new AddDrawableReq(draw));
+    }
+    scene->addChangeRequests(changes);
+    return drawIDs;
+}
+
+- (void)logFrame:(int)frame {
+    const FrameStatsNull &stats = renderer->getFrameStats();
+    const RenderSetupInfoNull &setupInfo = renderer->getSetupInfo();
+    NSLog(@"Frame %d: %d visible, %d drawn, %d skipped, %lld points, %lld triangles, %lld buffers (%lld bytes)",
+          frame, stats.drawablesVisible, stats.drawablesDrawn, stats.drawablesSkipped,
+          (long long)stats.points, (long long)stats.triangles,
+          (long long)setupInfo.numBuffers.load(), (long long)setupInfo.bufferBytes.load());
+}
+
+// Push tiles in, render a few frames and check what we would have drawn, then take them out again
+- (void)testRenderFrames {
+    const int numTiles = 64;
+    const int numFrames = 10;
+    std::vector<SimpleIdentity> drawIDs = [self addTiles:numTiles];
+
+    // One more without a shader, which should be skipped
+    BasicDrawableRef orphan = MakeTileDrawable(renderer.get(), EmptyIdentity, numTiles);
+    scene->addChangeRequest(new AddDrawableReq(orphan));
+
+    for (int frame=0;frame<numFrames;frame++)
+    {
+        renderer->render(1.0/60.0);
+        [self logFrame:frame];
+
+        const FrameStatsNull &stats = renderer->getFrameStats();
+        XCTAssertEqual(stats.drawablesVisible, numTiles + 1);
+        XCTAssertEqual(stats.drawablesDrawn, numTiles);
+        XCTAssertEqual(stats.drawablesSkipped, 1);
+        XCTAssertEqual(stats.points, (int64_t)numTiles * TilePoints);
+        XCTAssertEqual(stats.triangles, (int64_t)numTiles * TileTris);
+    }
+    XCTAssertEqual(renderer->getSetupInfo().numBuffers.load(), numTiles + 1);
+    XCTAssertTrue(renderer->getSetupInfo().bufferBytes.load() > 0);
+
+    ChangeSet changes;
+    for (SimpleIdentity drawID : drawIDs)
+        changes.push_back(new RemDrawableReq(drawID));
+    changes.push_back(new RemDrawableReq(orphan->getId()));
+    scene->addChangeRequests(changes);
+    renderer->render(1.0/60.0);
+    [self logFrame:numFrames];
+
+    XCTAssertEqual(renderer->getFrameStats().drawablesVisible, 0);
+    XCTAssertEqual(renderer->getFrameStats().triangles, 0);
+    XCTAssertEqual(renderer->getSetupInfo().numBuffers.load(), 0);
+    XCTAssertEqual(renderer->getSetupInfo().bufferBytes.load(), 0);
+}
+
+// Frame loop cost with a full screen's worth of tiles and nothing waiting in the change queue
+- (void)testRenderPerformance {
+    const int numTiles = 200;
+    [self addTiles:numTiles];
+    renderer->render(1.0/60.0);
+    XCTAssertEqual(renderer->getFrameStats().drawablesDrawn, numTiles);
+
+    [self measureBlock:^{
+        for (int frame=0;frame<100;frame++)
+            renderer->render(1.0/60.0);
+    }];
+    [self logFrame:100];
+}
+
+// Add a lot of small drawables and render once so they're all in the scene
+- (std::vector<BasicDrawableRef>)addSmallDrawables:(int)numDrawables tweaker:(DrawableTweakerRef)tweaker {
+    std::vector<BasicDrawableRef> draws;
+    ChangeSet changes;
+    for (int ii=0;ii<numDrawables;ii++)
+    {
+        draws.push_back(MakeSmallDrawable(renderer.get(), progID, ii, tweaker));
+        changes.push_back(new AddDrawableReq(draws.back()));
+    }
+    scene->addChangeRequests(changes);
+    renderer->render(1.0/60.0);
+    return draws;
+}
+
+// The renderer draws by priority, then with the z buffer requests last, then by ID
+- (void)testDrawOrder {
+    const int numDrawables = 2000;
+    renderer->setZBufferMode(zBufferOffDefault);
+    DrawOrderTweakerRef tweaker = std::make_shared<DrawOrderTweaker>();
+    std::vector<BasicDrawableRef> draws = [self addSmallDrawables:numDrawables tweaker:tweaker];
+
+    // Change a priority in place and the order has to follow
+    draws[0]->setDrawPriority(1000);
+
+    // Every tenth one is off
+    std::vector<BasicDrawableRef> expected;
+    for (int ii=0;ii<numDrawables;ii++)
+        if (ii % 10 != 9)
+            expected.push_back(draws[ii]);
+    std::sort(expected.begin(), expected.end(), [](const BasicDrawableRef &a, const BasicDrawableRef &b) {
+        if (a->getDrawPriority() != b->getDrawPriority())
+            return a->getDrawPriority() < b->getDrawPriority();
+        if (a->getRequestZBuffer() != b->getRequestZBuffer())
+            return !a->getRequestZBuffer();
+        return a->getId() < b->getId();
+    });
+
+    tweaker->drawIDs.clear();
+    renderer->render(1.0/60.0);
+    XCTAssertEqual(renderer->getFrameStats().drawablesVisible, numDrawables / 10 * 9);
+    XCTAssertEqual(tweaker->drawIDs.size(), expected.size());
+    for (size_t ii=0;ii<tweaker->drawIDs.size() && ii<expected.size();ii++)
+        XCTAssertEqual(tweaker->drawIDs[ii], expected[ii]->getId());
+}
+
+// Drawables in several visible ranges are culled a range at a time, but still come out in one draw order
+- (void)testVisibleRangeCulling {
+    const int numDrawables = 3000;
+    view->setHeightAboveGlobe(0.5);
+    renderer->setZBufferMode(zBufferOffDefault);
+    DrawOrderTweakerRef tweaker = std::make_shared<DrawOrderTweaker>();
+
+    // A third visible from here, a third not, and a third with no range at all
+    std::vector<BasicDrawableRef> draws;
+    ChangeSet changes;
+    for (int ii=0;ii<numDrawables;ii++)
+    {
+        draws.push_back(MakeSmallDrawable(renderer.get(), progID, ii, tweaker));
+        if (ii % 3 == 0)
+            draws.back()->setVisibleRange(0.0, 1.0);
+        else if (ii % 3 == 1)
+            draws.back()->setVisibleRange(2.0, 3.0);
+        changes.push_back(new AddDrawableReq(draws.back()));
+    }
+    scene->addChangeRequests(changes);
+
+    // Swap a couple between ranges through the change queue
+    renderer->render(1.0/60.0);
+    scene->addChangeRequest(new VisibilityChangeRequest(draws[0]->getId(), 2.0, 3.0));
+    scene->addChangeRequest(new VisibilityChangeRequest(draws[1]->getId(), 0.0, 1.0));
+
+    // Every tenth one is off, as usual
+    const auto isDrawn = [](int which) {
+        return which != 0 && which % 10 != 9 && (which == 1 || which % 3 != 1);
+    };
+    std::vector<BasicDrawableRef> expected;
+    for (int ii=0;ii<numDrawables;ii++)
+        if (isDrawn(ii))
+            expected.push_back(draws[ii]);
+    std::sort(expected.begin(), expected.end(), [](const BasicDrawableRef &a, const BasicDrawableRef &b) {
+        if (a->getDrawPriority() != b->getDrawPriority())
+            return a->getDrawPriority() < b->getDrawPriority();
+        if (a->getRequestZBuffer() != b->getRequestZBuffer())
+            return !a->getRequestZBuffer();
+        return a->getId() < b->getId();
+    });
+
+    tweaker->drawIDs.clear();
+    renderer->render(1.0/60.0);
+    XCTAssertEqual(renderer->getFrameStats().drawablesVisible, (int)expected.size());
+    XCTAssertEqual(tweaker->drawIDs.size(), expected.size());
+    for (size_t ii=0;ii<tweaker->drawIDs.size() && ii<expected.size();ii++)
+        XCTAssertEqual(tweaker->drawIDs[ii], expected[ii]->getId());
+}
+
+// Patches all around the globe, with and without a geographic MBR.  Only the ones with an MBR
+//  can be culled against the view, and none of the culled ones can have been on screen.
+- (void)testFrustumCulling {
+    view->setRotQuat(view->makeRotationToGeoCoord(GeoCoord(0.0, 0.0), true));
+    view->setHeightAboveGlobe(0.1);
+    DrawOrderTweakerRef tweaker = std::make_shared<DrawOrderTweaker>();
+
+    const double size = 0.1;
+    std::vector<Point2d> orgs;
+    std::vector<BasicDrawableRef> culled, unculled;
+    ChangeSet changes;
+    for (int iy=-6;iy<6;iy++)
+        for (int ix=-12;ix<12;ix++)
+        {
+            orgs.emplace_back(ix * 0.25, iy * 0.2);
+            culled.push_back(MakePatchDrawable(renderer.get(), progID, orgs.back(), size, LocalMbrGeographic));
+            unculled.push_back(MakePatchDrawable(renderer.get(), progID, orgs.back(), size));
+            for (const auto &draw : { culled.back(), unculled.back() })
+            {
+                draw->addTweaker(tweaker);
+                changes.push_back(new AddDrawableReq(draw));
+            }
+        }
+    scene->addChangeRequests(changes);
+    renderer->render(1.0/60.0);
+    const std::set<SimpleIdentity> drawn(tweaker->drawIDs.begin(), tweaker->drawIDs.end());
+
+    // Where the patch points land in clip space
+    const Eigen::Matrix4d mvpMat = view->calcProjectionMatrix(renderer->getFramebufferSize(), 0.0) *
+                                   view->calcViewMatrix() * view->calcModelMatrix();
+    const auto onScreen = [&mvpMat](const Point2d &org, double size) {
+        for (int iy=0;iy<=TileGridSize;iy++)
+            for (int ix=0;ix<=TileGridSize;ix++)
+            {
+                const Point3d pt = PatchPoint(org, size, ix, iy);
+                const Eigen::Vector4d clip = mvpMat * Eigen::Vector4d(pt.x(), pt.y(), pt.z(), 1.0);
+                if (clip.w() > 0.0 && std::abs(clip.x()) <= clip.w() && std::abs(clip.y()) <= clip.w())
+                    return true;
+            }
+        return false;
+    };
+
+    int numCulled = 0;
+    for (size_t ii=0;ii<orgs.size();ii++)
+    {
+        XCTAssertTrue(drawn.count(unculled[ii]->getId()));
+        if (!drawn.count(culled[ii]->getId()))
+        {
+            numCulled++;
+            XCTAssertFalse(onScreen(orgs[ii], size));
+        }
+    }
+    NSLog(@"Culled %d of %d patches", numCulled, (int)orgs.size());
+
+    // The one right under us stays, the far side of the globe goes
+    XCTAssertTrue(drawn.count(culled[6 * 24 + 12]->getId()));
+    XCTAssertGreaterThan(numCulled, (int)orgs.size() / 2);
+    XCTAssertEqual(renderer->getFrameStats().drawablesVisible, (int)(orgs.size() * 2) - numCulled);
+}
+
+// Frame cost with lots of small drawables in many priorities, most of it in building the draw list
+- (void)testDrawListPerformance {
+    renderer->setZBufferMode(zBufferOffDefault);
+    [self addSmallDrawables:30000 tweaker:nullptr];
+
+    [self measureBlock:^{
+        for (int frame=0;frame<20;frame++)
+            renderer->render(1.0/60.0);
+    }];
+    [self logFrame:20];
+}
+
+@end
@@ -0,0 +1,152 @@
+//
+//  OverlapHelperTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <vector>
+#import "OverlapHelper.h"
+#import "WhirlyGeometry.h"
+
+using namespace WhirlyKit;
+
+// Same as the layout manager uses
+static const int OverlapSampleX = 10;
+static const int OverlapSampleY = 60;
+
+// Axis aligned label boxes scattered over the screen, like the layout manager hands in
+static std::vector<Point2dVector> MakeLabelBoxes(const Mbr &screenMbr,int numBoxes)
+{
+    unsigned int rand = 4321;
+    auto next = [&rand](unsigned int limit) { rand = rand * 1103515245u + 12345u;  return (rand >> 8) % limit; };
+
+    const Point2f span = screenMbr.span();
+    std::vector<Point2dVector> boxes(numBoxes);
+    for (auto &box : boxes)
+    {
+        const Point2d org(screenMbr.ll().x() + next((int)span.x()), screenMbr.ll().y() + next((int)span.y()));
+        const Point2d size(30.0 + next(90), 12.0 + next(3) * 2.0);
+        box = { org, Point2d(org.x()+size.x(),org.y()), org+size, Point2d(org.x(),org.y()+size.y()) };
+    }
+    return boxes;
+}
+
+@interface OverlapHelperTests : XCTestCase
+
+@end
+
+@implementation OverlapHelperTests
+{
+    Mbr screenMbr;
+}
+
+- (void)setUp {
+    screenMbr = Mbr(Point2f(0.0, 0.0), Point2f(2048.0, 1536.0));
+}
+
+// Place the given number of labels, returning how many went in
+- (int)placeBoxes:(const std::vector<Point2dVector> &)boxes {
+    OverlapHelper overlapMan(screenMbr, OverlapSampleX, OverlapSampleY);
+    int numPlaced = 0;
+    for (const auto &box : boxes)
+        if (overlapMan.addCheckObject(box))
+            numPlaced++;
+    return numPlaced;
+}
+
+// The same placement as checking everything against everything
+- (void)testMatchesBruteForce {
+    const std::vector<Point2dVector> boxes = MakeLabelBoxes(screenMbr, 2000);
+    OverlapHelper overlapMan(screenMbr, OverlapSampleX, OverlapSampleY);
+    std::vector<Point2dVector> placed;
+    for (const auto &box : boxes)
+    {
+        bool overlaps = false;
+        for (const auto &other : placed)
+            if (ConvexPolyIntersect(box, other))
+            {
+                overlaps = true;
+                break;
+            }
+        XCTAssertEqual(overlapMan.addCheckObject(box), !overlaps);
+        if (!overlaps)
+            placed.push_back(box);
+    }
+    XCTAssertGreaterThan(placed.size(), 100);
+}
+
+// Objects forced in still block later ones
+- (void)testAddObject {
+    OverlapHelper overlapMan(screenMbr, OverlapSampleX, OverlapSampleY);
+    const Point2dVector box = { Point2d(100,100), Point2d(200,100), Point2d(200,120), Point2d(100,120) };
+    overlapMan.addObject(box);
+    overlapMan.addObject(box);
+    XCTAssertFalse(overlapMan.checkObject(box));
+    XCTAssertFalse(overlapMan.addCheckObject({ Point2d(150,110), Point2d(250,110), Point2d(250,130), Point2d(150,130) }));
+    XCTAssertTrue(overlapMan.addCheckObject({ Point2d(300,100), Point2d(400,100), Point2d(400,120), Point2d(300,120) }));
+}
+
+// Ranked objects only block checks with a higher rank, and stop blocking once removed
+- (void)testRankedObjects {
+    OverlapHelper overlapMan(screenMbr, OverlapSampleX, OverlapSampleY);
+    const Mbr box(Point2f(100,100), Point2f(200,120));
+    const Mbr nearBox(Point2f(150,110), Point2f(250,130));
+    const int which = overlapMan.addObject(box, 5);
+    XCTAssertEqual(overlapMan.numObjects(), 1);
+    XCTAssertTrue(overlapMan.checkObject(nearBox, 5));
+    XCTAssertFalse(overlapMan.checkObject(nearBox, 6));
+    XCTAssertFalse(overlapMan.checkObject(nearBox));
+
+    overlapMan.setObjectRank(which, 10);
+    XCTAssertTrue(overlapMan.checkObject(nearBox, 6));
+    XCTAssertFalse(overlapMan.checkObject(nearBox, 11));
+
+    // Unranked objects block everything
+    overlapMan.removeObject(which);
+    XCTAssertTrue(overlapMan.checkObject(nearBox));
+    XCTAssertTrue(overlapMan.addCheckObject({ Point2d(150,110), Point2d(250,110), Point2d(250,130), Point2d(150,130) }));
+    XCTAssertFalse(overlapMan.checkObject(box, 0));
+    XCTAssertEqual(overlapMan.numObjects(), 2);
+}
+
+- (void)testAddCheckObject1kPerformance {
+    const std::vector<Point2dVector> boxes = MakeLabelBoxes(screenMbr, 1000);
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        const int numPlaced = [self placeBoxes:boxes];
+        NSLog(@"addCheckObject for 1k objects: %.3f ms, %d placed", (TimeGetCurrent() - startTime) * 1000.0, numPlaced);
+    }];
+}
+
+- (void)testAddCheckObject10kPerformance {
+    const std::vector<Point2dVector> boxes = MakeLabelBoxes(screenMbr, 10000);
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        const int numPlaced = [self placeBoxes:boxes];
+        NSLog(@"addCheckObject for 10k objects: %.3f ms, %d placed", (TimeGetCurrent() - startTime) * 1000.0, numPlaced);
+    }];
+}
+
+- (void)testAddCheckObject100kPerformance {
+    const std::vector<Point2dVector> boxes = MakeLabelBoxes(screenMbr, 100000);
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        const int numPlaced = [self placeBoxes:boxes];
+        NSLog(@"addCheckObject for 100k objects: %.3f ms, %d placed", (TimeGetCurrent() - startTime) * 1000.0, numPlaced);
+    }];
+}
+
+@end
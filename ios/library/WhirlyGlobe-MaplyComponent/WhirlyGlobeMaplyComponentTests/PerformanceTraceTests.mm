@@ -0,0 +1,279 @@
+//
+//  PerformanceTraceTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <atomic>
+#import <set>
+#import <string>
+#import <thread>
+#import <vector>
+#import "PerformanceTrace.h"
+
+using namespace WhirlyKit;
+
+typedef std::vector<std::pair<int,std::vector<PerformanceTrace::Event>>> TraceEvents;
+
+// The histogram for the given name, or one with a zero count
+static PerformanceTrace::Histogram FindHistogram(const std::string &name)
+{
+    for (const auto &hist : PerformanceTrace::makeHistograms())
+        if (hist.name == name)
+            return hist;
+    PerformanceTrace::Histogram hist;
+    hist.count = 0;
+    return hist;
+}
+
+// Events with the given name, along with the threads they came from
+static std::vector<PerformanceTrace::Event> FindEvents(TraceNameID name,std::set<int> *tids = nullptr)
+{
+    TraceEvents events;
+    PerformanceTrace::getEvents(events);
+
+    std::vector<PerformanceTrace::Event> found;
+    for (const auto &threadEvents : events)
+        for (const auto &event : threadEvents.second)
+            if (event.name == name)
+            {
+                found.push_back(event);
+                if (tids)
+                    tids->insert(threadEvents.first);
+            }
+    return found;
+}
+
+@interface PerformanceTraceTests : XCTestCase
+
+@end
+
+@implementation PerformanceTraceTests
+
+- (void)setUp {
+    PerformanceTrace::setEnabled(true);
+    PerformanceTrace::clear();
+}
+
+- (void)tearDown {
+    PerformanceTrace::clear();
+}
+
+// Nearest rank percentiles over spans we timed ourselves
+- (void)testPercentiles {
+    const TraceNameID name = PerformanceTrace::registerName("PerformanceTraceTests hundred");
+    XCTAssertEqual(PerformanceTrace::registerName("PerformanceTraceTests hundred"), name);
+    XCTAssertTrue(PerformanceTrace::getName(name) == "PerformanceTraceTests hundred");
+
+    // 1 to 100 ms, out of order
+    for (int ii=0;ii<100;ii++)
+    {
+        const uint64_t dur = (uint64_t)((ii * 37) % 100 + 1) * 1000000;
+        PerformanceTrace::addSpan(name, 1000, 1000 + dur);
+    }
+    auto hist = FindHistogram("PerformanceTraceTests hundred");
+    XCTAssertEqual(hist.count, 100);
+    XCTAssertEqualWithAccuracy(hist.minDur, 0.001, 1e-9);
+    XCTAssertEqualWithAccuracy(hist.p50, 0.050, 1e-9);
+    XCTAssertEqualWithAccuracy(hist.p90, 0.090, 1e-9);
+    XCTAssertEqualWithAccuracy(hist.p99, 0.099, 1e-9);
+    XCTAssertEqualWithAccuracy(hist.maxDur, 0.100, 1e-9);
+
+    // With only a few values the ranks round up
+    const TraceNameID fewName = PerformanceTrace::registerName("PerformanceTraceTests few");
+    for (uint64_t dur : { 30, 10, 20 })
+        PerformanceTrace::addSpan(fewName, 0, dur * 1000000);
+    // Backwards spans come out as zero
+    PerformanceTrace::addSpan(fewName, 5000, 1000);
+    hist = FindHistogram("PerformanceTraceTests few");
+    XCTAssertEqual(hist.count, 4);
+    XCTAssertEqual(hist.minDur, 0.0);
+    XCTAssertEqualWithAccuracy(hist.p50, 0.010, 1e-9);
+    XCTAssertEqualWithAccuracy(hist.p90, 0.030, 1e-9);
+    XCTAssertEqualWithAccuracy(hist.p99, 0.030, 1e-9);
+
+    // Nothing left after a clear
+    PerformanceTrace::clear();
+    XCTAssertEqual(FindHistogram("PerformanceTraceTests hundred").count, 0);
+}
+
+// Async events pair up by name and ID across threads
+- (void)testAsyncMatching {
+    const TraceNameID name = PerformanceTrace::registerName("PerformanceTraceTests tile");
+    const TraceNameID otherName = PerformanceTrace::registerName("PerformanceTraceTests other");
+    const int64_t tile = PerformanceTrace::tileID(12, 1205, 1539);
+    XCTAssertNotEqual(tile, PerformanceTrace::tileID(12, 1205, 1540));
+
+    // A repeated begin restarts the clock
+    PerformanceTrace::addAsyncBegin(name, tile);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const uint64_t restart = PerformanceTrace::now();
+    PerformanceTrace::addAsyncBegin(name, tile);
+    uint64_t done = 0;
+    std::thread endThread([&]()
+    {
+        // These don't match anything
+        PerformanceTrace::addAsyncEnd(name, tile + 1);
+        PerformanceTrace::addAsyncEnd(otherName, tile);
+        PerformanceTrace::addAsyncEnd(name, tile);
+        // Nor does this, it's already been ended
+        PerformanceTrace::addAsyncEnd(name, tile);
+        done = PerformanceTrace::now();
+    });
+    endThread.join();
+
+    const auto hist = FindHistogram("PerformanceTraceTests tile");
+    XCTAssertEqual(hist.count, 1);
+    XCTAssertLessThanOrEqual(hist.maxDur, (done - restart) / 1e9);
+    XCTAssertEqual(FindHistogram("PerformanceTraceTests other").count, 0);
+
+    std::set<int> tids;
+    XCTAssertEqual(FindEvents(name, &tids).size(), 5);
+    XCTAssertEqual(tids.size(), 2);
+}
+
+// A thread's buffer goes to the next thread once it exits
+- (void)testThreadBufferReuse {
+    const TraceNameID name = PerformanceTrace::registerName("PerformanceTraceTests reuse");
+    for (int ti=0;ti<10;ti++)
+    {
+        std::thread thread([name,ti]()
+        {
+            PerformanceTrace::setThreadName("reuse " + std::to_string(ti));
+            PerformanceTrace::addInstant(name, ti);
+        });
+        thread.join();
+    }
+
+    std::set<int> tids;
+    const auto events = FindEvents(name, &tids);
+    XCTAssertEqual(events.size(), 10);
+    XCTAssertEqual(tids.size(), 1);
+    for (unsigned int ii=0;ii<events.size();ii++)
+        XCTAssertEqual(events[ii].value, (int64_t)ii);
+
+    // The name went with the thread
+    const std::string json = PerformanceTrace::exportChromeTrace();
+    XCTAssertEqual(json.find("\"reuse "), std::string::npos);
+}
+
+// Read while a thread laps its buffer many times over.
+// Whatever comes back has to be a run of whole events, in order.
+- (void)testOverflowWhileReading {
+    const TraceNameID name = PerformanceTrace::registerName("PerformanceTraceTests overflow");
+    const uint64_t numEvents = 64 * PerformanceTrace::BufferSize;
+    std::atomic<bool> writing(true);
+    std::thread writer([&]()
+    {
+        // Every word of the event carries the sequence number, so a torn copy shows up
+        for (uint64_t ii=1;ii<=numEvents;ii++)
+            PerformanceTrace::addSpan(name, ii, 2*ii, (int64_t)ii);
+        writing = false;
+    });
+
+    int numReads = 0;
+    bool ok = true;
+    while (writing || numReads == 0)
+    {
+        const auto events = FindEvents(name);
+        numReads++;
+        if (events.size() >= PerformanceTrace::BufferSize)
+            ok = false;
+        for (unsigned int ii=0;ii<events.size() && ok;ii++)
+        {
+            const auto &event = events[ii];
+            if (event.type != PerformanceTrace::Span || event.start != (uint64_t)event.value || event.dur != event.start ||
+                (ii > 0 && event.value != events[ii-1].value + 1))
+                ok = false;
+        }
+        if (!ok)
+            break;
+    }
+    writer.join();
+    XCTAssertTrue(ok);
+    NSLog(@"Read the trace %d times while it overflowed", numReads);
+
+    // Once it's quiet we get everything but the slot that's next to be written
+    const auto events = FindEvents(name);
+    XCTAssertEqual(events.size(), PerformanceTrace::BufferSize - 1);
+    if (!events.empty())
+    {
+        XCTAssertEqual(events.front().value, (int64_t)(numEvents - PerformanceTrace::BufferSize + 2));
+        XCTAssertEqual(events.back().value, (int64_t)numEvents);
+    }
+}
+
+// The export has to be valid JSON, even with awkward names
+- (void)testChromeTraceJSON {
+    const TraceNameID spanName = PerformanceTrace::registerName("PerformanceTraceTests \"quoted\" \\ span");
+    const TraceNameID ctrlName = PerformanceTrace::registerName("PerformanceTraceTests tab\there");
+    const TraceNameID asyncName = PerformanceTrace::registerName("PerformanceTraceTests async");
+    PerformanceTrace::setThreadName("PerformanceTraceTests \"main\"");
+
+    const uint64_t start = PerformanceTrace::now();
+    PerformanceTrace::addSpan(spanName, start, start + 1500000);
+    PerformanceTrace::addSpan(spanName, start, start + 2500, PerformanceTrace::tileID(3, 2, 1));
+    PerformanceTrace::addInstant(ctrlName, 7);
+    PerformanceTrace::addCounter(ctrlName, -42);
+    PerformanceTrace::addAsyncBegin(asyncName, 99);
+    PerformanceTrace::addAsyncEnd(asyncName, 99);
+
+    const std::string json = PerformanceTrace::exportChromeTrace();
+    NSData *data = [NSData dataWithBytes:json.data() length:json.size()];
+    NSError *error = nil;
+    NSDictionary *trace = [NSJSONSerialization JSONObjectWithData:data options:0 error:&error];
+    XCTAssertNil(error);
+    XCTAssertTrue([trace isKindOfClass:[NSDictionary class]]);
+    NSArray *traceEvents = trace[@"traceEvents"];
+    XCTAssertTrue([traceEvents isKindOfClass:[NSArray class]]);
+
+    NSMutableDictionary<NSString *,NSNumber *> *phases = [NSMutableDictionary dictionary];
+    bool foundThreadName = false;
+    for (NSDictionary *event in traceEvents)
+    {
+        NSString *eventName = event[@"name"];
+        NSString *ph = event[@"ph"];
+        if ([ph isEqualToString:@"M"])
+        {
+            foundThreadName |= [event[@"args"][@"name"] isEqualToString:@"PerformanceTraceTests \"main\""];
+            continue;
+        }
+        if (![eventName hasPrefix:@"PerformanceTraceTests"])
+            continue;
+        phases[ph] = @(phases[ph].intValue + 1);
+
+        if ([ph isEqualToString:@"X"])
+        {
+            XCTAssertEqualObjects(eventName, @"PerformanceTraceTests \"quoted\" \\ span");
+            XCTAssertTrue([event[@"dur"] doubleValue] == 1500.0 || [event[@"dur"] doubleValue] == 2.5);
+        }
+        else if ([ph isEqualToString:@"i"])
+            // Control characters come out as spaces
+            XCTAssertEqualObjects(eventName, @"PerformanceTraceTests tab here");
+        else if ([ph isEqualToString:@"C"])
+            XCTAssertEqual([event[@"args"][@"value"] intValue], -42);
+        else if ([ph isEqualToString:@"b"] || [ph isEqualToString:@"e"])
+            XCTAssertEqualObjects(event[@"id"], @"0x63");
+    }
+    XCTAssertTrue(foundThreadName);
+    XCTAssertEqual(phases[@"X"].intValue, 2);
+    XCTAssertEqual(phases[@"i"].intValue, 1);
+    XCTAssertEqual(phases[@"C"].intValue, 1);
+    XCTAssertEqual(phases[@"b"].intValue, 1);
+    XCTAssertEqual(phases[@"e"].intValue, 1);
+}
+
+@end
@@ -0,0 +1,103 @@
+//
+//  PolygonFixtures.h
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <cmath>
+#import <utility>
+#import <vector>
+#import "VectorData.h"
+
+// Ring and polygon fixtures shared by the tesselator and clipper tests
+
+namespace WhirlyKit
+{
+
+/// Outer ring first, then any holes
+typedef std::vector<VectorRing> Polygon;
+
+static inline VectorRing MakeRing(const std::vector<std::pair<float,float>> &pts)
+{
+    VectorRing ring;
+    for (const auto &pt : pts)
+        ring.push_back(Point2f(pt.first,pt.second));
+    return ring;
+}
+
+// Alternates between two radii, so every other vertex is concave
+static inline VectorRing MakeStar(float cx,float cy,float outer,float inner,int numPoints)
+{
+    VectorRing ring;
+    for (int ii=0;ii<2*numPoints;ii++)
+    {
+        const double ang = M_PI * ii / numPoints;
+        const float rad = ii % 2 ? inner : outer;
+        ring.push_back(Point2f(cx + rad * cos(ang),cy + rad * sin(ang)));
+    }
+    return ring;
+}
+
+// Signed area, positive for counter clockwise
+static inline double RingArea(const VectorRing &ring)
+{
+    double sum = 0.0;
+    for (unsigned int ii=0,jj=ring.size()-1;ii<ring.size();jj=ii++)
+        sum += ((double)ring[jj].x() - ring[ii].x()) * ((double)ring[jj].y() + ring[ii].y());
+    return sum / 2.0;
+}
+
+// Repeatable random numbers, so the generated fixtures are the same from run to run
+class FixtureRandom
+{
+public:
+    FixtureRandom(unsigned int seed) : state(seed) { }
+
+    // Something in [0,limit)
+    unsigned int next(unsigned int limit)
+    {
+        state = state * 1103515245u + 12345u;
+        return (state >> 8) % limit;
+    }
+
+protected:
+    unsigned int state;
+};
+
+// A building with a notch out of its top edge, optionally with a courtyard
+static inline Polygon MakeBuilding(float x,float y,float w,float h,float n,bool courtyard)
+{
+    Polygon poly = {MakeRing({{x,y},{x+w,y},{x+w,y+h},{x+w-n,y+h},{x+w-n,y+h-n},{x+n,y+h-n},{x+n,y+h},{x,y+h}})};
+    if (courtyard)
+        poly.push_back(MakeRing({{x+w/3,y+h/3},{x+w/3,y+h/2},{x+2*w/3,y+h/2},{x+2*w/3,y+h/3}}));
+    return poly;
+}
+
+// A wobbly, roughly circular ring like a landuse area.  Each vertex is off the radius by up to +/- wobble of it.
+static inline VectorRing MakeBlob(FixtureRandom &rand,float cx,float cy,float rad,int numPts,double wobble)
+{
+    const unsigned int wobbleSteps = std::lround(200 * wobble);
+    VectorRing ring;
+    ring.reserve(numPts);
+    for (int pi=0;pi<numPts;pi++)
+    {
+        const double ang = 2.0 * M_PI * pi / numPts;
+        const float r = rad * (1.0 - wobble + rand.next(wobbleSteps) / 100.0);
+        ring.push_back(Point2f(cx + r * cos(ang),cy + r * sin(ang)));
+    }
+    return ring;
+}
+
+}
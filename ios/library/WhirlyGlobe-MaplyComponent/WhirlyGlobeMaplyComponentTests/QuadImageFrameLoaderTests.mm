@@ -0,0 +1,336 @@
+//
+//  QuadImageFrameLoaderTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <algorithm>
+#import <map>
+#import <vector>
+#import "QuadImageFrameLoader.h"
+#import "Scene.h"
+
+using namespace WhirlyKit;
+
+// Like an animated weather layer
+static const int NumFrames = 8;
+// Levels 0 through 4, 341 tiles
+static const int NumLevels = 5;
+
+// A frame that we hand textures to directly, rather than fetching
+class TestFrameAsset : public QIFFrameAsset
+{
+public:
+    TestFrameAsset(QuadFrameInfoRef frameInfo) : QIFFrameAsset(frameInfo) { }
+
+    // Pretend the texture for this frame just came back
+    void arrive(SimpleIdentity texID) { state = Loaded;  texIDs = { texID }; }
+};
+
+class TestTileAsset : public QIFTileAsset
+{
+public:
+    // A couple of instance drawables, as setupContents would make for one focus
+    TestTileAsset(const QuadTreeNew::ImportantNode &ident) : QIFTileAsset(ident)
+    {
+        shouldEnable = true;
+        instanceDrawIDs = { { Identifiable::genId(), Identifiable::genId() } };
+    }
+
+    const std::vector<std::vector<SimpleIdentity> > &getAllInstanceDrawIDs() const { return instanceDrawIDs; }
+
+protected:
+    virtual QIFFrameAssetRef makeFrameAsset(PlatformThreadInfo *,const QuadFrameInfoRef &frameInfo,QuadImageFrameLoader *) override
+        { return std::make_shared<TestFrameAsset>(frameInfo); }
+};
+
+// Multi-frame loader with no fetcher or tile builder.  Tiles and their frames are fed in by the test.
+class TestFrameLoader : public QuadImageFrameLoader
+{
+public:
+    TestFrameLoader(const SamplingParams &params,int numFrames) : QuadImageFrameLoader(params,MultiFrame)
+    {
+        for (int ii=0;ii<numFrames;ii++)
+        {
+            auto frame = std::make_shared<QuadFrameInfo>();
+            frame->frameIndex = ii;
+            frames.push_back(frame);
+        }
+    }
+
+    // Add a tile with nothing loaded yet
+    void addTile(const QuadTreeNew::Node &ident)
+    {
+        tiles[ident] = makeTileAsset(nullptr,QuadTreeNew::ImportantNode(ident,1.0));
+        changesSinceLastFlush = true;
+    }
+
+    // A texture came in for one of a tile's frames
+    void tileArrived(const QuadTreeNew::Node &ident,int frameID,SimpleIdentity texID)
+    {
+        auto frame = std::dynamic_pointer_cast<TestFrameAsset>(tiles[ident]->getFrame(frameID));
+        frame->arrive(texID);
+        changesSinceLastFlush = true;
+    }
+
+    const QIFTileAssetMap &getTiles() const { return tiles; }
+    std::shared_ptr<const QIFRenderState> getLastBuiltState() const { return lastBuiltState; }
+
+protected:
+    virtual QIFTileAssetRef makeTileAsset(PlatformThreadInfo *threadInfo,const QuadTreeNew::ImportantNode &ident) override
+    {
+        auto tileAsset = std::make_shared<TestTileAsset>(ident);
+        tileAsset->setupFrames(threadInfo,this,getNumFrames());
+        return tileAsset;
+    }
+    virtual QIFBatchOps *makeBatchOps(PlatformThreadInfo *) override { return new QIFBatchOps(); }
+    virtual void processBatchOps(PlatformThreadInfo *,QIFBatchOps *batchOps) override { delete batchOps; }
+};
+
+typedef std::map<QuadTreeNew::Node,QIFTileStateRef> TileStateMap;
+
+// The render state the way buildRenderState used to make it: a new state for every tile,
+//  a walk up the tile map for every tile and frame, then the whole map copied into the hand-off
+static void BuildRenderStateFromScratch(const QIFTileAssetMap &tiles,int numFrames,TileStateMap &tileStates,ChangeSet &changes)
+{
+    tileStates.clear();
+    std::vector<int> tilesLoaded(numFrames,0);
+    for (const auto &tileIt : tiles)
+    {
+        const auto &tileID = tileIt.first;
+        const auto tile = std::static_pointer_cast<TestTileAsset>(tileIt.second);
+
+        const auto tileState = std::make_shared<QIFTileState>(numFrames,tileID);
+        tileState->instanceDrawIDs = tile->getAllInstanceDrawIDs();
+        tileState->enable = tile->getShouldEnable();
+        tileState->compObjs = tile->getCompObjs();
+        tileState->ovlCompObjs = tile->getOvlCompObjs();
+
+        for (int frameID=0;frameID<numFrames;frameID++)
+        {
+            auto &outFrame = tileState->frames[frameID];
+            QuadTreeNew::Node texNode = tileID;
+            do {
+                const auto it = tiles.find(texNode);
+                if (it == tiles.end())
+                    break;
+                const auto parentFrame = it->second->getFrame(frameID);
+                if (parentFrame && !parentFrame->getTexIDs().empty())
+                {
+                    outFrame.texIDs = parentFrame->getTexIDs();
+                    outFrame.texNode = texNode;
+                    break;
+                }
+                if (texNode.level <= 0)
+                    break;
+                texNode.level -= 1;
+                texNode.x /= 2;
+                texNode.y /= 2;
+            } while (outFrame.texIDs.empty());
+
+            if (!outFrame.texIDs.empty() || tile->getFrame(frameID)->getState() == QIFFrameAsset::Loaded)
+                tilesLoaded[frameID]++;
+        }
+
+        tileStates[tileID] = tileState;
+    }
+
+    changes.push_back(new RunBlockReq([tileStates,tilesLoaded](Scene *,SceneRenderer *,View *) { }));
+}
+
+// Count the run blocks handed over, then toss the changes
+static int ClearChanges(ChangeSet &changes)
+{
+    int numRunBlocks = 0;
+    for (auto change : changes)
+    {
+        if (dynamic_cast<RunBlockReq *>(change))
+            numRunBlocks++;
+        delete change;
+    }
+    changes.clear();
+    return numRunBlocks;
+}
+
+// True if the node is the given one or underneath it
+static bool IsUnder(const QuadTreeNew::Node &node,const QuadTreeNew::Node &parent)
+{
+    if (node.level < parent.level)
+        return false;
+    const int relLevel = node.level - parent.level;
+    return (node.x >> relLevel) == parent.x && (node.y >> relLevel) == parent.y;
+}
+
+@interface QuadImageFrameLoaderTests : XCTestCase
+
+@end
+
+@implementation QuadImageFrameLoaderTests
+{
+    SamplingParams params;
+    std::shared_ptr<TestFrameLoader> loader;
+    // Every tile and frame, in the order they come in
+    std::vector<std::pair<QuadTreeNew::Node,int> > arrivals;
+}
+
+- (void)setUp {
+    params.minZoom = 0;
+    params.maxZoom = NumLevels - 1;
+    loader = std::make_shared<TestFrameLoader>(params, NumFrames);
+
+    for (int level=0;level<NumLevels;level++)
+        for (int y=0;y<(1<<level);y++)
+            for (int x=0;x<(1<<level);x++)
+                loader->addTile(QuadTreeNew::Node(x,y,level));
+
+    // Roughly level by level, but shuffled within that, the way tiles come back from a fetcher
+    unsigned int rand = 9753;
+    auto next = [&rand](unsigned int limit) { rand = rand * 1103515245u + 12345u;  return (rand >> 8) % limit; };
+    for (const auto &tileIt : loader->getTiles())
+        for (int frameID=0;frameID<NumFrames;frameID++)
+            arrivals.emplace_back(tileIt.first, frameID);
+    for (size_t ii=arrivals.size()-1;ii>0;ii--)
+        std::swap(arrivals[ii], arrivals[std::max(0, (int)ii - 1 - (int)next(64))]);
+}
+
+- (void)tearDown {
+    arrivals.clear();
+    loader = nullptr;
+}
+
+// Unchanged tiles keep their state, changes flow down to the children, and nothing new goes out when nothing changed
+- (void)testReuseUnchangedTiles {
+    ChangeSet changes;
+    loader->buildRenderState(changes);
+    XCTAssertEqual(ClearChanges(changes), 1);
+    const auto firstState = loader->getLastBuiltState();
+    XCTAssertEqual(firstState->tiles.size(), loader->getTiles().size());
+
+    // A texture for one frame of a level 1 tile
+    const QuadTreeNew::Node parent(1,0,1);
+    loader->tileArrived(parent, 3, 1000);
+    loader->buildRenderState(changes);
+    XCTAssertEqual(ClearChanges(changes), 1);
+    const auto secondState = loader->getLastBuiltState();
+    XCTAssertEqual(secondState->version, firstState->version + 1);
+    XCTAssertEqual(secondState->tiles.size(), firstState->tiles.size());
+
+    for (size_t ii=0;ii<secondState->tiles.size() && ii<firstState->tiles.size();ii++)
+    {
+        const auto &tileState = secondState->tiles[ii];
+        XCTAssertTrue(tileState->node == firstState->tiles[ii]->node);
+        if (IsUnder(tileState->node, parent))
+        {
+            // The parent and everything under it picked up the new texture
+            XCTAssertNotEqual(tileState.get(), firstState->tiles[ii].get());
+            XCTAssertTrue(tileState->frames[3].texNode == parent);
+            XCTAssertEqual(tileState->frames[3].texIDs.size(), 1);
+        } else
+            XCTAssertEqual(tileState.get(), firstState->tiles[ii].get());
+    }
+
+    // Nothing changed, so nothing to hand over
+    loader->buildRenderState(changes);
+    XCTAssertEqual(ClearChanges(changes), 0);
+    XCTAssertEqual(loader->getLastBuiltState().get(), secondState.get());
+
+    // A child getting its own texture only touches its own subtree
+    const QuadTreeNew::Node child(2,1,2);
+    loader->tileArrived(child, 3, 1001);
+    loader->buildRenderState(changes);
+    XCTAssertEqual(ClearChanges(changes), 1);
+    const auto thirdState = loader->getLastBuiltState();
+    for (size_t ii=0;ii<thirdState->tiles.size() && ii<secondState->tiles.size();ii++)
+    {
+        const auto &tileState = thirdState->tiles[ii];
+        XCTAssertEqual(tileState != secondState->tiles[ii], IsUnder(tileState->node, child));
+        if (IsUnder(tileState->node, child))
+            XCTAssertTrue(tileState->frames[3].texNode == child);
+    }
+}
+
+// Stream everything in and check each state against one built from scratch
+- (void)testMatchesFromScratch {
+    ChangeSet changes;
+    TileStateMap scratchStates;
+    SimpleIdentity texID = 1;
+    for (size_t ii=0;ii<arrivals.size();ii++)
+    {
+        loader->tileArrived(arrivals[ii].first, arrivals[ii].second, texID++);
+        loader->buildRenderState(changes);
+        XCTAssertEqual(ClearChanges(changes), 1);
+        // Every so often, since this is the slow way
+        if (ii % 97 != 0 && ii != arrivals.size()-1)
+            continue;
+
+        BuildRenderStateFromScratch(loader->getTiles(), NumFrames, scratchStates, changes);
+        ClearChanges(changes);
+        const auto state = loader->getLastBuiltState();
+        XCTAssertEqual(state->tiles.size(), scratchStates.size());
+        for (const auto &tileState : state->tiles)
+        {
+            const auto &scratchState = scratchStates[tileState->node];
+            XCTAssertTrue(scratchState && tileState->frames == scratchState->frames);
+            XCTAssertTrue(scratchState && tileState->instanceDrawIDs == scratchState->instanceDrawIDs);
+        }
+    }
+
+    const auto state = loader->getLastBuiltState();
+    for (int frameID=0;frameID<NumFrames;frameID++)
+        XCTAssertEqual(state->tilesLoaded[frameID], (int)loader->getTiles().size());
+}
+
+// Stream every tile and frame in, building the render state after each, and return the cost per arrival
+- (double)streamArrivals:(bool)fromScratch {
+    ChangeSet changes;
+    TileStateMap scratchStates;
+    SimpleIdentity texID = 1;
+    TimeInterval buildTime = 0.0;
+    for (const auto &arrival : arrivals)
+    {
+        loader->tileArrived(arrival.first, arrival.second, texID++);
+        const TimeInterval startTime = TimeGetCurrent();
+        if (fromScratch)
+            BuildRenderStateFromScratch(loader->getTiles(), NumFrames, scratchStates, changes);
+        else
+            loader->buildRenderState(changes);
+        ClearChanges(changes);
+        buildTime += TimeGetCurrent() - startTime;
+    }
+    return buildTime / arrivals.size();
+}
+
+- (void)testArrivalSpeedup {
+    const double newTime = [self streamArrivals:false];
+    const double oldTime = [self streamArrivals:true];
+    NSLog(@"%d tiles, %d frames: %.1f us per arrival from scratch, %.1f us reusing tile states",
+          (int)loader->getTiles().size(), NumFrames, oldTime * 1e6, newTime * 1e6);
+    XCTAssertLessThan(newTime, oldTime);
+}
+
+- (void)testArrivalFromScratchPerformance {
+    [self measureBlock:^{
+        NSLog(@"From scratch: %.1f us per arrival", [self streamArrivals:true] * 1e6);
+    }];
+}
+
+- (void)testArrivalReusePerformance {
+    [self measureBlock:^{
+        NSLog(@"Reusing tile states: %.1f us per arrival", [self streamArrivals:false] * 1e6);
+    }];
+}
+
+@end
@@ -0,0 +1,274 @@
+//
+//  QuadTreeNewTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <algorithm>
+#import <tuple>
+#import <unordered_set>
+#import <vector>
+#import "SceneRendererNull.h"
+#import "QuadSamplingController.h"
+#import "SphericalMercator.h"
+#import "GlobeView.h"
+
+using namespace WhirlyKit;
+
+// Runs just the coverage calculation the display controller does on a view update
+class TestDisplayControl : public QuadDisplayControllerNew
+{
+public:
+    TestDisplayControl(QuadDataStructure *dataStructure,QuadLoaderNew *loader,SceneRenderer *renderer)
+        : QuadDisplayControllerNew(dataStructure,loader,renderer)
+    {
+    }
+
+    void setViewState(const ViewStateRef &inViewState)
+    {
+        viewState = inViewState;
+        dataStructure->newViewState(viewState);
+    }
+
+    ImportantNodeVector coverageImportance(std::vector<double> &maxRejectedImport)
+    {
+        return calcCoverageImportance(minImportancePerLevel,maxTiles,true,maxRejectedImport);
+    }
+
+    std::tuple<int,ImportantNodeVector> coverageVisible(std::vector<double> &maxRejectedImport)
+    {
+        return calcCoverageVisible(minImportancePerLevel,maxTiles,levelLoads,keepMinLevel,maxRejectedImport);
+    }
+};
+
+struct CameraPos
+{
+    double lon,lat;
+    double height;
+};
+
+// A recorded session: zoom from the whole globe down to street level, then wander around town
+static std::vector<CameraPos> MakeCameraPath()
+{
+    std::vector<CameraPos> path;
+    double lon = -122.4, lat = 37.78, height = 2.0;
+    while (height > 0.00002)
+    {
+        height *= 0.85;
+        path.push_back({lon,lat,height});
+    }
+    for (int ii=0;ii<60;ii++)
+    {
+        lon += 0.0002;  lat += 0.0001 * sin(ii / 10.0);
+        path.push_back({lon,lat,height});
+    }
+    for (int ii=0;ii<20;ii++)
+    {
+        height *= 1.1;
+        path.push_back({lon,lat,height});
+    }
+    return path;
+}
+
+@interface QuadTreeNewTests : XCTestCase
+
+@end
+
+@implementation QuadTreeNewTests
+{
+    WhirlyGlobe::GlobeViewRef view;
+    SceneNull *scene;
+    SceneRendererNullRef renderer;
+    std::shared_ptr<QuadSamplingController> sampler;
+    std::shared_ptr<TestDisplayControl> displayControl;
+    std::vector<CameraPos> cameraPath;
+}
+
+- (void)setUp {
+    renderer = std::make_shared<SceneRendererNull>();
+    renderer->setup(2048, 1536, 2.0);
+
+    view = std::make_shared<WhirlyGlobe::GlobeView>(nullptr);
+    // Like the globe view controller, so we can get down to street level
+    view->continuousZoom = true;
+    scene = new SceneNull(view->coordAdapter);
+    renderer->setScene(scene);
+    renderer->setView(view.get());
+
+    cameraPath = MakeCameraPath();
+}
+
+- (void)tearDown {
+    displayControl = nullptr;
+    if (sampler)
+        sampler->stop();
+    sampler = nullptr;
+    scene->teardown(nullptr);
+    renderer->setScene(nullptr);
+    delete scene;
+    scene = nullptr;
+    renderer = nullptr;
+    view = nullptr;
+}
+
+// A web mercator image layer sampler, going down to the given level
+- (void)startSampler:(int)maxZoom {
+    SamplingParams params;
+    params.coordSys = std::make_shared<SphericalMercatorCoordSystem>();
+    const Point3d ll = params.coordSys->geographicToLocal(Point2d(-M_PI,-85.0511 / 180.0 * M_PI));
+    const Point3d ur = params.coordSys->geographicToLocal(Point2d(M_PI,85.0511 / 180.0 * M_PI));
+    params.coordBounds.addPoint(Point2d(ll.x(),ll.y()));
+    params.coordBounds.addPoint(Point2d(ur.x(),ur.y()));
+    params.minZoom = 0;
+    params.maxZoom = maxZoom;
+    params.generateGeom = false;
+
+    sampler = std::make_shared<QuadSamplingController>();
+    sampler->start(params, scene, renderer.get());
+
+    const auto sampleControl = sampler->getDisplayControl();
+    displayControl = std::make_shared<TestDisplayControl>(sampler.get(), sampler->getBuilder().get(), renderer.get());
+    displayControl->setMinImportancePerLevel(sampleControl->getMinImportancePerLevel());
+    displayControl->setMaxTiles(sampleControl->getMaxTiles());
+}
+
+- (ViewStateRef)moveTo:(const CameraPos &)pos {
+    view->setRotQuat(view->makeRotationToGeoCoord(GeoCoord::CoordFromDegrees(pos.lon, pos.lat), true), false);
+    view->setHeightAboveGlobe(pos.height, false);
+    ViewStateRef viewState = view->makeViewState(renderer.get());
+    displayControl->setViewState(viewState);
+    return viewState;
+}
+
+// Play back the camera path, returning the deepest level we asked for
+- (int)replayImportance:(int)maxZoom {
+    int deepest = -1;
+    for (const auto &pos : cameraPath)
+    {
+        [self moveTo:pos];
+        std::vector<double> maxRejectedImport(maxZoom+1,0.0);
+        for (const auto &node : displayControl->coverageImportance(maxRejectedImport))
+            deepest = std::max(deepest,node.level);
+    }
+    return deepest;
+}
+
+// The same for single level loading
+- (int)replayVisible:(int)maxZoom {
+    int deepest = -1;
+    for (const auto &pos : cameraPath)
+    {
+        [self moveTo:pos];
+        std::vector<double> maxRejectedImport(maxZoom+1,0.0);
+        deepest = std::max(deepest,std::get<0>(displayControl->coverageVisible(maxRejectedImport)));
+    }
+    return deepest;
+}
+
+// At street level we should be loading the bottom of the tree, within the tile limit
+- (void)testStreetLevelCoverage {
+    [self startSampler:18];
+    const CameraPos streetPos = {-122.4,37.78,0.00001};
+    [self moveTo:streetPos];
+
+    std::vector<double> maxRejectedImport(19,0.0);
+    const auto nodes = displayControl->coverageImportance(maxRejectedImport);
+    XCTAssertGreaterThan(nodes.size(), 0);
+    XCTAssertLessThanOrEqual(nodes.size(), displayControl->getMaxTiles());
+    int deepest = -1;
+    for (const auto &node : nodes)
+        deepest = std::max(deepest,node.level);
+    XCTAssertEqual(deepest, 18);
+    [self checkSortedUnique:nodes];
+
+    int targetLevel;
+    QuadTreeNew::ImportantNodeVector visNodes;
+    std::tie(targetLevel,visNodes) = displayControl->coverageVisible(maxRejectedImport);
+    XCTAssertEqual(targetLevel, 18);
+    XCTAssertGreaterThan(visNodes.size(), 0);
+    [self checkSortedUnique:visNodes];
+}
+
+// Coverage comes back least important first, with each node only once
+- (void)checkSortedUnique:(const QuadTreeNew::ImportantNodeVector &)nodes {
+    XCTAssertTrue(std::is_sorted(nodes.begin(), nodes.end()));
+    std::unordered_set<int64_t> nodeNums;
+    for (const auto &node : nodes)
+        nodeNums.insert(node.NodeNumber());
+    XCTAssertEqual(nodeNums.size(), nodes.size());
+}
+
+- (void)testImportanceCoverageLevel18Performance {
+    [self startSampler:18];
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        const int deepest = [self replayImportance:18];
+        NSLog(@"Importance coverage at maxLevel 18: %.2f ms/frame over %d frames, down to level %d",
+              (TimeGetCurrent() - startTime) * 1000.0 / cameraPath.size(), (int)cameraPath.size(), deepest);
+    }];
+}
+
+- (void)testImportanceCoverageLevel19Performance {
+    [self startSampler:19];
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        const int deepest = [self replayImportance:19];
+        NSLog(@"Importance coverage at maxLevel 19: %.2f ms/frame over %d frames, down to level %d",
+              (TimeGetCurrent() - startTime) * 1000.0 / cameraPath.size(), (int)cameraPath.size(), deepest);
+    }];
+}
+
+- (void)testImportanceCoverageLevel20Performance {
+    [self startSampler:20];
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        const int deepest = [self replayImportance:20];
+        NSLog(@"Importance coverage at maxLevel 20: %.2f ms/frame over %d frames, down to level %d",
+              (TimeGetCurrent() - startTime) * 1000.0 / cameraPath.size(), (int)cameraPath.size(), deepest);
+    }];
+}
+
+- (void)testVisibleCoverageLevel18Performance {
+    [self startSampler:18];
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        const int deepest = [self replayVisible:18];
+        NSLog(@"Visible coverage at maxLevel 18: %.2f ms/frame over %d frames, down to level %d",
+              (TimeGetCurrent() - startTime) * 1000.0 / cameraPath.size(), (int)cameraPath.size(), deepest);
+    }];
+}
+
+- (void)testVisibleCoverageLevel19Performance {
+    [self startSampler:19];
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        const int deepest = [self replayVisible:19];
+        NSLog(@"Visible coverage at maxLevel 19: %.2f ms/frame over %d frames, down to level %d",
+              (TimeGetCurrent() - startTime) * 1000.0 / cameraPath.size(), (int)cameraPath.size(), deepest);
+    }];
+}
+
+- (void)testVisibleCoverageLevel20Performance {
+    [self startSampler:20];
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        const int deepest = [self replayVisible:20];
+        NSLog(@"Visible coverage at maxLevel 20: %.2f ms/frame over %d frames, down to level %d",
+              (TimeGetCurrent() - startTime) * 1000.0 / cameraPath.size(), (int)cameraPath.size(), deepest);
+    }];
+}
+
+@end
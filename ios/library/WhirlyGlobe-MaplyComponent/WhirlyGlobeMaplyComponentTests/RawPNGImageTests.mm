@@ -0,0 +1,194 @@
+//
+//  RawPNGImageTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <dirent.h>
+#import <stdio.h>
+#import <string>
+#import <vector>
+#import "RawPNGImage.h"
+#import "TextureNull.h"
+#import "lodepng.h"
+
+using namespace WhirlyKit;
+
+typedef std::vector<unsigned char> PNGData;
+
+// Something like a map tile: smooth color with a bit of noise so it doesn't compress to nothing
+static PNGData MakeTile(unsigned int size,LodePNGColorType colorType,int seed)
+{
+    const int channels = colorType == LCT_GREY ? 1 : (colorType == LCT_RGB ? 3 : 4);
+    std::vector<unsigned char> pixels((size_t)size * size * channels);
+    unsigned int noise = seed * 2654435761u + 1;
+    for (unsigned int y=0;y<size;y++)
+        for (unsigned int x=0;x<size;x++)
+        {
+            noise = noise * 1103515245u + 12345u;
+            unsigned char *pix = &pixels[((size_t)y * size + x) * channels];
+            for (int c=0;c<channels;c++)
+                pix[c] = (unsigned char)((x * (c+1) + y * (3-c) + seed * 17 + ((noise >> 16) & 0x7)) & 0xFF);
+        }
+
+    unsigned char *out = nullptr;
+    size_t outSize = 0;
+    if (lodepng_encode_memory(&out, &outSize, pixels.data(), size, size, colorType, 8) != 0)
+        return PNGData();
+    PNGData png(out, out + outSize);
+    free(out);
+    return png;
+}
+
+// Tiles from WK_PNG_TILE_DIR if it's set, otherwise a mix of made up ones
+static std::vector<PNGData> LoadTiles()
+{
+    std::vector<PNGData> tiles;
+    if (const char *dirName = getenv("WK_PNG_TILE_DIR"))
+    {
+        if (DIR *dir = opendir(dirName))
+        {
+            while (struct dirent *dirEnt = readdir(dir))
+            {
+                const std::string name = dirEnt->d_name;
+                if (name.size() < 4 || name.compare(name.size()-4, 4, ".png") != 0)
+                    continue;
+                if (FILE *fp = fopen((std::string(dirName) + "/" + name).c_str(), "rb"))
+                {
+                    PNGData png;
+                    unsigned char buf[16384];
+                    size_t len;
+                    while ((len = fread(buf, 1, sizeof(buf), fp)) > 0)
+                        png.insert(png.end(), buf, buf + len);
+                    fclose(fp);
+                    tiles.push_back(std::move(png));
+                }
+            }
+            closedir(dir);
+        }
+        if (!tiles.empty())
+            return tiles;
+    }
+
+    for (int ii=0;ii<64;ii++)
+        tiles.push_back(MakeTile(256, (ii % 4 == 0) ? LCT_GREY : ((ii % 4 == 1) ? LCT_RGB : LCT_RGBA), ii));
+    return tiles;
+}
+
+@interface RawPNGImageTests : XCTestCase
+
+@end
+
+@implementation RawPNGImageTests
+
+// Decoding to 16 bit gives the same pixels as decoding to RGBA and converting
+- (void)testDecodeTo16Bit {
+    RawPNGDecoder decoder;
+    const std::vector<int> valueMap;
+    for (LodePNGColorType colorType : {LCT_RGB, LCT_RGBA})
+    {
+        const PNGData png = MakeTile(200, colorType, 3);
+        XCTAssertFalse(png.empty());
+
+        unsigned int width = 0, height = 0, err = 0;
+        int byteWidth = 0;
+        RawDataRef rgba = decoder.decode(png.data(), png.size(), valueMap, RawPNGRGBA, width, height, byteWidth, err);
+        XCTAssertTrue(rgba && err == 0);
+        XCTAssertEqual(byteWidth, 4);
+        if (!rgba)
+            continue;
+        const size_t numPixels = (size_t)width * height;
+
+        std::vector<uint16_t> expect565(numPixels), expect4444(numPixels);
+        ConvertRGBATo565((const uint32_t *)rgba->getRawData(), expect565.data(), numPixels);
+        ConvertRGBATo4444((const uint32_t *)rgba->getRawData(), expect4444.data(), numPixels);
+
+        RawDataRef out565 = decoder.decode(png.data(), png.size(), valueMap, RawPNG565, width, height, byteWidth, err);
+        XCTAssertTrue(out565 && byteWidth == 2 && out565->getLen() == numPixels * 2);
+        XCTAssertTrue(out565 && memcmp(out565->getRawData(), expect565.data(), numPixels * 2) == 0);
+
+        RawDataRef out4444 = decoder.decode(png.data(), png.size(), valueMap, RawPNG4444, width, height, byteWidth, err);
+        XCTAssertTrue(out4444 && byteWidth == 2 && out4444->getLen() == numPixels * 2);
+        XCTAssertTrue(out4444 && memcmp(out4444->getRawData(), expect4444.data(), numPixels * 2) == 0);
+    }
+
+    // Greyscale stays at a byte per pixel
+    const PNGData grey = MakeTile(128, LCT_GREY, 5);
+    unsigned int width = 0, height = 0, err = 0;
+    int byteWidth = 0;
+    RawDataRef out = decoder.decode(grey.data(), grey.size(), valueMap, RawPNG565, width, height, byteWidth, err);
+    XCTAssertTrue(out && err == 0);
+    XCTAssertEqual(byteWidth, 1);
+}
+
+// Only the formats the decoder can produce are passed through to it
+- (void)testFormatForTexType {
+    XCTAssertEqual(RawPNGFormatForTexType(TexTypeShort565), RawPNG565);
+    XCTAssertEqual(RawPNGFormatForTexType(TexTypeShort4444), RawPNG4444);
+    XCTAssertEqual(RawPNGFormatForTexType(TexTypeShort5551), RawPNGRGBA);
+    XCTAssertEqual(RawPNGFormatForTexType(TexTypeUnsignedByte), RawPNGRGBA);
+    XCTAssertEqual(RawPNGFormatForTexType(TexTypeSingleChannel), RawPNGRGBA);
+}
+
+// The texture uses data flagged as already in its format and converts everything else
+- (void)testTextureDataInFormat {
+    const int size = 64;
+    std::vector<uint32_t> rgba(size * size, 0xff3366cc);
+    std::vector<uint16_t> pix565(size * size);
+    ConvertRGBATo565(rgba.data(), pix565.data(), rgba.size());
+
+    TextureNull converted("converted", std::make_shared<RawDataWrapper>(rgba.data(), rgba.size() * 4, false), false);
+    converted.setWidth(size);  converted.setHeight(size);
+    converted.setFormat(TexTypeShort565);
+    RawDataRef convertedData = converted.processData();
+    XCTAssertTrue(convertedData && convertedData->getLen() == pix565.size() * 2);
+    XCTAssertTrue(convertedData && memcmp(convertedData->getRawData(), pix565.data(), pix565.size() * 2) == 0);
+
+    RawDataRef inFormat = std::make_shared<RawDataWrapper>(pix565.data(), pix565.size() * 2, false);
+    TextureNull passed("passed", inFormat, false);
+    passed.setWidth(size);  passed.setHeight(size);
+    passed.setFormat(TexTypeShort565);
+    passed.setDataInFormat(true);
+    XCTAssertTrue(passed.processData() == inFormat);
+}
+
+// Decode throughput over a set of tiles (time, plus peak memory)
+- (void)testDecodePerformance {
+    const std::vector<PNGData> tiles = LoadTiles();
+    size_t totalBytes = 0;
+    for (const auto &tile : tiles)
+        totalBytes += tile.size();
+    XCTAssertFalse(tiles.empty());
+
+    const std::vector<int> valueMap;
+    [self measureWithMetrics:@[[[XCTClockMetric alloc] init],[[XCTMemoryMetric alloc] init]] block:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        for (int pass=0;pass<4;pass++)
+            for (const auto &tile : tiles)
+            {
+                unsigned int width = 0, height = 0, err = 0;
+                int byteWidth = 0;
+                RawDataRef outData = RawPNGImageLoaderInterpreter(width, height, tile.data(), tile.size(), valueMap,
+                                                                  RawPNGRGBA, byteWidth, err);
+                XCTAssertTrue(outData && err == 0);
+            }
+        const TimeInterval howLong = TimeGetCurrent() - startTime;
+        NSLog(@"Decoded %d tiles, %.1f MB of PNG at %.1f MB/s", (int)tiles.size() * 4,
+              totalBytes * 4 / (1024.0*1024.0), totalBytes * 4 / (1024.0*1024.0) / howLong);
+    }];
+}
+
+@end
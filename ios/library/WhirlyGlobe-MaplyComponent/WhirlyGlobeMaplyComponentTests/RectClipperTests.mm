@@ -0,0 +1,339 @@
+//
+//  RectClipperTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <cmath>
+#import <string>
+#import <vector>
+#import "GridClipper.h"
+#import "Platform.h"
+#import "PolygonFixtures.h"
+#import "clipper.hpp"
+
+using namespace WhirlyKit;
+
+// Rings against the unit tile, most of them crossing it once so they stay on the Sutherland-Hodgman path
+static std::vector<std::pair<std::string,Polygon>> TestPolygons()
+{
+    std::vector<std::pair<std::string,Polygon>> polys;
+
+    polys.push_back({"inside", {MakeRing({{0.2,0.2},{0.8,0.2},{0.8,0.8},{0.2,0.8}})}});
+    polys.push_back({"outside", {MakeRing({{1.2,0.2},{1.8,0.2},{1.8,0.8},{1.2,0.8}})}});
+    polys.push_back({"around", {MakeRing({{-1,-1},{2,-1},{2,2},{-1,2}})}});
+    polys.push_back({"cross right", {MakeRing({{0.5,0.2},{1.5,0.3},{1.4,0.9},{0.6,0.7}})}});
+    polys.push_back({"cross corner", {MakeRing({{0.7,0.6},{1.3,0.7},{1.4,1.4},{0.6,1.3}})}});
+    polys.push_back({"clockwise", {MakeRing({{0.5,0.2},{0.6,0.7},{1.4,0.9},{1.5,0.3}})}});
+    polys.push_back({"closed", {MakeRing({{-0.5,0.2},{0.5,0.2},{0.5,0.6},{-0.5,0.6},{-0.5,0.2}})}});
+
+    // Edges along the tile boundary, inside and out
+    polys.push_back({"edge inside", {MakeRing({{0.5,0.2},{1,0.2},{1,0.8},{0.5,0.8}})}});
+    polys.push_back({"edge outside", {MakeRing({{1,0.2},{1.5,0.2},{1.5,0.8},{1,0.8}})}});
+    polys.push_back({"edge across", {MakeRing({{0.5,0},{1.5,0},{1.5,0.5},{0.5,0.5}})}});
+    polys.push_back({"touch corner", {MakeRing({{1,1},{1.5,1},{1.5,1.5},{1,1.5}})}});
+    polys.push_back({"vertex on edge", {MakeRing({{0.5,0.5},{1,0.25},{1.5,0.5},{1,0.75}})}});
+
+    // Collinear points, including runs that cross the boundary
+    polys.push_back({"collinear", {MakeRing({{0.25,0.25},{0.75,0.25},{1,0.25},{1.25,0.25},{1.5,0.25},{1.5,0.75},{0.25,0.75}})}});
+    polys.push_back({"duplicates", {MakeRing({{0.5,0.2},{0.5,0.2},{1.5,0.3},{1.5,0.3},{1.4,0.9},{0.6,0.7},{0.6,0.7}})}});
+
+    // Degenerate rings
+    polys.push_back({"flat", {MakeRing({{-0.5,0.5},{0.5,0.5},{1.5,0.5}})}});
+    polys.push_back({"two points", {MakeRing({{0.2,0.2},{0.8,0.8}})}});
+    polys.push_back({"spike", {MakeRing({{0.2,0.2},{0.8,0.2},{1.5,0.2},{0.8,0.2},{0.8,0.8},{0.2,0.8}})}});
+    polys.push_back({"sliver", {MakeRing({{0.5,0.5},{1.5,0.5},{1.5,0.5000001}})}});
+
+    // Crosses twice, so it comes apart and goes to Clipper
+    polys.push_back({"u shape", {MakeRing({{-0.5,0.2},{0.8,0.2},{0.8,0.4},{-0.2,0.4},{-0.2,0.6},{0.8,0.6},{0.8,0.8},{-0.5,0.8}})}});
+
+    // Holes
+    polys.push_back({"hole inside", {MakeRing({{-1,-1},{2,-1},{2,2},{-1,2}}),
+                                     MakeRing({{0.4,0.4},{0.4,0.6},{0.6,0.6},{0.6,0.4}})}});
+    polys.push_back({"hole outside", {MakeRing({{-1,-1},{2,-1},{2,2},{-1,2}}),
+                                      MakeRing({{1.2,1.2},{1.2,1.6},{1.6,1.6},{1.6,1.2}})}});
+    polys.push_back({"hole across", {MakeRing({{0.5,0.1},{1.5,0.1},{1.5,0.9},{0.5,0.9}}),
+                                     MakeRing({{0.7,0.3},{0.7,0.7},{1.3,0.7},{1.3,0.3}})}});
+    polys.push_back({"hole around", {MakeRing({{-2,-2},{3,-2},{3,3},{-2,3}}),
+                                     MakeRing({{-1,-1},{-1,2},{2,2},{2,-1}})}});
+
+    return polys;
+}
+
+// Outers count up, holes count down
+static double SignedArea(const std::vector<VectorRing> &rings)
+{
+    double area = 0.0;
+    for (const VectorRing &ring : rings)
+        area += RingArea(ring);
+    return area;
+}
+
+// What Clipper does with the same rings, in doubles
+static double ClipperArea(const Polygon &poly,const Mbr &mbr)
+{
+    const double scale = 1e9;
+    ClipperLib::Clipper c;
+    for (const VectorRing &ring : poly)
+    {
+        ClipperLib::Path path;
+        for (const Point2f &pt : ring)
+            path.push_back(ClipperLib::IntPoint(std::llround(pt.x()*scale),std::llround(pt.y()*scale)));
+        c.AddPath(path, ClipperLib::ptSubject, true);
+    }
+    ClipperLib::Path clip = {
+        ClipperLib::IntPoint(std::llround(mbr.ll().x()*scale),std::llround(mbr.ll().y()*scale)),
+        ClipperLib::IntPoint(std::llround(mbr.ur().x()*scale),std::llround(mbr.ll().y()*scale)),
+        ClipperLib::IntPoint(std::llround(mbr.ur().x()*scale),std::llround(mbr.ur().y()*scale)),
+        ClipperLib::IntPoint(std::llround(mbr.ll().x()*scale),std::llround(mbr.ur().y()*scale))
+    };
+    c.AddPath(clip, ClipperLib::ptClip, true);
+
+    ClipperLib::Paths solution;
+    if (!c.Execute(ClipperLib::ctIntersection, solution))
+        return -1.0;
+
+    double area = 0.0;
+    for (const ClipperLib::Path &path : solution)
+        area += ClipperLib::Area(path) / (scale * scale);
+    return area;
+}
+
+// Everything should be in the box, give or take float rounding
+static bool InsideBox(const std::vector<VectorRing> &rings,const Mbr &mbr)
+{
+    const float eps = 1e-6;
+    for (const VectorRing &ring : rings)
+        for (const Point2f &pt : ring)
+            if (pt.x() < mbr.ll().x() - eps || pt.x() > mbr.ur().x() + eps ||
+                pt.y() < mbr.ll().y() - eps || pt.y() > mbr.ur().y() + eps)
+                return false;
+    return true;
+}
+
+// Vector tile extent, and the buffer around it polygons run into
+static const float TileExtent = 4096.0;
+static const float TileBuffer = 512.0;
+
+// A busy vector tile's worth of polygons: lots of buildings, some with courtyards,
+//  and big landuse areas, with everything near the edges running past them
+static std::vector<Polygon> MakeTilePolygons()
+{
+    FixtureRandom rand(8642);
+    const unsigned int span = TileExtent + 2 * TileBuffer;
+
+    std::vector<Polygon> polys;
+    for (int ii=0;ii<4000;ii++)
+    {
+        const float x = (float)rand.next(span) - TileBuffer, y = (float)rand.next(span) - TileBuffer;
+        const float w = 20 + rand.next(60), h = 20 + rand.next(60), n = 2 + rand.next(6);
+        polys.push_back(MakeBuilding(x,y,w,h,n,ii % 10 == 0));
+    }
+    for (int ii=0;ii<200;ii++)
+    {
+        const float cx = (float)rand.next(span) - TileBuffer, cy = (float)rand.next(span) - TileBuffer, rad = 100 + rand.next(1000);
+        const int numPts = 50 + rand.next(450);
+        Polygon poly = {MakeBlob(rand,cx,cy,rad,numPts,0.1)};
+        if (ii % 4 == 0)
+        {
+            VectorRing hole;
+            for (int pi=0;pi<20;pi++)
+            {
+                const double ang = -2.0 * M_PI * pi / 20;
+                hole.push_back(Point2f(cx + rad / 3 * cos(ang),cy + rad / 3 * sin(ang)));
+            }
+            poly.push_back(hole);
+        }
+        polys.push_back(poly);
+    }
+    return polys;
+}
+
+// Clip with Clipper, handing back fresh rings the way the old ClipLoopsToMbr did
+static bool ClipWithClipper(const Polygon &poly,const Mbr &mbr,double scale,std::vector<VectorRing> &rets)
+{
+    ClipperLib::Clipper c;
+    for (const VectorRing &ring : poly)
+    {
+        ClipperLib::Path path(ring.size());
+        for (unsigned int ii=0;ii<ring.size();ii++)
+            path[ii] = ClipperLib::IntPoint(ring[ii].x()*scale,ring[ii].y()*scale);
+        c.AddPath(path, ClipperLib::ptSubject, true);
+    }
+    ClipperLib::Path clip = {
+        ClipperLib::IntPoint(mbr.ll().x()*scale,mbr.ll().y()*scale),
+        ClipperLib::IntPoint(mbr.ur().x()*scale,mbr.ll().y()*scale),
+        ClipperLib::IntPoint(mbr.ur().x()*scale,mbr.ur().y()*scale),
+        ClipperLib::IntPoint(mbr.ll().x()*scale,mbr.ur().y()*scale)
+    };
+    c.AddPath(clip, ClipperLib::ptClip, true);
+
+    ClipperLib::Paths solution;
+    if (!c.Execute(ClipperLib::ctIntersection, solution))
+        return false;
+    for (const ClipperLib::Path &path : solution)
+    {
+        VectorRing outRing;
+        for (const ClipperLib::IntPoint &pt : path)
+            outRing.push_back(Point2f(pt.X/scale,pt.Y/scale));
+        if (outRing.size() > 2)
+            rets.push_back(outRing);
+    }
+    return true;
+}
+
+@interface RectClipperTests : XCTestCase
+
+@end
+
+@implementation RectClipperTests
+
+// Clipped area has to match Clipper's, including the winding of outers and holes
+- (void)testMatchesClipper {
+    RectClipper clipper;
+    const Mbr mbr(Point2f(0,0),Point2f(1,1));
+    for (const auto &test : TestPolygons())
+    {
+        const Polygon &poly = test.second;
+        NSString *name = [NSString stringWithUTF8String:test.first.c_str()];
+
+        std::vector<VectorRing> rets;
+        XCTAssertTrue(clipper.clipLoops(poly.data(), poly.size(), mbr, rets), @"%@", name);
+        XCTAssertTrue(InsideBox(rets, mbr), @"%@", name);
+
+        const double area = SignedArea(rets);
+        const double clipperArea = ClipperArea(poly, mbr);
+        XCTAssertTrue(clipperArea >= 0.0, @"%@", name);
+        XCTAssertEqualWithAccuracy(area, clipperArea, 1e-6, @"%@", name);
+
+        // Nothing without area comes back, same as Clipper
+        for (const VectorRing &ring : rets)
+            XCTAssertTrue(ring.size() >= 3 && RingArea(ring) != 0.0, @"%@", name);
+    }
+}
+
+// Same thing, with the tile moved around so the boundaries aren't at nice numbers
+- (void)testMatchesClipperOffset {
+    RectClipper clipper;
+    for (const Point2f &org : {Point2f(-0.37,0.81),Point2f(12.5,-3.25),Point2f(-180.0,-85.0)})
+    {
+        const Mbr mbr(org,Point2f(org.x()+1,org.y()+1));
+        for (const auto &test : TestPolygons())
+        {
+            Polygon poly = test.second;
+            for (VectorRing &ring : poly)
+                for (Point2f &pt : ring)
+                    pt += org;
+            NSString *name = [NSString stringWithUTF8String:test.first.c_str()];
+
+            std::vector<VectorRing> rets;
+            XCTAssertTrue(clipper.clipLoops(poly.data(), poly.size(), mbr, rets), @"%@", name);
+            XCTAssertTrue(InsideBox(rets, mbr), @"%@", name);
+            // Float coordinates out here, so a looser match
+            XCTAssertEqualWithAccuracy(SignedArea(rets), ClipperArea(poly, mbr), 1e-4, @"%@", name);
+        }
+    }
+}
+
+// Cutting a ring into grid cells shouldn't lose or add any area
+- (void)testGridKeepsArea {
+    for (const auto &test : TestPolygons())
+    {
+        const Polygon &poly = test.second;
+        NSString *name = [NSString stringWithUTF8String:test.first.c_str()];
+        if (poly.size() != 1 || poly[0].size() < 3)
+            continue;
+
+        std::vector<VectorRing> rets;
+        XCTAssertTrue(ClipLoopToGrid(poly[0], Point2f(0,0), Point2f(0.25,0.25), rets), @"%@", name);
+        double area = 0.0;
+        for (const VectorRing &ring : rets)
+            area += std::abs(RingArea(ring));
+        XCTAssertEqualWithAccuracy(area, std::abs(RingArea(poly[0])), 1e-5, @"%@", name);
+    }
+}
+
+// A whole tile clipped to its boundary should come out the same as with Clipper
+- (void)testTileMatchesClipper {
+    RectClipper clipper;
+    const Mbr mbr(Point2f(0,0),Point2f(TileExtent,TileExtent));
+    double area = 0.0, clipperArea = 0.0;
+    for (const Polygon &poly : MakeTilePolygons())
+    {
+        std::vector<VectorRing> rets, clipperRets;
+        XCTAssertTrue(clipper.clipLoops(poly.data(), poly.size(), mbr, rets, 1e9));
+        XCTAssertTrue(ClipWithClipper(poly, mbr, 1e9, clipperRets));
+        XCTAssertTrue(InsideBox(rets, mbr));
+        area += SignedArea(rets);
+        clipperArea += SignedArea(clipperRets);
+    }
+    XCTAssertEqualWithAccuracy(area, clipperArea, 1e-6 * clipperArea);
+}
+
+// Clip every polygon in a tile to the tile boundary
+- (void)clipTile:(bool)useClipper {
+    const std::vector<Polygon> polys = MakeTilePolygons();
+    const Mbr mbr(Point2f(0,0),Point2f(TileExtent,TileExtent));
+    unsigned int numVerts = 0;
+    for (const Polygon &poly : polys)
+        for (const VectorRing &ring : poly)
+            numVerts += ring.size();
+
+    [self measureBlock:^{
+        RectClipper clipper;
+        unsigned int numRings = 0;
+        const TimeInterval startTime = TimeGetCurrent();
+        for (const Polygon &poly : polys)
+        {
+            std::vector<VectorRing> rets;
+            if (useClipper)
+                ClipWithClipper(poly, mbr, 1e9, rets);
+            else
+                clipper.clipLoops(poly.data(), poly.size(), mbr, rets, 1e9);
+            numRings += rets.size();
+        }
+        NSLog(@"%s: %d polygons (%d vertices) clipped to the tile in %.2f ms, %d rings out",
+              useClipper ? "Clipper" : "Sutherland-Hodgman", (int)polys.size(), numVerts,
+              (TimeGetCurrent() - startTime) * 1000.0, numRings);
+    }];
+}
+
+- (void)testRectClipTilePerformance {
+    [self clipTile:false];
+}
+
+- (void)testClipperClipTilePerformance {
+    [self clipTile:true];
+}
+
+// Cut the tile's polygons into a 16x16 grid, as the loft layer does
+- (void)testGridClipTilePerformance {
+    const std::vector<Polygon> polys = MakeTilePolygons();
+    [self measureBlock:^{
+        unsigned int numRings = 0;
+        const TimeInterval startTime = TimeGetCurrent();
+        for (const Polygon &poly : polys)
+        {
+            std::vector<VectorRing> rets;
+            ClipLoopsToGrid(poly, Point2f(0,0), Point2f(TileExtent/16,TileExtent/16), rets);
+            numRings += rets.size();
+        }
+        NSLog(@"Grid clipping: %d polygons in %.2f ms, %d rings out", (int)polys.size(),
+              (TimeGetCurrent() - startTime) * 1000.0, numRings);
+    }];
+}
+
+@end
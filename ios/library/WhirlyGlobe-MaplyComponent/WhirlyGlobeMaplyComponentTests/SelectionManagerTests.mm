@@ -0,0 +1,210 @@
+//
+//  SelectionManagerTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <set>
+#import <vector>
+#import "SceneRendererNull.h"
+#import "SelectionManager.h"
+#import "GlobeView.h"
+#import "FlatMath.h"
+
+using namespace WhirlyKit;
+
+// Split evenly between rectangles, boxes, lines and billboards
+static const int NumSelectables = 500000;
+
+// Selectable features scattered around a region, like a few zoom levels of vector tiles
+static void AddSelectables(SelectionManager *selectManager,CoordSystemDisplayAdapter *coordAdapter,int numSelectables)
+{
+    unsigned int rand = 12345;
+    auto next = [&rand](unsigned int limit) { rand = rand * 1103515245u + 12345u;  return (rand >> 8) % limit; };
+    auto randomLoc = [&]() {
+        const GeoCoord geo = GeoCoord::CoordFromDegrees(-5.0 + next(100000) / 10000.0, 40.0 + next(50000) / 10000.0);
+        return coordAdapter->localToDisplay(coordAdapter->getCoordSystem()->geographicToLocal3d(geo));
+    };
+    // Somewhere between 50m and 500m across
+    auto randomSize = [&]() { return (50.0 + next(450)) / EarthRadius; };
+
+    const Eigen::Matrix4d identMat = Eigen::Matrix4d::Identity();
+    for (int ii=0;ii<numSelectables;ii++)
+    {
+        const SimpleIdentity selectID = ii+1;
+        const Point3d center = randomLoc();
+        const double size = randomSize();
+        switch (ii % 4)
+        {
+            case 0:
+            {
+                Point3f pts[4];
+                pts[0] = (center + Point3d(-size,-size,0.0)).cast<float>();
+                pts[1] = (center + Point3d(size,-size,0.0)).cast<float>();
+                pts[2] = (center + Point3d(size,size,0.0)).cast<float>();
+                pts[3] = (center + Point3d(-size,size,0.0)).cast<float>();
+                selectManager->addSelectableRect(selectID, pts, true);
+            }
+                break;
+            case 1:
+                selectManager->addPolytopeFromBox(selectID, center - Point3d(size,size,size), center + Point3d(size,size,size),
+                                                  identMat, DrawVisibleInvalid, DrawVisibleInvalid, true);
+                break;
+            case 2:
+            {
+                const Point3dVector pts = { center, center + Point3d(size,size/2.0,0.0), center + Point3d(2.0*size,0.0,size) };
+                selectManager->addSelectableLinear(selectID, pts, DrawVisibleInvalid, DrawVisibleInvalid, true);
+            }
+                break;
+            case 3:
+                selectManager->addSelectableBillboard(selectID, center, center.normalized(), Point2d(size,size),
+                                                      DrawVisibleInvalid, DrawVisibleInvalid, true);
+                break;
+        }
+    }
+}
+
+// Touch points spread over the screen
+static std::vector<Point2f> MakeTouches(const Point2f &frameSize)
+{
+    std::vector<Point2f> touches;
+    for (int iy=1;iy<8;iy++)
+        for (int ix=1;ix<8;ix++)
+            touches.emplace_back(frameSize.x() * ix / 8.0, frameSize.y() * iy / 8.0);
+    return touches;
+}
+
+// Sorted IDs of everything picked at a touch point
+static std::vector<SimpleIdentity> PickedIDs(SelectionManager *selectManager,const Point2f &touch,const ViewStateRef &viewState)
+{
+    std::vector<SelectionManager::SelectedObject> selObjs;
+    selectManager->pickObjects(touch, 20.0, viewState, selObjs);
+    std::vector<SimpleIdentity> ids;
+    for (const auto &selObj : selObjs)
+        ids.insert(ids.end(), selObj.selectIDs.begin(), selObj.selectIDs.end());
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+@interface SelectionManagerTests : XCTestCase
+
+@end
+
+@implementation SelectionManagerTests
+{
+    WhirlyGlobe::GlobeViewRef view;
+    SceneNull *scene;
+    SceneRendererNullRef renderer;
+    SelectionManagerRef selectManager;
+    ViewStateRef viewState;
+    std::vector<Point2f> touches;
+}
+
+- (void)setUp {
+    renderer = std::make_shared<SceneRendererNull>();
+    renderer->setup(2048, 1536, 2.0);
+
+    view = std::make_shared<WhirlyGlobe::GlobeView>(nullptr);
+    view->continuousZoom = true;
+    scene = new SceneNull(view->coordAdapter);
+    renderer->setScene(scene);
+    renderer->setView(view.get());
+
+    selectManager = scene->getManager<SelectionManager>(kWKSelectionManager);
+    AddSelectables(selectManager.get(), view->coordAdapter, NumSelectables);
+
+    view->setRotQuat(view->makeRotationToGeoCoord(GeoCoord::CoordFromDegrees(0.0, 42.5), true), false);
+    view->setHeightAboveGlobe(0.002, false);
+    viewState = view->makeViewState(renderer.get());
+
+    touches = MakeTouches(Point2f(1024.0, 768.0));
+}
+
+- (void)tearDown {
+    viewState = nullptr;
+    selectManager = nullptr;
+    scene->teardown(nullptr);
+    renderer->setScene(nullptr);
+    delete scene;
+    scene = nullptr;
+    renderer = nullptr;
+    view = nullptr;
+}
+
+// Pick at all the touch points, returning the number of hits
+- (int)pickAll:(bool)useSpatialIndex {
+    selectManager->setUseSpatialIndex(useSpatialIndex);
+    int numHits = 0;
+    for (const auto &touch : touches)
+        numHits += PickedIDs(selectManager.get(), touch, viewState).size();
+    return numHits;
+}
+
+// The spatial index should find exactly what looking at everything does
+- (void)testIndexMatchesScan {
+    int numHits = 0;
+    for (const auto &touch : touches)
+    {
+        selectManager->setUseSpatialIndex(true);
+        const std::vector<SimpleIdentity> indexIDs = PickedIDs(selectManager.get(), touch, viewState);
+        selectManager->setUseSpatialIndex(false);
+        const std::vector<SimpleIdentity> scanIDs = PickedIDs(selectManager.get(), touch, viewState);
+        XCTAssertTrue(indexIDs == scanIDs);
+        numHits += indexIDs.size();
+    }
+    XCTAssertGreaterThan(numHits, 0);
+}
+
+// Removed objects shouldn't come back from the index
+- (void)testIndexRemove {
+    bool tested = false;
+    for (const auto &touch : touches)
+    {
+        const std::vector<SimpleIdentity> ids = PickedIDs(selectManager.get(), touch, viewState);
+        if (ids.empty())
+            continue;
+
+        selectManager->removeSelectable(ids.front());
+        const std::vector<SimpleIdentity> newIDs = PickedIDs(selectManager.get(), touch, viewState);
+        XCTAssertEqual(newIDs.size(), ids.size()-1);
+        XCTAssertTrue(std::find(newIDs.begin(), newIDs.end(), ids.front()) == newIDs.end());
+        tested = true;
+        break;
+    }
+    XCTAssertTrue(tested);
+}
+
+// Picking with the spatial index.  The first pick builds the index, so do that first.
+- (void)testIndexPickPerformance {
+    [self pickAll:true];
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        const int numHits = [self pickAll:true];
+        NSLog(@"Indexed pick: %.2f ms/tap over %d selectables, %d hits", (TimeGetCurrent() - startTime) * 1000.0 / touches.size(), NumSelectables, numHits);
+    }];
+}
+
+// Picking by projecting every selectable.  This is slow enough that a few taps will do.
+- (void)testScanPickPerformance {
+    touches.resize(4);
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        const int numHits = [self pickAll:false];
+        NSLog(@"Scanning pick: %.2f ms/tap over %d selectables, %d hits", (TimeGetCurrent() - startTime) * 1000.0 / touches.size(), NumSelectables, numHits);
+    }];
+}
+
+@end
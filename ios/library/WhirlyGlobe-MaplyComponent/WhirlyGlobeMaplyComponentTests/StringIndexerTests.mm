@@ -0,0 +1,169 @@
+//
+//  StringIndexerTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <mutex>
+#import <string>
+#import <thread>
+#import <unordered_map>
+#import <vector>
+#import "StringIndexer.h"
+#import "Platform.h"
+
+using namespace WhirlyKit;
+
+// Attribute keys from OpenMapTiles and raw OSM extracts, most common first
+static const char *OSMKeys[] = {
+    "class", "subclass", "name", "name_en", "name_de", "name:latin", "name:nonlatin", "name_int",
+    "rank", "brunnel", "oneway", "ramp", "layer", "level", "indoor", "surface", "service", "access",
+    "ref", "ref_length", "network", "admin_level", "disputed", "maritime", "iso_a2", "capital",
+    "ele", "ele_ft", "intermittent", "housenumber", "render_height", "render_min_height", "colour",
+    "hide_3d", "building", "highway", "landuse", "natural", "waterway", "amenity", "shop", "tourism",
+};
+
+// Lookups for one thread: mostly the common keys, with a long tail of rare ones
+static std::vector<std::string> MakeLookups(int numLookups,int seed)
+{
+    unsigned int rand = 777 + seed;
+    auto next = [&rand](unsigned int limit) { rand = rand * 1103515245u + 12345u;  return (rand >> 8) % limit; };
+
+    const int numKeys = sizeof(OSMKeys) / sizeof(OSMKeys[0]);
+    std::vector<std::string> lookups;
+    lookups.reserve(numLookups);
+    for (int ii=0;ii<numLookups;ii++)
+    {
+        if (next(10) == 0)
+            lookups.push_back("name:x" + std::to_string(next(2000)));
+        else
+            // Skewed toward the front of the list
+            lookups.push_back(OSMKeys[next(numKeys) * next(numKeys) / numKeys]);
+    }
+    return lookups;
+}
+
+// The way the indexer used to work: one lock around a string keyed map
+class LockedIndexer
+{
+public:
+    StringIdentity getStringID(const std::string &str)
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        const auto it = ids.find(str);
+        if (it != ids.end())
+            return it->second;
+        const StringIdentity newID = ids.size() + 1;
+        ids[str] = newID;
+        return newID;
+    }
+
+protected:
+    std::mutex lock;
+    std::unordered_map<std::string,StringIdentity> ids;
+};
+
+static const int LookupsPerThread = 200000;
+
+// Run the lookups on the given number of threads, returning how long it took in seconds
+static double InternOnThreads(const std::vector<std::vector<std::string>> &lookups,int numThreads,LockedIndexer *lockedIndexer)
+{
+    const TimeInterval startTime = TimeGetCurrent();
+    std::vector<std::thread> threads;
+    for (int ti=0;ti<numThreads;ti++)
+        threads.emplace_back([&lookups,ti,lockedIndexer]()
+        {
+            StringIdentity total = 0;
+            for (const auto &str : lookups[ti])
+                total += lockedIndexer ? lockedIndexer->getStringID(str) : StringIndexer::getStringID(str);
+            (void)total;
+        });
+    for (auto &thread : threads)
+        thread.join();
+    return TimeGetCurrent() - startTime;
+}
+
+@interface StringIndexerTests : XCTestCase
+
+@end
+
+@implementation StringIndexerTests
+{
+    std::vector<std::vector<std::string>> lookups;
+}
+
+- (void)setUp {
+    for (int ti=0;ti<16;ti++)
+        lookups.push_back(MakeLookups(LookupsPerThread, ti));
+}
+
+- (void)tearDown {
+    lookups.clear();
+}
+
+// Everyone interning the same new strings at once gets the same IDs, and they map back
+- (void)testConcurrentIntern {
+    const int numThreads = 8, numStrings = 5000;
+    std::vector<std::vector<StringIdentity>> ids(numThreads, std::vector<StringIdentity>(numStrings));
+    std::vector<std::thread> threads;
+    for (int ti=0;ti<numThreads;ti++)
+        threads.emplace_back([&ids,ti]()
+        {
+            for (int si=0;si<numStrings;si++)
+                ids[ti][si] = StringIndexer::getStringID("StringIndexerTests " + std::to_string(si));
+        });
+    for (auto &thread : threads)
+        thread.join();
+
+    for (int ti=1;ti<numThreads;ti++)
+        XCTAssertTrue(ids[ti] == ids[0]);
+    for (int si=0;si<numStrings;si++)
+    {
+        XCTAssertTrue(StringIndexer::getString(ids[0][si]) == "StringIndexerTests " + std::to_string(si));
+        StringIdentity strID;
+        XCTAssertTrue(StringIndexer::findStringID("StringIndexerTests " + std::to_string(si), strID));
+        XCTAssertEqual(strID, ids[0][si]);
+    }
+    StringIdentity strID;
+    XCTAssertFalse(StringIndexer::findStringID("StringIndexerTests never added", strID));
+}
+
+// Time the lookups on 1 to 16 threads
+- (void)timeIndexer:(bool)locked {
+    // The first pass adds the strings, after that it's all lookups
+    InternOnThreads(lookups, 1, nullptr);
+    auto lockedIndexer = std::make_shared<LockedIndexer>();
+
+    [self measureBlock:^{
+        for (int numThreads : { 1, 2, 4, 8, 16 })
+        {
+            const double howLong = InternOnThreads(lookups, numThreads, locked ? lockedIndexer.get() : nullptr);
+            NSLog(@"%s indexer, %2d threads: %.2f ms, %.1f ns per lookup", locked ? "Locked" : "Lock-free", numThreads,
+                  howLong * 1000.0, howLong * 1e9 / (numThreads * LookupsPerThread));
+        }
+    }];
+}
+
+- (void)testStringIndexerContentionPerformance {
+    [self timeIndexer:false];
+}
+
+// The same with a single lock, for comparison
+- (void)testLockedIndexerContentionPerformance {
+    [self timeIndexer:true];
+}
+
+@end
@@ -0,0 +1,353 @@
+//
+//  TesselatorTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <cmath>
+#import <fstream>
+#import <sstream>
+#import <string>
+#import <vector>
+#import "Tesselator.h"
+#import "Platform.h"
+#import "PolygonFixtures.h"
+
+using namespace WhirlyKit;
+
+// Polygons that exercise the concave and hole handling.  Some are big enough for z-order hashing.
+static std::vector<std::pair<std::string,Polygon>> TestPolygons()
+{
+    std::vector<std::pair<std::string,Polygon>> polys;
+
+    polys.push_back({"L", {MakeRing({{0,0},{4,0},{4,1},{1,1},{1,3},{0,3}})}});
+    polys.push_back({"collinear", {MakeRing({{0,0},{1,0},{2,0},{3,0},{3,1},{3,2},{2,2},{2,1},{1,1},{0,1}})}});
+    polys.push_back({"closed", {MakeRing({{0,0},{5,0},{5,5},{3,5},{3,2},{2,2},{2,5},{0,5},{0,0}})}});
+
+    VectorRing comb = MakeRing({{0,0},{20,0}});
+    for (int ii=19;ii>=0;ii--)
+        comb.push_back(Point2f(ii+(ii%2 ? 1 : 0),ii%2 ? 6 : 1));
+    polys.push_back({"comb", {comb}});
+
+    polys.push_back({"star", {MakeStar(0,0,10,4,12)}});
+
+    // Thin zig-zag band, lots of reflex vertices
+    VectorRing zigzag;
+    for (int ii=0;ii<60;ii++)
+        zigzag.push_back(Point2f(ii,ii%2 ? 3 : 0));
+    for (int ii=59;ii>=0;ii--)
+        zigzag.push_back(Point2f(ii,(ii%2 ? 3 : 0) + 1.5));
+    polys.push_back({"zigzag", {zigzag}});
+
+    polys.push_back({"square hole", {MakeRing({{0,0},{10,0},{10,10},{0,10}}),
+                                     MakeRing({{3,3},{3,7},{7,7},{7,3}})}});
+    polys.push_back({"three holes", {MakeRing({{0,0},{30,0},{30,10},{0,10}}),
+                                     MakeRing({{2,2},{2,8},{8,8},{8,2}}),
+                                     MakeRing({{12,2},{12,8},{14,8},{14,4},{18,4},{18,2}}),
+                                     MakeStar(24,5,3,1.5,5)}});
+    polys.push_back({"star hole", {MakeStar(0,0,20,12,9),
+                                   MakeStar(0,0,6,3,6)}});
+
+    // Wobbly circle with holes, big enough to hash
+    VectorRing wobble;
+    for (int ii=0;ii<200;ii++)
+    {
+        const double ang = 2.0 * M_PI * ii / 200;
+        const double rad = 100.0 + (ii % 3 ? 0.0 : 12.0);
+        wobble.push_back(Point2f(rad * cos(ang),rad * sin(ang)));
+    }
+    polys.push_back({"wobble holes", {wobble,
+                                      MakeStar(-40,0,20,10,16),
+                                      MakeRing({{20,-20},{20,20},{60,20},{60,10},{30,10},{30,-20}})}});
+
+    return polys;
+}
+
+static double TriArea(const Point2d &a,const Point2d &b,const Point2d &c)
+{
+    return ((b.x() - a.x()) * (c.y() - a.y()) - (c.x() - a.x()) * (b.y() - a.y())) / 2.0;
+}
+
+static double PolygonArea(const Polygon &poly)
+{
+    double area = 0.0;
+    for (unsigned int ri=0;ri<poly.size();ri++)
+    {
+        area += (ri == 0 ? 1.0 : -1.0) * std::abs(RingArea(poly[ri]));
+    }
+    return area;
+}
+
+// Even-odd over all the rings
+static bool PointInPolygon(const Polygon &poly,const Point2d &pt)
+{
+    bool inside = false;
+    for (const VectorRing &ring : poly)
+        for (unsigned int ii=0,jj=ring.size()-1;ii<ring.size();jj=ii++)
+        {
+            const Point2d a = ring[ii].cast<double>(), b = ring[jj].cast<double>();
+            if ((a.y() > pt.y()) != (b.y() > pt.y()) &&
+                pt.x() < (b.x() - a.x()) * (pt.y() - a.y()) / (b.y() - a.y()) + a.x())
+                inside = !inside;
+        }
+    return inside;
+}
+
+static bool PointInTriangle(const Point2d &a,const Point2d &b,const Point2d &c,const Point2d &pt)
+{
+    const double d0 = TriArea(a,b,pt), d1 = TriArea(b,c,pt), d2 = TriArea(c,a,pt);
+    return (d0 >= 0 && d1 >= 0 && d2 >= 0) || (d0 <= 0 && d1 <= 0 && d2 <= 0);
+}
+
+// Sample points that are inside the polygon should land in exactly one triangle, and the rest in none
+static int CountCoverageErrors(const Polygon &poly,const std::vector<Point2d> &triPts)
+{
+    Point2d ll(MAXFLOAT,MAXFLOAT), ur(-MAXFLOAT,-MAXFLOAT);
+    for (const Point2f &pt : poly[0])
+    {
+        ll = ll.cwiseMin(pt.cast<double>());
+        ur = ur.cwiseMax(pt.cast<double>());
+    }
+
+    // Odd steps, so we don't land on the edges
+    int errors = 0;
+    const int steps = 97;
+    for (int iy=0;iy<steps;iy++)
+        for (int ix=0;ix<steps;ix++)
+        {
+            const Point2d pt(ll.x() + (ur.x() - ll.x()) * (ix + 0.3183) / steps,
+                             ll.y() + (ur.y() - ll.y()) * (iy + 0.7071) / steps);
+            int hits = 0;
+            for (unsigned int ii=0;ii+2<triPts.size();ii+=3)
+                if (PointInTriangle(triPts[ii],triPts[ii+1],triPts[ii+2],pt))
+                    hits++;
+            if (hits != (PointInPolygon(poly,pt) ? 1 : 0))
+                errors++;
+        }
+    return errors;
+}
+
+// Run TesselateLoops with the given tesselator and return the triangle corners
+static std::vector<Point2d> TesselateWith(TesselatorType type,const Polygon &poly)
+{
+    SetTesselatorType(type);
+    VectorTrianglesRef tris = VectorTriangles::createTriangles();
+    TesselateLoops(poly, tris);
+
+    std::vector<Point2d> triPts;
+    for (const auto &tri : tris->tris)
+        for (unsigned int ii=0;ii<3;ii++)
+            triPts.push_back(Point2d(tris->pts[tri.pts[ii]].x(),tris->pts[tri.pts[ii]].y()));
+    return triPts;
+}
+
+// Sum of the triangle areas, counting which way they face.  GLU will emit the odd degenerate triangle, which faces neither way.
+static double TotalArea(const std::vector<Point2d> &triPts,int *numClockwise = nullptr,int *numCounter = nullptr)
+{
+    double area = 0.0;
+    for (unsigned int ii=0;ii+2<triPts.size();ii+=3)
+    {
+        const double triArea = TriArea(triPts[ii],triPts[ii+1],triPts[ii+2]);
+        area += std::abs(triArea);
+        if (numClockwise && triArea < 0.0)
+            (*numClockwise)++;
+        if (numCounter && triArea > 0.0)
+            (*numCounter)++;
+    }
+    return area;
+}
+
+// Stand-in for the OSM extracts: blocks of notched buildings, some with courtyards, and wobbly landuse areas
+static std::vector<Polygon> MakeCityPolygons()
+{
+    FixtureRandom rand(9753);
+
+    std::vector<Polygon> polys;
+    for (int ii=0;ii<20000;ii++)
+    {
+        const float x = rand.next(10000), y = rand.next(10000), w = 8 + rand.next(30), h = 8 + rand.next(30), n = 2 + rand.next(4);
+        polys.push_back(MakeBuilding(x,y,w,h,n,ii % 10 == 0));
+    }
+    for (int ii=0;ii<500;ii++)
+    {
+        const float cx = rand.next(10000), cy = rand.next(10000), rad = 50 + rand.next(200);
+        const int numPts = 20 + rand.next(400);
+        Polygon poly = {MakeBlob(rand,cx,cy,rad,numPts,0.2)};
+        if (ii % 4 == 0)
+            poly.push_back(MakeStar(cx,cy,rad/4,rad/8,8));
+        polys.push_back(poly);
+    }
+    return polys;
+}
+
+// Building and landuse polygons from the Belfast OSM extracts the Android tester ships, if they're in the checkout
+static const std::vector<Polygon> &OSMPolygons()
+{
+    static std::vector<Polygon> polys;
+    if (!polys.empty())
+        return polys;
+
+    const std::string testDir = std::string(__FILE__).substr(0, std::string(__FILE__).find_last_of('/'));
+    for (const char *name : { "buildings", "landusages" })
+    {
+        std::ifstream inFile(testDir + "/../../../../android/apps/AutoTesterAndroid/app/src/main/assets/belfast_ireland_" + name + ".geojson");
+        if (!inFile)
+            continue;
+        std::stringstream json;
+        json << inFile.rdbuf();
+
+        ShapeSet shapes;
+        std::string crs;
+        if (!VectorParseGeoJSON(shapes, json.str(), crs))
+            continue;
+        for (const auto &shape : shapes)
+            if (const auto areal = std::dynamic_pointer_cast<VectorAreal>(shape))
+                if (!areal->loops.empty())
+                    polys.push_back(areal->loops);
+    }
+    if (polys.empty())
+        polys = MakeCityPolygons();
+
+    return polys;
+}
+
+@interface TesselatorTests : XCTestCase
+
+@end
+
+@implementation TesselatorTests
+
+- (void)tearDown {
+    SetTesselatorType(TesselatorEarcut);
+}
+
+// The ear clipper on its own, without the GLU fallback, has to cover each polygon exactly
+- (void)testEarcutCoverage {
+    EarcutTesselator tess;
+    for (const auto &test : TestPolygons())
+    {
+        const Polygon &poly = test.second;
+        NSString *name = [NSString stringWithUTF8String:test.first.c_str()];
+
+        std::vector<double> coords;
+        std::vector<unsigned int> holeStarts, tris;
+        for (unsigned int ri=0;ri<poly.size();ri++)
+        {
+            VectorRing ring = poly[ri];
+            if (ring.size() > 1 && ring.front() == ring.back())
+                ring.pop_back();
+            if (ri > 0)
+                holeStarts.push_back(coords.size() / 2);
+            for (const Point2f &pt : ring)
+            {
+                coords.push_back(pt.x());
+                coords.push_back(pt.y());
+            }
+        }
+        tess.tesselate(coords.data(), coords.size() / 2, holeStarts, tris);
+
+        XCTAssertTrue(tris.size() > 0 && tris.size() % 3 == 0, @"%@", name);
+        std::vector<Point2d> triPts;
+        for (const unsigned int idx : tris)
+        {
+            XCTAssertTrue(idx < coords.size() / 2, @"%@", name);
+            if (idx < coords.size() / 2)
+                triPts.push_back(Point2d(coords[2*idx],coords[2*idx+1]));
+        }
+
+        const double polyArea = PolygonArea(poly);
+        XCTAssertEqualWithAccuracy(TotalArea(triPts), polyArea, 1e-9 * polyArea, @"%@", name);
+        XCTAssertEqual(CountCoverageErrors(poly, triPts), 0, @"%@", name);
+    }
+}
+
+// Ear clipping and GLU should produce the same area, coverage and winding
+- (void)testEarcutMatchesGLU {
+    for (const auto &test : TestPolygons())
+    {
+        const Polygon &poly = test.second;
+        NSString *name = [NSString stringWithUTF8String:test.first.c_str()];
+
+        const std::vector<Point2d> earcutPts = TesselateWith(TesselatorEarcut, poly);
+        const std::vector<Point2d> gluPts = TesselateWith(TesselatorGLU, poly);
+
+        int earcutClockwise = 0, earcutCounter = 0, gluClockwise = 0, gluCounter = 0;
+        const double earcutArea = TotalArea(earcutPts, &earcutClockwise, &earcutCounter);
+        const double gluArea = TotalArea(gluPts, &gluClockwise, &gluCounter);
+        const double polyArea = PolygonArea(poly);
+        XCTAssertEqualWithAccuracy(earcutArea, gluArea, 1e-5 * polyArea, @"%@", name);
+        XCTAssertEqualWithAccuracy(earcutArea, polyArea, 1e-5 * polyArea, @"%@", name);
+
+        XCTAssertEqual(CountCoverageErrors(poly, earcutPts), 0, @"%@", name);
+        XCTAssertEqual(CountCoverageErrors(poly, gluPts), 0, @"%@", name);
+
+        // Everything faces the same way
+        XCTAssertTrue(earcutClockwise == 0 || earcutCounter == 0, @"%@", name);
+        XCTAssertTrue(gluClockwise == 0 || gluCounter == 0, @"%@", name);
+        XCTAssertEqual(earcutClockwise > 0, gluClockwise > 0, @"%@", name);
+    }
+}
+
+// Real world buildings and landuse should come out with the same total area either way
+- (void)testOSMAreaMatchesGLU {
+    const std::vector<Polygon> &polys = OSMPolygons();
+    XCTAssertGreaterThan(polys.size(), 1000);
+
+    int numMismatched = 0;
+    for (const Polygon &poly : polys)
+    {
+        const double earcutArea = TotalArea(TesselateWith(TesselatorEarcut, poly));
+        const double gluArea = TotalArea(TesselateWith(TesselatorGLU, poly));
+        if (std::abs(earcutArea - gluArea) > 1e-4 * std::max(gluArea, PolygonArea(poly)))
+            numMismatched++;
+    }
+    XCTAssertEqual(numMismatched, 0);
+}
+
+// Tesselate all the OSM polygons through TesselateLoops, the way the vector manager does
+- (void)tesselateOSM:(TesselatorType)type {
+    const std::vector<Polygon> &polys = OSMPolygons();
+    unsigned int numVerts = 0;
+    for (const Polygon &poly : polys)
+        for (const VectorRing &ring : poly)
+            numVerts += ring.size();
+
+    [self measureBlock:^{
+        SetTesselatorType(type);
+        unsigned int numTris = 0;
+        const TimeInterval startTime = TimeGetCurrent();
+        for (const Polygon &poly : polys)
+        {
+            VectorTrianglesRef tris = VectorTriangles::createTriangles();
+            TesselateLoops(poly, tris);
+            numTris += tris->tris.size();
+        }
+        const TimeInterval howLong = TimeGetCurrent() - startTime;
+        NSLog(@"%s: %d polygons (%d vertices) in %.1f ms, %.0f polygons/s, %d triangles",
+              type == TesselatorEarcut ? "Ear clipping" : "GLU", (int)polys.size(), numVerts,
+              howLong * 1000.0, polys.size() / howLong, numTris);
+    }];
+}
+
+- (void)testEarcutOSMPerformance {
+    [self tesselateOSM:TesselatorEarcut];
+}
+
+- (void)testGLUOSMPerformance {
+    [self tesselateOSM:TesselatorGLU];
+}
+
+@end
@@ -0,0 +1,213 @@
+//
+//  TextureConversionTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <vector>
+#import "Texture.h"
+#import "Platform.h"
+
+using namespace WhirlyKit;
+
+// The scalar loops the vectorized converters replaced
+static uint16_t Ref565(uint32_t p)
+{
+    const uint32_t r = (((p >> 0)  & 0xFF) >> 3);
+    const uint32_t g = (((p >> 8)  & 0xFF) >> 2);
+    const uint32_t b = (((p >> 16) & 0xFF) >> 3);
+    return (uint16_t)((r << 11) | (g << 5) | (b << 0));
+}
+
+static uint16_t Ref4444(uint32_t p)
+{
+    const uint32_t r = (((p >> 0)  & 0xFF) >> 4);
+    const uint32_t g = (((p >> 8)  & 0xFF) >> 4);
+    const uint32_t b = (((p >> 16) & 0xFF) >> 4);
+    const uint32_t a = (((p >> 24) & 0xFF) >> 4);
+    return (uint16_t)((r << 12) | (g << 8) | (b << 4) | (a << 0));
+}
+
+static uint16_t Ref5551(uint32_t p)
+{
+    const uint32_t r = (((p >> 0)  & 0xFF) >> 3);
+    const uint32_t g = (((p >> 8)  & 0xFF) >> 3);
+    const uint32_t b = (((p >> 16) & 0xFF) >> 3);
+    const uint32_t a = (((p >> 24) & 0xFF) >> 7);
+    return (uint16_t)((r << 11) | (g << 6) | (b << 1) | (a << 0));
+}
+
+static uint16_t RefRG(uint32_t p)
+{
+    // Red in the first byte, green in the second
+    return (uint16_t)(((p >> 0) & 0xFF) | (((p >> 8) & 0xFF) << 8));
+}
+
+typedef void (*ConvertFunc)(const uint32_t *,uint16_t *,size_t);
+typedef uint16_t (*RefFunc)(uint32_t);
+
+// Pixels that poke at the edges of each channel, then a repeatable pseudo-random fill
+static std::vector<uint32_t> MakeTestPixels(size_t count)
+{
+    std::vector<uint32_t> pixels = {
+        0x00000000, 0xFFFFFFFF, 0x80808080, 0x7F7F7F7F,
+        0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000,
+        0x07070707, 0x08080808, 0xF8F8F8F8, 0xF7F7F7F7,
+        0x0F0F0F0F, 0xF0F0F0F0, 0xAAAAAAAA, 0x55555555,
+    };
+    for (int bit=0;bit<32;bit++)
+    {
+        pixels.push_back(1U << bit);
+        pixels.push_back(~(1U << bit));
+    }
+
+    uint32_t seed = 0x12345678;
+    while (pixels.size() < count)
+    {
+        seed = seed * 1664525U + 1013904223U;
+        pixels.push_back(seed);
+    }
+    pixels.resize(count);
+
+    return pixels;
+}
+
+// Converters along with the scalar loops they replaced, for the throughput comparison
+static const struct {
+    const char *name;
+    ConvertFunc convert;
+    RefFunc ref;
+} Converters[] = {
+    { "565", &ConvertRGBATo565, &Ref565 },
+    { "4444", &ConvertRGBATo4444, &Ref4444 },
+    { "5551", &ConvertRGBATo5551, &Ref5551 },
+    { "RG", &ConvertRGBAToRG, &RefRG },
+};
+
+// Convert the tile over and over, returning millions of pixels per second
+static double ConvertThroughput(ConvertFunc convert,RefFunc ref,const std::vector<uint32_t> &pixels,std::vector<uint16_t> &out,int numTiles)
+{
+    const TimeInterval startTime = TimeGetCurrent();
+    for (int ti=0;ti<numTiles;ti++)
+    {
+        if (convert)
+            convert(pixels.data(),out.data(),pixels.size());
+        else
+            for (size_t ii=0;ii<pixels.size();ii++)
+                out[ii] = ref(pixels[ii]);
+    }
+    return (double)pixels.size() * numTiles / (TimeGetCurrent() - startTime) / 1e6;
+}
+
+@interface TextureConversionTests : XCTestCase
+
+@end
+
+@implementation TextureConversionTests
+
+// Compare a converter against its scalar version for every length up to a few SIMD blocks,
+//  at every alignment, and make sure nothing is written past the end.
+- (void)checkConvert:(ConvertFunc)convert ref:(RefFunc)ref name:(NSString *)name
+{
+    const size_t maxLen = 67;
+    const uint16_t sentinel = 0xBEEF;
+    const std::vector<uint32_t> pixels = MakeTestPixels(maxLen + 4);
+
+    for (size_t offset=0;offset<4;offset++)
+    {
+        for (size_t len=0;len<=maxLen;len++)
+        {
+            std::vector<uint16_t> out(len + offset + 8, sentinel);
+            convert(&pixels[offset],&out[offset],len);
+
+            for (size_t ii=0;ii<offset;ii++)
+                XCTAssertEqual(out[ii], sentinel, @"%@ wrote before the start, len %zu offset %zu", name, len, offset);
+            for (size_t ii=0;ii<len;ii++)
+            {
+                const uint32_t pix = pixels[offset + ii];
+                XCTAssertEqual(out[offset + ii], ref(pix), @"%@ mismatch for 0x%08x at %zu, len %zu offset %zu",
+                               name, pix, ii, len, offset);
+            }
+            for (size_t ii=offset+len;ii<out.size();ii++)
+                XCTAssertEqual(out[ii], sentinel, @"%@ wrote past the end, len %zu offset %zu", name, len, offset);
+        }
+    }
+}
+
+- (void)testConvert565 {
+    [self checkConvert:&ConvertRGBATo565 ref:&Ref565 name:@"565"];
+}
+
+- (void)testConvert4444 {
+    [self checkConvert:&ConvertRGBATo4444 ref:&Ref4444 name:@"4444"];
+}
+
+- (void)testConvert5551 {
+    [self checkConvert:&ConvertRGBATo5551 ref:&Ref5551 name:@"5551"];
+}
+
+- (void)testConvertRG {
+    [self checkConvert:&ConvertRGBAToRG ref:&RefRG name:@"RG"];
+}
+
+// Odd widths get a padding pixel on every row, which has to come out zeroed
+- (void)testConvertRGPadded {
+    for (int width=1;width<=19;width++)
+    {
+        const int height = 3;
+        const std::vector<uint32_t> pixels = MakeTestPixels(width * height);
+        RawDataRef inData = std::make_shared<RawDataWrapper>((void *)pixels.data(), pixels.size() * 4, false);
+
+        RawDataRef outData = ConvertRGBATo16(inData, width, height, true);
+        const int outWidth = width + (width % 2);
+        XCTAssertEqual(outData->getLen(), (size_t)(outWidth * height * 2));
+
+        const uint16_t *out = (const uint16_t *)outData->getRawData();
+        for (int y=0;y<height;y++)
+        {
+            for (int x=0;x<width;x++)
+                XCTAssertEqual(out[y*outWidth + x], RefRG(pixels[y*width + x]), @"width %d at (%d,%d)", width, x, y);
+            for (int x=width;x<outWidth;x++)
+                XCTAssertEqual(out[y*outWidth + x], 0, @"width %d padding at (%d,%d)", width, x, y);
+        }
+    }
+}
+
+// Throughput of each converter and its scalar loop on tiles of the given size, into a reused buffer
+- (void)timeTileSize:(int)tileSize {
+    const std::vector<uint32_t> pixels = MakeTestPixels(tileSize * tileSize);
+    __block std::vector<uint16_t> out(pixels.size());
+    const int numTiles = 64 * 256 * 256 / (tileSize * tileSize);
+
+    [self measureBlock:^{
+        for (const auto &conv : Converters)
+        {
+            const double vecRate = ConvertThroughput(conv.convert, conv.ref, pixels, out, numTiles);
+            const double scalarRate = ConvertThroughput(nullptr, conv.ref, pixels, out, numTiles);
+            NSLog(@"%d px tiles, %s: %.0f Mpix/s, scalar %.0f Mpix/s", tileSize, conv.name, vecRate, scalarRate);
+        }
+    }];
+}
+
+- (void)testConvert256Performance {
+    [self timeTileSize:256];
+}
+
+- (void)testConvert512Performance {
+    [self timeTileSize:512];
+}
+
+@end
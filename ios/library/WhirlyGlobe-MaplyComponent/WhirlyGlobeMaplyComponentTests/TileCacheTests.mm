@@ -0,0 +1,410 @@
+//
+//  TileCacheTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <dirent.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import <sys/stat.h>
+#import <set>
+#import <string>
+#import <vector>
+#import "TileCache.h"
+#import "Platform.h"
+
+using namespace WhirlyKit;
+
+// Contents that differ by tile and source, with a length that isn't a multiple of 8
+static std::vector<unsigned char> MakeTileData(const QuadTreeIdentifier &ident,const std::string &source)
+{
+    std::vector<unsigned char> data(1000 + (ident.x * 37 + ident.y * 11 + ident.level) % 500);
+    for (size_t ii=0;ii<data.size();ii++)
+        data[ii] = (unsigned char)(ii * 31 + ident.x * 7 + ident.y * 3 + ident.level + source.size());
+    return data;
+}
+
+static bool PutTile(TileCache &cache,const QuadTreeIdentifier &ident,const std::string &source)
+{
+    const std::vector<unsigned char> data = MakeTileData(ident, source);
+    const RawDataWrapper rawData(data.data(), data.size(), false);
+    return cache.putTile(ident, source, rawData);
+}
+
+// The tile is there and holds what we put in it
+static bool HasTile(TileCache &cache,const QuadTreeIdentifier &ident,const std::string &source)
+{
+    const RawDataRef rawData = cache.getTile(ident, source);
+    if (!rawData)
+        return false;
+    const std::vector<unsigned char> data = MakeTileData(ident, source);
+    return rawData->getLen() == data.size() && memcmp(rawData->getRawData(), data.data(), data.size()) == 0;
+}
+
+static std::vector<std::string> PackFiles(const std::string &dir)
+{
+    std::vector<std::string> files;
+    if (DIR *dirp = opendir(dir.c_str()))
+    {
+        while (struct dirent *dirEnt = readdir(dirp))
+            if (strncmp(dirEnt->d_name, "pack-", 5) == 0)
+                files.push_back(dir + "/" + dirEnt->d_name);
+        closedir(dirp);
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+static void RemoveDir(const std::string &dir)
+{
+    for (const std::string &file : PackFiles(dir))
+        unlink(file.c_str());
+    unlink((dir + "/index").c_str());
+    unlink((dir + "/index.tmp").c_str());
+    rmdir(dir.c_str());
+}
+
+// The tiles a loader asks for as the camera pans across a city, zooms in two levels and back out.
+// Only tiles that weren't on screen the frame before get fetched.
+static std::vector<QuadTreeIdentifier> MakeReplay()
+{
+    std::vector<QuadTreeIdentifier> replay;
+    std::set<QuadTreeIdentifier> lastVisible;
+    const int numFrames = 300;
+    for (int frame=0;frame<numFrames;frame++)
+    {
+        const int zoom = (frame < 100) ? 0 : ((frame < 150) ? 1 : ((frame < 200) ? 2 : ((frame < 250) ? 1 : 0)));
+        const double centerX = 1200.0 + frame * 0.05, centerY = 1500.0 + frame * 0.02;
+        std::set<QuadTreeIdentifier> visible;
+        // The screen at the current level and the level above it for coverage
+        for (int level=12+zoom-1;level<=12+zoom;level++)
+        {
+            const double scale = pow(2.0, level - 12);
+            const int cx = (int)(centerX * scale), cy = (int)(centerY * scale);
+            const int span = (level == 12+zoom) ? 3 : 2;
+            for (int y=cy-span;y<=cy+span;y++)
+                for (int x=cx-span;x<=cx+span;x++)
+                    visible.insert(QuadTreeIdentifier(x,y,level));
+        }
+        for (const auto &ident : visible)
+            if (lastVisible.find(ident) == lastVisible.end())
+                replay.push_back(ident);
+        lastVisible = visible;
+    }
+    return replay;
+}
+
+static std::string SourceFile(const std::string &sourceDir,const QuadTreeIdentifier &ident)
+{
+    return sourceDir + "/" + std::to_string(ident.level) + "_" + std::to_string(ident.x) + "_" + std::to_string(ident.y);
+}
+
+// A local tile source with a file per tile, 16-48k each, which is about what a vector tile runs
+static void WriteSourceTiles(const std::string &sourceDir,const std::vector<QuadTreeIdentifier> &replay)
+{
+    mkdir(sourceDir.c_str(), 0755);
+    const std::set<QuadTreeIdentifier> tiles(replay.begin(), replay.end());
+    for (const auto &ident : tiles)
+    {
+        std::vector<unsigned char> data(16*1024 + (ident.x * 7919 + ident.y * 104729) % (32*1024));
+        for (size_t ii=0;ii<data.size();ii++)
+            data[ii] = (unsigned char)(ii * 13 + ident.x + ident.y * 5 + ident.level);
+        if (FILE *fp = fopen(SourceFile(sourceDir, ident).c_str(), "wb"))
+        {
+            fwrite(data.data(), 1, data.size(), fp);
+            fclose(fp);
+        }
+    }
+}
+
+static void RemoveSourceTiles(const std::string &sourceDir,const std::vector<QuadTreeIdentifier> &replay)
+{
+    for (const auto &ident : replay)
+        unlink(SourceFile(sourceDir, ident).c_str());
+    rmdir(sourceDir.c_str());
+}
+
+// Read the whole file, the way the fetchers read their cache files
+static RawDataRef ReadSourceTile(const std::string &sourceDir,const QuadTreeIdentifier &ident)
+{
+    FILE *fp = fopen(SourceFile(sourceDir, ident).c_str(), "rb");
+    if (!fp)
+        return RawDataRef();
+    fseek(fp, 0, SEEK_END);
+    const long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    void *buf = malloc(len);
+    const bool ok = buf && fread(buf, 1, len, fp) == (size_t)len;
+    fclose(fp);
+    if (!ok)
+    {
+        free(buf);
+        return RawDataRef();
+    }
+    return std::make_shared<RawDataWrapper>(buf, len, true);
+}
+
+// What the remote fetchers do with a tile cache: look there first, then go to the source and save what comes back
+static RawDataRef FetchTile(TileCache &cache,const std::string &sourceDir,const QuadTreeIdentifier &ident)
+{
+    if (RawDataRef data = cache.getTile(ident, sourceDir))
+        return data;
+    RawDataRef data = ReadSourceTile(sourceDir, ident);
+    if (data)
+        cache.putTile(ident, sourceDir, *data);
+    return data;
+}
+
+// Read a byte from every page, like a parser would, so mapped data gets paged in
+static size_t TouchData(const RawData &data)
+{
+    size_t sum = data.getLen();
+    for (size_t ii=0;ii<data.getLen();ii+=4096)
+        sum += data.getRawData()[ii];
+    return sum;
+}
+
+// Fetch everything in the replay and return how many bytes came back
+static size_t ReplayTiles(TileCache &cache,const std::string &sourceDir,const std::vector<QuadTreeIdentifier> &replay)
+{
+    size_t totalBytes = 0;
+    for (const auto &ident : replay)
+        if (RawDataRef data = FetchTile(cache, sourceDir, ident))
+            totalBytes += TouchData(*data) ? data->getLen() : 0;
+    return totalBytes;
+}
+
+@interface TileCacheTests : XCTestCase
+
+@end
+
+@implementation TileCacheTests
+{
+    std::string cacheDir;
+}
+
+- (void)setUp {
+    NSString *dir = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    cacheDir = [dir UTF8String];
+}
+
+- (void)tearDown {
+    RemoveDir(cacheDir);
+}
+
+// Put, get and replace, then again after closing and reopening
+- (void)testRoundTrip {
+    {
+        TileCache cache(cacheDir, 64*1024*1024);
+        XCTAssertTrue(cache.open());
+        for (int y=0;y<16;y++)
+            for (int x=0;x<16;x++)
+            {
+                XCTAssertTrue(PutTile(cache, QuadTreeIdentifier(x,y,4), "base"));
+                XCTAssertTrue(PutTile(cache, QuadTreeIdentifier(x,y,4), "overlay"));
+            }
+        XCTAssertTrue(PutTile(cache, QuadTreeIdentifier(3,3,4), "base"));
+
+        XCTAssertTrue(HasTile(cache, QuadTreeIdentifier(3,3,4), "base"));
+        XCTAssertTrue(HasTile(cache, QuadTreeIdentifier(15,0,4), "overlay"));
+        XCTAssertFalse(HasTile(cache, QuadTreeIdentifier(0,0,5), "base"));
+        XCTAssertFalse(HasTile(cache, QuadTreeIdentifier(0,0,4), "other"));
+        XCTAssertEqual(cache.getStats().numTiles, 512);
+    }
+
+    TileCache cache(cacheDir, 64*1024*1024);
+    XCTAssertTrue(cache.open());
+    XCTAssertEqual(cache.getStats().numTiles, 512);
+    for (int y=0;y<16;y++)
+        for (int x=0;x<16;x++)
+        {
+            XCTAssertTrue(HasTile(cache, QuadTreeIdentifier(x,y,4), "base"));
+            XCTAssertTrue(HasTile(cache, QuadTreeIdentifier(x,y,4), "overlay"));
+        }
+}
+
+// Data handed out stays valid after the cache is closed
+- (void)testDataOutlivesCache {
+    RawDataRef rawData;
+    {
+        TileCache cache(cacheDir, 64*1024*1024);
+        XCTAssertTrue(cache.open());
+        XCTAssertTrue(PutTile(cache, QuadTreeIdentifier(1,2,3), "base"));
+        rawData = cache.getTile(QuadTreeIdentifier(1,2,3), "base");
+    }
+    const std::vector<unsigned char> data = MakeTileData(QuadTreeIdentifier(1,2,3), "base");
+    XCTAssertTrue(rawData && rawData->getLen() == data.size());
+    XCTAssertTrue(rawData && memcmp(rawData->getRawData(), data.data(), data.size()) == 0);
+}
+
+// Lose the index and tear the end of a pack, then make sure the rebuild gets it right
+- (void)testRecovery {
+    {
+        // Small packs so the index and tiles span several of them
+        TileCache cache(cacheDir, 64*1024*1024, 64*1024);
+        XCTAssertTrue(cache.open());
+        for (int x=0;x<200;x++)
+            XCTAssertTrue(PutTile(cache, QuadTreeIdentifier(x,0,8), "base"));
+        // Newer copy in a later pack
+        XCTAssertTrue(PutTile(cache, QuadTreeIdentifier(0,0,8), "base"));
+        cache.removeTile(QuadTreeIdentifier(5,0,8), "base");
+        cache.removeTile(QuadTreeIdentifier(6,0,8), "base");
+        XCTAssertTrue(PutTile(cache, QuadTreeIdentifier(6,0,8), "base"));
+        XCTAssertFalse(HasTile(cache, QuadTreeIdentifier(5,0,8), "base"));
+    }
+    XCTAssertTrue(PackFiles(cacheDir).size() > 1);
+
+    unlink((cacheDir + "/index").c_str());
+    const std::string lastPack = PackFiles(cacheDir).back();
+    const int fd = open(lastPack.c_str(), O_WRONLY | O_APPEND);
+    XCTAssertTrue(fd >= 0);
+    const char junk[100] = {1,2,3,4,5,6,7,8};
+    XCTAssertEqual(write(fd, junk, sizeof(junk)), (ssize_t)sizeof(junk));
+    close(fd);
+
+    TileCache cache(cacheDir, 64*1024*1024, 64*1024);
+    XCTAssertTrue(cache.open());
+    XCTAssertEqual(cache.getStats().numTiles, 199);
+    for (int x=0;x<200;x++)
+    {
+        if (x == 5)
+            XCTAssertFalse(HasTile(cache, QuadTreeIdentifier(x,0,8), "base"));
+        else
+            XCTAssertTrue(HasTile(cache, QuadTreeIdentifier(x,0,8), "base"));
+    }
+
+    // Picks up where it left off
+    XCTAssertTrue(PutTile(cache, QuadTreeIdentifier(5,0,8), "base"));
+    XCTAssertTrue(HasTile(cache, QuadTreeIdentifier(5,0,8), "base"));
+}
+
+// Stays near the size limit and keeps what's been read recently
+- (void)testEviction {
+    const size_t maxBytes = 256*1024, packBytes = 64*1024;
+    TileCache cache(cacheDir, maxBytes, packBytes);
+    XCTAssertTrue(cache.open());
+
+    XCTAssertTrue(PutTile(cache, QuadTreeIdentifier(0,0,10), "base"));
+    for (int x=1;x<1000;x++)
+    {
+        XCTAssertTrue(PutTile(cache, QuadTreeIdentifier(x,0,10), "base"));
+        // Keep reading the first one so it survives
+        XCTAssertTrue(HasTile(cache, QuadTreeIdentifier(0,0,10), "base"));
+    }
+
+    const TileCache::Stats stats = cache.getStats();
+    XCTAssertTrue(stats.totalBytes <= maxBytes);
+    XCTAssertTrue(stats.numTiles < 1000);
+    XCTAssertTrue(HasTile(cache, QuadTreeIdentifier(999,0,10), "base"));
+    XCTAssertFalse(HasTile(cache, QuadTreeIdentifier(1,0,10), "base"));
+}
+
+// A replay through the cache gives back what's in the source, and the second time it's all hits
+- (void)testReplay {
+    const std::vector<QuadTreeIdentifier> replay = MakeReplay();
+    const std::string sourceDir = cacheDir + "-tiles";
+    WriteSourceTiles(sourceDir, replay);
+
+    TileCache cache(cacheDir, 1024*1024*1024);
+    XCTAssertTrue(cache.open());
+    const size_t coldBytes = ReplayTiles(cache, sourceDir, replay);
+    const TileCache::Stats coldStats = cache.getStats();
+    const size_t warmBytes = ReplayTiles(cache, sourceDir, replay);
+    const TileCache::Stats warmStats = cache.getStats();
+    XCTAssertTrue(coldBytes > 0);
+    XCTAssertEqual(coldBytes, warmBytes);
+    XCTAssertEqual(warmStats.hits - coldStats.hits, (long long)replay.size());
+    XCTAssertEqual(warmStats.misses, coldStats.misses);
+
+    for (size_t ii=0;ii<replay.size();ii+=17)
+    {
+        const RawDataRef cached = cache.getTile(replay[ii], sourceDir);
+        const RawDataRef source = ReadSourceTile(sourceDir, replay[ii]);
+        XCTAssertTrue(cached && source && cached->getLen() == source->getLen() &&
+                      memcmp(cached->getRawData(), source->getRawData(), source->getLen()) == 0);
+    }
+
+    RemoveSourceTiles(sourceDir, replay);
+}
+
+// Pan and zoom with nothing cached, so every tile goes to the source and then into the cache
+- (void)testColdReplayPerformance {
+    const std::vector<QuadTreeIdentifier> replay = MakeReplay();
+    const std::string sourceDir = cacheDir + "-tiles";
+    WriteSourceTiles(sourceDir, replay);
+
+    __block int run = 0;
+    [self measureBlock:^{
+        const std::string runDir = cacheDir + "-" + std::to_string(run++);
+        const TimeInterval startTime = TimeGetCurrent();
+        size_t totalBytes = 0;
+        {
+            TileCache cache(runDir, 1024*1024*1024);
+            XCTAssertTrue(cache.open());
+            totalBytes = ReplayTiles(cache, sourceDir, replay);
+        }
+        const TimeInterval howLong = TimeGetCurrent() - startTime;
+        NSLog(@"Cold replay: %d tiles, %.1f MB, %.1f us per tile", (int)replay.size(),
+              totalBytes / (1024.0*1024.0), howLong * 1e6 / replay.size());
+        RemoveDir(runDir);
+    }];
+
+    RemoveSourceTiles(sourceDir, replay);
+}
+
+// The same pan and zoom again with everything already in the cache
+- (void)testWarmReplayPerformance {
+    const std::vector<QuadTreeIdentifier> replay = MakeReplay();
+    const std::string sourceDir = cacheDir + "-tiles";
+    WriteSourceTiles(sourceDir, replay);
+
+    TileCache cache(cacheDir, 1024*1024*1024);
+    XCTAssertTrue(cache.open());
+    ReplayTiles(cache, sourceDir, replay);
+
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        const size_t totalBytes = ReplayTiles(cache, sourceDir, replay);
+        const TimeInterval howLong = TimeGetCurrent() - startTime;
+        NSLog(@"Warm replay: %d tiles, %.1f MB, %.1f us per tile", (int)replay.size(),
+              totalBytes / (1024.0*1024.0), howLong * 1e6 / replay.size());
+    }];
+
+    RemoveSourceTiles(sourceDir, replay);
+}
+
+// The same pan and zoom reading a file per tile, which is what the fetchers' cache files do
+- (void)testFileReplayPerformance {
+    const std::vector<QuadTreeIdentifier> replay = MakeReplay();
+    const std::string sourceDir = cacheDir + "-tiles";
+    WriteSourceTiles(sourceDir, replay);
+
+    [self measureBlock:^{
+        const TimeInterval startTime = TimeGetCurrent();
+        size_t totalBytes = 0;
+        for (const auto &ident : replay)
+            if (RawDataRef data = ReadSourceTile(sourceDir, ident))
+                totalBytes += TouchData(*data) ? data->getLen() : 0;
+        const TimeInterval howLong = TimeGetCurrent() - startTime;
+        NSLog(@"File replay: %d tiles, %.1f MB, %.1f us per tile", (int)replay.size(),
+              totalBytes / (1024.0*1024.0), howLong * 1e6 / replay.size());
+    }];
+
+    RemoveSourceTiles(sourceDir, replay);
+}
+
+@end
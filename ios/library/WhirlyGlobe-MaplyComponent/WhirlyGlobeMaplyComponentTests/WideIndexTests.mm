@@ -0,0 +1,188 @@
+//
+//  WideIndexTests.mm
+//  WhirlyGlobeMaplyComponentTests
+//
+//  Copyright 2011-2021 mousebird consulting
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <vector>
+#import "SceneRendererNull.h"
+#import "TextureNull.h"
+#import "VectorManager.h"
+#import "GlobeView.h"
+#import "PolygonFixtures.h"
+
+using namespace WhirlyKit;
+
+// One style's worth of features from the tile
+struct TileLayer
+{
+    std::vector<VectorShapeRef> shapes;
+    bool filled;
+};
+
+// A dense city tile about 5km across: landuse, building fills and outlines, and roads.
+// Each layer is well past what fits in a drawable with 16 bit indices.
+static std::vector<TileLayer> MakeDenseTile()
+{
+    FixtureRandom rand(2468);
+    const float org = 0.5, size = 0.0008;
+    auto randCoord = [&rand,org,size]() { return org + size * rand.next(10000) / 10000.0; };
+
+    std::vector<TileLayer> layers(4);
+    layers[0].filled = true;
+    for (int ii=0;ii<1500;ii++)
+    {
+        VectorArealRef areal = VectorAreal::createAreal();
+        areal->loops.push_back(MakeBlob(rand, randCoord(), randCoord(), size / 40, 48, 0.2));
+        layers[0].shapes.push_back(areal);
+    }
+
+    // The same buildings are filled and outlined
+    layers[1].filled = true;
+    layers[2].filled = false;
+    for (int ii=0;ii<8000;ii++)
+    {
+        const float w = size / 400 * (1 + rand.next(4)), h = size / 400 * (1 + rand.next(4));
+        VectorArealRef areal = VectorAreal::createAreal();
+        areal->loops = MakeBuilding(randCoord(), randCoord(), w, h, w / 4, ii % 4 == 0);
+        layers[1].shapes.push_back(areal);
+        layers[2].shapes.push_back(areal);
+    }
+
+    layers[3].filled = false;
+    for (int ii=0;ii<3000;ii++)
+    {
+        VectorLinearRef linear = VectorLinear::createLinear();
+        Point2f pt(randCoord(), randCoord());
+        for (int pi=0;pi<20;pi++)
+        {
+            linear->pts.push_back(pt);
+            pt += Point2f(size / 200 * ((int)rand.next(21) - 10) / 10.0, size / 200 * ((int)rand.next(21) - 10) / 10.0);
+        }
+        layers[3].shapes.push_back(linear);
+    }
+
+    return layers;
+}
+
+@interface WideIndexTests : XCTestCase
+
+@end
+
+@implementation WideIndexTests
+{
+    WhirlyGlobe::GlobeViewRef view;
+    SceneNull *scene;
+    SceneRendererNullRef renderer;
+    SimpleIdentity progID;
+    std::vector<TileLayer> tile;
+}
+
+- (void)setUp {
+    tile = MakeDenseTile();
+}
+
+- (void)tearDown {
+    [self teardownRenderer];
+    tile.clear();
+}
+
+// Same order the render controllers use: renderer, view, scene, then the shaders
+- (void)setupRenderer:(bool)wideIndices {
+    renderer = std::make_shared<SceneRendererNull>();
+    renderer->setup(2048, 1536, 2.0, wideIndices);
+
+    view = std::make_shared<WhirlyGlobe::GlobeView>(nullptr);
+    scene = new SceneNull(view->coordAdapter);
+    renderer->setScene(scene);
+    renderer->setView(view.get());
+
+    ProgramNullRef prog = std::make_shared<ProgramNull>("Default Triangle;lighting=no");
+    progID = prog->getId();
+    scene->addProgram(prog);
+}
+
+- (void)teardownRenderer {
+    if (!scene)
+        return;
+    scene->teardown(nullptr);
+    renderer->setScene(nullptr);
+    delete scene;
+    scene = nullptr;
+    renderer = nullptr;
+    view = nullptr;
+}
+
+// Build the tile through the vector manager, one style per layer, and render once to take it in
+- (void)addTile {
+    VectorManagerRef vecManager = scene->getManager<VectorManager>(kWKVectorManager);
+    ChangeSet changes;
+    for (const auto &layer : tile)
+    {
+        VectorInfo vecInfo;
+        vecInfo.programID = progID;
+        vecInfo.filled = layer.filled;
+        XCTAssertNotEqual(vecManager->addVectors(&layer.shapes, vecInfo, changes), EmptyIdentity);
+    }
+    scene->addChangeRequests(changes);
+    renderer->render(1.0/60.0);
+}
+
+// Render the tile with or without wide indices, returning the drawable count
+- (int)renderTile:(bool)wideIndices frames:(int)numFrames {
+    [self setupRenderer:wideIndices];
+    XCTAssertEqual(renderer->hasWideIndices(), wideIndices);
+
+    TimeInterval startTime = TimeGetCurrent();
+    [self addTile];
+    const TimeInterval buildTime = TimeGetCurrent() - startTime;
+
+    startTime = TimeGetCurrent();
+    for (int frame=0;frame<numFrames;frame++)
+        renderer->render(1.0/60.0);
+    const TimeInterval renderTime = (TimeGetCurrent() - startTime) / numFrames;
+
+    const FrameStatsNull stats = renderer->getFrameStats();
+    NSLog(@"%s indices: %d drawables, %lld points, %lld triangles, built in %.1f ms, render() %.3f ms",
+          wideIndices ? "Wide" : "16 bit", stats.drawablesDrawn, (long long)stats.points, (long long)stats.triangles,
+          buildTime * 1000.0, renderTime * 1000.0);
+    XCTAssertEqual(stats.drawablesSkipped, 0);
+
+    [self teardownRenderer];
+    return stats.drawablesDrawn;
+}
+
+// With wide indices each style is one drawable.  Without, the same tile has to be split.
+- (void)testDrawableCount {
+    const int wideDrawables = [self renderTile:true frames:10];
+    const int narrowDrawables = [self renderTile:false frames:10];
+    XCTAssertEqual(wideDrawables, (int)tile.size());
+    XCTAssertGreaterThan(narrowDrawables, 2 * wideDrawables);
+}
+
+- (void)testRenderWidePerformance {
+    [self measureBlock:^{
+        [self renderTile:true frames:100];
+    }];
+}
+
+- (void)testRenderNarrowPerformance {
+    [self measureBlock:^{
+        [self renderTile:false frames:100];
+    }];
+}
+
+@end
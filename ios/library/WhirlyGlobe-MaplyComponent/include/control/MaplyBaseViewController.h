@@ -1092,6 +1092,16 @@
   */
 - (void)setMaxLayoutObjects:(int)maxLayoutObjects;
 
+/**
+    Reuse the last layout for screen objects that haven't moved much.
+
+    When this is on, the layout engine keeps what it placed last time and only retests objects that have moved by more than the threshold (in pixels) relative to the rest of the screen, along with anything near them.  This makes layout much cheaper when panning over lots of labels and markers.  Clustered objects still get a full layout.
+
+    @param incrementalLayout Turn incremental layout on or off.  Off by default.
+    @param moveThreshold How far an object can move, in pixels, before it's tested again.
+  */
+- (void)setIncrementalLayout:(bool)incrementalLayout moveThreshold:(float)moveThreshold;
+
 /**
  Screen markers and labels can have uniqueIDs.  We use these to ensure we're only displaying one version of an object with, say, vector tiles
  that load multiple levels.
@@ -117,6 +117,10 @@
 /// If you're using local storage (separate from the cache) this will be passed on to the MaplyTileLocalStorage manager
 @property (nonatomic,nullable,retain) id localStorageKey;
 
+/// Name of the source in the fetcher's tile cache, if it has one.  Tile infos sharing a fetcher need different names.
+/// Nothing goes in the tile cache if this isn't set.
+@property (nonatomic,nullable,retain) NSString *cacheSource;
+
 @end
 
 /**
@@ -179,6 +183,15 @@
 /// Useful if you've got an old version of the tile lying around you might use in a pinch
 - (void)setSecondChance:(NSObject<MaplyTileSecondChance> * __nonnull)secondChance;
 
+/**
+ Keep fetched tiles in a persistent cache in the given directory, staying under maxBytes.
+ 
+ Tiles are kept in a few large pack files with a memory mapped index, rather than a file per tile.
+ This is consulted after local storage and used instead of the cacheFile for fetches with a cacheSource.
+ Returns false if the cache couldn't be opened.
+ */
+- (bool)setTileCacheDir:(NSString * __nonnull)dir maxSize:(size_t)maxBytes;
+
 /// Return the fetching stats since the beginning or since the last reset
 - (MaplyRemoteTileFetcherStats * __nullable)getStats:(bool)allTime;
 
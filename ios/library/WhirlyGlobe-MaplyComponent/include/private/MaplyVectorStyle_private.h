@@ -19,6 +19,7 @@
 #import "MaplyVectorStyle.h"
 #import "WhirlyGlobe.h"
 #import "Dictionary_NSDictionary.h"
+#import <mutex>
 
 @interface MaplyVectorStyleSettings()
 {
@@ -119,7 +120,12 @@ public:
     /// Add a sprite sheet
     void addSprites(MapboxVectorStyleSpritesRef newSprites,MaplyTexture *_Nonnull tex);
     
+    /// Hold on to a texture so it doesn't get released
+    void keepTexture(MaplyTexture *_Nonnull tex);
+
     // Textures we're holding on to (so they don't get released)
+    // Layers can make textures while tiles are building, so this is locked
+    std::mutex texturesLock;
     std::vector<MaplyTexture *> textures;
 };
 typedef std::shared_ptr<MapboxVectorStyleSetImpl_iOS> MapboxVectorStyleSetImpl_iOSRef;
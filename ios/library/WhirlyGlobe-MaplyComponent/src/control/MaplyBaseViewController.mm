@@ -1008,6 +1008,14 @@ static const float PerfOutputDelay = 15.0;
     }
 }
 
+- (void)setIncrementalLayout:(bool)incrementalLayout moveThreshold:(float)moveThreshold
+{
+    if (const auto layoutManager = renderControl->scene->getManager<LayoutManager>(kWKLayoutManager))
+    {
+        layoutManager->setIncrementalLayout(incrementalLayout, moveThreshold);
+    }
+}
+
 - (void)setLayoutOverrideIDs:(NSArray *)uuids
 {
     std::set<std::string> uuidSet;
@@ -215,6 +215,8 @@ using namespace WhirlyKit;
 - (void)dataForTile:(MaplyImageLoaderReturn *)loadReturn loader:(MaplyQuadLoaderBase *)loader
 {
     const auto __strong vc = loader.viewC;
+    // Decode color images straight to 16 bit if that's what the textures will be
+    const RawPNGFormat format = loader->loader ? RawPNGFormatForTexType(loader->loader->getTexType()) : RawPNGRGBA;
     NSArray<id> *tileData = [loadReturn getTileData];
     for (unsigned int ii=0;ii<[tileData count];ii++) {
         if (loadReturn.isCancelled) {
@@ -228,19 +230,25 @@ using namespace WhirlyKit;
         
         unsigned int err = 0;
         int byteWidth = -1;
-        unsigned char *outData = RawPNGImageLoaderInterpreter(width,height,
-                                                              (const unsigned char *)[inData bytes],[inData length],
-                                                              valueMap,
-                                                              byteWidth, err);
+        RawDataRef outData = RawPNGImageLoaderInterpreter(width,height,
+                                                          (const unsigned char *)[inData bytes],[inData length],
+                                                          valueMap,
+                                                          format,
+                                                          byteWidth, err);
 
-        if (err != 0) {
+        if (err != 0 || !outData) {
             wkLogLevel(Warn, "Failed to read PNG in MaplyRawPNGImageLoaderInterpreter for tile %d: (%d,%d) frame = %d",loadReturn.tileID.level,loadReturn.tileID.x,loadReturn.tileID.y,loadReturn.frame);
         } else {
-            NSData *retData = [[NSData alloc] initWithBytesNoCopy:outData length:width*height*byteWidth freeWhenDone:YES];
+            // The decoded buffer goes back to the decoder's pool when this is released
+            __block RawDataRef holdData = outData;
+            NSData *retData = [[NSData alloc] initWithBytesNoCopy:(void *)outData->getRawData() length:outData->getLen()
+                                                      deallocator:^(void *bytes, NSUInteger length) { holdData.reset(); }];
 
             // Build a wrapper around the data and pass it on
             MaplyImageTile *tileData = [[MaplyImageTile alloc] initWithRawImage:retData width:width height:height components:byteWidth viewC:vc];
             if (tileData) {
+                // Greyscale comes out one byte per pixel whatever we asked for
+                tileData->imageTile->dataInFormat = format != RawPNGRGBA && byteWidth == 2;
                 loadReturn->loadReturn->images.push_back(tileData->imageTile);
             }
         }
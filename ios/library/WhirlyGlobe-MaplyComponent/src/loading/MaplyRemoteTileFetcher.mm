@@ -20,6 +20,7 @@
 
 #import "loading/MaplyRemoteTileFetcher.h"
 #import "MaplyRenderController_private.h"
+#import "TileCache.h"
 
 namespace WhirlyKit
 {
@@ -210,6 +211,7 @@ using namespace WhirlyKit;
     MaplyRemoteTileFetchInfo *fetchInfo = [[MaplyRemoteTileFetchInfo alloc] init];
     fetchInfo.urlReq = [self urlRequestForTile:tileID flipY:flipY];
     fetchInfo.cacheFile = [self fileNameForTile:tileID flipY:flipY];
+    fetchInfo.cacheSource = _baseURL;
     
     if (!fetchInfo.urlReq)
         return nil;
@@ -397,6 +399,9 @@ using namespace WhirlyKit;
     NSObject<MaplyTileLocalStorage> __weak *localStorage;
     NSObject<MaplyTileSecondChance> __weak *secondChance;
 
+    // Persistent tile cache, if there is one
+    TileCacheRef tileCache;
+
     NSURLSession *session;
     dispatch_queue_t queue;
     
@@ -436,6 +441,28 @@ using namespace WhirlyKit;
     secondChance = inSecondChance;
 }
 
+- (bool)setTileCacheDir:(NSString * __nonnull)dir maxSize:(size_t)maxBytes
+{
+    auto newCache = std::make_shared<TileCache>([dir UTF8String],maxBytes);
+    if (!newCache->open())
+        return false;
+
+    // The cache is only read and swapped on our queue
+    MaplyRemoteTileFetcher * __weak weakSelf = self;
+    dispatch_async(queue, ^{
+        if (const auto __strong s = weakSelf)
+            s->tileCache = newCache;
+    });
+
+    return true;
+}
+
+// The tile goes through the tile cache rather than the cache file
+- (bool)usesTileCache:(TileInfoRef)tile
+{
+    return tileCache && tile->fetchInfo.cacheSource;
+}
+
 /// Return the fetching stats since the beginning or since the last reset
 - (MaplyRemoteTileFetcherStats * __nullable)getStats:(bool)allTime
 {
@@ -656,7 +683,16 @@ using namespace WhirlyKit;
 
 - (void)writeToCache:(TileInfoRef)tileInfo tileData:(NSData *)tileData
 {
-    if (tileInfo->fetchInfo.cacheFile) {
+    if ([self usesTileCache:tileInfo]) {
+        const TileCacheRef theCache = tileCache;
+        const QuadTreeIdentifier ident(tileInfo->tileID.x,tileInfo->tileID.y,tileInfo->tileID.level);
+        const std::string source = [tileInfo->fetchInfo.cacheSource UTF8String];
+
+        // Appending to the pack is quick, but it's still disk
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            theCache->putTile(ident, source, RawDataWrapper([tileData bytes], [tileData length], false));
+        });
+    } else if (tileInfo->fetchInfo.cacheFile) {
         NSString *dir = [tileInfo->fetchInfo.cacheFile stringByDeletingLastPathComponent];
         NSString *cacheFile = tileInfo->fetchInfo.cacheFile;
         
@@ -676,6 +712,25 @@ using namespace WhirlyKit;
     return [NSData dataWithContentsOfFile:tileInfo->fetchInfo.cacheFile];
 }
 
+// Look in the tile cache.  The data is a view on the mapped pack file, not a copy.
+- (NSData *)readFromTileCache:(TileInfoRef)tileInfo
+{
+    if (![self usesTileCache:tileInfo])
+        return nil;
+
+    const QuadTreeIdentifier ident(tileInfo->tileID.x,tileInfo->tileID.y,tileInfo->tileID.level);
+    RawDataRef rawData = tileCache->getTile(ident, [tileInfo->fetchInfo.cacheSource UTF8String]);
+    if (!rawData)
+        return nil;
+
+    return [[NSData alloc] initWithBytesNoCopy:(void *)rawData->getRawData()
+                                        length:rawData->getLen()
+                                   deallocator:^(void *bytes, NSUInteger length) {
+        // Hang on to the pack mapping until the data goes away
+        (void)rawData;
+    }];
+}
+
 // Run on the dispatch queue
 - (void)updateLoading
 {
@@ -724,6 +779,20 @@ using namespace WhirlyKit;
             }
         }
         
+        // Then the tile cache, which is quick enough to check here
+        if (!inLocalStorage) {
+            if (NSData *data = [self readFromTileCache:tile]) {
+                inLocalStorage = true;
+                tile->task = nil;
+
+                if (_debugMode)
+                    NSLog(@"Tile cache for: %@, %dk",urlReq.URL.absoluteString,(int)[data length] / 1024);
+                if (log)
+                    [log addCache:tile length:[data length]];
+                [self handleFinishLoading:data tile:tile];
+            }
+        }
+
         // Next up, deal with local tile or remote tile fetching
         if (!inLocalStorage) {
             // Look for it cached
@@ -120,7 +120,14 @@ using namespace WhirlyKit;
 
         for (ShapeSet::iterator it = shapes.begin(); it != shapes.end(); ++it) {
             
-            NSMutableDictionary *attributes = ((iosMutableDictionary *)(*it)->getAttrDict().get())->dict;
+            // The reader builds these with MutableDictionaryMake, but don't count on it
+            iosMutableDictionaryRef attrDict = std::dynamic_pointer_cast<iosMutableDictionary>((*it)->getAttrDict());
+            if (!attrDict) {
+                attrDict = (*it)->getAttrDict() ? std::make_shared<iosMutableDictionary>((*it)->getAttrDict()) :
+                                                  std::make_shared<iosMutableDictionary>();
+                (*it)->setAttrDict(attrDict);
+            }
+            NSMutableDictionary *attributes = attrDict->dict;
 
             NSMutableArray *vectorObjs = [NSMutableArray array];
             
@@ -256,10 +256,11 @@ using namespace WhirlyKit;
 
 - (UIImage *)imageForSymbol:(const std::string &)symbolName size:(CGSize)size
 {
-    if (!style->sprites)
+    const auto sprites = style->getSprites();
+    if (!sprites)
         return nil;
     
-    auto sprite = style->sprites->getSprite(symbolName);
+    auto sprite = sprites->getSprite(symbolName);
     if (sprite.name.empty())
         return nil;
 
@@ -441,7 +441,10 @@ MapboxVectorStyleSetImpl_iOS::~MapboxVectorStyleSetImpl_iOS()
 bool MapboxVectorStyleSetImpl_iOS::parse(PlatformThreadInfo *inst,const DictionaryRef &dict)
 {
     // Release the textures we're standing on
-    textures.clear();
+    {
+        std::lock_guard<std::mutex> guardLock(texturesLock);
+        textures.clear();
+    }
     
     return MapboxVectorStyleSetImpl::parse(inst,dict);
 }
@@ -491,7 +494,7 @@ SimpleIdentity MapboxVectorStyleSetImpl_iOS::makeCircleTexture(PlatformThreadInf
     UIGraphicsEndImageContext();
     
     MaplyTexture *tex = [viewC addTexture:image desc:nil mode:MaplyThreadCurrent];
-    textures.push_back(tex);
+    keepTexture(tex);
     
     return tex.texID;
 }
@@ -510,7 +513,7 @@ SimpleIdentity MapboxVectorStyleSetImpl_iOS::makeLineTexture(PlatformThreadInfo
                                                       kMaplyTexWrapY: @(MaplyImageWrapY)
                                                       }
                                                mode:MaplyThreadCurrent];
-    textures.push_back(tex);
+    keepTexture(tex);
     
     return tex.texID;
 }
@@ -632,10 +635,18 @@ double MapboxVectorStyleSetImpl_iOS::calculateTextWidth(PlatformThreadInfo *inst
 
 void MapboxVectorStyleSetImpl_iOS::addSprites(MapboxVectorStyleSpritesRef newSprites,MaplyTexture *tex)
 {
-    textures.push_back(tex);
+    keepTexture(tex);
     MapboxVectorStyleSetImpl::addSprites(std::move(newSprites));
 }
 
+void MapboxVectorStyleSetImpl_iOS::keepTexture(MaplyTexture *tex)
+{
+    if (!tex)
+        return;
+    std::lock_guard<std::mutex> guardLock(texturesLock);
+    textures.push_back(tex);
+}
+
 VectorStyleDelegateWrapper::VectorStyleDelegateWrapper(NSObject<MaplyRenderControllerProtocol> *viewC,NSObject<MaplyVectorStyleDelegate> *delegate)
 : viewC(viewC), delegate(delegate)
 {
@@ -652,11 +663,9 @@ VectorStyleDelegateWrapper::stylesForFeature(PlatformThreadInfo *inst,
         dict = dictRef->dict;
     } else if (const auto dictRef = dynamic_cast<const iosMutableDictionary*>(&attrs)) {
         dict = dictRef->dict;
-    } else if (const auto dictRef = dynamic_cast<const MutableDictionaryC*>(&attrs)) {
-        dict = [NSMutableDictionary fromDictionaryCPointer:dictRef];
-    } else if (dict) {
-        wkLogLevel(Warn, "unsupported dictionary implementation");
-        return std::vector<VectorStyleImplRef>();
+    } else {
+        // MutableDictionaryC, the flat records from vector tiles, or anything else
+        dict = [NSMutableDictionary fromDictionaryCPointer:&attrs];
     }
     
     const MaplyTileID theTileID = { tileID.x, tileID.y, tileID.level };
@@ -104,6 +104,9 @@ public:
     // Set up the memory and defaults for the argument buffers (vertex, fragment, calculate)
     void setupArgBuffers(id<MTLDevice> mtlDevice,RenderSetupInfoMTL *setupInfo,SceneMTL *scene,BufferBuilderMTL *buffBuild);
         
+    // 16 or 32 bit, depending on how many vertices we've got
+    MTLIndexType getIndexTypeMTL() const { return wideIndices ? MTLIndexTypeUInt32 : MTLIndexTypeUInt16; }
+
     bool setupForMTL;
     std::vector<Triangle> tris;
     int numPts,numTris;
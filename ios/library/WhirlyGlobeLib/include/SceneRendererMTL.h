@@ -119,6 +119,9 @@ public:
     
     // Various information about the renderer passed around to call
     virtual const RenderSetupInfo *getRenderSetupInfo() const;
+
+    /// Metal always has 32 bit indices
+    virtual bool hasWideIndices() const override { return true; }
     
     virtual void setView(View *newView);
     virtual void setScene(Scene *newScene);
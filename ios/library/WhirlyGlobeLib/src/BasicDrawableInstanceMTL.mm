@@ -601,7 +601,7 @@ void BasicDrawableInstanceMTL::encodeDirect(RendererFrameInfoMTL *frameInfo,id<M
                     // This actually draws the triangles (well, in a bit)
                     [cmdEncode drawIndexedPrimitives:MTLPrimitiveTypeTriangle
                                           indexCount:basicDrawMTL->numTris*3
-                                           indexType:MTLIndexTypeUInt16
+                                           indexType:basicDrawMTL->getIndexTypeMTL()
                                          indexBuffer:basicDrawMTL->triBuffer.buffer
                                    indexBufferOffset:basicDrawMTL->triBuffer.offset];
                     break;
@@ -621,7 +621,7 @@ void BasicDrawableInstanceMTL::encodeDirect(RendererFrameInfoMTL *frameInfo,id<M
                 case Triangles:
                     [cmdEncode drawIndexedPrimitives:MTLPrimitiveTypeTriangle
                                           indexCount:basicDrawMTL->numTris*3
-                                           indexType:MTLIndexTypeUInt16
+                                           indexType:basicDrawMTL->getIndexTypeMTL()
                                          indexBuffer:basicDrawMTL->triBuffer.buffer
                                    indexBufferOffset:basicDrawMTL->triBuffer.offset
                                        instanceCount:numInst];
@@ -640,7 +640,7 @@ void BasicDrawableInstanceMTL::encodeDirect(RendererFrameInfoMTL *frameInfo,id<M
                     break;
                 case Triangles:
                     [cmdEncode drawIndexedPrimitives:MTLPrimitiveTypeTriangle
-                                           indexType:MTLIndexTypeUInt16
+                                           indexType:basicDrawMTL->getIndexTypeMTL()
                                          indexBuffer:basicDrawMTL->triBuffer.buffer
                                    indexBufferOffset:basicDrawMTL->triBuffer.offset
                                       indirectBuffer:indirectBuffer.buffer
@@ -664,7 +664,7 @@ void BasicDrawableInstanceMTL::encodeDirect(RendererFrameInfoMTL *frameInfo,id<M
                 case Triangles:
                     [cmdEncode drawIndexedPrimitives:MTLPrimitiveTypeTriangle
                                           indexCount:basicDrawMTL->numTris*3
-                                           indexType:MTLIndexTypeUInt16
+                                           indexType:basicDrawMTL->getIndexTypeMTL()
                                          indexBuffer:basicDrawMTL->triBuffer.buffer
                                    indexBufferOffset:basicDrawMTL->triBuffer.offset
                                        instanceCount:instDrawMTL->calcDataEntries];
@@ -814,7 +814,7 @@ void BasicDrawableInstanceMTL::encodeIndirect(id<MTLIndirectRenderCommand> cmdEn
                     // This actually draws the triangles (well, in a bit)
                     [cmdEncode drawIndexedPrimitives:MTLPrimitiveTypeTriangle
                                           indexCount:basicDrawMTL->numTris*3
-                                           indexType:MTLIndexTypeUInt16
+                                           indexType:basicDrawMTL->getIndexTypeMTL()
                                          indexBuffer:basicDrawMTL->triBuffer.buffer
                                    indexBufferOffset:basicDrawMTL->triBuffer.offset
                                        instanceCount:1
@@ -838,7 +838,7 @@ void BasicDrawableInstanceMTL::encodeIndirect(id<MTLIndirectRenderCommand> cmdEn
                 case Triangles:
                     [cmdEncode drawIndexedPrimitives:MTLPrimitiveTypeTriangle
                                           indexCount:basicDrawMTL->numTris*3
-                                           indexType:MTLIndexTypeUInt16
+                                           indexType:basicDrawMTL->getIndexTypeMTL()
                                          indexBuffer:basicDrawMTL->triBuffer.buffer
                                    indexBufferOffset:basicDrawMTL->triBuffer.offset
                                        instanceCount:numInst
@@ -864,7 +864,7 @@ void BasicDrawableInstanceMTL::encodeIndirect(id<MTLIndirectRenderCommand> cmdEn
                 case Triangles:
                     [cmdEncode drawIndexedPrimitives:MTLPrimitiveTypeTriangle
                                           indexCount:basicDrawMTL->numTris*3
-                                           indexType:MTLIndexTypeUInt16
+                                           indexType:basicDrawMTL->getIndexTypeMTL()
                                          indexBuffer:basicDrawMTL->triBuffer.buffer
                                    indexBufferOffset:basicDrawMTL->triBuffer.offset
                                        instanceCount:instDrawMTL->calcDataEntries
@@ -78,11 +78,14 @@ void BasicDrawableMTL::setupForRenderer(const RenderSetupInfo *inSetupInfo,Scene
     }
     
     // And put the triangles in their own
-    // Note: Could use 1 byte some of the time
-    int bufferSize = 3*2*tris.size();
+    // 16 bit indices unless there are too many vertices for that
+    wideIndices = numPts > (1<<16);
+    size_t bufferSize = indexBufferSize(tris.size(),wideIndices);
     numTris = tris.size();
     if (bufferSize > 0) {
-        buffBuild.addData(&tris[0], bufferSize, &triBuffer);
+        std::vector<uint8_t> indices(bufferSize);
+        copyIndices(tris,wideIndices,indices.data());
+        buffBuild.addData(indices.data(), bufferSize, &triBuffer);
         tris.clear();
     }
     
@@ -692,7 +695,7 @@ void BasicDrawableMTL::encodeDirect(RendererFrameInfoMTL *frameInfo,id<MTLRender
                 return;
             }
             // This actually draws the triangles (well, in a bit)
-            [cmdEncode drawIndexedPrimitives:MTLPrimitiveTypeTriangle indexCount:numTris*3 indexType:MTLIndexTypeUInt16 indexBuffer:triBuffer.buffer indexBufferOffset:triBuffer.offset];
+            [cmdEncode drawIndexedPrimitives:MTLPrimitiveTypeTriangle indexCount:numTris*3 indexType:getIndexTypeMTL() indexBuffer:triBuffer.buffer indexBufferOffset:triBuffer.offset];
             break;
         default:
             break;
@@ -807,7 +810,7 @@ void BasicDrawableMTL::encodeIndirect(id<MTLIndirectRenderCommand> cmdEncode,Sce
                 return;
             }
             // This actually draws the triangles (well, in a bit)
-            [cmdEncode drawIndexedPrimitives:MTLPrimitiveTypeTriangle indexCount:numTris*3 indexType:MTLIndexTypeUInt16 indexBuffer:triBuffer.buffer indexBufferOffset:triBuffer.offset instanceCount:1 baseVertex:0 baseInstance:0];
+            [cmdEncode drawIndexedPrimitives:MTLPrimitiveTypeTriangle indexCount:numTris*3 indexType:getIndexTypeMTL() indexBuffer:triBuffer.buffer indexBufferOffset:triBuffer.offset instanceCount:1 baseVertex:0 baseInstance:0];
             break;
         default:
             break;
@@ -129,6 +129,7 @@ Texture *ImageTile_iOS::buildTexture()
             tex = new TextureMTL("ImageTile_iOS",RawDataRef(new RawNSDataReader((NSData *)imageStuff)),false);
             tex->setWidth(destWidth);
             tex->setHeight(destHeight);
+            tex->setDataInFormat(dataInFormat);
             break;
     }
 
@@ -55,6 +55,7 @@ void SceneMTL::teardown(PlatformThreadInfo *inst)
         }
     }
     drawables.clear();
+    clearDrawOrder();
     for (auto it : textures) {
         it.second->destroyInRenderer(setupInfo,this);
     }
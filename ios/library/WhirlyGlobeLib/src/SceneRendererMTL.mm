@@ -467,6 +467,9 @@ void SceneRendererMTL::render(TimeInterval duration,
 {
     if (!scene)
         return;
+    // CPU side only, the GPU work finishes later
+    WK_TRACE_SCOPE("SceneRenderer::render");
+
     SceneMTL *sceneMTL = (SceneMTL *)scene;
     
     frameCount++;